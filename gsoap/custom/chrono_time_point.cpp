@@ -79,8 +79,23 @@ SOAP_FMAC3 void soap_serialize_xsd__dateTime(struct soap *soap, std::chrono::sys
 
 SOAP_FMAC3 const char * SOAP_FMAC4 soap_xsd__dateTime2s(struct soap *soap, const std::chrono::system_clock::time_point a)
 {
-  time_t t = std::chrono::system_clock::to_time_t(a);
-  return soap_dateTime2s(soap, t);
+  long long n = std::chrono::duration_cast<std::chrono::nanoseconds>(a.time_since_epoch()).count();
+  long long t = n / 1000000000;
+  long long f = n % 1000000000;
+  int digits = 9;
+  if (f < 0)
+  {
+    f += 1000000000;
+    t--;
+  }
+  if (f == 0)
+    return soap_dateTime2s(soap, (time_t)t);
+  while (f % 10 == 0)
+  {
+    f /= 10;
+    digits--;
+  }
+  return soap_dateTime2s_frac(soap, (time_t)t, (unsigned long)f, digits);
 }
 
 SOAP_FMAC3 int SOAP_FMAC4 soap_out_xsd__dateTime(struct soap *soap, const char *tag, int id, const std::chrono::system_clock::time_point *a, const char *type)
@@ -94,8 +109,9 @@ SOAP_FMAC3 int SOAP_FMAC4 soap_out_xsd__dateTime(struct soap *soap, const char *
 SOAP_FMAC3 int SOAP_FMAC4 soap_s2xsd__dateTime(struct soap *soap, const char *s, std::chrono::system_clock::time_point *a)
 {
   time_t t;
-  if (!soap_s2dateTime(soap, s, &t))
-    *a = std::chrono::system_clock::from_time_t(t);
+  unsigned long f;
+  if (!soap_s2dateTime_frac(soap, s, &t, &f, 9))
+    *a = std::chrono::system_clock::from_time_t(t) + std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(f));
   return soap->error;
 }
 
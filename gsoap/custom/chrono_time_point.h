@@ -6,6 +6,9 @@
 
 	Requires C++11 or higher (compile with -std=c++11).
 
+	Fractional seconds are serialized and deserialized with up to nanosecond
+	precision, as permitted by the system clock's duration.
+
 	#import this file into your gSOAP .h file
 
 	To automate the wsdl2h-mapping of xsd:dateTime to
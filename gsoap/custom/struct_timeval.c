@@ -73,17 +73,7 @@ SOAP_FMAC3 void SOAP_FMAC4 soap_serialize_xsd__dateTime(struct soap *soap, struc
 
 SOAP_FMAC3 const char * SOAP_FMAC4 soap_xsd__dateTime2s(struct soap *soap, const struct timeval a)
 {
-  size_t n;
-  soap_dateTime2s(soap, a.tv_sec); /* assuming result is in tmpbuf! */
-  n = strlen(soap->tmpbuf);
-  if (soap->tmpbuf[n-1] == 'Z')
-    n--;
-#ifndef WITH_NOZONE
-  (SOAP_SNPRINTF(soap->tmpbuf + n, sizeof(soap->tmpbuf) - n, 10), ".%.6ldZ", (long)a.tv_usec); /* tv_usec might be int or long int */
-#else
-  (SOAP_SNPRINTF(soap->tmpbuf + n, sizeof(soap->tmpbuf) - n, 9), ".%.6ld", (long)a.tv_usec); /* tv_usec might be int or long int */
-#endif
-  return soap->tmpbuf;
+  return soap_dateTime2s_frac(soap, a.tv_sec, (unsigned long)a.tv_usec, 6); /* tv_usec might be int or long int */
 }
 
 SOAP_FMAC3 int SOAP_FMAC4 soap_out_xsd__dateTime(struct soap *soap, const char *tag, int id, const struct timeval *a, const char *type)
@@ -96,137 +86,13 @@ SOAP_FMAC3 int SOAP_FMAC4 soap_out_xsd__dateTime(struct soap *soap, const char *
 
 SOAP_FMAC3 int SOAP_FMAC4 soap_s2xsd__dateTime(struct soap *soap, const char *s, struct timeval *a)
 {
+  time_t t;
+  unsigned long f;
   memset((void*)a, 0, sizeof(struct timeval));
-  if (s)
+  if (!soap_s2dateTime_frac(soap, s, &t, &f, 6))
   {
-    char *t;
-    unsigned long d;
-    struct tm T;
-    memset((void*)&T, 0, sizeof(T));
-    d = soap_strtoul(s, &t, 10);
-    if (*t == '-')
-    {
-      /* YYYY-MM-DD */
-      T.tm_year = (int)d;
-      T.tm_mon = (int)soap_strtoul(t + 1, &t, 10);
-      T.tm_mday = (int)soap_strtoul(t + 1, &t, 10);
-    }
-    else if (!(soap->mode & SOAP_XML_STRICT))
-    {
-      /* YYYYMMDD */
-      T.tm_year = (int)(d / 10000);
-      T.tm_mon = (int)(d / 100 % 100);
-      T.tm_mday = (int)(d % 100);
-    }
-    else
-    {
-      return soap->error = SOAP_TYPE;
-    }
-    if (*t == 'T' || ((*t == 't' || *t == ' ') && !(soap->mode & SOAP_XML_STRICT)))
-    {
-      d = soap_strtoul(t + 1, &t, 10);
-      if (*t == ':')
-      {
-	/* Thh:mm:ss */
-	T.tm_hour = (int)d;
-	T.tm_min = (int)soap_strtoul(t + 1, &t, 10);
-	T.tm_sec = (int)soap_strtoul(t + 1, &t, 10);
-      }
-      else if (!(soap->mode & SOAP_XML_STRICT))
-      {
-	/* Thhmmss */
-        T.tm_hour = (int)(d / 10000);
-	T.tm_min = (int)(d / 100 % 100);
-	T.tm_sec = (int)(d % 100);
-      }
-      else
-      {
-	return soap->error = SOAP_TYPE;
-      }
-    }
-    if (T.tm_year == 1)
-      T.tm_year = 70;
-    else
-      T.tm_year -= 1900;
-    T.tm_mon--;
-    a->tv_usec = 0;
-    if (*t == '.')
-    {
-      char tmp[32];
-      int i;
-      float f = 0.0;
-      for (i = 0; i < 31; i++)
-      {
-        tmp[i] = *t++;
-        if (*t < '0' || *t > '9')
-          break;
-      }
-      tmp[i + 1] = '\0';
-      if (soap_s2float(soap, tmp, &f))
-        return soap->error;
-      a->tv_usec = (long)(1e6 * f + 0.5);
-    }
-    if (*t == ' ' && !(soap->mode & SOAP_XML_STRICT))
-      t++;
-    if (*t)
-    {
-#ifndef WITH_NOZONE
-      if (*t == '+' || *t == '-')
-      {
-	int h, m;
-	m = (int)soap_strtol(t, &t, 10);
-        if (*t == ':')
-        {
-	  /* +hh:mm */
-	  h = m;
-	  m = (int)soap_strtol(t + 1, &t, 10);
-          if (h < 0)
-            m = -m;
-        }
-        else if (!(soap->mode & SOAP_XML_STRICT))
-	{
-	  /* +hhmm */
-          h = m / 100;
-          m = m % 100;
-        }
-        else
-	{
-	  /* +hh */
-          h = m;
-	  m = 0;
-        }
-	if (*t)
-	  return soap->error = SOAP_TYPE;
-        T.tm_min -= m;
-        T.tm_hour -= h;
-        /* put hour and min in range */
-        T.tm_hour += T.tm_min / 60;
-        T.tm_min %= 60;
-        if (T.tm_min < 0)
-        {
-	  T.tm_min += 60;
-          T.tm_hour--;
-        }
-        T.tm_mday += T.tm_hour / 24;
-        T.tm_hour %= 24;
-        if (T.tm_hour < 0)
-        {
-	  T.tm_hour += 24;
-          T.tm_mday--;
-        }
-        /* note: day of the month may be out of range, timegm() handles it */
-      }
-      else if (*t != 'Z')
-      {
-	return soap->error = SOAP_TYPE;
-      }
-#endif
-      a->tv_sec = soap_timegm(&T);
-    }
-    else
-    {
-      a->tv_sec = mktime(&T);
-    }
+    a->tv_sec = t;
+    a->tv_usec = f;
   }
   return soap->error;
 }
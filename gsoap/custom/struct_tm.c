@@ -73,6 +73,13 @@ SOAP_FMAC3 void SOAP_FMAC4 soap_serialize_xsd__dateTime(struct soap *soap, struc
 
 SOAP_FMAC3 const char * SOAP_FMAC4 soap_xsd__dateTime2s(struct soap *soap, const struct tm a)
 {
+#ifndef WITH_NOZONE
+  struct tm b = a;
+  time_t t = soap_timegm(&b);
+  if (a.tm_isdst > 0)
+    t -= 3600;
+  return soap_dateTime2s(soap, t);
+#else
   if (a.tm_isdst > 0)
   {
     struct tm b = a;
@@ -84,19 +91,12 @@ SOAP_FMAC3 const char * SOAP_FMAC4 soap_xsd__dateTime2s(struct soap *soap, const
 #else
     b = *gmtime(&t);
 #endif
-#ifndef WITH_NOZONE
-    strftime(soap->tmpbuf, sizeof(soap->tmpbuf), "%Y-%m-%dT%H:%M:%SZ", &b);
-#else
     strftime(soap->tmpbuf, sizeof(soap->tmpbuf), "%Y-%m-%dT%H:%M:%S", &b);
-#endif
     return soap->tmpbuf;
   }
-#ifndef WITH_NOZONE
-  strftime(soap->tmpbuf, sizeof(soap->tmpbuf), "%Y-%m-%dT%H:%M:%SZ", &a);
-#else
   strftime(soap->tmpbuf, sizeof(soap->tmpbuf), "%Y-%m-%dT%H:%M:%S", &a);
-#endif
   return soap->tmpbuf;
+#endif
 }
 
 SOAP_FMAC3 int SOAP_FMAC4 soap_out_xsd__dateTime(struct soap *soap, const char *tag, int id, const struct tm *a, const char *type)
@@ -109,117 +109,8 @@ SOAP_FMAC3 int SOAP_FMAC4 soap_out_xsd__dateTime(struct soap *soap, const char *
 
 SOAP_FMAC3 int SOAP_FMAC4 soap_s2xsd__dateTime(struct soap *soap, const char *s, struct tm *a)
 {
-  memset((void*)a, 0, sizeof(struct tm));
-  if (s)
-  {
-    char *t;
-    unsigned long d;
-    d = soap_strtoul(s, &t, 10);
-    if (*t == '-')
-    {
-      /* YYYY-MM-DD */
-      a->tm_year = (int)d;
-      a->tm_mon = (int)soap_strtoul(t + 1, &t, 10);
-      a->tm_mday = (int)soap_strtoul(t + 1, &t, 10);
-    }
-    else if (!(soap->mode & SOAP_XML_STRICT))
-    {
-      /* YYYYMMDD */
-      a->tm_year = (int)(d / 10000);
-      a->tm_mon = (int)(d / 100 % 100);
-      a->tm_mday = (int)(d % 100);
-    }
-    else
-      return soap->error = SOAP_TYPE;
-    if (*t == 'T' || ((*t == 't' || *t == ' ') && !(soap->mode & SOAP_XML_STRICT)))
-    {
-      d = soap_strtoul(t + 1, &t, 10);
-      if (*t == ':')
-      {
-	/* Thh:mm:ss */
-	a->tm_hour = (int)d;
-	a->tm_min = (int)soap_strtoul(t + 1, &t, 10);
-	a->tm_sec = (int)soap_strtoul(t + 1, &t, 10);
-      }
-      else if (!(soap->mode & SOAP_XML_STRICT))
-      {
-	/* Thhmmss */
-        a->tm_hour = (int)(d / 10000);
-	a->tm_min = (int)(d / 100 % 100);
-	a->tm_sec = (int)(d % 100);
-      }
-      else
-	return soap->error = SOAP_TYPE;
-    }
-    if (a->tm_year == 1)
-      a->tm_year = 70;
-    else
-      a->tm_year -= 1900;
-    a->tm_mon--;
-    if (*t == '.')
-    {
-      for (t++; *t; t++)
-        if (*t < '0' || *t > '9')
-          break;
-    }
-    if (*t == ' ' && !(soap->mode & SOAP_XML_STRICT))
-      t++;
-    if (*t)
-    {
-#ifndef WITH_NOZONE
-      if (*t == '+' || *t == '-')
-      {
-	int h, m;
-	m = (int)soap_strtol(t, &t, 10);
-        if (*t == ':')
-        {
-	  /* +hh:mm */
-	  h = m;
-	  m = (int)soap_strtol(t + 1, &t, 10);
-          if (h < 0)
-            m = -m;
-        }
-        else if (!(soap->mode & SOAP_XML_STRICT))
-	{
-	  /* +hhmm */
-          h = m / 100;
-          m = m % 100;
-        }
-        else
-	{
-	  /* +hh */
-          h = m;
-	  m = 0;
-        }
-	if (*t)
-	  return soap->error = SOAP_TYPE;
-        a->tm_min -= m;
-        a->tm_hour -= h;
-        /* put hour and min in range */
-        a->tm_hour += a->tm_min / 60;
-        a->tm_min %= 60;
-        if (a->tm_min < 0)
-        {
-	  a->tm_min += 60;
-          a->tm_hour--;
-        }
-        a->tm_mday += a->tm_hour / 24;
-        a->tm_hour %= 24;
-        if (a->tm_hour < 0)
-        {
-	  a->tm_hour += 24;
-          a->tm_mday--;
-        }
-        /* note: day of the month may be out of range, timegm() handles it */
-      }
-      else if (*t != 'Z')
-	return soap->error = SOAP_TYPE;
-#endif
-    }
-    else /* no UTC or timezone, so assume we got a localtime */
-      a->tm_isdst = -1;
-  }
-  return soap->error;
+  /* UTC when a zone is present, otherwise localtime with tm_isdst = -1 */
+  return soap_s2tm(soap, s, a, NULL, 0);
 }
 
 SOAP_FMAC3 struct tm * SOAP_FMAC4 soap_in_xsd__dateTime(struct soap *soap, const char *tag, struct tm *a, const char *type)
@@ -230,7 +230,7 @@ static int
 out_element(struct soap *soap, const struct soap_dom_element *node, const char *prefix, const char *name)
 {
   DBGLOG(TEST, SOAP_MESSAGE(fdebug, "DOM node lead '%s'\n", node->lead ? node->lead : ""));
-  if (node->lead && soap_send(soap, node->lead))
+  if (node->lead && soap_send_xml(soap, node->lead))
     return soap->error;
   if (node->type && node->node)
   {
@@ -483,10 +483,10 @@ soap_out_xsd__anyType(struct soap *soap, const char *tag, int id, const struct s
           if (soap_out_xsd__anyType(soap, NULL, 0, elt, NULL))
             return soap->error;
         DBGLOG(TEST, SOAP_MESSAGE(fdebug, "DOM node code '%s'\n", node->code ? node->code : ""));
-        if (node->code && soap_send(soap, node->code))
+        if (node->code && soap_send_xml(soap, node->code))
           return soap->error;
         DBGLOG(TEST, SOAP_MESSAGE(fdebug, "DOM node tail '%s'\n", node->tail ? node->tail : ""));
-        if (node->tail && soap_send(soap, node->tail))
+        if (node->tail && soap_send_xml(soap, node->tail))
           return soap->error;
         if (!prefix || !*prefix)
         {
@@ -1027,7 +1027,9 @@ soap_push_prefix(struct soap *soap, const char *id, size_t n, const char *ns, in
   if (isearly)
     soap->level++;
   np = soap_push_namespace(soap, id, ns);
-  soap->local_namespaces = ln;
+  if (!soap->local_namespaces)
+    soap->local_namespaces = ln; /* restore the table after pushing a replacement id */
+  ln = soap->local_namespaces; /* soap_push_namespace may have copied a shared table on write */
   if (isearly)
     soap->level--;
   if (!np)
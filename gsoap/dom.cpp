@@ -1027,7 +1027,9 @@ soap_push_prefix(struct soap *soap, const char *id, size_t n, const char *ns, in
   if (isearly)
     soap->level++;
   np = soap_push_namespace(soap, id, ns);
-  soap->local_namespaces = ln;
+  if (!soap->local_namespaces)
+    soap->local_namespaces = ln; /* restore the table after pushing a replacement id */
+  ln = soap->local_namespaces; /* soap_push_namespace may have copied a shared table on write */
   if (isearly)
     soap->level--;
   if (!np)
@@ -32,19 +32,21 @@ SOAP_FMAC1
 void
 SOAP_FMAC2
 soap_print_fault_location(struct soap *soap, std::ostream& msg)
-{ int c;
-  if (soap->error && soap->buflen > 0)
-  { if (soap->bufidx == 0)
-      soap->bufidx = 1;
-    c = soap->buf[soap->bufidx-1];
-    soap->buf[soap->bufidx-1] = '\0';
+{ size_t i, j, n = sizeof(soap->tmpbuf) / 2;
+  if (soap->error && soap->ibuf && soap->bufidx <= soap->buflen && soap->buflen > 0)
+  { // copy the window around bufidx from ibuf, which may be in-situ or read-only
+    i = soap->bufidx > n ? soap->bufidx - n : 0;
+    memcpy(soap->tmpbuf, soap->ibuf + i, soap->bufidx - i);
+    soap->tmpbuf[soap->bufidx - i] = '\0';
+    msg << soap->tmpbuf << std::endl << "** HERE **" << std::endl;
     if (soap->bufidx < soap->buflen)
-      msg << soap->buf << static_cast<char> (c) << std::endl
-          << "** HERE **" << std::endl << soap->buf+soap->bufidx
-          << std::endl;
-    else
-      msg << soap->buf << static_cast<char> (c) << std::endl
-          << "** HERE **" << std::endl;
+    { j = soap->buflen - soap->bufidx;
+      if (j >= sizeof(soap->tmpbuf))
+        j = sizeof(soap->tmpbuf) - 1;
+      memcpy(soap->tmpbuf, soap->ibuf + soap->bufidx, j);
+      soap->tmpbuf[j] = '\0';
+      msg << soap->tmpbuf << std::endl;
+    }
   }
 }
 
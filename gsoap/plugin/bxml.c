@@ -0,0 +1,292 @@
+/*
+        bxml.c
+
+        Binary XML message encoding negotiated with HTTP Content-Type
+
+        See instructions below.
+
+gSOAP XML Web services tools
+Copyright (C) 2000-2023, Robert van Engelen, Genivia, Inc. All Rights Reserved.
+
+--------------------------------------------------------------------------------
+gSOAP public license.
+
+The contents of this file are subject to the gSOAP Public License Version 1.3
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at
+http://www.cs.fsu.edu/~engelen/soaplicense.html
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+for the specific language governing rights and limitations under the License.
+
+The Initial Developer of the Original Code is Robert A. van Engelen.
+Copyright (C) 2000-2023 Robert A. van Engelen, Genivia inc. All Rights Reserved.
+--------------------------------------------------------------------------------
+GPL license.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+Author contact information:
+engelen@genivia.com / engelen@acm.org
+
+This program is released under the GPL with the additional exemption that
+compiling, linking, and/or using OpenSSL is allowed.
+--------------------------------------------------------------------------------
+
+        A client and a server that both register this plugin exchange SOAP
+        and XML messages in a compact binary XML format instead of text.  The
+        engine's serializers and deserializers read and write the format
+        directly, so the generated soap_out_T, soap_in_T, soap_put_T and
+        soap_get_T functions and the service operations are used as usual:
+
+        - soap_element_begin_out(), soap_attribute() and
+          soap_element_end_out() send tags and attributes as tokens with
+          tag and attribute names that are sent once and are referenced by
+          their number in a name table afterwards
+        - short text and attribute values, such as xmlns namespace URIs,
+          xsi:type values and enumeration constants, are sent once and are
+          referenced by their number in a value table afterwards
+        - integers, floats and doubles are sent in binary by the soap_outT
+          functions of the primitive types and read by the soap_inT
+          functions without converting them to and from text
+        - xsd:base64Binary and xsd:hexBinary data is sent as raw bytes
+        - end tags are a single byte and white space between tags is not
+          sent
+
+        The format is negotiated with HTTP Content-Type and Accept headers.  A
+        client that registers the plugin accepts binary XML responses.  With
+        the BXML_REQUEST flag, a client also sends its requests in binary XML,
+        which requires a server that registers the plugin.  A server that
+        registers the plugin accepts binary XML requests and responds in
+        binary XML to a client that sent a binary XML request or accepts a
+        binary XML response.  Other clients and servers exchange XML as usual.
+
+        Binary XML messages can be sent with HTTP chunked transfers and HTTP
+        compression as usual.  Messages with DIME/MIME attachments, canonical
+        XML messages such as signed WS-Security messages, messages in the
+        ISO-8859-1 encoding (SOAP_ENC_LATIN) and non-XML messages, such as
+        JSON, are sent as usual.  Binary XML messages are not received in
+        DOM mode (SOAP_XML_DOM), a request is rejected with HTTP 415 in that
+        case.  The engine must be compiled without WITH_LEAN.
+
+        Usage (server):
+
+        struct soap *soap = soap_new();
+        soap_register_plugin(soap, bxml);
+        ... // serve requests as usual
+
+        Usage (client):
+
+        struct soap *soap = soap_new();
+        soap_register_plugin(soap, bxml); // accept binary XML responses
+        // or: soap_register_plugin_arg(soap, bxml, (void*)BXML_REQUEST);
+        ... // call services as usual
+
+        Wire format: the message is a sequence of tokens, where each token is
+        a token byte followed by its operands.  Numbers are unsigned LEB128
+        varints.  A name or a value is a varint number + 1 of the name or
+        value table, or a varint 0 followed by a varint length and the UTF-8
+        bytes, which are added to the table.  Tables hold at most 1024
+        entries and values are added when at most 64 bytes long.
+
+        0xF0                    end tag of the innermost open element
+        0xF1 value              text
+        0xF2 num                integer, num = magnitude << 1 | sign
+        0xF3 num                unsigned integer
+        0xF4 bits               float, 4 bytes IEEE 754 big endian
+        0xF5 bits               double, 8 bytes IEEE 754 big endian
+        0xF6 len bytes          xsd:base64Binary data
+        0xF7 len bytes          xsd:hexBinary data
+        0xF8 len bytes          comment, processing instruction or DTD
+        0xF9 name               start tag, followed by attributes and 0xFB
+                                or 0xFC
+        0xFA name value         attribute
+        0xFB                    end of start tag
+        0xFC                    end of start tag of an empty element
+
+*/
+
+#include "bxml.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char bxml_id[] = BXML_ID;
+
+static int bxml_copy(struct soap *soap, struct soap_plugin *dst, struct soap_plugin *src);
+static void bxml_delete(struct soap *soap, struct soap_plugin *p);
+static int bxml_post(struct soap *soap, const char *endpoint, const char *host, int port, const char *path, const char *action, ULONG64 count);
+static int bxml_posthdr(struct soap *soap, const char *key, const char *val);
+static int bxml_parse(struct soap *soap);
+static int bxml_parsehdr(struct soap *soap, const char *key, const char *val);
+static int bxml_prepareinitsend(struct soap *soap);
+static int bxml_prepareinitrecv(struct soap *soap);
+
+int bxml(struct soap *soap, struct soap_plugin *p, void *arg)
+{
+  struct bxml_data *data;
+  p->id = bxml_id;
+  p->data = (void*)SOAP_MALLOC(soap, sizeof(struct bxml_data));
+  p->fcopy = bxml_copy;
+  p->fdelete = bxml_delete;
+  if (!p->data)
+    return SOAP_EOM;
+  data = (struct bxml_data*)p->data;
+  memset((void*)data, 0, sizeof(struct bxml_data));
+  data->flags = (int)(size_t)arg;
+  data->fpost = soap->fpost;
+  soap->fpost = bxml_post;
+  data->fposthdr = soap->fposthdr;
+  soap->fposthdr = bxml_posthdr;
+  data->fparse = soap->fparse;
+  soap->fparse = bxml_parse;
+  data->fparsehdr = soap->fparsehdr;
+  soap->fparsehdr = bxml_parsehdr;
+  data->fprepareinitsend = soap->fprepareinitsend;
+  soap->fprepareinitsend = bxml_prepareinitsend;
+  data->fprepareinitrecv = soap->fprepareinitrecv;
+  soap->fprepareinitrecv = bxml_prepareinitrecv;
+  return SOAP_OK;
+}
+
+static int bxml_copy(struct soap *soap, struct soap_plugin *dst, struct soap_plugin *src)
+{
+  (void)soap;
+  *dst = *src;
+  dst->data = (void*)SOAP_MALLOC(soap, sizeof(struct bxml_data));
+  if (!dst->data)
+    return SOAP_EOM;
+  (void)soap_memcpy((void*)dst->data, sizeof(struct bxml_data), (const void*)src->data, sizeof(struct bxml_data));
+  return SOAP_OK;
+}
+
+static void bxml_delete(struct soap *soap, struct soap_plugin *p)
+{
+  soap->bxml = 0;
+  SOAP_FREE(soap, p->data);
+}
+
+/******************************************************************************\
+ *
+ * HTTP negotiation
+ *
+\******************************************************************************/
+
+static int bxml_post(struct soap *soap, const char *endpoint, const char *host, int port, const char *path, const char *action, ULONG64 count)
+{
+  struct bxml_data *data = (struct bxml_data*)soap_lookup_plugin(soap, bxml_id);
+  int err;
+  if (!data)
+    return SOAP_PLUGIN_ERROR;
+  data->post = 1;
+  err = data->fpost(soap, endpoint, host, port, path, action, count);
+  data->post = 0;
+  return err;
+}
+
+static int bxml_posthdr(struct soap *soap, const char *key, const char *val)
+{
+  struct bxml_data *data = (struct bxml_data*)soap_lookup_plugin(soap, bxml_id);
+  if (!data)
+    return SOAP_PLUGIN_ERROR;
+  if (key && val && data->encode && !soap_tag_cmp(key, "Content-Type"))
+  {
+    /* replace the media type, keep its parameters such as the SOAP 1.2 action */
+    char buf[SOAP_TMPLEN];
+    const char *s = strchr(val, ';');
+    size_t n = s ? (size_t)(s - val) : strlen(val);
+    if (!s)
+      s = "";
+    (SOAP_SNPRINTF(buf, sizeof(buf), sizeof(BXML_CONTENT_TYPE) + n + strlen(s) + 9), BXML_CONTENT_TYPE "; type=\"%.*s\"%s", (int)n, val, s);
+    return data->fposthdr(soap, key, buf);
+  }
+  if (!key && data->post && soap->status == SOAP_POST) /* last line of a POST header */
+  {
+    int err = data->fposthdr(soap, "Accept", BXML_CONTENT_TYPE);
+    if (err)
+      return err;
+  }
+  return data->fposthdr(soap, key, val);
+}
+
+static int bxml_parse(struct soap *soap)
+{
+  struct bxml_data *data = (struct bxml_data*)soap_lookup_plugin(soap, bxml_id);
+  int err;
+  if (!data)
+    return SOAP_PLUGIN_ERROR;
+  err = data->fparse(soap);
+  data->server = (soap->status >= SOAP_POST);
+  if (data->decode)
+  {
+    /* the DOM parser reads text XML only */
+    if ((soap->imode & SOAP_XML_DOM))
+      return soap->error = 415;
+    soap->bxml |= SOAP_BXML_IN;
+  }
+  return err;
+}
+
+static int bxml_parsehdr(struct soap *soap, const char *key, const char *val)
+{
+  struct bxml_data *data = (struct bxml_data*)soap_lookup_plugin(soap, bxml_id);
+  if (!data)
+    return SOAP_PLUGIN_ERROR;
+  if (!soap_tag_cmp(key, "Content-Type") && !soap_tag_cmp(val, BXML_CONTENT_TYPE "*"))
+    data->decode = 1;
+  else if (!soap_tag_cmp(key, "Accept") && !soap_tag_cmp(val, "*" BXML_CONTENT_TYPE "*"))
+    data->accept = 1;
+  return data->fparsehdr(soap, key, val);
+}
+
+static int bxml_prepareinitsend(struct soap *soap)
+{
+  struct bxml_data *data = (struct bxml_data*)soap_lookup_plugin(soap, bxml_id);
+  if (!data)
+    return SOAP_PLUGIN_ERROR;
+  if (data->server)
+    data->encode = data->decode || data->accept;
+  else
+    data->encode = (data->flags & BXML_REQUEST) != 0;
+  if ((soap->mode & (SOAP_ENC_PLAIN | SOAP_ENC_DIME | SOAP_ENC_MIME | SOAP_ENC_LATIN | SOAP_XML_CANONICAL | SOAP_XML_DOM))
+   || (soap->http_content && soap_tag_cmp(soap->http_content, "*xml*")))
+    data->encode = 0;
+  if (data->encode)
+    soap->bxml |= SOAP_BXML_OUT;
+  else
+    soap->bxml &= ~SOAP_BXML_OUT;
+  if (data->fprepareinitsend)
+    return data->fprepareinitsend(soap);
+  return SOAP_OK;
+}
+
+static int bxml_prepareinitrecv(struct soap *soap)
+{
+  struct bxml_data *data = (struct bxml_data*)soap_lookup_plugin(soap, bxml_id);
+  if (!data)
+    return SOAP_PLUGIN_ERROR;
+  data->server = 0;
+  data->accept = 0;
+  data->decode = 0;
+  data->encode = 0;
+  soap->bxml = 0;
+  if (data->fprepareinitrecv)
+    return data->fprepareinitrecv(soap);
+  return SOAP_OK;
+}
+
+#ifdef __cplusplus
+}
+#endif
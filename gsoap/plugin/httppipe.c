@@ -151,6 +151,7 @@ static int http_pipe_init_recv(struct soap *soap)
   if (data->len && soap->keep_alive)
   {
     (void)soap_memcpy(soap->buf, sizeof(soap->buf), data->buf, data->len);
+    soap->ibuf = soap->buf;
     soap->bufidx = 0;
     soap->buflen = data->len;
     DBGLOG(TEST,SOAP_MESSAGE(fdebug, "HTTP pipeline: restored %lu buffered bytes\n", (unsigned long)data->len));
@@ -172,7 +173,7 @@ static int http_pipe_final_recv(struct soap *soap)
     data->len = soap->buflen - soap->bufidx;
     if (data->len)
     {
-      (void)soap_memcpy(data->buf, sizeof(data->buf), soap->buf + soap->bufidx, data->len);
+      (void)soap_memcpy(data->buf, sizeof(data->buf), soap->ibuf + soap->bufidx, data->len);
       DBGLOG(TEST,SOAP_MESSAGE(fdebug, "HTTP pipeline: saved %lu buffered bytes\n", (unsigned long)data->len));
     }
   }
@@ -707,7 +707,7 @@ soap_mec_start_alg(struct soap *soap, int alg, const unsigned char *key)
     }
     data->bufidx = soap->buflen - soap->bufidx;
     /* copy buf[bufidx..buflen-1] to data buf */
-    (void)soap_memcpy((void*)data->buf, data->buflen, (const void*)(soap->buf + soap->bufidx), data->bufidx);
+    (void)soap_memcpy((void*)data->buf, data->buflen, (const void*)(soap->ibuf + soap->bufidx), data->bufidx);
     DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Alloc buf=%lu, copy %lu message bytes\n", (unsigned long)data->buflen, (unsigned long)data->bufidx));
     /* trigger ffilterrecv() */
     soap->bufidx = soap->buflen;
@@ -0,0 +1,206 @@
+/*
+        parallel.c
+
+        Parallel (de)serialization of large arrays with threads
+
+        See instructions below.
+
+gSOAP XML Web services tools
+Copyright (C) 2000-2023, Robert van Engelen, Genivia, Inc. All Rights Reserved.
+
+--------------------------------------------------------------------------------
+gSOAP public license.
+
+The contents of this file are subject to the gSOAP Public License Version 1.3
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at
+http://www.cs.fsu.edu/~engelen/soaplicense.html
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+for the specific language governing rights and limitations under the License.
+
+The Initial Developer of the Original Code is Robert A. van Engelen.
+Copyright (C) 2000-2023 Robert A. van Engelen, Genivia inc. All Rights Reserved.
+--------------------------------------------------------------------------------
+GPL license.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+Author contact information:
+engelen@genivia.com / engelen@acm.org
+
+This program is released under the GPL with the additional exemption that
+compiling, linking, and/or using OpenSSL is allowed.
+--------------------------------------------------------------------------------
+
+        Compile & link with threads.c on Windows, with -lpthread on Unix/Linux.
+
+        The soapcpp2 -F option generates code that deserializes the items of a
+        large array or std::vector in parallel when this plugin is registered
+        and the XML message is read from an in-situ buffer, such as a file
+        mapped with soap_mmap() or a string assigned to soap->isbuf.  The
+        items are split in slices at element boundaries.  Each slice is
+        deserialized by a separate context copy in a thread, after which the
+        deserialized data is managed by the context.
+
+        The generated code also serializes the items of a large array or
+        std::vector in parallel, in slices of at least SOAP_SLICENUM items.
+        Each slice is serialized by a separate context copy in a thread into
+        a buffer.  The buffers are sent in sequence by the context, with
+        compression, chunking and HTTP content length as usual.
+
+        Only arrays of items without id, href and ref attributes of SOAP
+        encoding and SOAP_XML_GRAPH are (de)serialized in parallel.
+        Callbacks, such as soap->fignore, are invoked by the threads and must
+        be thread-safe.
+
+        Usage:
+
+        struct soap *soap = soap_new();
+        soap_register_plugin(soap, parallel); // as many threads as CPUs
+        // or: soap_register_plugin_arg(soap, parallel, (void*)(size_t)4);
+        int fd = open("data.xml", O_RDONLY);
+        if (soap_mmap(soap, fd) || soap_read_ns__Data(soap, &data))
+          ... // error
+        ...
+        if (soap_write_ns__Data(soap, &data))
+          ... // error
+        soap_destroy(soap);
+        soap_end(soap);
+        soap_free(soap); // unmaps the file and deletes the plugin
+        close(fd);
+
+        Context copies made with soap_copy() share the plugin.
+
+*/
+
+#include "parallel.h"
+#include "threads.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* default number of threads when the number of CPUs is unknown */
+#define PARALLEL_THREADS (4)
+
+const char parallel_id[] = PARALLEL_ID;
+
+/* the jobs of a parallel run, claimed in order by the threads */
+struct parallel_jobs
+{
+  int (*job)(void*);
+  void **args;
+  int num;
+  int next;
+  int error;
+  MUTEX_TYPE lock;
+};
+
+static void parallel_delete(struct soap *soap, struct soap_plugin *p);
+static int parallel_run(struct soap *soap, int (*job)(void*), void **args, int num);
+static void *parallel_thread(void *arg);
+
+int parallel(struct soap *soap, struct soap_plugin *p, void *arg)
+{
+  struct parallel_data *data;
+  p->id = parallel_id;
+  p->data = (void*)SOAP_MALLOC(soap, sizeof(struct parallel_data));
+  p->fdelete = parallel_delete;
+  p->fcopy = NULL; /* copies share the plugin data */
+  if (!p->data)
+    return SOAP_EOM;
+  data = (struct parallel_data*)p->data;
+  data->threads = (int)(size_t)arg;
+  if (data->threads <= 0)
+  {
+#if defined(WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    data->threads = (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    data->threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (data->threads <= 0)
+      data->threads = PARALLEL_THREADS;
+  }
+  soap->fparallel = parallel_run;
+  return SOAP_OK;
+}
+
+static void parallel_delete(struct soap *soap, struct soap_plugin *p)
+{
+  if (soap->fparallel == parallel_run)
+    soap->fparallel = NULL;
+  SOAP_FREE(soap, p->data); /* free allocated plugin data (this function is not called for shared plugin data, but only when the final soap_done() is invoked on the original soap struct) */
+}
+
+static int parallel_run(struct soap *soap, int (*job)(void*), void **args, int num)
+{
+  struct parallel_data *data = (struct parallel_data*)soap_lookup_plugin(soap, parallel_id);
+  struct parallel_jobs jobs;
+  THREAD_TYPE tid[SOAP_MAXSLICES];
+  int i, n;
+  if (!data)
+    return SOAP_PLUGIN_ERROR;
+  jobs.job = job;
+  jobs.args = args;
+  jobs.num = num;
+  jobs.next = 0;
+  jobs.error = SOAP_OK;
+  MUTEX_SETUP(jobs.lock);
+  n = data->threads < num ? data->threads : num;
+  if (n > SOAP_MAXSLICES)
+    n = SOAP_MAXSLICES;
+  /* this thread runs jobs too, when fewer threads could be created the others run more jobs */
+  for (i = 0; i < n - 1; i++)
+    if (THREAD_CREATEX(&tid[i], parallel_thread, (void*)&jobs))
+      break;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Running %d jobs with %d threads\n", num, i + 1));
+  (void)parallel_thread((void*)&jobs);
+  while (i-- > 0)
+  {
+    THREAD_JOIN(tid[i]);
+    THREAD_CLOSE(tid[i]);
+  }
+  MUTEX_CLEANUP(jobs.lock);
+  return jobs.error;
+}
+
+static void *parallel_thread(void *arg)
+{
+  struct parallel_jobs *jobs = (struct parallel_jobs*)arg;
+  for (;;)
+  {
+    int i, err;
+    MUTEX_LOCK(jobs->lock);
+    i = jobs->next++;
+    MUTEX_UNLOCK(jobs->lock);
+    if (i >= jobs->num)
+      break;
+    err = jobs->job(jobs->args[i]);
+    if (err)
+    {
+      MUTEX_LOCK(jobs->lock);
+      if (!jobs->error)
+        jobs->error = err;
+      MUTEX_UNLOCK(jobs->lock);
+    }
+  }
+  return NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
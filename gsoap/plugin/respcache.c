@@ -0,0 +1,694 @@
+/*
+        respcache.c
+
+        Server-side cache of HTTP responses to idempotent operations
+
+        See instructions below.
+
+gSOAP XML Web services tools
+Copyright (C) 2000-2023, Robert van Engelen, Genivia, Inc. All Rights Reserved.
+
+--------------------------------------------------------------------------------
+gSOAP public license.
+
+The contents of this file are subject to the gSOAP Public License Version 1.3
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at
+http://www.cs.fsu.edu/~engelen/soaplicense.html
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+for the specific language governing rights and limitations under the License.
+
+The Initial Developer of the Original Code is Robert A. van Engelen.
+Copyright (C) 2000-2023 Robert A. van Engelen, Genivia inc. All Rights Reserved.
+--------------------------------------------------------------------------------
+GPL license.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+Author contact information:
+engelen@genivia.com / engelen@acm.org
+
+This program is released under the GPL with the additional exemption that
+compiling, linking, and/or using OpenSSL is allowed.
+--------------------------------------------------------------------------------
+
+        A server that registers this plugin replays the HTTP response to a
+        request of a cacheable operation when an identical request was served
+        before, without parsing the request, invoking the service operation,
+        or serializing the response:
+
+        - a cacheable operation is opted in with soap_respcache_add() with a
+          time to live in seconds, by its SOAPAction or by its URL path, and
+          its requests that carry a Cookie header are never cached
+        - the body of an HTTP POST request of a cacheable operation is read
+          into the engine's buffer before the request is parsed, together
+          with the SOAPAction, the URL path, the Content-Type, the Accept and
+          Host headers, the HTTP version, and the keep-alive and compression
+          of the response it forms the key of the request
+        - a request with the same key as a cached response that did not
+          expire is answered with the cached HTTP response bytes
+        - otherwise the request is served as usual and its HTTP response is
+          captured as it is sent and is cached when it has status 200 OK and
+          an HTTP content length and does not set cookies
+
+        Keys are compared byte by byte, so only requests with the same bytes
+        hit the same cached response.  A hash of the key is used to find the
+        cached responses in a hash table.  The cache is an LRU cache bounded
+        by a max number of entries and a max total size, which are set with
+        soap_respcache_limits().  A single response is cached when it is not
+        larger than 1/8th of the max total size.  Expired responses are
+        removed when they are looked up or when they are the least recently
+        used.  The cache is shared by the context that registered the plugin
+        and its copies made with soap_copy() and may be used by multiple
+        threads.
+
+        Requests with HTTP chunked transfers or compressed requests, requests
+        with HTTP authentication, requests with cookies, and requests larger
+        than the engine's buffer (SOAP_BUFLEN) are served as usual and are
+        not cached.  Other HTTP headers of a request are not part of its key,
+        so a cacheable operation should not depend on them.  Because
+        cached responses are replayed as they were sent, including their HTTP
+        headers such as the Date header, only operations whose responses
+        depend on the request message alone should be cached.  Clear the
+        cache with soap_respcache_clear() when the data that the cached
+        responses depend on changes.
+
+        Register this plugin after other plugins that handle HTTP requests,
+        such as httppost and httpform.  This plugin should not be combined
+        with plugins that change the message bytes sent or received, such as
+        bxml.  The engine must be compiled without WITH_LEANER and without
+        WITH_NOHTTP.
+
+        Usage (server):
+
+        struct soap *soap = soap_new();
+        soap_register_plugin(soap, respcache);
+        soap_respcache_limits(soap, 4096, 64*1024*1024);  // optional
+        soap_respcache_add(soap, "urn:quote#getQuote", 10); // cache responses to getQuote for 10 seconds
+        soap_respcache_add(soap, "/rates", 60);             // cache responses to POST /rates for 60 seconds
+        ... // serve requests as usual, for example with soap_copy() and threads
+
+        When the quotes change:
+
+        soap_respcache_clear(soap);
+
+*/
+
+#include "respcache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char respcache_id[] = RESPCACHE_ID;
+
+static int respcache_copy(struct soap *soap, struct soap_plugin *dst, struct soap_plugin *src);
+static void respcache_delete(struct soap *soap, struct soap_plugin *p);
+static int respcache_parse(struct soap *soap);
+static int respcache_parsehdr(struct soap *soap, const char *key, const char *val);
+static int respcache_form(struct soap *soap);
+static int respcache_send(struct soap *soap, const char *s, size_t n);
+static int respcache_read(struct soap *soap);
+static int respcache_key(struct soap *soap, struct respcache_data *data);
+static int respcache_lookup(struct soap *soap, struct respcache_data *data);
+static void respcache_capture(struct soap *soap, struct respcache_data *data, const char *s, size_t n);
+static void respcache_insert(struct soap *soap, struct respcache_data *data);
+static int respcache_ttl(struct respcache_cache *cache, struct soap *soap);
+static int respcache_cacheable(const char *s, const char *e, size_t *length);
+static const char *respcache_hdr(const char *s, const char *e, const char *key);
+static void respcache_unlink(struct soap *soap, struct respcache_cache *cache, struct respcache_entry *e);
+static int respcache_put(struct soap *soap, struct respcache_buf *b, const char *s, size_t n);
+static int respcache_str(struct soap *soap, struct respcache_buf *b, const char *s);
+static size_t respcache_hash(const char *s, size_t n);
+
+int respcache(struct soap *soap, struct soap_plugin *p, void *arg)
+{
+  struct respcache_data *data;
+  struct respcache_cache *cache;
+  (void)arg;
+  p->id = respcache_id;
+  p->data = (void*)SOAP_MALLOC(soap, sizeof(struct respcache_data));
+  p->fcopy = respcache_copy;
+  p->fdelete = respcache_delete;
+  if (!p->data)
+    return SOAP_EOM;
+  data = (struct respcache_data*)p->data;
+  memset((void*)data, 0, sizeof(struct respcache_data));
+  cache = (struct respcache_cache*)SOAP_MALLOC(soap, sizeof(struct respcache_cache));
+  if (!cache)
+  {
+    SOAP_FREE(soap, p->data);
+    p->data = NULL;
+    return SOAP_EOM;
+  }
+  memset((void*)cache, 0, sizeof(struct respcache_cache));
+  MUTEX_SETUP(cache->lock);
+  cache->refs = 1;
+  cache->max_entries = RESPCACHE_MAX_ENTRIES;
+  cache->max_bytes = RESPCACHE_MAX_BYTES;
+  data->cache = cache;
+  data->fparse = soap->fparse;
+  soap->fparse = respcache_parse;
+  data->fparsehdr = soap->fparsehdr;
+  soap->fparsehdr = respcache_parsehdr;
+  data->fsend = soap->fsend;
+  soap->fsend = respcache_send;
+  return SOAP_OK;
+}
+
+/* the copy shares the cache */
+static int respcache_copy(struct soap *soap, struct soap_plugin *dst, struct soap_plugin *src)
+{
+  struct respcache_data *data;
+  (void)soap;
+  *dst = *src;
+  dst->data = (void*)SOAP_MALLOC(soap, sizeof(struct respcache_data));
+  if (!dst->data)
+    return SOAP_EOM;
+  data = (struct respcache_data*)dst->data;
+  (void)soap_memcpy((void*)data, sizeof(struct respcache_data), (const void*)src->data, sizeof(struct respcache_data));
+  data->ttl = 0;
+  data->capture = 0;
+  memset((void*)&data->key, 0, sizeof(struct respcache_buf));
+  memset((void*)&data->resp, 0, sizeof(struct respcache_buf));
+  memset((void*)&data->hdrs, 0, sizeof(struct respcache_buf));
+  MUTEX_LOCK(data->cache->lock);
+  data->cache->refs++;
+  MUTEX_UNLOCK(data->cache->lock);
+  return SOAP_OK;
+}
+
+static void respcache_delete(struct soap *soap, struct soap_plugin *p)
+{
+  struct respcache_data *data = (struct respcache_data*)p->data;
+  struct respcache_cache *cache = data->cache;
+  int refs;
+  MUTEX_LOCK(cache->lock);
+  refs = --cache->refs;
+  MUTEX_UNLOCK(cache->lock);
+  if (refs == 0)
+  {
+    while (cache->ops)
+    {
+      struct respcache_op *op = cache->ops;
+      cache->ops = op->next;
+      if (op->name)
+        SOAP_FREE(soap, op->name);
+      SOAP_FREE(soap, op);
+    }
+    while (cache->tail)
+      respcache_unlink(soap, cache, cache->tail);
+    MUTEX_CLEANUP(cache->lock);
+    SOAP_FREE(soap, cache);
+  }
+  if (data->key.ptr)
+    SOAP_FREE(soap, data->key.ptr);
+  if (data->resp.ptr)
+    SOAP_FREE(soap, data->resp.ptr);
+  if (data->hdrs.ptr)
+    SOAP_FREE(soap, data->hdrs.ptr);
+  SOAP_FREE(soap, p->data);
+}
+
+/******************************************************************************\
+ *
+ * Configuration
+ *
+\******************************************************************************/
+
+int soap_respcache_add(struct soap *soap, const char *name, int ttl)
+{
+  struct respcache_data *data = (struct respcache_data*)soap_lookup_plugin(soap, respcache_id);
+  struct respcache_op *op;
+  if (!data)
+    return soap->error = SOAP_PLUGIN_ERROR;
+  op = (struct respcache_op*)SOAP_MALLOC(soap, sizeof(struct respcache_op));
+  if (!op)
+    return soap->error = SOAP_EOM;
+  op->name = NULL;
+  op->ttl = ttl;
+  if (name)
+  {
+    size_t n = strlen(name) + 1;
+    op->name = (char*)SOAP_MALLOC(soap, n);
+    if (!op->name)
+    {
+      SOAP_FREE(soap, op);
+      return soap->error = SOAP_EOM;
+    }
+    (void)soap_memcpy((void*)op->name, n, (const void*)name, n);
+  }
+  MUTEX_LOCK(data->cache->lock);
+  op->next = data->cache->ops;
+  data->cache->ops = op;
+  MUTEX_UNLOCK(data->cache->lock);
+  return SOAP_OK;
+}
+
+void soap_respcache_limits(struct soap *soap, size_t max_entries, size_t max_bytes)
+{
+  struct respcache_data *data = (struct respcache_data*)soap_lookup_plugin(soap, respcache_id);
+  struct respcache_cache *cache;
+  if (!data)
+    return;
+  cache = data->cache;
+  MUTEX_LOCK(cache->lock);
+  cache->max_entries = max_entries;
+  cache->max_bytes = max_bytes;
+  while (cache->tail && (cache->num > cache->max_entries || cache->bytes > cache->max_bytes))
+    respcache_unlink(soap, cache, cache->tail);
+  MUTEX_UNLOCK(cache->lock);
+}
+
+void soap_respcache_clear(struct soap *soap)
+{
+  struct respcache_data *data = (struct respcache_data*)soap_lookup_plugin(soap, respcache_id);
+  struct respcache_cache *cache;
+  if (!data)
+    return;
+  cache = data->cache;
+  MUTEX_LOCK(cache->lock);
+  while (cache->tail)
+    respcache_unlink(soap, cache, cache->tail);
+  MUTEX_UNLOCK(cache->lock);
+}
+
+/******************************************************************************\
+ *
+ * Requests
+ *
+\******************************************************************************/
+
+static int respcache_parse(struct soap *soap)
+{
+  struct respcache_data *data = (struct respcache_data*)soap_lookup_plugin(soap, respcache_id);
+  int err;
+  if (!data)
+    return SOAP_PLUGIN_ERROR;
+  data->ttl = 0;
+  data->capture = 0;
+  data->cookie = 0;
+  data->hdrs.len = 0;
+  err = data->fparse(soap);
+  if (err
+   || data->cookie
+   || soap->status != SOAP_POST
+   || soap->fform
+   || !soap->body
+   || soap->length == 0
+   || soap->length > sizeof(soap->buf)
+   || (soap->imode & SOAP_IO) == SOAP_IO_CHUNK
+#ifdef WITH_ZLIB
+   || soap->zlib_in != SOAP_ZLIB_NONE
+#endif
+   || soap->userid
+   || soap->passwd
+   || soap->bearer)
+    return err;
+  MUTEX_LOCK(data->cache->lock);
+  data->ttl = respcache_ttl(data->cache, soap);
+  data->max = data->cache->max_bytes / 8;
+  MUTEX_UNLOCK(data->cache->lock);
+  if (data->ttl <= 0)
+    return SOAP_OK;
+  if (respcache_read(soap) || respcache_key(soap, data))
+    return soap->error;
+  if (respcache_lookup(soap, data))
+  {
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Response cache hit\n"));
+    /* soap_begin_recv() invokes the handler and stops further processing */
+    soap->fform = respcache_form;
+  }
+  else
+  {
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Response cache miss\n"));
+    data->hdrlen = 0;
+    data->total = 0;
+    data->resp.len = 0;
+    data->capture = 1;
+  }
+  return SOAP_OK;
+}
+
+static int respcache_parsehdr(struct soap *soap, const char *key, const char *val)
+{
+  struct respcache_data *data = (struct respcache_data*)soap_lookup_plugin(soap, respcache_id);
+  if (!data)
+    return SOAP_PLUGIN_ERROR;
+  if (!soap_tag_cmp(key, "Cookie") || !soap_tag_cmp(key, "Cookie2"))
+    data->cookie = 1;
+  else if ((!soap_tag_cmp(key, "Accept") || !soap_tag_cmp(key, "Host"))
+        && (respcache_str(soap, &data->hdrs, key) || respcache_str(soap, &data->hdrs, val)))
+    return soap->error;
+  return data->fparsehdr(soap, key, val);
+}
+
+/* replays the cached response and skips the request body */
+static int respcache_form(struct soap *soap)
+{
+  struct respcache_data *data = (struct respcache_data*)soap_lookup_plugin(soap, respcache_id);
+  if (!data)
+    return SOAP_PLUGIN_ERROR;
+  soap->bufidx += (size_t)soap->length;
+  return data->fsend(soap, data->resp.ptr, data->resp.len);
+}
+
+/* reads the request body into the buffer after the HTTP header was parsed */
+static int respcache_read(struct soap *soap)
+{
+  size_t n = (size_t)soap->length;
+  if (soap->bufidx > 0)
+  {
+    if (soap->bufidx < soap->buflen)
+      (void)memmove((void*)soap->buf, (const void*)(soap->ibuf + soap->bufidx), soap->buflen - soap->bufidx);
+    soap->buflen -= soap->bufidx;
+    soap->bufidx = 0;
+  }
+  else if (soap->ibuf != soap->buf)
+  {
+    (void)memmove((void*)soap->buf, (const void*)soap->ibuf, soap->buflen);
+  }
+  soap->ibuf = soap->buf;
+  while (soap->buflen < n)
+  {
+    size_t r = soap->frecv(soap, soap->buf + soap->buflen, sizeof(soap->buf) - soap->buflen);
+    if (r == 0)
+      return soap->error = SOAP_EOF;
+    soap->buflen += r;
+    soap->count += r;
+  }
+  return SOAP_OK;
+}
+
+/* the key consists of the properties of the request that determine the response bytes */
+static int respcache_key(struct soap *soap, struct respcache_data *data)
+{
+  char tmp[2];
+  tmp[0] = (char)(soap->keep_alive != 0);
+#ifdef WITH_ZLIB
+  tmp[1] = (char)soap->zlib_out;
+#else
+  tmp[1] = 0;
+#endif
+  data->key.len = 0;
+  if (respcache_put(soap, &data->key, tmp, 2)
+   || respcache_str(soap, &data->key, soap->http_version)
+   || respcache_str(soap, &data->key, soap->action)
+   || respcache_str(soap, &data->key, soap->path)
+   || respcache_str(soap, &data->key, soap->http_content)
+   || respcache_put(soap, &data->key, data->hdrs.ptr, data->hdrs.len)
+   || respcache_put(soap, &data->key, soap->ibuf + soap->bufidx, (size_t)soap->length))
+    return soap->error;
+  data->hash = respcache_hash(data->key.ptr, data->key.len);
+  return SOAP_OK;
+}
+
+/* copies the cached response for the key to data->resp, returns nonzero when found */
+static int respcache_lookup(struct soap *soap, struct respcache_data *data)
+{
+  struct respcache_cache *cache = data->cache;
+  struct respcache_entry *e;
+  int found = 0;
+  MUTEX_LOCK(cache->lock);
+  for (e = cache->table[data->hash & (RESPCACHE_HASHSIZE - 1)]; e; e = e->chain)
+  {
+    if (e->hash == data->hash && e->keylen == data->key.len && !memcmp((const void*)(e + 1), (const void*)data->key.ptr, e->keylen))
+    {
+      if (e->expires <= time(NULL))
+      {
+        respcache_unlink(soap, cache, e);
+        break;
+      }
+      if (e != cache->head)
+      {
+        e->prev->next = e->next;
+        if (e->next)
+          e->next->prev = e->prev;
+        else
+          cache->tail = e->prev;
+        e->prev = NULL;
+        e->next = cache->head;
+        cache->head->prev = e;
+        cache->head = e;
+      }
+      data->resp.len = 0;
+      found = !respcache_put(soap, &data->resp, (const char*)(e + 1) + e->keylen, e->resplen);
+      break;
+    }
+  }
+  MUTEX_UNLOCK(cache->lock);
+  if (!found)
+    soap->error = SOAP_OK;
+  return found;
+}
+
+/* returns the TTL of the operation of the request, 0 when not cacheable */
+static int respcache_ttl(struct respcache_cache *cache, struct soap *soap)
+{
+  struct respcache_op *op;
+  for (op = cache->ops; op; op = op->next)
+  {
+    if (!op->name)
+      return op->ttl;
+    if (*op->name == '/' ? !strcmp(op->name, soap->path) : soap->action && !strcmp(op->name, soap->action))
+      return op->ttl;
+  }
+  return 0;
+}
+
+/******************************************************************************\
+ *
+ * Responses
+ *
+\******************************************************************************/
+
+static int respcache_send(struct soap *soap, const char *s, size_t n)
+{
+  struct respcache_data *data = (struct respcache_data*)soap_lookup_plugin(soap, respcache_id);
+  if (!data)
+    return SOAP_PLUGIN_ERROR;
+  if (data->capture)
+    respcache_capture(soap, data, s, n);
+  return data->fsend(soap, s, n);
+}
+
+/* appends sent bytes to the captured response and caches the response when complete */
+static void respcache_capture(struct soap *soap, struct respcache_data *data, const char *s, size_t n)
+{
+  if (respcache_put(soap, &data->resp, s, n) || data->resp.len > data->max)
+  {
+    soap->error = SOAP_OK;
+    data->capture = 0;
+    return;
+  }
+  if (!data->hdrlen)
+  {
+    const char *t = data->resp.ptr;
+    const char *e = data->resp.ptr + data->resp.len;
+    size_t length;
+    while (t + 4 <= e && (t[0] != '\r' || t[1] != '\n' || t[2] != '\r' || t[3] != '\n'))
+      t++;
+    if (t + 4 > e)
+      return;
+    data->hdrlen = t + 4 - data->resp.ptr;
+    if (!respcache_cacheable(data->resp.ptr, t + 2, &length))
+    {
+      data->capture = 0;
+      return;
+    }
+    data->total = data->hdrlen + length;
+  }
+  if (data->resp.len >= data->total)
+  {
+    data->capture = 0;
+    if (data->resp.len == data->total)
+      respcache_insert(soap, data);
+  }
+}
+
+/* returns nonzero when the HTTP response header s..e has status 200 and a content length and does not set cookies */
+static int respcache_cacheable(const char *s, const char *e, size_t *length)
+{
+  int found = 0;
+  if (e - s < 12 || strncmp(s, "HTTP/1.", 7) || strncmp(s + 8, " 200", 4))
+    return 0;
+  while (s < e)
+  {
+    const char *t = s, *v;
+    while (t < e && *t != '\r')
+      t++;
+    if ((v = respcache_hdr(s, t, "content-length")) != NULL)
+    {
+      *length = 0;
+      if (v >= t)
+        return 0;
+      while (v < t && *v >= '0' && *v <= '9')
+        *length = 10 * *length + (*v++ - '0');
+      found = 1;
+    }
+    else if (respcache_hdr(s, t, "set-cookie") || respcache_hdr(s, t, "transfer-encoding"))
+    {
+      return 0;
+    }
+    s = t + 2;
+  }
+  return found;
+}
+
+/* returns the value of the HTTP header line s..e when it has the lower case key, or NULL */
+static const char *respcache_hdr(const char *s, const char *e, const char *key)
+{
+  while (*key && s < e && tolower((unsigned char)*s) == *key)
+  {
+    s++;
+    key++;
+  }
+  if (*key || s >= e || *s != ':')
+    return NULL;
+  for (s++; s < e && (*s == ' ' || *s == '\t'); s++)
+    continue;
+  return s;
+}
+
+/******************************************************************************\
+ *
+ * LRU cache
+ *
+\******************************************************************************/
+
+static void respcache_insert(struct soap *soap, struct respcache_data *data)
+{
+  struct respcache_cache *cache = data->cache;
+  struct respcache_entry *e, *p;
+  size_t size = sizeof(struct respcache_entry) + data->key.len + data->resp.len;
+  size_t i = data->hash & (RESPCACHE_HASHSIZE - 1);
+  e = (struct respcache_entry*)SOAP_MALLOC(soap, size);
+  if (!e)
+    return;
+  e->prev = NULL;
+  e->hash = data->hash;
+  e->expires = time(NULL) + data->ttl;
+  e->keylen = data->key.len;
+  e->resplen = data->resp.len;
+  (void)soap_memcpy((void*)(e + 1), data->key.len, (const void*)data->key.ptr, data->key.len);
+  (void)soap_memcpy((void*)((char*)(e + 1) + e->keylen), data->resp.len, (const void*)data->resp.ptr, data->resp.len);
+  MUTEX_LOCK(cache->lock);
+  /* another thread may have cached a response to the same request */
+  for (p = cache->table[i]; p; p = p->chain)
+  {
+    if (p->hash == e->hash && p->keylen == e->keylen && !memcmp((const void*)(p + 1), (const void*)(e + 1), e->keylen))
+    {
+      respcache_unlink(soap, cache, p);
+      break;
+    }
+  }
+  while (cache->tail && (cache->num >= cache->max_entries || cache->bytes + size > cache->max_bytes))
+    respcache_unlink(soap, cache, cache->tail);
+  if (cache->num >= cache->max_entries || size > cache->max_bytes)
+  {
+    MUTEX_UNLOCK(cache->lock);
+    SOAP_FREE(soap, e);
+    return;
+  }
+  e->next = cache->head;
+  if (cache->head)
+    cache->head->prev = e;
+  else
+    cache->tail = e;
+  cache->head = e;
+  e->chain = cache->table[i];
+  cache->table[i] = e;
+  cache->num++;
+  cache->bytes += size;
+  MUTEX_UNLOCK(cache->lock);
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Response cached (%lu bytes)\n", (unsigned long)data->resp.len));
+}
+
+/* removes and deletes entry e, the cache must be locked */
+static void respcache_unlink(struct soap *soap, struct respcache_cache *cache, struct respcache_entry *e)
+{
+  struct respcache_entry **p;
+  (void)soap;
+  for (p = &cache->table[e->hash & (RESPCACHE_HASHSIZE - 1)]; *p; p = &(*p)->chain)
+  {
+    if (*p == e)
+    {
+      *p = e->chain;
+      break;
+    }
+  }
+  if (e->prev)
+    e->prev->next = e->next;
+  else
+    cache->head = e->next;
+  if (e->next)
+    e->next->prev = e->prev;
+  else
+    cache->tail = e->prev;
+  cache->num--;
+  cache->bytes -= sizeof(struct respcache_entry) + e->keylen + e->resplen;
+  SOAP_FREE(soap, e);
+}
+
+/******************************************************************************\
+ *
+ * Buffers
+ *
+\******************************************************************************/
+
+static int respcache_put(struct soap *soap, struct respcache_buf *b, const char *s, size_t n)
+{
+  if (b->len + n > b->max)
+  {
+    size_t max = b->max ? 2 * b->max : 256;
+    char *ptr;
+    while (max < b->len + n)
+      max *= 2;
+    ptr = (char*)SOAP_MALLOC(soap, max);
+    if (!ptr)
+      return soap->error = SOAP_EOM;
+    if (b->len)
+      (void)soap_memcpy((void*)ptr, max, (const void*)b->ptr, b->len);
+    if (b->ptr)
+      SOAP_FREE(soap, b->ptr);
+    b->ptr = ptr;
+    b->max = max;
+  }
+  if (n)
+    (void)soap_memcpy((void*)(b->ptr + b->len), b->max - b->len, (const void*)s, n);
+  b->len += n;
+  return SOAP_OK;
+}
+
+/* appends string s with its terminating '\0', or just a '\0' when s is NULL */
+static int respcache_str(struct soap *soap, struct respcache_buf *b, const char *s)
+{
+  if (!s)
+    s = "";
+  return respcache_put(soap, b, s, strlen(s) + 1);
+}
+
+/* FNV-1a */
+static size_t respcache_hash(const char *s, size_t n)
+{
+  size_t h = (size_t)2166136261UL;
+  while (n--)
+    h = (h ^ (unsigned char)*s++) * (size_t)16777619UL;
+  return h;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,135 @@
+/*
+        respcache.h
+
+        Server-side cache of HTTP responses to idempotent operations
+
+gSOAP XML Web services tools
+Copyright (C) 2000-2023, Robert van Engelen, Genivia, Inc. All Rights Reserved.
+
+--------------------------------------------------------------------------------
+gSOAP public license.
+
+The contents of this file are subject to the gSOAP Public License Version 1.3
+(the "License"); you may not use this file except in compliance with the
+License. You may obtain a copy of the License at
+http://www.cs.fsu.edu/~engelen/soaplicense.html
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+for the specific language governing rights and limitations under the License.
+
+The Initial Developer of the Original Code is Robert A. van Engelen.
+Copyright (C) 2000-2023 Robert A. van Engelen, Genivia inc. All Rights Reserved.
+--------------------------------------------------------------------------------
+GPL license.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+Author contact information:
+engelen@genivia.com / engelen@acm.org
+
+This program is released under the GPL with the additional exemption that
+compiling, linking, and/or using OpenSSL is allowed.
+--------------------------------------------------------------------------------
+*/
+
+#ifndef RESPCACHE_H
+#define RESPCACHE_H
+
+#include "stdsoap2.h"
+#include "threads.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RESPCACHE_ID "SOAP-RESPCACHE/1.0" /* plugin identification */
+
+#define RESPCACHE_MAX_ENTRIES (1024)            /* default max number of cached responses */
+#define RESPCACHE_MAX_BYTES   (16*1024*1024)    /* default max total size of the cached requests and responses */
+#define RESPCACHE_HASHSIZE    (4096)            /* size of the hash table, a power of two */
+
+extern const char respcache_id[];
+
+/* growable buffer */
+struct respcache_buf
+{
+  char *ptr;
+  size_t len;
+  size_t max;
+};
+
+/* cacheable operation, identified by its SOAPAction or by its URL path */
+struct respcache_op
+{
+  struct respcache_op *next;
+  char *name; /* NULL matches all operations */
+  int ttl;    /* seconds */
+};
+
+/* cached HTTP response, the key and response bytes follow the entry in memory */
+struct respcache_entry
+{
+  struct respcache_entry *prev;  /* more recently used */
+  struct respcache_entry *next;  /* less recently used */
+  struct respcache_entry *chain; /* next entry with the same hash table index */
+  size_t hash;
+  time_t expires;
+  size_t keylen;
+  size_t resplen;
+};
+
+/* LRU cache shared by the context that registered the plugin and its copies */
+struct respcache_cache
+{
+  MUTEX_TYPE lock;
+  int refs;
+  size_t max_entries;
+  size_t max_bytes;
+  size_t num;
+  size_t bytes;
+  struct respcache_entry *head; /* most recently used */
+  struct respcache_entry *tail; /* least recently used */
+  struct respcache_entry *table[RESPCACHE_HASHSIZE];
+  struct respcache_op *ops;
+};
+
+struct respcache_data
+{
+  struct respcache_cache *cache;
+  int ttl;                   /* TTL of the operation of the current request, 0 when not cacheable */
+  int capture;               /* capturing the response to the current request */
+  int cookie;                /* the current request has a Cookie header, which is not part of the key */
+  size_t max;                /* max size of a cached response */
+  size_t hash;               /* hash of the key */
+  size_t hdrlen;             /* length of the captured HTTP header, 0 when incomplete */
+  size_t total;              /* length of the captured HTTP response, 0 when unknown */
+  struct respcache_buf key;  /* key of the current request */
+  struct respcache_buf resp; /* captured or cached HTTP response */
+  struct respcache_buf hdrs; /* Accept and Host headers of the current request, part of the key */
+  int (*fparse)(struct soap*);
+  int (*fparsehdr)(struct soap*, const char*, const char*);
+  int (*fsend)(struct soap*, const char*, size_t);
+};
+
+int respcache(struct soap*, struct soap_plugin*, void*);
+/* responses to requests with a Cookie header are never cached, because the key includes the Accept and Host headers but no cookies or other HTTP headers */
+int soap_respcache_add(struct soap *soap, const char *name, int ttl);
+void soap_respcache_limits(struct soap *soap, size_t max_entries, size_t max_bytes);
+void soap_respcache_clear(struct soap *soap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -340,12 +340,14 @@ SOAP_FMAC3 int SOAP_FMAC4 soap_ignore_element(struct soap *soap)
 #ifndef WITH_NOIDREF
 SOAP_FMAC3 int SOAP_FMAC4 soap_putindependent(struct soap *soap)
 {
-	int i;
+	struct soap_pblk *pb = soap->pblk;
+	int i, n = soap->pidx;
 	struct soap_plist *pp;
 	if (soap->version == 1 && soap->encodingStyle && !(soap->mode & (SOAP_XML_TREE | SOAP_XML_GRAPH)))
-		for (i = 0; i < SOAP_PTRHASH; i++)
-			for (pp = soap->pht[i]; pp; pp = pp->next)
-				if (pp->mark1 == 2 || pp->mark2 == 2)
+		/* scan the plist blocks, which stay in place when soap_putelement() grows soap->pht */
+		for (; pb; pb = pb->next, n = SOAP_PTRBLK)
+			for (i = 0; i < n; i++)
+				if ((pp = &pb->plist[i])->mark1 == 2 || pp->mark2 == 2)
 					if (soap_putelement(soap, pp->ptr, SOAP_MULTIREFTAG, pp->id, pp->type))
 						return soap->error;
 	return SOAP_OK;
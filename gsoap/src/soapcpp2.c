@@ -59,13 +59,16 @@ int Cflag = 0;          /* when set, generate only files for clients */
 int aflag = 0;          /* when set, use value of SOAP Action to dispatch method at server side */
 int Aflag = 0;          /* when set, require SOAP Action to dispatch method at server side */
 int bflag = 0;          /* when set, serialize byte arrays char[N] as string */
+int Bflag = 0;          /* when set, generate CBOR serializers soap_out_cbor_X and soap_in_cbor_X */
 int eflag = 0;          /* when set, use SOAP RPC encoding by default */
 int Ecflag = 0;         /* when set, generate extra functions for data copying (soap_dup_X) */
 int Edflag = 0;         /* when set, generate extra functions for data deletion (soap_del_X) */
 int Etflag = 0;         /* when set, generate data traversal/walker functions */
+int Fflag = 0;          /* when set, generate streaming (de)serializers of repetitions for the fitemin and fitemout callbacks and parallel (de)serializers of arrays for fparallel */
 unsigned long fflag = 0;/* multi-file split for each bundle of -fN defs */
 int gflag = 0;          /* when set, generate XML sample messages in template format for testmsgr */
 int iflag = 0;          /* when set, generate new style proxy/object classes inherited from soap struct */
+int Jflag = 0;          /* when set, generate JSON serializers soap_out_json_X and soap_in_json_X */
 int jflag = 0;          /* when set, generate new style proxy/object classes */
 int mflag = 0;          /* when set, generate code that requires array/binary classes to explicitly remove malloced array */
 int nflag = 0;          /* when set, names the namespaces global struct '%NAME%_namespaces */
@@ -182,9 +185,15 @@ main(int argc, char **argv)
             if (fflag < 10)
               fflag = 10;
             break;
+          case 'F':
+            Fflag = 1;
+            break;
           case 'g':
             gflag = 1;
             break;
+          case 'J':
+            Jflag = 1;
+            break;
           case 'a':
             aflag = 1;
             break;
@@ -195,15 +204,19 @@ main(int argc, char **argv)
           case 'b':
             bflag = 1;
             break;
+          case 'B':
+            Bflag = 1;
+            break;
           case '?':
           case 'h':
-            fprintf(stderr, "Usage: soapcpp2 [-0|-1|-2] [-C|-S|-CS] [-A] [-a] [-b] [-c|-c++|-c++11|-c++14|-c++17] [-d path] [-Ec] [-Ed] [-Et] [-e] [-f N] [-g] [-h] [-i] [-I path" SOAP_PATHSEP "path" SOAP_PATHSEP "...] [-L] [-l] [-m] [-n] [-p name] [-Q name] [-q name] [-r] [-s] [-T] [-t] [-u] [-V] [-v] [-w] [-x] [-y] [-z#] [infile]\n\n");
+            fprintf(stderr, "Usage: soapcpp2 [-0|-1|-2] [-C|-S|-CS] [-A] [-a] [-B] [-b] [-c|-c++|-c++11|-c++14|-c++17] [-d path] [-Ec] [-Ed] [-Et] [-e] [-F] [-f N] [-g] [-h] [-i] [-I path" SOAP_PATHSEP "path" SOAP_PATHSEP "...] [-J] [-L] [-l] [-m] [-n] [-p name] [-Q name] [-q name] [-r] [-s] [-T] [-t] [-u] [-V] [-v] [-w] [-x] [-y] [-z#] [infile]\n\n");
             fprintf(stderr, "\
 -0      no SOAP, generate REST source code\n\
 -1      generate SOAP 1.1 source code\n\
 -2      generate SOAP 1.2 source code\n\
 -A      require HTTP SOAPAction headers to invoke server-side operations\n\
 -a      use HTTP SOAPAction with WS-Addressing to invoke server-side operations\n\
+-B      generate CBOR serializers soap_out_cbor_X and soap_in_cbor_X\n\
 -b      serialize byte arrays char[N] as string\n\
 -C      generate client-side source code only\n\
 -c      generate C source code\n\
@@ -216,11 +229,13 @@ main(int argc, char **argv)
 -Ed     generate extra functions for deep deletion\n\
 -Et     generate extra functions for data traversals with callback functions\n\
 -e      generate SOAP RPC encoding style bindings (also use -1 or -2)\n\
+-F      generate streaming and parallel (de)serializers of repetitions\n\
 -fN     multiple soapC files, with N serializer definitions per file (N>=10)\n\
 -g      generate XML sample messages in template format for testmsgr\n\
 -h      display help info and exit\n\
 -Ipath  use path(s) for #import (paths separated with '" SOAP_PATHSEP "')\n\
 -i      generate C++ service proxies and objects inherited from soap struct\n\
+-J      generate JSON serializers soap_out_json_X and soap_in_json_X\n\
 -j      generate C++ service proxies and objects that share a soap struct\n\
 -L      don't generate soapClientLib/soapServerLib\n\
 -l      generate linkable modules (experimental)\n\
@@ -264,6 +264,11 @@ typedef struct Tnode
   struct Tnode    *base;
   Visited         visited;
   Bool            recursive;      /* recursive data type */
+  int             aliasfree;      /* 1 if soap_serialize has nothing to mark, -1 if it has, 0 if not yet determined */
+  int             soapfree;       /* 1 if the data has no struct soap* members, -1 if it has, 0 if not yet determined, 2 while exploring */
+  Bool            itemin;         /* -F: soap_in_item function was generated to deserialize items in parallel */
+  Bool            itemout;        /* -F: soap_out_item function was generated to serialize items in parallel */
+  Bool            lazy;           /* soap_lazy function was generated to deserialize a lazy member */
   Bool            generated;
   Bool            wsdl;
   int             num;
@@ -459,6 +464,7 @@ extern const char *copt;
 extern int aflag;
 extern int Aflag;
 extern int bflag;
+extern int Bflag;
 extern int cflag;
 extern int c11flag;
 extern int Cflag;
@@ -466,9 +472,11 @@ extern int eflag;
 extern int Ecflag;
 extern int Edflag;
 extern int Etflag;
+extern int Fflag;
 extern unsigned long fflag;
 extern int gflag;
 extern int iflag;
+extern int Jflag;
 extern int jflag;
 extern int mflag;
 extern int nflag;
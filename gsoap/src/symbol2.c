@@ -81,6 +81,10 @@ static int is_anytype_flag = 0; /* anytype is used */
 static int is_anyType_flag = 0; /* anyType XML DOM is used */
 static int has_nsmap = 0;
 
+static const char **dispatch_name = NULL; /* local names of the element members dispatched by soap_in_T */
+static int dispatch_size = 0; /* number of names in dispatch_name, zero when soap_in_T tests all members */
+static const char *dispatch_id = NULL; /* c_ident of T */
+
 static char soapStub[1024];
 static char soapH[1024];
 static char soapC[1024];
@@ -207,6 +211,12 @@ const char *ns_cname(const char*, const char*);
 const char *ns_fname(const char*);
 
 int has_class(Tnode*);
+int is_alias_free(Tnode*);
+int has_soapref_data(Tnode*);
+int is_soapref_free(Tnode*);
+int is_parallel_item(Tnode*);
+int is_parallel_repetition(Entry*);
+int is_parallel_container(Tnode*);
 const char *union_member(Tnode*);
 int has_union(Tnode*);
 void gen_constructor(FILE *fd, Tnode*);
@@ -294,7 +304,40 @@ void soap_out(Tnode*);
 void soap_out_Darray(Tnode *);
 void soap_get(Tnode*);
 void soap_in(Tnode*);
+int is_tag_matched(Tnode*);
+const char *member_name(Entry*, Tnode*, const char*);
+void member_dispatch_add(const char*);
+void gen_member_dispatch(Tnode*, const char*);
+void member_dispatch_test(Entry*, Tnode*, const char*);
+void gen_item_release(Entry*, const char*, const char*, int);
+void gen_item_slices(Entry*, const char*, const char*, int);
+void gen_container_slices(Tnode*);
+int is_parallel_out_repetition(Entry*);
+int is_parallel_out_container(Tnode*);
+void gen_item_out(Tnode*);
+void gen_items_out(Tnode*);
+void gen_item_out_slices(Entry*, const char*, const char*);
+void gen_container_out_slices(Tnode*, Tnode*);
+void gen_item_release_container(Tnode*, const char*, const char*);
+void gen_item_producer(Tnode*, const char*, const char*);
+void gen_item_in(Tnode*);
+void gen_items_in(Tnode*);
+int is_lazy(Entry*);
+void gen_lazy(Tnode*);
+void gen_lazy_members(Tnode*);
 void soap_in_Darray(Tnode *);
+int is_json(Tnode*);
+int is_json_member(Entry*);
+const char *json_key(Entry*);
+const char *json_member(Tnode*, Table*, Entry*);
+void json_array_out(Tnode*, const char*, const char*, const char*);
+void json_array_in(Tnode*, const char*, const char*, const char*);
+void soap_out_json(Tnode*);
+void soap_in_json(Tnode*);
+void cbor_array_out(Tnode*, const char*, const char*, const char*);
+void cbor_array_in(Tnode*, const char*, const char*, const char*);
+void soap_out_cbor(Tnode*);
+void soap_in_cbor(Tnode*);
 void soap_instantiate(Tnode *);
 void soap_dup(Tnode *);
 void soap_del(Tnode *);
@@ -377,7 +420,94 @@ int
 mapcomp(const void *a, const void *b)
 {
   const struct pair *p = a, *q = b;
-  return strcmp(p->action, q->action);
+  const char *s = p->action, *t = q->action;
+  /* compare actions by their string value, since some are quoted */
+  if (*s == '"')
+    s++;
+  if (*t == '"')
+    t++;
+  for (;;)
+  {
+    int c = (unsigned char)*s, d = (unsigned char)*t;
+    if (c == '"' && !s[1])
+      c = 0;
+    if (d == '"' && !t[1])
+      d = 0;
+    if (c != d || !c)
+      return c - d;
+    s++;
+    t++;
+  }
+}
+
+struct optag
+{
+  const char *tag;  /* qualified tag of the request element */
+  const char *name; /* local part of the tag */
+  Entry *method;
+  int num;          /* declaration order */
+};
+
+int
+optagcomp(const void *a, const void *b)
+{
+  const struct optag *p = a, *q = b;
+  int r = strcmp(p->name, q->name);
+  if (r)
+    return r;
+  return p->num - q->num;
+}
+
+void
+optag_add(struct optag *map, int *num, const char *tag, Entry *method)
+{
+  const char *s = strchr(tag, ':');
+  map[*num].tag = tag;
+  map[*num].name = s ? s + 1 : tag;
+  map[*num].method = method;
+  map[*num].num = *num;
+  ++*num;
+}
+
+void
+gen_serve_tags(FILE *fd, struct optag *map, int num, const char *soap, const char *serve, const char *args)
+{
+  struct optag *sorted;
+  int i, j, k, search;
+  for (i = 0; i < num; i++)
+    if (!*map[i].name || strchr(map[i].name, '*'))
+      break;
+  search = (num > 4 && i == num); /* binary search worthwhile when num > 4 */
+  if (search)
+  {
+    sorted = (struct optag*)emalloc(num * sizeof(struct optag));
+    memcpy(sorted, map, num * sizeof(struct optag));
+    qsort(sorted, num, sizeof(struct optag), optagcomp);
+    fprintf(fd, "\n#ifndef WITH_CASEINSENSITIVETAGS\n\t{\tstatic const char *soap_tag[] = { ");
+    for (i = 0, k = 0; i < num; i++)
+    {
+      if (i == 0 || strcmp(sorted[i].name, sorted[i - 1].name))
+      {
+        fprintf(fd, "\"%s\", ", sorted[i].name);
+        k++;
+      }
+    }
+    fprintf(fd, " };");
+    fprintf(fd, "\n\t\tconst char *s = strchr(%s->tag, ':');", soap);
+    fprintf(fd, "\n\t\tswitch (soap_binary_search_string(soap_tag, %d, s ? s + 1 : %s->tag))\n\t\t{", k, soap);
+    for (i = 0, k = 0; i < num; i = j, k++)
+    {
+      fprintf(fd, "\n\t\t\tcase %d:", k);
+      for (j = i; j < num && !strcmp(sorted[j].name, sorted[i].name); j++)
+        fprintf(fd, "\n\t\t\t\tif (!soap_match_tag(%s, %s->tag, \"%s\"))\n\t\t\t\t\treturn %s%s(%s);", soap, soap, sorted[j].tag, serve, ident(sorted[j].method->sym->name), args);
+      fprintf(fd, "\n\t\t\t\tbreak;");
+    }
+    fprintf(fd, "\n\t\t}\n\t}\n#else");
+  }
+  for (i = 0; i < num; i++)
+    fprintf(fd, "\n\tif (!soap_match_tag(%s, %s->tag, \"%s\"))\n\t\treturn %s%s(%s);", soap, soap, map[i].tag, serve, ident(map[i].method->sym->name), args);
+  if (search)
+    fprintf(fd, "\n#endif");
 }
 
 /*
@@ -707,6 +837,11 @@ mktype(Type type, void *ref, int width)
   p->width = width;
   p->visited = Unexplored;
   p->recursive = False;
+  p->aliasfree = 0;
+  p->soapfree = 0;
+  p->itemin = False;
+  p->lazy = False;
+  p->itemout = False;
   p->generated = False;
   p->wsdl = False;
   p->next = Tptr[type];
@@ -755,6 +890,11 @@ mksymtype(Tnode *typ, Symbol *sym)
   p->width = typ->width;
   p->visited = Unexplored;
   p->recursive = False;
+  p->aliasfree = 0;
+  p->soapfree = 0;
+  p->itemin = False;
+  p->lazy = False;
+  p->itemout = False;
   p->generated = False;
   p->wsdl = False;
   p->next = Tptr[typ->type];
@@ -798,6 +938,11 @@ mktemplate(Tnode *typ, Symbol *id)
   p->extsym = NULL;
   p->response = (Entry*)0;
   p->width = 0;
+  p->aliasfree = 0;
+  p->soapfree = 0;
+  p->itemin = False;
+  p->lazy = False;
+  p->itemout = False;
   p->generated = False;
   p->wsdl = False;
   p->next = Tptr[Ttemplate];
@@ -1273,11 +1418,12 @@ compile(Table *table)
         fprintf(fout, "\n}");
 
         fprintf(fout, "\n\n#ifndef WITH_NOIDREF");
-        fprintf(fout, "\nSOAP_FMAC3 int SOAP_FMAC4 soap_putindependent(struct soap *soap)\n{\n\tint i;\n\tstruct soap_plist *pp;");
+        fprintf(fout, "\nSOAP_FMAC3 int SOAP_FMAC4 soap_putindependent(struct soap *soap)\n{\n\tstruct soap_pblk *pb = soap->pblk;\n\tint i, n = soap->pidx;\n\tstruct soap_plist *pp;");
         fprintf(fout, "\n\tif (soap->version == 1 && soap->encodingStyle && !(soap->mode & (SOAP_XML_TREE | SOAP_XML_GRAPH)))");
-        fprintf(fout, "\n\t\tfor (i = 0; i < SOAP_PTRHASH; i++)");
-        fprintf(fout, "\n\t\t\tfor (pp = soap->pht[i]; pp; pp = pp->next)");
-        fprintf(fout, "\n\t\t\t\tif (pp->mark1 == 2 || pp->mark2 == 2)");
+        fprintf(fout, "\n\t\t/* scan the plist blocks, which stay in place when soap_putelement() grows soap->pht */");
+        fprintf(fout, "\n\t\tfor (; pb; pb = pb->next, n = SOAP_PTRBLK)");
+        fprintf(fout, "\n\t\t\tfor (i = 0; i < n; i++)");
+        fprintf(fout, "\n\t\t\t\tif ((pp = &pb->plist[i])->mark1 == 2 || pp->mark2 == 2)");
         fprintf(fout, "\n\t\t\t\t\tif (soap_putelement(soap, pp->ptr, SOAP_MULTIREFTAG, pp->id, pp->type))\n\t\t\t\t\t\treturn soap->error;");
         fprintf(fout, "\n\treturn SOAP_OK;\n}\n#endif");
 
@@ -7298,8 +7444,16 @@ gen_object_code(FILE *fd, Table *table, Symbol *ns, const char *name)
   }
   if (!Aflag)
   {
+    int num = 0;
+    struct optag *map;
+    const char *args = "this";
     fprintf(fd, "\n\t(void)soap_peek_element(%s);", soap);
     catch_method = NULL;
+    for (method = table->list; method; method = method->next)
+      if (method->info.typ->type == Tfun && !(method->info.sto & Sextern) && has_ns_eq(ns->name, method->sym->name))
+        ++num;
+    map = (struct optag*)emalloc((num + 1) * sizeof(struct optag));
+    num = 0;
     for (method = table->list; method; method = method->next)
     {
       if (method->info.typ->type == Tfun && !(method->info.sto & Sextern) && has_ns_eq(ns->name, method->sym->name))
@@ -7310,28 +7464,24 @@ gen_object_code(FILE *fd, Table *table, Symbol *ns, const char *name)
           if (param)
             param = ((Table*)param->info.typ->ref)->list;
           if (param)
-          {
-            fprintf(fd, "\n\tif (!soap_match_tag(%s, %s->tag, \"%s\")", soap, soap, ns_convert(param->sym->name));
-            if (iflag)
-              fprintf(fd, ")\n\t\treturn serve_%s(this);", ident(method->sym->name));
-            else
-              fprintf(fd, ")\n\t\treturn serve_%s(%s, this);", ident(method->sym->name), soap);
-          }
+            optag_add(map, &num, ns_convert(param->sym->name), method);
           else
-          {
             catch_method = method;
-          }
         }
         else
         {
-          fprintf(fd, "\n\tif (!soap_match_tag(%s, %s->tag, \"%s\")", soap, soap, ns_convert(method->sym->name));
-          if (iflag)
-            fprintf(fd, ")\n\t\treturn serve_%s(this);", ident(method->sym->name));
-          else
-            fprintf(fd, ")\n\t\treturn serve_%s(%s, this);", ident(method->sym->name), soap);
+          optag_add(map, &num, ns_convert(method->sym->name), method);
         }
       }
     }
+    if (!iflag)
+    {
+      char *t = (char*)emalloc(strlen(soap) + 7);
+      strcpy(t, soap);
+      strcat(t, ", this");
+      args = t;
+    }
+    gen_serve_tags(fd, map, num, soap, "serve_", args);
     if (catch_method)
     {
       if (iflag)
@@ -10747,8 +10897,15 @@ soap_serve(Table *table)
     }
     if (!Aflag)
     {
+      int num = 0;
+      struct optag *map;
       fprintf(fserver, "\n\t(void)soap_peek_element(soap);");
       catch_method = NULL;
+      for (method = table->list; method; method = method->next)
+        if (method->info.typ->type == Tfun && !(method->info.sto & Sextern))
+          ++num;
+      map = (struct optag*)emalloc((num + 1) * sizeof(struct optag));
+      num = 0;
       for (method = table->list; method; method = method->next)
       {
         if (method->info.typ->type == Tfun && !(method->info.sto & Sextern))
@@ -10759,16 +10916,17 @@ soap_serve(Table *table)
             if (param)
               param = ((Table*)param->info.typ->ref)->list;
             if (param)
-              fprintf(fserver, "\n\tif (!soap_match_tag(soap, soap->tag, \"%s\"))\n\t\treturn soap_serve_%s(soap);", ns_convert(param->sym->name), ident(method->sym->name));
+              optag_add(map, &num, ns_convert(param->sym->name), method);
             else
               catch_method = method;
           }
           else
           {
-            fprintf(fserver, "\n\tif (!soap_match_tag(soap, soap->tag, \"%s\"))\n\t\treturn soap_serve_%s(soap);", ns_convert(method->sym->name), ident(method->sym->name));
+            optag_add(map, &num, ns_convert(method->sym->name), method);
           }
         }
       }
+      gen_serve_tags(fserver, map, num, "soap", "soap_serve_", "soap");
       if (catch_method)
         fprintf(fserver, "\n\treturn soap_serve_%s(soap);", ident(catch_method->sym->name));
       else
@@ -11606,6 +11764,128 @@ has_class(Tnode *typ)
   return 0;
 }
 
+/* returns 1 if the data of typ is tree-shaped and soap_serialize has nothing to mark for (multi)references, so calls to soap_serialize can be omitted */
+int
+is_alias_free(Tnode *typ)
+{
+  Table *t;
+  Entry *p;
+  Tnode *q;
+  if (is_primitive(typ) || is_stdstring(typ) || is_stdwstring(typ))
+    return 1;
+  if (typ->aliasfree)
+    return typ->aliasfree > 0;
+  typ->aliasfree = -1; /* assume not alias-free while exploring (cyclic) types */
+  if (is_external(typ))
+    return 0;
+  if (typ->type == Ttemplate)
+  {
+    q = (Tnode*)typ->ref;
+    if (is_smart(typ) || !q || q->type == Tfun)
+      return 0;
+    if (!is_XML(q) && !is_void(q) && !is_alias_free(q))
+      return 0;
+    typ->aliasfree = 1;
+    return 1;
+  }
+  if ((typ->type != Tstruct && typ->type != Tclass) || !typ->ref)
+    return 0;
+  for (q = typ; q->baseid; q = p->info.typ)
+  {
+    p = entry(classtable, q->baseid);
+    if (!p || is_external(p->info.typ))
+      return 0;
+  }
+  for (t = (Table*)typ->ref; t; t = t->prev)
+  {
+    for (p = t->list; p; p = p->next)
+    {
+      if (is_pointer_to_derived(p))
+        return 0;
+      if (p->info.typ->type == Tfun || p->info.typ->type == Tunion || is_soapref(p->info.typ))
+        continue;
+      if (p->info.sto & (Sconst | Sprivate | Sprotected | Sattribute))
+        continue;
+      if (is_repetition(p))
+      {
+        q = (Tnode*)p->next->info.typ->ref;
+        if (!is_XML(p->next->info.typ) && (has_ptr(q) || !is_alias_free(q)))
+          return 0;
+        p = p->next;
+      }
+      else if (is_anytype(p) || is_choice(p))
+      {
+        return 0;
+      }
+      else if (is_transient(p->info.typ))
+      {
+        continue;
+      }
+      else if (p->info.typ->type == Tarray)
+      {
+        return 0;
+      }
+      else if (!is_void(p->info.typ) && !is_XML(p->info.typ))
+      {
+        if (has_ptr(p->info.typ) || !is_alias_free(p->info.typ))
+          return 0;
+      }
+    }
+  }
+  typ->aliasfree = 1;
+  return 1;
+}
+
+/* returns 1 if the data of typ has a struct soap* member or a DOM node, which refer to the context that deserialized the data, explores the struct, class and union types of the data once */
+int
+has_soapref_data(Tnode *typ)
+{
+  Table *t;
+  Entry *p;
+  while (typ->ref && (typ->type == Tpointer || typ->type == Treference || typ->type == Trvalueref || typ->type == Tarray || typ->type == Ttemplate))
+    typ = (Tnode*)typ->ref;
+  if (typ->type != Tstruct && typ->type != Tclass && typ->type != Tunion)
+    return 0;
+  if (typ->soapfree)
+    return typ->soapfree < 0;
+  if (is_external(typ))
+    return typ->id && (!strcmp(typ->id->name, "soap_dom_element") || !strcmp(typ->id->name, "soap_dom_attribute"));
+  typ->soapfree = 2; /* exploring (cyclic) types */
+  if (is_anyType_base(typ))
+  {
+    typ->soapfree = -1;
+    return 1;
+  }
+  for (t = (Table*)typ->ref; t; t = t->prev)
+  {
+    for (p = t->list; p; p = p->next)
+    {
+      if (p->info.typ->type == Tfun)
+        continue;
+      if (is_soapref(p->info.typ) || has_soapref_data(p->info.typ))
+      {
+        typ->soapfree = -1;
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* returns 1 if the data of typ has no struct soap* members and DOM nodes, so that items of typ can be deserialized in parallel by context copies */
+int
+is_soapref_free(Tnode *typ)
+{
+  Tnode *p;
+  int i, r = !has_soapref_data(typ);
+  /* the types explored are free when typ is free, otherwise the search stopped early and some are not yet determined */
+  for (i = Tclass; i <= Tunion; i++)
+    for (p = Tptr[i]; p; p = p->next)
+      if (p->soapfree == 2)
+        p->soapfree = r;
+  return r;
+}
+
 int
 has_external(Tnode *typ)
 {
@@ -13429,6 +13709,10 @@ generate_type(Tnode *typ)
       soap_traverse(typ);
     soap_out(typ);
     soap_in(typ);
+    soap_out_json(typ);
+    soap_in_json(typ);
+    soap_out_cbor(typ);
+    soap_in_cbor(typ);
     if (!Qflag && is_external(typ) && namespaceid)
     {
       fprintf(fhead, "\n\nnamespace %s {", namespaceid);
@@ -13480,6 +13764,10 @@ generate_type(Tnode *typ)
         soap_traverse(typ);
       soap_out(typ);
       soap_in(typ);
+      soap_out_json(typ);
+      soap_in_json(typ);
+      soap_out_cbor(typ);
+      soap_in_cbor(typ);
       if (!Qflag && is_external(typ) && namespaceid)
       {
         fprintf(fhead, "\n\nnamespace %s {", namespaceid);
@@ -14188,12 +14476,134 @@ in_defs(void)
   }
 }
 
+struct typetag
+{
+  const char *tag;  /* qualified xsi:type or element name */
+  const char *name; /* local part of the tag */
+  Tnode *typ;
+  int num;          /* declaration order */
+};
+
+int
+typetagcomp(const void *a, const void *b)
+{
+  const struct typetag *p = a, *q = b;
+  int r = strcmp(p->name, q->name);
+  if (r)
+    return r;
+  return p->num - q->num;
+}
+
+void
+in_defs_test(const char *tab, const char *s, Tnode *p, const char *tag)
+{
+  if (is_dynamic_array(p) && !is_binary(p) && !has_ns(p) && !is_untyped(p))
+    fprintf(fout, "\n%sif (*soap->arrayType && !soap_match_array(soap, \"%s\"))\n%s{\t*type = %s;\n%s\treturn soap_in_%s(soap, %s, NULL, NULL);\n%s}", tab, s, tab, soap_type(p), tab, c_ident(p), tag, tab);
+  else if (is_string(p))
+    fprintf(fout, "\n%sif (!soap_match_tag(soap, t, \"%s\"))\n%s{\tchar **s;\n%s\t*type = %s;\n%s\ts = soap_in_%s(soap, %s, NULL, NULL);\n%s\treturn s ? *s : NULL;\n%s}", tab, s, tab, tab, soap_type(p), tab, c_ident(p), tag, tab, tab);
+  else if (is_wstring(p))
+    fprintf(fout, "\n%sif (!soap_match_tag(soap, t, \"%s\"))\n%s{\twchar_t **s;\n%s\t*type = %s;\n%s\ts = soap_in_%s(soap, %s, NULL, NULL);\n%s\treturn s ? *s : NULL;\n%s}", tab, s, tab, tab, soap_type(p), tab, c_ident(p), tag, tab, tab);
+  else
+    fprintf(fout, "\n%sif (!soap_match_tag(soap, t, \"%s\"))\n%s{\t*type = %s;\n%s\treturn soap_in_%s(soap, %s, NULL, NULL);\n%s}", tab, s, tab, soap_type(p), tab, c_ident(p), tag, tab);
+}
+
+void
+in_defs_tags(struct typetag *map, int num, const char *tag)
+{
+  struct typetag *sorted;
+  int i, j, k, n;
+  /* binary search on the local name of soap->type or soap->tag when no tag is a wildcard, unless there is a SOAP-encoded array type to match */
+  for (i = 0, n = 0; i < num; i++)
+  {
+    if (!map[i].name)
+      continue;
+    if (!*map[i].name || strchr(map[i].name, '*'))
+      break;
+    n++;
+  }
+  if (n <= 4 || i < num)
+  {
+    for (i = 0; i < num; i++)
+      in_defs_test("\t\t", map[i].tag, map[i].typ, tag);
+    return;
+  }
+  sorted = (struct typetag*)emalloc(n * sizeof(struct typetag));
+  for (i = 0, n = 0; i < num; i++)
+    if (map[i].name)
+      sorted[n++] = map[i];
+  qsort(sorted, n, sizeof(struct typetag), typetagcomp);
+  if (n < num)
+    fprintf(fout, "\n#ifndef WITH_CASEINSENSITIVETAGS\n\t\tif (!*soap->arrayType)\n\t\t{\tstatic const char *soap_tag[] = { ");
+  else
+    fprintf(fout, "\n#ifndef WITH_CASEINSENSITIVETAGS\n\t\t{\tstatic const char *soap_tag[] = { ");
+  for (i = 0, k = 0; i < n; i++)
+  {
+    if (i == 0 || strcmp(sorted[i].name, sorted[i - 1].name))
+    {
+      fprintf(fout, "\"%s\", ", sorted[i].name);
+      k++;
+    }
+  }
+  fprintf(fout, " };");
+  fprintf(fout, "\n\t\t\tconst char *q = strchr(t, ':');");
+  fprintf(fout, "\n\t\t\tswitch (soap_binary_search_string(soap_tag, %d, q ? q + 1 : t))\n\t\t\t{", k);
+  for (i = 0, k = 0; i < n; i = j, k++)
+  {
+    fprintf(fout, "\n\t\t\tcase %d:", k);
+    for (j = i; j < n && !strcmp(sorted[j].name, sorted[i].name); j++)
+      in_defs_test("\t\t\t\t", sorted[j].tag, sorted[j].typ, tag);
+    fprintf(fout, "\n\t\t\t\tbreak;");
+  }
+  if (n < num)
+  {
+    fprintf(fout, "\n\t\t\t}\n\t\t}\n\t\telse\n#endif\n\t\t{");
+    for (i = 0; i < num; i++)
+      in_defs_test("\t\t\t", map[i].tag, map[i].typ, tag);
+    fprintf(fout, "\n\t\t}");
+  }
+  else
+  {
+    fprintf(fout, "\n\t\t\t}\n\t\t}\n#else");
+    for (i = 0; i < num; i++)
+      in_defs_test("\t\t", map[i].tag, map[i].typ, tag);
+    fprintf(fout, "\n#endif");
+  }
+}
+
+void
+in_defs_add(struct typetag *map, int *num, Tnode *p)
+{
+  const char *s = xsi_type(p);
+  int array = is_dynamic_array(p) && !is_binary(p) && !has_ns(p) && !is_untyped(p);
+  if (!*s)
+    s = wsdl_type(p, "");
+  if (!*s || *s == '-')
+    return;
+  if (!array && p->type == Tpointer && !is_string(p) && !is_wstring(p))
+    return;
+  map[*num].tag = s;
+  map[*num].name = NULL; /* SOAP-encoded arrays are matched by soap->arrayType */
+  if (!array)
+  {
+    const char *t = strchr(s, ':');
+    map[*num].name = t ? t + 1 : s;
+  }
+  map[*num].typ = p;
+  map[*num].num = *num;
+  ++*num;
+}
+
 void
 in_defs2(void)
 {
-  int i, j;
+  int i, j, num = 0;
   Tnode *p;
-  const char *s;
+  struct typetag *map;
+  for (i = 0; i < TYPES; i++)
+    for (p = Tptr[i]; p; p = p->next)
+      num++;
+  map = (struct typetag*)emalloc((num + 1) * sizeof(struct typetag));
+  num = 0;
   for (i = 0; i < TYPES; i++)
   {
     /* make sure (wrapper) classes are checked first */
@@ -14206,59 +14616,32 @@ in_defs2(void)
     for (p = Tptr[j]; p; p = p->next)
     {
       if (!is_element(p) && !is_transient(p) && !is_template(p) && p->type != Twchar && p->type != Tfun && p->type != Treference && p->type != Trvalueref && p->type != Tunion && !is_XML(p) && !is_header_or_fault(p) && !is_body(p))
-      {
-        s = xsi_type(p);
-        if (!*s)
-          s = wsdl_type(p, "");
-        if (*s == '-')
-          continue;
-        if (*s)
-        {
-          if (is_dynamic_array(p) && !is_binary(p) && !has_ns(p) && !is_untyped(p))
-            fprintf(fout, "\n\t\tif (*soap->arrayType && !soap_match_array(soap, \"%s\"))\n\t\t{\t*type = %s;\n\t\t\treturn soap_in_%s(soap, tag, NULL, NULL);\n\t\t}", s, soap_type(p), c_ident(p));
-          else if (is_string(p))
-            fprintf(fout, "\n\t\tif (!soap_match_tag(soap, t, \"%s\"))\n\t\t{\tchar **s;\n\t\t\t*type = %s;\n\t\t\ts = soap_in_%s(soap, tag, NULL, NULL);\n\t\t\treturn s ? *s : NULL;\n\t\t}", s, soap_type(p), c_ident(p));
-          else if (is_wstring(p))
-            fprintf(fout, "\n\t\tif (!soap_match_tag(soap, t, \"%s\"))\n\t\t{\twchar_t **s;\n\t\t\t*type = %s;\n\t\t\ts = soap_in_%s(soap, tag, NULL, NULL);\n\t\t\treturn s ? *s : NULL;\n\t\t}", s, soap_type(p), c_ident(p));
-          else if (p->type != Tpointer)
-            fprintf(fout, "\n\t\tif (!soap_match_tag(soap, t, \"%s\"))\n\t\t{\t*type = %s;\n\t\t\treturn soap_in_%s(soap, tag, NULL, NULL);\n\t\t}", s, soap_type(p), c_ident(p));
-        }
-      }
+        in_defs_add(map, &num, p);
     }
   }
+  in_defs_tags(map, num, "tag");
 }
 
 void
 in_defs3(void)
 {
-  int i;
+  int i, num = 0;
   Tnode *p;
-  const char *s;
+  struct typetag *map;
+  for (i = 0; i < TYPES; i++)
+    for (p = Tptr[i]; p; p = p->next)
+      num++;
+  map = (struct typetag*)emalloc((num + 1) * sizeof(struct typetag));
+  num = 0;
   for (i = 0; i < TYPES; i++)
   {
     for (p = Tptr[i]; p; p = p->next)
     {
       if (is_element(p) && !is_transient(p) && !is_template(p) && p->type != Twchar && p->type != Tfun && p->type != Treference && p->type != Trvalueref && p->type != Tunion && !is_XML(p) && !is_header_or_fault(p) && !is_body(p))
-      {
-        s = xsi_type(p);
-        if (!*s)
-          s = wsdl_type(p, "");
-        if (*s == '-')
-          continue;
-        if (*s)
-        {
-          if (is_dynamic_array(p) && !is_binary(p) && !has_ns(p) && !is_untyped(p))
-            fprintf(fout, "\n\t\tif (*soap->arrayType && !soap_match_array(soap, \"%s\"))\n\t\t{\t*type = %s;\n\t\t\treturn soap_in_%s(soap, NULL, NULL, NULL);\n\t\t}", s, soap_type(p), c_ident(p));
-          else if (is_string(p))
-            fprintf(fout, "\n\t\tif (!soap_match_tag(soap, t, \"%s\"))\n\t\t{\tchar **s;\n\t\t\t*type = %s;\n\t\t\ts = soap_in_%s(soap, NULL, NULL, NULL);\n\t\t\treturn s ? *s : NULL;\n\t\t}", s, soap_type(p), c_ident(p));
-          else if (is_wstring(p))
-            fprintf(fout, "\n\t\tif (!soap_match_tag(soap, t, \"%s\"))\n\t\t{\twchar_t **s;\n\t\t\t*type = %s;\n\t\t\ts = soap_in_%s(soap, NULL, NULL, NULL);\n\t\t\treturn s ? *s : NULL;\n\t\t}", s, soap_type(p), c_ident(p));
-          else if (p->type != Tpointer)
-            fprintf(fout, "\n\t\tif (!soap_match_tag(soap, t, \"%s\"))\n\t\t{\t*type = %s;\n\t\t\treturn soap_in_%s(soap, NULL, NULL, NULL);\n\t\t}", s, soap_type(p), c_ident(p));
-        }
-      }
+        in_defs_add(map, &num, p);
     }
   }
+  in_defs_tags(map, num, "NULL");
 }
 
 void
@@ -15733,7 +16116,7 @@ soap_serialize(Tnode *typ)
             ;
           else if (is_repetition(p))
           {
-            if (!is_XML(p->next->info.typ))
+            if (!is_XML(p->next->info.typ) && (has_ptr((Tnode*)p->next->info.typ->ref) || !is_alias_free((Tnode*)p->next->info.typ->ref)))
             {
               fprintf(fout, "\n\tif (%s->%s::%s)", self, ident(table->sym->name), ident(p->next->sym->name));
               fprintf(fout, "\n\t{\tint i;\n\t\tfor (i = 0; i < (int)%s->%s::%s; i++)\n\t\t{", self, ident(table->sym->name), ident(p->sym->name));
@@ -15767,6 +16150,8 @@ soap_serialize(Tnode *typ)
             if (!is_pointer_to_derived(p))
               fprintf(fout, "\n\t/* transient %s skipped */", ident(p->sym->name));
           }
+          else if (!has_ptr(p->info.typ) && is_alias_free(p->info.typ))
+            ;
           else if (p->info.typ->type == Tarray)
           {
             if (has_ptr(p->info.typ))
@@ -15798,7 +16183,7 @@ soap_serialize(Tnode *typ)
               fprintf(fout, "\n\t/* %s skipped */", ident(p->sym->name));
           }
         }
-        if (table && table->prev)
+        if (table && table->prev && (!(p = entry(classtable, table->prev->sym)) || !is_alias_free(p->info.typ)))
           fprintf(fout, "\n\t%s->%s::soap_serialize(soap);", self, ident(table->prev->sym->name));
         fprintf(fout, "\n#endif\n}");
         break;
@@ -15842,7 +16227,7 @@ soap_serialize(Tnode *typ)
             ;
           else if (is_repetition(p))
           {
-            if (!is_XML(p->next->info.typ))
+            if (!is_XML(p->next->info.typ) && (has_ptr((Tnode*)p->next->info.typ->ref) || !is_alias_free((Tnode*)p->next->info.typ->ref)))
             {
               fprintf(fout, "\n\tif (a->%s)", ident(p->next->sym->name));
               fprintf(fout, "\n\t{\tint i;\n\t\tfor (i = 0; i < (int)a->%s; i++)\n\t\t{", ident(p->sym->name));
@@ -15876,6 +16261,8 @@ soap_serialize(Tnode *typ)
             if (!is_pointer_to_derived(p))
               fprintf(fout, "\n\t/* transient %s skipped */", ident(p->sym->name));
           }
+          else if (!has_ptr(p->info.typ) && is_alias_free(p->info.typ))
+            ;
           else if (p->info.typ->type == Tarray)
           {
             if (has_ptr(p->info.typ))
@@ -15942,6 +16329,8 @@ soap_serialize(Tnode *typ)
             if (!is_pointer_to_derived(p))
               fprintf(fout, "\n\t/* transient %s skipped */", ident(p->sym->name));
           }
+          else if (!has_ptr(p->info.typ) && is_alias_free(p->info.typ))
+            ;
           else if (p->info.typ->type == Tarray)
           {
             fprintf(fout, "\n\tcase %s:", soap_union_member(typ, p));
@@ -16090,7 +16479,7 @@ soap_serialize(Tnode *typ)
             }
           }
         }
-        else if (!is_primitive(temp))
+        else if (!is_alias_free(temp))
         {
           fprintf(fout, "\n\tfor (%s::const_iterator i = a->begin(); i != a->end(); ++i)", c_type(typ));
           if (temp->type == Tclass && !is_external(temp) && !is_volatile(temp) && !is_typedef(temp))
@@ -17730,22 +18119,245 @@ ptr_cast(Table *t, const char *name)
 }
 
 void
-soap_out(Tnode *typ)
+gen_item_producer(Tnode *typ, const char *tag, const char *type)
 {
-  Table *table, *t;
-  Entry *p = NULL;
-  int cardinality, i, j, d;
-  Tnode *temp;
-  const char *nse = ns_qualifiedElement(typ);
-  const char *nsa = ns_qualifiedAttribute(typ);
-  const char *x;
+  if (typ->type == Tarray || typ->type == Tfun || is_void(typ) || is_qname(typ) || is_stdqname(typ) || is_smart(typ))
+    return;
+  fprintf(fout, "\n\tif (soap->fitemout)\n\t{\t%s;\n\t\tstruct soap_imark soap_mark;\n\t\tsoap_begin_item(soap, &soap_mark);\n\t\tfor (;;)\n\t\t{\t", c_type_id(typ, "n"));
+  if (typ->type == Tpointer || is_XML(typ))
+    fprintf(fout, "n = NULL;");
+  else if (typ->type == Tclass && !is_external(typ) && !is_volatile(typ) && !is_typedef(typ))
+    fprintf(fout, "n.soap_default(soap);");
+  else
+    fprintf(fout, "soap_default_%s(soap, &n);", c_ident(typ));
+  fprintf(fout, "\n\t\t\tif (!soap_next_item(soap, %s, %s, (const void*)a, (void*)&n, &soap_mark))\n\t\t\t\tbreak;", tag, soap_type(typ));
+  if (typ->type == Tclass && !is_external(typ) && !is_volatile(typ) && !is_typedef(typ))
+    fprintf(fout, "\n\t\t\tif (n.soap_out(soap, %s, -1, \"%s\"))", tag, type);
+  else if (is_XML(typ) && is_string(typ))
+    fprintf(fout, "\n\t\t\tif (soap_outliteral(soap, %s, (char*const*)&n, NULL))", tag);
+  else if (is_XML(typ) && is_wstring(typ))
+    fprintf(fout, "\n\t\t\tif (soap_outwliteral(soap, %s, (wchar_t*const*)&n, NULL))", tag);
+  else if (is_string(typ))
+    fprintf(fout, "\n\t\t\tif (soap_out_%s(soap, %s, -1, (char*const*)&n, \"%s\"))", c_ident(typ), tag, type);
+  else if (is_wstring(typ))
+    fprintf(fout, "\n\t\t\tif (soap_out_%s(soap, %s, -1, (wchar_t*const*)&n, \"%s\"))", c_ident(typ), tag, type);
+  else
+    fprintf(fout, "\n\t\t\tif (soap_out_%s(soap, %s, -1, &n, \"%s\"))", c_ident(typ), tag, type);
+  fprintf(fout, "\n\t\t\t\treturn soap->error;\n\t\t}\n\t\tif (soap->error)\n\t\t\treturn soap->error;\n\t}");
+}
 
-  if (is_XML(typ))
+/* returns 1 if items of typ in an array or std::vector can be deserialized in parallel with soap_in_slices() by -F generated code */
+int
+is_parallel_item(Tnode *typ)
+{
+  if (typ->type == Tarray || typ->type == Tfun || is_void(typ) || is_XML(typ) || is_smart(typ) || is_transient(typ))
+    return 0;
+  return is_soapref_free(typ);
+}
+
+/* returns 1 if the items of repetition p, the size member followed by the pointer member, are deserialized in parallel by -F generated code */
+int
+is_parallel_repetition(Entry *p)
+{
+  Tnode *typ = (Tnode*)p->next->info.typ->ref;
+  if (!Fflag || is_unmatched(p->next->sym) || is_invisible(p->next->sym->name))
+    return 0;
+  /* items allocated with soap_block<T>::push are not contiguous */
+  if (typ->type == Tclass || typ->type == Ttemplate || has_class(typ) || (!cflag && typ->type == Tstruct))
+    return 0;
+  if (typ->type == Tpointer && (p->next->info.sto & Sconstptr))
+    return 0;
+  return is_parallel_item(typ);
+}
+
+/* returns 1 if the items of std::vector typ are deserialized in parallel by -F generated code */
+int
+is_parallel_container(Tnode *typ)
+{
+  Tnode *n = (Tnode*)typ->ref;
+  return Fflag && n && !strcmp(typ->id->name, "std::vector") && !is_bool(n) && is_parallel_item(n);
+}
+
+/* generate soap_in_item_X for soap_in_slices() to deserialize an item of type X */
+void
+gen_item_in(Tnode *typ)
+{
+  if (typ->itemin)
     return;
+  typ->itemin = True;
+  fprintf(fhead, "\nSOAP_FMAC3 void * SOAP_FMAC4 soap_in_item_%s(struct soap*, const char*, void*, const char*);", c_ident(typ));
+  fprintf(fout, "\n\nSOAP_FMAC3 void * SOAP_FMAC4 soap_in_item_%s(struct soap *soap, const char *tag, void *p, const char *type)\n{", c_ident(typ));
+  if (typ->type == Tpointer)
+    fprintf(fout, "\n\t*(%s)p = NULL;", c_type_id(typ, "*"));
+  else if (typ->type == Tclass && !is_external(typ) && !is_volatile(typ) && !is_typedef(typ))
+    fprintf(fout, "\n\t((%s)p)->soap_default(soap);", c_type_id(typ, "*"));
+  else
+    fprintf(fout, "\n\tsoap_default_%s(soap, (%s)p);", c_ident(typ), c_type_id(typ, "*"));
+  fprintf(fout, "\n\treturn (void*)soap_in_%s(soap, tag, (%s)p, type);\n}", c_ident(typ), c_type_id(typ, "*"));
+}
 
-  if (is_dynamic_array(typ))
-  {
-    soap_out_Darray(typ);
+/* generate soap_in_item_X for the repetitions of struct or class typ that are deserialized in parallel */
+void
+gen_items_in(Tnode *typ)
+{
+  Table *t;
+  Entry *p;
+  if (!Fflag)
+    return;
+  for (t = (Table*)typ->ref; t; t = t->prev)
+  {
+    for (p = t->list; p; p = p->next)
+    {
+      if (p->info.typ->type == Tfun || p->info.typ->type == Tunion || is_soapref(p->info.typ) || (p->info.sto & (Sconst | Sprivate | Sprotected | Sattribute)))
+        continue;
+      if (is_repetition(p))
+      {
+        if (is_parallel_repetition(p))
+          gen_item_in((Tnode*)p->next->info.typ->ref);
+        p = p->next;
+      }
+    }
+  }
+}
+
+/* returns 1 if member p is a pointer to a struct or class declared with $ that is deserialized lazily */
+int
+is_lazy(Entry *p)
+{
+  Tnode *typ = p->info.typ;
+  if (!(p->info.sto & Sspecial) || (p->info.sto & Sattribute) || typ->type != Tpointer)
+    return 0;
+  typ = (Tnode*)typ->ref;
+  return (typ->type == Tstruct || typ->type == Tclass) && !is_external(typ) && !is_volatile(typ) && !is_transient(typ) && !is_XML(typ);
+}
+
+/* generate soap_lazy_X to deserialize a lazy member of pointer type X on first access */
+void
+gen_lazy(Tnode *typ)
+{
+  if (typ->lazy)
+    return;
+  typ->lazy = True;
+  fprintf(fhead, "\nSOAP_FMAC3 %s SOAP_FMAC4 soap_lazy_%s(struct soap*, %s);", c_type(typ), c_ident(typ), c_type_id(typ, "*"));
+  fprintf(fout, "\n\nSOAP_FMAC3 %s SOAP_FMAC4 soap_lazy_%s(struct soap *soap, %s)\n{", c_type(typ), c_ident(typ), c_type_id(typ, "*p"));
+  fprintf(fout, "\n\tif (!*p)\n\t{\tstruct soap *copy = soap_lazy_begin(soap, (const void*)p);\n\t\tif (copy)\n\t\t{\tif (!soap_in_%s(copy, NULL, p, NULL))\n\t\t\t\t*p = NULL;\n\t\t\tsoap_lazy_end(soap, copy, (const void*)p);\n\t\t}\n\t}\n\treturn *p;\n}", c_ident(typ));
+}
+
+/* generate soap_lazy_X for the lazy members of struct or class typ */
+void
+gen_lazy_members(Tnode *typ)
+{
+  Table *t;
+  Entry *p;
+  for (t = (Table*)typ->ref; t; t = t->prev)
+  {
+    for (p = t->list; p; p = p->next)
+    {
+      if (is_lazy(p))
+        gen_lazy(p->info.typ);
+    }
+  }
+}
+
+/* returns 1 if the items of repetition p are serialized in parallel by -F generated code */
+int
+is_parallel_out_repetition(Entry *p)
+{
+  Tnode *typ = (Tnode*)p->next->info.typ->ref;
+  return is_parallel_repetition(p) && !is_qname(typ);
+}
+
+/* returns 1 if the items of std::vector typ are serialized in parallel by -F generated code */
+int
+is_parallel_out_container(Tnode *typ)
+{
+  Tnode *n = (Tnode*)typ->ref;
+  return is_parallel_container(typ) && !is_qname(n) && !is_stdqname(n);
+}
+
+/* generate soap_out_item_X for soap_out_slices() to serialize an item of type X */
+void
+gen_item_out(Tnode *typ)
+{
+  if (typ->itemout)
+    return;
+  typ->itemout = True;
+  fprintf(fhead, "\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_item_%s(struct soap*, const char*, const void*, const char*);", c_ident(typ));
+  fprintf(fout, "\n\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_item_%s(struct soap *soap, const char *tag, const void *p, const char *type)\n{", c_ident(typ));
+  if (typ->type == Tclass && !is_external(typ) && !is_volatile(typ) && !is_typedef(typ))
+    fprintf(fout, "\n\treturn ((const %s)p)->soap_out(soap, tag, -1, type);\n}", c_type_id(typ, "*"));
+  else if (is_string(typ))
+    fprintf(fout, "\n\treturn soap_out_%s(soap, tag, -1, (char*const*)p, type);\n}", c_ident(typ));
+  else if (is_wstring(typ))
+    fprintf(fout, "\n\treturn soap_out_%s(soap, tag, -1, (wchar_t*const*)p, type);\n}", c_ident(typ));
+  else if (typ->type == Tpointer)
+    fprintf(fout, "\n\treturn soap_out_%s(soap, tag, -1, (%s)p, type);\n}", c_ident(typ), c_type_constptr_id(typ, "const*"));
+  else
+    fprintf(fout, "\n\treturn soap_out_%s(soap, tag, -1, (const %s)p, type);\n}", c_ident(typ), c_type_id(typ, "*"));
+}
+
+/* generate soap_out_item_X for the repetitions of struct or class typ that are serialized in parallel */
+void
+gen_items_out(Tnode *typ)
+{
+  Table *t;
+  Entry *p;
+  if (!Fflag)
+    return;
+  for (t = (Table*)typ->ref; t; t = t->prev)
+  {
+    for (p = t->list; p; p = p->next)
+    {
+      if (p->info.typ->type == Tfun || p->info.typ->type == Tunion || is_soapref(p->info.typ) || (p->info.sto & (Sconst | Sprivate | Sprotected | Sattribute)))
+        continue;
+      if (is_repetition(p))
+      {
+        if (is_parallel_out_repetition(p))
+          gen_item_out((Tnode*)p->next->info.typ->ref);
+        p = p->next;
+      }
+    }
+  }
+}
+
+/* generate the loop header of repetition p of a struct or class cls that serializes the items in parallel with soap_out_slices() */
+void
+gen_item_out_slices(Entry *p, const char *cls, const char *tag)
+{
+  Tnode *typ = (Tnode*)p->next->info.typ->ref;
+  const char *sep = cls ? "::" : "";
+  if (!cls)
+    cls = "";
+  fprintf(fout, "\n\t{\tint i = 0;\n\t\tif (soap->fparallel && a->%s%s%s > 1)", cls, sep, ident(p->sym->name));
+  fprintf(fout, "\n\t\t{\ti = (int)soap_out_slices(soap, %s, (const void*)a->%s%s%s, (size_t)a->%s%s%s, sizeof(%s), soap_out_item_%s, \"%s\");\n\t\t\tif (soap->error)\n\t\t\t\treturn soap->error;\n\t\t}", tag, cls, sep, ident(p->next->sym->name), cls, sep, ident(p->sym->name), c_type(typ), c_ident(typ), xsi_type_u(typ));
+  fprintf(fout, "\n\t\tfor (; i < (int)a->%s%s%s; i++)", cls, sep, ident(p->sym->name));
+}
+
+/* generate the code of the std::vector typ serializer that serializes the items of type n in parallel with soap_out_slices() */
+void
+gen_container_out_slices(Tnode *n, Tnode *typ)
+{
+  fprintf(fout, "\n\tsize_t soap_num = 0;\n\tif (soap->fparallel && id == -1 && a->size() > 1)");
+  fprintf(fout, "\n\t{\tsoap_num = soap_out_slices(soap, tag, (const void*)&(*a)[0], a->size(), sizeof(%s), soap_out_item_%s, \"%s\");\n\t\tif (soap->error)\n\t\t\treturn soap->error;\n\t}", c_type(n), c_ident(n), xsi_type_u(typ));
+}
+
+void
+soap_out(Tnode *typ)
+{
+  Table *table, *t;
+  Entry *p = NULL;
+  int cardinality, i, j, d;
+  Tnode *temp;
+  const char *nse = ns_qualifiedElement(typ);
+  const char *nsa = ns_qualifiedAttribute(typ);
+  const char *x;
+
+  if (is_XML(typ))
+    return;
+
+  if (is_dynamic_array(typ))
+  {
+    soap_out_Darray(typ);
     return;
   }
 
@@ -17910,6 +18522,7 @@ soap_out(Tnode *typ)
         return;
       }
       fprintf(fhead, "\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_%s(struct soap*, const char*, int, const %s, const char*);", c_ident(typ), c_type_id(typ, "*"));
+      gen_items_out(typ);
       fprintf(fout, "\n\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_%s(struct soap *soap, const char *tag, int id, const %s, const char *type)\n{", c_ident(typ), c_type_id(typ, "*a"));
       table = (Table*)typ->ref;
       for (t = table; t; t = t->prev)
@@ -18043,7 +18656,14 @@ soap_out(Tnode *typ)
             else if (is_repetition(p))
             {
               fprintf(fout, "\n\tif (a->%s)", ident(p->next->sym->name));
-              fprintf(fout, "\n\t{\tint i;\n\t\tfor (i = 0; i < (int)a->%s; i++)", ident(p->sym->name));
+              if (is_parallel_out_repetition(p))
+              {
+                char *tag = (char*)emalloc(strlen(ns_add(p->next, nse)) + 3);
+                sprintf(tag, "\"%s\"", ns_add(p->next, nse));
+                gen_item_out_slices(p, NULL, tag);
+              }
+              else
+                fprintf(fout, "\n\t{\tint i;\n\t\tfor (i = 0; i < (int)a->%s; i++)", ident(p->sym->name));
               if (((Tnode*)p->next->info.typ->ref)->type == Tclass && !is_external((Tnode*)p->next->info.typ->ref) && !is_volatile((Tnode*)p->next->info.typ->ref) && !is_typedef((Tnode*)p->next->info.typ->ref))
                 fprintf(fout, "\n\t\t\tif (a->%s[i].soap_out(soap, \"%s\", -1, \"%s\"))\n\t\t\t\treturn soap->error;", ident(p->next->sym->name), ns_add(p->next, nse), xsi_type_u((Tnode*)p->next->info.typ->ref));
               else if (is_qname((Tnode*)p->next->info.typ->ref))
@@ -18059,6 +18679,12 @@ soap_out(Tnode *typ)
               else
                 fprintf(fout, "\n\t\t\tif (soap_out_%s(soap, \"%s\", -1, a->%s + i, \"%s\"))\n\t\t\t\treturn soap->error;", c_ident((Tnode*)p->next->info.typ->ref), ns_add(p->next, nse), ident(p->next->sym->name), xsi_type_u((Tnode*)p->next->info.typ->ref));
               fprintf(fout, "\n\t}");
+              if (Fflag)
+              {
+                char *tag = (char*)emalloc(strlen(ns_add(p->next, nse)) + 3);
+                sprintf(tag, "\"%s\"", ns_add(p->next, nse));
+                gen_item_producer((Tnode*)p->next->info.typ->ref, tag, xsi_type_u((Tnode*)p->next->info.typ->ref));
+              }
               p = p->next;
             }
             else if (is_anytype(p) && is_invisible(p->next->sym->name))
@@ -18081,6 +18707,8 @@ soap_out(Tnode *typ)
               if (!is_pointer_to_derived(p))
                 fprintf(fout, "\n\t/* transient %s skipped */", ident(p->sym->name));
             }
+            else if (is_lazy(p))
+              fprintf(fout, "\n\tif (!a->%s && soap_lazy_out(soap, (const void*)&a->%s))\n\t{\tif (soap->error)\n\t\t\treturn soap->error;\n\t}\n\telse if (soap_out_%s(soap, %s, -1, &a->%s, \"%s\"))\n\t\treturn soap->error;", ident(p->sym->name), ident(p->sym->name), c_ident(p->info.typ), field(p, nse), ident(p->sym->name), xsi_type_u(p->info.typ));
             else if (p->info.typ->type == Tarray)
               fprintf(fout, "\n\tif (soap_out_%s(soap, %s, -1, a->%s, \"%s\"))\n\t\treturn soap->error;", c_ident(p->info.typ), field(p, nse), ident(p->sym->name), xsi_type_u(p->info.typ));
             else if (p->info.typ->type == Tclass && !is_external(p->info.typ) && !is_volatile(p->info.typ) && !is_typedef(p->info.typ))
@@ -18146,6 +18774,7 @@ soap_out(Tnode *typ)
         fprintf(fout, "\n{\n\treturn soap_out_%s(soap, tag, id, this, type);\n}", c_ident(typ));
       }
       fprintf(fhead, "\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_%s(struct soap*, const char*, int, const %s, const char*);", c_ident(typ), c_type_id(typ, "*"));
+      gen_items_out(typ);
       fprintf(fout, "\n\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_%s(struct soap *soap, const char *tag, int id, const %s, const char *type)\n{", c_ident(typ), c_type_id(typ, "*a"));
       fflush(fout);
       if (has_setter(typ))
@@ -18314,7 +18943,19 @@ soap_out(Tnode *typ)
             else if (is_repetition(p))
             {
               fprintf(fout, "\n\tif (a->%s::%s)", ident(t->sym->name), ident(p->next->sym->name));
-              fprintf(fout, "\n\t{\tint i;\n\t\tfor (i = 0; i < (int)a->%s::%s; i++)", ident(t->sym->name), ident(p->sym->name));
+              if (is_parallel_out_repetition(p))
+              {
+                const char *tag = field_overridden(t, p->next, nse1);
+                if (is_string((Tnode*)p->next->info.typ->ref) || is_wstring((Tnode*)p->next->info.typ->ref))
+                {
+                  char *stag = (char*)emalloc(strlen(ns_add(p->next, nse)) + 3);
+                  sprintf(stag, "\"%s\"", ns_add(p->next, nse));
+                  tag = stag;
+                }
+                gen_item_out_slices(p, ident(t->sym->name), tag);
+              }
+              else
+                fprintf(fout, "\n\t{\tint i;\n\t\tfor (i = 0; i < (int)a->%s::%s; i++)", ident(t->sym->name), ident(p->sym->name));
               if (((Tnode*)p->next->info.typ->ref)->type == Tclass && !is_external((Tnode*)p->next->info.typ->ref) && !is_volatile((Tnode*)p->next->info.typ->ref) && !is_typedef((Tnode*)p->next->info.typ->ref))
                 fprintf(fout, "\n\t\t\tif (a->%s::%s[i].soap_out(soap, %s, -1, \"%s\"))\n\t\t\t\treturn soap->error;", ident(t->sym->name), ident(p->next->sym->name), field_overridden(t, p->next, nse1), xsi_type_u((Tnode*)p->next->info.typ->ref));
               else if (is_qname((Tnode*)p->next->info.typ->ref))
@@ -18330,6 +18971,8 @@ soap_out(Tnode *typ)
               else
                 fprintf(fout, "\n\t\t\tif (soap_out_%s(soap, %s, -1, a->%s::%s + i, \"%s\"))\n\t\t\t\treturn soap->error;", c_ident((Tnode*)p->next->info.typ->ref), field_overridden(t, p->next, nse1), ident(t->sym->name), ident(p->next->sym->name), xsi_type_u((Tnode*)p->next->info.typ->ref));
               fprintf(fout, "\n\t}");
+              if (Fflag)
+                gen_item_producer((Tnode*)p->next->info.typ->ref, field_overridden(t, p->next, nse1), xsi_type_u((Tnode*)p->next->info.typ->ref));
               p = p->next;
             }
             else if (is_anytype(p) && is_invisible(p->next->sym->name))
@@ -18355,6 +18998,8 @@ soap_out(Tnode *typ)
               if (!is_pointer_to_derived(p))
                 fprintf(fout, "\n\t/* transient %s skipped */", ident(p->sym->name));
             }
+            else if (is_lazy(p))
+              fprintf(fout, "\n\tif (!a->%s::%s && soap_lazy_out(soap, (const void*)&a->%s::%s))\n\t{\tif (soap->error)\n\t\t\treturn soap->error;\n\t}\n\telse if (soap_out_%s(soap, %s, -1, &a->%s::%s, \"%s\"))\n\t\treturn soap->error;", ident(t->sym->name), ident(p->sym->name), ident(t->sym->name), ident(p->sym->name), c_ident(p->info.typ), field_overridden(t, p, nse1), ident(t->sym->name), ident(p->sym->name), xsi_type_u(p->info.typ));
             else if (p->info.typ->type == Tarray)
               fprintf(fout, "\n\tif (soap_out_%s(soap, %s, -1, a->%s::%s, \"%s\"))\n\t\treturn soap->error;", c_ident(p->info.typ), field_overridden(t, p, nse1), ident(t->sym->name), ident(p->sym->name), xsi_type_u(p->info.typ));
             else if (p->info.typ->type == Tclass && !is_external(p->info.typ) && !is_volatile(p->info.typ) && !is_typedef(p->info.typ))
@@ -18424,6 +19069,8 @@ soap_out(Tnode *typ)
               ;
             else if (is_transient(p->info.typ))
               ;
+            else if (is_lazy(p))
+              fprintf(fout, "\n\tif (!a->%s::%s && soap_lazy_out(soap, (const void*)&a->%s::%s))\n\t{\tif (soap->error)\n\t\t\treturn soap->error;\n\t}\n\telse if (soap_out_%s(soap, %s, -1, &a->%s::%s, \"%s\"))\n\t\treturn soap->error;", ident(t->sym->name), ident(p->sym->name), ident(t->sym->name), ident(p->sym->name), c_ident(p->info.typ), field_overridden(t, p, nse1), ident(t->sym->name), ident(p->sym->name), xsi_type_u(p->info.typ));
             else if (p->info.typ->type == Tarray)
               fprintf(fout, "\n\tif (soap_out_%s(soap, %s, -1, a->%s::%s, \"%s\"))\n\t\treturn soap->error;", c_ident(p->info.typ), field_overridden(t, p, nse1), ident(t->sym->name), ident(p->sym->name), xsi_type_u(p->info.typ));
             else if (p->info.typ->type == Tclass && !is_external(p->info.typ) && !is_volatile(p->info.typ) && !is_typedef(p->info.typ))
@@ -18686,7 +19333,7 @@ soap_out(Tnode *typ)
       if (x && *x)
         fprintf(fout, "\n\tif (!type)\n\t\ttype = \"%s\";", x);
       fprintf(fout, "\n\tif (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, a, %s), type)", soap_type(typ));
-      fprintf(fout, " || soap_send(soap, soap_%s2s(soap, *a)))\n\t\treturn soap->error;", c_ident(typ));
+      fprintf(fout, " || soap_string_out(soap, soap_%s2s(soap, *a), 0))\n\t\treturn soap->error;", c_ident(typ));
       fprintf(fout, "\n\treturn soap_element_end_out(soap, tag);\n}");
       break;
     case Ttemplate:
@@ -18704,6 +19351,8 @@ soap_out(Tnode *typ)
       temp = (Tnode*)typ->ref;
       if (!temp)
         return;
+      if (is_parallel_out_container(typ))
+        gen_item_out(temp);
       fprintf(fout, "\n\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_%s(struct soap *soap, const char *tag, int id, const %s, const char *type)\n{", c_ident(typ), c_type_id(typ, "*a"));
       fprintf(fout, "\n\t(void)id; (void)type; /* appease -Wall -Werror */");
       if (is_smart_optional(typ))
@@ -18760,7 +19409,13 @@ soap_out(Tnode *typ)
       }
       else
       {
-        fprintf(fout, "\n\tfor (%s::const_iterator i = a->begin(); i != a->end(); ++i)\n\t{", c_type(typ));
+        if (is_parallel_out_container(typ))
+        {
+          gen_container_out_slices(temp, typ);
+          fprintf(fout, "\n\tfor (%s::const_iterator i = a->begin() + soap_num; i != a->end(); ++i)\n\t{", c_type(typ));
+        }
+        else
+          fprintf(fout, "\n\tfor (%s::const_iterator i = a->begin(); i != a->end(); ++i)\n\t{", c_type(typ));
         if (temp->type == Tarray)
           fprintf(fout, "\n\t\tif (soap_out_%s(soap, tag, id, *i, \"%s\"))", c_ident(temp), xsi_type_u(typ));
         else if (temp->type == Tclass && !is_external(temp) && !is_volatile(temp) && !is_typedef(temp))
@@ -18782,7 +19437,10 @@ soap_out(Tnode *typ)
         else
           fprintf(fout, "\n\t\tif (soap_out_%s(soap, tag, id, &(*i), \"%s\"))", c_ident(temp), xsi_type_u(typ));
         fprintf(fout, "\n\t\t\treturn soap->error;");
-        fprintf(fout, "\n\t}\n\treturn SOAP_OK;\n}");
+        fprintf(fout, "\n\t}");
+        if (Fflag)
+          gen_item_producer(temp, "tag", xsi_type_u(typ));
+        fprintf(fout, "\n\treturn SOAP_OK;\n}");
       }
       break;
     default:
@@ -19089,6 +19747,189 @@ soap_get(Tnode *typ)
   fflush(fout);
 }
 
+int
+is_tag_matched(Tnode *typ)
+{
+  if (is_XML(typ) || is_stdXML(typ) || is_external(typ))
+    return 0;
+  if (typ->type == Tpointer || typ->type == Treference || typ->type == Trvalueref || typ->type == Ttemplate || typ->type == Tarray)
+    return typ->ref && is_tag_matched((Tnode*)typ->ref);
+  if (typ->type == Tstruct || typ->type == Tclass)
+    return !is_invisible(typ->id->name) && !is_anyType_base(typ);
+  return 1;
+}
+
+const char *
+member_name(Entry *p, Tnode *typ, const char *tag)
+{
+  const char *s;
+  if (is_self(p) || *tag == '-' || !is_tag_matched(typ))
+    return NULL;
+  s = strchr(tag, ':');
+  if (s)
+    s++;
+  else
+    s = tag;
+  if (!*s || strchr(s, '*'))
+    return NULL;
+  return s;
+}
+
+void
+member_dispatch_add(const char *name)
+{
+  int k;
+  if (!name)
+    return;
+  for (k = 0; k < dispatch_size; k++)
+    if (!strcmp(dispatch_name[k], name))
+      return;
+  dispatch_name[dispatch_size++] = name;
+}
+
+void
+gen_member_dispatch(Tnode *typ, const char *nse)
+{
+  Table *table = (Table*)typ->ref, *t;
+  Entry *p;
+  size_t len, next;
+  int k, n = 0;
+  dispatch_size = 0;
+  dispatch_id = c_ident(typ);
+  if (!table || is_invisible(typ->id->name) || is_discriminant(typ) || is_primclass(typ))
+    return;
+  for (t = table; t; t = t->prev)
+    for (p = t->list; p; p = p->next)
+      n++;
+  dispatch_name = (const char**)emalloc((n + 1) * sizeof(const char*));
+  for (t = table; t; t = t->prev)
+  {
+    const char *nse1 = nse;
+    if (typ->type == Tclass)
+    {
+      Entry *e = entry(classtable, t->sym);
+      nse1 = e ? ns_qualifiedElement(e->info.typ) : nse;
+    }
+    for (p = t->list; p; p = p->next)
+    {
+      if (p->info.typ->type == Tfun || p->info.typ->type == Tunion || is_soapref(p->info.typ) || (typ->type == Tclass && is_item(p)))
+        continue;
+      if ((p->info.sto & (Sconst | Sprivate | Sprotected | Sattribute)))
+        continue;
+      if (is_repetition(p))
+      {
+        p = p->next;
+        if (!is_unmatched(p->sym) && !is_invisible(p->sym->name))
+          member_dispatch_add(member_name(p, (Tnode*)p->info.typ->ref, ns_add(p, nse1)));
+      }
+      else if (is_anytype(p) || is_choice(p))
+        p = p->next;
+      else if (!is_transient(p->info.typ) && !is_unmatched(p->sym) && !is_invisible(p->sym->name) && !is_void(p->info.typ))
+        member_dispatch_add(member_name(p, p->info.typ, typ->type == Tclass ? ns_add_overridden(t, p, nse1) : ns_add(p, nse1)));
+    }
+  }
+  /* a few string compares are cheaper than the dispatch */
+  if (dispatch_size < 4)
+  {
+    dispatch_size = 0;
+    return;
+  }
+  fprintf(fout, "\n\nstatic int soap_member_%s(struct soap *soap, int *member)\n{", dispatch_id);
+  fprintf(fout, "\n\tif (*member < 0)\n\t{\tconst char *s;\n\t\t*member = 0;\n\t\tif (soap_peek_element(soap))\n\t\t\treturn 0;\n\t\tsoap->error = SOAP_TAG_MISMATCH;\n\t\tif (soap->other)\n\t\t\treturn 0;\n\t\ts = strchr(soap->tag, ':');\n\t\ts = s ? s + 1 : soap->tag;\n\t\tswitch (strlen(s))\n\t\t{");
+  for (len = 1; len; len = next)
+  {
+    const char *sep = "";
+    next = 0;
+    for (k = 0; k < dispatch_size; k++)
+    {
+      size_t m = strlen(dispatch_name[k]);
+      if (m == len)
+      {
+        if (!*sep)
+          fprintf(fout, "\n\t\tcase %lu:", (unsigned long)len);
+        fprintf(fout, "\n\t\t\t%sif (!SOAP_STRCMP(s, \"%s\"))\n\t\t\t\t*member = %d;", sep, dispatch_name[k], k + 1);
+        sep = "else ";
+      }
+      else if (m > len && (!next || m < next))
+      {
+        next = m;
+      }
+    }
+    if (*sep)
+      fprintf(fout, "\n\t\t\tbreak;");
+  }
+  fprintf(fout, "\n\t\t}\n\t}\n\treturn *member;\n}");
+}
+
+void
+member_dispatch_test(Entry *p, Tnode *typ, const char *tag)
+{
+  const char *name = member_name(p, typ, tag);
+  int k;
+  if (!name)
+    return;
+  for (k = 0; k < dispatch_size; k++)
+  {
+    if (!strcmp(dispatch_name[k], name))
+    {
+      fprintf(fout, " && soap_member_%s(soap, &soap_member) == %d", dispatch_id, k + 1);
+      return;
+    }
+  }
+}
+
+void
+gen_item_release(Entry *p, const char *cls, const char *tag, int i)
+{
+  Tnode *typ = (Tnode*)p->next->info.typ->ref;
+  const char *sep = cls ? "::" : "";
+  if (!cls)
+    cls = "";
+  fprintf(fout, "\n\t\t\t\t{\tif (soap_end_item(soap, %s, %s, (void*)a->%s%s%s, &soap_mark_%s%.0d))\n\t\t\t\t\t{\tif (soap->error)\n\t\t\t\t\t\t\treturn NULL;", tag, soap_type(typ), cls, sep, ident(p->next->sym->name), ident(p->next->sym->name), i);
+  if (typ->type == Tclass && !is_external(typ) && !is_volatile(typ) && !is_typedef(typ))
+    fprintf(fout, "\n\t\t\t\t\t\ta->%s%s%s->soap_default(soap);", cls, sep, ident(p->next->sym->name));
+  else if (typ->type != Tpointer && !is_XML(typ))
+    fprintf(fout, "\n\t\t\t\t\t\tsoap_default_%s(soap, a->%s%s%s);", c_ident(typ), cls, sep, ident(p->next->sym->name));
+  else
+    fprintf(fout, "\n\t\t\t\t\t\t*a->%s%s%s = NULL;", cls, sep, ident(p->next->sym->name));
+  fprintf(fout, "\n\t\t\t\t\t\tcontinue;\n\t\t\t\t\t}\n\t\t\t\t\ta->%s%s%s++;\n\t\t\t\t\ta->%s%s%s = NULL;\n\t\t\t\t\tcontinue;\n\t\t\t\t}\n\t\t\t}", cls, sep, ident(p->sym->name), cls, sep, ident(p->next->sym->name));
+}
+
+void
+gen_item_slices(Entry *p, const char *cls, const char *tag, int i)
+{
+  Tnode *typ = (Tnode*)p->next->info.typ->ref;
+  const char *sep = cls ? "::" : "";
+  char *blist = (char*)emalloc(strlen(p->next->sym->name) + 32);
+  if (cls)
+    sprintf(blist, "soap_blist_%s%d", ident(p->next->sym->name), i);
+  else
+    sprintf(blist, "soap_blist_%s", ident(p->next->sym->name));
+  if (!cls)
+    cls = "";
+  fprintf(fout, "if (%s == NULL && soap->fparallel)\n\t\t\t\t{\tstruct soap_slices soap_slices;\n\t\t\t\t\tsize_t soap_num;\n\t\t\t\t\tsoap_revert(soap);\n\t\t\t\t\tsoap_num = soap_begin_slices(soap, &soap_slices, sizeof(%s));", blist, c_type(typ));
+  fprintf(fout, "\n\t\t\t\t\tif (soap_num)\n\t\t\t\t\t{\t%s = soap_alloc_block(soap);\n\t\t\t\t\t\ta->%s%s%s = (%s)soap_push_block(soap, %s, soap_num * sizeof(%s));\n\t\t\t\t\t\tif (a->%s%s%s == NULL)\n\t\t\t\t\t\t\treturn NULL;", blist, cls, sep, ident(p->next->sym->name), c_type(p->next->info.typ), blist, c_type(typ), cls, sep, ident(p->next->sym->name));
+  fprintf(fout, "\n\t\t\t\t\t\tif (soap_in_slices(soap, %s, &soap_slices, (void*)a->%s%s%s, soap_in_item_%s, \"%s\"))\n\t\t\t\t\t\t\treturn NULL;", tag, cls, sep, ident(p->next->sym->name), c_ident(typ), xsi_type(typ));
+  fprintf(fout, "\n\t\t\t\t\t\ta->%s%s%s = (%s)soap_num;\n\t\t\t\t\t\ta->%s%s%s = NULL;\n\t\t\t\t\t\tcontinue;\n\t\t\t\t\t}\n\t\t\t\t}\n\t\t\t\t", cls, sep, ident(p->sym->name), c_type(p->info.typ), cls, sep, ident(p->next->sym->name));
+}
+
+void
+gen_container_slices(Tnode *n)
+{
+  fprintf(fout, "\n\t\tif (!soap_flag && tag && *tag != '-' && soap->fparallel)\n\t\t{\tstruct soap_slices soap_slices;\n\t\t\tsize_t soap_num = soap_begin_slices(soap, &soap_slices, sizeof(%s));", c_type(n));
+  fprintf(fout, "\n\t\t\tif (soap_num)\n\t\t\t{\tsize_t soap_size = a->size();\n\t\t\t\ta->resize(soap_size + soap_num);");
+  fprintf(fout, "\n\t\t\t\tif (soap_in_slices(soap, tag, &soap_slices, (void*)&(*a)[soap_size], soap_in_item_%s, \"%s\"))\n\t\t\t\t\treturn NULL;\n\t\t\t\tcontinue;\n\t\t\t}\n\t\t}", c_ident(n), xsi_type(n));
+}
+
+void
+gen_item_release_container(Tnode *n, const char *item, const char *pop)
+{
+  fprintf(fout, "\n\t\t\tif (soap_end_item(soap, tag, %s, (void*)%s, &soap_mark))\n\t\t\t{\tif (soap->error)\n\t\t\t\t\treturn NULL;%s", soap_type(n), item, pop);
+  if (!is_primitive(n) && n->type != Tpointer)
+    fprintf(fout, "\n\t\t\t\tsoap_end_shaky(soap, soap_shaky);");
+  fprintf(fout, "\n\t\t\t\tif (!tag || *tag == '-')\n\t\t\t\t\treturn a;\n\t\t\t\tcontinue;\n\t\t\t}");
+}
+
 void
 soap_in(Tnode *typ)
 {
@@ -19377,6 +20218,9 @@ soap_in(Tnode *typ)
         return;
       }
       fprintf(fhead, "\nSOAP_FMAC3 %s SOAP_FMAC4 soap_in_%s(struct soap*, const char*, %s, const char*);", c_type_id(typ, "*"), c_ident(typ), c_type_id(typ, "*"));
+      gen_member_dispatch(typ, nse);
+      gen_items_in(typ);
+      gen_lazy_members(typ);
       fprintf(fout, "\n\nSOAP_FMAC3 %s SOAP_FMAC4 soap_in_%s(struct soap *soap, const char *tag, %s, const char *type)\n{", c_type_id(typ, "*"), c_ident(typ), c_type_id(typ, "*a"));
       table = (Table*)typ->ref;
       if (!table)
@@ -19471,6 +20315,8 @@ soap_in(Tnode *typ)
                 else if (is_repetition(p))
                 {
                   fprintf(fout, "\n\tstruct soap_blist *soap_blist_%s = NULL;", ident(p->next->sym->name));
+                  if (Fflag && !is_unmatched(p->next->sym) && !is_invisible(p->next->sym->name))
+                    fprintf(fout, "\n\tstruct soap_imark soap_mark_%s;", ident(p->next->sym->name));
                   p = p->next;
                 }
                 else if (!is_transient(p->info.typ) && !is_container(p->info.typ))
@@ -19479,6 +20325,8 @@ soap_in(Tnode *typ)
             }
           }
         }
+        if (dispatch_size)
+          fprintf(fout, "\n\tint soap_member;");
         if (!is_invisible(typ->id->name))
         {
           for (p = table->list; p; p = p->next)
@@ -19562,6 +20410,8 @@ soap_in(Tnode *typ)
           {
             fprintf(fout, "\n\tif (soap->body && *soap->href != '#')\n\t{");
             fprintf(fout, "\n\t\tfor (;;)\n\t\t{\tsoap->error = SOAP_TAG_MISMATCH;");
+            if (dispatch_size)
+              fprintf(fout, "\n\t\t\tsoap_member = -1;");
           }
           else
           {
@@ -19592,9 +20442,13 @@ soap_in(Tnode *typ)
                 continue;
               }
               flag = 1;
-              fprintf(fout, "\n\t\t\tif (soap->error == SOAP_TAG_MISMATCH && ");
-              fprintf(fout, "!soap_element_begin_in(soap, %s, 1, NULL))", field(p->next, nse));
-              fprintf(fout, "\n\t\t\t{\tif (a->%s == NULL)\n\t\t\t\t{\tif (soap_blist_%s == NULL)\n\t\t\t\t\t\tsoap_blist_%s = soap_alloc_block(soap);", ident(p->next->sym->name), ident(p->next->sym->name), ident(p->next->sym->name));
+              fprintf(fout, "\n\t\t\tif (soap->error == SOAP_TAG_MISMATCH");
+              member_dispatch_test(p->next, (Tnode*)p->next->info.typ->ref, ns_add(p->next, nse));
+              fprintf(fout, " && !soap_element_begin_in(soap, %s, 1, NULL))", field(p->next, nse));
+              fprintf(fout, "\n\t\t\t{\t");
+              if (is_parallel_repetition(p))
+                gen_item_slices(p, NULL, field(p->next, nse), 0);
+              fprintf(fout, "if (a->%s == NULL)\n\t\t\t\t{\tif (soap_blist_%s == NULL)\n\t\t\t\t\t\tsoap_blist_%s = soap_alloc_block(soap);", ident(p->next->sym->name), ident(p->next->sym->name), ident(p->next->sym->name));
               if (((Tnode*)p->next->info.typ->ref)->type == Tclass
                || ((Tnode*)p->next->info.typ->ref)->type == Ttemplate
                || has_class((Tnode*)p->next->info.typ->ref)
@@ -19612,6 +20466,8 @@ soap_in(Tnode *typ)
                 fprintf(fout, "\n\t\t\t\t\t*a->%s = NULL;", ident(p->next->sym->name));
               fprintf(fout, "\n\t\t\t\t}");
               fprintf(fout, "\n\t\t\t\tsoap_revert(soap);");
+              if (Fflag)
+                fprintf(fout, "\n\t\t\t\tsoap_begin_item(soap, &soap_mark_%s);", ident(p->next->sym->name));
               if (is_XML((Tnode*)p->next->info.typ->ref) && is_string((Tnode*)p->next->info.typ->ref))
                 fprintf(fout, "\n\t\t\t\tif (soap_inliteral(soap, %s, (char**)a->%s))", field(p->next, nse), ident(p->next->sym->name));
               else if (is_XML((Tnode*)p->next->info.typ->ref) && is_wstring((Tnode*)p->next->info.typ->ref))
@@ -19622,7 +20478,10 @@ soap_in(Tnode *typ)
                 fprintf(fout, "\n\t\t\t\tif (soap_in_%s(soap, %s, (wchar_t**)a->%s, \"%s\"))", c_ident((Tnode*)p->next->info.typ->ref), field(p->next, nse), ident(p->next->sym->name), xsi_type((Tnode*)p->next->info.typ->ref));
               else
                 fprintf(fout, "\n\t\t\t\tif (soap_in_%s(soap, %s, a->%s, \"%s\"))", c_ident((Tnode*)p->next->info.typ->ref), field(p->next, nse), ident(p->next->sym->name), xsi_type((Tnode*)p->next->info.typ->ref));
-              fprintf(fout, "\n\t\t\t\t{\ta->%s++;\n\t\t\t\t\ta->%s = NULL;\n\t\t\t\t\tcontinue;\n\t\t\t\t}\n\t\t\t}", ident(p->sym->name), ident(p->next->sym->name));
+              if (Fflag)
+                gen_item_release(p, NULL, field(p->next, nse), 0);
+              else
+                fprintf(fout, "\n\t\t\t\t{\ta->%s++;\n\t\t\t\t\ta->%s = NULL;\n\t\t\t\t\tcontinue;\n\t\t\t\t}\n\t\t\t}", ident(p->sym->name), ident(p->next->sym->name));
               p = p->next;
             }
             else if (is_anytype(p))
@@ -19668,12 +20527,14 @@ soap_in(Tnode *typ)
               if (!is_invisible(p->sym->name) && !is_primclass(typ) && p->info.typ->type != Tfun && !is_void(p->info.typ))
               {
                 if (is_string(p->info.typ) || is_wstring(p->info.typ) || is_stdstr(p->info.typ))
-                  fprintf(fout, "\n\t\t\tif (soap_flag_%s && (soap->error == SOAP_TAG_MISMATCH || soap->error == SOAP_NO_TAG))", ident(p->sym->name));
+                  fprintf(fout, "\n\t\t\tif (soap_flag_%s && (soap->error == SOAP_TAG_MISMATCH || soap->error == SOAP_NO_TAG)", ident(p->sym->name));
                 else if (is_container(p->info.typ))
-                  fprintf(fout, "\n\t\t\tif (soap->error == SOAP_TAG_MISMATCH)");
+                  fprintf(fout, "\n\t\t\tif (soap->error == SOAP_TAG_MISMATCH");
                 else
-                  fprintf(fout, "\n\t\t\tif (soap_flag_%s && soap->error == SOAP_TAG_MISMATCH)", ident(p->sym->name));
-                fprintf(fout, "\n\t\t\t{\t");
+                  fprintf(fout, "\n\t\t\tif (soap_flag_%s && soap->error == SOAP_TAG_MISMATCH", ident(p->sym->name));
+                if (!is_unmatched(p->sym))
+                  member_dispatch_test(p, p->info.typ, ns_add(p, nse));
+                fprintf(fout, ")\n\t\t\t{\t");
               }
               if (is_unmatched(p->sym))
               {
@@ -19708,7 +20569,11 @@ soap_in(Tnode *typ)
               }
               else if (!is_invisible(p->sym->name))
               {
-                if (is_XML(p->info.typ) && is_string(p->info.typ))
+                if (is_lazy(p))
+                {
+                  fprintf(fout, "if (soap_lazy_in(soap, %s, (const void*)&a->%s) || (!soap->error && soap_in_%s(soap, %s, &a->%s, \"%s\")))", field(p, nse), ident(p->sym->name), c_ident(p->info.typ), field(p, nse), ident(p->sym->name), xsi_type(p->info.typ));
+                }
+                else if (is_XML(p->info.typ) && is_string(p->info.typ))
                 {
                   fprintf(fout, "if (soap_inliteral(soap, %s, (char**)&a->%s))", field(p, nse), ident(p->sym->name));
                 }
@@ -20192,6 +21057,9 @@ soap_in(Tnode *typ)
         fprintf(fout, "\n{\n\treturn soap_in_%s(soap, tag, this, type);\n}", c_ident(typ));
         fflush(fout);
       }
+      gen_member_dispatch(typ, nse);
+      gen_items_in(typ);
+      gen_lazy_members(typ);
       fprintf(fout, "\n\nSOAP_FMAC3 %s SOAP_FMAC4 soap_in_%s(struct soap *soap, const char *tag, %s, const char *type)\n{", c_type_id(typ, "*"), c_ident(typ), c_type_id(typ, "*a"));
       table = (Table*)typ->ref;
       if (!table)
@@ -20386,6 +21254,8 @@ soap_in(Tnode *typ)
                 else if (is_repetition(p))
                 {
                   fprintf(fout, "\n\tstruct soap_blist *soap_blist_%s%d = NULL;", ident(p->next->sym->name), i);
+                  if (Fflag && !is_unmatched(p->next->sym) && !is_invisible(p->next->sym->name))
+                    fprintf(fout, "\n\tstruct soap_imark soap_mark_%s%d;", ident(p->next->sym->name), i);
                   p = p->next;
                 }
                 else if (!is_transient(p->info.typ) && !is_container(p->info.typ))
@@ -20394,6 +21264,8 @@ soap_in(Tnode *typ)
             }
           }
         }
+        if (dispatch_size)
+          fprintf(fout, "\n\tint soap_member;");
         fflush(fout);
         if (!is_invisible(typ->id->name))
         {
@@ -20401,6 +21273,8 @@ soap_in(Tnode *typ)
           {
             fprintf(fout, "\n\tif (soap->body && *soap->href != '#')\n\t{");
             fprintf(fout, "\n\t\tfor (;;)\n\t\t{\tsoap->error = SOAP_TAG_MISMATCH;");
+            if (dispatch_size)
+              fprintf(fout, "\n\t\t\tsoap_member = -1;");
           }
           else
             fprintf(fout, "\n\tif (!tag || *tag == '-' || (soap->body && *soap->href != '#'))\n\t{");
@@ -20442,9 +21316,13 @@ soap_in(Tnode *typ)
                 continue;
               }
               flag = 1;
-              fprintf(fout, "\n\t\t\tif (soap->error == SOAP_TAG_MISMATCH && ");
-              fprintf(fout, "!soap_element_begin_in(soap, %s, 1, NULL))", field(p->next, nse1));
-              fprintf(fout, "\n\t\t\t{\tif (a->%s::%s == NULL)\n\t\t\t\t{\tif (soap_blist_%s%d == NULL)\n\t\t\t\t\t\tsoap_blist_%s%d = soap_alloc_block(soap);", ident(t->sym->name), ident(p->next->sym->name), ident(p->next->sym->name), i, ident(p->next->sym->name), i);
+              fprintf(fout, "\n\t\t\tif (soap->error == SOAP_TAG_MISMATCH");
+              member_dispatch_test(p->next, (Tnode*)p->next->info.typ->ref, ns_add(p->next, nse1));
+              fprintf(fout, " && !soap_element_begin_in(soap, %s, 1, NULL))", field(p->next, nse1));
+              fprintf(fout, "\n\t\t\t{\t");
+              if (is_parallel_repetition(p))
+                gen_item_slices(p, ident(t->sym->name), field(p->next, nse1), i);
+              fprintf(fout, "if (a->%s::%s == NULL)\n\t\t\t\t{\tif (soap_blist_%s%d == NULL)\n\t\t\t\t\t\tsoap_blist_%s%d = soap_alloc_block(soap);", ident(t->sym->name), ident(p->next->sym->name), ident(p->next->sym->name), i, ident(p->next->sym->name), i);
               if (((Tnode*)p->next->info.typ->ref)->type == Tclass
                || ((Tnode*)p->next->info.typ->ref)->type == Ttemplate
                || has_class((Tnode*)p->next->info.typ->ref)
@@ -20462,6 +21340,8 @@ soap_in(Tnode *typ)
                 fprintf(fout, "\n\t\t\t\t\t*a->%s::%s = NULL;", ident(t->sym->name), ident(p->next->sym->name));
               fprintf(fout, "\n\t\t\t\t}");
               fprintf(fout, "\n\t\t\t\tsoap_revert(soap);");
+              if (Fflag)
+                fprintf(fout, "\n\t\t\t\tsoap_begin_item(soap, &soap_mark_%s%d);", ident(p->next->sym->name), i);
               if (is_XML((Tnode*)p->next->info.typ->ref) && is_string((Tnode*)p->next->info.typ->ref))
                 fprintf(fout, "\n\t\t\t\tif (soap_inliteral(soap, %s, (char**)a->%s::%s))", field(p->next, nse1), ident(t->sym->name), ident(p->next->sym->name));
               else if (is_XML((Tnode*)p->next->info.typ->ref) && is_wstring((Tnode*)p->next->info.typ->ref))
@@ -20472,7 +21352,10 @@ soap_in(Tnode *typ)
                 fprintf(fout, "\n\t\t\t\tif (soap_in_%s(soap, %s, (wchar_t**)a->%s::%s, \"%s\"))", c_ident((Tnode*)p->next->info.typ->ref), field(p->next, nse1), ident(t->sym->name), ident(p->next->sym->name), xsi_type((Tnode*)p->next->info.typ->ref));
               else
                 fprintf(fout, "\n\t\t\t\tif (soap_in_%s(soap, %s, a->%s::%s, \"%s\"))", c_ident((Tnode*)p->next->info.typ->ref), field(p->next, nse1), ident(t->sym->name), ident(p->next->sym->name), xsi_type((Tnode*)p->next->info.typ->ref));
-              fprintf(fout, "\n\t\t\t\t{\ta->%s::%s++;\n\t\t\t\t\ta->%s::%s = NULL;\n\t\t\t\t\tcontinue;\n\t\t\t\t}\n\t\t\t}", ident(t->sym->name), ident(p->sym->name), ident(t->sym->name), ident(p->next->sym->name));
+              if (Fflag)
+                gen_item_release(p, ident(t->sym->name), field(p->next, nse1), i);
+              else
+                fprintf(fout, "\n\t\t\t\t{\ta->%s::%s++;\n\t\t\t\t\ta->%s::%s = NULL;\n\t\t\t\t\tcontinue;\n\t\t\t\t}\n\t\t\t}", ident(t->sym->name), ident(p->sym->name), ident(t->sym->name), ident(p->next->sym->name));
               p = p->next;
             }
             else if (is_anytype(p))
@@ -20519,12 +21402,14 @@ soap_in(Tnode *typ)
               if (!is_invisible(p->sym->name) && !is_primclass(typ) && p->info.typ->type != Tfun && !is_void(p->info.typ))
               {
                 if (is_string(p->info.typ) || is_wstring(p->info.typ) || is_stdstr(p->info.typ))
-                  fprintf(fout, "\n\t\t\tif (soap_flag_%s%d && (soap->error == SOAP_TAG_MISMATCH || soap->error == SOAP_NO_TAG))", ident(p->sym->name), i);
+                  fprintf(fout, "\n\t\t\tif (soap_flag_%s%d && (soap->error == SOAP_TAG_MISMATCH || soap->error == SOAP_NO_TAG)", ident(p->sym->name), i);
                 else if (is_container(p->info.typ))
-                  fprintf(fout, "\n\t\t\tif (soap->error == SOAP_TAG_MISMATCH)");
+                  fprintf(fout, "\n\t\t\tif (soap->error == SOAP_TAG_MISMATCH");
                 else
-                  fprintf(fout, "\n\t\t\tif (soap_flag_%s%d && soap->error == SOAP_TAG_MISMATCH)", ident(p->sym->name), i);
-                fprintf(fout, "\n\t\t\t{\t");
+                  fprintf(fout, "\n\t\t\tif (soap_flag_%s%d && soap->error == SOAP_TAG_MISMATCH", ident(p->sym->name), i);
+                if (!is_unmatched(p->sym))
+                  member_dispatch_test(p, p->info.typ, ns_add_overridden(t, p, nse1));
+                fprintf(fout, ")\n\t\t\t{\t");
               }
               if (is_unmatched(p->sym))
               {
@@ -20559,7 +21444,11 @@ soap_in(Tnode *typ)
               }
               else if (!is_invisible(p->sym->name))
               {
-                if (is_XML(p->info.typ) && is_string(p->info.typ))
+                if (is_lazy(p))
+                {
+                  fprintf(fout, "if (soap_lazy_in(soap, %s, (const void*)&a->%s::%s) || (!soap->error && soap_in_%s(soap, %s, &a->%s::%s, \"%s\")))", field_overridden(t, p, nse1), ident(t->sym->name), ident(p->sym->name), c_ident(p->info.typ), field_overridden(t, p, nse1), ident(t->sym->name), ident(p->sym->name), xsi_type(p->info.typ));
+                }
+                else if (is_XML(p->info.typ) && is_string(p->info.typ))
                 {
                   fprintf(fout, "if (soap_inliteral(soap, %s, (char**)&a->%s::%s))", field_overridden(t, p, nse1), ident(t->sym->name), ident(p->sym->name));
                 }
@@ -21329,6 +22218,8 @@ soap_in(Tnode *typ)
       n = (Tnode*)typ->ref;
       if (n->type == Tfun || is_void(n))
         return;
+      if (is_parallel_container(typ))
+        gen_item_in(n);
       fprintf(fhead, "\nSOAP_FMAC3 %s SOAP_FMAC4 soap_in_%s(struct soap*, const char*, %s, const char*);", c_type_id(typ, "*"), c_ident(typ), c_type_id(typ, "*"));
       fprintf(fout, "\n\nSOAP_FMAC3 %s SOAP_FMAC4 soap_in_%s(struct soap *soap, const char *tag, %s, const char *type)\n{", c_type_id(typ, "*"), c_ident(typ), c_type_id(typ, "*a"));
       fprintf(fout, "\n\t(void)type; /* appease -Wall -Werror */");
@@ -21406,6 +22297,8 @@ soap_in(Tnode *typ)
         fprintf(fout, "\n\tfor (soap_flag = 0;; soap_flag = 1)\n\t{");
         fprintf(fout, "\n\t\tif (tag && *tag != '-')\n\t\t{\tif (soap_element_begin_in(soap, tag, 1, NULL))\n\t\t\t\tbreak;\n\t\t\tsoap_revert(soap);\n\t\t}");
         fprintf(fout, "\n\t\tif (!a && !(a = soap_new_%s(soap)))\n\t\t\treturn NULL;", c_ident(typ));
+        if (is_parallel_container(typ))
+          gen_container_slices(n);
         if (!strcmp(typ->id->name, "std::vector") && !is_primitive(n) && n->type != Tpointer)
         {
           fprintf(fout, "\n\t\tif (!a->empty() && a->size() == a->capacity())\n\t\t{\tconst void *p = &a->front();");
@@ -21440,6 +22333,8 @@ soap_in(Tnode *typ)
         else
           fprintf(fout, "!soap_in_%s(soap, tag, NULL, \"%s\")", c_ident(n), xsi_type(n));
         fprintf(fout, ")\n\t\t\t\tbreak;\n\t\t}\n\t\telse\n\t\t{\t");
+        if (Fflag)
+          fprintf(fout, "struct soap_imark soap_mark;\n\t\t\tsoap_begin_item(soap, &soap_mark);\n\t\t\t");
         if (is_XML(n) && is_string(n))
           fprintf(fout, "if (!soap_inliteral(soap, tag, n))");
         else if (is_XML(n) && is_wstring(n))
@@ -21448,7 +22343,10 @@ soap_in(Tnode *typ)
           fprintf(fout, "if (!soap_in_%s(soap, tag, n, \"%s\"))", c_ident(n), xsi_type(n));
         else
           fprintf(fout, "if (!soap_in_%s(soap, tag, n, \"%s\"))", c_ident(n), xsi_type(n));
-        fprintf(fout, "\n\t\t\t{\ta->pop_back();\n\t\t\t\tbreak;\n\t\t\t}\n\t\t}");
+        fprintf(fout, "\n\t\t\t{\ta->pop_back();\n\t\t\t\tbreak;\n\t\t\t}");
+        if (Fflag)
+          gen_item_release_container(n, "n", "\n\t\t\t\ta->pop_back();");
+        fprintf(fout, "\n\t\t}");
         if (!is_primitive(n) && n->type != Tpointer)
           fprintf(fout, "\n\t\tsoap_end_shaky(soap, soap_shaky);");
         fprintf(fout, "\n\t\tif (!tag || *tag == '-')\n\t\t\treturn a;\n\t}\n\tif (soap_flag && (soap->error == SOAP_TAG_MISMATCH || soap->error == SOAP_NO_TAG))\n\t{\tsoap->error = SOAP_OK;\n\t\treturn a;\n\t}\n\treturn NULL;\n}");
@@ -21460,6 +22358,8 @@ soap_in(Tnode *typ)
         fprintf(fout, "\n\t\tif (tag && *tag != '-')\n\t\t{\tif (soap_element_begin_in(soap, tag, 1, NULL))\n\t\t\t\tbreak;\n\t\t\tsoap_revert(soap);\n\t\t}");
         fprintf(fout, "\n\t\tif (!a && !(a = soap_new_%s(soap)))\n\t\t\treturn NULL;", c_ident(typ));
         fprintf(fout, "\n\t\telse if (static_cast<size_t>(a->size()) > soap->maxoccurs)\n\t\t{\tsoap->error = SOAP_OCCURS;\n\t\t\treturn NULL;\n\t\t}");
+        if (is_parallel_container(typ))
+          gen_container_slices(n);
         fprintf(fout, "\n\t\t%s;\n\t\t", c_type_id(n, "n"));
         if (n->type == Tpointer)
           fprintf(fout, "n = NULL;");
@@ -21482,6 +22382,8 @@ soap_in(Tnode *typ)
         else
           fprintf(fout, "!soap_in_%s(soap, tag, NULL, \"%s\")", c_ident(n), xsi_type(n));
         fprintf(fout, ")\n\t\t\t\tbreak;\n\t\t}\n\t\telse\n\t\t{\t");
+        if (Fflag)
+          fprintf(fout, "struct soap_imark soap_mark;\n\t\t\tsoap_begin_item(soap, &soap_mark);\n\t\t\t");
         if (is_XML(n) && is_string(n))
           fprintf(fout, "if (!soap_inliteral(soap, tag, &n))");
         else if (is_XML(n) && is_wstring(n))
@@ -21490,7 +22392,10 @@ soap_in(Tnode *typ)
           fprintf(fout, "if (!soap_in_%s(soap, tag, &n, \"%s\"))", c_ident(n), xsi_type(n));
         else
           fprintf(fout, "if (!soap_in_%s(soap, tag, &n, \"%s\"))", c_ident(n), xsi_type(n));
-        fprintf(fout, "\n\t\t\t\tbreak;\n\t\t}");
+        fprintf(fout, "\n\t\t\t\tbreak;");
+        if (Fflag)
+          gen_item_release_container(n, "&n", "");
+        fprintf(fout, "\n\t\t}");
         if (!is_primitive(n) && n->type != Tpointer)
           fprintf(fout, "\n\t\tsoap_end_shaky(soap, soap_shaky);");
         if (!(!strcmp(typ->id->name, "std::list") || !strcmp(typ->id->name, "std::deque") || !strcmp(typ->id->name, "std::set")) && !is_primitive(n) && n->type != Tpointer && !is_smart(n))
@@ -21766,7 +22671,7 @@ soap_in_Darray(Tnode *typ)
      || (!cflag && ((Tnode*)p->info.typ->ref)->type == Tstruct))
       fprintf(fout, "\tp = soap_block<%s>::push(soap, NULL);\n\t\t\t\tif (!p)\n\t\t\t\t\tbreak;", c_type((Tnode*)p->info.typ->ref));
     else
-      fprintf(fout, "\tp = (%s)soap_push_block(soap, NULL, sizeof(%s));\n\t\t\t\tif (!p)\n\t\t\t\t\tbreak;", c_type(p->info.typ), c_type((Tnode*)p->info.typ->ref));
+      fprintf(fout, "\tp = (%s)soap_push_block_max(soap, NULL, sizeof(%s));\n\t\t\t\tif (!p)\n\t\t\t\t\tbreak;", c_type(p->info.typ), c_type((Tnode*)p->info.typ->ref));
     if (((Tnode*)p->info.typ->ref)->type == Tclass && !is_external((Tnode*)p->info.typ->ref) && !is_volatile((Tnode*)p->info.typ->ref) && !is_typedef((Tnode*)p->info.typ->ref))
       fprintf(fout, "\n\t\t\t\tp->soap_default(soap);");
     else if (((Tnode*)p->info.typ->ref)->type == Tpointer)
@@ -21840,6 +22745,603 @@ soap_in_Darray(Tnode *typ)
   fprintf(fout, "\n\treturn a;\n}");
 }
 
+int
+is_json(Tnode *typ)
+{
+  Entry *p;
+  if (is_transient(typ) || is_XML(typ) || is_wstring(typ) || is_stdwstring(typ) || is_smart(typ))
+    return 0;
+  if (is_string(typ) || is_stdstring(typ))
+    return 1;
+  if (is_external(typ))
+    return 0;
+  switch (typ->type)
+  {
+    case Tchar:
+    case Tshort:
+    case Tint:
+    case Tlong:
+    case Tllong:
+    case Tfloat:
+    case Tdouble:
+    case Tuchar:
+    case Tushort:
+    case Tuint:
+    case Tulong:
+    case Tullong:
+    case Ttime:
+    case Tenum:
+    case Tenumsc:
+      return 1;
+    case Tpointer:
+      return is_json((Tnode*)typ->ref);
+    case Ttemplate:
+      return typ->ref
+        && (!strcmp(typ->id->name, "std::vector") || !strcmp(typ->id->name, "std::deque") || !strcmp(typ->id->name, "std::list"))
+        && !is_bool((Tnode*)typ->ref)
+        && is_json((Tnode*)typ->ref);
+    case Tstruct:
+    case Tclass:
+      if (is_binary(typ))
+        return 1;
+      p = is_dynamic_array(typ);
+      if (p)
+        return p->info.typ->type == Tpointer && p->next->info.typ->type == Tint && is_json((Tnode*)p->info.typ->ref);
+      return 1;
+    default:
+      break;
+  }
+  return 0;
+}
+
+/* returns 1 if member p is a JSON object member, 2 if p is a __sizeX repetition of the next member X */
+int
+is_json_member(Entry *p)
+{
+  if (p->info.typ->type == Tfun || (p->info.sto & (Sconst | Sprivate | Sprotected | Sstatic | Stypedef)) || is_soapref(p->info.typ))
+    return 0;
+  if (is_repetition(p))
+    return !(p->next->info.sto & (Sconst | Sconstptr | Sprivate | Sprotected)) && is_json((Tnode*)p->next->info.typ->ref) ? 2 : 0;
+  if (is_anytype(p) || is_choice(p))
+    return 0;
+  return is_json(p->info.typ);
+}
+
+/* JSON object key of member p is the XML local name of p */
+const char *
+json_key(Entry *p)
+{
+  if (p->tag)
+    return ns_name(p->tag);
+  return ns_remove(p->sym->name);
+}
+
+/* member p of a table t of struct or class typ */
+const char *
+json_member(Tnode *typ, Table *t, Entry *p)
+{
+  char *s;
+  if (typ->type == Tclass && t->sym)
+  {
+    s = (char*)emalloc(strlen(ident(t->sym->name)) + strlen(ident(p->sym->name)) + 6);
+    sprintf(s, "a->%s::%s", ident(t->sym->name), ident(p->sym->name));
+  }
+  else
+  {
+    s = (char*)emalloc(strlen(ident(p->sym->name)) + 4);
+    sprintf(s, "a->%s", ident(p->sym->name));
+  }
+  return s;
+}
+
+/* emit code to write JSON array values ptr[0..size-1] of type typ */
+void
+json_array_out(Tnode *typ, const char *ptr, const char *size, const char *indent)
+{
+  fprintf(fout, "\n%sif (soap_send_raw(soap, \"[\", 1))\n%s\treturn soap->error;", indent, indent);
+  fprintf(fout, "\n%sif (%s)\n%s{\tint i;\n%s\tfor (i = 0; i < %s; i++)\n%s\t\tif ((i && soap_send_raw(soap, \",\", 1)) || soap_out_json_%s(soap, %s + i))\n%s\t\t\treturn soap->error;\n%s}", indent, ptr, indent, indent, size, indent, c_ident(typ), ptr, indent, indent);
+  fprintf(fout, "\n%sif (soap_send_raw(soap, \"]\", 1))\n%s\treturn soap->error;", indent, indent);
+}
+
+/* emit code to read a JSON array into ptr and size with values of type typ */
+void
+json_array_in(Tnode *typ, const char *ptr, const char *size, const char *indent)
+{
+  int block = typ->type == Tclass || typ->type == Ttemplate || has_class(typ) || (!cflag && typ->type == Tstruct);
+  fprintf(fout, "\n%s{\tstruct soap_blist *soap_blist = NULL;\n%s\tint soap_num = 0;", indent, indent);
+  fprintf(fout, "\n%s\tif (soap_json_begin_in(soap, '['))\n%s\t\treturn NULL;", indent, indent);
+  fprintf(fout, "\n%s\twhile (soap_json_next_in(soap, ']', &soap_num))\n%s\t{\t%s;", indent, indent, c_type_id(typ, "*p"));
+  fprintf(fout, "\n%s\t\tif (!soap_blist && !(soap_blist = soap_alloc_block(soap)))\n%s\t\t\treturn NULL;", indent, indent);
+  if (block)
+    fprintf(fout, "\n%s\t\tp = soap_block<%s>::push(soap, soap_blist);", indent, c_type(typ));
+  else
+    fprintf(fout, "\n%s\t\tp = (%s)soap_push_block_max(soap, soap_blist, sizeof(%s));", indent, c_type_id(typ, "*"), c_type(typ));
+  fprintf(fout, "\n%s\t\tif (!p)\n%s\t\t\treturn NULL;", indent, indent);
+  if (typ->type == Tpointer)
+    fprintf(fout, "\n%s\t\t*p = NULL;", indent);
+  else if (!block)
+    fprintf(fout, "\n%s\t\tsoap_default_%s(soap, p);", indent, c_ident(typ));
+  fprintf(fout, "\n%s\t\tif (!soap_in_json_%s(soap, p))\n%s\t\t\treturn NULL;\n%s\t}", indent, c_ident(typ), indent, indent);
+  fprintf(fout, "\n%s\tif (soap->error)\n%s\t\treturn NULL;", indent, indent);
+  fprintf(fout, "\n%s\tif (soap_blist)\n%s\t{\t", indent, indent);
+  if (block)
+    fprintf(fout, "%s = soap_new_%s(soap, soap_num);\n%s\t\tif (!%s)\n%s\t\t\treturn NULL;\n%s\t\tsoap_block<%s>::save(soap, soap_blist, %s);", ptr, c_ident(typ), indent, ptr, indent, indent, c_type(typ), ptr);
+  else
+    fprintf(fout, "%s = (%s)soap_save_block(soap, soap_blist, NULL, 1);", ptr, c_type_id(typ, "*"));
+  fprintf(fout, "\n%s\t\t%s = soap_num;\n%s\t}\n%s}", indent, size, indent, indent);
+}
+
+void
+soap_out_json(Tnode *typ)
+{
+  Table *t;
+  Entry *p;
+  const char *ci = c_ident(typ);
+  if (!Jflag || !is_json(typ))
+    return;
+  if (typ->type == Tpointer)
+  {
+    fprintf(fhead, "\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_json_%s(struct soap*, %s);", ci, c_type_constptr_id(typ, "const*"));
+    fprintf(fout, "\n\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_json_%s(struct soap *soap, %s)\n{", ci, c_type_constptr_id(typ, "const*a"));
+  }
+  else
+  {
+    fprintf(fhead, "\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_json_%s(struct soap*, const %s);", ci, c_type_id(typ, "*"));
+    fprintf(fout, "\n\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_json_%s(struct soap *soap, const %s)\n{", ci, c_type_id(typ, "*a"));
+  }
+  if (is_string(typ))
+  {
+    fprintf(fout, "\n\treturn soap_json_string_out(soap, *a);");
+  }
+  else if (is_stdstring(typ))
+  {
+    fprintf(fout, "\n\treturn soap_json_string_out(soap, a->c_str());");
+  }
+  else if (typ->type == Tpointer)
+  {
+    fprintf(fout, "\n\tif (!*a)\n\t\treturn soap_send_raw(soap, \"null\", 4);");
+    fprintf(fout, "\n\treturn soap_out_json_%s(soap, *a);", c_ident((Tnode*)typ->ref));
+  }
+  else if (is_boolean(typ))
+  {
+    fprintf(fout, "\n\treturn soap_send(soap, soap_%s2s(soap, *a));", ci);
+  }
+  else if (typ->type == Tenum || typ->type == Tenumsc || typ->type == Ttime)
+  {
+    fprintf(fout, "\n\treturn soap_json_string_out(soap, soap_%s2s(soap, *a));", ci);
+  }
+  else if (is_primitive(typ))
+  {
+    fprintf(fout, "\n\treturn soap_json_number_out(soap, soap_%s2s(soap, *a));", ci);
+  }
+  else if (is_binary(typ))
+  {
+    fprintf(fout, "\n\tif (!a->__ptr)\n\t\treturn soap_send_raw(soap, \"null\", 4);");
+    fprintf(fout, "\n\treturn soap_json_string_out(soap, soap_s2%s(soap, a->__ptr, NULL, a->__size));", is_hexBinary(typ) ? "hex" : "base64");
+  }
+  else if (is_dynamic_array(typ))
+  {
+    json_array_out((Tnode*)is_dynamic_array(typ)->info.typ->ref, "a->__ptr", "a->__size", "\t");
+    fprintf(fout, "\n\treturn SOAP_OK;");
+  }
+  else if (typ->type == Ttemplate)
+  {
+    fprintf(fout, "\n\tif (soap_send_raw(soap, \"[\", 1))\n\t\treturn soap->error;");
+    fprintf(fout, "\n\tfor (%s::const_iterator i = a->begin(); i != a->end(); ++i)\n\t\tif ((i != a->begin() && soap_send_raw(soap, \",\", 1)) || soap_out_json_%s(soap, &*i))\n\t\t\treturn soap->error;", c_type(typ), c_ident((Tnode*)typ->ref));
+    fprintf(fout, "\n\treturn soap_send_raw(soap, \"]\", 1);");
+  }
+  else
+  {
+    int n = 0;
+    for (t = (Table*)typ->ref; t; t = t->prev)
+      for (p = t->list; p; p = p->next)
+        if (is_json_member(p))
+          n++;
+    if (n)
+      fprintf(fout, "\n\tint n = 0;");
+    else
+      fprintf(fout, "\n\t(void)a;");
+    fprintf(fout, "\n\tif (soap_send_raw(soap, \"{\", 1))\n\t\treturn soap->error;");
+    for (t = (Table*)typ->ref; t; t = t->prev)
+    {
+      for (p = t->list; p; p = p->next)
+      {
+        int k = is_json_member(p);
+        if (k == 2)
+        {
+          const char *size = json_member(typ, t, p);
+          p = p->next;
+          fprintf(fout, "\n\tif (%s)\n\t{\tif (soap_json_key_out(soap, \"%s\", n++))\n\t\t\treturn soap->error;", json_member(typ, t, p), json_key(p));
+          json_array_out((Tnode*)p->info.typ->ref, json_member(typ, t, p), size, "\t\t");
+          fprintf(fout, "\n\t}");
+        }
+        else if (is_repetition(p) || is_anytype(p) || is_choice(p))
+        {
+          p = p->next;
+        }
+        else if (k && p->info.typ->type == Tpointer && !is_string(p->info.typ))
+        {
+          fprintf(fout, "\n\tif (%s && (soap_json_key_out(soap, \"%s\", n++) || soap_out_json_%s(soap, &%s)))\n\t\treturn soap->error;", json_member(typ, t, p), json_key(p), c_ident(p->info.typ), json_member(typ, t, p));
+        }
+        else if (k)
+        {
+          fprintf(fout, "\n\tif (soap_json_key_out(soap, \"%s\", n++) || soap_out_json_%s(soap, &%s))\n\t\treturn soap->error;", json_key(p), c_ident(p->info.typ), json_member(typ, t, p));
+        }
+      }
+    }
+    fprintf(fout, "\n\treturn soap_send_raw(soap, \"}\", 1);");
+  }
+  fprintf(fout, "\n}");
+  if (typ->type != Tpointer || is_string(typ))
+    fprintf(fhead, "\n\n#ifndef soap_write_json_%s\n#define soap_write_json_%s(soap, data) ( soap_free_temp(soap), soap_begin_send(soap) || soap_out_json_%s(soap, (data)) || soap_end_send(soap), (soap)->error )\n#endif\n", ci, ci, ci);
+}
+
+void
+soap_in_json(Tnode *typ)
+{
+  Table *t;
+  Entry *p;
+  const char *ci = c_ident(typ);
+  if (!Jflag || !is_json(typ))
+    return;
+  fprintf(fhead, "\nSOAP_FMAC3 %s * SOAP_FMAC4 soap_in_json_%s(struct soap*, %s);", c_type(typ), ci, c_type_id(typ, "*"));
+  fprintf(fout, "\n\nSOAP_FMAC3 %s * SOAP_FMAC4 soap_in_json_%s(struct soap *soap, %s)\n{", c_type(typ), ci, c_type_id(typ, "*a"));
+  if (is_primitive_or_string(typ) || is_binary(typ))
+  {
+    fprintf(fout, "\n\tconst char *s = soap_json_value_in(soap);\n\tif (soap->error)\n\t\treturn NULL;");
+    fprintf(fout, "\n\tif (!a && !(a = soap_new_%s(soap, -1)))\n\t\treturn NULL;", ci);
+    if (is_string(typ))
+      fprintf(fout, "\n\t*a = NULL;\n\tif (s && !(*a = soap_strdup(soap, s)))\n\t\treturn NULL;");
+    else if (is_stdstring(typ))
+      fprintf(fout, "\n\tif (s)\n\t\ta->assign(s);");
+    else if (is_binary(typ))
+      fprintf(fout, "\n\tif (s && !(a->__ptr = (unsigned char*)soap_%s2s(soap, s, NULL, 0, &a->__size)))\n\t\treturn NULL;", is_hexBinary(typ) ? "hex" : "base64");
+    else
+      fprintf(fout, "\n\tif (s && soap_s2%s(soap, s, a))\n\t\treturn NULL;", ci);
+  }
+  else if (typ->type == Tpointer)
+  {
+    fprintf(fout, "\n\tif (!a && !(a = (%s)soap_malloc(soap, sizeof(%s))))\n\t\treturn NULL;", c_type_id(typ, "*"), c_type(typ));
+    fprintf(fout, "\n\tif (soap_json_null_in(soap))\n\t\t*a = NULL;");
+    fprintf(fout, "\n\telse if (soap->error || !(*a = soap_in_json_%s(soap, NULL)))\n\t\treturn NULL;", c_ident((Tnode*)typ->ref));
+  }
+  else if (is_dynamic_array(typ))
+  {
+    fprintf(fout, "\n\tif (!a && !(a = soap_new_%s(soap, -1)))\n\t\treturn NULL;", ci);
+    if (typ->type == Tclass && !is_external(typ) && !is_volatile(typ) && !is_typedef(typ))
+      fprintf(fout, "\n\ta->soap_default(soap);");
+    else
+      fprintf(fout, "\n\tsoap_default_%s(soap, a);", ci);
+    json_array_in((Tnode*)is_dynamic_array(typ)->info.typ->ref, "a->__ptr", "a->__size", "\t");
+  }
+  else
+  {
+    fprintf(fout, "\n\tint n = 0;");
+    fprintf(fout, "\n\tif (soap_json_begin_in(soap, '%c'))\n\t\treturn NULL;", typ->type == Ttemplate ? '[' : '{');
+    fprintf(fout, "\n\tif (!a)\n\t{\tif (!(a = soap_new_%s(soap, -1)))\n\t\t\treturn NULL;\n\t}\n\telse", ci);
+    if (typ->type == Tclass && !is_external(typ) && !is_volatile(typ) && !is_typedef(typ))
+      fprintf(fout, "\n\t\ta->soap_default(soap);");
+    else
+      fprintf(fout, "\n\t\tsoap_default_%s(soap, a);", ci);
+    if (typ->type == Ttemplate)
+    {
+      Tnode *ref = (Tnode*)typ->ref;
+      fprintf(fout, "\n\twhile (soap_json_next_in(soap, ']', &n))\n\t{\t%s;", c_type_id(ref, "v"));
+      if (ref->type == Tpointer)
+        fprintf(fout, "\n\t\tv = NULL;");
+      else if (is_primitive(ref))
+        fprintf(fout, "\n\t\tsoap_default_%s(soap, &v);", c_ident(ref));
+      fprintf(fout, "\n\t\ta->push_back(v);\n\t\tif (!soap_in_json_%s(soap, &a->back()))\n\t\t\treturn NULL;\n\t}", c_ident(ref));
+    }
+    else
+    {
+      const char *s = "";
+      fprintf(fout, "\n\twhile (soap_json_next_in(soap, '}', &n))\n\t{\tconst char *key = soap_json_key_in(soap);\n\t\tif (!key)\n\t\t\treturn NULL;\n\t\t");
+      for (t = (Table*)typ->ref; t; t = t->prev)
+      {
+        for (p = t->list; p; p = p->next)
+        {
+          int k = is_json_member(p);
+          if (k == 2)
+          {
+            const char *size = json_member(typ, t, p);
+            p = p->next;
+            fprintf(fout, "%sif (!strcmp(key, \"%s\"))", s, json_key(p));
+            json_array_in((Tnode*)p->info.typ->ref, json_member(typ, t, p), size, "\t\t");
+            s = "\n\t\telse ";
+          }
+          else if (is_repetition(p) || is_anytype(p) || is_choice(p))
+          {
+            p = p->next;
+          }
+          else if (k)
+          {
+            fprintf(fout, "%sif (!strcmp(key, \"%s\"))\n\t\t{\tif (!soap_in_json_%s(soap, &%s))\n\t\t\t\treturn NULL;\n\t\t}", s, json_key(p), c_ident(p->info.typ), json_member(typ, t, p));
+            s = "\n\t\telse ";
+          }
+        }
+      }
+      fprintf(fout, "%sif (soap_json_ignore_in(soap))\n\t\t\treturn NULL;\n\t}", s);
+    }
+    fprintf(fout, "\n\tif (soap->error)\n\t\treturn NULL;");
+  }
+  fprintf(fout, "\n\treturn a;\n}");
+  if (typ->type != Tpointer || is_string(typ))
+    fprintf(fhead, "\n\n#ifndef soap_read_json_%s\n#define soap_read_json_%s(soap, data) ( soap_begin_recv(soap) || !soap_in_json_%s(soap, (data)) || soap_end_recv(soap), (soap)->error )\n#endif\n", ci, ci, ci);
+}
+
+/* emit code to write CBOR array values ptr[0..size-1] of type typ */
+void
+cbor_array_out(Tnode *typ, const char *ptr, const char *size, const char *indent)
+{
+  fprintf(fout, "\n%sif (soap_cbor_head_out(soap, SOAP_CBOR_ARRAY, %s && %s > 0 ? (ULONG64)%s : 0))\n%s\treturn soap->error;", indent, ptr, size, size, indent);
+  fprintf(fout, "\n%sif (%s)\n%s{\tint i;\n%s\tfor (i = 0; i < %s; i++)\n%s\t\tif (soap_out_cbor_%s(soap, %s + i))\n%s\t\t\treturn soap->error;\n%s}", indent, ptr, indent, indent, size, indent, c_ident(typ), ptr, indent, indent);
+}
+
+/* emit code to read a CBOR array into ptr and size with values of type typ */
+void
+cbor_array_in(Tnode *typ, const char *ptr, const char *size, const char *indent)
+{
+  int block = typ->type == Tclass || typ->type == Ttemplate || has_class(typ) || (!cflag && typ->type == Tstruct);
+  fprintf(fout, "\n%s{\tstruct soap_blist *soap_blist = NULL;\n%s\tint soap_num = 0;\n%s\tsize_t soap_len;", indent, indent, indent);
+  fprintf(fout, "\n%s\tif (soap_cbor_begin_in(soap, SOAP_CBOR_ARRAY, &soap_len))\n%s\t\treturn NULL;", indent, indent);
+  fprintf(fout, "\n%s\twhile (soap_cbor_next_in(soap, &soap_len))\n%s\t{\t%s;", indent, indent, c_type_id(typ, "*p"));
+  fprintf(fout, "\n%s\t\tif (!soap_blist && !(soap_blist = soap_alloc_block(soap)))\n%s\t\t\treturn NULL;", indent, indent);
+  if (block)
+    fprintf(fout, "\n%s\t\tp = soap_block<%s>::push(soap, soap_blist);", indent, c_type(typ));
+  else
+    fprintf(fout, "\n%s\t\tp = (%s)soap_push_block_max(soap, soap_blist, sizeof(%s));", indent, c_type_id(typ, "*"), c_type(typ));
+  fprintf(fout, "\n%s\t\tif (!p)\n%s\t\t\treturn NULL;", indent, indent);
+  if (typ->type == Tpointer)
+    fprintf(fout, "\n%s\t\t*p = NULL;", indent);
+  else if (!block)
+    fprintf(fout, "\n%s\t\tsoap_default_%s(soap, p);", indent, c_ident(typ));
+  fprintf(fout, "\n%s\t\tif (!soap_in_cbor_%s(soap, p))\n%s\t\t\treturn NULL;\n%s\t\tsoap_num++;\n%s\t}", indent, c_ident(typ), indent, indent, indent);
+  fprintf(fout, "\n%s\tif (soap->error)\n%s\t\treturn NULL;", indent, indent);
+  fprintf(fout, "\n%s\tif (soap_blist)\n%s\t{\t", indent, indent);
+  if (block)
+    fprintf(fout, "%s = soap_new_%s(soap, soap_num);\n%s\t\tif (!%s)\n%s\t\t\treturn NULL;\n%s\t\tsoap_block<%s>::save(soap, soap_blist, %s);", ptr, c_ident(typ), indent, ptr, indent, indent, c_type(typ), ptr);
+  else
+    fprintf(fout, "%s = (%s)soap_save_block(soap, soap_blist, NULL, 1);", ptr, c_type_id(typ, "*"));
+  fprintf(fout, "\n%s\t\t%s = soap_num;\n%s\t}\n%s}", indent, size, indent, indent);
+}
+
+/* CBOR serializers cover the same types as the JSON serializers, with the same object keys */
+void
+soap_out_cbor(Tnode *typ)
+{
+  Table *t;
+  Entry *p;
+  const char *ci = c_ident(typ);
+  if (!Bflag || !is_json(typ))
+    return;
+  if (typ->type == Tpointer)
+  {
+    fprintf(fhead, "\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_cbor_%s(struct soap*, %s);", ci, c_type_constptr_id(typ, "const*"));
+    fprintf(fout, "\n\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_cbor_%s(struct soap *soap, %s)\n{", ci, c_type_constptr_id(typ, "const*a"));
+  }
+  else
+  {
+    fprintf(fhead, "\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_cbor_%s(struct soap*, const %s);", ci, c_type_id(typ, "*"));
+    fprintf(fout, "\n\nSOAP_FMAC3 int SOAP_FMAC4 soap_out_cbor_%s(struct soap *soap, const %s)\n{", ci, c_type_id(typ, "*a"));
+  }
+  if (is_string(typ))
+  {
+    fprintf(fout, "\n\treturn soap_cbor_string_out(soap, *a);");
+  }
+  else if (is_stdstring(typ))
+  {
+    fprintf(fout, "\n\treturn soap_cbor_string_out(soap, a->c_str());");
+  }
+  else if (typ->type == Tpointer)
+  {
+    fprintf(fout, "\n\tif (!*a)\n\t\treturn soap_cbor_null_out(soap);");
+    fprintf(fout, "\n\treturn soap_out_cbor_%s(soap, *a);", c_ident((Tnode*)typ->ref));
+  }
+  else if (is_boolean(typ))
+  {
+    fprintf(fout, "\n\treturn soap_cbor_bool_out(soap, (int)*a);");
+  }
+  else if (typ->type == Ttime)
+  {
+    fprintf(fout, "\n\tif (soap_cbor_head_out(soap, SOAP_CBOR_TAG, 1))\n\t\treturn soap->error;");
+    fprintf(fout, "\n\treturn soap_cbor_int_out(soap, (LONG64)*a);");
+  }
+  else if (typ->type == Tfloat)
+  {
+    fprintf(fout, "\n\treturn soap_cbor_float_out(soap, *a);");
+  }
+  else if (typ->type == Tdouble)
+  {
+    fprintf(fout, "\n\treturn soap_cbor_double_out(soap, *a);");
+  }
+  else if (typ->type == Tuchar || typ->type == Tushort || typ->type == Tuint || typ->type == Tulong || typ->type == Tullong)
+  {
+    fprintf(fout, "\n\treturn soap_cbor_head_out(soap, SOAP_CBOR_UINT, (ULONG64)*a);");
+  }
+  else if (is_primitive(typ))
+  {
+    fprintf(fout, "\n\treturn soap_cbor_int_out(soap, (LONG64)*a);");
+  }
+  else if (is_binary(typ))
+  {
+    fprintf(fout, "\n\treturn soap_cbor_bytes_out(soap, a->__ptr, a->__size);");
+  }
+  else if (is_dynamic_array(typ))
+  {
+    cbor_array_out((Tnode*)is_dynamic_array(typ)->info.typ->ref, "a->__ptr", "a->__size", "\t");
+    fprintf(fout, "\n\treturn SOAP_OK;");
+  }
+  else if (typ->type == Ttemplate)
+  {
+    fprintf(fout, "\n\tif (soap_cbor_head_out(soap, SOAP_CBOR_ARRAY, (ULONG64)a->size()))\n\t\treturn soap->error;");
+    fprintf(fout, "\n\tfor (%s::const_iterator i = a->begin(); i != a->end(); ++i)\n\t\tif (soap_out_cbor_%s(soap, &*i))\n\t\t\treturn soap->error;", c_type(typ), c_ident((Tnode*)typ->ref));
+    fprintf(fout, "\n\treturn SOAP_OK;");
+  }
+  else
+  {
+    int n = 0;
+    for (t = (Table*)typ->ref; t; t = t->prev)
+      for (p = t->list; p; p = p->next)
+        if (is_json_member(p))
+          n++;
+    if (!n)
+      fprintf(fout, "\n\t(void)a;");
+    fprintf(fout, "\n\tif (soap_cbor_begin_out(soap, SOAP_CBOR_MAP))\n\t\treturn soap->error;");
+    for (t = (Table*)typ->ref; t; t = t->prev)
+    {
+      for (p = t->list; p; p = p->next)
+      {
+        int k = is_json_member(p);
+        if (k == 2)
+        {
+          const char *size = json_member(typ, t, p);
+          p = p->next;
+          fprintf(fout, "\n\tif (%s)\n\t{\tif (soap_cbor_string_out(soap, \"%s\"))\n\t\t\treturn soap->error;", json_member(typ, t, p), json_key(p));
+          cbor_array_out((Tnode*)p->info.typ->ref, json_member(typ, t, p), size, "\t\t");
+          fprintf(fout, "\n\t}");
+        }
+        else if (is_repetition(p) || is_anytype(p) || is_choice(p))
+        {
+          p = p->next;
+        }
+        else if (k && p->info.typ->type == Tpointer && !is_string(p->info.typ))
+        {
+          fprintf(fout, "\n\tif (%s && (soap_cbor_string_out(soap, \"%s\") || soap_out_cbor_%s(soap, &%s)))\n\t\treturn soap->error;", json_member(typ, t, p), json_key(p), c_ident(p->info.typ), json_member(typ, t, p));
+        }
+        else if (k)
+        {
+          fprintf(fout, "\n\tif (soap_cbor_string_out(soap, \"%s\") || soap_out_cbor_%s(soap, &%s))\n\t\treturn soap->error;", json_key(p), c_ident(p->info.typ), json_member(typ, t, p));
+        }
+      }
+    }
+    fprintf(fout, "\n\treturn soap_cbor_end_out(soap);");
+  }
+  fprintf(fout, "\n}");
+  if (typ->type != Tpointer || is_string(typ))
+  {
+    fprintf(fhead, "\n\n#ifndef soap_write_cbor_%s\n#define soap_write_cbor_%s(soap, data) ( soap_free_temp(soap), soap_begin_send(soap) || soap_cbor_head_out(soap, SOAP_CBOR_TAG, SOAP_CBOR_SELF) || soap_out_cbor_%s(soap, (data)) || soap_end_send(soap), (soap)->error )\n#endif\n", ci, ci, ci);
+    fprintf(fhead, "\n#ifndef soap_POST_send_cbor_%s\n#define soap_POST_send_cbor_%s(soap, URL, data) ( soap_free_temp(soap), ( soap_POST(soap, URL, NULL, SOAP_CBOR_CONTENT_TYPE) || soap_cbor_head_out(soap, SOAP_CBOR_TAG, SOAP_CBOR_SELF) || soap_out_cbor_%s(soap, (data)) || soap_end_send(soap) ) && soap_closesock(soap), (soap)->error )\n#endif\n", ci, ci, ci);
+  }
+}
+
+void
+soap_in_cbor(Tnode *typ)
+{
+  Table *t;
+  Entry *p;
+  const char *ci = c_ident(typ);
+  if (!Bflag || !is_json(typ))
+    return;
+  fprintf(fhead, "\nSOAP_FMAC3 %s * SOAP_FMAC4 soap_in_cbor_%s(struct soap*, %s);", c_type(typ), ci, c_type_id(typ, "*"));
+  fprintf(fout, "\n\nSOAP_FMAC3 %s * SOAP_FMAC4 soap_in_cbor_%s(struct soap *soap, %s)\n{", c_type(typ), ci, c_type_id(typ, "*a"));
+  if (is_string(typ) || is_stdstring(typ))
+  {
+    fprintf(fout, "\n\tconst char *s = soap_cbor_string_in(soap);\n\tif (soap->error)\n\t\treturn NULL;");
+    fprintf(fout, "\n\tif (!a && !(a = soap_new_%s(soap, -1)))\n\t\treturn NULL;", ci);
+    if (is_string(typ))
+      fprintf(fout, "\n\t*a = NULL;\n\tif (s && !(*a = soap_strdup(soap, s)))\n\t\treturn NULL;");
+    else
+      fprintf(fout, "\n\tif (s)\n\t\ta->assign(s);");
+  }
+  else if (is_binary(typ))
+  {
+    fprintf(fout, "\n\tint n;\n\tconst unsigned char *s = soap_cbor_bytes_in(soap, &n);\n\tif (soap->error)\n\t\treturn NULL;");
+    fprintf(fout, "\n\tif (!a && !(a = soap_new_%s(soap, -1)))\n\t\treturn NULL;", ci);
+    fprintf(fout, "\n\tif (s)\n\t{\tif (!(a->__ptr = (unsigned char*)soap_malloc(soap, n + 1)))\n\t\t\treturn NULL;\n\t\t(void)soap_memcpy((void*)a->__ptr, n + 1, (const void*)s, n);\n\t\ta->__size = n;\n\t}");
+  }
+  else if (is_primitive(typ))
+  {
+    if (is_boolean(typ))
+      fprintf(fout, "\n\tint v = 0;\n\tif (soap_cbor_bool_in(soap, &v))\n\t\treturn NULL;");
+    else if (typ->type == Tfloat || typ->type == Tdouble)
+      fprintf(fout, "\n\tdouble v = 0.0;\n\tif (soap_cbor_double_in(soap, &v))\n\t\treturn NULL;");
+    else if (typ->type == Tuchar || typ->type == Tushort || typ->type == Tuint || typ->type == Tulong || typ->type == Tullong)
+      fprintf(fout, "\n\tULONG64 v = 0;\n\tif (soap_cbor_uint_in(soap, &v))\n\t\treturn NULL;");
+    else
+      fprintf(fout, "\n\tLONG64 v = 0;\n\tif (soap_cbor_int_in(soap, &v))\n\t\treturn NULL;");
+    fprintf(fout, "\n\tif (!a && !(a = soap_new_%s(soap, -1)))\n\t\treturn NULL;", ci);
+    if (is_boolean(typ))
+      fprintf(fout, "\n\t*a = (%s)(v != 0);", c_type(typ));
+    else if (typ->type == Tfloat || typ->type == Tdouble)
+      fprintf(fout, "\n\t*a = (%s)v;", c_type(typ));
+    else
+      fprintf(fout, "\n\t*a = (%s)v;\n\tif ((%s)*a != v)\n\t{\tsoap->error = SOAP_TYPE;\n\t\treturn NULL;\n\t}", c_type(typ), typ->type == Tuchar || typ->type == Tushort || typ->type == Tuint || typ->type == Tulong || typ->type == Tullong ? "ULONG64" : "LONG64");
+  }
+  else if (typ->type == Tpointer)
+  {
+    fprintf(fout, "\n\tif (!a && !(a = (%s)soap_malloc(soap, sizeof(%s))))\n\t\treturn NULL;", c_type_id(typ, "*"), c_type(typ));
+    fprintf(fout, "\n\tif (soap_cbor_null_in(soap))\n\t\t*a = NULL;");
+    fprintf(fout, "\n\telse if (!(*a = soap_in_cbor_%s(soap, NULL)))\n\t\treturn NULL;", c_ident((Tnode*)typ->ref));
+  }
+  else if (is_dynamic_array(typ))
+  {
+    fprintf(fout, "\n\tif (!a && !(a = soap_new_%s(soap, -1)))\n\t\treturn NULL;", ci);
+    if (typ->type == Tclass && !is_external(typ) && !is_volatile(typ) && !is_typedef(typ))
+      fprintf(fout, "\n\ta->soap_default(soap);");
+    else
+      fprintf(fout, "\n\tsoap_default_%s(soap, a);", ci);
+    cbor_array_in((Tnode*)is_dynamic_array(typ)->info.typ->ref, "a->__ptr", "a->__size", "\t");
+  }
+  else
+  {
+    fprintf(fout, "\n\tsize_t n;");
+    fprintf(fout, "\n\tif (soap_cbor_begin_in(soap, %s, &n))\n\t\treturn NULL;", typ->type == Ttemplate ? "SOAP_CBOR_ARRAY" : "SOAP_CBOR_MAP");
+    fprintf(fout, "\n\tif (!a)\n\t{\tif (!(a = soap_new_%s(soap, -1)))\n\t\t\treturn NULL;\n\t}\n\telse", ci);
+    if (typ->type == Tclass && !is_external(typ) && !is_volatile(typ) && !is_typedef(typ))
+      fprintf(fout, "\n\t\ta->soap_default(soap);");
+    else
+      fprintf(fout, "\n\t\tsoap_default_%s(soap, a);", ci);
+    if (typ->type == Ttemplate)
+    {
+      Tnode *ref = (Tnode*)typ->ref;
+      fprintf(fout, "\n\twhile (soap_cbor_next_in(soap, &n))\n\t{\t%s;", c_type_id(ref, "v"));
+      if (ref->type == Tpointer)
+        fprintf(fout, "\n\t\tv = NULL;");
+      else if (is_primitive(ref))
+        fprintf(fout, "\n\t\tsoap_default_%s(soap, &v);", c_ident(ref));
+      fprintf(fout, "\n\t\ta->push_back(v);\n\t\tif (!soap_in_cbor_%s(soap, &a->back()))\n\t\t\treturn NULL;\n\t}", c_ident(ref));
+    }
+    else
+    {
+      const char *s = "";
+      fprintf(fout, "\n\twhile (soap_cbor_next_in(soap, &n))\n\t{\tconst char *key = soap_cbor_key_in(soap);\n\t\tif (!key)\n\t\t\treturn NULL;\n\t\t");
+      for (t = (Table*)typ->ref; t; t = t->prev)
+      {
+        for (p = t->list; p; p = p->next)
+        {
+          int k = is_json_member(p);
+          if (k == 2)
+          {
+            const char *size = json_member(typ, t, p);
+            p = p->next;
+            fprintf(fout, "%sif (!strcmp(key, \"%s\"))", s, json_key(p));
+            cbor_array_in((Tnode*)p->info.typ->ref, json_member(typ, t, p), size, "\t\t");
+            s = "\n\t\telse ";
+          }
+          else if (is_repetition(p) || is_anytype(p) || is_choice(p))
+          {
+            p = p->next;
+          }
+          else if (k)
+          {
+            fprintf(fout, "%sif (!strcmp(key, \"%s\"))\n\t\t{\tif (!soap_in_cbor_%s(soap, &%s))\n\t\t\t\treturn NULL;\n\t\t}", s, json_key(p), c_ident(p->info.typ), json_member(typ, t, p));
+            s = "\n\t\telse ";
+          }
+        }
+      }
+      fprintf(fout, "%sif (soap_cbor_ignore_in(soap))\n\t\t\treturn NULL;\n\t}", s);
+    }
+    fprintf(fout, "\n\tif (soap->error)\n\t\treturn NULL;");
+  }
+  fprintf(fout, "\n\treturn a;\n}");
+  if (typ->type != Tpointer || is_string(typ))
+  {
+    fprintf(fhead, "\n\n#ifndef soap_read_cbor_%s\n#define soap_read_cbor_%s(soap, data) ( soap_begin_recv(soap) || !soap_in_cbor_%s(soap, (data)) || soap_end_recv(soap), (soap)->error )\n#endif\n", ci, ci, ci);
+    fprintf(fhead, "\n#ifndef soap_POST_recv_cbor_%s\n#define soap_POST_recv_cbor_%s(soap, data) ( soap_read_cbor_%s(soap, (data)) || soap_closesock(soap), (soap)->error )\n#endif\n", ci, ci, ci);
+  }
+}
+
 const char *
 cstring(const char *s, int q)
 {
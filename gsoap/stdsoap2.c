@@ -123,12 +123,43 @@ SOAP_SOURCE_STAMP("@(#) stdsoap2.c ver 2.8.131 2023-09-23 00:00:00 GMT")
 
 #define soap_coblank(c)         ((c)+1 > 0 && (c) <= 32)
 
+#ifndef WITH_LEAN
+/* binary XML tokens, bytes that cannot start an XML document */
+#define SOAP_BXML_END     (0xF0) /* end tag */
+#define SOAP_BXML_TEXT    (0xF1) /* text value: UTF-8 string */
+#define SOAP_BXML_INT     (0xF2) /* zigzag varint */
+#define SOAP_BXML_UINT    (0xF3) /* varint */
+#define SOAP_BXML_FLOAT   (0xF4) /* IEEE 754 single in network byte order */
+#define SOAP_BXML_DOUBLE  (0xF5) /* IEEE 754 double in network byte order */
+#define SOAP_BXML_BASE64  (0xF6) /* varint length and bytes of xsd:base64Binary content */
+#define SOAP_BXML_HEX     (0xF7) /* varint length and bytes of xsd:hexBinary content */
+#define SOAP_BXML_MARKUP  (0xF8) /* varint length and bytes of a comment, PI or DTD, verbatim */
+#define SOAP_BXML_ELT     (0xF9) /* start tag: name, followed by attributes and GT or EMPTY */
+#define SOAP_BXML_ATT     (0xFA) /* attribute: name and value */
+#define SOAP_BXML_GT      (0xFB) /* end of the start tag of an element with content */
+#define SOAP_BXML_EMPTY   (0xFC) /* end of the start tag of an empty element */
+
+/* a name is a varint index + 1 in the name table or 0 followed by the varint length and bytes of a new name, likewise a value */
+#define SOAP_BXML_MAXNUM  (1024) /* max number of strings in a name or value table */
+#define SOAP_BXML_MAXLEN  (64)   /* max length of a value in the value table */
+#define SOAP_BXML_HASHLEN (2048) /* size of the hash table of a name or value table, a power of 2 and at least 2 * SOAP_BXML_MAXNUM */
+
+#define SOAP_LONG64_MAX   ((LONG64)(~(ULONG64)0 >> 1))
+#define SOAP_LONG64_MIN   (-SOAP_LONG64_MAX - 1)
+#endif
+
 #if defined(WIN32) && !defined(UNDER_CE)
 #define soap_hash_ptr(p)        ((size_t)((PtrToUlong(p) >> 3) & (SOAP_PTRHASH - 1)))
 #else
 #define soap_hash_ptr(p)        ((size_t)(((unsigned long)(p) >> 3) & (SOAP_PTRHASH-1)))
 #endif
 
+/* soap_malloc() data is followed by its alist link: the next link, the data size, and the previous link's next field or &soap::alist */
+/* the back link for O(1) removal adds sizeof(void*) to every soap_malloc() cell */
+#define SOAP_ALIST_LEN          (2 * sizeof(void*) + sizeof(size_t))
+#define soap_alist_size(q)      (*(size_t*)((char*)(q) + sizeof(void*)))
+#define soap_alist_prev(q)      (*(void***)((char*)(q) + sizeof(void*) + sizeof(size_t)))
+
 #ifdef SOAP_DEBUG
 static void soap_init_logs(struct soap*);
 static void soap_close_logfile(struct soap*, int);
@@ -146,13 +177,14 @@ static int soap_copy_fault(struct soap*, const char*, const char*, const char*,
 static int soap_getattrval(struct soap*, char*, size_t*, soap_wchar);
 static void soap_version(struct soap*);
 static void soap_free_ns(struct soap*);
+static int soap_own_namespaces(struct soap*);
 static soap_wchar soap_char(struct soap*);
 static soap_wchar soap_getpi(struct soap*);
 static int soap_isxdigit(int);
 static void *fplugin(struct soap*, const char*);
 static ULONG64 soap_count_attachments(struct soap*);
 static int soap_try_connect_command(struct soap*, int http_command, const char *endpoint, const char *action);
-static int soap_init_send(struct soap*);
+static int soap_init_send(struct soap*, int msg);
 
 #ifdef WITH_NTLM
 static int soap_ntlm_handshake(struct soap *soap, int command, const char *endpoint, const char *host, int port);
@@ -164,9 +196,13 @@ static int soap_type_punned(struct soap*, const struct soap_ilist*);
 static int soap_is_shaky(struct soap*, void*);
 static void soap_init_iht(struct soap*);
 static void soap_free_iht(struct soap*);
+static int soap_resize_iht(struct soap*);
 #endif
 static void soap_init_pht(struct soap*);
 static void soap_free_pht(struct soap*);
+static int soap_resize_pht(struct soap*);
+static size_t soap_hash_id(const char*);
+static size_t soap_hash_key(const void*);
 
 #ifndef WITH_LEAN
 static const char *soap_set_validation_fault(struct soap*, const char*, const char*);
@@ -175,7 +211,54 @@ static struct soap_nlist *soap_push_ns(struct soap *soap, const char *id, const
 static void soap_utilize_ns(struct soap *soap, const char *tag, short isearly);
 static const wchar_t* soap_wstring(struct soap *soap, const char *s, int flag, long minlen, long maxlen, const char *pattern);
 static wchar_t* soap_wcollapse(struct soap *soap, wchar_t *s, int flag, int insitu);
-#endif
+static void *soap_arena_malloc(struct soap*, size_t);
+static int soap_free_arena(struct soap*);
+static int soap_in_arena(struct soap*, const void*);
+static void soap_init_lht(struct soap_lht*);
+static void soap_free_lht(struct soap*, struct soap_lht*);
+static int soap_enter_lht(struct soap*, struct soap_lht*, const void*, void*);
+static size_t soap_find_lht(const struct soap_lht*, const void*, const void*);
+static void soap_remove_lht(struct soap_lht*, size_t);
+static int soap_index_alist(struct soap*);
+static int soap_index_clist(struct soap*);
+static const void *soap_lazy_key(const void*);
+static void soap_lazy_drop(struct soap*, struct soap_lazy*);
+static void soap_lazy_move(struct soap*, const char*, const char*, size_t);
+#ifndef WITH_NOIO
+static struct soap_lazy *soap_lazy_find(const struct soap*, const void*);
+static void soap_lazy_merge(struct soap*, struct soap*);
+#endif
+static int soap_cbor_send_arg(struct soap*, int, ULONG64, size_t);
+static int soap_cbor_raw_in(struct soap*, ULONG64, int);
+static int soap_bxml_begin(struct soap*, struct soap_bxml**);
+static void soap_bxml_free(struct soap*, struct soap_bxml**);
+static int soap_bxml_copy(struct soap*, const struct soap*);
+static int soap_bxml_put(struct soap*, int);
+static int soap_bxml_put_num(struct soap*, int, ULONG64);
+static int soap_bxml_name_out(struct soap*, int, const char*, size_t);
+static int soap_bxml_string_out(struct soap*, const char*, int);
+static int soap_bxml_attribute_out(struct soap*, const char*, const char*, int);
+static int soap_bxml_bytes_out(struct soap*, int, const unsigned char*, int);
+static int soap_bxml_xml_out(struct soap*, const char*);
+static int soap_bxml_element_in(struct soap*);
+static int soap_bxml_end_in(struct soap*, int);
+static const char *soap_bxml_value(struct soap*);
+static char *soap_bxml_string_in(struct soap*, int, long, ULONG64*);
+static unsigned char *soap_bxml_bytes_in(struct soap*, int*, int);
+static int soap_bxml_integer_in(struct soap*, LONG64*, LONG64, LONG64);
+static int soap_bxml_unsigned_in(struct soap*, ULONG64*, ULONG64);
+static int soap_bxml_double_in(struct soap*, double*);
+static soap_wchar soap_bxml_peek(struct soap*);
+#endif
+static char *soap_alist_find(struct soap*, const void*);
+static void soap_alist_remove(struct soap*, char*);
+static int soap_release_item(struct soap*, const struct soap_imark*);
+static struct soap_clist *soap_clist_find(struct soap*, const void*);
+static void soap_clist_remove(struct soap*, struct soap_clist*);
+static void *soap_malloc_block(struct soap*, size_t);
+static void soap_free_block(struct soap*, void*);
+static int soap_resize_block(struct soap*, struct soap_blist*, size_t, size_t);
+static int soap_flush_block(struct soap*, struct soap_blist*);
 
 static const char* soap_string(struct soap *soap, const char *s, int flag, long minlen, long maxlen, const char *pattern);
 static char* soap_collapse(struct soap *soap, char *s, int flag, int insitu);
@@ -362,6 +445,15 @@ static const char soap_indent[41] = "\n                                       ";
 # define SOAP_CANARY (0xC0DE)
 #endif
 
+#ifndef WITH_LEAN
+# define SOAP_ARENA_ALIGN (2 * sizeof(size_t)) /* arena data alignment, same as malloc() */
+# define SOAP_ARENA_HDRLEN ((sizeof(struct soap_arena) + SOAP_ARENA_ALIGN - 1) & ~(SOAP_ARENA_ALIGN - 1))
+#endif
+
+#ifndef WITH_LEAN
+# define SOAP_TZ_NONE (0x7FFFFFFFL) /* soap::tz_offset value when no UTC offset is cached */
+#endif
+
 static const char soap_padding[4] = "\0\0\0";
 #define SOAP_STR_PADDING (soap_padding)
 #define SOAP_STR_EOS (soap_padding)
@@ -1002,6 +1094,20 @@ soap_send(struct soap *soap, const char *s)
 
 /******************************************************************************/
 
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_send_xml(struct soap *soap, const char *s)
+{
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_OUT))
+    return soap_bxml_xml_out(soap, s);
+#endif
+  return soap_send(soap, s);
+}
+
+/******************************************************************************/
+
 #ifndef WITH_LEANER
 SOAP_FMAC1
 int
@@ -1178,6 +1284,17 @@ frecv(struct soap *soap, char *s, size_t n)
   int retries = 100; /* max 100 retries with non-blocking sockets */
   SOAP_SOCKET sk;
   soap->errnum = 0;
+#ifndef WITH_LEAN
+  if (soap->isbuf) /* recv from in-situ buffer */
+  {
+    size_t l = soap->isidx < soap->islen ? soap->islen - soap->isidx : 0;
+    if (l > n)
+      l = n;
+    (void)soap_memcpy((void*)s, n, soap->isbuf + soap->isidx, l);
+    soap->isidx += l;
+    return l;
+  }
+#endif
 #if defined(__cplusplus) && !defined(WITH_COMPAT)
   if (soap->is) /* recv from C++ stream */
   {
@@ -1387,13 +1504,14 @@ static soap_wchar
 soap_getchunkchar(struct soap *soap)
 {
   if (soap->bufidx < soap->buflen)
-    return soap->buf[soap->bufidx++];
+    return soap->ibuf[soap->bufidx++];
+  soap->ibuf = soap->buf;
   soap->bufidx = 0;
   soap->buflen = soap->chunkbuflen = soap->frecv(soap, soap->buf, sizeof(soap->buf));
   DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Read %u bytes from socket=%d/fd=%d\n", (unsigned int)soap->buflen, (int)soap->socket, soap->recvfd));
   DBGMSG(RECV, soap->buf, soap->buflen);
   if (soap->buflen)
-    return soap->buf[soap->bufidx++];
+    return soap->ibuf[soap->bufidx++];
   return EOF;
 }
 #endif
@@ -1417,6 +1535,9 @@ soap_recv_raw(struct soap *soap)
 #if !defined(WITH_LEANER) || defined(WITH_ZLIB)
   int r;
 #endif
+#ifndef WITH_LEAN
+  soap->insitu = NULL;
+#endif
 #ifdef WITH_ZLIB
   if ((soap->mode & SOAP_ENC_ZLIB) && soap->d_stream)
   {
@@ -1428,6 +1549,7 @@ soap_recv_raw(struct soap *soap)
     if (soap->d_stream->avail_in || !soap->d_stream->avail_out)
     {
       DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Inflating\n"));
+      soap->ibuf = soap->buf;
       soap->d_stream->next_out = (Byte*)soap->buf;
       soap->d_stream->avail_out = sizeof(soap->buf);
       r = inflate(soap->d_stream, Z_NO_FLUSH);
@@ -1478,6 +1600,7 @@ zlib_again:
     if ((soap->mode & SOAP_IO) == SOAP_IO_CHUNK && !soap->chunksize)
     {
       (void)soap_memcpy((void*)soap->buf, sizeof(soap->buf), (const void*)soap->z_buf, sizeof(soap->buf));
+      soap->ibuf = soap->buf;
       soap->buflen = soap->z_buflen;
     }
     DBGLOG(RECV, SOAP_MESSAGE(fdebug, "\n---- compressed ----\n"));
@@ -1493,6 +1616,7 @@ zlib_again:
       unsigned long chunksize;
       if (soap->chunksize)
       {
+        soap->ibuf = soap->buf;
         soap->buflen = ret = soap->frecv(soap, soap->buf, soap->chunksize > sizeof(soap->buf) ? sizeof(soap->buf) : soap->chunksize);
         DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Getting chunk: read %u bytes\n", (unsigned int)ret));
         DBGMSG(RECV, soap->buf, ret);
@@ -1507,6 +1631,7 @@ zlib_again:
       }
       if (!soap->chunkbuflen)
       {
+        soap->ibuf = soap->buf;
         soap->chunkbuflen = ret = soap->frecv(soap, soap->buf, sizeof(soap->buf));
         DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Read %u bytes (chunked) from socket=%d\n", (unsigned int)ret, (int)soap->socket));
         DBGMSG(RECV, soap->buf, ret);
@@ -1582,9 +1707,29 @@ zlib_again:
 #endif
   {
     soap->bufidx = 0;
-    soap->buflen = ret = soap->frecv(soap, soap->buf, sizeof(soap->buf));
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+    if (soap->isbuf && soap->frecv == frecv && !(soap->mode & SOAP_ENC_ZLIB) && !soap->ffilterrecv)
+    {
+      /* read in-situ: point ibuf[] into isbuf[] instead of copying the next window to buf[] */
+      ret = soap->isidx < soap->islen ? soap->islen - soap->isidx : 0;
+      if (ret > sizeof(soap->buf))
+        ret = sizeof(soap->buf);
+      soap->ibuf = soap->insitu = soap->isbuf + soap->isidx;
+      soap->isidx += ret;
+      soap->buflen = ret;
+    }
+    else
+#endif
+    {
+      soap->ibuf = soap->buf;
+      soap->buflen = ret = soap->frecv(soap, soap->buf, sizeof(soap->buf));
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+      if (soap->isbuf && soap->frecv == frecv)
+        soap->insitu = soap->isbuf + soap->isidx - ret;
+#endif
+    }
     DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Read %u bytes from socket=%d/fd=%d\n", (unsigned int)ret, (int)soap->socket, soap->recvfd));
-    DBGMSG(RECV, soap->buf, ret);
+    DBGMSG(RECV, soap->ibuf, ret);
   }
 #ifdef WITH_ZLIB
   if ((soap->mode & SOAP_ENC_ZLIB) && soap->d_stream)
@@ -1639,7 +1784,7 @@ zlib_again:
 #ifdef WITH_ZLIB
    && soap->zlib_in == SOAP_ZLIB_NONE
 #endif
-   && (r = soap->fpreparerecv(soap, soap->buf + soap->bufidx, ret)))
+   && (r = soap->fpreparerecv(soap, soap->ibuf + soap->bufidx, ret)))
     return soap->error = r;
 #endif
   if (ret)
@@ -1657,6 +1802,83 @@ zlib_again:
 
 /******************************************************************************/
 
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_mmap(struct soap *soap, int fd)
+{
+#if defined(HAVE_MMAP) && !defined(WITH_NOIO)
+  struct stat sb;
+  void *p;
+  soap_munmap(soap);
+  soap->recvfd = fd;
+  soap->is = NULL;
+  if (fstat(fd, &sb) || !S_ISREG(sb.st_mode) || sb.st_size < 0 || (off_t)(size_t)sb.st_size != sb.st_size)
+  {
+    soap->errnum = soap_errno;
+    return soap->error = SOAP_EOF;
+  }
+  if (sb.st_size == 0)
+    return SOAP_OK; /* nothing to map, read from recvfd */
+  /* a read-only mapping: the parser reads it directly, string content is copied so no page is dirtied */
+  p = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (p == MAP_FAILED)
+  {
+    soap->errnum = soap_errno;
+    return soap->error = SOAP_EOF;
+  }
+#ifdef MADV_SEQUENTIAL
+  (void)madvise(p, (size_t)sb.st_size, MADV_SEQUENTIAL);
+#endif
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Mapped file fd=%d length=%lu\n", fd, (unsigned long)sb.st_size));
+  soap->mmapbuf = p;
+  soap->mmaplen = (size_t)sb.st_size;
+  soap->isbuf = (char*)p;
+  soap->islen = (size_t)sb.st_size;
+  soap->isidx = 0;
+  soap->isconst = 1;
+  return SOAP_OK;
+#else
+  soap->recvfd = fd; /* no mmap: read from recvfd instead */
+  soap->is = NULL;
+  return SOAP_OK;
+#endif
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+void
+SOAP_FMAC2
+soap_munmap(struct soap *soap)
+{
+#if defined(HAVE_MMAP) && !defined(WITH_NOIO)
+  if (soap->mmapbuf)
+  {
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Unmapped file length=%lu\n", (unsigned long)soap->mmaplen));
+    if (soap->isbuf == (char*)soap->mmapbuf)
+    {
+      soap->isbuf = NULL;
+      soap->islen = 0;
+      soap->isidx = 0;
+      soap->insitu = NULL;
+      soap->isconst = 0;
+      soap->ibuf = soap->buf;
+      soap->bufidx = soap->buflen = 0;
+    }
+    (void)munmap(soap->mmapbuf, soap->mmaplen);
+  }
+#endif
+  soap->mmapbuf = NULL;
+  soap->mmaplen = 0;
+}
+#endif
+
+/******************************************************************************/
+
 SOAP_FMAC1
 int
 SOAP_FMAC2
@@ -1688,7 +1910,7 @@ soap_recv(struct soap *soap)
       s = (char*)tmp;
       for (i = 12; i > 0; i--)
       {
-        *s++ = soap->buf[soap->bufidx++];
+        *s++ = soap->ibuf[soap->bufidx++];
         if (soap->bufidx >= soap->buflen)
           if (soap_recv_raw(soap))
             return EOF;
@@ -1757,6 +1979,7 @@ soap_recv(struct soap *soap)
     else
     {
       soap->bufidx = soap->buflen = 0;
+      soap->ibuf = soap->buf;
       err = soap->ffilterrecv(soap, soap->buf, &soap->buflen, sizeof(soap->buf));
       if (err)
       {
@@ -1983,7 +2206,7 @@ soap_char(struct soap *soap)
 soap_wchar
 soap_get0(struct soap *soap)
 {
-  return (soap->bufidx >= soap->buflen && soap_recv(soap)) ?  EOF : (unsigned char)soap->buf[soap->bufidx];
+  return (soap->bufidx >= soap->buflen && soap_recv(soap)) ?  EOF : (unsigned char)soap->ibuf[soap->bufidx];
 }
 #endif
 
@@ -1993,7 +2216,7 @@ soap_get0(struct soap *soap)
 soap_wchar
 soap_get1(struct soap *soap)
 {
-  return (soap->bufidx >= soap->buflen && soap_recv(soap)) ?  EOF : (unsigned char)soap->buf[soap->bufidx++];
+  return (soap->bufidx >= soap->buflen && soap_recv(soap)) ?  EOF : (unsigned char)soap->ibuf[soap->bufidx++];
 }
 #endif
 
@@ -2395,6 +2618,10 @@ soap_puthex(struct soap *soap, const unsigned char *s, int n)
       return soap->error;
     return SOAP_OK;
   }
+#endif
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_OUT))
+    return soap_bxml_bytes_out(soap, SOAP_BXML_HEX, s, n);
 #endif
   for (; n > 0; n--)
   {
@@ -2430,6 +2657,10 @@ soap_gethex(struct soap *soap, int *n)
     return (unsigned char*)soap_hex2s(soap, soap->dom->text, NULL, 0, n);
   }
 #endif
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_IN))
+    return soap_bxml_bytes_in(soap, n, 1);
+#endif
 #ifdef WITH_FAST
   soap->labidx = 0;
   for (;;)
@@ -2563,6 +2794,10 @@ soap_putbase64(struct soap *soap, const unsigned char *s, int n)
       return soap->error;
     return SOAP_OK;
   }
+#endif
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_OUT))
+    return soap_bxml_bytes_out(soap, SOAP_BXML_BASE64, s, n);
 #endif
   for (; n > 2; n -= 3, s += 3)
   {
@@ -2615,6 +2850,10 @@ soap_getbase64(struct soap *soap, int *n, int malloc_flag)
     return (unsigned char*)soap_base642s(soap, soap->dom->text, NULL, 0, n);
   }
 #endif
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_IN))
+    return soap_bxml_bytes_in(soap, n, 0);
+#endif
 #ifdef WITH_FAST
   soap->labidx = 0;
   for (;;)
@@ -2972,7 +3211,7 @@ soap_alloc_block(struct soap *soap)
 {
   struct soap_blist *p;
   DBGLOG(TEST, SOAP_MESSAGE(fdebug, "New block sequence (prev=%p)\n", (void*)soap->blist));
-  p = (struct soap_blist*)SOAP_MALLOC(soap, sizeof(struct soap_blist));
+  p = (struct soap_blist*)soap_malloc_block(soap, sizeof(struct soap_blist));
   if (!p)
   {
     soap->error = SOAP_EOM;
@@ -2982,6 +3221,9 @@ soap_alloc_block(struct soap *soap)
   p->head = NULL;
   p->size = 0;
   p->item = 0;
+  p->ptr = NULL;
+  p->room = 0;
+  p->unit = 0;
   soap->blist = p;
   return p;
 }
@@ -2996,6 +3238,8 @@ soap_push_block(struct soap *soap, struct soap_blist *b, size_t n)
   struct soap_bhead *p;
   if (!b)
     b = soap->blist;
+  if (b && b->ptr && soap_flush_block(soap, b))
+    return NULL;
   if (!b
    || b->size + n < b->size
    || sizeof(struct soap_bhead) + n < n
@@ -3004,7 +3248,7 @@ soap_push_block(struct soap *soap, struct soap_blist *b, size_t n)
     soap->error = SOAP_EOM;
     return NULL;
   }
-  p = (struct soap_bhead*)SOAP_MALLOC(soap, sizeof(struct soap_bhead) + n);
+  p = (struct soap_bhead*)soap_malloc_block(soap, sizeof(struct soap_bhead) + n);
   if (!p)
   {
     soap->error = SOAP_EOM;
@@ -3026,12 +3270,89 @@ void*
 SOAP_FMAC2
 soap_push_block_max(struct soap *soap, struct soap_blist *b, size_t n)
 {
+  char *s;
+  if (!b)
+    b = soap->blist;
   if (b && b->item >= soap->maxoccurs) /* restrict block array length */
   {
     soap->error = SOAP_OCCURS;
     return NULL;
   }
-  return soap_push_block(soap, b, n);
+  /* items of one size are stored contiguously in a soap_malloc() array that doubles in capacity when full */
+  if (!b || !n || b->head || (b->ptr && b->unit != n))
+    return soap_push_block(soap, b, n);
+  if (b->room < n)
+  {
+    size_t m;
+    if (b->ptr)
+      m = 2 * (b->size + b->room);
+    else if (n < SOAP_BLKLEN)
+      m = SOAP_BLKLEN - SOAP_BLKLEN % n;
+    else
+      m = n;
+    if (b->size + n < b->size || m < b->size + n)
+    {
+      soap->error = SOAP_EOM;
+      return NULL;
+    }
+    if (soap_resize_block(soap, b, m, n))
+      return NULL;
+  }
+  s = b->ptr + b->size;
+  b->size += n;
+  b->room -= n;
+  b->item++;
+  return (void*)s;
+}
+
+/******************************************************************************/
+
+static int
+soap_resize_block(struct soap *soap, struct soap_blist *b, size_t m, size_t n)
+{
+  char *p = (char*)soap_malloc(soap, m);
+  if (!p)
+    return soap->error = SOAP_EOM;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Resize block array %p of %lu items (%lu bytes) to %p of %lu bytes\n", (void*)b->ptr, (unsigned long)b->item, (unsigned long)b->size, (void*)p, (unsigned long)m));
+  if (b->ptr)
+  {
+    if (b->size)
+    {
+      soap_update_pointers(soap, p, b->ptr, b->size);
+      (void)soap_memcpy((void*)p, m, (const void*)b->ptr, b->size);
+    }
+    soap_dealloc(soap, b->ptr);
+  }
+  b->ptr = p;
+  b->room = m - b->size;
+  b->unit = n;
+  return SOAP_OK;
+}
+
+/******************************************************************************/
+
+/* moves the items stored contiguously by soap_push_block_max() to a block */
+static int
+soap_flush_block(struct soap *soap, struct soap_blist *b)
+{
+  char *s = b->ptr;
+  size_t n = b->size, i = b->item;
+  b->ptr = NULL;
+  b->room = 0;
+  b->unit = 0;
+  if (n)
+  {
+    char *p;
+    b->size = 0;
+    p = (char*)soap_push_block(soap, b, n);
+    if (!p)
+      return soap->error;
+    b->item = i;
+    soap_update_pointers(soap, p, s, n);
+    (void)soap_memcpy((void*)p, n, (const void*)s, n);
+  }
+  soap_dealloc(soap, s);
+  return SOAP_OK;
 }
 
 /******************************************************************************/
@@ -3044,14 +3365,28 @@ soap_pop_block(struct soap *soap, struct soap_blist *b)
   struct soap_bhead *p;
   if (!b)
     b = soap->blist;
-  if (!b || !b->head)
+  if (!b)
+    return;
+  if (b->ptr)
+  {
+    /* pop the last item stored by soap_push_block_max() */
+    if (b->size >= b->unit && b->item)
+    {
+      b->size -= b->unit;
+      b->room += b->unit;
+      b->item--;
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Pop item from block array %p (%lu items of %lu bytes total)\n", (void*)b->ptr, (unsigned long)b->item, (unsigned long)b->size));
+    }
+    return;
+  }
+  if (!b->head)
     return;
   p = b->head;
   b->size -= p->size;
   b->head = p->next;
   b->item--;
   DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Pop block %p (%lu items of %lu bytes total)\n", (void*)p, (unsigned long)b->item, (unsigned long)b->size));
-  SOAP_FREE(soap, p);
+  soap_free_block(soap, p);
 }
 
 /******************************************************************************/
@@ -3068,55 +3403,51 @@ soap_update_pointers(struct soap *soap, const char *dst, const char *src, size_t
 #ifndef WITH_NOIDREF
   if ((soap->version && !(soap->imode & SOAP_XML_TREE)) || (soap->mode & SOAP_XML_GRAPH))
   {
-    int i;
+    struct soap_ilist *ip;
     DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Update pointers %p (%lu bytes) -> %p\n", (void*)src, (unsigned long)len, (void*)dst));
-    for (i = 0; i < SOAP_IDHASH; i++)
+    for (ip = soap->ilist; ip; ip = ip->next)
     {
-      struct soap_ilist *ip;
-      for (ip = soap->iht[i]; ip; ip = ip->next)
+      struct soap_flist *fp;
+      void *p, **q;
+      if (ip->shaky)
       {
-        struct soap_flist *fp;
-        void *p, **q;
-        if (ip->shaky)
+        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Update shaky id='%s'\n", ip->id));
+        if (ip->ptr && ip->ptr >= start && ip->ptr < end)
         {
-          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Update shaky id='%s'\n", ip->id));
-          if (ip->ptr && ip->ptr >= start && ip->ptr < end)
-          {
-            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Update ptr %p -> %p\n", ip->ptr, (void*)((const char*)ip->ptr + (dst-src))));
-            ip->ptr = (void*)((const char*)ip->ptr + (dst-src));
-          }
-          for (q = &ip->link; q; q = (void**)p)
-          {
-            p = *q;
-            if (p && p >= start && p < end)
-            {
-              DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Link update id='%s' %p -> %p\n", ip->id, p, (void*)((const char*)p + (dst-src))));
-              *q = (void*)((const char*)p + (dst-src));
-            }
-          }
-          for (q = &ip->copy; q; q = (void**)p)
+          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Update ptr %p -> %p\n", ip->ptr, (void*)((const char*)ip->ptr + (dst-src))));
+          ip->ptr = (void*)((const char*)ip->ptr + (dst-src));
+        }
+        for (q = &ip->link; q; q = (void**)p)
+        {
+          p = *q;
+          if (p && p >= start && p < end)
           {
-            p = *q;
-            if (p && p >= start && p < end)
-            {
-              DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Copy chain update id='%s' %p -> %p\n", ip->id, p, (void*)((const char*)p + (dst-src))));
-              *q = (void*)((const char*)p + (dst-src));
-            }
+            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Link update id='%s' %p -> %p\n", ip->id, p, (void*)((const char*)p + (dst-src))));
+            *q = (void*)((const char*)p + (dst-src));
           }
-          for (fp = ip->flist; fp; fp = fp->next)
+        }
+        for (q = &ip->copy; q; q = (void**)p)
+        {
+          p = *q;
+          if (p && p >= start && p < end)
           {
-            if (fp->ptr >= start && fp->ptr < end)
-            {
-              DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Copy list update id='%s' target type=%d %p -> %p\n", ip->id, fp->type, fp->ptr, (void*)((char*)fp->ptr + (dst-src))));
-              fp->ptr = (void*)((const char*)fp->ptr + (dst-src));
-            }
+            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Copy chain update id='%s' %p -> %p\n", ip->id, p, (void*)((const char*)p + (dst-src))));
+            *q = (void*)((const char*)p + (dst-src));
           }
-          if (ip->smart && ip->smart >= start && ip->smart < end)
+        }
+        for (fp = ip->flist; fp; fp = fp->next)
+        {
+          if (fp->ptr >= start && fp->ptr < end)
           {
-            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Smart shared pointer update %p -> %p\n", ip->smart, (void*)((const char*)ip->smart + (dst-src))));
-            ip->smart = (void*)((const char*)ip->smart + (dst-src));
+            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Copy list update id='%s' target type=%d %p -> %p\n", ip->id, fp->type, fp->ptr, (void*)((char*)fp->ptr + (dst-src))));
+            fp->ptr = (void*)((const char*)fp->ptr + (dst-src));
           }
         }
+        if (ip->smart && ip->smart >= start && ip->smart < end)
+        {
+          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Smart shared pointer update %p -> %p\n", ip->smart, (void*)((const char*)ip->smart + (dst-src))));
+          ip->smart = (void*)((const char*)ip->smart + (dst-src));
+        }
       }
     }
   }
@@ -3136,6 +3467,9 @@ soap_update_pointers(struct soap *soap, const char *dst, const char *src, size_t
     }
   }
 #endif
+#ifndef WITH_LEAN
+  soap_lazy_move(soap, dst, src, len);
+#endif
 }
 
 /******************************************************************************/
@@ -3144,21 +3478,17 @@ soap_update_pointers(struct soap *soap, const char *dst, const char *src, size_t
 static int
 soap_has_copies(struct soap *soap, const char *start, const char *end)
 {
-  int i;
   struct soap_ilist *ip = NULL;
   struct soap_flist *fp = NULL;
   const char *p;
-  for (i = 0; i < SOAP_IDHASH; i++)
+  for (ip = soap->ilist; ip; ip = ip->next)
   {
-    for (ip = soap->iht[i]; ip; ip = ip->next)
-    {
-      for (p = (const char*)ip->copy; p; p = *(const char**)p)
-        if (p >= start && p < end)
-          return SOAP_ERR;
-      for (fp = ip->flist; fp; fp = fp->next)
-        if (fp->type == ip->type && (const char*)fp->ptr >= start && (const char*)fp->ptr < end)
-          return SOAP_ERR;
-    }
+    for (p = (const char*)ip->copy; p; p = *(const char**)p)
+      if (p >= start && p < end)
+        return SOAP_ERR;
+    for (fp = ip->flist; fp; fp = fp->next)
+      if (fp->type == ip->type && (const char*)fp->ptr >= start && (const char*)fp->ptr < end)
+        return SOAP_ERR;
   }
   return SOAP_OK;
 }
@@ -3172,64 +3502,60 @@ int
 SOAP_FMAC2
 soap_resolve(struct soap *soap)
 {
-  int i;
+  struct soap_ilist *ip;
   short flag;
   const char *id;
   DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Resolving forwarded refs\n"));
-  for (i = 0; i < SOAP_IDHASH; i++)
+  for (ip = soap->ilist; ip; ip = ip->next)
   {
-    struct soap_ilist *ip;
-    for (ip = soap->iht[i]; ip; ip = ip->next)
-    {
-      if (ip->ptr)
-      {
-        void **q;
-        struct soap_flist *fp, **fpp = &ip->flist;
-        if (ip->spine)
-          ip->spine[0] = ip->ptr;
-        q = (void**)ip->link;
-        ip->link = NULL;
-        DBGLOG(TEST, if (q) SOAP_MESSAGE(fdebug, "Traversing link chain to resolve id='%s' type=%d\n", ip->id, ip->type));
-        while (q)
-        {
-          void *p = *q;
-          *q = ip->ptr;
-          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "... link %p -> %p\n", (void*)q, ip->ptr));
-          q = (void**)p;
-        }
-        while ((fp = *fpp))
+    if (ip->ptr)
+    {
+      void **q;
+      struct soap_flist *fp, **fpp = &ip->flist;
+      if (ip->spine)
+        ip->spine[0] = ip->ptr;
+      q = (void**)ip->link;
+      ip->link = NULL;
+      DBGLOG(TEST, if (q) SOAP_MESSAGE(fdebug, "Traversing link chain to resolve id='%s' type=%d\n", ip->id, ip->type));
+      while (q)
+      {
+        void *p = *q;
+        *q = ip->ptr;
+        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "... link %p -> %p\n", (void*)q, ip->ptr));
+        q = (void**)p;
+      }
+      while ((fp = *fpp))
+      {
+        if (fp->level > 0 && fp->finsert)
         {
-          if (fp->level > 0 && fp->finsert)
+          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "... insert type=%d link %p -> %p\n", fp->type, fp->ptr, ip->ptr));
+          if (ip->spine && fp->level <= SOAP_MAXPTRS)
+            fp->finsert(soap, ip->type, fp->type, fp->ptr, fp->index, &ip->spine[fp->level - 1], &ip->smart);
+          else if (fp->level == 1)
+            fp->finsert(soap, ip->type, fp->type, fp->ptr, fp->index, &ip->ptr, &ip->smart);
+          else if (fp->level <= SOAP_MAXPTRS)
           {
-            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "... insert type=%d link %p -> %p\n", fp->type, fp->ptr, ip->ptr));
-            if (ip->spine && fp->level <= SOAP_MAXPTRS)
-              fp->finsert(soap, ip->type, fp->type, fp->ptr, fp->index, &ip->spine[fp->level - 1], &ip->smart);
-            else if (fp->level == 1)
-              fp->finsert(soap, ip->type, fp->type, fp->ptr, fp->index, &ip->ptr, &ip->smart);
-            else if (fp->level <= SOAP_MAXPTRS)
-            {
-              int i;
-              ip->spine = (void**)soap_malloc(soap, SOAP_MAXPTRS * sizeof(void*));
-              if (!ip->spine)
-                return soap->error = SOAP_EOM;
-              ip->spine[0] = ip->ptr;
-              for (i = 1; i < SOAP_MAXPTRS; i++)
-                ip->spine[i] = &ip->spine[i - 1];
-              fp->finsert(soap, ip->type, fp->type, fp->ptr, fp->index, &ip->spine[fp->level - 1], &ip->smart);
-            }
-            *fpp = fp->next;
-            SOAP_FREE(soap, fp);
+            int i;
+            ip->spine = (void**)soap_malloc(soap, SOAP_MAXPTRS * sizeof(void*));
+            if (!ip->spine)
+              return soap->error = SOAP_EOM;
+            ip->spine[0] = ip->ptr;
+            for (i = 1; i < SOAP_MAXPTRS; i++)
+              ip->spine[i] = &ip->spine[i - 1];
+            fp->finsert(soap, ip->type, fp->type, fp->ptr, fp->index, &ip->spine[fp->level - 1], &ip->smart);
           }
-          else
-            fpp = &fp->next;
+          *fpp = fp->next;
+          SOAP_FREE(soap, fp);
         }
+        else
+          fpp = &fp->next;
       }
-      else if (*ip->id == '#')
-      {
-        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Missing id='%s'\n", ip->id));
-        soap_strcpy(soap->id, sizeof(soap->id), ip->id + 1);
-        return soap->error = SOAP_MISSING_ID;
-      }
+    }
+    else if (*ip->id == '#')
+    {
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Missing id='%s'\n", ip->id));
+      soap_strcpy(soap->id, sizeof(soap->id), ip->id + 1);
+      return soap->error = SOAP_MISSING_ID;
     }
   }
   do
@@ -3237,50 +3563,46 @@ soap_resolve(struct soap *soap)
     flag = 0;
     id = NULL;
     DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Resolution phase\n"));
-    for (i = 0; i < SOAP_IDHASH; i++)
+    for (ip = soap->ilist; ip; ip = ip->next)
     {
-      struct soap_ilist *ip;
-      for (ip = soap->iht[i]; ip; ip = ip->next)
+      if (ip->copy || ip->flist)
       {
-        if (ip->copy || ip->flist)
+        if (ip->ptr && !soap_has_copies(soap, (const char*)ip->ptr, (const char*)ip->ptr + ip->size))
         {
-          if (ip->ptr && !soap_has_copies(soap, (const char*)ip->ptr, (const char*)ip->ptr + ip->size))
+          struct soap_flist *fp;
+          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Resolving id='%s' type=%d ptr=%p size=%lu ...\n", ip->id, ip->type, ip->ptr, (unsigned long)ip->size));
+          if (ip->copy)
           {
-            struct soap_flist *fp;
-            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Resolving id='%s' type=%d ptr=%p size=%lu ...\n", ip->id, ip->type, ip->ptr, (unsigned long)ip->size));
-            if (ip->copy)
+            void *p, **q = (void**)ip->copy;
+            DBGLOG(TEST, if (q) SOAP_MESSAGE(fdebug, "Traversing copy chain to resolve id='%s'\n", ip->id));
+            ip->copy = NULL;
+            do
             {
-              void *p, **q = (void**)ip->copy;
-              DBGLOG(TEST, if (q) SOAP_MESSAGE(fdebug, "Traversing copy chain to resolve id='%s'\n", ip->id));
-              ip->copy = NULL;
-              do
-              {
-                DBGLOG(TEST, SOAP_MESSAGE(fdebug, "... copy %p -> %p (%u bytes)\n", ip->ptr, (void*)q, (unsigned int)ip->size));
-                p = *q;
-                (void)soap_memcpy((void*)q, ip->size, (const void*)ip->ptr, ip->size);
-                q = (void**)p;
-              } while (q);
-              flag = 1;
-            }
-            while ((fp = ip->flist))
+              DBGLOG(TEST, SOAP_MESSAGE(fdebug, "... copy %p -> %p (%u bytes)\n", ip->ptr, (void*)q, (unsigned int)ip->size));
+              p = *q;
+              (void)soap_memcpy((void*)q, ip->size, (const void*)ip->ptr, ip->size);
+              q = (void**)p;
+            } while (q);
+            flag = 1;
+          }
+          while ((fp = ip->flist))
+          {
+            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Resolving forwarded data type=%d target type=%d location=%p level=%u id='%s'\n", ip->type, fp->type, ip->ptr, fp->level, ip->id));
+            if (fp->level == 0)
             {
-              DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Resolving forwarded data type=%d target type=%d location=%p level=%u id='%s'\n", ip->type, fp->type, ip->ptr, fp->level, ip->id));
-              if (fp->level == 0)
-              {
-                DBGLOG(TEST, SOAP_MESSAGE(fdebug, "... copy %p -> %p (%lu bytes)\n", ip->ptr, fp->ptr, (unsigned long)ip->size));
-                if (fp->finsert)
-                  fp->finsert(soap, ip->type, fp->type, fp->ptr, fp->index, ip->ptr, &ip->smart);
-                else
-                  (void)soap_memcpy((void*)fp->ptr, ip->size, (const void*)ip->ptr, ip->size);
-              }
-              ip->flist = fp->next;
-              SOAP_FREE(soap, fp);
-              flag = 1;
+              DBGLOG(TEST, SOAP_MESSAGE(fdebug, "... copy %p -> %p (%lu bytes)\n", ip->ptr, fp->ptr, (unsigned long)ip->size));
+              if (fp->finsert)
+                fp->finsert(soap, ip->type, fp->type, fp->ptr, fp->index, ip->ptr, &ip->smart);
+              else
+                (void)soap_memcpy((void*)fp->ptr, ip->size, (const void*)ip->ptr, ip->size);
             }
+            ip->flist = fp->next;
+            SOAP_FREE(soap, fp);
+            flag = 1;
           }
-          else if (*ip->id == '#')
-            id = ip->id;
         }
+        else if (*ip->id == '#')
+          id = ip->id;
       }
     }
   } while (flag);
@@ -3321,6 +3643,8 @@ soap_first_block(struct soap *soap, struct soap_blist *b)
   struct soap_bhead *p, *q, *r;
   if (!b)
     b = soap->blist;
+  if (b->ptr && soap_flush_block(soap, b))
+    return NULL;
   p = b->head;
   if (!p)
     return NULL;
@@ -3352,7 +3676,7 @@ soap_next_block(struct soap *soap, struct soap_blist *b)
   {
     b->head = p->next;
     DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Next block %p, deleting current block\n", (void*)(b->head ? b->head + 1 : NULL)));
-    SOAP_FREE(soap, p);
+    soap_free_block(soap, p);
     if (b->head)
       return (char*)(b->head + 1);
   }
@@ -3384,10 +3708,12 @@ soap_end_block(struct soap *soap, struct soap_blist *b)
   if (b)
   {
     DBGLOG(TEST, SOAP_MESSAGE(fdebug, "End of block sequence, free all remaining blocks\n"));
+    if (b->ptr)
+      soap_dealloc(soap, b->ptr);
     for (p = b->head; p; p = q)
     {
       q = p->next;
-      SOAP_FREE(soap, p);
+      soap_free_block(soap, p);
     }
     if (soap->blist == b)
       soap->blist = b->next;
@@ -3403,17 +3729,15 @@ soap_end_block(struct soap *soap, struct soap_blist *b)
         }
       }
     }
-    SOAP_FREE(soap, b);
+    soap_free_block(soap, b);
   }
   DBGLOG(TEST, if (soap->blist) SOAP_MESSAGE(fdebug, "Restored previous block sequence\n"));
 #ifndef WITH_NOIDREF
   if (!soap->blist && ((soap->version && !(soap->imode & SOAP_XML_TREE)) || (soap->mode & SOAP_XML_GRAPH)))
   {
-    int i;
-    struct soap_ilist *ip = NULL;
-    for (i = 0; i < SOAP_IDHASH; i++)
-      for (ip = soap->iht[i]; ip; ip = ip->next)
-        ip->shaky = 0;
+    struct soap_ilist *ip;
+    for (ip = soap->ilist; ip; ip = ip->next)
+      ip->shaky = 0;
   }
 #endif
 }
@@ -3429,7 +3753,34 @@ soap_save_block(struct soap *soap, struct soap_blist *b, char *p, int flag)
   char *q, *s;
   if (!b)
     b = soap->blist;
-  if (b->size)
+  if (b->ptr && b->size)
+  {
+    /* items stored contiguously by soap_push_block_max() are handed over without copying, or copied once */
+    if (!p && b->room <= b->size)
+    {
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Save block array %p of %lu items (%lu bytes)\n", (void*)b->ptr, (unsigned long)b->item, (unsigned long)b->size));
+      p = b->ptr;
+      b->ptr = NULL;
+    }
+    else
+    {
+      /* an array that is more than half unused is trimmed to its items */
+      if (!p)
+      {
+        p = (char*)soap_malloc(soap, b->size);
+        if (!p)
+        {
+          soap->error = SOAP_EOM;
+          soap_end_block(soap, b);
+          return NULL;
+        }
+      }
+      if (flag)
+        soap_update_pointers(soap, p, b->ptr, b->size);
+      (void)soap_memcpy((void*)p, b->size, (const void*)b->ptr, b->size);
+    }
+  }
+  else if (b->size)
   {
     if (!p)
       p = (char*)soap_malloc(soap, b->size);
@@ -3621,13 +3972,18 @@ soap_push_namespace(struct soap *soap, const char *id, const char *ns)
   struct soap_nlist *np = NULL;
   struct Namespace *p;
   short i = -1;
-  size_t n, k;
+  size_t n, k, h;
   n = strlen(id);
   k = strlen(ns) + 1;
   p = soap->local_namespaces;
   if (p)
   {
-    for (i = 0; p->id; p++, i++)
+    /* check the namespace URI hash table first, then search the table */
+    h = soap_hash(ns) % SOAP_NSHASH;
+    i = soap->nsht[h] - 1;
+    if (i >= 0 && ((p[i].ns && !strcmp(ns, p[i].ns)) || (p[i].out && !strcmp(ns, p[i].out))))
+      p += i;
+    else for (i = 0; p->id; p++, i++)
     {
       if (p->ns && !strcmp(ns, p->ns))
         break;
@@ -3640,6 +3996,12 @@ soap_push_namespace(struct soap *soap, const char *id, const char *ns)
       {
         if (!soap_tag_cmp(ns, p->in))
         {
+          if (soap->nsshared)
+          {
+            if (soap_own_namespaces(soap))
+              break;
+            p = soap->local_namespaces + i;
+          }
           if (SOAP_MAXALLOCSIZE <= 0 || k <= SOAP_MAXALLOCSIZE)
             p->out = (char*)SOAP_MALLOC(soap, k);
           if (p->out)
@@ -3650,6 +4012,8 @@ soap_push_namespace(struct soap *soap, const char *id, const char *ns)
     }
     if (!p->id)
       i = -1;
+    else
+      soap->nsht[h] = i + 1;
   }
   if (i >= 0)
     k = 0;
@@ -3662,6 +4026,7 @@ soap_push_namespace(struct soap *soap, const char *id, const char *ns)
   }
   np->next = soap->nlist;
   soap->nlist = np;
+  soap->nmatch = NULL;
   np->level = soap->level;
   np->index = i;
   soap_strcpy((char*)np->id, n + 1, id);
@@ -3695,6 +4060,7 @@ soap_pop_namespace(struct soap *soap)
     SOAP_FREE(soap, np);
   }
   soap->nlist = np;
+  soap->nmatch = NULL;
 }
 
 /******************************************************************************/
@@ -3704,12 +4070,18 @@ int
 SOAP_FMAC2
 soap_match_namespace(struct soap *soap, const char *id1, const char *id2, size_t n1, size_t n2)
 {
-  struct soap_nlist *np = soap->nlist;
+  struct soap_nlist *np = soap->nmatch;
   const char *s;
-  while (np && (strncmp(np->id, id1, n1) || np->id[n1]))
-    np = np->next;
+  /* check the binding found last, which is valid until the namespace stack changes */
+  if (!np || strncmp(np->id, id1, n1) || np->id[n1])
+  {
+    np = soap->nlist;
+    while (np && (strncmp(np->id, id1, n1) || np->id[n1]))
+      np = np->next;
+  }
   if (np)
   {
+    soap->nmatch = np;
     if (!(soap->mode & SOAP_XML_IGNORENS) && (n2 > 0 || !np->ns || *np->ns))
     {
       if (np->index < 0
@@ -6227,7 +6599,7 @@ again:
         return soap->socket = SOAP_INVALID_SOCKET;
       }
 #endif
-      if (soap_init_send(soap))
+      if (soap_init_send(soap, 0))
       {
         (void)soap->fclosesocket(soap, sk);
         return soap->socket = SOAP_INVALID_SOCKET;
@@ -6261,7 +6633,7 @@ again:
       soap->http_content = http_content; /* restore */
       soap->http_extra_header = http_extra_header; /* restore */
       soap->bearer = bearer; /* restore */
-      if (soap_init_send(soap))
+      if (soap_init_send(soap, 0))
       {
         (void)soap->fclosesocket(soap, sk);
         return soap->socket = SOAP_INVALID_SOCKET;
@@ -7830,6 +8202,30 @@ soap_done(struct soap *soap)
     DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Warning: managed C data was not deallocated with soap_end() from the heap managed by context %p\n", (void*)soap));
 #endif
   soap->alist = NULL;
+  soap->arena = NULL;
+#ifndef WITH_NOIDREF
+  if (soap->iht)
+    SOAP_FREE(soap, soap->iht);
+  soap->iht = NULL;
+  soap->ihtsize = 0;
+#endif
+  if (soap->pht)
+    SOAP_FREE(soap, soap->pht);
+  soap->pht = NULL;
+  soap->phtsize = 0;
+#ifndef WITH_LEAN
+  soap_munmap(soap);
+  soap_free_lht(soap, &soap->aht);
+  soap_free_lht(soap, &soap->cht);
+  soap_bxml_free(soap, &soap->bxml_in);
+  soap_bxml_free(soap, &soap->bxml_out);
+  while (soap->arenafree)
+  {
+    struct soap_arena *ap = soap->arenafree->next;
+    SOAP_FREE(soap, soap->arenafree);
+    soap->arenafree = ap;
+  }
+#endif
   while (soap->clist)
   {
     struct soap_clist *p = soap->clist->next;
@@ -7907,6 +8303,9 @@ soap_done(struct soap *soap)
 #endif
   soap->fseterror = NULL;
   soap->fignore = NULL;
+  soap->fitemin = NULL;
+  soap->fitemout = NULL;
+  soap->fparallel = NULL;
   soap->fencoding = NULL;
   soap->fserveloop = NULL;
 #ifdef WITH_OPENSSL
@@ -8936,7 +9335,7 @@ soap_response(struct soap *soap, int status)
     soap->omode = (soap->omode & ~SOAP_IO) | SOAP_IO_STORE;
   soap->status = status;
   count = soap_count_attachments(soap);
-  if (soap_init_send(soap))
+  if (soap_init_send(soap, 1))
     return soap->error;
 #ifndef WITH_NOHTTP
   if ((soap->mode & SOAP_IO) != SOAP_IO_STORE && !(soap->mode & SOAP_ENC_PLAIN))
@@ -10084,11 +10483,33 @@ SOAP_FMAC1
 size_t
 SOAP_FMAC2
 soap_hash(const char *s)
+{
+  return soap_hash_id(s) % SOAP_IDHASH;
+}
+
+/******************************************************************************/
+
+static size_t
+soap_hash_id(const char *s)
 {
   size_t h = 0;
   while (*s)
     h = *s++ + (h << 6) + (h << 16) - h; /* Red Dragon book h = 65599*h + c */
-  return h % SOAP_IDHASH;
+  return h;
+}
+
+/******************************************************************************/
+
+static size_t
+soap_hash_key(const void *p)
+{
+#if defined(WIN32) && !defined(UNDER_CE)
+  size_t h = (size_t)(PtrToUlong(p) >> 3);
+#else
+  size_t h = (size_t)((unsigned long)p >> 3);
+#endif
+  h *= 2654435761U; /* Knuth's multiplicative hash spreads aligned pointers over the table */
+  return h ^ (h >> 16);
 }
 
 /******************************************************************************/
@@ -10096,11 +10517,11 @@ soap_hash(const char *s)
 static void
 soap_init_pht(struct soap *soap)
 {
-  int i;
   soap->pblk = NULL;
   soap->pidx = 0;
-  for (i = 0; i < (int)SOAP_PTRHASH; i++)
-    soap->pht[i] = NULL;
+  soap->pht = NULL;
+  soap->phtsize = 0;
+  soap->phtnum = 0;
 }
 
 /******************************************************************************/
@@ -10152,7 +10573,6 @@ static void
 soap_free_pht(struct soap *soap)
 {
   struct soap_pblk *pb, *next;
-  int i;
   DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Free pointer hashtable\n"));
   for (pb = soap->pblk; pb; pb = next)
   {
@@ -10161,19 +10581,58 @@ soap_free_pht(struct soap *soap)
   }
   soap->pblk = NULL;
   soap->pidx = 0;
-  for (i = 0; i < (int)SOAP_PTRHASH; i++)
-    soap->pht[i] = NULL;
+  if (soap->phtsize > SOAP_PTRHASH) /* release a table grown by a large message */
+  {
+    SOAP_FREE(soap, soap->pht);
+    soap->pht = NULL;
+    soap->phtsize = 0;
+  }
+  else if (soap->phtnum)
+    memset((void*)soap->pht, 0, soap->phtsize * sizeof(struct soap_plist*));
+  soap->phtnum = 0;
 }
 
 /******************************************************************************/
 
-#ifndef WITH_NOIDREF
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_embed(struct soap *soap, const void *p, const void *a, int n, int t)
+static int
+soap_resize_pht(struct soap *soap)
 {
-  int id;
+  struct soap_plist **pht;
+  size_t i, n = soap->phtsize ? 2 * soap->phtsize : SOAP_PTRHASH;
+  if (n < soap->phtsize || n > (~(size_t)0) / sizeof(struct soap_plist*) || (SOAP_MAXALLOCSIZE > 0 && n * sizeof(struct soap_plist*) > SOAP_MAXALLOCSIZE))
+    return soap->error = SOAP_EOM;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Resize pointer hashtable to %lu entries\n", (unsigned long)n));
+  pht = (struct soap_plist**)SOAP_MALLOC(soap, n * sizeof(struct soap_plist*));
+  if (!pht)
+    return soap->error = SOAP_EOM;
+  memset((void*)pht, 0, n * sizeof(struct soap_plist*));
+  for (i = 0; i < soap->phtsize; i++)
+  {
+    struct soap_plist *pp = soap->pht[i];
+    if (pp)
+    {
+      size_t h = soap_hash_key(pp->array ? pp->array : pp->ptr) & (n - 1);
+      while (pht[h])
+        h = (h + 1) & (n - 1);
+      pht[h] = pp;
+    }
+  }
+  if (soap->pht)
+    SOAP_FREE(soap, soap->pht);
+  soap->pht = pht;
+  soap->phtsize = n;
+  return SOAP_OK;
+}
+
+/******************************************************************************/
+
+#ifndef WITH_NOIDREF
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_embed(struct soap *soap, const void *p, const void *a, int n, int t)
+{
+  int id;
   struct soap_plist *pp;
   if (soap->version == 2)
     soap->encoding = 1;
@@ -10202,9 +10661,10 @@ soap_pointer_lookup(struct soap *soap, const void *p, int type, struct soap_plis
 {
   struct soap_plist *pp;
   *ppp = NULL;
-  if (p)
+  if (p && soap->phtnum)
   {
-    for (pp = soap->pht[soap_hash_ptr(p)]; pp; pp = pp->next)
+    size_t h = soap_hash_key(p) & (soap->phtsize - 1);
+    while ((pp = soap->pht[h]))
     {
       if (pp->ptr == p && pp->type == type)
       {
@@ -10212,6 +10672,7 @@ soap_pointer_lookup(struct soap *soap, const void *p, int type, struct soap_plis
         DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Lookup location=%p type=%d id=%d\n", p, type, pp->id));
         return pp->id;
       }
+      h = (h + 1) & (soap->phtsize - 1);
     }
   }
   DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Lookup location=%p type=%d: not found\n", p, type));
@@ -10228,6 +10689,8 @@ soap_pointer_enter(struct soap *soap, const void *p, const void *a, int n, int t
   size_t h;
   struct soap_plist *pp;
   (void)n;
+  if (2 * (soap->phtnum + 1) > soap->phtsize && soap_resize_pht(soap))
+    return 0;
   if (!soap->pblk || soap->pidx >= SOAP_PTRBLK)
   {
     struct soap_pblk *pb = (struct soap_pblk*)SOAP_MALLOC(soap, sizeof(struct soap_pblk));
@@ -10242,11 +10705,13 @@ soap_pointer_enter(struct soap *soap, const void *p, const void *a, int n, int t
   }
   *ppp = pp = &soap->pblk->plist[soap->pidx++];
   if (a)
-    h = soap_hash_ptr(a);
+    h = soap_hash_key(a);
   else
-    h = soap_hash_ptr(p);
+    h = soap_hash_key(p);
+  h &= soap->phtsize - 1;
+  while (soap->pht[h])
+    h = (h + 1) & (soap->phtsize - 1);
   DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Pointer enter location=%p array=%p size=%lu type=%d id=%d\n", p, a, (unsigned long)n, type, soap->idnum+1));
-  pp->next = soap->pht[h];
   pp->type = type;
   pp->mark1 = 0;
   pp->mark2 = 0;
@@ -10255,6 +10720,7 @@ soap_pointer_enter(struct soap *soap, const void *p, const void *a, int n, int t
   pp->array = a;
   pp->size = n;
   soap->pht[h] = pp;
+  soap->phtnum++;
   pp->id = ++soap->idnum;
   return pp->id;
 }
@@ -10267,10 +10733,12 @@ SOAP_FMAC2
 soap_array_pointer_lookup(struct soap *soap, const void *p, const void *a, int n, int type, struct soap_plist **ppp)
 {
   struct soap_plist *pp;
+  size_t h;
   *ppp = NULL;
-  if (!p || !a)
+  if (!p || !a || !soap->phtnum)
     return 0;
-  for (pp = soap->pht[soap_hash_ptr(a)]; pp; pp = pp->next)
+  h = soap_hash_key(a) & (soap->phtsize - 1);
+  while ((pp = soap->pht[h]))
   {
     if (pp->type == type && pp->array == a && pp->size == n)
     {
@@ -10278,6 +10746,7 @@ soap_array_pointer_lookup(struct soap *soap, const void *p, const void *a, int n
       DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Array lookup location=%p type=%d id=%d\n", a, type, pp->id));
       return pp->id;
     }
+    h = (h + 1) & (soap->phtsize - 1);
   }
   DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Array lookup location=%p type=%d: not found\n", a, type));
   return 0;
@@ -10292,6 +10761,9 @@ soap_begin_count(struct soap *soap)
 {
   soap_free_ns(soap);
   soap->error = SOAP_OK;
+#ifndef WITH_LEAN
+  soap->store = 0;
+#endif
 #ifndef WITH_LEANER
   if ((soap->mode & SOAP_ENC_DIME) || (soap->omode & SOAP_ENC_DIME))
   {
@@ -10312,9 +10784,25 @@ soap_begin_count(struct soap *soap)
       && !soap->fpreparesend
 #endif
       ))
+    {
+      soap->mode &= ~SOAP_IO_LENGTH;
+    }
+#ifndef WITH_LEAN
+    else if (!(soap->mode & (SOAP_ENC_MIME | SOAP_ENC_MTOM | SOAP_ENC_ZLIB))
+          && !soap->fprepareinitsend
+          && !soap->fpreparesend
+          && !soap->fpreparefinalsend)
+    {
+      /* serialize the message only once, storing it in blocks to determine the HTTP content length, rather than serializing it twice */
+      /* note: this buffers the entire message, so streaming output in constant memory requires SOAP_IO_CHUNK */
       soap->mode &= ~SOAP_IO_LENGTH;
+      soap->store = 1;
+    }
+#endif
     else
+    {
       soap->mode |= SOAP_IO_LENGTH;
+    }
   }
 #ifdef WITH_ZLIB
   if ((soap->mode & SOAP_ENC_ZLIB) && (soap->mode & SOAP_IO) == SOAP_IO_FLUSH)
@@ -10354,6 +10842,10 @@ soap_begin_count(struct soap *soap)
   soap->dime.size = 0; /* accumulate total size of attachments */
   if (soap->fprepareinitsend && (soap->mode & SOAP_IO) != SOAP_IO_STORE && (soap->error = soap->fprepareinitsend(soap)) != SOAP_OK)
     return soap->error;
+#endif
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_OUT) && soap_bxml_begin(soap, &soap->bxml_out))
+    return soap->error;
 #endif
   DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Begin count phase (socket=%d mode=0x%x count=" SOAP_ULONG_FORMAT ")\n", (int)soap->socket, (unsigned int)soap->mode, soap->count));
 #ifndef WITH_LEANER
@@ -10388,7 +10880,7 @@ soap_end_count(struct soap *soap)
 /******************************************************************************/
 
 static int
-soap_init_send(struct soap *soap)
+soap_init_send(struct soap *soap, int msg)
 {
   DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Initializing for output to socket=%d/fd=%d\n", (int)soap->socket, soap->sendfd));
   *soap->tag = '\0';
@@ -10396,6 +10888,12 @@ soap_init_send(struct soap *soap)
   soap->error = SOAP_OK;
   soap->mode = soap->omode | (soap->mode & (SOAP_IO_LENGTH | SOAP_ENC_DIME));
 #ifndef WITH_LEAN
+  if (msg) /* only the message, not a proxy CONNECT or NTLM handshake, uses the storage selected by soap_begin_count() */
+  {
+    if (soap->store)
+      soap->mode = (soap->mode & ~SOAP_IO) | SOAP_IO_STORE;
+    soap->store = 0;
+  }
   if ((soap->mode & SOAP_IO_UDP))
   {
     soap->mode &= ~SOAP_IO;
@@ -10403,6 +10901,8 @@ soap_init_send(struct soap *soap)
     if ((soap->mode & SOAP_IO_LENGTH) && soap->count > sizeof(soap->buf))
       return soap->error = SOAP_UDP_ERROR;
   }
+#else
+  (void)msg;
 #endif
 #ifdef WITH_ZLIB
   if ((soap->mode & SOAP_ENC_ZLIB) && (soap->mode & SOAP_IO) == SOAP_IO_FLUSH)
@@ -10530,6 +11030,8 @@ soap_init_send(struct soap *soap)
     return soap->error;
 #endif
 #ifndef WITH_LEAN
+  if (msg && (soap->bxml & SOAP_BXML_OUT) && soap_bxml_begin(soap, &soap->bxml_out))
+    return soap->error;
   soap->start = (ULONG64)time(NULL);
 #endif
   return SOAP_OK;
@@ -10543,11 +11045,11 @@ SOAP_FMAC2
 soap_begin_send(struct soap *soap)
 {
 #ifndef WITH_LEANER
-  if (soap_init_send(soap))
+  if (soap_init_send(soap, 1))
     return soap->error;
   return soap_begin_attachments(soap);
 #else
-  return soap_init_send(soap);
+  return soap_init_send(soap, 1);
 #endif
 }
 
@@ -10858,9 +11360,10 @@ soap_attachment(struct soap *soap, const char *tag, int id, const void *p, const
 static void
 soap_init_iht(struct soap *soap)
 {
-  int i;
-  for (i = 0; i < SOAP_IDHASH; i++)
-    soap->iht[i] = NULL;
+  soap->iht = NULL;
+  soap->ilist = NULL;
+  soap->ihtsize = 0;
+  soap->ihtnum = 0;
 }
 #endif
 
@@ -10870,24 +11373,60 @@ soap_init_iht(struct soap *soap)
 static void
 soap_free_iht(struct soap *soap)
 {
-  int i;
   struct soap_ilist *ip = NULL, *p = NULL;
   struct soap_flist *fp = NULL, *fq = NULL;
   DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Free ID hashtable\n"));
-  for (i = 0; i < SOAP_IDHASH; i++)
+  for (ip = soap->ilist; ip; ip = p)
   {
-    for (ip = soap->iht[i]; ip; ip = p)
+    for (fp = ip->flist; fp; fp = fq)
     {
-      for (fp = ip->flist; fp; fp = fq)
-      {
-        fq = fp->next;
-        SOAP_FREE(soap, fp);
-      }
-      p = ip->next;
-      SOAP_FREE(soap, ip);
+      fq = fp->next;
+      SOAP_FREE(soap, fp);
     }
-    soap->iht[i] = NULL;
+    p = ip->next;
+    SOAP_FREE(soap, ip);
+  }
+  soap->ilist = NULL;
+  if (soap->ihtsize > SOAP_IDHASH) /* release a table grown by a large message */
+  {
+    SOAP_FREE(soap, soap->iht);
+    soap->iht = NULL;
+    soap->ihtsize = 0;
   }
+  else if (soap->ihtnum)
+    memset((void*)soap->iht, 0, soap->ihtsize * sizeof(struct soap_ilist*));
+  soap->ihtnum = 0;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_NOIDREF
+static int
+soap_resize_iht(struct soap *soap)
+{
+  struct soap_ilist **iht, *ip;
+  size_t n = soap->ihtsize ? 2 * soap->ihtsize + 1 : SOAP_IDHASH;
+  if (n < soap->ihtsize || n > (~(size_t)0) / sizeof(struct soap_ilist*) || (SOAP_MAXALLOCSIZE > 0 && n * sizeof(struct soap_ilist*) > SOAP_MAXALLOCSIZE))
+    return soap->error = SOAP_EOM;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Resize ID hashtable to %lu entries\n", (unsigned long)n));
+  iht = (struct soap_ilist**)SOAP_MALLOC(soap, n * sizeof(struct soap_ilist*));
+  if (!iht)
+    return soap->error = SOAP_EOM;
+  memset((void*)iht, 0, n * sizeof(struct soap_ilist*));
+  for (ip = soap->ilist; ip; ip = ip->next)
+  {
+    size_t h = soap_hash_id(ip->id) % n;
+    while (iht[h])
+      if (++h >= n)
+        h = 0;
+    iht[h] = ip;
+  }
+  if (soap->iht)
+    SOAP_FREE(soap, soap->iht);
+  soap->iht = iht;
+  soap->ihtsize = n;
+  return SOAP_OK;
 }
 #endif
 
@@ -10900,9 +11439,17 @@ SOAP_FMAC2
 soap_lookup(struct soap *soap, const char *id)
 {
   struct soap_ilist *ip = NULL;
-  for (ip = soap->iht[soap_hash(id)]; ip; ip = ip->next)
-    if (!strcmp(ip->id, id))
-      return ip;
+  if (soap->ihtnum)
+  {
+    size_t h = soap_hash_id(id) % soap->ihtsize;
+    while ((ip = soap->iht[h]))
+    {
+      if (!strcmp(ip->id, id))
+        return ip;
+      if (++h >= soap->ihtsize)
+        h = 0;
+    }
+  }
   return NULL;
 }
 #endif
@@ -10918,6 +11465,8 @@ soap_enter(struct soap *soap, const char *id, int t, size_t n)
   size_t h;
   struct soap_ilist *ip = NULL;
   size_t l = strlen(id);
+  if (2 * (soap->ihtnum + 1) > soap->ihtsize && soap_resize_iht(soap))
+    return NULL;
   if (sizeof(struct soap_ilist) + l > l && (SOAP_MAXALLOCSIZE <= 0 || sizeof(struct soap_ilist) + l <= SOAP_MAXALLOCSIZE))
     ip = (struct soap_ilist*)SOAP_MALLOC(soap, sizeof(struct soap_ilist) + l);
   if (ip)
@@ -10932,9 +11481,14 @@ soap_enter(struct soap *soap, const char *id, int t, size_t n)
     ip->smart = NULL;
     ip->shaky = 0;
     (void)soap_memcpy((char*)ip->id, l + 1, id, l + 1);
-    h = soap_hash(id); /* h = (HASH(id) % SOAP_IDHASH) so soap->iht[h] is safe */
-    ip->next = soap->iht[h];
+    h = soap_hash_id(id) % soap->ihtsize;
+    while (soap->iht[h])
+      if (++h >= soap->ihtsize)
+        h = 0;
     soap->iht[h] = ip;
+    soap->ihtnum++;
+    ip->next = soap->ilist;
+    soap->ilist = ip;
   }
   return ip;
 }
@@ -10959,12 +11513,16 @@ soap_malloc(struct soap *soap, size_t n)
     return SOAP_MALLOC(soap, n);
   n += sizeof(short);
   n += (~n+1) & (sizeof(void*)-1); /* align at 4-, 8- or 16-byte boundary by rounding up */
-  if (n + sizeof(void*) + sizeof(size_t) < k)
+  if (n + SOAP_ALIST_LEN < k)
   {
     soap->error = SOAP_EOM;
     return NULL;
   }
-  p = (char*)SOAP_MALLOC(soap, n + sizeof(void*) + sizeof(size_t));
+#ifndef WITH_LEAN
+  if (n <= soap->arenalen)
+    return soap_arena_malloc(soap, n);
+#endif
+  p = (char*)SOAP_MALLOC(soap, n + SOAP_ALIST_LEN);
   if (!p)
   {
     soap->error = SOAP_EOM;
@@ -10975,169 +11533,578 @@ soap_malloc(struct soap *soap, size_t n)
   /* keep chain of alloced cells for destruction */
   *(void**)(p + n) = soap->alist;
   *(size_t*)(p + n + sizeof(void*)) = n;
+  soap_alist_prev(p + n) = &soap->alist;
+  if (soap->alist)
+    soap_alist_prev(soap->alist) = (void**)(p + n);
   soap->alist = p + n;
   return p;
 }
 
 /******************************************************************************/
 
-#ifdef SOAP_MEM_DEBUG
-static void
-soap_init_mht(struct soap *soap)
+#ifndef WITH_LEAN
+static void *
+soap_arena_malloc(struct soap *soap, size_t n)
 {
-  int i;
-  for (i = 0; i < (int)SOAP_PTRHASH; i++)
-    soap->mht[i] = NULL;
+  struct soap_arena *ap = soap->arena;
+  char *p;
+  n += (~n+1) & (SOAP_ARENA_ALIGN-1); /* align at malloc() boundary by rounding up */
+#ifdef SOAP_DEBUG
+  n += SOAP_ARENA_ALIGN; /* block size to check canaries */
+#endif
+  if (!ap || ap->size - ap->used < n)
+  {
+    /* reuse a kept chunk that is large enough, or allocate a new chunk twice the size of the previous chunk */
+    struct soap_arena **aq = &soap->arenafree;
+    while (*aq && (*aq)->size < n)
+      aq = &(*aq)->next;
+    if (*aq)
+    {
+      ap = *aq;
+      *aq = ap->next;
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Reuse arena chunk %p of %lu bytes\n", (void*)ap, (unsigned long)ap->size));
+    }
+    else
+    {
+      size_t k = soap->arenalen;
+      if (ap && ap->size >= k && ap->size < ap->size + ap->size)
+        k = ap->size + ap->size;
+      if (SOAP_MAXALLOCSIZE > 0 && k > SOAP_MAXALLOCSIZE - SOAP_ARENA_HDRLEN)
+        k = SOAP_MAXALLOCSIZE - SOAP_ARENA_HDRLEN;
+      if (k < n)
+        k = n;
+      ap = (struct soap_arena*)SOAP_MALLOC(soap, SOAP_ARENA_HDRLEN + k);
+      if (!ap)
+      {
+        soap->error = SOAP_EOM;
+        return NULL;
+      }
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "New arena chunk %p of %lu bytes\n", (void*)ap, (unsigned long)k));
+      ap->size = k;
+    }
+    ap->next = soap->arena;
+    ap->used = 0;
+    soap->arena = ap;
+  }
+  p = (char*)ap + SOAP_ARENA_HDRLEN + ap->used;
+  ap->used += n;
+#ifdef SOAP_DEBUG
+  *(size_t*)p = n;
+  p += SOAP_ARENA_ALIGN;
+  n -= SOAP_ARENA_ALIGN;
+#endif
+  /* set a canary word to detect memory overruns and data corruption */
+  *(unsigned short*)(p + n - sizeof(unsigned short)) = (unsigned short)SOAP_CANARY;
+  return p;
 }
 #endif
 
 /******************************************************************************/
 
-#ifdef SOAP_MEM_DEBUG
-static void
-soap_free_mht(struct soap *soap)
+#ifndef WITH_LEAN
+static int
+soap_free_arena(struct soap *soap)
 {
-  int i;
-  struct soap_mlist *mp, *mq;
-  for (i = 0; i < (int)SOAP_PTRHASH; i++)
+  struct soap_arena *ap;
+  size_t keep = 0;
+  for (ap = soap->arenafree; ap; ap = ap->next)
+    keep += ap->size;
+  while (soap->arena)
   {
-    for (mp = soap->mht[i]; mp; mp = mq)
+    ap = soap->arena;
+#ifdef SOAP_DEBUG
+    char *p = (char*)ap + SOAP_ARENA_HDRLEN;
+    char *q = p + ap->used;
+    while (p < q)
     {
-      mq = mp->next;
-      if (mp->live)
-        fprintf(stderr, "%s(%d): malloc() = %p not freed (memory leak or forgot to call soap_end()?)\n", mp->file, mp->line, mp->ptr);
-      free(mp);
+      char *r = p;
+      p += *(size_t*)p;
+      if (*(unsigned short*)(p - sizeof(unsigned short)) != (unsigned short)SOAP_CANARY)
+      {
+#ifdef SOAP_MEM_DEBUG
+        fprintf(stderr, "Data corruption in arena allocation (see logs)\n");
+#endif
+        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Data corruption:\n"));
+        DBGHEX(TEST, r, p - r);
+        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "\n"));
+        return soap->error = SOAP_MOE;
+      }
+    }
+#endif
+    soap->arena = ap->next;
+    if (keep + ap->size <= soap->arenakeep && keep + ap->size > keep)
+    {
+      /* keep the chunk for reuse, up to the high-water mark soap->arenakeep */
+      keep += ap->size;
+      ap->next = soap->arenafree;
+      soap->arenafree = ap;
+    }
+    else
+    {
+      SOAP_FREE(soap, ap);
     }
-    soap->mht[i] = NULL;
   }
+  return SOAP_OK;
 }
 #endif
 
 /******************************************************************************/
 
-#ifdef SOAP_MEM_DEBUG
-SOAP_FMAC1
-void*
-SOAP_FMAC2
-soap_track_malloc(struct soap *soap, const char *file, int line, size_t size)
+#ifndef WITH_LEAN
+static int
+soap_in_arena(struct soap *soap, const void *p)
 {
-  void *p = malloc(size);
-  if (soap)
+  struct soap_arena *ap;
+  for (ap = soap->arena; ap; ap = ap->next)
+    if ((const char*)p >= (const char*)ap + SOAP_ARENA_HDRLEN && (const char*)p < (const char*)ap + SOAP_ARENA_HDRLEN + ap->used)
+      return 1;
+  return 0;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+static void
+soap_init_lht(struct soap_lht *lht)
+{
+  lht->table = NULL;
+  lht->size = 0;
+  lht->num = 0;
+  lht->head = NULL;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+static void
+soap_free_lht(struct soap *soap, struct soap_lht *lht)
+{
+  (void)soap;
+  if (lht->table)
+    SOAP_FREE(soap, lht->table);
+  soap_init_lht(lht);
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+static int
+soap_enter_lht(struct soap *soap, struct soap_lht *lht, const void *p, void *link)
+{
+  size_t h;
+  (void)soap;
+  if (2 * (lht->num + 1) > lht->size)
+  {
+    struct soap_lent *table;
+    size_t i, n = lht->size ? 2 * lht->size : SOAP_PTRHASH;
+    if (n < lht->size || n > (~(size_t)0) / sizeof(struct soap_lent) || (SOAP_MAXALLOCSIZE > 0 && n * sizeof(struct soap_lent) > SOAP_MAXALLOCSIZE))
+      return SOAP_EOM;
+    table = (struct soap_lent*)SOAP_MALLOC(soap, n * sizeof(struct soap_lent));
+    if (!table)
+      return SOAP_EOM;
+    memset((void*)table, 0, n * sizeof(struct soap_lent));
+    for (i = 0; i < lht->size; i++)
+    {
+      if (lht->table[i].link)
+      {
+        h = soap_hash_key(lht->table[i].ptr) & (n - 1);
+        while (table[h].link)
+          h = (h + 1) & (n - 1);
+        table[h] = lht->table[i];
+      }
+    }
+    if (lht->table)
+      SOAP_FREE(soap, lht->table);
+    lht->table = table;
+    lht->size = n;
+  }
+  h = soap_hash_key(p) & (lht->size - 1);
+  while (lht->table[h].link)
+    h = (h + 1) & (lht->size - 1);
+  lht->table[h].ptr = p;
+  lht->table[h].link = link;
+  lht->num++;
+  return SOAP_OK;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* returns the slot of p (with the given link, if non-NULL) or lht->size when not found */
+static size_t
+soap_find_lht(const struct soap_lht *lht, const void *p, const void *link)
+{
+  if (lht->num)
   {
-    size_t h = soap_hash_ptr(p);
-    struct soap_mlist *mp = (struct soap_mlist*)malloc(sizeof(struct soap_mlist));
-    if (soap->fdebug[SOAP_INDEX_TEST])
+    size_t h = soap_hash_key(p) & (lht->size - 1);
+    while (lht->table[h].link)
     {
-      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "%s(%d): malloc(%lu) = %p\n", file, line, (unsigned long)size, p));
+      if (lht->table[h].ptr == p && (!link || lht->table[h].link == link))
+        return h;
+      h = (h + 1) & (lht->size - 1);
     }
-    mp->next = soap->mht[h];
-    mp->ptr = p;
-    mp->file = file;
-    mp->line = line;
-    mp->live = 1;
-    soap->mht[h] = mp;
   }
-  return p;
+  return lht->size;
 }
 #endif
 
 /******************************************************************************/
 
-#ifdef SOAP_MEM_DEBUG
-SOAP_FMAC1
-void
-SOAP_FMAC2
-soap_track_free(struct soap *soap, const char *file, int line, void *p)
+#ifndef WITH_LEAN
+static void
+soap_remove_lht(struct soap_lht *lht, size_t i)
 {
-  if (!soap)
+  size_t j = i, mask = lht->size - 1;
+  /* backward shift deletion: move later entries of the probe sequence into the hole */
+  for (;;)
   {
-    free(p);
+    size_t k;
+    j = (j + 1) & mask;
+    if (!lht->table[j].link)
+      break;
+    k = soap_hash_key(lht->table[j].ptr) & mask;
+    if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+      continue;
+    lht->table[i] = lht->table[j];
+    i = j;
   }
-  else
+  lht->table[i].ptr = NULL;
+  lht->table[i].link = NULL;
+  lht->num--;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+static int
+soap_index_alist(struct soap *soap)
+{
+  char *q;
+  /* index the links allocated since the last update, these are in front of aht.head */
+  for (q = (char*)soap->alist; q && q != (char*)soap->aht.head; q = *(char**)q)
   {
-    size_t h = soap_hash_ptr(p);
-    struct soap_mlist *mp;
-    for (mp = soap->mht[h]; mp; mp = mp->next)
-      if (mp->ptr == p)
-        break;
-    if (mp)
-    {
-      if (mp->live)
-      {
-        if (soap->fdebug[SOAP_INDEX_TEST])
-        {
-          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "%s(%d): free(%p)\n", file, line, p));
-        }
-        free(p);
-        mp->live = 0;
-      }
-      else
-      {
-        fprintf(stderr, "%s(%d): free(%p) double free of pointer malloced at %s(%d)\n", file, line, p, mp->file, mp->line);
-      }
-    }
-    else
+    if (soap_enter_lht(soap, &soap->aht, q - soap_alist_size(q), q))
     {
-      fprintf(stderr, "%s(%d): free(%p) pointer not malloced\n", file, line, p);
+      soap_free_lht(soap, &soap->aht);
+      return SOAP_EOM;
     }
   }
+  soap->aht.head = soap->alist;
+  return SOAP_OK;
 }
 #endif
 
 /******************************************************************************/
 
-#ifdef SOAP_MEM_DEBUG
-static void
-soap_track_unlink(struct soap *soap, const void *p)
+#ifndef WITH_LEAN
+static int
+soap_index_clist(struct soap *soap)
 {
-  size_t h = soap_hash_ptr(p);
-  struct soap_mlist *mp;
-  for (mp = soap->mht[h]; mp; mp = mp->next)
-    if (mp->ptr == p)
-      break;
-  if (mp)
-    mp->live = 0;
+  struct soap_clist *cp;
+  /* index the nodes linked since the last update, these are in front of cht.head */
+  for (cp = soap->clist; cp && cp != (struct soap_clist*)soap->cht.head; cp = cp->next)
+  {
+    if (soap_enter_lht(soap, &soap->cht, cp->ptr, (void*)cp))
+    {
+      soap_free_lht(soap, &soap->cht);
+      return SOAP_EOM;
+    }
+  }
+  soap->cht.head = (void*)soap->clist;
+  return SOAP_OK;
 }
 #endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-void
-SOAP_FMAC2
-soap_dealloc(struct soap *soap, void *p)
+static char *
+soap_alist_find(struct soap *soap, const void *p)
 {
-  if (soap_check_state(soap))
-    return;
-  if (p)
+  char *q;
+#ifndef WITH_LEAN
+  if (!soap_index_alist(soap))
   {
-    char **q;
-    for (q = (char**)(void*)&soap->alist; *q; q = *(char***)q)
-    {
-      if (*(unsigned short*)(char*)(*q - sizeof(unsigned short)) != (unsigned short)SOAP_CANARY)
-      {
-#ifdef SOAP_MEM_DEBUG
-        fprintf(stderr, "Data corruption in dynamic allocation (see logs)\n");
+    size_t i = soap_find_lht(&soap->aht, p, NULL);
+    return i < soap->aht.size ? (char*)soap->aht.table[i].link : NULL;
+  }
+#endif
+  /* no index: linear search */
+  for (q = (char*)soap->alist; q; q = *(char**)q)
+    if (p == (void*)(q - soap_alist_size(q)))
+      return q;
+  return NULL;
+}
+
+/******************************************************************************/
+
+static void
+soap_alist_remove(struct soap *soap, char *q)
+{
+  void *next = *(void**)q;
+  void **prev = soap_alist_prev(q);
+  *prev = next;
+  if (next)
+    soap_alist_prev(next) = prev;
+#ifndef WITH_LEAN
+  if (soap->aht.num)
+  {
+    size_t i = soap_find_lht(&soap->aht, q - soap_alist_size(q), q);
+    if (i < soap->aht.size)
+      soap_remove_lht(&soap->aht, i);
+  }
+  if (soap->aht.head == (void*)q)
+    soap->aht.head = next;
+#else
+  (void)soap;
+#endif
+}
+
+/******************************************************************************/
+
+static struct soap_clist *
+soap_clist_find(struct soap *soap, const void *p)
+{
+  struct soap_clist *cp;
+#ifndef WITH_LEAN
+  if (!soap_index_clist(soap))
+  {
+    size_t i = soap_find_lht(&soap->cht, p, NULL);
+    return i < soap->cht.size ? (struct soap_clist*)soap->cht.table[i].link : NULL;
+  }
+#endif
+  /* no index: linear search */
+  for (cp = soap->clist; cp; cp = cp->next)
+    if (p == cp->ptr)
+      return cp;
+  return NULL;
+}
+
+/******************************************************************************/
+
+static void
+soap_clist_remove(struct soap *soap, struct soap_clist *cp)
+{
+  *cp->prev = cp->next;
+  if (cp->next)
+    cp->next->prev = cp->prev;
+#ifndef WITH_LEAN
+  if (soap->cht.num)
+  {
+    size_t i = soap_find_lht(&soap->cht, cp->ptr, cp);
+    if (i < soap->cht.size)
+      soap_remove_lht(&soap->cht, i);
+  }
+  if (soap->cht.head == (void*)cp)
+    soap->cht.head = (void*)cp->next;
+#else
+  (void)soap;
+#endif
+}
+
+/******************************************************************************/
+
+static void *
+soap_malloc_block(struct soap *soap, size_t n)
+{
+#ifndef WITH_LEAN
+  if (n < soap->arenalen)
+    return soap_arena_malloc(soap, n + sizeof(unsigned short));
+#else
+  (void)soap;
+#endif
+  return SOAP_MALLOC(soap, n);
+}
+
+/******************************************************************************/
+
+static void
+soap_free_block(struct soap *soap, void *p)
+{
+#ifndef WITH_LEAN
+  if (soap_in_arena(soap, p))
+    return;
+#else
+  (void)soap;
+#endif
+  SOAP_FREE(soap, p);
+}
+
+/******************************************************************************/
+
+#ifdef SOAP_MEM_DEBUG
+static void
+soap_init_mht(struct soap *soap)
+{
+  int i;
+  for (i = 0; i < (int)SOAP_PTRHASH; i++)
+    soap->mht[i] = NULL;
+}
+#endif
+
+/******************************************************************************/
+
+#ifdef SOAP_MEM_DEBUG
+static void
+soap_free_mht(struct soap *soap)
+{
+  int i;
+  struct soap_mlist *mp, *mq;
+  for (i = 0; i < (int)SOAP_PTRHASH; i++)
+  {
+    for (mp = soap->mht[i]; mp; mp = mq)
+    {
+      mq = mp->next;
+      if (mp->live)
+        fprintf(stderr, "%s(%d): malloc() = %p not freed (memory leak or forgot to call soap_end()?)\n", mp->file, mp->line, mp->ptr);
+      free(mp);
+    }
+    soap->mht[i] = NULL;
+  }
+}
+#endif
+
+/******************************************************************************/
+
+#ifdef SOAP_MEM_DEBUG
+SOAP_FMAC1
+void*
+SOAP_FMAC2
+soap_track_malloc(struct soap *soap, const char *file, int line, size_t size)
+{
+  void *p = malloc(size);
+  if (soap)
+  {
+    size_t h = soap_hash_ptr(p);
+    struct soap_mlist *mp = (struct soap_mlist*)malloc(sizeof(struct soap_mlist));
+    if (soap->fdebug[SOAP_INDEX_TEST])
+    {
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "%s(%d): malloc(%lu) = %p\n", file, line, (unsigned long)size, p));
+    }
+    mp->next = soap->mht[h];
+    mp->ptr = p;
+    mp->file = file;
+    mp->line = line;
+    mp->live = 1;
+    soap->mht[h] = mp;
+  }
+  return p;
+}
+#endif
+
+/******************************************************************************/
+
+#ifdef SOAP_MEM_DEBUG
+SOAP_FMAC1
+void
+SOAP_FMAC2
+soap_track_free(struct soap *soap, const char *file, int line, void *p)
+{
+  if (!soap)
+  {
+    free(p);
+  }
+  else
+  {
+    size_t h = soap_hash_ptr(p);
+    struct soap_mlist *mp;
+    for (mp = soap->mht[h]; mp; mp = mp->next)
+      if (mp->ptr == p)
+        break;
+    if (mp)
+    {
+      if (mp->live)
+      {
+        if (soap->fdebug[SOAP_INDEX_TEST])
+        {
+          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "%s(%d): free(%p)\n", file, line, p));
+        }
+        free(p);
+        mp->live = 0;
+      }
+      else
+      {
+        fprintf(stderr, "%s(%d): free(%p) double free of pointer malloced at %s(%d)\n", file, line, p, mp->file, mp->line);
+      }
+    }
+    else
+    {
+      fprintf(stderr, "%s(%d): free(%p) pointer not malloced\n", file, line, p);
+    }
+  }
+}
+#endif
+
+/******************************************************************************/
+
+#ifdef SOAP_MEM_DEBUG
+static void
+soap_track_unlink(struct soap *soap, const void *p)
+{
+  size_t h = soap_hash_ptr(p);
+  struct soap_mlist *mp;
+  for (mp = soap->mht[h]; mp; mp = mp->next)
+    if (mp->ptr == p)
+      break;
+  if (mp)
+    mp->live = 0;
+}
+#endif
+
+/******************************************************************************/
+
+SOAP_FMAC1
+void
+SOAP_FMAC2
+soap_dealloc(struct soap *soap, void *p)
+{
+  if (soap_check_state(soap))
+    return;
+  if (p)
+  {
+    char *q = soap_alist_find(soap, p);
+    if (q)
+    {
+      if (*(unsigned short*)(q - sizeof(unsigned short)) != (unsigned short)SOAP_CANARY)
+      {
+#ifdef SOAP_MEM_DEBUG
+        fprintf(stderr, "Data corruption in dynamic allocation (see logs)\n");
 #endif
         DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Data corruption:\n"));
-        DBGHEX(TEST, *q - 200, 200);
+        DBGHEX(TEST, q - 200, 200);
         DBGLOG(TEST, SOAP_MESSAGE(fdebug, "\n"));
         soap->error = SOAP_MOE;
         return;
       }
-      if (p == (void*)(*q - *(size_t*)(*q + sizeof(void*))))
-      {
-        *q = **(char***)q;
-        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Freed data at %p\n", p));
-        SOAP_FREE(soap, p);
-        return;
-      }
+      soap_alist_remove(soap, q);
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Freed data at %p\n", p));
+      SOAP_FREE(soap, p);
+      return;
+    }
+#ifndef WITH_LEAN
+    if (soap_in_arena(soap, p))
+    {
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Data at %p is in arena and freed with soap_end()\n", p));
+      return;
     }
+#endif
     soap_delete(soap, p);
   }
   else
   {
     DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Free all soap_malloc() data\n"));
+#ifndef WITH_LEAN
+    /* the lazy elements are soap_malloc() data */
+    soap_free_lht(soap, &soap->lzht);
+    soap->lazy = NULL;
+    if (soap_free_arena(soap))
+      return;
+    soap_free_lht(soap, &soap->aht);
+#endif
     while (soap->alist)
     {
       char *q = (char*)soap->alist;
@@ -11181,38 +12148,36 @@ void
 SOAP_FMAC2
 soap_delete(struct soap *soap, void *p)
 {
-  struct soap_clist **cp;
+  struct soap_clist *q;
   if (soap_check_state(soap))
     return;
-  cp = &soap->clist;
   if (p)
   {
-    while (*cp)
+    q = soap_clist_find(soap, p);
+    if (q)
     {
-      if (p == (*cp)->ptr)
+      soap_clist_remove(soap, q);
+      if (q->fdelete(soap, q))
       {
-        struct soap_clist *q = *cp;
-        *cp = q->next;
-        if (q->fdelete(soap, q))
-        {
-          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Could not dealloc data %p: deletion callback failed for object type=%d\n", q->ptr, q->type));
+        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Could not dealloc data %p: deletion callback failed for object type=%d\n", q->ptr, q->type));
 #ifdef SOAP_MEM_DEBUG
-          fprintf(stderr, "new(object type=%d) = %p not freed: deletion callback failed\n", q->type, q->ptr);
+        fprintf(stderr, "new(object type=%d) = %p not freed: deletion callback failed\n", q->type, q->ptr);
 #endif
-        }
-        SOAP_FREE(soap, q);
-        return;
       }
-      cp = &(*cp)->next;
+      SOAP_FREE(soap, q);
+      return;
     }
     DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Could not dealloc data %p: address not in list\n", p));
   }
   else
   {
-    while (*cp)
+#ifndef WITH_LEAN
+    soap_free_lht(soap, &soap->cht);
+#endif
+    while (soap->clist)
     {
-      struct soap_clist *q = *cp;
-      *cp = q->next;
+      q = soap->clist;
+      soap_clist_remove(soap, q);
       DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Delete %p type=%d (cp=%p)\n", q->ptr, q->type, (void*)q));
       if (q->fdelete(soap, q))
       {
@@ -11272,8 +12237,52 @@ soap_delegate_deletion(struct soap *soap, struct soap *soap_to)
 #endif
   }
   *q = (char*)soap_to->alist;
+  if (soap_to->alist)
+    soap_alist_prev(soap_to->alist) = (void**)q;
   soap_to->alist = soap->alist;
+  if (soap_to->alist)
+    soap_alist_prev(soap_to->alist) = &soap_to->alist;
   soap->alist = NULL;
+#ifndef WITH_LEAN
+  soap_free_lht(soap, &soap->aht);
+#endif
+#ifndef WITH_LEAN
+  if (soap->arena)
+  {
+    struct soap_arena *ap = soap->arena;
+    for (;;)
+    {
+#ifdef SOAP_MEM_DEBUG
+      h = soap_hash_ptr(ap);
+      for (mp = &soap->mht[h]; *mp; mp = &(*mp)->next)
+      {
+        if ((*mp)->ptr == ap)
+        {
+          mq = *mp;
+          *mp = mq->next;
+          mq->next = soap_to->mht[h];
+          soap_to->mht[h] = mq;
+          break;
+        }
+      }
+#endif
+      if (!ap->next)
+        break;
+      ap = ap->next;
+    }
+    /* the chunks of soap_to stay in front, to continue allocating from its current chunk */
+    if (soap_to->arena)
+    {
+      ap->next = soap_to->arena->next;
+      soap_to->arena->next = soap->arena;
+    }
+    else
+    {
+      soap_to->arena = soap->arena;
+    }
+    soap->arena = NULL;
+  }
+#endif
 #ifdef SOAP_MEM_DEBUG
   cp = soap->clist;
   while (cp)
@@ -11299,24 +12308,161 @@ soap_delegate_deletion(struct soap *soap, struct soap *soap_to)
     while (cp->next)
       cp = cp->next;
     cp->next = soap->clist;
+    if (soap->clist)
+      soap->clist->prev = &cp->next;
   }
   else
   {
     soap_to->clist = soap->clist;
+    if (soap->clist)
+      soap->clist->prev = &soap_to->clist;
   }
   soap->clist = NULL;
+#ifndef WITH_LEAN
+  /* the index of soap_to->clist does not cover the appended nodes */
+  soap_free_lht(soap, &soap->cht);
+  soap_free_lht(soap_to, &soap_to->cht);
+#endif
 }
 
 /******************************************************************************/
 
 SOAP_FMAC1
-struct soap_clist *
+void
 SOAP_FMAC2
-soap_link(struct soap *soap, int t, int n, int (*fdelete)(struct soap*, struct soap_clist*))
+soap_begin_item(struct soap *soap, struct soap_imark *mark)
 {
-  struct soap_clist *cp = NULL;
-  if (soap)
-  {
+  mark->alist = soap->alist;
+  mark->clist = soap->clist;
+  mark->arena = soap->arena;
+  mark->used = soap->arena ? soap->arena->used : 0;
+#ifndef WITH_LEAN
+  mark->lazy = soap->lazy;
+#else
+  mark->lazy = NULL;
+#endif
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_end_item(struct soap *soap, const char *tag, int t, void *p, const struct soap_imark *mark)
+{
+  int err;
+  if (!soap->fitemin)
+    return 0;
+#if !defined(WITH_LEANER) || !defined(WITH_NOIDREF)
+  /* data that is or may be referenced by id-ref must be kept until the refs are resolved by soap_end_recv() */
+  if (soap->ihtnum)
+  {
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Item '%s' type=%d is kept, because the message has id-ref data\n", tag ? tag : SOAP_STR_EOS, t));
+    return 0;
+  }
+#endif
+  err = soap->fitemin(soap, tag, t, p);
+  if (err == SOAP_TAG_MISMATCH)
+    return 0;
+  if (err)
+  {
+    soap->error = err;
+    return 1;
+  }
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Item '%s' type=%d at %p consumed: release its data\n", tag ? tag : SOAP_STR_EOS, t, p));
+  (void)soap_release_item(soap, mark);
+  return 1;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_next_item(struct soap *soap, const char *tag, int t, const void *a, void *p, const struct soap_imark *mark)
+{
+  int err;
+  if (!soap->fitemout || soap_release_item(soap, mark))
+    return 0;
+  err = soap->fitemout(soap, tag, t, a, p);
+  if (err == SOAP_OK)
+  {
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Item '%s' type=%d at %p produced\n", tag ? tag : SOAP_STR_EOS, t, p));
+    return 1;
+  }
+  if (err != SOAP_EOF)
+    soap->error = err;
+  else
+    (void)soap_release_item(soap, mark);
+  return 0;
+}
+
+/******************************************************************************/
+
+static int
+soap_release_item(struct soap *soap, const struct soap_imark *mark)
+{
+#ifndef WITH_LEAN
+  /* unlink the lazy elements retained after the mark before their data is freed */
+  while (soap->lazy && soap->lazy != mark->lazy)
+  {
+    struct soap_lazy *lp = soap->lazy;
+    soap->lazy = lp->next;
+    soap_lazy_drop(soap, lp);
+  }
+#endif
+  /* delete and free the data allocated after the mark, i.e. the data of the item */
+  while (soap->clist && soap->clist != mark->clist)
+  {
+    struct soap_clist *cp = soap->clist;
+    soap_clist_remove(soap, cp);
+    if (cp->fdelete(soap, cp))
+    {
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Could not dealloc data %p: deletion callback failed for object type=%d\n", cp->ptr, cp->type));
+    }
+    SOAP_FREE(soap, cp);
+  }
+  while (soap->alist && soap->alist != mark->alist)
+  {
+    char *q = (char*)soap->alist;
+    if (*(unsigned short*)(char*)(q - sizeof(unsigned short)) != (unsigned short)SOAP_CANARY)
+    {
+#ifdef SOAP_MEM_DEBUG
+      fprintf(stderr, "Data corruption in dynamic allocation (see logs)\n");
+#endif
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Data corruption:\n"));
+      DBGHEX(TEST, q - 200, 200);
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "\n"));
+      return soap->error = SOAP_MOE;
+    }
+    soap_alist_remove(soap, q);
+    SOAP_FREE(soap, q - soap_alist_size(q));
+  }
+#ifndef WITH_LEAN
+  /* rewind the arena, the chunks that were added are kept for reuse */
+  while (soap->arena && soap->arena != mark->arena)
+  {
+    struct soap_arena *ap = soap->arena;
+    soap->arena = ap->next;
+    ap->next = soap->arenafree;
+    soap->arenafree = ap;
+  }
+  if (soap->arena)
+    soap->arena->used = mark->used;
+#endif
+  return SOAP_OK;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+struct soap_clist *
+SOAP_FMAC2
+soap_link(struct soap *soap, int t, int n, int (*fdelete)(struct soap*, struct soap_clist*))
+{
+  struct soap_clist *cp = NULL;
+  if (soap)
+  {
     if (n != SOAP_NO_LINK_TO_DELETE)
     {
       cp = (struct soap_clist*)SOAP_MALLOC(soap, sizeof(struct soap_clist));
@@ -11327,6 +12473,9 @@ soap_link(struct soap *soap, int t, int n, int (*fdelete)(struct soap*, struct s
       else
       {
         cp->next = soap->clist;
+        cp->prev = &soap->clist;
+        if (soap->clist)
+          soap->clist->prev = &cp->next;
         cp->type = t;
         cp->size = n;
         cp->ptr = NULL;
@@ -11348,30 +12497,25 @@ soap_unlink(struct soap *soap, const void *p)
 {
   if (soap && p)
   {
-    char **q;
-    struct soap_clist **cp;
-    for (q = (char**)(void*)&soap->alist; *q; q = *(char***)q)
+    char *q;
+    struct soap_clist *cp;
+    q = soap_alist_find(soap, p);
+    if (q)
     {
-      if (p == (void*)(*q - *(size_t*)(*q + sizeof(void*))))
-      {
-        *q = **(char***)q;
-        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Unlinked data %p\n", p));
+      soap_alist_remove(soap, q);
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Unlinked data %p\n", p));
 #ifdef SOAP_MEM_DEBUG
-        soap_track_unlink(soap, p);
+      soap_track_unlink(soap, p);
 #endif
-        return SOAP_OK;         /* found and removed from dealloc chain */
-      }
+      return SOAP_OK;           /* found and removed from dealloc chain */
     }
-    for (cp = &soap->clist; *cp; cp = &(*cp)->next)
+    cp = soap_clist_find(soap, p);
+    if (cp)
     {
-      if (p == (*cp)->ptr)
-      {
-        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Unlinked class instance %p\n", p));
-        q = (char**)*cp;
-        *cp = (*cp)->next;
-        SOAP_FREE(soap, q);
-        return SOAP_OK;         /* found and removed from dealloc chain */
-      }
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Unlinked class instance %p\n", p));
+      soap_clist_remove(soap, cp);
+      SOAP_FREE(soap, cp);
+      return SOAP_OK;           /* found and removed from dealloc chain */
     }
   }
   return SOAP_ERR;
@@ -11728,20 +12872,16 @@ int
 SOAP_FMAC2
 soap_id_nullify(struct soap *soap, const char *id)
 {
-  int i;
-  for (i = 0; i < SOAP_IDHASH; i++)
+  struct soap_ilist *ip;
+  for (ip = soap->ilist; ip; ip = ip->next)
   {
-    struct soap_ilist *ip;
-    for (ip = soap->iht[i]; ip; ip = ip->next)
+    void *p, *q;
+    for (p = ip->link; p; p = q)
     {
-      void *p, *q;
-      for (p = ip->link; p; p = q)
-      {
-        q = *(void**)p;
-        *(void**)p = NULL;
-      }
-      ip->link = NULL;
+      q = *(void**)p;
+      *(void**)p = NULL;
     }
+    ip->link = NULL;
   }
   soap_strcpy(soap->id, sizeof(soap->id), id);
   return soap->error = SOAP_HREF;
@@ -11992,6 +13132,7 @@ soap_end_recv(struct soap *soap)
         break;
     soap->mode &= ~SOAP_ENC_ZLIB;
     (void)soap_memcpy((void*)soap->buf, sizeof(soap->buf), (const void*)soap->z_buf, sizeof(soap->buf));
+    soap->ibuf = soap->buf;
     soap->bufidx = (char*)soap->d_stream->next_in - soap->z_buf;
     soap->buflen = soap->z_buflen;
     soap->zlib_state = SOAP_ZLIB_NONE;
@@ -12083,16 +13224,20 @@ soap_free_temp(struct soap *soap)
   ns = soap->local_namespaces;
   if (ns)
   {
-    for (; ns->id; ns++)
+    if (!soap->nsshared)
     {
-      if (ns->out)
+      for (; ns->id; ns++)
       {
-        SOAP_FREE(soap, ns->out);
-        ns->out = NULL;
+        if (ns->out)
+        {
+          SOAP_FREE(soap, ns->out);
+          ns->out = NULL;
+        }
       }
+      SOAP_FREE(soap, soap->local_namespaces);
     }
-    SOAP_FREE(soap, soap->local_namespaces);
     soap->local_namespaces = NULL;
+    soap->nsshared = 0;
   }
 #ifndef WITH_LEANER
   while (soap->xlist)
@@ -12121,6 +13266,7 @@ soap_free_ns(struct soap *soap)
     SOAP_FREE(soap, np);
   }
   soap->nlist = NULL;
+  soap->nmatch = NULL;
 }
 
 /******************************************************************************/
@@ -12293,17 +13439,47 @@ soap_copy_context(struct soap *copy, const struct soap *soap)
     copy->ntlm_challenge = NULL;
 #endif
     copy->nlist = NULL;
+    copy->nmatch = NULL;
     copy->blist = NULL;
     copy->clist = NULL;
     copy->alist = NULL;
+#ifndef WITH_LEAN
+    soap_init_lht(&copy->aht);
+    soap_init_lht(&copy->cht);
+    soap_init_lht(&copy->lzht);
+    copy->bxml = 0;
+    copy->bxml_in = NULL;
+    copy->bxml_out = NULL;
+#endif
+    copy->arena = NULL;
+    copy->arenafree = NULL;
     copy->attributes = NULL;
     copy->labbuf = NULL;
     copy->lablen = 0;
     copy->labidx = 0;
-    copy->namespaces = soap->local_namespaces;
-    copy->local_namespaces = NULL;
-    soap_set_local_namespaces(copy); /* copy content of soap->local_namespaces */
-    copy->namespaces = soap->namespaces; /* point to shared read-only namespaces table */
+    copy->ibuf = soap->ibuf == soap->buf ? copy->buf : soap->ibuf;
+#ifndef WITH_LEAN
+    copy->mmapbuf = NULL; /* the mapping is unmapped by the context only */
+    copy->mmaplen = 0;
+    copy->lazy = NULL;
+#endif
+    /* share a shared read-only soap->local_namespaces table, copy a private table without its rebound URIs */
+    if (soap->local_namespaces && !soap->nsshared)
+    {
+      copy->nsshared = 1;
+      if (soap_own_namespaces(copy))
+      {
+        copy->local_namespaces = NULL;
+        copy->nsshared = 0;
+      }
+      else
+      {
+        struct Namespace *ns;
+        for (ns = copy->local_namespaces; ns->id; ns++)
+          ns->out = NULL;
+        memset((void*)copy->nsht, 0, sizeof(copy->nsht));
+      }
+    }
     copy->c_locale = NULL;
 #ifdef WITH_OPENSSL
     copy->bio = NULL;
@@ -12407,6 +13583,17 @@ soap_copy_stream(struct soap *copy, struct soap *soap)
   copy->maxoccurs = soap->maxoccurs;
   copy->os = soap->os;
   copy->is = soap->is;
+#ifndef WITH_LEAN
+  copy->isbuf = soap->isbuf;
+  copy->islen = soap->islen;
+  copy->isidx = soap->isidx;
+  copy->insitu = soap->insitu;
+  copy->isconst = soap->isconst;
+  copy->mmapbuf = NULL;
+  copy->mmaplen = 0;
+  copy->bxml = soap->bxml;
+  (void)soap_bxml_copy(copy, soap);
+#endif
   copy->sendfd = soap->sendfd;
   copy->recvfd = soap->recvfd;
   copy->bufidx = soap->bufidx;
@@ -12482,6 +13669,7 @@ soap_copy_stream(struct soap *copy, struct soap *soap)
   copy->z_dict_len = soap->z_dict_len;
 #endif
   (void)soap_memcpy((void*)copy->buf, sizeof(copy->buf), (const void*)soap->buf, sizeof(soap->buf));
+  copy->ibuf = soap->ibuf == soap->buf ? copy->buf : soap->ibuf;
   /* copy XML parser state */
   soap_free_ns(copy);
   soap_set_local_namespaces(copy);
@@ -12688,6 +13876,9 @@ soap_versioning(soap_init)(struct soap *soap, soap_mode imode, soap_mode omode)
 #endif
   soap->fseterror = NULL;
   soap->fignore = NULL;
+  soap->fitemin = NULL;
+  soap->fitemout = NULL;
+  soap->fparallel = NULL;
   soap->fencoding = NULL;
   soap->fserveloop = NULL;
   soap->fplugin = fplugin;
@@ -12779,10 +13970,25 @@ soap_versioning(soap_init)(struct soap *soap, soap_mode imode, soap_mode omode)
   soap->namespaces = NULL;
 #endif
   soap->local_namespaces = NULL;
+  soap->nsshared = 0;
+  memset((void*)soap->nsht, 0, sizeof(soap->nsht));
   soap->nlist = NULL;
+  soap->nmatch = NULL;
   soap->blist = NULL;
   soap->clist = NULL;
   soap->alist = NULL;
+#ifndef WITH_LEAN
+  soap_init_lht(&soap->aht);
+  soap_init_lht(&soap->cht);
+  soap_init_lht(&soap->lzht);
+  soap->bxml = 0;
+  soap->bxml_in = NULL;
+  soap->bxml_out = NULL;
+#endif
+  soap->arena = NULL;
+  soap->arenalen = SOAP_ARENALEN;
+  soap->arenafree = NULL;
+  soap->arenakeep = SOAP_ARENAKEEP;
   soap->shaky = 0;
   soap->attributes = NULL;
   soap->header = NULL;
@@ -12793,6 +13999,16 @@ soap_versioning(soap_init)(struct soap *soap, soap_mode imode, soap_mode omode)
   soap->recvsk = SOAP_INVALID_SOCKET;
   soap->os = NULL;
   soap->is = NULL;
+#ifndef WITH_LEAN
+  soap->isbuf = NULL;
+  soap->islen = 0;
+  soap->isidx = 0;
+  soap->insitu = NULL;
+  soap->isconst = 0;
+  soap->mmapbuf = NULL;
+  soap->mmaplen = 0;
+  soap->lazy = NULL;
+#endif
 #ifndef WITH_LEANER
   soap->dom = NULL;
   soap->dime.list = NULL;
@@ -12849,6 +14065,11 @@ soap_versioning(soap_init)(struct soap *soap, soap_mode imode, soap_mode omode)
   soap->z_dict = NULL;
   soap->z_dict_len = 0;
 #ifndef WITH_LEAN
+  soap->dt_time = 0;
+  soap->dt_buf[0] = '\0';
+  soap->tz_hour = 0;
+  soap->tz_offset = SOAP_TZ_NONE;
+  soap->store = 0;
   soap->wsuid = NULL;
   soap->c14nexclude = NULL;
   soap->c14ninclude = NULL;
@@ -12940,6 +14161,7 @@ soap_versioning(soap_init)(struct soap *soap, soap_mode imode, soap_mode omode)
   soap->randfile = NULL;
 #endif
   soap->c_locale = NULL;
+  soap->ibuf = soap->buf;
   soap->buflen = 0;
   soap->bufidx = 0;
 #ifndef WITH_LEANER
@@ -12986,6 +14208,9 @@ soap_begin(struct soap *soap)
   }
   soap->encoding = 0;
   soap->mode = 0;
+#ifndef WITH_LEAN
+  soap->store = 0;
+#endif
   soap->part = SOAP_END;
   soap->peeked = 0;
   soap->ahead = 0;
@@ -13011,6 +14236,9 @@ soap_end(struct soap *soap)
     SOAP_FREE(soap, soap->clist);
     soap->clist = cp;
   }
+#ifndef WITH_LEAN
+  soap_free_lht(soap, &soap->cht);
+#endif
   (void)soap_closesock(soap);
 #ifdef SOAP_DEBUG
   soap_close_logfiles(soap);
@@ -13025,7 +14253,7 @@ SOAP_FMAC2
 soap_set_version(struct soap *soap, short version)
 {
   soap_set_local_namespaces(soap);
-  if (soap->version != version && soap->local_namespaces && soap->local_namespaces[0].id && soap->local_namespaces[1].id)
+  if (soap->version != version && soap->local_namespaces && soap->local_namespaces[0].id && soap->local_namespaces[1].id && !soap_own_namespaces(soap))
   {
     if (version == 1)
     {
@@ -13037,6 +14265,7 @@ soap_set_version(struct soap *soap, short version)
       soap->local_namespaces[0].ns = soap_env2;
       soap->local_namespaces[1].ns = soap_enc2;
     }
+    memset((void*)soap->nsht, 0, sizeof(soap->nsht));
     soap->version = version;
   }
   if (version == 0)
@@ -13053,7 +14282,7 @@ soap_version(struct soap *soap)
   struct Namespace *p = soap->local_namespaces;
   if (p)
   {
-    const char *ns = p[0].out;
+    const char *ns = p[0].out, *enc;
     if (!ns)
       ns = p[0].ns;
     if (ns)
@@ -13061,20 +14290,30 @@ soap_version(struct soap *soap)
       if (!strcmp(ns, soap_env1))
       {
         soap->version = 1; /* make sure we use SOAP 1.1 */
-        if (p[1].out)
-          SOAP_FREE(soap, p[1].out);
-        p[1].out = (char*)SOAP_MALLOC(soap, sizeof(soap_enc1));
-        if (p[1].out)
-          (void)soap_memcpy(p[1].out, sizeof(soap_enc1), soap_enc1, sizeof(soap_enc1));
+        enc = p[1].out ? p[1].out : p[1].ns;
+        if ((!enc || strcmp(enc, soap_enc1)) && !soap_own_namespaces(soap)) /* copy the shared table only to rebind */
+        {
+          p = soap->local_namespaces;
+          if (p[1].out)
+            SOAP_FREE(soap, p[1].out);
+          p[1].out = (char*)SOAP_MALLOC(soap, sizeof(soap_enc1));
+          if (p[1].out)
+            (void)soap_memcpy(p[1].out, sizeof(soap_enc1), soap_enc1, sizeof(soap_enc1));
+        }
       }
       else if (!strcmp(ns, soap_env2))
       {
         soap->version = 2; /* make sure we use SOAP 1.2 */
-        if (p[1].out)
-          SOAP_FREE(soap, p[1].out);
-        p[1].out = (char*)SOAP_MALLOC(soap, sizeof(soap_enc2));
-        if (p[1].out)
-          (void)soap_memcpy(p[1].out, sizeof(soap_enc2), soap_enc2, sizeof(soap_enc2));
+        enc = p[1].out ? p[1].out : p[1].ns;
+        if ((!enc || strcmp(enc, soap_enc2)) && !soap_own_namespaces(soap)) /* copy the shared table only to rebind */
+        {
+          p = soap->local_namespaces;
+          if (p[1].out)
+            SOAP_FREE(soap, p[1].out);
+          p[1].out = (char*)SOAP_MALLOC(soap, sizeof(soap_enc2));
+          if (p[1].out)
+            (void)soap_memcpy(p[1].out, sizeof(soap_enc2), soap_enc2, sizeof(soap_enc2));
+        }
       }
     }
   }
@@ -13088,14 +14327,17 @@ SOAP_FMAC2
 soap_set_namespaces(struct soap *soap, const struct Namespace *p)
 {
   struct Namespace *ns = soap->local_namespaces;
+  short nsshared = soap->nsshared;
   struct soap_nlist *np, *nq, *nr;
   unsigned int level = soap->level;
   soap->namespaces = p;
   soap->local_namespaces = NULL;
+  soap->nsshared = 0;
   soap_set_local_namespaces(soap);
   /* reverse the namespace list */
   np = soap->nlist;
   soap->nlist = NULL;
+  soap->nmatch = NULL;
   if (np)
   {
     nq = np->next;
@@ -13126,7 +14368,7 @@ soap_set_namespaces(struct soap *soap, const struct Namespace *p)
     np = np->next;
     SOAP_FREE(soap, nq);
   }
-  if (ns)
+  if (ns && !nsshared)
   {
     int i;
     for (i = 0; ns[i].id; i++)
@@ -13154,26 +14396,57 @@ soap_set_local_namespaces(struct soap *soap)
   {
     const struct Namespace *ns1;
     struct Namespace *ns2;
-    size_t n = 1;
+    /* share the read-only namespaces table until a namespace URI is rebound, but copy it when it has out values to clear */
+    soap->local_namespaces = (struct Namespace*)soap->namespaces;
+    soap->nsshared = 1;
     for (ns1 = soap->namespaces; ns1->id; ns1++)
-      n++;
-    n *= sizeof(struct Namespace);
-    ns2 = (struct Namespace*)SOAP_MALLOC(soap, n);
-    if (ns2)
+      if (ns1->out)
+        break;
+    if (ns1->id)
     {
-      (void)soap_memcpy((void*)ns2, n, (const void*)soap->namespaces, n);
-      if (ns2[0].ns)
+      if (soap_own_namespaces(soap))
       {
-        if (!strcmp(ns2[0].ns, soap_env1))
-          soap->version = 1;
-        else if (!strcmp(ns2[0].ns, soap_env2))
-          soap->version = 2;
+        soap->local_namespaces = NULL;
+        soap->nsshared = 0;
+        return;
       }
-      soap->local_namespaces = ns2;
-      for (; ns2->id; ns2++)
+      for (ns2 = soap->local_namespaces; ns2->id; ns2++)
         ns2->out = NULL;
     }
+    ns2 = soap->local_namespaces;
+    if (ns2[0].ns)
+    {
+      if (!strcmp(ns2[0].ns, soap_env1))
+        soap->version = 1;
+      else if (!strcmp(ns2[0].ns, soap_env2))
+        soap->version = 2;
+    }
+    memset((void*)soap->nsht, 0, sizeof(soap->nsht));
+  }
+}
+
+/******************************************************************************/
+
+static int
+soap_own_namespaces(struct soap *soap)
+{
+  if (soap->nsshared)
+  {
+    const struct Namespace *ns1;
+    struct Namespace *ns2;
+    size_t n = 1;
+    for (ns1 = soap->local_namespaces; ns1->id; ns1++)
+      n++;
+    n *= sizeof(struct Namespace);
+    ns2 = (struct Namespace*)SOAP_MALLOC(soap, n);
+    if (!ns2)
+      return SOAP_EOM;
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Copy on write of the shared namespace table\n"));
+    (void)soap_memcpy((void*)ns2, n, (const void*)soap->local_namespaces, n);
+    soap->local_namespaces = ns2;
+    soap->nsshared = 0;
   }
+  return SOAP_OK;
 }
 
 /******************************************************************************/
@@ -13423,10 +14696,10 @@ soap_element(struct soap *soap, const char *tag, int id, const char *type)
 #ifndef WITH_LEAN
     if (!soap->ns)
     {
-      if (!(soap->mode & SOAP_XML_CANONICAL) && soap_send(soap, soap->prolog))
+      if (!(soap->mode & SOAP_XML_CANONICAL) && !(soap->bxml & SOAP_BXML_OUT) && soap_send(soap, soap->prolog))
         return soap->error;
     }
-    else if ((soap->mode & SOAP_XML_INDENT))
+    else if ((soap->mode & SOAP_XML_INDENT) && !(soap->bxml & SOAP_BXML_OUT))
     {
       if (soap->ns == 1 && soap_send_raw(soap, soap_indent, soap->level < sizeof(soap_indent) ? soap->level : sizeof(soap_indent) - 1))
         return soap->error;
@@ -13446,9 +14719,16 @@ soap_element(struct soap *soap, const char *tag, int id, const char *type)
       {
         s = tag;
       }
-      if (soap_send_raw(soap, "<", 1)
-       || soap_send(soap, s))
+      if ((soap->bxml & SOAP_BXML_OUT))
+      {
+        if (soap_bxml_name_out(soap, SOAP_BXML_ELT, s, strlen(s)))
+          return soap->error;
+      }
+      else if (soap_send_raw(soap, "<", 1)
+            || soap_send(soap, s))
+      {
         return soap->error;
+      }
       if (n)
       {
         struct Namespace *ns = soap->local_namespaces;
@@ -13475,6 +14755,11 @@ soap_element(struct soap *soap, const char *tag, int id, const char *type)
       }
 #endif
     }
+    else if ((soap->bxml & SOAP_BXML_OUT))
+    {
+      if (soap_bxml_name_out(soap, SOAP_BXML_ELT, tag, strlen(tag)))
+        return soap->error;
+    }
     else
 #endif
     if (soap_send_raw(soap, "<", 1)
@@ -14029,6 +15314,15 @@ soap_element_start_end_out(struct soap *soap, const char *tag)
   {
     if (tp->visible)
     {
+#ifndef WITH_LEAN
+      if ((soap->bxml & SOAP_BXML_OUT))
+      {
+        if (soap_bxml_attribute_out(soap, tp->name, tp->visible == 2 && tp->value ? tp->value : SOAP_STR_EOS, tp->flag))
+          return soap->error;
+        tp->visible = 0;
+        continue;
+      }
+#endif
       if (soap_send_raw(soap, " ", 1) || soap_send(soap, tp->name))
         return soap->error;
       if (tp->visible == 2 && tp->value)
@@ -14061,8 +15355,16 @@ soap_element_start_end_out(struct soap *soap, const char *tag)
       soap_pop_namespace(soap);
     soap->level--;      /* decrement level just before /> */
     soap->body = 0;
+#ifndef WITH_LEAN
+    if ((soap->bxml & SOAP_BXML_OUT))
+      return soap_bxml_put(soap, SOAP_BXML_EMPTY);
+#endif
     return soap_send_raw(soap, "/>", 2);
   }
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_OUT))
+    return soap_bxml_put(soap, SOAP_BXML_GT);
+#endif
   return soap_send_raw(soap, ">", 1);
 }
 
@@ -14104,6 +15406,11 @@ soap_element_end(struct soap *soap, const char *tag)
 #ifndef WITH_LEAN
   if (soap->nlist)
     soap_pop_namespace(soap);
+  if ((soap->bxml & SOAP_BXML_OUT))
+  {
+    soap->level--;
+    return soap_bxml_put(soap, SOAP_BXML_END);
+  }
   if ((soap->mode & SOAP_XML_INDENT))
   {
     if (!soap->body)
@@ -14448,6 +15755,11 @@ soap_attribute(struct soap *soap, const char *name, const char *value)
       soap->level++;
     }
   }
+  else if ((soap->bxml & SOAP_BXML_OUT))
+  {
+    if (soap_bxml_attribute_out(soap, name, value ? value : SOAP_STR_EOS, 1))
+      return soap->error;
+  }
   else
 #endif
   {
@@ -14538,6 +15850,14 @@ soap_element_end_in(struct soap *soap, const char *tag)
       n++;
     soap->peeked = 0;
   }
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_IN))
+  {
+    if (soap_bxml_end_in(soap, n && soap->body))
+      return soap->error;
+    goto end;
+  }
+#endif
   do
   {
     while (((c = soap_get(soap)) != SOAP_TT))
@@ -14579,6 +15899,7 @@ soap_element_end_in(struct soap *soap, const char *tag)
   if (c != SOAP_GT)
     return soap->error = SOAP_SYNTAX_ERROR;
 #ifndef WITH_LEAN
+end:
 #ifdef WITH_DOM
   if (soap->feltendin)
   {
@@ -15048,6 +16369,14 @@ soap_peek_element(struct soap *soap)
   soap->position = 0;
   soap->null = 0;
   soap->mustUnderstand = 0;
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_IN))
+  {
+    if (soap_bxml_element_in(soap))
+      return soap->error;
+    goto attrs;
+  }
+#endif
   /* UTF-8 BOM? */
   c = soap_getchar(soap);
   if (c == 0xEF && soap_get0(soap) == 0xBB)
@@ -15421,6 +16750,9 @@ soap_peek_element(struct soap *soap)
     if (!soap->body && soap->dom->prnt)
       soap->dom = soap->dom->prnt;
   }
+#endif
+#ifndef WITH_LEAN
+attrs:
 #endif
   for (tp = soap->attributes; tp; tp = tp->next)
   {
@@ -15591,962 +16923,1296 @@ soap_revert(struct soap *soap)
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_ignore(struct soap *soap)
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+/* returns the end of the XML element that starts at s in s[0..e-s-1], or NULL when the element is incomplete or has an id, href or ref attribute and idref is set */
+static const char *
+soap_scan_element(const char *s, const char *e, int idref)
 {
   int n = 0;
-  soap_wchar c;
-  soap->level++;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Ignoring XML content at level=%u\n", soap->level));
-#ifdef WITH_DOM
-  if ((soap->mode & SOAP_XML_DOM) && soap->dom)
-  {
-    if (!soap_string_in(soap, -1, -1, -1, NULL))
-      return soap->error;
-  }
-  else
-#endif
+  while (s < e)
   {
-    for (;;)
+    s = (const char*)memchr(s, '<', e - s);
+    if (!s || s + 1 >= e)
+      return NULL;
+    if (s[1] == '/')
     {
-      c = soap_get(soap);
-      switch (c)
-      {
-        case SOAP_TT:
-          if (n == 0)
-            goto end;
-          n--;
-          break;
-        case SOAP_LT:
-          n++;
+      s = (const char*)memchr(s, '>', e - s);
+      if (!s)
+        return NULL;
+      s++;
+      if (--n <= 0)
+        return s;
+    }
+    else if (s[1] == '!' || s[1] == '?')
+    {
+      const char *t = ">";
+      const char *b = s + 2;
+      size_t k;
+      if (s[1] == '?')
+        t = "?>";
+      else if (e - s >= 4 && s[2] == '-' && s[3] == '-')
+        t = "-->", b = s + 4;
+      else if (e - s >= 9 && !strncmp(s + 2, "[CDATA[", 7))
+        t = "]]>", b = s + 9;
+      k = strlen(t);
+      for (s = b; ; s++)
+      {
+        s = (const char*)memchr(s, '>', e - s);
+        if (!s)
+          return NULL;
+        if ((size_t)(s - b) >= k - 1 && !strncmp(s - k + 1, t, k))
           break;
-        case '/':
-          if (n > 0)
-          {
-            c = soap_get0(soap);
-            if (c == '>')
-              n--;
-          }
+      }
+      s++;
+    }
+    else
+    {
+      for (s++; ; s++)
+      {
+        if (s >= e)
+          return NULL;
+        if (*s == '>')
           break;
-        default:
-          if ((int)c == EOF)
-            return soap->error = SOAP_EOF;
+        if (*s == '"' || *s == '\'')
+        {
+          s = (const char*)memchr(s + 1, *s, e - s - 1);
+          if (!s)
+            return NULL;
+        }
+        else if (idref && soap_coblank((soap_wchar)*s))
+        {
+          const char *t;
+          while (s + 1 < e && soap_coblank((soap_wchar)s[1]))
+            s++;
+          for (t = s + 1; s + 1 < e && s[1] != '=' && s[1] != '>' && s[1] != '/' && !soap_coblank((soap_wchar)s[1]); s++)
+            if (s[1] == ':')
+              t = s + 2;
+          /* id, href and ref attributes, with or without prefix, are (multi)references that slices cannot resolve */
+          if ((s + 1 - t == 2 && !strncmp(t, "id", 2))
+           || (s + 1 - t == 4 && !strncmp(t, "href", 4))
+           || (s + 1 - t == 3 && !strncmp(t, "ref", 3)))
+            return NULL;
+        }
       }
+      if (s[-1] != '/')
+        n++;
+      s++;
+      if (n == 0)
+        return s;
     }
-end:
-    soap_unget(soap, c);
   }
-  return soap_element_end_in(soap, NULL);
+  return NULL;
 }
+#endif
 
 /******************************************************************************/
 
 SOAP_FMAC1
-int
+size_t
 SOAP_FMAC2
-soap_string_out(struct soap *soap, const char *s, int flag)
-{
-  const char *t;
-  soap_wchar c;
-  soap_wchar mask = (soap_wchar)0xFFFFFF80UL;
-#ifdef WITH_DOM
-  if ((soap->mode & SOAP_XML_DOM) && soap->dom)
-  {
-    soap->dom->text = soap_strdup(soap, s);
-    if (!soap->dom->text)
-      return soap->error = SOAP_EOM;
-    return SOAP_OK;
-  }
+soap_begin_slices(struct soap *soap, struct soap_slices *sp, size_t size)
+{
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+  size_t off[2 * SOAP_MAXSLICES], idx[2 * SOAP_MAXSLICES];
+  size_t gap = SOAP_SLICELEN, n = 0, k = 0, l, i;
+  const char *s, *t, *e;
+  int idref;
+  /* slices are scanned in the in-situ buffer after the start tag of the first item was peeked */
+  if (!soap->fparallel || soap->fitemin || !soap->insitu || !soap->peeked || soap->ahead || soap->cdata || !*soap->tag || !size
+   || (soap->mode & (SOAP_XML_DOM | SOAP_ENC_DIME | SOAP_ENC_MIME | SOAP_ENC_ZLIB))
+   || (soap->bxml & SOAP_BXML_IN))
+    return 0;
+#ifndef WITH_LEANER
+  if (soap->fpreparerecv || soap->ffilterrecv || soap->feltbegin || soap->feltendin)
+    return 0;
 #endif
-  if (flag == 2 || (soap->mode & SOAP_C_UTFSTRING))
-    mask = 0;
-  t = s;
-  while ((c = *t++))
+  e = soap->isbuf + soap->islen;
+  if (soap->insitu + soap->bufidx > e || e - (soap->insitu + soap->bufidx) < 2 * SOAP_SLICELEN)
+    return 0;
+  s = soap->insitu + soap->bufidx;
+  do
   {
-    switch (c)
+    if (s == soap->isbuf)
+      return 0;
+  } while (*--s != '<');
+  l = strlen(soap->tag);
+  if ((size_t)(e - s) <= l + 1 || strncmp(s + 1, soap->tag, l) || !(soap_coblank((soap_wchar)s[l + 1]) || s[l + 1] == '/' || s[l + 1] == '>'))
+    return 0;
+  idref = (soap->version > 0 && !(soap->imode & SOAP_XML_TREE)) || (soap->mode & (SOAP_XML_GRAPH | SOAP_ENC_MTOM));
+  for (;;)
+  {
+    /* keep at most 2 * SOAP_MAXSLICES checkpoints at least gap bytes apart, thinning them out when full */
+    if (k == 0 || (size_t)(s - soap->isbuf) - off[k - 1] >= gap)
     {
-    case 0x09:
-      if (flag)
-      {
-        if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&#x9;", 5))
-          return soap->error;
-        s = t;
-      }
-      break;
-    case 0x0A:
-      if (flag)
-      {
-        if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&#xA;", 5))
-          return soap->error;
-        s = t;
-      }
-      break;
-#ifdef WITH_CRTOLF
-    case 0x0D:
-      if (*t == 0x0A)
-      {
-        if (soap_send_raw(soap, s, t - s - 1))
-          return soap->error;
-        s = t;
-      }
-      else if (flag)
-      {
-        if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&#xA;", 5))
-          return soap->error;
-        s = t;
-      }
-      else
-      {
-        if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "\n", 1))
-          return soap->error;
-        s = t;
-      }
-      break;
-#endif
-    case '&':
-      if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&amp;", 5))
-        return soap->error;
-      s = t;
-      break;
-    case '<':
-      if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&lt;", 4))
-        return soap->error;
-      s = t;
-      break;
-    case '>':
-      if (!flag)
-      {
-        if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&gt;", 4))
-          return soap->error;
-        s = t;
-      }
-      break;
-    case '"':
-      if (flag)
-      {
-        if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&quot;", 6))
-          return soap->error;
-        s = t;
-      }
-      break;
-    case 0x7F:
-      if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&#x7F;", 6))
-        return soap->error;
-      s = t;
-      break;
-    default:
-#ifndef WITH_LEANER
-#ifdef HAVE_MBTOWC
-      if ((soap->mode & SOAP_C_MBSTRING))
+      if (k == 2 * SOAP_MAXSLICES)
       {
-        wchar_t wc;
-        int m = mbtowc(&wc, t - 1, MB_CUR_MAX);
-        if (m > 0 && !((soap_wchar)wc == c && m == 1 && c < 0x80))
+        for (i = 0; i < SOAP_MAXSLICES; i++)
         {
-          if (soap_send_raw(soap, s, t - s - 1) || soap_pututf8(soap, (unsigned long)wc))
-            return soap->error;
-          s = t += m - 1;
-          continue;
+          off[i] = off[2 * i];
+          idx[i] = idx[2 * i];
         }
+        k = SOAP_MAXSLICES;
+        gap *= 2;
       }
+      off[k] = s - soap->isbuf;
+      idx[k] = n;
+      k++;
+    }
+    t = soap_scan_element(s, e, idref);
+    if (!t)
+      return 0;
+    if (++n > soap->maxoccurs)
+      return 0;
+    for (s = t; s < e && soap_coblank((soap_wchar)*s); s++)
+      continue;
+    if ((size_t)(e - s) <= l + 1 || *s != '<' || strncmp(s + 1, soap->tag, l) || !(soap_coblank((soap_wchar)s[l + 1]) || s[l + 1] == '/' || s[l + 1] == '>'))
+      break;
+  }
+  if (n < 2 || n > (~(size_t)0) / size || (SOAP_MAXALLOCSIZE > 0 && n * size > SOAP_MAXALLOCSIZE))
+    return 0;
+  l = (size_t)(t - soap->isbuf) - off[0];
+  l /= SOAP_SLICELEN;
+  if (l > k)
+    l = k;
+  if (l > SOAP_MAXSLICES)
+    l = SOAP_MAXSLICES;
+  if (l < 2)
+    return 0;
+  for (i = 0; i < l; i++)
+  {
+    sp->off[i] = off[i * k / l];
+    sp->idx[i] = idx[i * k / l];
+  }
+  sp->off[l] = t - soap->isbuf;
+  sp->idx[l] = n;
+  sp->len = (int)l;
+  sp->num = n;
+  sp->size = size;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Found %lu items '%s' in %lu bytes split in %d slices\n", (unsigned long)n, soap->tag, (unsigned long)(sp->off[l] - sp->off[0]), sp->len));
+  return n;
+#else
+  (void)soap; (void)sp; (void)size;
+  return 0;
 #endif
+}
+
+/******************************************************************************/
+
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+/* a slice of items (de)serialized by a context copy, see soap_in_slices() and soap_out_slices() */
+struct soap_slice
+{
+  struct soap *soap;
+  const char *tag;
+  const char *type;
+  char *p;
+  const char *q;
+  size_t num;
+  size_t size;
+  void *(*fin)(struct soap*, const char*, void*, const char*);
+  int (*fout)(struct soap*, const char*, const void*, const char*);
+};
 #endif
-#ifndef WITH_NOSTRINGTOUTF8
-      if ((c & mask) || !(c & 0xFFFFFFE0UL))
-      {
-        if (soap_send_raw(soap, s, t - s - 1) || soap_pututf8(soap, (unsigned char)c))
-          return soap->error;
-        s = t;
-      }
-#endif
+
+/******************************************************************************/
+
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+static int
+soap_slice_in(void *arg)
+{
+  struct soap_slice *sp = (struct soap_slice*)arg;
+  struct soap *soap = sp->soap;
+  size_t i;
+  for (i = 0; i < sp->num; i++)
+  {
+    if (!sp->fin(soap, sp->tag, (void*)(sp->p + i * sp->size), sp->type))
+    {
+      if (!soap->error)
+        soap->error = SOAP_SYNTAX_ERROR;
+      return soap->error;
     }
   }
-  return soap_send_raw(soap, s, t - s - 1);
+  return soap->error = SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-char *
-SOAP_FMAC2
-soap_string_in(struct soap *soap, int flag, long minlen, long maxlen, const char *pattern)
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+static int
+soap_slice_out(void *arg)
 {
-  char *s = NULL;
-  char *t = NULL;
+  struct soap_slice *sp = (struct soap_slice*)arg;
+  struct soap *soap = sp->soap;
   size_t i;
-  ULONG64 l = 0;
-  int n = 0, f = 0, m = 0;
-  soap_wchar c;
-#if !defined(WITH_LEANER) && defined(HAVE_WCTOMB)
-  char buf[MB_LEN_MAX > 8 ? MB_LEN_MAX : 8];
-#else
-  char buf[8];
+  for (i = 0; i < sp->num; i++)
+  {
+    if (sp->fout(soap, sp->tag, (const void*)(sp->q + i * sp->size), sp->type))
+      return soap->error;
+  }
+  /* store the buffered output in the block sequence */
+  if (soap->bufidx && soap_flush(soap))
+    return soap->error;
+  return soap->error = SOAP_OK;
+}
 #endif
-  if (maxlen < 0 && soap->maxlength > 0)
-    maxlen = soap->maxlength;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Reading string content, flag=%d\n", flag));
-  if (flag <= 0 && soap->peeked && *soap->tag)
+
+/******************************************************************************/
+
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+/* clone the namespace bindings below level, the outermost first */
+static int
+soap_copy_nlist(struct soap *copy, const struct soap_nlist *np, unsigned int level)
+{
+  struct soap_nlist *nq;
+  size_t n, k;
+  if (!np)
+    return SOAP_OK;
+  if (soap_copy_nlist(copy, np->next, level))
+    return copy->error;
+  if (np->level >= level)
+    return SOAP_OK;
+  n = strlen(np->id);
+  k = np->ns ? strlen(np->ns) + 1 : 0;
+  nq = (struct soap_nlist*)SOAP_MALLOC(copy, sizeof(struct soap_nlist) + n + k);
+  if (!nq)
+    return copy->error = SOAP_EOM;
+  nq->next = copy->nlist;
+  nq->level = np->level;
+  nq->index = np->index;
+  (void)soap_memcpy((void*)nq->id, n + 1, (const void*)np->id, n);
+  ((char*)nq->id)[n] = '\0';
+  if (np->ns)
+  {
+    nq->ns = nq->id + n + 1;
+    (void)soap_memcpy((void*)nq->ns, k, (const void*)np->ns, k - 1);
+    ((char*)nq->ns)[k - 1] = '\0';
+  }
+  else
   {
-#ifndef WITH_LEAN
-    struct soap_attribute *tp;
-    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String content includes tag '%s' and attributes\n", soap->tag));
-    t = soap->tmpbuf;
-    *t = '<';
-    soap_strcpy(t + 1, sizeof(soap->tmpbuf) - 1, soap->tag);
-    t += strlen(t);
-    for (tp = soap->attributes; tp; tp = tp->next)
+    nq->ns = NULL;
+  }
+  copy->nlist = nq;
+  return SOAP_OK;
+}
+#endif
+
+/******************************************************************************/
+
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+/* clone the marked pointers, which are on the path to the current element, the copy marks with mark2 */
+static int
+soap_copy_pht(struct soap *copy, const struct soap *soap)
+{
+  size_t i;
+  for (i = 0; i < soap->phtsize; i++)
+  {
+    const struct soap_plist *pp = soap->pht[i];
+    if (pp && (pp->mark1 || pp->mark2))
     {
-      if (tp->visible)
-      {
-        size_t k = strlen(tp->name);
-        if (t + k + 1 >= soap->tmpbuf + sizeof(soap->tmpbuf))
-          break; /* too many or attribute values to large */
-        *t++ = ' ';
-        (void)soap_strncpy(t, sizeof(soap->tmpbuf) - (t - soap->tmpbuf), tp->name, k);
-        t += k;
-        if (tp->value)
-        {
-          k = strlen(tp->value);
-          if (t + k + 3 >= soap->tmpbuf + sizeof(soap->tmpbuf))
-            break; /* too many or attribute values to large */
-          *t++ = '=';
-          *t++ = '"';
-          (void)soap_strncpy(t, sizeof(soap->tmpbuf) - (t - soap->tmpbuf), tp->value, k);
-          t += k;
-          *t++ = '"';
-        }
-      }
+      struct soap_plist *pq;
+      if (!soap_pointer_enter(copy, pp->ptr, pp->array, pp->size, pp->type, &pq))
+        return copy->error;
+      pq->mark1 = pp->mark1;
+      pq->mark2 = (soap->mode & SOAP_IO_LENGTH) ? pp->mark1 : pp->mark2;
     }
-    if (!soap->body)
-      *t++ = '/';
-    *t++ = '>';
-    *t = '\0';
-    t = soap->tmpbuf;
-    m = (int)strlen(soap->tmpbuf);
+  }
+  return SOAP_OK;
+}
 #endif
-    if (soap->body)
-      n = 1;
-    f = 1;
-    soap->peeked = 0;
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_in_slices(struct soap *soap, const char *tag, const struct soap_slices *sp, void *p, void *(*fin)(struct soap*, const char*, void*, const char*), const char *type)
+{
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+  struct soap_slice slice[SOAP_MAXSLICES];
+  void *job[SOAP_MAXSLICES];
+  int i, len, ret = SOAP_OK, err = SOAP_OK;
+  for (len = 0; len < sp->len; len++)
+  {
+    struct soap *copy = soap_copy(soap);
+    if (!copy)
+    {
+      err = SOAP_EOM;
+      break;
+    }
+    slice[len].soap = copy;
+    slice[len].tag = tag;
+    slice[len].type = type;
+    slice[len].p = (char*)p + sp->idx[len] * sp->size;
+    slice[len].num = sp->idx[len + 1] - sp->idx[len];
+    slice[len].size = sp->size;
+    slice[len].fin = fin;
+    job[len] = (void*)&slice[len];
+    /* the copy reads its slice from the in-situ buffer at the current element level and namespace scope */
+    copy->isbuf = soap->isbuf + sp->off[len];
+    copy->islen = sp->off[len + 1] - sp->off[len];
+    copy->isidx = 0;
+    copy->insitu = NULL;
+    copy->bufidx = 0;
+    copy->buflen = 0;
+    copy->ahead = 0;
+    copy->cdata = 0;
+    copy->peeked = 0;
+    copy->count = 0;
+    copy->level = soap->level;
+    copy->master = SOAP_INVALID_SOCKET;
+    copy->socket = SOAP_INVALID_SOCKET;
+    copy->fdisconnect = NULL;
+    copy->fclose = NULL;
+    copy->fparallel = NULL;
+    if (soap_copy_nlist(copy, soap->nlist, soap->level))
+    {
+      err = copy->error;
+      len++;
+      break;
+    }
   }
-#ifdef WITH_CDATA
-  if (flag <= 0)
+  if (!err)
   {
-    int state = 0;
-#ifdef WITH_FAST
-    soap->labidx = 0;                   /* use look-aside buffer */
-#else
-    if (soap_alloc_block(soap) == NULL)
-      return NULL;
-#endif
-    for (;;)
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Parallel deserialization of %lu items '%s' in %d slices\n", (unsigned long)sp->num, tag, len));
+    ret = soap->fparallel(soap, soap_slice_in, job, len);
+  }
+  for (i = 0; i < len; i++)
+  {
+    struct soap *copy = slice[i].soap;
+    if (copy->error && !err)
     {
-#ifdef WITH_FAST
-      size_t k;
-      if (soap_append_lab(soap, NULL, 0))       /* allocate more space in look-aside buffer if necessary */
-        return NULL;
-      s = soap->labbuf + soap->labidx;  /* space to populate */
-      k = soap->lablen - soap->labidx;  /* number of bytes available */
-      soap->labidx = soap->lablen;      /* claim this space */
+      /* report the error of the first slice that failed */
+      err = copy->error;
+      soap_strcpy(soap->tag, sizeof(soap->tag), copy->tag);
+    }
+    /* the items refer to data allocated by the copies, which is managed by the context from now on */
+    soap_lazy_merge(soap, copy);
+    soap_delegate_deletion(copy, soap);
+    soap_destroy(copy);
+    soap_end(copy);
+    soap_free(copy);
+  }
+  if (!err)
+    err = ret;
+  if (err)
+    return soap->error = err;
+  /* continue after the last item */
+  if (sp->off[len] <= soap->isidx)
+  {
+    soap->bufidx = sp->off[len] - (soap->insitu - soap->isbuf);
+  }
+  else
+  {
+    soap->count += sp->off[len] - soap->isidx;
+    soap->isidx = sp->off[len];
+    soap->bufidx = 0;
+    soap->buflen = 0;
+    soap->insitu = NULL;
+  }
+  soap->peeked = 0;
+  soap->ahead = 0;
+  if (soap->recv_maxlength && soap->count > soap->recv_maxlength)
+    return soap->error = SOAP_EOF;
+  return SOAP_OK;
 #else
-      size_t k = SOAP_BLKLEN;
-      s = (char*)soap_push_block(soap, NULL, k);
-      if (!s)
-        return NULL;
+  (void)tag; (void)sp; (void)p; (void)fin; (void)type;
+  return soap->error = SOAP_EOM;
 #endif
-      for (i = 0; i < k; i++)
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+size_t
+SOAP_FMAC2
+soap_out_slices(struct soap *soap, const char *tag, const void *p, size_t num, size_t size, int (*fout)(struct soap*, const char*, const void*, const char*), const char *type)
+{
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+  struct soap_slice slice[SOAP_MAXSLICES];
+  void *job[SOAP_MAXSLICES];
+  size_t n = num / SOAP_SLICENUM;
+  int i, len, ret = SOAP_OK, err = SOAP_OK;
+  /* items are serialized without id-ref, after the namespace table was sent, and not produced by soap::fitemout */
+  if (!soap->fparallel || soap->fitemout || !p || !size || soap->error || soap->ns != 1
+   || (soap->mode & (SOAP_XML_DOM | SOAP_XML_GRAPH | SOAP_XML_DEFAULTNS | SOAP_ENC_DIME | SOAP_ENC_MIME | SOAP_ENC_MTOM))
+   || (soap->encodingStyle && !(soap->mode & SOAP_XML_TREE))
+   || (soap->bxml & SOAP_BXML_OUT))
+    return 0;
+#ifndef WITH_LEANER
+  if (soap->feltbegout || soap->feltendout)
+    return 0;
+#endif
+  if (n < 2)
+    return 0;
+  if (n > SOAP_MAXSLICES)
+    n = SOAP_MAXSLICES;
+  for (len = 0; len < (int)n; len++)
+  {
+    struct soap *copy = soap_copy(soap);
+    size_t k = num / n;
+    if (!copy)
+    {
+      err = SOAP_EOM;
+      break;
+    }
+    slice[len].soap = copy;
+    slice[len].tag = tag;
+    slice[len].type = type;
+    slice[len].q = (const char*)p + len * k * size;
+    slice[len].num = len + 1 < (int)n ? k : num - len * k;
+    slice[len].size = size;
+    slice[len].fout = fout;
+    job[len] = (void*)&slice[len];
+    /* the copy stores its output at the current element level and namespace scope, also when the length is counted */
+    copy->mode = (soap->mode & ~(SOAP_IO | SOAP_IO_LENGTH | SOAP_ENC_ZLIB)) | SOAP_IO_STORE;
+    copy->bufidx = 0;
+    copy->count = 0;
+    copy->master = SOAP_INVALID_SOCKET;
+    copy->socket = SOAP_INVALID_SOCKET;
+    copy->fdisconnect = NULL;
+    copy->fclose = NULL;
+    copy->fparallel = NULL;
+#ifndef WITH_LEANER
+    copy->fpreparesend = NULL;
+    copy->ffiltersend = NULL;
+#endif
+    if (soap_copy_nlist(copy, soap->nlist, soap->level + 1)
+     || soap_copy_pht(copy, soap)
+     || !soap_alloc_block(copy))
+    {
+      err = copy->error;
+      len++;
+      break;
+    }
+  }
+  if (!err)
+  {
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Parallel serialization of %lu items '%s' in %d slices\n", (unsigned long)num, tag ? tag : SOAP_STR_EOS, len));
+    ret = soap->fparallel(soap, soap_slice_out, job, len);
+  }
+  for (i = 0; i < len; i++)
+  {
+    struct soap *copy = slice[i].soap;
+    if (copy->error && !err)
+      err = copy->error;
+    if (!err && !ret)
+    {
+      /* send the stored output of the slices in sequence */
+      char *s;
+      for (s = soap_first_block(copy, NULL); s; s = soap_next_block(copy, NULL))
       {
-        if (m > 0)
+        if (soap_send_raw(soap, s, soap_block_size(copy, NULL)))
         {
-          *s++ = *t++;  /* copy multibyte characters */
-          m--;
-          continue;
+          err = soap->error;
+          break;
         }
-        c = soap_getchar(soap);
-        if ((int)c == EOF)
-          goto end;
-        if ((c >= 0x80 || c < SOAP_AP) && state != 1)
-        {
-          if ((c & 0x7FFFFFFF) >= 0x80)
+      }
+      soap->body = copy->body;
+    }
+    soap_destroy(copy);
+    soap_end(copy);
+    soap_free(copy);
+  }
+  if (!err)
+    err = ret;
+  if (err)
+  {
+    soap->error = err;
+    return 0;
+  }
+  return num;
+#else
+  (void)soap; (void)tag; (void)p; (void)num; (void)size; (void)fout; (void)type;
+  return 0;
+#endif
+}
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* skips raw XML content up to and including the '</' of the end tag of the current element, only balances tags and skips quoted attribute values, comments, CDATA, PIs and declarations without decoding, namespace handling or allocation, appends the content skipped to the look-aside buffer when save is set */
+static int
+soap_skip(struct soap *soap, int save)
+{
+  const char *t = NULL; /* pattern matched after '<!' or the terminator matched of a comment, CDATA, PI or declaration */
+  size_t k = 0;         /* number of chars of t matched */
+  size_t n = 0;         /* element nesting depth */
+  size_t d = 0;         /* '<' nesting depth in a declaration */
+  int state = 0;
+  char q = 0;           /* quote of an attribute value */
+  char p = 0;           /* last char in a start tag, '/' for an empty element */
+  for (;;)
+  {
+    const char *s, *e;
+    if (soap->bufidx >= soap->buflen && soap_recv(soap))
+      return soap->error = SOAP_EOF;
+    s = soap->ibuf + soap->bufidx;
+    e = soap->ibuf + soap->buflen;
+    while (s < e)
+    {
+      char c;
+      switch (state)
+      {
+        case 0: /* content */
+          s = (const char*)memchr(s, '<', e - s);
+          if (!s)
           {
-            soap_unget(soap, c);
-            c = soap_getutf8(soap);
+            s = e;
+            break;
           }
-          if ((c & 0x7FFFFFFF) >= 0x80 && (flag <= 0 || (soap->mode & SOAP_C_UTFSTRING)))
+          s++;
+          state = 1;
+          break;
+        case 1: /* after '<' */
+          c = *s++;
+          if (c == '/')
           {
-            c &= 0x7FFFFFFF;
-            t = buf;
-            if (c < 0x0800)
-              *t++ = (char)(0xC0 | ((c >> 6) & 0x1F));
-            else
+            if (n == 0)
             {
-#ifdef WITH_REPLACE_ILLEGAL_UTF8
-              if (!((c >= 0x80 && c <= 0xD7FF) || (c >= 0xE000 && c <= 0xFFFD) || (c >= 0x10000 && c <= 0x10FFFF)))
-                c = SOAP_UNKNOWN_UNICODE_CHAR;
-#endif
-              if (c < 0x010000)
-              {
-                *t++ = (char)(0xE0 | ((c >> 12) & 0x0F));
-              }
-              else
+              if (save)
               {
-                if (c < 0x200000)
-                {
-                  *t++ = (char)(0xF0 | ((c >> 18) & 0x07));
-                }
-                else
-                {
-                  if (c < 0x04000000)
-                  {
-                    *t++ = (char)(0xF8 | ((c >> 24) & 0x03));
-                  }
-                  else
-                  {
-                    *t++ = (char)(0xFC | ((c >> 30) & 0x01));
-                    *t++ = (char)(0x80 | ((c >> 24) & 0x3F));
-                  }
-                  *t++ = (char)(0x80 | ((c >> 18) & 0x3F));
-                }
-                *t++ = (char)(0x80 | ((c >> 12) & 0x3F));
+                if (soap_append_lab(soap, soap->ibuf + soap->bufidx, s - soap->ibuf - soap->bufidx))
+                  return soap->error;
+                soap->labidx -= 2; /* remove '</' */
               }
-              *t++ = (char)(0x80 | ((c >> 6) & 0x3F));
+              soap->bufidx = s - soap->ibuf;
+              return SOAP_OK;
             }
-            *t++ = (char)(0x80 | (c & 0x3F));
-            m = (int)(t - buf) - 1;
-            t = buf;
-            *s++ = *t++;
-            continue;
+            state = 4;
+          }
+          else if (c == '!')
+          {
+            t = NULL;
+            k = 0;
+            state = 5;
+          }
+          else if (c == '?')
+          {
+            t = "?>";
+            k = 0;
+            state = 6;
+          }
+          else if (c == '%')
+          {
+            d = 0;
+            state = 7;
+          }
+          else if (!soap_coblank((soap_wchar)c))
+          {
+            p = c;
+            state = 2;
           }
-        }
-        switch (state)
-        {
-          case 1:
-            if (c == ']')
-              state = 4;
-            *s++ = (char)c;
-            continue;
-          case 2:
-            if (c == '-')
-              state = 6;
-            *s++ = (char)c;
-            continue;
-          case 3:
-            if (c == '?')
-              state = 8;
-            *s++ = (char)c;
-            continue;
-          /* CDATA */
-          case 4:
-            if (c == ']')
-              state = 5;
-            else
-              state = 1;
-            *s++ = (char)c;
-            continue;
-          case 5:
-            if (c == '>')
-              state = 0;
-            else if (c != ']')
-              state = 1;
-            *s++ = (char)c;
-            continue;
-          /* comment */
-          case 6:
-            if (c == '-')
-              state = 7;
-            else
-              state = 2;
-            *s++ = (char)c;
-            continue;
-          case 7:
-            if (c == '>')
-              state = 0;
-            else if (c != '-')
-              state = 2;
-            *s++ = (char)c;
-            continue;
-          /* PI */
-          case 8:
-            if (c == '>')
-              state = 0;
-            else if (c != '?')
-              state = 3;
-            *s++ = (char)c;
-            continue;
-        }
-        switch (c)
-        {
-        case SOAP_TT:
-          if (n == 0)
-            goto end;
-          n--;
-          *s++ = '<';
-          t = (char*)"/";
-          m = 1;
-          break;
-        case SOAP_LT:
-          if (flag == 3 || (f && n == 0))
-            goto end;
-          n++;
-          *s++ = '<';
-          break;
-        case SOAP_GT:
-          *s++ = '>';
-          break;
-        case SOAP_QT:
-          *s++ = '"';
-          break;
-        case SOAP_AP:
-          *s++ = '\'';
           break;
-        case '/':
-          if (n > 0)
+        case 2: /* start tag */
+          c = *s++;
+          if (c == '>')
           {
-            c = soap_getchar(soap);
-            if (c == '>')
-              n--;
-            soap_unget(soap, c);
+            if (p != '/')
+              n++;
+            state = 0;
+          }
+          else if (c == '"' || c == '\'')
+          {
+            q = c;
+            state = 3;
+          }
+          else if (!soap_coblank((soap_wchar)c))
+          {
+            p = c;
           }
-          *s++ = '/';
           break;
-        case '<':
-          c = soap_getchar(soap);
-          if (c == '/')
+        case 3: /* quoted attribute value */
+          s = (const char*)memchr(s, q, e - s);
+          if (!s)
           {
-            if (n == 0)
-            {
-              c = SOAP_TT;
-              goto end;
-            }
-            n--;
+            s = e;
+            break;
           }
-          else if (c == '!')
+          s++;
+          p = q;
+          state = 2;
+          break;
+        case 4: /* end tag */
+          s = (const char*)memchr(s, '>', e - s);
+          if (!s)
           {
-            c = soap_getchar(soap);
-            if (c == '[')
-            {
-              do
-              {
-                c = soap_getchar(soap);
-              } while ((int)c != EOF && c != '[');
-              if ((int)c == EOF)
-                 goto end;
-              t = (char*)"![CDATA[";
-              m = 8;
-              state = 1;
-            }
-            else if (c == '-')
-            {
-              c = soap_getchar(soap);
-              if (c == '-')
-                state = 2;
-              t = (char*)"!-";
-              m = 2;
-              soap_unget(soap, c);
-            }
-            else
-            {
-              t = (char*)"!";
-              m = 1;
-              soap_unget(soap, c);
-            }
-            *s++ = '<';
+            s = e;
             break;
           }
-          else if (c == '?')
+          s++;
+          n--;
+          state = 0;
+          break;
+        case 5: /* after '<!', match "--" or "[CDATA[" */
+          c = *s;
+          if (!t)
           {
-            state = 3;
+            if (c == '-')
+              t = "--";
+            else if (c == '[')
+              t = "[CDATA[";
           }
-          else if (flag == 3 || (f && n == 0))
+          if (t && c == t[k])
           {
-            soap_revget1(soap);
-            c = '<';
-            goto end;
+            s++;
+            if (t[++k])
+              break;
+            t = *t == '-' ? "-->" : "]]>";
+            k = 0;
+            state = 6;
           }
           else
-            n++;
-          soap_unget(soap, c);
-          *s++ = '<';
-          break;
-        case '>':
-          *s++ = '>';
-          break;
-        case '"':
-          *s++ = '"';
+          {
+            d = 0;
+            state = 7;
+          }
           break;
-        default:
-#ifndef WITH_LEANER
-#ifdef HAVE_WCTOMB
-          if ((soap->mode & SOAP_C_MBSTRING))
+        case 6: /* comment, CDATA or PI up to terminator t of the form x...x> */
+          if (k == 0)
           {
-#if defined(WIN32) && !defined(CYGWIN) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(__BORLANDC__)
-            m = 0;
-            wctomb_s(&m, buf, sizeof(buf), (wchar_t)(c & 0x7FFFFFFF));
-#else
-            m = wctomb(buf, (wchar_t)(c & 0x7FFFFFFF));
-#endif
-            if (m >= 1 && m <= (int)MB_CUR_MAX)
+            s = (const char*)memchr(s, *t, e - s);
+            if (!s)
             {
-              t = buf;
-              *s++ = *t++;
-              m--;
+              s = e;
+              break;
             }
+          }
+          c = *s++;
+          if (c == t[k])
+          {
+            if (!t[++k])
+              state = 0;
+          }
+          else if (c != *t)
+          {
+            k = 0;
+          }
+          break;
+        case 7: /* declaration */
+          c = *s++;
+          if (c == '<')
+          {
+            d++;
+          }
+          else if (c == '>')
+          {
+            if (d == 0)
+              state = 0;
             else
-            {
-              *s++ = SOAP_UNKNOWN_CHAR;
-              m = 0;
-            }
+              d--;
           }
-          else
+          break;
+      }
+    }
+    if (save && soap_append_lab(soap, soap->ibuf + soap->bufidx, soap->buflen - soap->bufidx))
+      return soap->error;
+    soap->bufidx = soap->buflen;
+  }
+}
+#endif
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_ignore(struct soap *soap)
+{
+  int n = 0;
+  soap_wchar c;
+  soap->level++;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Ignoring XML content at level=%u\n", soap->level));
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_IN))
+    return soap_element_end_in(soap, NULL);
 #endif
+#ifdef WITH_DOM
+  if ((soap->mode & SOAP_XML_DOM) && soap->dom)
+  {
+    if (!soap_string_in(soap, -1, -1, -1, NULL))
+      return soap->error;
+  }
+  else
 #endif
-            *s++ = (char)(c & 0xFF);
-        }
-        l++;
-        if (maxlen >= 0 && l > (size_t)maxlen)
+  {
+#ifndef WITH_LEAN
+    /* skip raw content unless a char was pushed back or we are in CDATA */
+    if (!soap->ahead && !soap->cdata)
+    {
+      if (soap_skip(soap, 0))
+        return soap->error;
+      c = SOAP_TT;
+      goto end;
+    }
+#endif
+    for (;;)
+    {
+      c = soap_get(soap);
+      switch (c)
+      {
+        case SOAP_TT:
+          if (n == 0)
+            goto end;
+          n--;
+          break;
+        case SOAP_LT:
+          n++;
+          break;
+        case '/':
+          if (n > 0)
+          {
+            c = soap_get0(soap);
+            if (c == '>')
+              n--;
+          }
+          break;
+        default:
+          if ((int)c == EOF)
+            return soap->error = SOAP_EOF;
+      }
+    }
+end:
+    soap_unget(soap, c);
+  }
+  return soap_element_end_in(soap, NULL);
+}
+
+/******************************************************************************/
+
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+/* appends attribute value s to the look-aside buffer as XML, chars that are not UTF-8 encoded are appended as char references */
+static int
+soap_append_lab_attr(struct soap *soap, const char *s)
+{
+  const char *t;
+  for (t = s; *t; t++)
+  {
+    const char *r;
+    char tmp[8];
+    switch (*t)
+    {
+      case '&':
+        r = "&amp;";
+        break;
+      case '<':
+        r = "&lt;";
+        break;
+      case '"':
+        r = "&quot;";
+        break;
+      case '\t':
+        r = "&#x9;";
+        break;
+      case '\n':
+        r = "&#xA;";
+        break;
+      case '\r':
+        r = "&#xD;";
+        break;
+      default:
+        if ((*t & 0x80) && !(soap->mode & SOAP_C_UTFSTRING))
         {
-          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String too long: maxlen=%ld\n", maxlen));
-          soap->error = SOAP_LENGTH;
-          return NULL;
+          (SOAP_SNPRINTF(tmp, sizeof(tmp), 7), "&#x%X;", (unsigned char)*t);
+          r = tmp;
+          break;
         }
-      }
+        continue;
     }
+    if (soap_append_lab(soap, s, t - s) || soap_append_lab(soap, r, strlen(r)))
+      return soap->error;
+    s = t + 1;
   }
+  return soap_append_lab(soap, s, t - s);
+}
 #endif
-#ifdef WITH_FAST
-  soap->labidx = 0;                     /* use look-aside buffer */
-#else
-  if (soap_alloc_block(soap) == NULL)
-    return NULL;
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+static const void *
+soap_lazy_key(const void *p)
+{
+  return (const void*)((size_t)p & ~(((size_t)1 << SOAP_LAZYSHIFT) - 1));
+}
 #endif
-  for (;;)
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* removes the lazy member from the index, its element is no longer sent verbatim or deserialized */
+static void
+soap_lazy_drop(struct soap *soap, struct soap_lazy *lp)
+{
+  if (lp->ptr)
   {
-#ifdef WITH_FAST
-    size_t k;
-    if (soap_append_lab(soap, NULL, 0)) /* allocate more space in look-aside buffer if necessary */
-      return NULL;
-    s = soap->labbuf + soap->labidx;    /* space to populate */
-    k = soap->lablen - soap->labidx;    /* number of bytes available */
-    soap->labidx = soap->lablen;        /* claim this space */
-#else
-    size_t k = SOAP_BLKLEN;
-    s = (char*)soap_push_block(soap, NULL, k);
-    if (!s)
-      return NULL;
+    size_t i = soap_find_lht(&soap->lzht, soap_lazy_key(lp->ptr), lp);
+    if (i < soap->lzht.size)
+      soap_remove_lht(&soap->lzht, i);
+    lp->ptr = NULL;
+  }
+}
 #endif
-    for (i = 0; i < k; i++)
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* re-keys the lazy members in the block [src, src + len) that was moved to dst */
+static void
+soap_lazy_move(struct soap *soap, const char *dst, const char *src, size_t len)
+{
+  struct soap_lht *lht = &soap->lzht;
+  struct soap_lazy *lp, *moved = NULL;
+  const char *g;
+  if (!lht->num)
+    return;
+  for (g = (const char*)soap_lazy_key(src); g < src + len; g += (size_t)1 << SOAP_LAZYSHIFT)
+  {
+    size_t h = soap_hash_key(g) & (lht->size - 1);
+    while (lht->table[h].link)
     {
-      if (m > 0)
+      lp = (struct soap_lazy*)lht->table[h].link;
+      if (lht->table[h].ptr == (const void*)g && (const char*)lp->ptr >= src && (const char*)lp->ptr < src + len)
       {
-        *s++ = *t++;    /* copy multibyte characters */
-        m--;
-        continue;
+        /* the backward shift deletion moves the next entry of the probe sequence to slot h */
+        soap_remove_lht(lht, h);
+        lp->move = moved;
+        moved = lp;
       }
-#ifndef WITH_CDATA
-      if (flag <= 0)
-        c = soap_getchar(soap);
       else
-#endif
       {
-        c = soap_getutf8(soap);
-        if ((soap->mode & SOAP_C_UTFSTRING))
-        {
-          if (c >= 0x80 || (c < SOAP_AP && c >= -0x7FFFFF80))
-          {
-            c &= 0x7FFFFFFF;
-            t = buf;
-            if (c < 0x0800)
-            {
-              *t++ = (char)(0xC0 | ((c >> 6) & 0x1F));
-            }
-            else
-            {
-#ifdef WITH_REPLACE_ILLEGAL_UTF8
-              if (!((c >= 0x80 && c <= 0xD7FF) || (c >= 0xE000 && c <= 0xFFFD) || (c >= 0x10000 && c <= 0x10FFFF)))
-                c = SOAP_UNKNOWN_UNICODE_CHAR;
+        h = (h + 1) & (lht->size - 1);
+      }
+    }
+  }
+  for (lp = moved; lp; lp = lp->move)
+  {
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Update lazy member %p -> %p\n", lp->ptr, (void*)(dst + ((const char*)lp->ptr - src))));
+    lp->ptr = (const void*)(dst + ((const char*)lp->ptr - src));
+    /* cannot fail, the index does not grow when entries are re-entered */
+    (void)soap_enter_lht(soap, lht, soap_lazy_key(lp->ptr), (void*)lp);
+  }
+}
 #endif
-              if (c < 0x010000)
-              {
-                *t++ = (char)(0xE0 | ((c >> 12) & 0x0F));
-              }
-              else
-              {
-                if (c < 0x200000)
-                {
-                  *t++ = (char)(0xF0 | ((c >> 18) & 0x07));
-                }
-                else
-                {
-                  if (c < 0x04000000)
-                  {
-                    *t++ = (char)(0xF8 | ((c >> 24) & 0x03));
-                  }
-                  else
-                  {
-                    *t++ = (char)(0xFC | ((c >> 30) & 0x01));
-                    *t++ = (char)(0x80 | ((c >> 24) & 0x3F));
-                  }
-                  *t++ = (char)(0x80 | ((c >> 18) & 0x3F));
-                }
-                *t++ = (char)(0x80 | ((c >> 12) & 0x3F));
-              }
-              *t++ = (char)(0x80 | ((c >> 6) & 0x3F));
-            }
-            *t++ = (char)(0x80 | (c & 0x3F));
-            m = (int)(t - buf) - 1;
-            t = buf;
-            *s++ = *t++;
-            l++;
-            if (maxlen >= 0 && l > (size_t)maxlen)
-            {
-              DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String too long: maxlen=%ld\n", maxlen));
-              soap->error = SOAP_LENGTH;
-              return NULL;
-            }
-            continue;
-          }
-        }
-      }
-      switch (c)
-      {
-      case SOAP_TT:
-        if (n == 0)
-          goto end;
-        n--;
-        *s++ = '<';
-        t = (char*)"/";
-        m = 1;
-        break;
-      case SOAP_LT:
-        if (flag == 3 || (f && n == 0))
-          goto end;
-        n++;
-        *s++ = '<';
-        break;
-      case SOAP_GT:
-        *s++ = '>';
-        break;
-      case SOAP_QT:
-        *s++ = '"';
-        break;
-      case SOAP_AP:
-        *s++ = '\'';
-        break;
-      case '/':
-        if (n > 0)
-        {
-          if (flag > 0)
-          {
-            c = soap_get(soap);
-            if (c == SOAP_GT)
-              n--;
-          }
-          else
-          {
-            c = soap_getchar(soap);
-            if (c == '>')
-              n--;
-          }
-          soap_unget(soap, c);
-        }
-        *s++ = '/';
-        break;
-      case (soap_wchar)('<' | 0x80000000):
-        if (flag > 0)
-        {
-          *s++ = '<';
-        }
-        else
-        {
-          *s++ = '&';
-          t = (char*)"lt;";
-          m = 3;
-        }
-        break;
-      case (soap_wchar)('>' | 0x80000000):
-        if (flag > 0)
-        {
-          *s++ = '>';
-        }
-        else
-        {
-          *s++ = '&';
-          t = (char*)"gt;";
-          m = 3;
-        }
-        break;
-      case (soap_wchar)('&' | 0x80000000):
-        if (flag > 0)
-        {
-          *s++ = '&';
-        }
-        else
-        {
-          *s++ = '&';
-          t = (char*)"amp;";
-          m = 4;
-        }
-        break;
-      case (soap_wchar)('"' | 0x80000000):
-        if (flag > 0)
-        {
-          *s++ = '"';
-        }
-        else
-        {
-          *s++ = '&';
-          t = (char*)"quot;";
-          m = 5;
-        }
-        break;
-      case (soap_wchar)('\'' | 0x80000000):
-        if (flag > 0)
-        {
-          *s++ = '\'';
-        }
-        else
-        {
-          *s++ = '&';
-          t = (char*)"apos;";
-          m = 5;
-        }
-        break;
-      default:
-        if ((int)c == EOF)
-          goto end;
-#ifndef WITH_CDATA
-        if (c == '<')
-        {
-          c = soap_getchar(soap);
-          soap_unget(soap, c);
-          if (c == '/')
-          {
-            c = SOAP_TT;
-            if (n == 0)
-              goto end;
-            n--;
-          }
-          else
-          {
-            n++;
-          }
-          *s++ = '<';
-        }
-        else
-#endif
-#ifndef WITH_LEANER
-#ifdef HAVE_WCTOMB
-        if ((soap->mode & SOAP_C_MBSTRING))
-        {
-#if defined(WIN32) && !defined(CYGWIN) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(__BORLANDC__)
-          m = 0;
-          wctomb_s(&m, buf, sizeof(buf), (wchar_t)(c & 0x7FFFFFFF));
-#else
-          m = wctomb(buf, (wchar_t)(c & 0x7FFFFFFF));
-#endif
-          if (m >= 1 && m <= (int)MB_CUR_MAX)
-          {
-            t = buf;
-            *s++ = *t++;
-            m--;
-          }
-          else
-          {
-            *s++ = SOAP_UNKNOWN_CHAR;
-            m = 0;
-          }
-        }
-        else
-#endif
-#endif
-          *s++ = (char)(c & 0xFF);
-      }
-      l++;
-      if (maxlen >= 0 && l > (size_t)maxlen)
-      {
-        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String too long: maxlen=%ld\n", maxlen));
-        soap->error = SOAP_LENGTH;
-        return NULL;
-      }
+
+/******************************************************************************/
+
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+static struct soap_lazy *
+soap_lazy_find(const struct soap *soap, const void *p)
+{
+  const struct soap_lht *lht = &soap->lzht;
+  if (lht->num)
+  {
+    const void *k = soap_lazy_key(p);
+    size_t h = soap_hash_key(k) & (lht->size - 1);
+    while (lht->table[h].link)
+    {
+      if (lht->table[h].ptr == k && ((struct soap_lazy*)lht->table[h].link)->ptr == p)
+        return (struct soap_lazy*)lht->table[h].link;
+      h = (h + 1) & (lht->size - 1);
     }
   }
-end:
-  soap_unget(soap, c);
-  *s = '\0';
-#ifdef WITH_FAST
-  t = soap_strdup(soap, soap->labbuf);
-  if (!t)
-    return NULL;
-#else
-  soap_size_block(soap, NULL, i + 1);
-  t = (char*)soap_save_block(soap, NULL, NULL, 0);
+  return NULL;
+}
 #endif
-  if (minlen > 0 && l < (size_t)minlen)
-  {
-    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String too short: %lu chars, minlen=%ld\n", (unsigned long)l, minlen));
-    soap->error = SOAP_LENGTH;
-    return NULL;
-  }
-#ifdef WITH_DOM
-  if ((soap->mode & SOAP_XML_DOM) && soap->dom && *t)
+
+/******************************************************************************/
+
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+/* moves the lazy elements retained by the copy to the context, before the copy delegates the deletion of its data to the context */
+static void
+soap_lazy_merge(struct soap *soap, struct soap *copy)
+{
+  struct soap_lazy *lp, *next;
+  for (lp = copy->lazy; lp; lp = next)
   {
-    if (flag > 0)
-    {
-      soap->dom->text = t;
-    }
-    else
+    next = lp->next;
+    lp->next = soap->lazy;
+    soap->lazy = lp;
+    if (lp->ptr && soap_enter_lht(soap, &soap->lzht, soap_lazy_key(lp->ptr), (void*)lp))
     {
-      soap->dom->code = t;
-      if (flag < 0)
-      {
-        /* the tag URI and name are already in the XML code string */
-        soap->dom->nstr = NULL;
-        soap->dom->name = NULL;
-      }
+      lp->ptr = NULL;
+      soap->error = SOAP_EOM;
     }
   }
+  copy->lazy = NULL;
+  soap_free_lht(copy, &copy->lzht);
+}
 #endif
-  if (flag == 2)
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_lazy_in(struct soap *soap, const char *tag, const void *p)
+{
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+  struct soap_lazy *lp, *lq;
+  struct soap_nlist *np, *nq;
+  struct soap_attribute *tp;
+  if ((soap->mode & SOAP_XML_DOM) || (soap->bxml & SOAP_BXML_IN))
   {
-    if (soap_s2QName(soap, t, &t, minlen, maxlen, pattern))
-      return NULL;
+    soap->error = SOAP_OK;
+    return 0;
   }
-  else if (flag >= 4 && t)
+  if (soap_element_begin_in(soap, tag, 1, NULL))
+    return 0;
+  /* multi-referenced elements are resolved by id and href, which a retained element cannot */
+  if (soap->ahead || soap->cdata || *soap->id || *soap->href)
   {
-    t = soap_collapse(soap, t, flag, 1);
+    soap_revert(soap);
+    return 0;
   }
-#ifndef WITH_LEANER
-  else if (pattern && soap->fsvalidate)
+  /* retain the start tag with the namespace bindings in scope, the element content raw and the end tag */
+  soap->labidx = 0;
+  if (soap_append_lab(soap, "<", 1) || soap_append_lab(soap, soap->tag, strlen(soap->tag)))
+    return 0;
+  for (np = soap->nlist; np; np = np->next)
   {
-    soap->error = soap->fsvalidate(soap, pattern, t);
-    if (soap->error)
-      return NULL;
+    const char *ns = np->ns;
+    for (nq = soap->nlist; nq != np; nq = nq->next)
+      if (!strcmp(nq->id, np->id))
+        break;
+    if (nq != np)
+      continue;
+    if (!ns && np->index >= 0 && soap->local_namespaces)
+      ns = soap->local_namespaces[np->index].ns;
+    if (!ns)
+      continue;
+    if (soap_append_lab(soap, *np->id ? " xmlns:" : " xmlns", *np->id ? 7 : 6)
+     || soap_append_lab(soap, np->id, strlen(np->id))
+     || soap_append_lab(soap, "=\"", 2)
+     || soap_append_lab_attr(soap, ns)
+     || soap_append_lab(soap, "\"", 1))
+      return 0;
+  }
+  for (tp = soap->attributes; tp; tp = tp->next)
+  {
+    if (tp->visible == 2 && tp->value && strncmp(tp->name, "xmlns", 5))
+    {
+      if (soap_append_lab(soap, " ", 1)
+       || soap_append_lab(soap, tp->name, strlen(tp->name))
+       || soap_append_lab(soap, "=\"", 2)
+       || soap_append_lab_attr(soap, tp->value)
+       || soap_append_lab(soap, "\"", 1))
+        return 0;
+    }
+  }
+  if (soap_append_lab(soap, ">", 1))
+    return 0;
+  if (soap->body)
+  {
+    if (soap_skip(soap, 1))
+      return 0;
+    soap_unget(soap, SOAP_TT);
+    if (soap_element_end_in(soap, NULL))
+      return 0;
+  }
+  if (soap_append_lab(soap, "</", 2) || soap_append_lab(soap, soap->tag, strlen(soap->tag)) || soap_append_lab(soap, ">", 1))
+    return 0;
+  lp = (struct soap_lazy*)soap_malloc(soap, sizeof(struct soap_lazy));
+  if (!lp)
+    return 0;
+  lp->xml = (char*)soap_malloc(soap, soap->labidx + 1);
+  if (!lp->xml)
+    return 0;
+  (void)soap_memcpy((void*)lp->xml, soap->labidx + 1, (const void*)soap->labbuf, soap->labidx);
+  lp->xml[soap->labidx] = '\0';
+  lp->len = soap->labidx;
+  lp->ptr = p;
+  lp->move = NULL;
+  lp->next = soap->lazy;
+  soap->lazy = lp;
+  /* a member that is deserialized again replaces its retained element */
+  lq = soap_lazy_find(soap, p);
+  if (lq)
+    soap_lazy_drop(soap, lq);
+  if (soap_enter_lht(soap, &soap->lzht, soap_lazy_key(p), (void*)lp))
+  {
+    lp->ptr = NULL;
+    soap->error = SOAP_EOM;
+    return 0;
   }
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Retained lazy element '%s' (%lu bytes) of member %p\n", soap->tag, (unsigned long)lp->len, p));
+  return 1;
+#else
+  (void)tag; (void)p;
+  soap->error = SOAP_OK;
+  return 0;
 #endif
-  return t;
 }
 
 /******************************************************************************/
 
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_lazy_out(struct soap *soap, const void *p)
+{
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+  struct soap_lazy *lp;
+  if ((soap->mode & SOAP_XML_DOM))
+    return 0;
+  lp = soap_lazy_find(soap, p);
+  if (lp)
+  {
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Sending lazy element of member %p verbatim\n", p));
+    if ((soap->bxml & SOAP_BXML_OUT))
+      (void)soap_bxml_xml_out(soap, lp->xml);
+    else
+      (void)soap_send_raw(soap, lp->xml, lp->len);
+    return 1;
+  }
+#else
+  (void)soap; (void)p;
+#endif
+  return 0;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+struct soap *
+SOAP_FMAC2
+soap_lazy_begin(struct soap *soap, const void *p)
+{
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+  struct soap_lazy *lp;
+  struct soap *copy;
+  lp = soap_lazy_find(soap, p);
+  if (!lp)
+    return NULL;
+  copy = soap_copy(soap);
+  if (!copy)
+  {
+    soap->error = SOAP_EOM;
+    return NULL;
+  }
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Deserializing lazy element of member %p\n", p));
+  /* the copy reads the retained element in-situ, which is self-contained with its namespace bindings */
+  copy->mode &= ~(SOAP_IO | SOAP_ENC_ZLIB | SOAP_ENC_DIME | SOAP_ENC_MIME | SOAP_ENC_MTOM | SOAP_XML_DOM);
+  copy->isbuf = lp->xml;
+  copy->islen = lp->len;
+  copy->isidx = 0;
+  copy->insitu = NULL;
+  copy->isconst = 0;
+  copy->bufidx = 0;
+  copy->buflen = 0;
+  copy->ahead = 0;
+  copy->cdata = 0;
+  copy->peeked = 0;
+  copy->count = 0;
+  copy->level = 0;
+  copy->master = SOAP_INVALID_SOCKET;
+  copy->socket = SOAP_INVALID_SOCKET;
+  copy->fdisconnect = NULL;
+  copy->fclose = NULL;
 #ifndef WITH_LEANER
+  copy->fpreparerecv = NULL;
+  copy->ffilterrecv = NULL;
+#endif
+  return copy;
+#else
+  (void)soap; (void)p;
+  return NULL;
+#endif
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+void
+SOAP_FMAC2
+soap_lazy_end(struct soap *soap, struct soap *copy, const void *p)
+{
+#if !defined(WITH_LEAN) && !defined(WITH_NOIO)
+  struct soap_lazy *lp;
+  /* the retained element is modified by in-situ deserialization and is no longer sent verbatim */
+  lp = soap_lazy_find(soap, p);
+  if (lp)
+    soap_lazy_drop(soap, lp);
+  if (copy->error)
+  {
+    soap->error = copy->error;
+    soap_strcpy(soap->tag, sizeof(soap->tag), copy->tag);
+  }
+  /* lazy elements retained by the copy and the deserialized data are managed by the context from now on */
+  soap_lazy_merge(soap, copy);
+  soap_delegate_deletion(copy, soap);
+  soap_destroy(copy);
+  soap_end(copy);
+  soap_free(copy);
+#else
+  (void)soap; (void)copy; (void)p;
+#endif
+}
+
+/******************************************************************************/
+
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_wstring_out(struct soap *soap, const wchar_t *s, int flag)
+soap_string_out(struct soap *soap, const char *s, int flag)
 {
   const char *t;
-  char tmp;
   soap_wchar c;
+  soap_wchar mask = (soap_wchar)0xFFFFFF80UL;
 #ifdef WITH_DOM
   if ((soap->mode & SOAP_XML_DOM) && soap->dom)
   {
-    soap->dom->text = soap_wchar2s(soap, s);
+    soap->dom->text = soap_strdup(soap, s);
+    if (!soap->dom->text)
+      return soap->error = SOAP_EOM;
     return SOAP_OK;
   }
 #endif
-  while ((c = *s++))
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_OUT))
+    return soap_bxml_string_out(soap, s, flag);
+#endif
+  if (flag == 2 || (soap->mode & SOAP_C_UTFSTRING))
+    mask = 0;
+  t = s;
+  while ((c = *t++))
   {
     switch (c)
     {
     case 0x09:
       if (flag)
-        t = "&#x9;";
-      else
-        t = "\t";
+      {
+        if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&#x9;", 5))
+          return soap->error;
+        s = t;
+      }
       break;
     case 0x0A:
       if (flag)
-        t = "&#xA;";
-      else
-        t = "\n";
+      {
+        if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&#xA;", 5))
+          return soap->error;
+        s = t;
+      }
       break;
-#ifdef WITH_CR_TO_LF
+#ifdef WITH_CRTOLF
     case 0x0D:
-      if (*s == 0x0A)
-        continue;
-      if (flag)
-        t = "&#xA;";
+      if (*t == 0x0A)
+      {
+        if (soap_send_raw(soap, s, t - s - 1))
+          return soap->error;
+        s = t;
+      }
+      else if (flag)
+      {
+        if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&#xA;", 5))
+          return soap->error;
+        s = t;
+      }
       else
-        t = "\n";
+      {
+        if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "\n", 1))
+          return soap->error;
+        s = t;
+      }
       break;
 #endif
     case '&':
-      t = "&amp;";
+      if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&amp;", 5))
+        return soap->error;
+      s = t;
       break;
     case '<':
-      t = "&lt;";
+      if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&lt;", 4))
+        return soap->error;
+      s = t;
       break;
     case '>':
-      if (flag)
-        t = ">";
-      else
-        t = "&gt;";
+      if (!flag)
+      {
+        if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&gt;", 4))
+          return soap->error;
+        s = t;
+      }
       break;
     case '"':
       if (flag)
-        t = "&quot;";
-      else
-        t = "\"";
-      break;
-    default:
-      if (c >= 0x20 && c < 0x80)
       {
-        tmp = (char)c;
-        if (soap_send_raw(soap, &tmp, 1))
+        if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&quot;", 6))
           return soap->error;
+        s = t;
       }
-      else
+      break;
+    case 0x7F:
+      if (soap_send_raw(soap, s, t - s - 1) || soap_send_raw(soap, "&#x7F;", 6))
+        return soap->error;
+      s = t;
+      break;
+    default:
+#ifndef WITH_LEANER
+#ifdef HAVE_MBTOWC
+      if ((soap->mode & SOAP_C_MBSTRING))
       {
-        /* check for UTF16 encoding when wchar_t is too small to hold UCS */
-        if (sizeof(wchar_t) < 4 && (c & 0xFC00) == 0xD800)
+        wchar_t wc;
+        int m = mbtowc(&wc, t - 1, MB_CUR_MAX);
+        if (m > 0 && !((soap_wchar)wc == c && m == 1 && c < 0x80))
         {
-          soap_wchar d = *s;
-          if ((d & 0xFC00) == 0xDC00)
-          {
-            c = ((c - 0xD800) << 10) + (d - 0xDC00) + 0x10000;
-            s++;
-          }
-#ifdef WITH_REPLACE_ILLEGAL_UTF8
-          else
-          {
-            c = SOAP_UNKNOWN_UNICODE_CHAR; /* Malformed UTF-16 */
-          }
-#endif
+          if (soap_send_raw(soap, s, t - s - 1) || soap_pututf8(soap, (unsigned long)wc))
+            return soap->error;
+          s = t += m - 1;
+          continue;
         }
-        if (soap_pututf8(soap, (unsigned long)c))
+      }
+#endif
+#endif
+#ifndef WITH_NOSTRINGTOUTF8
+      if ((c & mask) || !(c & 0xFFFFFFE0UL))
+      {
+        if (soap_send_raw(soap, s, t - s - 1) || soap_pututf8(soap, (unsigned char)c))
           return soap->error;
+        s = t;
       }
-      continue;
+#endif
     }
-    if (soap_send(soap, t))
-      return soap->error;
   }
-  return SOAP_OK;
+  return soap_send_raw(soap, s, t - s - 1);
 }
-#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
 SOAP_FMAC1
-wchar_t *
+char *
 SOAP_FMAC2
-soap_wstring_in(struct soap *soap, int flag, long minlen, long maxlen, const char *pattern)
+soap_string_in(struct soap *soap, int flag, long minlen, long maxlen, const char *pattern)
 {
-  wchar_t *s;
-  int i, n = 0, f = 0;
+  char *s = NULL;
+  char *t = NULL;
+  size_t i;
   ULONG64 l = 0;
+  int n = 0, f = 0, m = 0;
   soap_wchar c;
-  char *t = NULL;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Reading wide string content\n"));
+#if !defined(WITH_LEANER) && defined(HAVE_WCTOMB)
+  char buf[MB_LEN_MAX > 8 ? MB_LEN_MAX : 8];
+#else
+  char buf[8];
+#endif
   if (maxlen < 0 && soap->maxlength > 0)
     maxlen = soap->maxlength;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Reading string content, flag=%d\n", flag));
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_IN))
+  {
+    t = soap_bxml_string_in(soap, flag, maxlen, &l);
+    if (!t)
+      return NULL;
+    goto insitu;
+  }
+#endif
   if (flag <= 0 && soap->peeked && *soap->tag)
   {
 #ifndef WITH_LEAN
     struct soap_attribute *tp;
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String content includes tag '%s' and attributes\n", soap->tag));
     t = soap->tmpbuf;
     *t = '<';
     soap_strcpy(t + 1, sizeof(soap->tmpbuf) - 1, soap->tag);
@@ -16557,7 +18223,7 @@ soap_wstring_in(struct soap *soap, int flag, long minlen, long maxlen, const cha
       {
         size_t k = strlen(tp->name);
         if (t + k + 1 >= soap->tmpbuf + sizeof(soap->tmpbuf))
-          break;
+          break; /* too many or attribute values to large */
         *t++ = ' ';
         (void)soap_strncpy(t, sizeof(soap->tmpbuf) - (t - soap->tmpbuf), tp->name, k);
         t += k;
@@ -16565,7 +18231,7 @@ soap_wstring_in(struct soap *soap, int flag, long minlen, long maxlen, const cha
         {
           k = strlen(tp->value);
           if (t + k + 3 >= soap->tmpbuf + sizeof(soap->tmpbuf))
-            break;
+            break; /* too many or attribute values to large */
           *t++ = '=';
           *t++ = '"';
           (void)soap_strncpy(t, sizeof(soap->tmpbuf) - (t - soap->tmpbuf), tp->value, k);
@@ -16579,3415 +18245,6863 @@ soap_wstring_in(struct soap *soap, int flag, long minlen, long maxlen, const cha
     *t++ = '>';
     *t = '\0';
     t = soap->tmpbuf;
+    m = (int)strlen(soap->tmpbuf);
 #endif
     if (soap->body)
       n = 1;
     f = 1;
     soap->peeked = 0;
   }
-  if (soap_alloc_block(soap) == NULL)
-    return NULL;
-  for (;;)
+#ifdef WITH_CDATA
+  if (flag <= 0)
   {
-    s = (wchar_t*)soap_push_block(soap, NULL, sizeof(wchar_t)*SOAP_BLKLEN);
-    if (!s)
-      return NULL;
-    for (i = 0; i < SOAP_BLKLEN; i++)
+    int state = 0;
+#ifdef WITH_FAST
+    soap->labidx = 0;                   /* use look-aside buffer */
+#else
+    if (soap_alloc_block(soap) == NULL)
+      return NULL;
+#endif
+    for (;;)
     {
-      if (t)
-      {
-        *s++ = (wchar_t)*t++;
-        if (!*t)
-          t = NULL;
-        continue;
-      }
-      c = soap_getutf8(soap);
-      switch (c)
+#ifdef WITH_FAST
+      size_t k;
+      if (soap_append_lab(soap, NULL, 0))       /* allocate more space in look-aside buffer if necessary */
+        return NULL;
+      s = soap->labbuf + soap->labidx;  /* space to populate */
+      k = soap->lablen - soap->labidx;  /* number of bytes available */
+      soap->labidx = soap->lablen;      /* claim this space */
+#else
+      size_t k = SOAP_BLKLEN;
+      s = (char*)soap_push_block(soap, NULL, k);
+      if (!s)
+        return NULL;
+#endif
+      for (i = 0; i < k; i++)
       {
-      case SOAP_TT:
-        if (n == 0)
-          goto end;
-        n--;
-        *s++ = L'<';
-        soap_unget(soap, '/');
-        break;
-      case SOAP_LT:
-        if (flag == 3 || (f && n == 0))
-          goto end;
-        n++;
-        *s++ = L'<';
-        break;
-      case SOAP_GT:
-        *s++ = L'>';
-        break;
-      case SOAP_QT:
-        *s++ = L'"';
-        break;
-      case SOAP_AP:
-        *s++ = L'\'';
-        break;
-      case '/':
-        if (n > 0)
-        {
-          c = soap_getutf8(soap);
-          if (c == SOAP_GT)
-            n--;
-          soap_unget(soap, c);
-        }
-        *s++ = L'/';
-        break;
-      case '<':
-        if (flag > 0)
+        if (m > 0)
         {
-          *s++ = L'<';
+          *s++ = *t++;  /* copy multibyte characters */
+          m--;
+          continue;
         }
-        else
+        c = soap_getchar(soap);
+        if ((int)c == EOF)
+          goto end;
+        if ((c >= 0x80 || c < SOAP_AP) && state != 1)
         {
-          *s++ = L'&';
-          t = (char*)"lt;";
+          if ((c & 0x7FFFFFFF) >= 0x80)
+          {
+            soap_unget(soap, c);
+            c = soap_getutf8(soap);
+          }
+          if ((c & 0x7FFFFFFF) >= 0x80 && (flag <= 0 || (soap->mode & SOAP_C_UTFSTRING)))
+          {
+            c &= 0x7FFFFFFF;
+            t = buf;
+            if (c < 0x0800)
+              *t++ = (char)(0xC0 | ((c >> 6) & 0x1F));
+            else
+            {
+#ifdef WITH_REPLACE_ILLEGAL_UTF8
+              if (!((c >= 0x80 && c <= 0xD7FF) || (c >= 0xE000 && c <= 0xFFFD) || (c >= 0x10000 && c <= 0x10FFFF)))
+                c = SOAP_UNKNOWN_UNICODE_CHAR;
+#endif
+              if (c < 0x010000)
+              {
+                *t++ = (char)(0xE0 | ((c >> 12) & 0x0F));
+              }
+              else
+              {
+                if (c < 0x200000)
+                {
+                  *t++ = (char)(0xF0 | ((c >> 18) & 0x07));
+                }
+                else
+                {
+                  if (c < 0x04000000)
+                  {
+                    *t++ = (char)(0xF8 | ((c >> 24) & 0x03));
+                  }
+                  else
+                  {
+                    *t++ = (char)(0xFC | ((c >> 30) & 0x01));
+                    *t++ = (char)(0x80 | ((c >> 24) & 0x3F));
+                  }
+                  *t++ = (char)(0x80 | ((c >> 18) & 0x3F));
+                }
+                *t++ = (char)(0x80 | ((c >> 12) & 0x3F));
+              }
+              *t++ = (char)(0x80 | ((c >> 6) & 0x3F));
+            }
+            *t++ = (char)(0x80 | (c & 0x3F));
+            m = (int)(t - buf) - 1;
+            t = buf;
+            *s++ = *t++;
+            continue;
+          }
         }
-        break;
-      case '>':
-        if (flag > 0)
+        switch (state)
         {
-          *s++ = L'>';
+          case 1:
+            if (c == ']')
+              state = 4;
+            *s++ = (char)c;
+            continue;
+          case 2:
+            if (c == '-')
+              state = 6;
+            *s++ = (char)c;
+            continue;
+          case 3:
+            if (c == '?')
+              state = 8;
+            *s++ = (char)c;
+            continue;
+          /* CDATA */
+          case 4:
+            if (c == ']')
+              state = 5;
+            else
+              state = 1;
+            *s++ = (char)c;
+            continue;
+          case 5:
+            if (c == '>')
+              state = 0;
+            else if (c != ']')
+              state = 1;
+            *s++ = (char)c;
+            continue;
+          /* comment */
+          case 6:
+            if (c == '-')
+              state = 7;
+            else
+              state = 2;
+            *s++ = (char)c;
+            continue;
+          case 7:
+            if (c == '>')
+              state = 0;
+            else if (c != '-')
+              state = 2;
+            *s++ = (char)c;
+            continue;
+          /* PI */
+          case 8:
+            if (c == '>')
+              state = 0;
+            else if (c != '?')
+              state = 3;
+            *s++ = (char)c;
+            continue;
         }
-        else
+        switch (c)
         {
-          *s++ = (wchar_t)'&';
-          t = (char*)"gt;";
+        case SOAP_TT:
+          if (n == 0)
+            goto end;
+          n--;
+          *s++ = '<';
+          t = (char*)"/";
+          m = 1;
+          break;
+        case SOAP_LT:
+          if (flag == 3 || (f && n == 0))
+            goto end;
+          n++;
+          *s++ = '<';
+          break;
+        case SOAP_GT:
+          *s++ = '>';
+          break;
+        case SOAP_QT:
+          *s++ = '"';
+          break;
+        case SOAP_AP:
+          *s++ = '\'';
+          break;
+        case '/':
+          if (n > 0)
+          {
+            c = soap_getchar(soap);
+            if (c == '>')
+              n--;
+            soap_unget(soap, c);
+          }
+          *s++ = '/';
+          break;
+        case '<':
+          c = soap_getchar(soap);
+          if (c == '/')
+          {
+            if (n == 0)
+            {
+              c = SOAP_TT;
+              goto end;
+            }
+            n--;
+          }
+          else if (c == '!')
+          {
+            c = soap_getchar(soap);
+            if (c == '[')
+            {
+              do
+              {
+                c = soap_getchar(soap);
+              } while ((int)c != EOF && c != '[');
+              if ((int)c == EOF)
+                 goto end;
+              t = (char*)"![CDATA[";
+              m = 8;
+              state = 1;
+            }
+            else if (c == '-')
+            {
+              c = soap_getchar(soap);
+              if (c == '-')
+                state = 2;
+              t = (char*)"!-";
+              m = 2;
+              soap_unget(soap, c);
+            }
+            else
+            {
+              t = (char*)"!";
+              m = 1;
+              soap_unget(soap, c);
+            }
+            *s++ = '<';
+            break;
+          }
+          else if (c == '?')
+          {
+            state = 3;
+          }
+          else if (flag == 3 || (f && n == 0))
+          {
+            soap_revget1(soap);
+            c = '<';
+            goto end;
+          }
+          else
+            n++;
+          soap_unget(soap, c);
+          *s++ = '<';
+          break;
+        case '>':
+          *s++ = '>';
+          break;
+        case '"':
+          *s++ = '"';
+          break;
+        default:
+#ifndef WITH_LEANER
+#ifdef HAVE_WCTOMB
+          if ((soap->mode & SOAP_C_MBSTRING))
+          {
+#if defined(WIN32) && !defined(CYGWIN) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(__BORLANDC__)
+            m = 0;
+            wctomb_s(&m, buf, sizeof(buf), (wchar_t)(c & 0x7FFFFFFF));
+#else
+            m = wctomb(buf, (wchar_t)(c & 0x7FFFFFFF));
+#endif
+            if (m >= 1 && m <= (int)MB_CUR_MAX)
+            {
+              t = buf;
+              *s++ = *t++;
+              m--;
+            }
+            else
+            {
+              *s++ = SOAP_UNKNOWN_CHAR;
+              m = 0;
+            }
+          }
+          else
+#endif
+#endif
+            *s++ = (char)(c & 0xFF);
+        }
+        l++;
+        if (maxlen >= 0 && l > (size_t)maxlen)
+        {
+          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String too long: maxlen=%ld\n", maxlen));
+          soap->error = SOAP_LENGTH;
+          return NULL;
+        }
+      }
+    }
+  }
+#endif
+#ifndef WITH_LEAN
+  if (flag > 0 && !f && soap->insitu && !soap->isconst && !soap->ahead && !soap->cdata && !(soap->mode & SOAP_ENC_ZLIB) && !soap->ffilterrecv)
+  {
+    /* string content without entities, CDATA and non-ASCII is NUL-terminated in place in the in-situ buffer, overwriting the '<' of the '</' that follows it */
+    const char *r = soap->ibuf + soap->bufidx;
+    const char *e = soap->ibuf + soap->buflen;
+    while (r < e && *r && *r != '<' && *r != '&' && !(*r & 0x80))
+      r++;
+    if (r + 1 < e && r[0] == '<' && r[1] == '/')
+    {
+      l = r - (soap->ibuf + soap->bufidx);
+      if (maxlen < 0 || l <= (size_t)maxlen)
+      {
+        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "In-situ string content of %lu bytes\n", (unsigned long)l));
+        t = soap->insitu + soap->bufidx;
+        t[l] = '\0';
+        soap->bufidx += (size_t)l + 2;
+        soap->ahead = SOAP_TT; /* ibuf[] may point to the overwritten '<' */
+        goto insitu;
+      }
+    }
+  }
+#endif
+#ifdef WITH_FAST
+  soap->labidx = 0;                     /* use look-aside buffer */
+#else
+  if (soap_alloc_block(soap) == NULL)
+    return NULL;
+#endif
+  for (;;)
+  {
+#ifdef WITH_FAST
+    size_t k;
+    if (soap_append_lab(soap, NULL, 0)) /* allocate more space in look-aside buffer if necessary */
+      return NULL;
+    s = soap->labbuf + soap->labidx;    /* space to populate */
+    k = soap->lablen - soap->labidx;    /* number of bytes available */
+    soap->labidx = soap->lablen;        /* claim this space */
+#else
+    size_t k = SOAP_BLKLEN;
+    s = (char*)soap_push_block(soap, NULL, k);
+    if (!s)
+      return NULL;
+#endif
+    for (i = 0; i < k; i++)
+    {
+      if (m > 0)
+      {
+        *s++ = *t++;    /* copy multibyte characters */
+        m--;
+        continue;
+      }
+#ifndef WITH_CDATA
+      if (flag <= 0)
+        c = soap_getchar(soap);
+      else
+#endif
+      {
+        c = soap_getutf8(soap);
+        if ((soap->mode & SOAP_C_UTFSTRING))
+        {
+          if (c >= 0x80 || (c < SOAP_AP && c >= -0x7FFFFF80))
+          {
+            c &= 0x7FFFFFFF;
+            t = buf;
+            if (c < 0x0800)
+            {
+              *t++ = (char)(0xC0 | ((c >> 6) & 0x1F));
+            }
+            else
+            {
+#ifdef WITH_REPLACE_ILLEGAL_UTF8
+              if (!((c >= 0x80 && c <= 0xD7FF) || (c >= 0xE000 && c <= 0xFFFD) || (c >= 0x10000 && c <= 0x10FFFF)))
+                c = SOAP_UNKNOWN_UNICODE_CHAR;
+#endif
+              if (c < 0x010000)
+              {
+                *t++ = (char)(0xE0 | ((c >> 12) & 0x0F));
+              }
+              else
+              {
+                if (c < 0x200000)
+                {
+                  *t++ = (char)(0xF0 | ((c >> 18) & 0x07));
+                }
+                else
+                {
+                  if (c < 0x04000000)
+                  {
+                    *t++ = (char)(0xF8 | ((c >> 24) & 0x03));
+                  }
+                  else
+                  {
+                    *t++ = (char)(0xFC | ((c >> 30) & 0x01));
+                    *t++ = (char)(0x80 | ((c >> 24) & 0x3F));
+                  }
+                  *t++ = (char)(0x80 | ((c >> 18) & 0x3F));
+                }
+                *t++ = (char)(0x80 | ((c >> 12) & 0x3F));
+              }
+              *t++ = (char)(0x80 | ((c >> 6) & 0x3F));
+            }
+            *t++ = (char)(0x80 | (c & 0x3F));
+            m = (int)(t - buf) - 1;
+            t = buf;
+            *s++ = *t++;
+            l++;
+            if (maxlen >= 0 && l > (size_t)maxlen)
+            {
+              DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String too long: maxlen=%ld\n", maxlen));
+              soap->error = SOAP_LENGTH;
+              return NULL;
+            }
+            continue;
+          }
+        }
+      }
+      switch (c)
+      {
+      case SOAP_TT:
+        if (n == 0)
+          goto end;
+        n--;
+        *s++ = '<';
+        t = (char*)"/";
+        m = 1;
+        break;
+      case SOAP_LT:
+        if (flag == 3 || (f && n == 0))
+          goto end;
+        n++;
+        *s++ = '<';
+        break;
+      case SOAP_GT:
+        *s++ = '>';
+        break;
+      case SOAP_QT:
+        *s++ = '"';
+        break;
+      case SOAP_AP:
+        *s++ = '\'';
+        break;
+      case '/':
+        if (n > 0)
+        {
+          if (flag > 0)
+          {
+            c = soap_get(soap);
+            if (c == SOAP_GT)
+              n--;
+          }
+          else
+          {
+            c = soap_getchar(soap);
+            if (c == '>')
+              n--;
+          }
+          soap_unget(soap, c);
+        }
+        *s++ = '/';
+        break;
+      case (soap_wchar)('<' | 0x80000000):
+        if (flag > 0)
+        {
+          *s++ = '<';
+        }
+        else
+        {
+          *s++ = '&';
+          t = (char*)"lt;";
+          m = 3;
+        }
+        break;
+      case (soap_wchar)('>' | 0x80000000):
+        if (flag > 0)
+        {
+          *s++ = '>';
+        }
+        else
+        {
+          *s++ = '&';
+          t = (char*)"gt;";
+          m = 3;
+        }
+        break;
+      case (soap_wchar)('&' | 0x80000000):
+        if (flag > 0)
+        {
+          *s++ = '&';
+        }
+        else
+        {
+          *s++ = '&';
+          t = (char*)"amp;";
+          m = 4;
+        }
+        break;
+      case (soap_wchar)('"' | 0x80000000):
+        if (flag > 0)
+        {
+          *s++ = '"';
+        }
+        else
+        {
+          *s++ = '&';
+          t = (char*)"quot;";
+          m = 5;
+        }
+        break;
+      case (soap_wchar)('\'' | 0x80000000):
+        if (flag > 0)
+        {
+          *s++ = '\'';
+        }
+        else
+        {
+          *s++ = '&';
+          t = (char*)"apos;";
+          m = 5;
+        }
+        break;
+      default:
+        if ((int)c == EOF)
+          goto end;
+#ifndef WITH_CDATA
+        if (c == '<')
+        {
+          c = soap_getchar(soap);
+          soap_unget(soap, c);
+          if (c == '/')
+          {
+            c = SOAP_TT;
+            if (n == 0)
+              goto end;
+            n--;
+          }
+          else
+          {
+            n++;
+          }
+          *s++ = '<';
+        }
+        else
+#endif
+#ifndef WITH_LEANER
+#ifdef HAVE_WCTOMB
+        if ((soap->mode & SOAP_C_MBSTRING))
+        {
+#if defined(WIN32) && !defined(CYGWIN) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(__BORLANDC__)
+          m = 0;
+          wctomb_s(&m, buf, sizeof(buf), (wchar_t)(c & 0x7FFFFFFF));
+#else
+          m = wctomb(buf, (wchar_t)(c & 0x7FFFFFFF));
+#endif
+          if (m >= 1 && m <= (int)MB_CUR_MAX)
+          {
+            t = buf;
+            *s++ = *t++;
+            m--;
+          }
+          else
+          {
+            *s++ = SOAP_UNKNOWN_CHAR;
+            m = 0;
+          }
+        }
+        else
+#endif
+#endif
+          *s++ = (char)(c & 0xFF);
+      }
+      l++;
+      if (maxlen >= 0 && l > (size_t)maxlen)
+      {
+        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String too long: maxlen=%ld\n", maxlen));
+        soap->error = SOAP_LENGTH;
+        return NULL;
+      }
+    }
+  }
+end:
+  soap_unget(soap, c);
+  *s = '\0';
+#ifdef WITH_FAST
+  t = soap_strdup(soap, soap->labbuf);
+  if (!t)
+    return NULL;
+#else
+  soap_size_block(soap, NULL, i + 1);
+  t = (char*)soap_save_block(soap, NULL, NULL, 0);
+#endif
+#ifndef WITH_LEAN
+insitu:
+#endif
+  if (minlen > 0 && l < (size_t)minlen)
+  {
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String too short: %lu chars, minlen=%ld\n", (unsigned long)l, minlen));
+    soap->error = SOAP_LENGTH;
+    return NULL;
+  }
+#ifdef WITH_DOM
+  if ((soap->mode & SOAP_XML_DOM) && soap->dom && *t)
+  {
+    if (flag > 0)
+    {
+      soap->dom->text = t;
+    }
+    else
+    {
+      soap->dom->code = t;
+      if (flag < 0)
+      {
+        /* the tag URI and name are already in the XML code string */
+        soap->dom->nstr = NULL;
+        soap->dom->name = NULL;
+      }
+    }
+  }
+#endif
+  if (flag == 2)
+  {
+    if (soap_s2QName(soap, t, &t, minlen, maxlen, pattern))
+      return NULL;
+  }
+  else if (flag >= 4 && t)
+  {
+    t = soap_collapse(soap, t, flag, 1);
+  }
+#ifndef WITH_LEANER
+  else if (pattern && soap->fsvalidate)
+  {
+    soap->error = soap->fsvalidate(soap, pattern, t);
+    if (soap->error)
+      return NULL;
+  }
+#endif
+  return t;
+}
+
+/******************************************************************************/
+
+#ifndef WITH_LEANER
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_wstring_out(struct soap *soap, const wchar_t *s, int flag)
+{
+  const char *t;
+  char tmp;
+  soap_wchar c;
+#ifdef WITH_DOM
+  if ((soap->mode & SOAP_XML_DOM) && soap->dom)
+  {
+    soap->dom->text = soap_wchar2s(soap, s);
+    return SOAP_OK;
+  }
+#endif
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_OUT))
+  {
+    t = soap_wchar2s(soap, s);
+    if (!t)
+      return soap->error;
+    return soap_bxml_string_out(soap, t, 2);
+  }
+#endif
+  while ((c = *s++))
+  {
+    switch (c)
+    {
+    case 0x09:
+      if (flag)
+        t = "&#x9;";
+      else
+        t = "\t";
+      break;
+    case 0x0A:
+      if (flag)
+        t = "&#xA;";
+      else
+        t = "\n";
+      break;
+#ifdef WITH_CR_TO_LF
+    case 0x0D:
+      if (*s == 0x0A)
+        continue;
+      if (flag)
+        t = "&#xA;";
+      else
+        t = "\n";
+      break;
+#endif
+    case '&':
+      t = "&amp;";
+      break;
+    case '<':
+      t = "&lt;";
+      break;
+    case '>':
+      if (flag)
+        t = ">";
+      else
+        t = "&gt;";
+      break;
+    case '"':
+      if (flag)
+        t = "&quot;";
+      else
+        t = "\"";
+      break;
+    default:
+      if (c >= 0x20 && c < 0x80)
+      {
+        tmp = (char)c;
+        if (soap_send_raw(soap, &tmp, 1))
+          return soap->error;
+      }
+      else
+      {
+        /* check for UTF16 encoding when wchar_t is too small to hold UCS */
+        if (sizeof(wchar_t) < 4 && (c & 0xFC00) == 0xD800)
+        {
+          soap_wchar d = *s;
+          if ((d & 0xFC00) == 0xDC00)
+          {
+            c = ((c - 0xD800) << 10) + (d - 0xDC00) + 0x10000;
+            s++;
+          }
+#ifdef WITH_REPLACE_ILLEGAL_UTF8
+          else
+          {
+            c = SOAP_UNKNOWN_UNICODE_CHAR; /* Malformed UTF-16 */
+          }
+#endif
+        }
+        if (soap_pututf8(soap, (unsigned long)c))
+          return soap->error;
+      }
+      continue;
+    }
+    if (soap_send(soap, t))
+      return soap->error;
+  }
+  return SOAP_OK;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEANER
+SOAP_FMAC1
+wchar_t *
+SOAP_FMAC2
+soap_wstring_in(struct soap *soap, int flag, long minlen, long maxlen, const char *pattern)
+{
+  wchar_t *s;
+  int i, n = 0, f = 0;
+  ULONG64 l = 0;
+  soap_wchar c;
+  char *t = NULL;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Reading wide string content\n"));
+  if (maxlen < 0 && soap->maxlength > 0)
+    maxlen = soap->maxlength;
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_IN))
+  {
+    soap_mode m = soap->mode;
+    wchar_t *w = NULL;
+    soap->mode |= SOAP_C_UTFSTRING;
+    t = soap_string_in(soap, flag > 0 ? 1 : flag, -1, -1, NULL);
+    soap->mode = m;
+    if (!t || soap_s2wchar(soap, t, &w, flag, minlen, maxlen, pattern))
+      return NULL;
+    return w;
+  }
+#endif
+  if (flag <= 0 && soap->peeked && *soap->tag)
+  {
+#ifndef WITH_LEAN
+    struct soap_attribute *tp;
+    t = soap->tmpbuf;
+    *t = '<';
+    soap_strcpy(t + 1, sizeof(soap->tmpbuf) - 1, soap->tag);
+    t += strlen(t);
+    for (tp = soap->attributes; tp; tp = tp->next)
+    {
+      if (tp->visible)
+      {
+        size_t k = strlen(tp->name);
+        if (t + k + 1 >= soap->tmpbuf + sizeof(soap->tmpbuf))
+          break;
+        *t++ = ' ';
+        (void)soap_strncpy(t, sizeof(soap->tmpbuf) - (t - soap->tmpbuf), tp->name, k);
+        t += k;
+        if (tp->value)
+        {
+          k = strlen(tp->value);
+          if (t + k + 3 >= soap->tmpbuf + sizeof(soap->tmpbuf))
+            break;
+          *t++ = '=';
+          *t++ = '"';
+          (void)soap_strncpy(t, sizeof(soap->tmpbuf) - (t - soap->tmpbuf), tp->value, k);
+          t += k;
+          *t++ = '"';
+        }
+      }
+    }
+    if (!soap->body)
+      *t++ = '/';
+    *t++ = '>';
+    *t = '\0';
+    t = soap->tmpbuf;
+#endif
+    if (soap->body)
+      n = 1;
+    f = 1;
+    soap->peeked = 0;
+  }
+  if (soap_alloc_block(soap) == NULL)
+    return NULL;
+  for (;;)
+  {
+    s = (wchar_t*)soap_push_block(soap, NULL, sizeof(wchar_t)*SOAP_BLKLEN);
+    if (!s)
+      return NULL;
+    for (i = 0; i < SOAP_BLKLEN; i++)
+    {
+      if (t)
+      {
+        *s++ = (wchar_t)*t++;
+        if (!*t)
+          t = NULL;
+        continue;
+      }
+      c = soap_getutf8(soap);
+      switch (c)
+      {
+      case SOAP_TT:
+        if (n == 0)
+          goto end;
+        n--;
+        *s++ = L'<';
+        soap_unget(soap, '/');
+        break;
+      case SOAP_LT:
+        if (flag == 3 || (f && n == 0))
+          goto end;
+        n++;
+        *s++ = L'<';
+        break;
+      case SOAP_GT:
+        *s++ = L'>';
+        break;
+      case SOAP_QT:
+        *s++ = L'"';
+        break;
+      case SOAP_AP:
+        *s++ = L'\'';
+        break;
+      case '/':
+        if (n > 0)
+        {
+          c = soap_getutf8(soap);
+          if (c == SOAP_GT)
+            n--;
+          soap_unget(soap, c);
+        }
+        *s++ = L'/';
+        break;
+      case '<':
+        if (flag > 0)
+        {
+          *s++ = L'<';
+        }
+        else
+        {
+          *s++ = L'&';
+          t = (char*)"lt;";
+        }
+        break;
+      case '>':
+        if (flag > 0)
+        {
+          *s++ = L'>';
+        }
+        else
+        {
+          *s++ = (wchar_t)'&';
+          t = (char*)"gt;";
+        }
+        break;
+      case '"':
+        if (flag > 0)
+        {
+          *s++ = L'"';
+        }
+        else
+        {
+          *s++ = L'&';
+          t = (char*)"quot;";
+        }
+        break;
+      default:
+        if ((int)c == EOF)
+          goto end;
+        /* use UTF16 encoding when wchar_t is too small to hold UCS */
+        if (sizeof(wchar_t) < 4 && c > 0xFFFF)
+        {
+          soap_wchar c1, c2;
+          c1 = 0xD800 - (0x10000 >> 10) + (c >> 10);
+          c2 = 0xDC00 + (c & 0x3FF);
+          c = c1;
+          soap_unget(soap, c2);
+        }
+        *s++ = (wchar_t)(c & 0x7FFFFFFF);
+      }
+      l++;
+      if (maxlen >= 0 && l > (size_t)maxlen)
+      {
+        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String too long: maxlen=%ld\n", maxlen));
+        soap->error = SOAP_LENGTH;
+        return NULL;
+      }
+    }
+  }
+end:
+  soap_unget(soap, c);
+  *s = L'\0';
+  soap_size_block(soap, NULL, sizeof(wchar_t) * (i + 1));
+  if (minlen > 0 && l < (size_t)minlen)
+  {
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String too short: %lu chars, minlen=%ld\n", (unsigned long)l, minlen));
+    soap->error = SOAP_LENGTH;
+    return NULL;
+  }
+  s = (wchar_t*)soap_save_block(soap, NULL, NULL, 0);
+#ifndef WITH_LEAN
+  if (flag >= 4 && s)
+    s = soap_wcollapse(soap, s, flag, 1);
+#endif
+#ifndef WITH_LEANER
+  if (pattern && soap->fwvalidate)
+  {
+    soap->error = soap->fwvalidate(soap, pattern, s);
+    if (soap->error)
+      return NULL;
+  }
+#endif
+#ifdef WITH_DOM
+  if ((soap->mode & SOAP_XML_DOM) && soap->dom)
+    soap->dom->text = soap_wchar2s(soap, s);
+#endif
+  return s;
+}
+#endif
+
+/******************************************************************************/
+
+/* sends an integer as element content */
+static int
+soap_integer_out(struct soap *soap, LONG64 n)
+{
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_OUT))
+    return soap_bxml_put_num(soap, SOAP_BXML_INT, n < 0 ? ((ULONG64)(-(n + 1)) << 1) | 1 : (ULONG64)n << 1);
+#endif
+  return soap_string_out(soap, soap_LONG642s(soap, n), 0);
+}
+
+/******************************************************************************/
+
+/* sends an unsigned integer as element content */
+static int
+soap_unsigned_out(struct soap *soap, ULONG64 n)
+{
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_OUT))
+    return soap_bxml_put_num(soap, SOAP_BXML_UINT, n);
+#endif
+  return soap_string_out(soap, soap_ULONG642s(soap, n), 0);
+}
+
+/******************************************************************************/
+
+/* sends a float as element content */
+static int
+soap_float_out(struct soap *soap, float f)
+{
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_OUT))
+  {
+    soap_int32 n;
+    (void)soap_memcpy((void*)&n, sizeof(n), (const void*)&f, sizeof(f));
+    return soap_cbor_send_arg(soap, SOAP_BXML_FLOAT, (ULONG64)n & 0xFFFFFFFF, 4);
+  }
+#endif
+  return soap_string_out(soap, soap_float2s(soap, f), 0);
+}
+
+/******************************************************************************/
+
+/* sends a double as element content */
+static int
+soap_double_out(struct soap *soap, double d)
+{
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_OUT))
+  {
+    ULONG64 n;
+    (void)soap_memcpy((void*)&n, sizeof(n), (const void*)&d, sizeof(d));
+    return soap_cbor_send_arg(soap, SOAP_BXML_DOUBLE, n, 8);
+  }
+#endif
+  return soap_string_out(soap, soap_double2s(soap, d), 0);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+const char*
+SOAP_FMAC2
+soap_int2s(struct soap *soap, int n)
+{
+  return soap_long2s(soap, (long)n);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_outint(struct soap *soap, const char *tag, int id, const int *p, const char *type, int n)
+{
+  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
+   || soap_integer_out(soap, (LONG64)*p))
+    return soap->error;
+  return soap_element_end_out(soap, tag);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2int(struct soap *soap, const char *s, int *p)
+{
+  if (s)
+  {
+    long n;
+    char *r;
+    if (!*s)
+      return soap->error = SOAP_EMPTY;
+#ifndef WITH_NOIO
+#ifndef WITH_LEAN
+    soap_reset_errno;
+#endif
+#endif
+    n = soap_strtol(s, &r, 10);
+    if (s == r || *r
+#ifndef WITH_LEAN
+        || n != (int)n
+#endif
+#ifndef WITH_NOIO
+#ifndef WITH_LEAN
+        || soap_errno == SOAP_ERANGE
+#endif
+#endif
+    )
+      soap->error = SOAP_TYPE;
+    *p = (int)n;
+  }
+  return soap->error;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int *
+SOAP_FMAC2
+soap_inint(struct soap *soap, const char *tag, int *p, const char *type, int t)
+{
+  if (soap_element_begin_in(soap, tag, 0, NULL))
+    return NULL;
+#ifndef WITH_LEAN
+  if (*soap->type
+   && soap_match_tag(soap, soap->type, type)
+   && soap_match_tag(soap, soap->type, ":int")
+   && soap_match_tag(soap, soap->type, ":short")
+   && soap_match_tag(soap, soap->type, ":byte"))
+  {
+    soap->error = SOAP_TYPE;
+    soap_revert(soap);
+    return NULL;
+  }
+#else
+  (void)type;
+#endif
+  p = (int*)soap_id_enter(soap, soap->id, p, t, sizeof(int), NULL, NULL, NULL, NULL);
+  if (!p)
+    return NULL;
+  if (*soap->href != '#')
+  {
+    int err;
+#ifndef WITH_LEAN
+    LONG64 n = 0;
+    if (soap_bxml_integer_in(soap, &n, INT_MIN, INT_MAX))
+    {
+      *p = (int)n;
+      err = soap->error;
+    }
+    else
+#endif
+    err = soap_s2int(soap, soap_value(soap), p);
+    if ((soap->body && soap_element_end_in(soap, tag)) || err)
+      return NULL;
+  }
+  else
+  {
+    p = (int*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(int), 0, NULL, NULL);
+    if (soap->body && soap_element_end_in(soap, tag))
+      return NULL;
+  }
+  return p;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+const char*
+SOAP_FMAC2
+soap_long2s(struct soap *soap, long n)
+{
+  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 20), "%ld", n);
+  return soap->tmpbuf;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_outlong(struct soap *soap, const char *tag, int id, const long *p, const char *type, int n)
+{
+  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
+   || soap_integer_out(soap, (LONG64)*p))
+    return soap->error;
+  return soap_element_end_out(soap, tag);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2long(struct soap *soap, const char *s, long *p)
+{
+  if (s)
+  {
+    char *r;
+    if (!*s)
+      return soap->error = SOAP_EMPTY;
+#ifndef WITH_NOIO
+#ifndef WITH_LEAN
+    soap_reset_errno;
+#endif
+#endif
+    *p = soap_strtol(s, &r, 10);
+    if (s == r || *r
+#ifndef WITH_NOIO
+#ifndef WITH_LEAN
+        || soap_errno == SOAP_ERANGE
+#endif
+#endif
+    )
+      soap->error = SOAP_TYPE;
+  }
+  return soap->error;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+long *
+SOAP_FMAC2
+soap_inlong(struct soap *soap, const char *tag, long *p, const char *type, int t)
+{
+  if (soap_element_begin_in(soap, tag, 0, NULL))
+    return NULL;
+#ifndef WITH_LEAN
+  if (*soap->type
+   && soap_match_tag(soap, soap->type, type)
+   && soap_match_tag(soap, soap->type, ":int")
+   && soap_match_tag(soap, soap->type, ":short")
+   && soap_match_tag(soap, soap->type, ":byte"))
+  {
+    soap->error = SOAP_TYPE;
+    soap_revert(soap);
+    return NULL;
+  }
+#else
+  (void)type;
+#endif
+  p = (long*)soap_id_enter(soap, soap->id, p, t, sizeof(long), NULL, NULL, NULL, NULL);
+  if (!p)
+    return NULL;
+  if (*soap->href != '#')
+  {
+    int err;
+#ifndef WITH_LEAN
+    LONG64 n = 0;
+    if (soap_bxml_integer_in(soap, &n, LONG_MIN, LONG_MAX))
+    {
+      *p = (long)n;
+      err = soap->error;
+    }
+    else
+#endif
+    err = soap_s2long(soap, soap_value(soap), p);
+    if ((soap->body && soap_element_end_in(soap, tag)) || err)
+      return NULL;
+  }
+  else
+  {
+    p = (long*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(long), 0, NULL, NULL);
+    if (soap->body && soap_element_end_in(soap, tag))
+      return NULL;
+  }
+  return p;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+const char*
+SOAP_FMAC2
+soap_LONG642s(struct soap *soap, LONG64 n)
+{
+  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 20), SOAP_LONG_FORMAT, n);
+  return soap->tmpbuf;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_outLONG64(struct soap *soap, const char *tag, int id, const LONG64 *p, const char *type, int n)
+{
+  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
+   || soap_integer_out(soap, *p))
+    return soap->error;
+  return soap_element_end_out(soap, tag);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2LONG64(struct soap *soap, const char *s, LONG64 *p)
+{
+  if (s)
+  {
+    char *r;
+    if (!*s)
+      return soap->error = SOAP_EMPTY;
+#ifndef WITH_NOIO
+#ifndef WITH_LEAN
+    soap_reset_errno;
+#endif
+#endif
+    *p = soap_strtoll(s, &r, 10);
+    if (s == r || *r
+#ifndef WITH_NOIO
+#ifndef WITH_LEAN
+        || soap_errno == SOAP_ERANGE
+#endif
+#endif
+      )
+      soap->error = SOAP_TYPE;
+  }
+  return soap->error;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+LONG64 *
+SOAP_FMAC2
+soap_inLONG64(struct soap *soap, const char *tag, LONG64 *p, const char *type, int t)
+{
+  if (soap_element_begin_in(soap, tag, 0, NULL))
+    return NULL;
+#ifndef WITH_LEAN
+  if (*soap->type
+   && soap_match_tag(soap, soap->type, type)
+   && soap_match_tag(soap, soap->type, ":integer")
+   && soap_match_tag(soap, soap->type, ":positiveInteger")
+   && soap_match_tag(soap, soap->type, ":negativeInteger")
+   && soap_match_tag(soap, soap->type, ":nonPositiveInteger")
+   && soap_match_tag(soap, soap->type, ":nonNegativeInteger")
+   && soap_match_tag(soap, soap->type, ":long")
+   && soap_match_tag(soap, soap->type, ":int")
+   && soap_match_tag(soap, soap->type, ":short")
+   && soap_match_tag(soap, soap->type, ":byte"))
+  {
+    soap->error = SOAP_TYPE;
+    soap_revert(soap);
+    return NULL;
+  }
+#else
+  (void)type;
+#endif
+  p = (LONG64*)soap_id_enter(soap, soap->id, p, t, sizeof(LONG64), NULL, NULL, NULL, NULL);
+  if (!p)
+    return NULL;
+  if (*soap->href != '#')
+  {
+    int err;
+#ifndef WITH_LEAN
+    LONG64 n = 0;
+    if (soap_bxml_integer_in(soap, &n, SOAP_LONG64_MIN, SOAP_LONG64_MAX))
+    {
+      *p = (LONG64)n;
+      err = soap->error;
+    }
+    else
+#endif
+    err = soap_s2LONG64(soap, soap_value(soap), p);
+    if ((soap->body && soap_element_end_in(soap, tag)) || err)
+      return NULL;
+  }
+  else
+  {
+    p = (LONG64*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(LONG64), 0, NULL, NULL);
+    if (soap->body && soap_element_end_in(soap, tag))
+      return NULL;
+  }
+  return p;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+const char*
+SOAP_FMAC2
+soap_byte2s(struct soap *soap, char n)
+{
+  return soap_long2s(soap, (long)n);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_outbyte(struct soap *soap, const char *tag, int id, const char *p, const char *type, int n)
+{
+  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
+   || soap_integer_out(soap, (LONG64)*p))
+    return soap->error;
+  return soap_element_end_out(soap, tag);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2byte(struct soap *soap, const char *s, char *p)
+{
+  if (s)
+  {
+    long n;
+    char *r;
+    if (!*s)
+      return soap->error = SOAP_EMPTY;
+    n = soap_strtol(s, &r, 10);
+    if (s == r || *r || n < -128 || n > 127)
+      soap->error = SOAP_TYPE;
+    *p = (char)n;
+  }
+  return soap->error;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+char *
+SOAP_FMAC2
+soap_inbyte(struct soap *soap, const char *tag, char *p, const char *type, int t)
+{
+  if (soap_element_begin_in(soap, tag, 0, NULL))
+    return NULL;
+#ifndef WITH_LEAN
+  if (*soap->type
+   && soap_match_tag(soap, soap->type, type)
+   && soap_match_tag(soap, soap->type, ":byte"))
+  {
+    soap->error = SOAP_TYPE;
+    soap_revert(soap);
+    return NULL;
+  }
+#else
+  (void)type;
+#endif
+  p = (char*)soap_id_enter(soap, soap->id, p, t, sizeof(char), NULL, NULL, NULL, NULL);
+  if (!p)
+    return NULL;
+  if (*soap->href != '#')
+  {
+    int err;
+#ifndef WITH_LEAN
+    LONG64 n = 0;
+    if (soap_bxml_integer_in(soap, &n, -128, 127))
+    {
+      *p = (char)n;
+      err = soap->error;
+    }
+    else
+#endif
+    err = soap_s2byte(soap, soap_value(soap), p);
+    if ((soap->body && soap_element_end_in(soap, tag)) || err)
+      return NULL;
+  }
+  else
+  {
+    p = (char*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(char), 0, NULL, NULL);
+    if (soap->body && soap_element_end_in(soap, tag))
+      return NULL;
+  }
+  return p;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+const char*
+SOAP_FMAC2
+soap_short2s(struct soap *soap, short n)
+{
+  return soap_long2s(soap, (long)n);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_outshort(struct soap *soap, const char *tag, int id, const short *p, const char *type, int n)
+{
+  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
+   || soap_integer_out(soap, (LONG64)*p))
+    return soap->error;
+  return soap_element_end_out(soap, tag);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2short(struct soap *soap, const char *s, short *p)
+{
+  if (s)
+  {
+    long n;
+    char *r;
+    if (!*s)
+      return soap->error = SOAP_EMPTY;
+    n = soap_strtol(s, &r, 10);
+    if (s == r || *r || n < -32768 || n > 32767)
+      soap->error = SOAP_TYPE;
+    *p = (short)n;
+  }
+  return soap->error;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+short *
+SOAP_FMAC2
+soap_inshort(struct soap *soap, const char *tag, short *p, const char *type, int t)
+{
+  if (soap_element_begin_in(soap, tag, 0, NULL))
+    return NULL;
+#ifndef WITH_LEAN
+  if (*soap->type
+   && soap_match_tag(soap, soap->type, type)
+   && soap_match_tag(soap, soap->type, ":short")
+   && soap_match_tag(soap, soap->type, ":byte"))
+  {
+    soap->error = SOAP_TYPE;
+    soap_revert(soap);
+    return NULL;
+  }
+#else
+  (void)type;
+#endif
+  p = (short*)soap_id_enter(soap, soap->id, p, t, sizeof(short), NULL, NULL, NULL, NULL);
+  if (!p)
+    return NULL;
+  if (*soap->href != '#')
+  {
+    int err;
+#ifndef WITH_LEAN
+    LONG64 n = 0;
+    if (soap_bxml_integer_in(soap, &n, -32768, 32767))
+    {
+      *p = (short)n;
+      err = soap->error;
+    }
+    else
+#endif
+    err = soap_s2short(soap, soap_value(soap), p);
+    if ((soap->body && soap_element_end_in(soap, tag)) || err)
+      return NULL;
+  }
+  else
+  {
+    p = (short*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(short), 0, NULL, NULL);
+    if (soap->body && soap_element_end_in(soap, tag))
+      return NULL;
+  }
+  return p;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+const char*
+SOAP_FMAC2
+soap_float2s(struct soap *soap, float n)
+{
+#if defined(WITH_C_LOCALE)
+# if !defined(WIN32)
+  SOAP_LOCALE_T locale;
+# endif
+#else
+  char *s;
+#endif
+  if (soap_isnan((double)n))
+    return "NaN";
+  if (soap_ispinff(n))
+    return "INF";
+  if (soap_isninff(n))
+    return "-INF";
+#if defined(WITH_C_LOCALE)
+# ifdef WIN32
+  _sprintf_s_l(soap->tmpbuf, _countof(soap->tmpbuf), soap->float_format, SOAP_LOCALE(soap), n);
+# else
+  locale = uselocale(SOAP_LOCALE(soap));
+  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 80), soap->float_format, n);
+  uselocale(locale);
+# endif
+#else
+  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 80), soap->float_format, n);
+  s = strchr(soap->tmpbuf, ',');        /* convert decimal comma to DP */
+  if (s)
+    *s = '.';
+#endif
+  return soap->tmpbuf;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_outfloat(struct soap *soap, const char *tag, int id, const float *p, const char *type, int n)
+{
+  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
+   || soap_float_out(soap, *p))
+    return soap->error;
+  return soap_element_end_out(soap, tag);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2float(struct soap *soap, const char *s, float *p)
+{
+  if (s)
+  {
+    if (!*s)
+      return soap->error = SOAP_EMPTY;
+    if (!soap_tag_cmp(s, "INF"))
+    {
+      *p = FLT_PINFTY;
+    }
+    else if (!soap_tag_cmp(s, "+INF"))
+    {
+      *p = FLT_PINFTY;
+    }
+    else if (!soap_tag_cmp(s, "-INF"))
+    {
+      *p = FLT_NINFTY;
+    }
+    else if (!soap_tag_cmp(s, "NaN"))
+    {
+      *p = FLT_NAN;
+    }
+    else
+    {
+/* On some systems strtof requires -std=c99 or does not even link: so we try strtod first */
+#if defined(WITH_C_LOCALE)
+# if defined(HAVE_STRTOD_L)
+      char *r;
+#  ifdef WIN32
+      *p = (float)_strtod_l(s, &r, SOAP_LOCALE(soap));
+#  else
+      *p = (float)strtod_l(s, &r, SOAP_LOCALE(soap));
+#  endif
+      if (*r)
+        soap->error = SOAP_TYPE;
+# elif defined(HAVE_STRTOF_L)
+      char *r;
+      *p = strtof_l((char*)s, &r, SOAP_LOCALE(soap));
+      if (*r)
+        soap->error = SOAP_TYPE;
+# elif defined(HAVE_SSCANF_L)
+      double n;
+      if (sscanf_l(s, SOAP_LOCALE(soap), "%lf", &n) != 1)
+        soap->error = SOAP_TYPE;
+      *p = (float)n;
+# elif defined(HAVE_STRTOD)
+      char *r;
+      SOAP_LOCALE_T locale = uselocale(SOAP_LOCALE(soap));
+      *p = (float)strtod((char*)s, &r);
+      uselocale(locale);
+      if (*r)
+        soap->error = SOAP_TYPE;
+# elif defined(HAVE_STRTOF)
+      char *r;
+      SOAP_LOCALE_T locale = uselocale(SOAP_LOCALE(soap));
+      *p = strtof((char*)s, &r);
+      uselocale(locale);
+      if (*r)
+        soap->error = SOAP_TYPE;
+# elif defined(HAVE_SSCANF)
+      double n;
+      SOAP_LOCALE_T locale = uselocale(SOAP_LOCALE(soap));
+      if (sscanf(s, "%lf", &n) != 1)
+        soap->error = SOAP_TYPE;
+      uselocale(locale);
+      *p = (float)n;
+# else
+      soap->error = SOAP_TYPE;
+# endif
+#elif defined(HAVE_STRTOD)
+      char *r;
+      *p = (float)strtod(s, &r);
+      if (*r)
+        soap->error = SOAP_TYPE;
+#elif defined(HAVE_STRTOF)
+      char *r;
+      *p = strtof((char*)s, &r);
+      if (*r)
+        soap->error = SOAP_TYPE;
+#elif defined(HAVE_SSCANF)
+      double n;
+      if (sscanf(s, "%lf", &n) != 1)
+        soap->error = SOAP_TYPE;
+      *p = (float)n;
+#else
+      soap->error = SOAP_TYPE;
+#endif
+    }
+  }
+  return soap->error;
+}
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+static int soap_isnumeric(struct soap *soap, const char *type)
+{
+  if (soap_match_tag(soap, soap->type, type)
+   && soap_match_tag(soap, soap->type, ":float")
+   && soap_match_tag(soap, soap->type, ":double")
+   && soap_match_tag(soap, soap->type, ":decimal")
+   && soap_match_tag(soap, soap->type, ":integer")
+   && soap_match_tag(soap, soap->type, ":positiveInteger")
+   && soap_match_tag(soap, soap->type, ":negativeInteger")
+   && soap_match_tag(soap, soap->type, ":nonPositiveInteger")
+   && soap_match_tag(soap, soap->type, ":nonNegativeInteger")
+   && soap_match_tag(soap, soap->type, ":long")
+   && soap_match_tag(soap, soap->type, ":int")
+   && soap_match_tag(soap, soap->type, ":short")
+   && soap_match_tag(soap, soap->type, ":byte")
+   && soap_match_tag(soap, soap->type, ":unsignedLong")
+   && soap_match_tag(soap, soap->type, ":unsignedInt")
+   && soap_match_tag(soap, soap->type, ":unsignedShort")
+   && soap_match_tag(soap, soap->type, ":unsignedByte"))
+  {
+    soap->error = SOAP_TYPE;
+    soap_revert(soap);
+    return SOAP_ERR;
+  }
+  return SOAP_OK;
+}
+#endif
+
+/******************************************************************************/
+
+SOAP_FMAC1
+float *
+SOAP_FMAC2
+soap_infloat(struct soap *soap, const char *tag, float *p, const char *type, int t)
+{
+  if (soap_element_begin_in(soap, tag, 0, NULL))
+    return NULL;
+#ifndef WITH_LEAN
+  if (*soap->type != '\0' && soap_isnumeric(soap, type))
+    return NULL;
+#else
+  (void)type;
+#endif
+  p = (float*)soap_id_enter(soap, soap->id, p, t, sizeof(float), NULL, NULL, NULL, NULL);
+  if (!p)
+    return NULL;
+  if (*soap->href != '#')
+  {
+    int err;
+#ifndef WITH_LEAN
+    double d = 0.0;
+    if (soap_bxml_double_in(soap, &d))
+    {
+      *p = (float)d;
+      err = soap->error;
+    }
+    else
+#endif
+    err = soap_s2float(soap, soap_value(soap), p);
+    if ((soap->body && soap_element_end_in(soap, tag)) || err)
+      return NULL;
+  }
+  else
+  {
+    p = (float*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(float), 0, NULL, NULL);
+    if (soap->body && soap_element_end_in(soap, tag))
+      return NULL;
+  }
+  return p;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+const char*
+SOAP_FMAC2
+soap_double2s(struct soap *soap, double n)
+{
+#if defined(WITH_C_LOCALE)
+# if !defined(WIN32)
+  SOAP_LOCALE_T locale;
+# endif
+#else
+  char *s;
+#endif
+  if (soap_isnan(n))
+    return "NaN";
+  if (soap_ispinfd(n))
+    return "INF";
+  if (soap_isninfd(n))
+    return "-INF";
+#if defined(WITH_C_LOCALE)
+# ifdef WIN32
+  _sprintf_s_l(soap->tmpbuf, _countof(soap->tmpbuf), soap->double_format, SOAP_LOCALE(soap), n);
+# else
+  locale = uselocale(SOAP_LOCALE(soap));
+  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 80), soap->double_format, n);
+  uselocale(locale);
+# endif
+#else
+  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 80), soap->double_format, n);
+  s = strchr(soap->tmpbuf, ',');        /* convert decimal comma to DP */
+  if (s)
+    *s = '.';
+#endif
+  return soap->tmpbuf;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_outdouble(struct soap *soap, const char *tag, int id, const double *p, const char *type, int n)
+{
+  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
+   || soap_double_out(soap, *p))
+    return soap->error;
+  return soap_element_end_out(soap, tag);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2double(struct soap *soap, const char *s, double *p)
+{
+  if (s)
+  {
+    if (!*s)
+      return soap->error = SOAP_EMPTY;
+    if (!soap_tag_cmp(s, "INF"))
+    {
+      *p = DBL_PINFTY;
+    }
+    else if (!soap_tag_cmp(s, "+INF"))
+    {
+      *p = DBL_PINFTY;
+    }
+    else if (!soap_tag_cmp(s, "-INF"))
+    {
+      *p = DBL_NINFTY;
+    }
+    else if (!soap_tag_cmp(s, "NaN"))
+    {
+      *p = DBL_NAN;
+    }
+    else
+    {
+#if defined(WITH_C_LOCALE)
+# if defined(HAVE_STRTOD_L)
+      char *r;
+#  ifdef WIN32
+      *p = _strtod_l(s, &r, SOAP_LOCALE(soap));
+#  else
+      *p = strtod_l(s, &r, SOAP_LOCALE(soap));
+#  endif
+      if (*r)
+        soap->error = SOAP_TYPE;
+# elif defined(HAVE_STRTOD)
+      char *r;
+      SOAP_LOCALE_T locale = uselocale(SOAP_LOCALE(soap));
+      *p = strtod(s, &r);
+      uselocale(locale);
+      if (*r)
+        soap->error = SOAP_TYPE;
+# elif defined(HAVE_SSCANF_L)
+      SOAP_LOCALE_T locale = uselocale(SOAP_LOCALE(soap));
+      if (sscanf_l(s, SOAP_LOCALE(soap), "%lf", p) != 1)
+        soap->error = SOAP_TYPE;
+      uselocale(locale);
+# else
+      soap->error = SOAP_TYPE;
+# endif
+#elif defined(HAVE_STRTOD)
+      char *r;
+      *p = strtod(s, &r);
+      if (*r)
+        soap->error = SOAP_TYPE;
+#elif defined(HAVE_SSCANF)
+      if (sscanf(s, "%lf", p) != 1)
+        soap->error = SOAP_TYPE;
+#else
+      soap->error = SOAP_TYPE;
+#endif
+    }
+  }
+  return soap->error;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+double *
+SOAP_FMAC2
+soap_indouble(struct soap *soap, const char *tag, double *p, const char *type, int t)
+{
+  if (soap_element_begin_in(soap, tag, 0, NULL))
+    return NULL;
+#ifndef WITH_LEAN
+  if (*soap->type != '\0' && soap_isnumeric(soap, type))
+    return NULL;
+#else
+  (void)type;
+#endif
+  p = (double*)soap_id_enter(soap, soap->id, p, t, sizeof(double), NULL, NULL, NULL, NULL);
+  if (!p)
+    return NULL;
+  if (*soap->href != '#')
+  {
+    int err;
+#ifndef WITH_LEAN
+    double d = 0.0;
+    if (soap_bxml_double_in(soap, &d))
+    {
+      *p = d;
+      err = soap->error;
+    }
+    else
+#endif
+    err = soap_s2double(soap, soap_value(soap), p);
+    if ((soap->body && soap_element_end_in(soap, tag)) || err)
+      return NULL;
+  }
+  else
+  {
+    p = (double*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(double), 0, NULL, NULL);
+    if (soap->body && soap_element_end_in(soap, tag))
+      return NULL;
+  }
+  return p;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+const char*
+SOAP_FMAC2
+soap_unsignedByte2s(struct soap *soap, unsigned char n)
+{
+  return soap_unsignedLong2s(soap, (unsigned long)n);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_outunsignedByte(struct soap *soap, const char *tag, int id, const unsigned char *p, const char *type, int n)
+{
+  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
+   || soap_unsigned_out(soap, (ULONG64)*p))
+    return soap->error;
+  return soap_element_end_out(soap, tag);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2unsignedByte(struct soap *soap, const char *s, unsigned char *p)
+{
+  if (s)
+  {
+    long n;
+    char *r;
+    if (!*s)
+      return soap->error = SOAP_EMPTY;
+    n = soap_strtol(s, &r, 10);
+    if (s == r || *r || n < 0 || n > 255)
+      soap->error = SOAP_TYPE;
+    *p = (unsigned char)n;
+  }
+  return soap->error;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+unsigned char *
+SOAP_FMAC2
+soap_inunsignedByte(struct soap *soap, const char *tag, unsigned char *p, const char *type, int t)
+{
+  if (soap_element_begin_in(soap, tag, 0, NULL))
+    return NULL;
+#ifndef WITH_LEAN
+  if (*soap->type
+   && soap_match_tag(soap, soap->type, type)
+   && soap_match_tag(soap, soap->type, ":unsignedByte"))
+  {
+    soap->error = SOAP_TYPE;
+    soap_revert(soap);
+    return NULL;
+  }
+#else
+  (void)type;
+#endif
+  p = (unsigned char*)soap_id_enter(soap, soap->id, p, t, sizeof(unsigned char), NULL, NULL, NULL, NULL);
+  if (!p)
+    return NULL;
+  if (*soap->href != '#')
+  {
+    int err;
+#ifndef WITH_LEAN
+    ULONG64 n = 0;
+    if (soap_bxml_unsigned_in(soap, &n, 255))
+    {
+      *p = (unsigned char)n;
+      err = soap->error;
+    }
+    else
+#endif
+    err = soap_s2unsignedByte(soap, soap_value(soap), p);
+    if ((soap->body && soap_element_end_in(soap, tag)) || err)
+      return NULL;
+  }
+  else
+  {
+    p = (unsigned char*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(unsigned char), 0, NULL, NULL);
+    if (soap->body && soap_element_end_in(soap, tag))
+      return NULL;
+  }
+  return p;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+const char*
+SOAP_FMAC2
+soap_unsignedShort2s(struct soap *soap, unsigned short n)
+{
+  return soap_unsignedLong2s(soap, (unsigned long)n);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_outunsignedShort(struct soap *soap, const char *tag, int id, const unsigned short *p, const char *type, int n)
+{
+  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
+   || soap_unsigned_out(soap, (ULONG64)*p))
+    return soap->error;
+  return soap_element_end_out(soap, tag);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2unsignedShort(struct soap *soap, const char *s, unsigned short *p)
+{
+  if (s)
+  {
+    long n;
+    char *r;
+    if (!*s)
+      return soap->error = SOAP_EMPTY;
+    n = soap_strtol(s, &r, 10);
+    if (s == r || *r || n < 0 || n > 65535)
+      soap->error = SOAP_TYPE;
+    *p = (unsigned short)n;
+  }
+  return soap->error;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+unsigned short *
+SOAP_FMAC2
+soap_inunsignedShort(struct soap *soap, const char *tag, unsigned short *p, const char *type, int t)
+{
+  if (soap_element_begin_in(soap, tag, 0, NULL))
+    return NULL;
+#ifndef WITH_LEAN
+  if (*soap->type
+   && soap_match_tag(soap, soap->type, type)
+   && soap_match_tag(soap, soap->type, ":unsignedShort")
+   && soap_match_tag(soap, soap->type, ":unsignedByte"))
+  {
+    soap->error = SOAP_TYPE;
+    soap_revert(soap);
+    return NULL;
+  }
+#else
+  (void)type;
+#endif
+  p = (unsigned short*)soap_id_enter(soap, soap->id, p, t, sizeof(unsigned short), NULL, NULL, NULL, NULL);
+  if (!p)
+    return NULL;
+  if (*soap->href != '#')
+  {
+    int err;
+#ifndef WITH_LEAN
+    ULONG64 n = 0;
+    if (soap_bxml_unsigned_in(soap, &n, 65535))
+    {
+      *p = (unsigned short)n;
+      err = soap->error;
+    }
+    else
+#endif
+    err = soap_s2unsignedShort(soap, soap_value(soap), p);
+    if ((soap->body && soap_element_end_in(soap, tag)) || err)
+      return NULL;
+  }
+  else
+  {
+    p = (unsigned short*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(unsigned short), 0, NULL, NULL);
+    if (soap->body && soap_element_end_in(soap, tag))
+      return NULL;
+  }
+  return p;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+const char*
+SOAP_FMAC2
+soap_unsignedInt2s(struct soap *soap, unsigned int n)
+{
+  return soap_unsignedLong2s(soap, (unsigned long)n);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_outunsignedInt(struct soap *soap, const char *tag, int id, const unsigned int *p, const char *type, int n)
+{
+  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
+   || soap_unsigned_out(soap, (ULONG64)*p))
+    return soap->error;
+  return soap_element_end_out(soap, tag);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2unsignedInt(struct soap *soap, const char *s, unsigned int *p)
+{
+  if (s)
+  {
+    unsigned long n;
+    char *r;
+    if (!*s)
+      return soap->error = SOAP_EMPTY;
+#ifndef WITH_NOIO
+#ifndef WITH_LEAN
+    soap_reset_errno;
+#endif
+#endif
+    n = soap_strtoul(s, &r, 10);
+    if (s == r || *r
+#ifndef WITH_LEAN
+        || n != (unsigned int)n
+#endif
+#ifndef WITH_NOIO
+#ifndef WITH_LEAN
+        || soap_errno == SOAP_ERANGE
+#endif
+#endif
+    )
+      soap->error = SOAP_TYPE;
+#ifdef HAVE_STRTOUL
+    if (n > 0 && strchr(s, '-'))
+      return soap->error = SOAP_TYPE;
+#endif
+    *p = (unsigned int)n;
+  }
+  return soap->error;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+unsigned int *
+SOAP_FMAC2
+soap_inunsignedInt(struct soap *soap, const char *tag, unsigned int *p, const char *type, int t)
+{
+  if (soap_element_begin_in(soap, tag, 0, NULL))
+    return NULL;
+#ifndef WITH_LEAN
+  if (*soap->type
+   && soap_match_tag(soap, soap->type, type)
+   && soap_match_tag(soap, soap->type, ":unsignedInt")
+   && soap_match_tag(soap, soap->type, ":unsignedShort")
+   && soap_match_tag(soap, soap->type, ":unsignedByte"))
+  {
+    soap->error = SOAP_TYPE;
+    soap_revert(soap);
+    return NULL;
+  }
+#else
+  (void)type;
+#endif
+  p = (unsigned int*)soap_id_enter(soap, soap->id, p, t, sizeof(unsigned int), NULL, NULL, NULL, NULL);
+  if (!p)
+    return NULL;
+  if (*soap->href != '#')
+  {
+    int err;
+#ifndef WITH_LEAN
+    ULONG64 n = 0;
+    if (soap_bxml_unsigned_in(soap, &n, UINT_MAX))
+    {
+      *p = (unsigned int)n;
+      err = soap->error;
+    }
+    else
+#endif
+    err = soap_s2unsignedInt(soap, soap_value(soap), p);
+    if ((soap->body && soap_element_end_in(soap, tag)) || err)
+      return NULL;
+  }
+  else
+  {
+    p = (unsigned int*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(unsigned int), 0, NULL, NULL);
+    if (soap->body && soap_element_end_in(soap, tag))
+      return NULL;
+  }
+  return p;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+const char*
+SOAP_FMAC2
+soap_unsignedLong2s(struct soap *soap, unsigned long n)
+{
+  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 20), "%lu", n);
+  return soap->tmpbuf;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_outunsignedLong(struct soap *soap, const char *tag, int id, const unsigned long *p, const char *type, int n)
+{
+  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
+   || soap_unsigned_out(soap, (ULONG64)*p))
+    return soap->error;
+  return soap_element_end_out(soap, tag);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2unsignedLong(struct soap *soap, const char *s, unsigned long *p)
+{
+  if (s)
+  {
+    char *r;
+    if (!*s)
+      return soap->error = SOAP_EMPTY;
+#ifndef WITH_NOIO
+#ifndef WITH_LEAN
+    soap_reset_errno;
+#endif
+#endif
+    *p = soap_strtoul(s, &r, 10);
+    if (s == r || *r
+#ifndef WITH_NOIO
+#ifndef WITH_LEAN
+        || soap_errno == SOAP_ERANGE
+#endif
+#endif
+    )
+      soap->error = SOAP_TYPE;
+#ifdef HAVE_STRTOUL
+    if (*p > 0 && strchr(s, '-'))
+      return soap->error = SOAP_TYPE;
+#endif
+  }
+  return soap->error;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+unsigned long *
+SOAP_FMAC2
+soap_inunsignedLong(struct soap *soap, const char *tag, unsigned long *p, const char *type, int t)
+{
+  if (soap_element_begin_in(soap, tag, 0, NULL))
+    return NULL;
+#ifndef WITH_LEAN
+  if (*soap->type
+   && soap_match_tag(soap, soap->type, type)
+   && soap_match_tag(soap, soap->type, ":unsignedInt")
+   && soap_match_tag(soap, soap->type, ":unsignedShort")
+   && soap_match_tag(soap, soap->type, ":unsignedByte"))
+  {
+    soap->error = SOAP_TYPE;
+    soap_revert(soap);
+    return NULL;
+  }
+#else
+  (void)type;
+#endif
+  p = (unsigned long*)soap_id_enter(soap, soap->id, p, t, sizeof(unsigned long), NULL, NULL, NULL, NULL);
+  if (!p)
+    return NULL;
+  if (*soap->href != '#')
+  {
+    int err;
+#ifndef WITH_LEAN
+    ULONG64 n = 0;
+    if (soap_bxml_unsigned_in(soap, &n, ULONG_MAX))
+    {
+      *p = (unsigned long)n;
+      err = soap->error;
+    }
+    else
+#endif
+    err = soap_s2unsignedLong(soap, soap_value(soap), p);
+    if ((soap->body && soap_element_end_in(soap, tag)) || err)
+      return NULL;
+  }
+  else
+  {
+    p = (unsigned long*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(unsigned long), 0, NULL, NULL);
+    if (soap->body && soap_element_end_in(soap, tag))
+      return NULL;
+  }
+  return p;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+const char*
+SOAP_FMAC2
+soap_ULONG642s(struct soap *soap, ULONG64 n)
+{
+  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 20), SOAP_ULONG_FORMAT, n);
+  return soap->tmpbuf;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_outULONG64(struct soap *soap, const char *tag, int id, const ULONG64 *p, const char *type, int n)
+{
+  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
+   || soap_unsigned_out(soap, *p))
+    return soap->error;
+  return soap_element_end_out(soap, tag);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2ULONG64(struct soap *soap, const char *s, ULONG64 *p)
+{
+  if (s)
+  {
+    char *r;
+    if (!*s)
+      return soap->error = SOAP_EMPTY;
+#ifndef WITH_NOIO
+#ifndef WITH_LEAN
+    soap_reset_errno;
+#endif
+#endif
+    *p = soap_strtoull(s, &r, 10);
+    if (s == r || *r
+#ifndef WITH_NOIO
+#ifndef WITH_LEAN
+        || soap_errno == SOAP_ERANGE
+#endif
+#endif
+      )
+      soap->error = SOAP_TYPE;
+    if (*p > 0 && strchr(s, '-'))
+      return soap->error = SOAP_TYPE;
+  }
+  return soap->error;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+ULONG64 *
+SOAP_FMAC2
+soap_inULONG64(struct soap *soap, const char *tag, ULONG64 *p, const char *type, int t)
+{
+  if (soap_element_begin_in(soap, tag, 0, NULL))
+    return NULL;
+#ifndef WITH_LEAN
+  if (*soap->type
+   && soap_match_tag(soap, soap->type, type)
+   && soap_match_tag(soap, soap->type, ":positiveInteger")
+   && soap_match_tag(soap, soap->type, ":nonNegativeInteger")
+   && soap_match_tag(soap, soap->type, ":unsignedLong")
+   && soap_match_tag(soap, soap->type, ":unsignedInt")
+   && soap_match_tag(soap, soap->type, ":unsignedShort")
+   && soap_match_tag(soap, soap->type, ":unsignedByte"))
+  {
+    soap->error = SOAP_TYPE;
+    soap_revert(soap);
+    return NULL;
+  }
+#else
+  (void)type;
+#endif
+  p = (ULONG64*)soap_id_enter(soap, soap->id, p, t, sizeof(ULONG64), NULL, NULL, NULL, NULL);
+  if (!p)
+    return NULL;
+  if (*soap->href != '#')
+  {
+    int err;
+#ifndef WITH_LEAN
+    ULONG64 n = 0;
+    if (soap_bxml_unsigned_in(soap, &n, ~(ULONG64)0))
+    {
+      *p = (ULONG64)n;
+      err = soap->error;
+    }
+    else
+#endif
+    err = soap_s2ULONG64(soap, soap_value(soap), p);
+    if ((soap->body && soap_element_end_in(soap, tag)) || err)
+      return NULL;
+  }
+  else
+  {
+    p = (ULONG64*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(ULONG64), 0, NULL, NULL);
+    if (soap->body && soap_element_end_in(soap, tag))
+      return NULL;
+  }
+  return p;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2char(struct soap *soap, const char *s, char **t, int flag, long minlen, long maxlen, const char *pattern)
+{
+  if (s)
+  {
+    const char *r = soap_string(soap, s, flag, minlen, maxlen, pattern);
+    if (r && (*t = soap_strdup(soap, r)) == NULL)
+      return soap->error = SOAP_EOM;
+  }
+  return soap->error;
+}
+
+/******************************************************************************/
+
+#ifndef WITH_COMPAT
+#ifdef __cplusplus
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2stdchar(struct soap *soap, const char *s, std::string *t, int flag, long minlen, long maxlen, const char *pattern)
+{
+  if (s)
+  {
+    const char *r = soap_string(soap, s, flag, minlen, maxlen, pattern);
+    if (r)
+      t->assign(r);
+  }
+  return soap->error;
+}
+#endif
+#endif
+
+/******************************************************************************/
+
+static const char*
+soap_string(struct soap *soap, const char *s, int flag, long minlen, long maxlen, const char *pattern)
+{
+  if (s)
+  {
+    if (maxlen < 0 && soap->maxlength > 0)
+      maxlen = soap->maxlength;
+    if (minlen > 0 || maxlen >= 0)
+    {
+      size_t l;
+      if ((soap->mode & SOAP_C_UTFSTRING))
+        l = soap_utf8len(s);
+      else
+        l = strlen(s);
+      if ((maxlen >= 0 && l > (size_t)maxlen) || (minlen > 0 && l < (size_t)minlen))
+      {
+        soap->error = SOAP_LENGTH;
+        return NULL;
+      }
+    }
+    if (flag >= 4)
+      s = soap_collapse(soap, (char*)s, flag, 0);
+#ifndef WITH_LEANER
+    if (pattern && soap->fsvalidate)
+    {
+      soap->error = soap->fsvalidate(soap, pattern, s);
+      if (soap->error)
+        return NULL;
+    }
+#else
+    (void)pattern;
+#endif
+  }
+  return s;
+}
+
+/******************************************************************************/
+
+static char*
+soap_collapse(struct soap *soap, char *s, int flag, int insitu)
+{
+  /* flag 4=normalizedString (replace), 5=token (collapse) */
+  char *t;
+  size_t n;
+  if (!s)
+    return NULL;
+  if (flag == 4)
+  {
+    for (t = s; *t && (!soap_coblank((soap_wchar)*t) || *t == 32); t++)
+      continue;
+    if (*t)
+    {
+      /* replace white space and control chars by blanks */
+      if (!insitu)
+        s = soap_strdup(soap, s);
+      for (t = s; *t; t++)
+        if (soap_coblank((soap_wchar)*t))
+          *t = ' ';
+    }
+    return s;
+  }
+  /* collapse white space */
+  for (t = s; *t && soap_coblank((soap_wchar)*t); t++)
+    continue;
+  n = strlen(t);
+  if (insitu && s < t)
+    (void)soap_memmove(s, n + 1, t, n + 1);
+  else
+    s = t;
+  if (n > 0)
+  {
+    if (!soap_coblank((soap_wchar)s[n-1]))
+    {
+      for (t = s; (*t && !soap_coblank((soap_wchar)*t)) || (*t == 32 && (!t[1] || !soap_coblank((soap_wchar)t[1]))); t++)
+        continue;
+      if (!*t)
+        return s;
+    }
+    if (!insitu)
+      s = soap_strdup(soap, s);
+    for (t = s; *t; t++)
+    {
+      if (soap_coblank((soap_wchar)*t))
+      {
+        char *r;
+        *t = ' ';
+        for (r = t + 1; *r && soap_coblank((soap_wchar)*r); r++)
+          continue;
+        if (r > t + 1)
+          (void)soap_memmove(t + 1, n - (t-s), r, n - (r-s) + 1);
+      }
+    }
+    t--;
+    if (t >= s && *t == 32)
+      *t = '\0';
+  }
+  return s;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2QName(struct soap *soap, const char *s, char **t, long minlen, long maxlen, const char *pattern)
+{
+  *t = NULL;
+  if (s)
+  {
+    const char *r = soap_QName(soap, s, minlen, maxlen, pattern);
+    if (r && (*t = soap_strdup(soap, r)) == NULL)
+      return soap->error = SOAP_EOM;
+  }
+  return soap->error;
+}
+
+/******************************************************************************/
+
+#ifndef WITH_COMPAT
+#ifdef __cplusplus
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2stdQName(struct soap *soap, const char *s, std::string *t, long minlen, long maxlen, const char *pattern)
+{
+  t->clear();
+  if (s)
+  {
+    const char *r = soap_QName(soap, s, minlen, maxlen, pattern);
+    if (r)
+      t->assign(r);
+  }
+  return soap->error;
+}
+#endif
+#endif
+
+/******************************************************************************/
+
+static const char*
+soap_QName(struct soap *soap, const char *s, long minlen, long maxlen, const char *pattern)
+{
+  if (s)
+  {
+    char *b;
+    if (maxlen < 0 && soap->maxlength > 0)
+      maxlen = soap->maxlength;
+    if (minlen > 0 || maxlen >= 0)
+    {
+      size_t l;
+      if ((soap->mode & SOAP_C_UTFSTRING))
+        l = soap_utf8len(s);
+      else
+        l = strlen(s);
+      if ((maxlen >= 0 && l > (size_t)maxlen) || (minlen > 0 && l < (size_t)minlen))
+      {
+        soap->error = SOAP_LENGTH;
+        return NULL;
+      }
+    }
+#ifdef WITH_FAST
+    soap->labidx = 0;
+#else
+    if (soap_alloc_block(soap) == NULL)
+      return NULL;
+#endif
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Normalized namespace(s) of QNames '%s'", s));
+    /* convert (by prefix normalize prefix) all QNames in s */
+    for (;;)
+    {
+      size_t n;
+      struct soap_nlist *np;
+      const char *p = NULL;
+      short flag = 0;
+      const char *r = NULL;
+      size_t m = 0;
+#ifndef WITH_FAST
+      size_t k = 0;
+#endif
+      /* skip blanks */
+      while (*s && soap_coblank((soap_wchar)*s))
+        s++;
+      if (!*s)
+        break;
+      /* find next QName */
+      n = 1;
+      while (s[n] && !soap_coblank((soap_wchar)s[n]))
+        n++;
+      np = soap->nlist;
+      /* if there is no namespace stack, or prefix is "#" or "xml" then copy string */
+      if (!np || *s == '#' || !strncmp(s, "xml:", 4))
+      {
+        r = s;
+        m = n;
+      }
+      else /* we normalize the QName by replacing its prefix */
+      {
+        const char *q;
+        for (p = s; *p && p < s + n; p++)
+          if (*p == ':')
+            break;
+        if (*p == ':')
+        {
+          size_t k = p - s;
+          while (np && (strncmp(np->id, s, k) || np->id[k]))
+            np = np->next;
+          p++;
+        }
+        else
+        {
+          while (np && *np->id)
+            np = np->next;
+          p = s;
+        }
+        /* replace prefix */
+        if (np)
+        {
+          if (np->index >= 0 && soap->local_namespaces && (q = soap->local_namespaces[np->index].id) != NULL)
+          {
+            size_t k = strlen(q);
+            if (q[k-1] != '_')
+            {
+              r = q;
+              m = k;
+            }
+            else
+            {
+              flag = 1;
+              r = soap->local_namespaces[np->index].ns;
+              m = strlen(r);
+            }
+          }
+          else if (np->ns)
+          {
+            flag = 1;
+            r = np->ns;
+            m = strlen(r);
+          }
+          else
+          {
+            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "\nNamespace prefix of '%s' not defined (index=%d, URI='%s')\n", s, np->index, np->ns ? np->ns : SOAP_STR_EOS));
+            soap->error = SOAP_NAMESPACE;
+            return NULL;
+          }
+        }
+        else if (s[n]) /* no namespace, part of string */
+        {
+          r = s;
+          m = n;
+        }
+        else /* no namespace: assume "" namespace */
+        {
+          flag = 1;
+        }
+      }
+#ifdef WITH_FAST
+      if ((flag && soap_append_lab(soap, "\"", 1))
+       || (m && soap_append_lab(soap, r, m))
+       || (flag && soap_append_lab(soap, "\"", 1))
+       || (p && (soap_append_lab(soap, ":", 1) || soap_append_lab(soap, p, n - (p-s)))))
+         return NULL;
+#else
+      k = 2*flag + m + (p ? n - (p-s) + 1 : 0) + (s[n] != '\0');
+      b = (char*)soap_push_block(soap, NULL, k);
+      if (!b)
+        return NULL;
+      if (flag)
+        *b++ = '"';
+      if (m)
+      {
+        if (soap_memcpy((void*)b, k, (const void*)r, m))
+        {
+          soap->error = SOAP_EOM;
+          return NULL;
+        }
+        b += m;
+      }
+      if (flag)
+        *b++ = '"';
+      if (p)
+      {
+        *b++ = ':';
+        if (soap_memcpy((void*)b, k - m - flag - 1, (const void*)p, n - (p-s)))
+        {
+          soap->error = SOAP_EOM;
+          return NULL;
+        }
+        b += n - (p-s);
+      }
+#endif
+      /* advance to next and add spacing */
+      s += n;
+      while (*s && soap_coblank(*s))
+        s++;
+      if (*s)
+      {
+#ifdef WITH_FAST
+        if (soap_append_lab(soap, " ", 1))
+          return NULL;
+#else
+        *b = ' ';
+#endif
+      }
+    }
+#ifdef WITH_FAST
+    if (soap_append_lab(soap, SOAP_STR_EOS, 1))
+      return NULL;
+    b = soap->labbuf;
+#else
+    b = (char*)soap_push_block(soap, NULL, 1);
+    if (!b)
+      return NULL;
+    *b = '\0';
+    b = (char*)soap_save_block(soap, NULL, NULL, 0);
+#endif
+#ifndef WITH_LEANER
+    if (pattern && soap->fsvalidate)
+    {
+      soap->error = soap->fsvalidate(soap, pattern, b);
+      if (soap->error)
+        return NULL;
+    }
+#else
+    (void)pattern;
+#endif
+    return b;
+  }
+  return NULL;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+const char*
+SOAP_FMAC2
+soap_QName2s(struct soap *soap, const char *s)
+{
+  const char *t = NULL;
+  if (s)
+  {
+#ifdef WITH_FAST
+    soap_store_lab(soap, SOAP_STR_EOS, 1);
+    soap->labidx = 0;
+#else
+    char *b = NULL;
+    if (soap_alloc_block(soap) == NULL)
+      return NULL;
+#endif
+    for (;;)
+    {
+      size_t n;
+      const char *q = NULL;
+      const char *r = NULL;
+      size_t m = 0;
+#ifndef WITH_FAST
+      size_t k = 0;
+#endif
+      /* skip blanks */
+      while (*s && soap_coblank((soap_wchar)*s))
+        s++;
+      if (!*s)
+      {
+#ifdef WITH_FAST
+        soap->labbuf[soap->labidx > 0 ? soap->labidx - 1 : 0] = '\0';
+#else
+        if (!b)
+          return soap_strdup(soap, SOAP_STR_EOS);
+        --b;
+        *b = '\0';
+#endif
+        break;
+      }
+      /* find next QName */
+      n = 0;
+      while (s[n] && !soap_coblank((soap_wchar)s[n]))
+      {
+        if (s[n] == ':')
+          r = s;
+        n++;
+      }
+      if (*s != '"') /* non-quoted: pass string as is */
+      {
+#ifndef WITH_LEAN
+        if (r && (soap->mode & SOAP_XML_CANONICAL) && !(soap->mode & SOAP_XML_CANONICAL_NA))
+          soap_utilize_ns(soap, s, 1);
+#endif
+        r = s;
+        m = n + 1;
+      }
+      else /* prefix quoted URI-based string */
+      {
+        q = strchr(s + 1, '"');
+        if (q)
+        {
+          struct Namespace *p = soap->local_namespaces;
+          if (p)
+          {
+            for (; p->id; p++)
+            {
+              if (p->ns)
+                if (!soap_tag_cmp(s + 1, p->ns))
+                  break;
+              if (p->in)
+                if (!soap_tag_cmp(s + 1, p->in))
+                  break;
+            }
+          }
+          q++;
+          /* URL is in the namespace table? */
+          if (p && p->id)
+          {
+            r = p->id;
+            m = strlen(r);
+          }
+          else /* not in namespace table: create xmlns binding */
+          {
+            char *x = soap_strdup(soap, s + 1);
+            if (!x)
+              return NULL;
+            x[q - s - 2] = '\0';
+            (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 27), "xmlns:_%d", soap->idnum++);
+            soap_set_attr(soap, soap->tmpbuf, x, 1);
+            r = soap->tmpbuf + 6;
+            m = strlen(r);
+          }
+        }
+      }
+      /* copy normalized QName into buffer, including the ending blank or NUL */
+#ifdef WITH_FAST
+      if ((m && soap_append_lab(soap, r, m))
+       || (q && soap_append_lab(soap, q, n - (q - s) + 1)))
+        return NULL;
+#else
+      k = m + (q ? n - (q - s) + 1 : 0);
+      b = (char*)soap_push_block(soap, NULL, k);
+      if (!b)
+      {
+        soap->error = SOAP_EOM;
+        return NULL;
+      }
+      if (soap_memcpy((void*)b, k, (const void*)r, m))
+      {
+        soap->error = SOAP_EOM;
+        return NULL;
+      }
+      b += m;
+      if (q)
+      {
+        if (soap_memcpy((void*)b, k - m, (const void*)q, n - (q - s) + 1))
+        {
+          soap->error = SOAP_EOM;
+          return NULL;
+        }
+        b += n - (q - s) + 1;
+      }
+#endif
+      /* advance to next */
+      s += n;
+    }
+#ifdef WITH_FAST
+    t = soap_strdup(soap, soap->labbuf);
+    if (!t)
+      soap->error = SOAP_EOM;
+#else
+    t = (char*)soap_save_block(soap, NULL, NULL, 0);
+#endif
+  }
+  return t;
+}
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2wchar(struct soap *soap, const char *s, wchar_t **t, int flag, long minlen, long maxlen, const char *pattern)
+{
+  if (s)
+  {
+    const wchar_t *r = soap_wstring(soap, s, flag, minlen, maxlen, pattern);
+    if (r && (*t = soap_wstrdup(soap, r)) == NULL)
+      return soap->error = SOAP_EOM;
+  }
+  return soap->error;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_COMPAT
+#ifdef __cplusplus
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_s2stdwchar(struct soap *soap, const char *s, std::wstring *t, int flag, long minlen, long maxlen, const char *pattern)
+{
+  if (s)
+  {
+    const wchar_t *r = soap_wstring(soap, s, flag, minlen, maxlen, pattern);
+    if (r)
+      t->assign(r);
+  }
+  return soap->error;
+}
+#endif
+#endif
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+static const wchar_t*
+soap_wstring(struct soap *soap, const char *s, int flag, long minlen, long maxlen, const char *pattern)
+{
+  if (s)
+  {
+    size_t l;
+    soap_wchar c;
+    wchar_t *t;
+    if (maxlen < 0 && soap->maxlength > 0)
+      maxlen = soap->maxlength;
+    soap->labidx = 0;
+    if ((soap->mode & SOAP_ENC_LATIN))
+    {
+      wchar_t *r;
+      if (soap_append_lab(soap, NULL, sizeof(wchar_t) * (strlen(s) + 1)))
+        return NULL;
+      r = (wchar_t*)(void*)soap->labbuf;
+      while (*s)
+        *r++ = (wchar_t)*s++;
+    }
+    else
+    {
+      /* Convert UTF8 to wchar_t */
+      while (*s)
+      {
+        c = (unsigned char)*s++;
+        if (c >= 0x80)
+        {
+#ifdef WITH_REPLACE_ILLEGAL_UTF8
+          soap_wchar c1, c2, c3;
+          c1 = (unsigned char)*s;
+          if (c <= 0xC1 || (c1 & 0xC0) != 0x80)
+          {
+            c = SOAP_UNKNOWN_UNICODE_CHAR;
+          }
+          else
+          {
+            ++s;
+            c1 &= 0x3F;
+            if (c < 0xE0)
+            {
+              c = (((c & 0x1F) << 6) | c1);
+            }
+            else
+            {
+              c2 = (unsigned char)*s;
+              if ((c == 0xE0 && c1 < 0x20) || (c2 & 0xC0) != 0x80)
+              {
+                c = SOAP_UNKNOWN_UNICODE_CHAR;
+              }
+              else
+              {
+                ++s;
+                c2 &= 0x3F;
+                if (c < 0xF0)
+                {
+                  c = (((c & 0x0F) << 12) | (c1 << 6) | c2);
+                }
+                else
+                {
+                  c3 = (unsigned char)*s;
+                  if ((c == 0xF0 && c1 < 0x10) || (c == 0xF4 && c1 >= 0x10) || c >= 0xF5 || (c3 & 0xC0) != 0x80)
+                  {
+                    c = SOAP_UNKNOWN_UNICODE_CHAR;
+                  }
+                  else
+                  {
+                    ++s;
+                    c = (((c & 0x07) << 18) | (c1 << 12) | (c2 << 6) | (c3 & 0x3F));
+                  }
+                }
+              }
+            }
+          }
+#else
+          soap_wchar c1, c2, c3, c4;
+          c1 = (unsigned char)*s;
+          if (c1)
+          {
+            s++;
+            c1 &= 0x3F;
+            if (c < 0xE0)
+            {
+              c = (wchar_t)(((soap_wchar)(c & 0x1F) << 6) | c1);
+            }
+            else
+            {
+              c2 = (unsigned char)*s;
+              if (c2)
+              {
+                s++;
+                c2 &= 0x3F;
+                if (c < 0xF0)
+                {
+                  c = (wchar_t)(((soap_wchar)(c & 0x0F) << 12) | (c1 << 6) | c2);
+                }
+                else
+                {
+                  c3 = (unsigned char)*s;
+                  if (c3)
+                  {
+                    s++;
+                    c3 &= 0x3F;
+                    if (c < 0xF8)
+                    {
+                      c = (wchar_t)(((soap_wchar)(c & 0x07) << 18) | (c1 << 12) | (c2 << 6) | c3);
+                    }
+                    else
+                    {
+                      c4 = (unsigned char)*s;
+                      if (c4)
+                      {
+                        s++;
+                        c4 &= 0x3F;
+                        if (c < 0xFC)
+                        {
+                          c = (wchar_t)(((soap_wchar)(c & 0x03) << 24) | (c1 << 18) | (c2 << 12) | (c3 << 6) | c4);
+                        }
+                        else
+                        {
+                          c = (wchar_t)(((soap_wchar)(c & 0x01) << 30) | (c1 << 24) | (c2 << 18) | (c3 << 12) | (c4 << 6) | (unsigned char)(*s & 0x3F));
+                          if (*s)
+                            s++;
+                        }
+                      }
+                    }
+                  }
+                }
+              }
+            }
+          }
+#endif
+        }
+        /* use UTF16 encoding when wchar_t is too small to hold UCS */
+        if (sizeof(wchar_t) < 4 && c > 0xFFFF)
+        {
+          wchar_t c1, c2;
+          c1 = 0xD800 - (0x10000 >> 10) + (c >> 10);
+          c2 = 0xDC00 + (c & 0x3FF);
+          if (soap_append_lab(soap, (const char*)&c1, sizeof(wchar_t)) || soap_append_lab(soap, (const char*)&c2, sizeof(wchar_t)))
+            return NULL;
+        }
+        else if (soap_append_lab(soap, (const char*)&c, sizeof(wchar_t)))
+        {
+          return NULL;
+        }
+      }
+    }
+    l = soap->labidx / sizeof(wchar_t);
+    c = L'\0';
+    if (soap_append_lab(soap, (const char*)&c, sizeof(wchar_t)))
+      return NULL;
+    if ((maxlen >= 0 && l > (size_t)maxlen) || (minlen > 0 && l < (size_t)minlen))
+    {
+      soap->error = SOAP_LENGTH;
+      return NULL;
+    }
+    t = (wchar_t*)(void*)soap->labbuf;
+#ifndef WITH_LEAN
+    if (flag >= 4 && t)
+      t = soap_wcollapse(soap, t, flag, 1);
+#endif
+#ifndef WITH_LEANER
+    if (pattern && soap->fwvalidate)
+    {
+      soap->error = soap->fwvalidate(soap, pattern, t);
+      if (soap->error)
+        return NULL;
+    }
+#endif
+    return t;
+  }
+  return NULL;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+static wchar_t*
+soap_wcollapse(struct soap *soap, wchar_t *s, int flag, int insitu)
+{
+  /* flag 4=normalizedString (replace), 5=token (collapse) */
+  wchar_t *t;
+  size_t n;
+  if (!s)
+    return NULL;
+  if (flag == 4)
+  {
+    for (t = s; *t && (!soap_coblank((soap_wchar)*t) || *t == 32); t++)
+      continue;
+    if (*t)
+    {
+      /* replace blanks and control char by space */
+      if (!insitu)
+        s = soap_wstrdup(soap, s);
+      if (s)
+        for (t = s; *t; t++)
+          if (soap_coblank((soap_wchar)*t))
+            *t = L' ';
+    }
+    return s;
+  }
+  /* collapse white space */
+  for (t = s; *t && soap_coblank((soap_wchar)*t); t++)
+    continue;
+  n = 0;
+  while (t[n])
+    n++;
+  if (insitu && s < t)
+    (void)soap_memmove(s, n + 1, t, n + 1);
+  else
+    s = t;
+  if (n > 0)
+  {
+    if (!soap_coblank((soap_wchar)s[n-1]))
+    {
+      for (t = s; (*t && !soap_coblank((soap_wchar)*t)) || (*t == 32 && (!t[1] || !soap_coblank((soap_wchar)t[1]))); t++)
+        continue;
+      if (!*t)
+        return s;
+    }
+    if (!insitu)
+      s = soap_wstrdup(soap, s);
+    if (s)
+    {
+      for (t = s; *t; t++)
+      {
+        if (soap_coblank((soap_wchar)*t))
+        {
+          wchar_t *r;
+          *t = L' ';
+          for (r = t + 1; *r && soap_coblank((soap_wchar)*r); r++)
+            continue;
+          if (r > t + 1)
+            (void)soap_memmove(t + 1, sizeof(wchar_t) * (n - (t-s)), r, sizeof(wchar_t) * (n - (r-s) + 1));
+        }
+      }
+      t--;
+      if (t >= s && *t == 32)
+        *t = L'\0';
+    }
+  }
+  return s;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+const char*
+SOAP_FMAC2
+soap_wchar2s(struct soap *soap, const wchar_t *s)
+{
+  soap_wchar c;
+  char *r, *t;
+  const wchar_t *q = s;
+  size_t n = 0;
+  if (!s)
+    return NULL;
+  while ((c = *q++))
+  {
+    if (c > 0 && c < 0x80)
+      n++;
+    else
+#ifdef WITH_REPLACE_ILLEGAL_UTF8
+      n += 4;
+#else
+      n += 6;
+#endif
+  }
+  r = t = (char*)soap_malloc(soap, n + 1);
+  if (r)
+  {
+    /* Convert wchar to UTF8 (chars above U+10FFFF are silently converted, but should not be used) */
+    while ((c = *s++))
+    {
+      if (c > 0 && c < 0x80)
+      {
+        *t++ = (char)c;
+      }
+      else
+      {
+        /* check for UTF16 encoding when wchar_t is too small to hold UCS */
+        if (sizeof(wchar_t) < 4 && (c & 0xFC00) == 0xD800)
+        {
+          soap_wchar d = *s;
+          if ((d & 0xFC00) == 0xDC00)
+          {
+            c = ((c - 0xD800) << 10) + (d - 0xDC00) + 0x10000;
+            s++;
+          }
+#ifdef WITH_REPLACE_ILLEGAL_UTF8
+          else
+          {
+            c = SOAP_UNKNOWN_UNICODE_CHAR; /* Malformed UTF-16 */
+          }
+#endif
         }
-        break;
-      case '"':
-        if (flag > 0)
+        if (c < 0x0800)
         {
-          *s++ = L'"';
+          *t++ = (char)(0xC0 | ((c >> 6) & 0x1F));
         }
         else
         {
-          *s++ = L'&';
-          t = (char*)"quot;";
-        }
-        break;
-      default:
-        if ((int)c == EOF)
-          goto end;
-        /* use UTF16 encoding when wchar_t is too small to hold UCS */
-        if (sizeof(wchar_t) < 4 && c > 0xFFFF)
-        {
-          soap_wchar c1, c2;
-          c1 = 0xD800 - (0x10000 >> 10) + (c >> 10);
-          c2 = 0xDC00 + (c & 0x3FF);
-          c = c1;
-          soap_unget(soap, c2);
+#ifdef WITH_REPLACE_ILLEGAL_UTF8
+          if (!((c >= 0x80 && c <= 0xD7FF) || (c >= 0xE000 && c <= 0xFFFD) || (c >= 0x10000 && c <= 0x10FFFF)))
+            c = SOAP_UNKNOWN_UNICODE_CHAR;
+#endif
+          if (c < 0x010000)
+          {
+            *t++ = (char)(0xE0 | ((c >> 12) & 0x0F));
+          }
+          else
+          {
+            if (c < 0x200000)
+            {
+              *t++ = (char)(0xF0 | ((c >> 18) & 0x07));
+            }
+            else
+            {
+              if (c < 0x04000000)
+              {
+                *t++ = (char)(0xF8 | ((c >> 24) & 0x03));
+              }
+              else
+              {
+                *t++ = (char)(0xFC | ((c >> 30) & 0x01));
+                *t++ = (char)(0x80 | ((c >> 24) & 0x3F));
+              }
+              *t++ = (char)(0x80 | ((c >> 18) & 0x3F));
+            }
+            *t++ = (char)(0x80 | ((c >> 12) & 0x3F));
+          }
+          *t++ = (char)(0x80 | ((c >> 6) & 0x3F));
         }
-        *s++ = (wchar_t)(c & 0x7FFFFFFF);
-      }
-      l++;
-      if (maxlen >= 0 && l > (size_t)maxlen)
-      {
-        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String too long: maxlen=%ld\n", maxlen));
-        soap->error = SOAP_LENGTH;
-        return NULL;
+        *t++ = (char)(0x80 | (c & 0x3F));
       }
     }
+    *t = '\0';
   }
-end:
-  soap_unget(soap, c);
-  *s = L'\0';
-  soap_size_block(soap, NULL, sizeof(wchar_t) * (i + 1));
-  if (minlen > 0 && l < (size_t)minlen)
+  return r;
+}
+#endif
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_outstring(struct soap *soap, const char *tag, int id, char *const*p, const char *type, int n)
+{
+  id = soap_element_id(soap, tag, id, *p, NULL, 0, type, n, NULL);
+  if (id < 0)
+    return soap->error;
+  if (!**p)
   {
-    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String too short: %lu chars, minlen=%ld\n", (unsigned long)l, minlen));
-    soap->error = SOAP_LENGTH;
+    if ((soap->mode & SOAP_C_NILSTRING))
+      return soap_element_null(soap, tag, id, type);
+    return soap_element_empty(soap, tag, id, type);
+  }
+  if (soap_element_begin_out(soap, tag, id, type)
+   || soap_string_out(soap, *p, 0)
+   || soap_element_end_out(soap, tag))
+    return soap->error;
+  return SOAP_OK;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+char **
+SOAP_FMAC2
+soap_instring(struct soap *soap, const char *tag, char **p, const char *type, int t, int flag, long minlen, long maxlen, const char *pattern)
+{
+  (void)type;
+  if (soap_element_begin_in(soap, tag, 1, NULL))
+  {
+    if (!tag || *tag != '-' || soap->error != SOAP_NO_TAG)
+      return NULL;
+    soap->error = SOAP_OK;
+  }
+  if (!p)
+  {
+    p = (char**)soap_malloc(soap, sizeof(char*));
+    if (!p)
+      return NULL;
+  }
+  if (soap->null)
+  {
+    *p = NULL;
+  }
+  else if (soap->body)
+  {
+    *p = soap_string_in(soap, flag, minlen, maxlen, pattern);
+    if (!*p || !(char*)soap_id_enter(soap, soap->id, *p, t, sizeof(char*), NULL, NULL, NULL, NULL))
+      return NULL;
+    if (!**p && tag && *tag == '-')
+    {
+      soap->error = SOAP_NO_TAG;
+      return NULL;
+    }
+  }
+  else if (tag && *tag == '-')
+  {
+    soap->error = SOAP_NO_TAG;
     return NULL;
   }
-  s = (wchar_t*)soap_save_block(soap, NULL, NULL, 0);
-#ifndef WITH_LEAN
-  if (flag >= 4 && s)
-    s = soap_wcollapse(soap, s, flag, 1);
+  else if (*soap->href != '#')
+  {
+    if (minlen > 0)
+    {
+      soap->error = SOAP_LENGTH;
+      return NULL;
+    }
+    *p = soap_strdup(soap, SOAP_STR_EOS);
+    if (!*p)
+      return NULL;
+  }
+  if (*soap->href == '#')
+    p = (char**)soap_id_lookup(soap, soap->href, (void**)p, t, sizeof(char**), 0, NULL);
+  if (soap->body && soap_element_end_in(soap, tag))
+    return NULL;
+  return p;
+}
+
+/******************************************************************************/
+
+#ifndef WITH_LEANER
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_outwstring(struct soap *soap, const char *tag, int id, wchar_t *const*p, const char *type, int n)
+{
+  id = soap_element_id(soap, tag, id, *p, NULL, 0, type, n, NULL);
+  if (id < 0)
+    return soap->error;
+  if (!**p)
+  {
+    if ((soap->mode & SOAP_C_NILSTRING))
+      return soap_element_null(soap, tag, id, type);
+    return soap_element_empty(soap, tag, id, type);
+  }
+  if (soap_element_begin_out(soap, tag, id, type)
+   || soap_wstring_out(soap, *p, 0)
+   || soap_element_end_out(soap, tag))
+    return soap->error;
+  return SOAP_OK;
+}
 #endif
+
+/******************************************************************************/
+
 #ifndef WITH_LEANER
-  if (pattern && soap->fwvalidate)
+SOAP_FMAC1
+wchar_t **
+SOAP_FMAC2
+soap_inwstring(struct soap *soap, const char *tag, wchar_t **p, const char *type, int t, int flag, long minlen, long maxlen, const char *pattern)
+{
+  (void)type;
+  if (soap_element_begin_in(soap, tag, 1, NULL))
   {
-    soap->error = soap->fwvalidate(soap, pattern, s);
-    if (soap->error)
+    if (!tag || *tag != '-' || soap->error != SOAP_NO_TAG)
       return NULL;
+    soap->error = SOAP_OK;
   }
+  if (!p)
+  {
+    p = (wchar_t**)soap_malloc(soap, sizeof(wchar_t*));
+    if (!p)
+      return NULL;
+  }
+  if (soap->null)
+  {
+    *p = NULL;
+  }
+  else if (soap->body)
+  {
+    *p = soap_wstring_in(soap, flag, minlen, maxlen, pattern);
+    if (!*p || !(wchar_t*)soap_id_enter(soap, soap->id, *p, t, sizeof(wchar_t*), NULL, NULL, NULL, NULL))
+      return NULL;
+    if (!**p && tag && *tag == '-')
+    {
+      soap->error = SOAP_NO_TAG;
+      return NULL;
+    }
+  }
+  else if (tag && *tag == '-')
+  {
+    soap->error = SOAP_NO_TAG;
+    return NULL;
+  }
+  else if (*soap->href != '#')
+  {
+    if (minlen > 0)
+    {
+      soap->error = SOAP_LENGTH;
+      return NULL;
+    }
+    *p = soap_wstrdup(soap, L"");
+  }
+  if (*soap->href == '#')
+    p = (wchar_t**)soap_id_lookup(soap, soap->href, (void**)p, t, sizeof(wchar_t**), 0, NULL);
+  if (soap->body && soap_element_end_in(soap, tag))
+    return NULL;
+  return p;
+}
 #endif
-#ifdef WITH_DOM
-  if ((soap->mode & SOAP_XML_DOM) && soap->dom)
-    soap->dom->text = soap_wchar2s(soap, s);
-#endif
-  return s;
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+#ifdef UNDER_CE
+/* WinCE mktime (based on the mingw-runtime, public domain) */
+#define __FILETIME_to_ll(f) ((long long)(f).dwHighDateTime << 32 | (long long)(f).dwLowDateTime)
+static time_t
+mktime(struct tm *pt)
+{
+  SYSTEMTIME s, s1, s2;
+  FILETIME f, f1, f2;
+  long long diff;
+  GetSystemTime(&s1);
+  GetLocalTime(&s2);
+  SystemTimeToFileTime(&s1, &f1);
+  SystemTimeToFileTime(&s2, &f2);
+  diff = (__FILETIME_to_ll(f2) - __FILETIME_to_ll(f1)) / 10000000LL;
+  s.wYear = pt->tm_year + 1900;
+  s.wMonth = pt->tm_mon  + 1;
+  s.wDayOfWeek = pt->tm_wday;
+  s.wDay = pt->tm_mday;
+  s.wHour = pt->tm_hour;
+  s.wMinute = pt->tm_min;
+  s.wSecond = pt->tm_sec;
+  s.wMilliseconds = 0;
+  SystemTimeToFileTime(&s, &f);
+  return (time_t)((__FILETIME_to_ll(f) - 116444736000000000LL) / 10000000LL) - (time_t)diff;
 }
 #endif
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-const char*
-SOAP_FMAC2
-soap_int2s(struct soap *soap, int n)
+#ifndef WITH_LEAN
+#ifdef UNDER_CE
+/* WinCE gmtime_r (based on the mingw-runtime, public domain) */
+#define HAVE_GMTIME_R
+static struct tm*
+gmtime_r(const time_t *t, struct tm *pt)
 {
-  return soap_long2s(soap, (long)n);
+  FILETIME f, f1, f2;
+  SYSTEMTIME s, s1 = {0};
+  long long time = (long long)(*t) * 10000000LL + 116444736000000000LL;
+  f.dwHighDateTime = (DWORD)((time >> 32) & 0x00000000FFFFFFFF);
+  f.dwLowDateTime = (DWORD)(time & 0x00000000FFFFFFFF);
+  FileTimeToSystemTime(&f, &s);
+  pt->tm_year = s.wYear - 1900;
+  pt->tm_mon = s.wMonth - 1;
+  pt->tm_wday = s.wDayOfWeek;
+  pt->tm_mday = s.wDay;
+  s1.wYear = s.wYear;
+  s1.wMonth = 1;
+  s1.wDayOfWeek = 1;
+  s1.wDay = 1;
+  SystemTimeToFileTime(&s1, &f1);
+  SystemTimeToFileTime(&s, &f2);
+  pt->tm_yday = (((__FILETIME_to_ll(f2) - __FILETIME_to_ll(f1)) / 10000000LL) / (60 * 60 * 24));
+  pt->tm_hour = s.wHour;
+  pt->tm_min = s.wMinute;
+  pt->tm_sec = s.wSecond;
+  pt->tm_isdst = 0;
+  return pt;
 }
+#endif
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_outint(struct soap *soap, const char *tag, int id, const int *p, const char *type, int n)
+#ifndef WITH_LEAN
+#ifdef UNDER_CE
+/* WinCE very simple strftime for format "%Y-%m-%dT%H:%M:%SZ", note: %F and %T not supported by MS */
+static size_t
+strftime(char *buf, size_t len, const char *format, const struct tm *pT)
 {
-  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
-   || soap_string_out(soap, soap_long2s(soap, (long)*p), 0))
-    return soap->error;
-  return soap_element_end_out(soap, tag);
+  (void)len; (void)format;
+#ifndef WITH_NOZONE
+  (SOAP_SNPRINTF(buf, len, 20), "%04d-%02d-%02dT%02d:%02d:%02dZ", pT->tm_year + 1900, pT->tm_mon + 1, pT->tm_mday, pT->tm_hour, pT->tm_min, pT->tm_sec);
+#else
+  (SOAP_SNPRINTF(buf, len, 20), "%04d-%02d-%02dT%02d:%02d:%02d", pT->tm_year + 1900, pT->tm_mon + 1, pT->tm_mday, pT->tm_hour, pT->tm_min, pT->tm_sec);
+#endif
+  return len;
 }
+#endif
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_s2int(struct soap *soap, const char *s, int *p)
+#if !defined(WITH_LEAN) || defined(WITH_COOKIES)
+/* days in the year before the first day of each month, non-leap year */
+static const short soap_mdays[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+
+/* floor division, rounds towards negative infinity for d > 0 */
+static LONG64
+soap_floordiv(LONG64 n, LONG64 d)
 {
-  if (s)
-  {
-    long n;
-    char *r;
-    if (!*s)
-      return soap->error = SOAP_EMPTY;
-#ifndef WITH_NOIO
-#ifndef WITH_LEAN
-    soap_reset_errno;
-#endif
-#endif
-    n = soap_strtol(s, &r, 10);
-    if (s == r || *r
-#ifndef WITH_LEAN
-        || n != (int)n
-#endif
-#ifndef WITH_NOIO
-#ifndef WITH_LEAN
-        || soap_errno == SOAP_ERANGE
-#endif
-#endif
-    )
-      soap->error = SOAP_TYPE;
-    *p = (int)n;
-  }
-  return soap->error;
+  return n >= 0 ? n / d : -((d - 1 - n) / d);
 }
 
-/******************************************************************************/
-
-SOAP_FMAC1
-int *
-SOAP_FMAC2
-soap_inint(struct soap *soap, const char *tag, int *p, const char *type, int t)
+/* number of days since 1970-01-01 of proleptic Gregorian year y, month m (0..11 or out of range), and day d (1..31 or out of range) */
+static LONG64
+soap_days_from_civil(LONG64 y, LONG64 m, LONG64 d)
 {
-  if (soap_element_begin_in(soap, tag, 0, NULL))
-    return NULL;
-#ifndef WITH_LEAN
-  if (*soap->type
-   && soap_match_tag(soap, soap->type, type)
-   && soap_match_tag(soap, soap->type, ":int")
-   && soap_match_tag(soap, soap->type, ":short")
-   && soap_match_tag(soap, soap->type, ":byte"))
-  {
-    soap->error = SOAP_TYPE;
-    soap_revert(soap);
-    return NULL;
-  }
-#else
-  (void)type;
-#endif
-  p = (int*)soap_id_enter(soap, soap->id, p, t, sizeof(int), NULL, NULL, NULL, NULL);
-  if (!p)
-    return NULL;
-  if (*soap->href != '#')
-  {
-    int err = soap_s2int(soap, soap_value(soap), p);
-    if ((soap->body && soap_element_end_in(soap, tag)) || err)
-      return NULL;
-  }
-  else
-  {
-    p = (int*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(int), 0, NULL, NULL);
-    if (soap->body && soap_element_end_in(soap, tag))
-      return NULL;
-  }
-  return p;
+  LONG64 k = soap_floordiv(m, 12);
+  y += k;
+  m -= 12 * k;
+  k = m < 2 ? y - 1 : y; /* leap days are counted up to and including year k */
+  return 365 * (y - 1970) + soap_floordiv(k, 4) - soap_floordiv(k, 100) + soap_floordiv(k, 400) - 477 + soap_mdays[m] + d - 1;
 }
+#endif
 
 /******************************************************************************/
 
+#if !defined(WITH_LEAN) || defined(WITH_COOKIES)
 SOAP_FMAC1
-const char*
+time_t
 SOAP_FMAC2
-soap_long2s(struct soap *soap, long n)
+soap_timegm(struct tm *T)
 {
-  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 20), "%ld", n);
-  return soap->tmpbuf;
+  /* table-driven, does not call mktime() or timegm(), does not normalize the fields of T */
+  return (time_t)(86400 * soap_days_from_civil((LONG64)T->tm_year + 1900, T->tm_mon, T->tm_mday) + 3600 * (LONG64)T->tm_hour + 60 * (LONG64)T->tm_min + T->tm_sec);
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_outlong(struct soap *soap, const char *tag, int id, const long *p, const char *type, int n)
+#ifndef WITH_LEAN
+/* two-digit decimal strings "00" to "99" */
+static const char soap_dec2[201] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+/* write two-digit decimal n (0..99) to s */
+static void
+soap_put2(char *s, int n)
 {
-  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
-   || soap_string_out(soap, soap_long2s(soap, *p), 0))
-    return soap->error;
-  return soap_element_end_out(soap, tag);
+  s[0] = soap_dec2[2 * n];
+  s[1] = soap_dec2[2 * n + 1];
 }
 
-/******************************************************************************/
+/* convert UTC time t in seconds since the epoch to normalized fields of T */
+static void
+soap_utc2tm(LONG64 t, struct tm *T)
+{
+  LONG64 z = soap_floordiv(t, 86400);
+  LONG64 s = t - 86400 * z;
+  LONG64 era, doe, yoe, doy, mp, y;
+  int m;
+  T->tm_hour = (int)(s / 3600);
+  T->tm_min = (int)(s / 60 % 60);
+  T->tm_sec = (int)(s % 60);
+  T->tm_wday = (int)(z + 4 - 7 * soap_floordiv(z + 4, 7)); /* 1970-01-01 is a Thursday */
+  /* days to civil: 400-year eras starting at March 1 of year 0 */
+  z += 719468;
+  era = soap_floordiv(z, 146097);
+  doe = z - 146097 * era;
+  yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  mp = (5 * doy + 2) / 153;
+  y = yoe + 400 * era;
+  m = (int)(mp < 10 ? mp + 2 : mp - 10);
+  if (m < 2)
+    y++;
+  T->tm_year = (int)(y - 1900);
+  T->tm_mon = m;
+  T->tm_mday = (int)(doy - (153 * mp + 2) / 5 + 1);
+  T->tm_yday = soap_mdays[m] + T->tm_mday - 1 + (m >= 2 && (y % 4 == 0 && (y % 100 != 0 || y % 400 == 0)));
+  T->tm_isdst = 0;
+}
+
+/* write fields of T to s as YYYY-MM-DDThh:mm:ss without zone, s must have room for 32 chars, returns length */
+static size_t
+soap_tm2s(char *s, const struct tm *T)
+{
+  char *r = s;
+  LONG64 y = (LONG64)T->tm_year + 1900;
+  if (y < 0)
+  {
+    *r++ = '-';
+    y = -y;
+  }
+  if (y >= 10000)
+  {
+    char b[20];
+    int n = 0;
+    LONG64 h = y / 10000;
+    while (h)
+    {
+      b[n++] = (char)('0' + h % 10);
+      h /= 10;
+    }
+    while (n)
+      *r++ = b[--n];
+    y %= 10000;
+  }
+  soap_put2(r, (int)(y / 100));
+  soap_put2(r + 2, (int)(y % 100));
+  r[4] = '-';
+  soap_put2(r + 5, T->tm_mon + 1);
+  r[7] = '-';
+  soap_put2(r + 8, T->tm_mday);
+  r[10] = 'T';
+  soap_put2(r + 11, T->tm_hour);
+  r[13] = ':';
+  soap_put2(r + 14, T->tm_min);
+  r[16] = ':';
+  soap_put2(r + 17, T->tm_sec);
+  r[19] = '\0';
+  return r + 19 - s;
+}
+
+/* parse exactly n decimal digits, returns -1 when not all are digits */
+static int
+soap_s2dec(const char *s, int n)
+{
+  int v = 0;
+  while (n-- > 0)
+  {
+    unsigned int c = (unsigned int)(unsigned char)*s++ - '0';
+    if (c > 9)
+      return -1;
+    v = 10 * v + (int)c;
+  }
+  return v;
+}
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_s2long(struct soap *soap, const char *s, long *p)
+/* parse xsd:dateTime s into fields of T (not normalized) and fraction f with precision digits, sets zone = 1 and UTC offset off in seconds when a zone is present */
+static int
+soap_s2dt(struct soap *soap, const char *s, struct tm *T, unsigned long *f, int digits, int *zone, long *off)
 {
-  if (s)
+  char *t;
+  memset((void*)T, 0, sizeof(struct tm));
+  *zone = 0;
+  *off = 0;
+  if (f)
+    *f = 0;
+  if (!*s)
+    return soap->error = SOAP_EMPTY;
+  /* fast path for the canonical YYYY-MM-DDThh:mm:ss form */
+  if ((T->tm_year = soap_s2dec(s, 4)) >= 0 && s[4] == '-'
+   && (T->tm_mon = soap_s2dec(s + 5, 2)) >= 0 && s[7] == '-'
+   && (T->tm_mday = soap_s2dec(s + 8, 2)) >= 0 && s[10] == 'T'
+   && (T->tm_hour = soap_s2dec(s + 11, 2)) >= 0 && s[13] == ':'
+   && (T->tm_min = soap_s2dec(s + 14, 2)) >= 0 && s[16] == ':'
+   && (T->tm_sec = soap_s2dec(s + 17, 2)) >= 0)
+  {
+    t = (char*)s + 19;
+  }
+  else
   {
-    char *r;
-    if (!*s)
-      return soap->error = SOAP_EMPTY;
-#ifndef WITH_NOIO
-#ifndef WITH_LEAN
-    soap_reset_errno;
-#endif
-#endif
-    *p = soap_strtol(s, &r, 10);
-    if (s == r || *r
-#ifndef WITH_NOIO
-#ifndef WITH_LEAN
-        || soap_errno == SOAP_ERANGE
-#endif
+    unsigned long d;
+    memset((void*)T, 0, sizeof(struct tm));
+    d = soap_strtoul(s, &t, 10);
+    if (*t == '-')
+    {
+      /* YYYY-MM-DD */
+      T->tm_year = (int)d;
+      T->tm_mon = (int)soap_strtoul(t + 1, &t, 10);
+      T->tm_mday = (int)soap_strtoul(t + 1, &t, 10);
+    }
+    else if (!(soap->mode & SOAP_XML_STRICT))
+    {
+      /* YYYYMMDD */
+      T->tm_year = (int)(d / 10000);
+      T->tm_mon = (int)(d / 100 % 100);
+      T->tm_mday = (int)(d % 100);
+    }
+    else
+    {
+      return soap->error = SOAP_TYPE;
+    }
+    if (*t == 'T' || ((*t == 't' || *t == ' ') && !(soap->mode & SOAP_XML_STRICT)))
+    {
+      d = soap_strtoul(t + 1, &t, 10);
+      if (*t == ':')
+      {
+        /* Thh:mm:ss */
+        T->tm_hour = (int)d;
+        T->tm_min = (int)soap_strtoul(t + 1, &t, 10);
+        T->tm_sec = (int)soap_strtoul(t + 1, &t, 10);
+      }
+      else if (!(soap->mode & SOAP_XML_STRICT))
+      {
+        /* Thhmmss */
+        T->tm_hour = (int)(d / 10000);
+        T->tm_min = (int)(d / 100 % 100);
+        T->tm_sec = (int)(d % 100);
+      }
+      else
+      {
+        return soap->error = SOAP_TYPE;
+      }
+    }
+  }
+  if (T->tm_year == 1)
+    T->tm_year = 70;
+  else
+    T->tm_year -= 1900;
+  T->tm_mon--;
+  if (*t == '.')
+  {
+    unsigned long v = 0;
+    int n = 0;
+    for (t++; *t >= '0' && *t <= '9'; t++)
+    {
+      if (n < digits)
+      {
+        v = 10 * v + (*t - '0');
+        n++;
+      }
+    }
+    if (f)
+    {
+      while (n++ < digits)
+        v *= 10;
+      *f = v;
+    }
+  }
+  if (*t == ' ' && !(soap->mode & SOAP_XML_STRICT))
+    t++;
+  if (*t)
+  {
+#ifndef WITH_NOZONE
+    if (*t == '+' || *t == '-')
+    {
+      int h, m, neg = (*t == '-');
+      m = (int)soap_strtol(t, &t, 10);
+      if (*t == ':')
+      {
+        /* +hh:mm */
+        h = m;
+        m = (int)soap_strtol(t + 1, &t, 10);
+        if (neg)
+          m = -m;
+      }
+      else if (!(soap->mode & SOAP_XML_STRICT))
+      {
+        /* +hhmm */
+        h = m / 100;
+        m = m % 100;
+      }
+      else
+      {
+        /* +hh */
+        h = m;
+        m = 0;
+      }
+      if (*t)
+        return soap->error = SOAP_TYPE;
+      *off = 3600L * h + 60L * m;
+    }
+    else if (*t != 'Z')
+    {
+      return soap->error = SOAP_TYPE;
+    }
 #endif
-    )
-      soap->error = SOAP_TYPE;
+    *zone = 1;
   }
-  return soap->error;
+  return SOAP_OK;
 }
 
-/******************************************************************************/
-
-SOAP_FMAC1
-long *
-SOAP_FMAC2
-soap_inlong(struct soap *soap, const char *tag, long *p, const char *type, int t)
+/* convert local time fields of T to time_t, caches the UTC offset of the local hour to avoid mktime() */
+static time_t
+soap_mktime(struct soap *soap, struct tm *T)
 {
-  if (soap_element_begin_in(soap, tag, 0, NULL))
-    return NULL;
-#ifndef WITH_LEAN
-  if (*soap->type
-   && soap_match_tag(soap, soap->type, type)
-   && soap_match_tag(soap, soap->type, ":int")
-   && soap_match_tag(soap, soap->type, ":short")
-   && soap_match_tag(soap, soap->type, ":byte"))
-  {
-    soap->error = SOAP_TYPE;
-    soap_revert(soap);
-    return NULL;
-  }
-#else
-  (void)type;
-#endif
-  p = (long*)soap_id_enter(soap, soap->id, p, t, sizeof(long), NULL, NULL, NULL, NULL);
-  if (!p)
-    return NULL;
-  if (*soap->href != '#')
+  LONG64 t = (LONG64)soap_timegm(T); /* local time as if it were UTC */
+  LONG64 h = soap_floordiv(t, 3600);
+  time_t n;
+  if (soap->tz_offset != SOAP_TZ_NONE && soap->tz_hour == h)
+    return (time_t)(t - soap->tz_offset);
+  T->tm_isdst = -1;
+  n = mktime(T);
+  if (n != (time_t)-1)
   {
-    int err = soap_s2long(soap, soap_value(soap), p);
-    if ((soap->body && soap_element_end_in(soap, tag)) || err)
-      return NULL;
-  }
-  else
-  {
-    p = (long*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(long), 0, NULL, NULL);
-    if (soap->body && soap_element_end_in(soap, tag))
-      return NULL;
+    soap->tz_hour = h;
+    soap->tz_offset = (long)(t - (LONG64)n);
   }
-  return p;
+  return n;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEAN
 SOAP_FMAC1
 const char*
 SOAP_FMAC2
-soap_LONG642s(struct soap *soap, LONG64 n)
-{
-  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 20), SOAP_LONG_FORMAT, n);
-  return soap->tmpbuf;
-}
-
-/******************************************************************************/
-
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_outLONG64(struct soap *soap, const char *tag, int id, const LONG64 *p, const char *type, int n)
+soap_dateTime2s(struct soap *soap, time_t n)
 {
-  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
-   || soap_string_out(soap, soap_LONG642s(soap, *p), 0))
-    return soap->error;
-  return soap_element_end_out(soap, tag);
+  return soap_dateTime2s_frac(soap, n, 0, 0);
 }
-
-/******************************************************************************/
-
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_s2LONG64(struct soap *soap, const char *s, LONG64 *p)
-{
-  if (s)
-  {
-    char *r;
-    if (!*s)
-      return soap->error = SOAP_EMPTY;
-#ifndef WITH_NOIO
-#ifndef WITH_LEAN
-    soap_reset_errno;
-#endif
-#endif
-    *p = soap_strtoll(s, &r, 10);
-    if (s == r || *r
-#ifndef WITH_NOIO
-#ifndef WITH_LEAN
-        || soap_errno == SOAP_ERANGE
-#endif
 #endif
-      )
-      soap->error = SOAP_TYPE;
-  }
-  return soap->error;
-}
 
 /******************************************************************************/
 
+#ifndef WITH_LEAN
 SOAP_FMAC1
-LONG64 *
+const char*
 SOAP_FMAC2
-soap_inLONG64(struct soap *soap, const char *tag, LONG64 *p, const char *type, int t)
+soap_dateTime2s_frac(struct soap *soap, time_t n, unsigned long f, int digits)
 {
-  if (soap_element_begin_in(soap, tag, 0, NULL))
-    return NULL;
-#ifndef WITH_LEAN
-  if (*soap->type
-   && soap_match_tag(soap, soap->type, type)
-   && soap_match_tag(soap, soap->type, ":integer")
-   && soap_match_tag(soap, soap->type, ":positiveInteger")
-   && soap_match_tag(soap, soap->type, ":negativeInteger")
-   && soap_match_tag(soap, soap->type, ":nonPositiveInteger")
-   && soap_match_tag(soap, soap->type, ":nonNegativeInteger")
-   && soap_match_tag(soap, soap->type, ":long")
-   && soap_match_tag(soap, soap->type, ":int")
-   && soap_match_tag(soap, soap->type, ":short")
-   && soap_match_tag(soap, soap->type, ":byte"))
+  size_t l;
+#ifndef WITH_NOZONE
+  /* UTC, the last second converted is cached */
+  if (!*soap->dt_buf || soap->dt_time != n)
   {
-    soap->error = SOAP_TYPE;
-    soap_revert(soap);
-    return NULL;
+    struct tm T;
+    soap_utc2tm((LONG64)n, &T);
+    (void)soap_tm2s(soap->dt_buf, &T);
+    soap->dt_time = n;
   }
+  l = strlen(soap->dt_buf);
+  (void)soap_memcpy((void*)soap->tmpbuf, sizeof(soap->tmpbuf), (const void*)soap->dt_buf, l);
 #else
-  (void)type;
+  /* local time without zone */
+  struct tm T, *pT = &T;
+#if defined(HAVE_LOCALTIME_R)
+  if (localtime_r(&n, pT) == SOAP_FUNC_R_ERR)
+    pT = NULL;
+#else
+  pT = localtime(&n);
 #endif
-  p = (LONG64*)soap_id_enter(soap, soap->id, p, t, sizeof(LONG64), NULL, NULL, NULL, NULL);
-  if (!p)
-    return NULL;
-  if (*soap->href != '#')
+  if (!pT)
   {
-    int err = soap_s2LONG64(soap, soap_value(soap), p);
-    if ((soap->body && soap_element_end_in(soap, tag)) || err)
-      return NULL;
+    soap_strcpy(soap->tmpbuf, sizeof(soap->tmpbuf), "1969-12-31T23:59:59");
+    return soap->tmpbuf;
   }
-  else
+  l = soap_tm2s(soap->tmpbuf, pT);
+#endif
+  if (digits > 0)
   {
-    p = (LONG64*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(LONG64), 0, NULL, NULL);
-    if (soap->body && soap_element_end_in(soap, tag))
-      return NULL;
+    int i;
+    if (digits > 9)
+      digits = 9;
+    soap->tmpbuf[l++] = '.';
+    for (i = digits; i > 0; f /= 10)
+      soap->tmpbuf[l + --i] = (char)('0' + f % 10);
+    l += digits;
   }
-  return p;
-}
-
-/******************************************************************************/
-
-SOAP_FMAC1
-const char*
-SOAP_FMAC2
-soap_byte2s(struct soap *soap, char n)
-{
-  return soap_long2s(soap, (long)n);
+#ifndef WITH_NOZONE
+  soap->tmpbuf[l++] = 'Z';
+#endif
+  soap->tmpbuf[l] = '\0';
+  return soap->tmpbuf;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_outbyte(struct soap *soap, const char *tag, int id, const char *p, const char *type, int n)
+soap_outdateTime(struct soap *soap, const char *tag, int id, const time_t *p, const char *type, int n)
 {
   if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
-   || soap_string_out(soap, soap_long2s(soap, (long)*p), 0))
+   || soap_string_out(soap, soap_dateTime2s(soap, *p), 0))
     return soap->error;
   return soap_element_end_out(soap, tag);
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_s2byte(struct soap *soap, const char *s, char *p)
+soap_s2dateTime(struct soap *soap, const char *s, time_t *p)
 {
-  if (s)
-  {
-    long n;
-    char *r;
-    if (!*s)
-      return soap->error = SOAP_EMPTY;
-    n = soap_strtol(s, &r, 10);
-    if (s == r || *r || n < -128 || n > 127)
-      soap->error = SOAP_TYPE;
-    *p = (char)n;
-  }
-  return soap->error;
+  return soap_s2dateTime_frac(soap, s, p, NULL, 0);
 }
-
-/******************************************************************************/
-
-SOAP_FMAC1
-char *
-SOAP_FMAC2
-soap_inbyte(struct soap *soap, const char *tag, char *p, const char *type, int t)
-{
-  if (soap_element_begin_in(soap, tag, 0, NULL))
-    return NULL;
-#ifndef WITH_LEAN
-  if (*soap->type
-   && soap_match_tag(soap, soap->type, type)
-   && soap_match_tag(soap, soap->type, ":byte"))
-  {
-    soap->error = SOAP_TYPE;
-    soap_revert(soap);
-    return NULL;
-  }
-#else
-  (void)type;
 #endif
-  p = (char*)soap_id_enter(soap, soap->id, p, t, sizeof(char), NULL, NULL, NULL, NULL);
-  if (!p)
-    return NULL;
-  if (*soap->href != '#')
-  {
-    int err = soap_s2byte(soap, soap_value(soap), p);
-    if ((soap->body && soap_element_end_in(soap, tag)) || err)
-      return NULL;
-  }
-  else
-  {
-    p = (char*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(char), 0, NULL, NULL);
-    if (soap->body && soap_element_end_in(soap, tag))
-      return NULL;
-  }
-  return p;
-}
-
-/******************************************************************************/
-
-SOAP_FMAC1
-const char*
-SOAP_FMAC2
-soap_short2s(struct soap *soap, short n)
-{
-  return soap_long2s(soap, (long)n);
-}
 
 /******************************************************************************/
 
+#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_outshort(struct soap *soap, const char *tag, int id, const short *p, const char *type, int n)
+soap_s2dateTime_frac(struct soap *soap, const char *s, time_t *p, unsigned long *f, int digits)
 {
-  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
-   || soap_string_out(soap, soap_long2s(soap, (long)*p), 0))
-    return soap->error;
-  return soap_element_end_out(soap, tag);
+  *p = 0;
+  if (f)
+    *f = 0;
+  if (s)
+  {
+    struct tm T;
+    int zone;
+    long off;
+    if (soap_s2dt(soap, s, &T, f, digits, &zone, &off))
+      return soap->error;
+    if (zone)
+      *p = (time_t)((LONG64)soap_timegm(&T) - off);
+    else /* no UTC or timezone, so assume we got a localtime */
+      *p = soap_mktime(soap, &T);
+  }
+  return soap->error;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_s2short(struct soap *soap, const char *s, short *p)
+soap_s2tm(struct soap *soap, const char *s, struct tm *T, unsigned long *f, int digits)
 {
+  memset((void*)T, 0, sizeof(struct tm));
+  if (f)
+    *f = 0;
   if (s)
   {
-    long n;
-    char *r;
-    if (!*s)
-      return soap->error = SOAP_EMPTY;
-    n = soap_strtol(s, &r, 10);
-    if (s == r || *r || n < -32768 || n > 32767)
-      soap->error = SOAP_TYPE;
-    *p = (short)n;
+    int zone;
+    long off;
+    if (soap_s2dt(soap, s, T, f, digits, &zone, &off))
+      return soap->error;
+    if (zone)
+      soap_utc2tm((LONG64)soap_timegm(T) - off, T);
+    else /* no UTC or timezone, so assume we got a localtime */
+      T->tm_isdst = -1;
   }
   return soap->error;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEAN
 SOAP_FMAC1
-short *
+time_t *
 SOAP_FMAC2
-soap_inshort(struct soap *soap, const char *tag, short *p, const char *type, int t)
+soap_indateTime(struct soap *soap, const char *tag, time_t *p, const char *type, int t)
 {
   if (soap_element_begin_in(soap, tag, 0, NULL))
     return NULL;
-#ifndef WITH_LEAN
   if (*soap->type
    && soap_match_tag(soap, soap->type, type)
-   && soap_match_tag(soap, soap->type, ":short")
-   && soap_match_tag(soap, soap->type, ":byte"))
+   && soap_match_tag(soap, soap->type, ":dateTime"))
   {
     soap->error = SOAP_TYPE;
     soap_revert(soap);
     return NULL;
   }
-#else
-  (void)type;
-#endif
-  p = (short*)soap_id_enter(soap, soap->id, p, t, sizeof(short), NULL, NULL, NULL, NULL);
+  p = (time_t*)soap_id_enter(soap, soap->id, p, t, sizeof(time_t), NULL, NULL, NULL, NULL);
   if (!p)
     return NULL;
   if (*soap->href != '#')
   {
-    int err = soap_s2short(soap, soap_value(soap), p);
+    int err = soap_s2dateTime(soap, soap_value(soap), p);
     if ((soap->body && soap_element_end_in(soap, tag)) || err)
       return NULL;
   }
   else
   {
-    p = (short*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(short), 0, NULL, NULL);
+    p = (time_t*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(time_t), 0, NULL, NULL);
     if (soap->body && soap_element_end_in(soap, tag))
       return NULL;
   }
   return p;
 }
+#endif
 
 /******************************************************************************/
 
 SOAP_FMAC1
-const char*
+int
 SOAP_FMAC2
-soap_float2s(struct soap *soap, float n)
+soap_outliteral(struct soap *soap, const char *tag, char *const*p, const char *type)
 {
-#if defined(WITH_C_LOCALE)
-# if !defined(WIN32)
-  SOAP_LOCALE_T locale;
-# endif
-#else
-  char *s;
-#endif
-  if (soap_isnan((double)n))
-    return "NaN";
-  if (soap_ispinff(n))
-    return "INF";
-  if (soap_isninff(n))
-    return "-INF";
-#if defined(WITH_C_LOCALE)
-# ifdef WIN32
-  _sprintf_s_l(soap->tmpbuf, _countof(soap->tmpbuf), soap->float_format, SOAP_LOCALE(soap), n);
-# else
-  locale = uselocale(SOAP_LOCALE(soap));
-  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 80), soap->float_format, n);
-  uselocale(locale);
-# endif
-#else
-  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 80), soap->float_format, n);
-  s = strchr(soap->tmpbuf, ',');        /* convert decimal comma to DP */
-  if (s)
-    *s = '.';
-#endif
-  return soap->tmpbuf;
+  if (tag && *tag != '-')
+    if (soap_element_begin_out(soap, tag, 0, type))
+      return soap->error;
+  if (p && *p)
+    if (soap_send_xml(soap, *p)) /* send as-is */
+      return soap->error;
+  if (tag && *tag != '-')
+    return soap_element_end_out(soap, tag);
+  return SOAP_OK;
 }
 
 /******************************************************************************/
 
 SOAP_FMAC1
-int
+char **
 SOAP_FMAC2
-soap_outfloat(struct soap *soap, const char *tag, int id, const float *p, const char *type, int n)
+soap_inliteral(struct soap *soap, const char *tag, char **p)
 {
-  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
-   || soap_string_out(soap, soap_float2s(soap, *p), 0))
-    return soap->error;
-  return soap_element_end_out(soap, tag);
+  if (soap_element_begin_in(soap, tag, 1, NULL))
+  {
+    if (soap->error != SOAP_NO_TAG)
+      return NULL;
+#ifndef WITH_LEAN
+    if ((soap->bxml & SOAP_BXML_IN) ? soap_bxml_peek(soap) == SOAP_BXML_END : soap_peek(soap) == SOAP_TT)
+#else
+    if (soap_peek(soap) == SOAP_TT)
+#endif
+      return NULL;
+    soap->error = SOAP_OK;
+  }
+  if (!p)
+  {
+    p = (char**)soap_malloc(soap, sizeof(char*));
+    if (!p)
+      return NULL;
+  }
+  if (soap->body || (tag && *tag == '-'))
+  {
+    if (tag && *tag != '-')
+      *p = soap_string_in(soap, 0, -1, -1, NULL);
+    else
+      *p = soap_string_in(soap, -1, -1, -1, NULL);
+    if (!*p)
+      return NULL;
+    if (!**p && tag && *tag == '-')
+    {
+      soap->error = SOAP_NO_TAG;
+      return NULL;
+    }
+  }
+  else if (soap->null)
+  {
+    *p = NULL;
+  }
+  else
+  {
+    *p = soap_strdup(soap, SOAP_STR_EOS);
+  }
+  if (soap->body && soap_element_end_in(soap, tag))
+    return NULL;
+  return p;
 }
 
 /******************************************************************************/
 
+#ifndef WITH_LEANER
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_s2float(struct soap *soap, const char *s, float *p)
+soap_outwliteral(struct soap *soap, const char *tag, wchar_t *const*p, const char *type)
 {
-  if (s)
+  if (tag && *tag != '-')
+    if (soap_element_begin_out(soap, tag, 0, type))
+      return soap->error;
+#ifndef WITH_LEAN
+  if (p && (soap->bxml & SOAP_BXML_OUT))
   {
-    if (!*s)
-      return soap->error = SOAP_EMPTY;
-    if (!soap_tag_cmp(s, "INF"))
-    {
-      *p = FLT_PINFTY;
-    }
-    else if (!soap_tag_cmp(s, "+INF"))
-    {
-      *p = FLT_PINFTY;
-    }
-    else if (!soap_tag_cmp(s, "-INF"))
-    {
-      *p = FLT_NINFTY;
-    }
-    else if (!soap_tag_cmp(s, "NaN"))
-    {
-      *p = FLT_NAN;
-    }
-    else
-    {
-/* On some systems strtof requires -std=c99 or does not even link: so we try strtod first */
-#if defined(WITH_C_LOCALE)
-# if defined(HAVE_STRTOD_L)
-      char *r;
-#  ifdef WIN32
-      *p = (float)_strtod_l(s, &r, SOAP_LOCALE(soap));
-#  else
-      *p = (float)strtod_l(s, &r, SOAP_LOCALE(soap));
-#  endif
-      if (*r)
-        soap->error = SOAP_TYPE;
-# elif defined(HAVE_STRTOF_L)
-      char *r;
-      *p = strtof_l((char*)s, &r, SOAP_LOCALE(soap));
-      if (*r)
-        soap->error = SOAP_TYPE;
-# elif defined(HAVE_SSCANF_L)
-      double n;
-      if (sscanf_l(s, SOAP_LOCALE(soap), "%lf", &n) != 1)
-        soap->error = SOAP_TYPE;
-      *p = (float)n;
-# elif defined(HAVE_STRTOD)
-      char *r;
-      SOAP_LOCALE_T locale = uselocale(SOAP_LOCALE(soap));
-      *p = (float)strtod((char*)s, &r);
-      uselocale(locale);
-      if (*r)
-        soap->error = SOAP_TYPE;
-# elif defined(HAVE_STRTOF)
-      char *r;
-      SOAP_LOCALE_T locale = uselocale(SOAP_LOCALE(soap));
-      *p = strtof((char*)s, &r);
-      uselocale(locale);
-      if (*r)
-        soap->error = SOAP_TYPE;
-# elif defined(HAVE_SSCANF)
-      double n;
-      SOAP_LOCALE_T locale = uselocale(SOAP_LOCALE(soap));
-      if (sscanf(s, "%lf", &n) != 1)
-        soap->error = SOAP_TYPE;
-      uselocale(locale);
-      *p = (float)n;
-# else
-      soap->error = SOAP_TYPE;
-# endif
-#elif defined(HAVE_STRTOD)
-      char *r;
-      *p = (float)strtod(s, &r);
-      if (*r)
-        soap->error = SOAP_TYPE;
-#elif defined(HAVE_STRTOF)
-      char *r;
-      *p = strtof((char*)s, &r);
-      if (*r)
-        soap->error = SOAP_TYPE;
-#elif defined(HAVE_SSCANF)
-      double n;
-      if (sscanf(s, "%lf", &n) != 1)
-        soap->error = SOAP_TYPE;
-      *p = (float)n;
-#else
-      soap->error = SOAP_TYPE;
+    if (soap_bxml_xml_out(soap, soap_wchar2s(soap, *p)))
+      return soap->error;
+  }
+  else
 #endif
+  if (p)
+  {
+    wchar_t c;
+    const wchar_t *s = *p;
+    while ((c = *s++))
+    {
+      if (soap_pututf8(soap, (unsigned long)c)) /* send as-is in UTF8 */
+        return soap->error;
     }
   }
-  return soap->error;
+  if (tag && *tag != '-')
+    return soap_element_end_out(soap, tag);
+  return SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEAN
-static int soap_isnumeric(struct soap *soap, const char *type)
+#ifndef WITH_LEANER
+SOAP_FMAC1
+wchar_t **
+SOAP_FMAC2
+soap_inwliteral(struct soap *soap, const char *tag, wchar_t **p)
 {
-  if (soap_match_tag(soap, soap->type, type)
-   && soap_match_tag(soap, soap->type, ":float")
-   && soap_match_tag(soap, soap->type, ":double")
-   && soap_match_tag(soap, soap->type, ":decimal")
-   && soap_match_tag(soap, soap->type, ":integer")
-   && soap_match_tag(soap, soap->type, ":positiveInteger")
-   && soap_match_tag(soap, soap->type, ":negativeInteger")
-   && soap_match_tag(soap, soap->type, ":nonPositiveInteger")
-   && soap_match_tag(soap, soap->type, ":nonNegativeInteger")
-   && soap_match_tag(soap, soap->type, ":long")
-   && soap_match_tag(soap, soap->type, ":int")
-   && soap_match_tag(soap, soap->type, ":short")
-   && soap_match_tag(soap, soap->type, ":byte")
-   && soap_match_tag(soap, soap->type, ":unsignedLong")
-   && soap_match_tag(soap, soap->type, ":unsignedInt")
-   && soap_match_tag(soap, soap->type, ":unsignedShort")
-   && soap_match_tag(soap, soap->type, ":unsignedByte"))
+  if (soap_element_begin_in(soap, tag, 1, NULL))
+  {
+    if (soap->error != SOAP_NO_TAG)
+      return NULL;
+#ifndef WITH_LEAN
+    if ((soap->bxml & SOAP_BXML_IN) ? soap_bxml_peek(soap) == SOAP_BXML_END : soap_peek(soap) == SOAP_TT)
+#else
+    if (soap_peek(soap) == SOAP_TT)
+#endif
+      return NULL;
+    soap->error = SOAP_OK;
+  }
+  if (!p)
+  {
+    p = (wchar_t**)soap_malloc(soap, sizeof(wchar_t*));
+    if (!p)
+      return NULL;
+  }
+  if (soap->body)
+  {
+    if (tag && *tag != '-')
+      *p = soap_wstring_in(soap, 0, -1, -1, NULL);
+    else
+      *p = soap_wstring_in(soap, -1, -1, -1, NULL);
+    if (!*p)
+      return NULL;
+    if (!**p && tag && *tag == '-')
+    {
+      soap->error = SOAP_NO_TAG;
+      return NULL;
+    }
+  }
+  else if (tag && *tag == '-')
+  {
+    soap->error = SOAP_NO_TAG;
+    return NULL;
+  }
+  else if (soap->null)
+  {
+    *p = NULL;
+  }
+  else
   {
-    soap->error = SOAP_TYPE;
-    soap_revert(soap);
-    return SOAP_ERR;
+    *p = soap_wstrdup(soap, L"");
   }
-  return SOAP_OK;
+  if (soap->body && soap_element_end_in(soap, tag))
+    return NULL;
+  return p;
 }
 #endif
 
 /******************************************************************************/
 
 SOAP_FMAC1
-float *
+const char *
 SOAP_FMAC2
-soap_infloat(struct soap *soap, const char *tag, float *p, const char *type, int t)
+soap_value(struct soap *soap)
 {
-  if (soap_element_begin_in(soap, tag, 0, NULL))
-    return NULL;
+  size_t i;
+  soap_wchar c = 0;
+  char *s = soap->tmpbuf;
+  if (!soap->body)
+    return SOAP_STR_EOS;
 #ifndef WITH_LEAN
-  if (*soap->type != '\0' && soap_isnumeric(soap, type))
-    return NULL;
-#else
-  (void)type;
+  if ((soap->bxml & SOAP_BXML_IN))
+    return soap_bxml_value(soap);
 #endif
-  p = (float*)soap_id_enter(soap, soap->id, p, t, sizeof(float), NULL, NULL, NULL, NULL);
-  if (!p)
-    return NULL;
-  if (*soap->href != '#')
+  do
   {
-    int err = soap_s2float(soap, soap_value(soap), p);
-    if ((soap->body && soap_element_end_in(soap, tag)) || err)
-      return NULL;
+    c = soap_get(soap);
+  } while (soap_coblank(c));
+  for (i = 0; i < sizeof(soap->tmpbuf) - 1; i++)
+  {
+    if (c == SOAP_TT || c == SOAP_LT || (int)c == EOF)
+      break;
+    *s++ = (char)c;
+    c = soap_get(soap);
+  }
+  for (s--; i > 0; i--, s--)
+  {
+    if (!soap_coblank((soap_wchar)*s))
+      break;
+  }
+  s[1] = '\0';
+  soap->tmpbuf[sizeof(soap->tmpbuf) - 1] = '\0'; /* appease */
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Element content value='%s'\n", soap->tmpbuf));
+  if (c == SOAP_TT || c == SOAP_LT || (int)c == EOF)
+  {
+    soap_unget(soap, c);
   }
   else
   {
-    p = (float*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(float), 0, NULL, NULL);
-    if (soap->body && soap_element_end_in(soap, tag))
+    soap->error = SOAP_LENGTH;
+    return NULL;
+  }
+#ifdef WITH_DOM
+  if ((soap->mode & SOAP_XML_DOM) && soap->dom)
+  {
+    soap->dom->text = soap_strdup(soap, soap->tmpbuf);
+    if (!soap->dom->text)
       return NULL;
   }
-  return p;
+#endif
+  return soap->tmpbuf; /* return non-null pointer */
 }
 
 /******************************************************************************/
 
+#if !defined(WITH_LEANER) || !defined(WITH_NOHTTP)
 SOAP_FMAC1
-const char*
+int
 SOAP_FMAC2
-soap_double2s(struct soap *soap, double n)
+soap_getline(struct soap *soap, char *buf, int len)
 {
-#if defined(WITH_C_LOCALE)
-# if !defined(WIN32)
-  SOAP_LOCALE_T locale;
-# endif
-#else
-  char *s;
+  char *s = buf;
+  int i = len;
+  soap_wchar c = 0;
+  for (;;)
+  {
+    while (i > 1)
+    {
+      c = soap_getchar(soap);
+      if (c == '\r' || c == '\n')
+        break;
+      if ((int)c == EOF)
+        return soap->error = SOAP_CHK_EOF;
+      *s++ = (char)c;
+      i--;
+    }
+    *s = '\0';
+    if (c != '\n')
+      c = soap_getchar(soap); /* got \r or something else, now get \n */
+    if (c == '\n')
+    {
+      if (i == len) /* empty line: end of HTTP/MIME header */
+        break;
+      c = soap_get0(soap);
+      if (c != ' ' && c != '\t') /* HTTP line continuation? */
+        break;
+    }
+    else if ((int)c == EOF)
+    {
+      return soap->error = SOAP_CHK_EOF;
+    }
+    else if (i <= 1)
+    {
+      return soap->error = SOAP_HDR;
+    }
+  }
+  return SOAP_OK;
+}
 #endif
-  if (soap_isnan(n))
-    return "NaN";
-  if (soap_ispinfd(n))
-    return "INF";
-  if (soap_isninfd(n))
-    return "-INF";
-#if defined(WITH_C_LOCALE)
-# ifdef WIN32
-  _sprintf_s_l(soap->tmpbuf, _countof(soap->tmpbuf), soap->double_format, SOAP_LOCALE(soap), n);
-# else
-  locale = uselocale(SOAP_LOCALE(soap));
-  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 80), soap->double_format, n);
-  uselocale(locale);
-# endif
+
+/******************************************************************************/
+
+static ULONG64
+soap_count_attachments(struct soap *soap)
+{
+#ifndef WITH_LEANER
+  struct soap_multipart *content;
+  ULONG64 count = soap->count;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Calculating the message size with attachments, current count=" SOAP_ULONG_FORMAT "\n", count));
+  if ((soap->mode & SOAP_ENC_DIME) && !(soap->mode & SOAP_ENC_MTOM))
+  {
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Calculating the size of DIME attachments\n"));
+    for (content = soap->dime.first; content; content = content->next)
+    {
+      count += 12 + ((content->size+3)&(~3));
+      if (content->id)
+        count += ((strlen(content->id)+3)&(~3));
+      if (content->type)
+        count += ((strlen(content->type)+3)&(~3));
+      if (content->options)
+        count += ((((unsigned char)content->options[2] << 8) | ((unsigned char)content->options[3]))+7)&(~3);
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Size of DIME attachment content is %lu bytes\n", (unsigned long)content->size));
+    }
+  }
+  if ((soap->mode & SOAP_ENC_MIME) && soap->mime.boundary)
+  {
+    size_t n = strlen(soap->mime.boundary);
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Calculating the size of MIME attachments\n"));
+    for (content = soap->mime.first; content; content = content->next)
+    {
+      const char *s;
+      /* count \r\n--boundary\r\n */
+      count += 6 + n;
+      /* count Content-Type: ...\r\n */
+      if (content->type)
+        count += 16 + strlen(content->type);
+      /* count Content-Transfer-Encoding: ...\r\n */
+      s = soap_code_str(mime_codes, content->encoding);
+      if (s)
+        count += 29 + strlen(s);
+      /* count Content-ID: ...\r\n */
+      if (content->id)
+        count += 14 + strlen(content->id);
+      /* count Content-Location: ...\r\n */
+      if (content->location)
+        count += 20 + strlen(content->location);
+      /* count Content-Description: ...\r\n */
+      if (content->description)
+        count += 23 + strlen(content->description);
+      /* count \r\n...content */
+      count += 2 + content->size;
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Size of MIME attachment content is %lu bytes\n", (unsigned long)content->size));
+    }
+    /* count \r\n--boundary-- */
+    count += 6 + n;
+  }
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "New count=" SOAP_ULONG_FORMAT "\n", count));
+  return count;
 #else
-  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 80), soap->double_format, n);
-  s = strchr(soap->tmpbuf, ',');        /* convert decimal comma to DP */
-  if (s)
-    *s = '.';
+  return soap->count;
 #endif
-  return soap->tmpbuf;
 }
 
 /******************************************************************************/
 
+#ifndef WITH_LEANER
+static int
+soap_putdimefield(struct soap *soap, const char *s, size_t n)
+{
+  if (soap_send_raw(soap, s, n))
+    return soap->error;
+  return soap_send_raw(soap, SOAP_STR_PADDING, -(long)n&3);
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEANER
+SOAP_FMAC1
+char *
+SOAP_FMAC2
+soap_dime_option(struct soap *soap, unsigned short optype, const char *option)
+{
+  size_t n;
+  char *s = NULL;
+  if (option)
+  {
+    n = strlen(option);
+    s = (char*)soap_malloc(soap, n + 5);
+    if (s)
+    {
+      s[0] = (char)(optype >> 8);
+      s[1] = (char)(optype & 0xFF);
+      s[2] = (char)(n >> 8);
+      s[3] = (char)(n & 0xFF);
+      soap_strcpy(s + 4, n + 1, option);
+    }
+  }
+  return s;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEANER
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_outdouble(struct soap *soap, const char *tag, int id, const double *p, const char *type, int n)
+soap_putdimehdr(struct soap *soap)
 {
-  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
-   || soap_string_out(soap, soap_double2s(soap, *p), 0))
+  unsigned char tmp[12];
+  size_t optlen = 0, idlen = 0, typelen = 0;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Put DIME header id='%s'\n", soap->dime.id ? soap->dime.id : SOAP_STR_EOS));
+  if (soap->dime.options)
+    optlen = (((unsigned char)soap->dime.options[2] << 8) | ((unsigned char)soap->dime.options[3])) + 4;
+  if (soap->dime.id)
+  {
+    idlen = strlen(soap->dime.id);
+    if (idlen > 0x0000FFFF)
+      idlen = 0x0000FFFF;
+  }
+  if (soap->dime.type)
+  {
+    typelen = strlen(soap->dime.type);
+    if (typelen > 0x0000FFFF)
+      typelen = 0x0000FFFF;
+  }
+  tmp[0] = SOAP_DIME_VERSION | (soap->dime.flags & 0x7);
+  tmp[1] = soap->dime.flags & 0xF0;
+  tmp[2] = (char)(optlen >> 8);
+  tmp[3] = (char)(optlen & 0xFF);
+  tmp[4] = (char)(idlen >> 8);
+  tmp[5] = (char)(idlen & 0xFF);
+  tmp[6] = (char)(typelen >> 8);
+  tmp[7] = (char)(typelen & 0xFF);
+  tmp[8] = (char)(soap->dime.size >> 24);
+  tmp[9] = (char)((soap->dime.size >> 16) & 0xFF);
+  tmp[10] = (char)((soap->dime.size >> 8) & 0xFF);
+  tmp[11] = (char)(soap->dime.size & 0xFF);
+  if (soap_send_raw(soap, (char*)tmp, 12)
+   || soap_putdimefield(soap, soap->dime.options, optlen)
+   || soap_putdimefield(soap, soap->dime.id, idlen)
+   || soap_putdimefield(soap, soap->dime.type, typelen))
     return soap->error;
-  return soap_element_end_out(soap, tag);
+  return SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEANER
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_s2double(struct soap *soap, const char *s, double *p)
+soap_putdime(struct soap *soap)
 {
-  if (s)
+  struct soap_multipart *content;
+  if (!(soap->mode & SOAP_ENC_DIME))
+    return SOAP_OK;
+  for (content = soap->dime.first; content; content = content->next)
   {
-    if (!*s)
-      return soap->error = SOAP_EMPTY;
-    if (!soap_tag_cmp(s, "INF"))
-    {
-      *p = DBL_PINFTY;
-    }
-    else if (!soap_tag_cmp(s, "+INF"))
-    {
-      *p = DBL_PINFTY;
-    }
-    else if (!soap_tag_cmp(s, "-INF"))
-    {
-      *p = DBL_NINFTY;
-    }
-    else if (!soap_tag_cmp(s, "NaN"))
+    void *handle;
+    soap->dime.size = content->size;
+    soap->dime.id = content->id;
+    soap->dime.type = content->type;
+    soap->dime.options = content->options;
+    soap->dime.flags = SOAP_DIME_VERSION | SOAP_DIME_MEDIA;
+    if (soap->fdimereadopen && ((handle = soap->fdimereadopen(soap, (void*)content->ptr, content->id, content->type, content->options)) != NULL || soap->error))
     {
-      *p = DBL_NAN;
+      size_t size = content->size;
+      if (!handle)
+      {
+        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fdimereadopen failed\n"));
+        return soap->error;
+      }
+      if (!size && ((soap->mode & SOAP_ENC_PLAIN) || (soap->mode & SOAP_IO) == SOAP_IO_CHUNK || (soap->mode & SOAP_IO) == SOAP_IO_STORE))
+      {
+        size_t chunksize = sizeof(soap->tmpbuf);
+        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Chunked streaming DIME\n"));
+        do
+        {
+          size = soap->fdimeread(soap, handle, soap->tmpbuf, chunksize);
+          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fdimeread returned %lu bytes\n", (unsigned long)size));
+          if (size < chunksize)
+          {
+            soap->dime.flags &= ~SOAP_DIME_CF;
+            if (!content->next)
+              soap->dime.flags |= SOAP_DIME_ME;
+          }
+          else
+          {
+            soap->dime.flags |= SOAP_DIME_CF;
+          }
+          soap->dime.size = size;
+          if (soap_putdimehdr(soap)
+           || soap_putdimefield(soap, soap->tmpbuf, size))
+            break;
+          if (soap->dime.id)
+          {
+            soap->dime.flags &= ~(SOAP_DIME_MB | SOAP_DIME_MEDIA);
+            soap->dime.id = NULL;
+            soap->dime.type = NULL;
+            soap->dime.options = NULL;
+          }
+        } while (size >= chunksize);
+      }
+      else
+      {
+        if (!content->next)
+          soap->dime.flags |= SOAP_DIME_ME;
+        if (soap_putdimehdr(soap))
+          return soap->error;
+        do
+        {
+          size_t bufsize;
+          if (size < sizeof(soap->tmpbuf))
+            bufsize = size;
+          else
+            bufsize = sizeof(soap->tmpbuf);
+          bufsize = soap->fdimeread(soap, handle, soap->tmpbuf, bufsize);
+          if (!bufsize)
+          {
+            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fdimeread failed: insufficient data (%lu bytes remaining from %lu bytes)\n", (unsigned long)size, (unsigned long)content->size));
+            soap->error = SOAP_CHK_EOF;
+            break;
+          }
+          if (soap_send_raw(soap, soap->tmpbuf, bufsize))
+            break;
+          size -= bufsize;
+        } while (size);
+        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fdimereadclose\n"));
+        if (soap_send_raw(soap, SOAP_STR_PADDING, -(long)soap->dime.size&3))
+          return soap->error;
+      }
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fdimereadclose\n"));
+      if (soap->fdimereadclose)
+        soap->fdimereadclose(soap, handle);
     }
     else
     {
-#if defined(WITH_C_LOCALE)
-# if defined(HAVE_STRTOD_L)
-      char *r;
-#  ifdef WIN32
-      *p = _strtod_l(s, &r, SOAP_LOCALE(soap));
-#  else
-      *p = strtod_l(s, &r, SOAP_LOCALE(soap));
-#  endif
-      if (*r)
-        soap->error = SOAP_TYPE;
-# elif defined(HAVE_STRTOD)
-      char *r;
-      SOAP_LOCALE_T locale = uselocale(SOAP_LOCALE(soap));
-      *p = strtod(s, &r);
-      uselocale(locale);
-      if (*r)
-        soap->error = SOAP_TYPE;
-# elif defined(HAVE_SSCANF_L)
-      SOAP_LOCALE_T locale = uselocale(SOAP_LOCALE(soap));
-      if (sscanf_l(s, SOAP_LOCALE(soap), "%lf", p) != 1)
-        soap->error = SOAP_TYPE;
-      uselocale(locale);
-# else
-      soap->error = SOAP_TYPE;
-# endif
-#elif defined(HAVE_STRTOD)
-      char *r;
-      *p = strtod(s, &r);
-      if (*r)
-        soap->error = SOAP_TYPE;
-#elif defined(HAVE_SSCANF)
-      if (sscanf(s, "%lf", p) != 1)
-        soap->error = SOAP_TYPE;
-#else
-      soap->error = SOAP_TYPE;
-#endif
+      if (!content->next)
+        soap->dime.flags |= SOAP_DIME_ME;
+      if (soap_putdimehdr(soap)
+       || soap_putdimefield(soap, (char*)content->ptr, content->size))
+        return soap->error;
     }
   }
-  return soap->error;
+  return SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-double *
-SOAP_FMAC2
-soap_indouble(struct soap *soap, const char *tag, double *p, const char *type, int t)
+#ifndef WITH_LEANER
+static char *
+soap_getdimefield(struct soap *soap, size_t n)
 {
-  if (soap_element_begin_in(soap, tag, 0, NULL))
-    return NULL;
-#ifndef WITH_LEAN
-  if (*soap->type != '\0' && soap_isnumeric(soap, type))
-    return NULL;
-#else
-  (void)type;
-#endif
-  p = (double*)soap_id_enter(soap, soap->id, p, t, sizeof(double), NULL, NULL, NULL, NULL);
-  if (!p)
-    return NULL;
-  if (*soap->href != '#')
-  {
-    int err = soap_s2double(soap, soap_value(soap), p);
-    if ((soap->body && soap_element_end_in(soap, tag)) || err)
-      return NULL;
-  }
-  else
+  char *p = NULL;
+  if (n > 0)
   {
-    p = (double*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(double), 0, NULL, NULL);
-    if (soap->body && soap_element_end_in(soap, tag))
-      return NULL;
+    p = (char*)soap_malloc(soap, n + 1 > n ? n + 1 : n);
+    if (p)
+    {
+      char *s = p;
+      size_t i;
+      for (i = n; i > 0; i--)
+      {
+        soap_wchar c = soap_get1(soap);
+        if ((int)c == EOF)
+        {
+          soap->error = SOAP_CHK_EOF;
+          return NULL;
+        }
+        *s++ = (char)c;
+      }
+      if (n + 1 > n)
+        *s = '\0'; /* force NUL terminated */
+      soap->error = soap_move(soap, (size_t)(-(long)n&3));
+      if (soap->error)
+        return NULL;
+    }
+    else
+    {
+      soap->error = SOAP_EOM;
+    }
   }
   return p;
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-const char*
-SOAP_FMAC2
-soap_unsignedByte2s(struct soap *soap, unsigned char n)
-{
-  return soap_unsignedLong2s(soap, (unsigned long)n);
-}
-
-/******************************************************************************/
-
+#ifndef WITH_LEANER
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_outunsignedByte(struct soap *soap, const char *tag, int id, const unsigned char *p, const char *type, int n)
+soap_getdimehdr(struct soap *soap)
 {
-  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
-   || soap_string_out(soap, soap_unsignedLong2s(soap, (unsigned long)*p), 0))
+  soap_wchar c;
+  char *s;
+  int i;
+  unsigned char tmp[12];
+  size_t optlen, idlen, typelen;
+  if (!(soap->mode & SOAP_ENC_DIME))
+    return soap->error = SOAP_DIME_END;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Get DIME header\n"));
+  s = (char*)tmp;
+  for (i = 12; i > 0; i--)
+  {
+    c = soap_getchar(soap);
+    if ((int)c == EOF)
+      return soap->error = SOAP_CHK_EOF;
+    *s++ = (char)c;
+  }
+  if ((tmp[0] & 0xF8) != SOAP_DIME_VERSION)
+    return soap->error = SOAP_DIME_MISMATCH;
+  soap->dime.flags = (tmp[0] & 0x7) | (tmp[1] & 0xF0);
+  optlen = (tmp[2] << 8) | tmp[3];
+  idlen = (tmp[4] << 8) | tmp[5];
+  typelen = (tmp[6] << 8) | tmp[7];
+  soap->dime.size = ((size_t)tmp[8] << 24) | ((size_t)tmp[9] << 16) | ((size_t)tmp[10] << 8) | ((size_t)tmp[11]);
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "DIME size=%lu flags=0x%X\n", (unsigned long)soap->dime.size, soap->dime.flags));
+  soap->dime.options = soap_getdimefield(soap, optlen);
+  if (!soap->dime.options && soap->error)
+    return soap->error;
+  soap->dime.id = soap_getdimefield(soap, idlen);
+  if (!soap->dime.id && soap->error)
     return soap->error;
-  return soap_element_end_out(soap, tag);
+  soap->dime.type = soap_getdimefield(soap, typelen);
+  if (!soap->dime.type && soap->error)
+    return soap->error;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "DIME flags=%x id='%s', type='%s', options='%s'\n", soap->dime.flags, soap->dime.id ? soap->dime.id : SOAP_STR_EOS, soap->dime.type ? soap->dime.type : "", soap->dime.options ? soap->dime.options+4 : SOAP_STR_EOS));
+  if ((soap->dime.flags & SOAP_DIME_ME))
+    soap->mode &= ~SOAP_ENC_DIME;
+  return SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEANER
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_s2unsignedByte(struct soap *soap, const char *s, unsigned char *p)
-{
-  if (s)
-  {
-    long n;
-    char *r;
-    if (!*s)
-      return soap->error = SOAP_EMPTY;
-    n = soap_strtol(s, &r, 10);
-    if (s == r || *r || n < 0 || n > 255)
-      soap->error = SOAP_TYPE;
-    *p = (unsigned char)n;
-  }
-  return soap->error;
-}
-
-/******************************************************************************/
-
-SOAP_FMAC1
-unsigned char *
-SOAP_FMAC2
-soap_inunsignedByte(struct soap *soap, const char *tag, unsigned char *p, const char *type, int t)
+soap_getdime(struct soap *soap)
 {
-  if (soap_element_begin_in(soap, tag, 0, NULL))
-    return NULL;
-#ifndef WITH_LEAN
-  if (*soap->type
-   && soap_match_tag(soap, soap->type, type)
-   && soap_match_tag(soap, soap->type, ":unsignedByte"))
+  if (soap->dime.buflen || soap->dime.chunksize)
   {
-    soap->error = SOAP_TYPE;
-    soap_revert(soap);
-    return NULL;
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Skip remainder of SOAP in DIME (%u bytes or %u bytes in chunk left)\n", (unsigned int)soap->dime.buflen, (unsigned int)soap->dime.chunksize));
+    do
+      if (soap_get1(soap) == (int)EOF)
+        return soap->error = SOAP_CHK_EOF;
+    while (soap->dime.buflen || soap->dime.chunksize);
+    if (soap_move(soap, (size_t)(-(long)soap->dime.size&3)))
+      return soap->error = SOAP_CHK_EOF;
+    if (!(soap->mode & SOAP_ENC_DIME))
+      return SOAP_OK;
   }
-#else
-  (void)type;
-#endif
-  p = (unsigned char*)soap_id_enter(soap, soap->id, p, t, sizeof(unsigned char), NULL, NULL, NULL, NULL);
-  if (!p)
-    return NULL;
-  if (*soap->href != '#')
+  else
   {
-    int err = soap_s2unsignedByte(soap, soap_value(soap), p);
-    if ((soap->body && soap_element_end_in(soap, tag)) || err)
-      return NULL;
+    if (soap_move(soap, (size_t)(((soap->dime.size+3)&(~3)) - soap_tell(soap))))
+      return soap->error = SOAP_CHK_EOF;
   }
-  else
+  for (;;)
   {
-    p = (unsigned char*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(unsigned char), 0, NULL, NULL);
-    if (soap->body && soap_element_end_in(soap, tag))
-      return NULL;
+    struct soap_multipart *content;
+    if (soap_getdimehdr(soap))
+      break;
+    if (soap->fdimewriteopen && ((soap->dime.ptr = (char*)soap->fdimewriteopen(soap, soap->dime.id, soap->dime.type, soap->dime.options)) != NULL || soap->error))
+    {
+      const char *id, *type, *options;
+      size_t size, n;
+      if (!soap->dime.ptr)
+        return soap->error;
+      id = soap->dime.id;
+      type = soap->dime.type;
+      options = soap->dime.options;
+      for (;;)
+      {
+        size = soap->dime.size;
+        for (;;)
+        {
+          n = soap->buflen - soap->bufidx;
+          if (size < n)
+            n = size;
+          soap->error = soap->fdimewrite(soap, (void*)soap->dime.ptr, soap->ibuf + soap->bufidx, n);
+          if (soap->error)
+            break;
+          size -= n;
+          if (!size)
+          {
+            soap->bufidx += n;
+            break;
+          }
+          if (soap_recv(soap))
+          {
+            soap->error = SOAP_EOF;
+            goto end;
+          }
+        }
+        if (soap_move(soap, (size_t)(-(long)soap->dime.size&3)))
+        {
+          soap->error = SOAP_EOF;
+          break;
+        }
+        if (!(soap->dime.flags & SOAP_DIME_CF))
+          break;
+        if (soap_getdimehdr(soap))
+          break;
+      }
+end:
+      if (soap->fdimewriteclose)
+        soap->fdimewriteclose(soap, (void*)soap->dime.ptr);
+      soap->dime.size = 0;
+      soap->dime.id = id;
+      soap->dime.type = type;
+      soap->dime.options = options;
+    }
+    else if ((soap->dime.flags & SOAP_DIME_CF))
+    {
+      const char *id, *type, *options;
+      id = soap->dime.id;
+      type = soap->dime.type;
+      options = soap->dime.options;
+      if (soap_alloc_block(soap) == NULL)
+        return soap->error = SOAP_EOM;
+      for (;;)
+      {
+        soap_wchar c;
+        size_t i;
+        char *s;
+        if (soap->dime.size > SOAP_MAXDIMESIZE)
+        {
+          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "DIME size=%lu exceeds SOAP_MAXDIMESIZE=%lu\n", (unsigned long)soap->dime.size, (unsigned long)SOAP_MAXDIMESIZE));
+          return soap->error = SOAP_DIME_ERROR;
+        }
+        s = (char*)soap_push_block(soap, NULL, soap->dime.size);
+        if (!s)
+          return soap->error = SOAP_EOM;
+        for (i = soap->dime.size; i > 0; i--)
+        {
+          c = soap_get1(soap);
+          if ((int)c == EOF)
+            return soap->error = SOAP_EOF;
+          *s++ = (char)c;
+        }
+        if (soap_move(soap, (size_t)(-(long)soap->dime.size&3)))
+          return soap->error = SOAP_EOF;
+        if (!(soap->dime.flags & SOAP_DIME_CF))
+          break;
+        if (soap_getdimehdr(soap))
+          return soap->error;
+      }
+      soap->dime.size = soap->blist->size;
+      if (soap->dime.size + 1 > soap->dime.size)
+        soap->blist->size++; /* allocate one more byte in blist for the terminating '\0' */
+      soap->dime.ptr = (char*)soap_save_block(soap, NULL, NULL, 0);
+      if (!soap->dime.ptr)
+        return soap->error;
+      if (soap->dime.size + 1 > soap->dime.size)
+        soap->dime.ptr[soap->dime.size] = '\0'; /* make 0-terminated, just in case even though this is binary data */
+      soap->dime.id = id;
+      soap->dime.type = type;
+      soap->dime.options = options;
+    }
+    else
+    {
+      soap->dime.ptr = soap_getdimefield(soap, soap->dime.size);
+    }
+    content = soap_alloc_multipart(soap, &soap->dime.first, &soap->dime.last, soap->dime.ptr, soap->dime.size);
+    if (!content)
+      return soap->error = SOAP_EOM;
+    content->id = soap->dime.id;
+    content->type = soap->dime.type;
+    content->options = soap->dime.options;
+    if (soap->error)
+      return soap->error;
+    soap_resolve_attachment(soap, content);
   }
-  return p;
-}
-
-/******************************************************************************/
-
-SOAP_FMAC1
-const char*
-SOAP_FMAC2
-soap_unsignedShort2s(struct soap *soap, unsigned short n)
-{
-  return soap_unsignedLong2s(soap, (unsigned long)n);
+  if (soap->error != SOAP_DIME_END)
+    return soap->error;
+  return soap->error = SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEANER
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_outunsignedShort(struct soap *soap, const char *tag, int id, const unsigned short *p, const char *type, int n)
+soap_getmimehdr(struct soap *soap)
 {
-  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
-   || soap_string_out(soap, soap_unsignedLong2s(soap, (unsigned long)*p), 0))
-    return soap->error;
-  return soap_element_end_out(soap, tag);
+  struct soap_multipart *content;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Get MIME header\n"));
+  do
+  {
+    if (soap_getline(soap, soap->msgbuf, sizeof(soap->msgbuf)))
+      return soap->error;
+  } while (!*soap->msgbuf);
+  if (soap->msgbuf[0] == '-' && soap->msgbuf[1] == '-')
+  {
+    char *s = soap->msgbuf + strlen(soap->msgbuf) - 1;
+    /* remove white space */
+    while (soap_coblank((soap_wchar)*s))
+      s--;
+    s[1] = '\0';
+    if (soap->mime.boundary)
+    {
+      if (strcmp(soap->msgbuf + 2, soap->mime.boundary))
+        return soap->error = SOAP_MIME_ERROR;
+    }
+    else
+    {
+      soap->mime.boundary = soap_strdup(soap, soap->msgbuf + 2);
+      if (!soap->mime.boundary)
+        return soap->error = SOAP_EOM;
+    }
+    if (soap_getline(soap, soap->msgbuf, sizeof(soap->msgbuf)))
+      return soap->error;
+  }
+  if (soap_set_mime_attachment(soap, NULL, 0, SOAP_MIME_NONE, NULL, NULL, NULL, NULL))
+    return soap->error = SOAP_EOM;
+  content = soap->mime.last;
+  for (;;)
+  {
+    char *key = soap->msgbuf;
+    char *val;
+    if (!*key)
+      break;
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "MIME header: %s\n", key));
+    val = strchr(soap->msgbuf, ':');
+    if (val)
+    {
+      *val = '\0';
+      do
+      {
+        val++;
+      } while (*val && *val <= 32);
+      if (!soap_tag_cmp(key, "Content-ID"))
+        content->id = soap_strdup(soap, val);
+      else if (!soap_tag_cmp(key, "Content-Location"))
+        content->location = soap_strdup(soap, val);
+      else if (!content->id && !soap_tag_cmp(key, "Content-Disposition"))
+        content->id = soap_strdup(soap, soap_http_header_attribute(soap, val, "name"));
+      else if (!soap_tag_cmp(key, "Content-Type"))
+        content->type = soap_strdup(soap, val);
+      else if (!soap_tag_cmp(key, "Content-Description"))
+        content->description = soap_strdup(soap, val);
+      else if (!soap_tag_cmp(key, "Content-Transfer-Encoding"))
+        content->encoding = (enum soap_mime_encoding)soap_code_int(mime_codes, val, (LONG64)SOAP_MIME_NONE);
+    }
+    if (soap_getline(soap, key, sizeof(soap->msgbuf)))
+      return soap->error;
+  }
+  return SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEANER
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_s2unsignedShort(struct soap *soap, const char *s, unsigned short *p)
+soap_getmime(struct soap *soap)
 {
-  if (s)
-  {
-    long n;
-    char *r;
-    if (!*s)
-      return soap->error = SOAP_EMPTY;
-    n = soap_strtol(s, &r, 10);
-    if (s == r || *r || n < 0 || n > 65535)
-      soap->error = SOAP_TYPE;
-    *p = (unsigned short)n;
-  }
+  while (soap_recv_mime_attachment(soap, NULL))
+    continue;
   return soap->error;
 }
-
-/******************************************************************************/
-
-SOAP_FMAC1
-unsigned short *
-SOAP_FMAC2
-soap_inunsignedShort(struct soap *soap, const char *tag, unsigned short *p, const char *type, int t)
-{
-  if (soap_element_begin_in(soap, tag, 0, NULL))
-    return NULL;
-#ifndef WITH_LEAN
-  if (*soap->type
-   && soap_match_tag(soap, soap->type, type)
-   && soap_match_tag(soap, soap->type, ":unsignedShort")
-   && soap_match_tag(soap, soap->type, ":unsignedByte"))
-  {
-    soap->error = SOAP_TYPE;
-    soap_revert(soap);
-    return NULL;
-  }
-#else
-  (void)type;
 #endif
-  p = (unsigned short*)soap_id_enter(soap, soap->id, p, t, sizeof(unsigned short), NULL, NULL, NULL, NULL);
-  if (!p)
-    return NULL;
-  if (*soap->href != '#')
-  {
-    int err = soap_s2unsignedShort(soap, soap_value(soap), p);
-    if ((soap->body && soap_element_end_in(soap, tag)) || err)
-      return NULL;
-  }
-  else
-  {
-    p = (unsigned short*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(unsigned short), 0, NULL, NULL);
-    if (soap->body && soap_element_end_in(soap, tag))
-      return NULL;
-  }
-  return p;
-}
 
 /******************************************************************************/
 
+#ifndef WITH_LEANER
 SOAP_FMAC1
-const char*
+void
 SOAP_FMAC2
-soap_unsignedInt2s(struct soap *soap, unsigned int n)
+soap_post_check_mime_attachments(struct soap *soap)
 {
-  return soap_unsignedLong2s(soap, (unsigned long)n);
+  soap->imode |= SOAP_MIME_POSTCHECK;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEANER
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_outunsignedInt(struct soap *soap, const char *tag, int id, const unsigned int *p, const char *type, int n)
+soap_check_mime_attachments(struct soap *soap)
 {
-  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
-   || soap_string_out(soap, soap_unsignedLong2s(soap, (unsigned long)*p), 0))
-    return soap->error;
-  return soap_element_end_out(soap, tag);
+  if ((soap->mode & SOAP_MIME_POSTCHECK))
+    return soap_recv_mime_attachment(soap, NULL) != NULL;
+  return 0;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEANER
 SOAP_FMAC1
-int
+struct soap_multipart *
 SOAP_FMAC2
-soap_s2unsignedInt(struct soap *soap, const char *s, unsigned int *p)
+soap_recv_mime_attachment(struct soap *soap, void *handle)
 {
-  if (s)
+  soap_wchar c = 0;
+  size_t i, m = 0;
+  char *s, *t = NULL;
+  struct soap_multipart *content;
+  short flag = 0;
+  if (!(soap->mode & SOAP_ENC_MIME))
+    goto post_check_exit;
+  content = soap->mime.last;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Get MIME (%p)\n", (void*)content));
+  if (!content)
   {
-    unsigned long n;
-    char *r;
-    if (!*s)
-      return soap->error = SOAP_EMPTY;
-#ifndef WITH_NOIO
-#ifndef WITH_LEAN
-    soap_reset_errno;
-#endif
-#endif
-    n = soap_strtoul(s, &r, 10);
-    if (s == r || *r
-#ifndef WITH_LEAN
-        || n != (unsigned int)n
-#endif
-#ifndef WITH_NOIO
-#ifndef WITH_LEAN
-        || soap_errno == SOAP_ERANGE
-#endif
-#endif
-    )
-      soap->error = SOAP_TYPE;
-#ifdef HAVE_STRTOUL
-    if (n > 0 && strchr(s, '-'))
-      return soap->error = SOAP_TYPE;
-#endif
-    *p = (unsigned int)n;
+    if (soap_getmimehdr(soap))
+      goto post_check_exit;
+    content = soap->mime.last;
   }
-  return soap->error;
-}
-
-/******************************************************************************/
-
-SOAP_FMAC1
-unsigned int *
-SOAP_FMAC2
-soap_inunsignedInt(struct soap *soap, const char *tag, unsigned int *p, const char *type, int t)
-{
-  if (soap_element_begin_in(soap, tag, 0, NULL))
-    return NULL;
-#ifndef WITH_LEAN
-  if (*soap->type
-   && soap_match_tag(soap, soap->type, type)
-   && soap_match_tag(soap, soap->type, ":unsignedInt")
-   && soap_match_tag(soap, soap->type, ":unsignedShort")
-   && soap_match_tag(soap, soap->type, ":unsignedByte"))
+  else if (content != soap->mime.first)
   {
-    soap->error = SOAP_TYPE;
-    soap_revert(soap);
-    return NULL;
+    if (soap->fmimewriteopen && ((content->ptr = (char*)soap->fmimewriteopen(soap, (void*)handle, content->id, content->type, content->description, content->encoding)) != NULL || soap->error))
+    {
+      if (!content->ptr)
+        goto post_check_exit;
+    }
   }
-#else
-  (void)type;
-#endif
-  p = (unsigned int*)soap_id_enter(soap, soap->id, p, t, sizeof(unsigned int), NULL, NULL, NULL, NULL);
-  if (!p)
-    return NULL;
-  if (*soap->href != '#')
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Parsing MIME content id='%s' type='%s'\n", content->id ? content->id : SOAP_STR_EOS, content->type ? content->type : SOAP_STR_EOS));
+  if (!content->ptr && soap_alloc_block(soap) == NULL)
+  {
+    soap->error = SOAP_EOM;
+    goto post_check_exit;
+  }
+  for (;;)
+  {
+    if (content->ptr)
+    {
+      s = soap->tmpbuf;
+    }
+    else
+    {
+      s = (char*)soap_push_block(soap, NULL, sizeof(soap->tmpbuf));
+      if (!s)
+      {
+        soap->error = SOAP_EOM;
+        goto post_check_exit;
+      }
+    }
+    for (i = 0; i < sizeof(soap->tmpbuf); i++)
+    {
+      if (m > 0)
+      {
+        *s++ = *t++;
+        m--;
+      }
+      else
+      {
+        if (!flag)
+        {
+          c = soap_getchar(soap);
+          if ((int)c == EOF)
+          {
+            if (content->ptr && soap->fmimewriteclose)
+              soap->fmimewriteclose(soap, (void*)content->ptr);
+            soap->error = SOAP_CHK_EOF;
+            goto post_check_exit;
+          }
+        }
+        if (flag || c == '\r')
+        {
+          memset((void*)soap->msgbuf, 0, sizeof(soap->msgbuf));
+          soap_strcpy(soap->msgbuf, sizeof(soap->msgbuf), "\n--");
+          if (soap->mime.boundary)
+          {
+            if (soap_strncat(soap->msgbuf, sizeof(soap->msgbuf), soap->mime.boundary, sizeof(soap->msgbuf) - 4))
+            {
+              soap->error = SOAP_MIME_ERROR;
+              goto post_check_exit;
+            }
+          }
+          t = soap->msgbuf;
+          do
+          {
+            c = soap_getchar(soap);
+          } while (c == *t++);
+          if ((int)c == EOF)
+          {
+            if (content->ptr && soap->fmimewriteclose)
+              soap->fmimewriteclose(soap, (void*)content->ptr);
+            soap->error = SOAP_CHK_EOF;
+            goto post_check_exit;
+          }
+          if (!*--t)
+            goto end;
+          *t = (char)c;
+          flag = (c == '\r');
+          m = t - soap->msgbuf + 1 - flag;
+          t = soap->msgbuf;
+          c = '\r';
+        }
+        *s++ = (char)c;
+      }
+    }
+    if (content->ptr && soap->fmimewrite)
+    {
+      soap->error = soap->fmimewrite(soap, (void*)content->ptr, soap->tmpbuf, i);
+      if (soap->error)
+        break;
+    }
+  }
+end:
+  if (content->ptr)
+  {
+    if (!soap->error && soap->fmimewrite)
+      soap->error = soap->fmimewrite(soap, (void*)content->ptr, soap->tmpbuf, i);
+    if (soap->fmimewriteclose)
+      soap->fmimewriteclose(soap, (void*)content->ptr);
+    if (soap->error)
+      goto post_check_exit;
+  }
+  else
+  {
+    *s = '\0'; /* make 0-terminated, just in case even though this is binary data */
+    content->size = soap_size_block(soap, NULL, i + 1) - 1; /* last block with '\0' */
+    content->ptr = (char*)soap_save_block(soap, NULL, NULL, 0);
+  }
+  soap_resolve_attachment(soap, content);
+  if (c == '-' && soap_getchar(soap) == '-')
   {
-    int err = soap_s2unsignedInt(soap, soap_value(soap), p);
-    if ((soap->body && soap_element_end_in(soap, tag)) || err)
-      return NULL;
+    soap->mode &= ~SOAP_ENC_MIME;
+    if ((soap->mode & SOAP_MIME_POSTCHECK))
+    {
+      if (soap_end_recv(soap))
+        goto post_check_exit;
+      if (soap->keep_alive == -2) /* special case to keep alive */
+        soap->keep_alive = 0;
+      (void)soap_closesock(soap);
+    }
   }
   else
   {
-    p = (unsigned int*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(unsigned int), 0, NULL, NULL);
-    if (soap->body && soap_element_end_in(soap, tag))
-      return NULL;
+    while (c != '\r' && (int)c != EOF && soap_coblank(c))
+      c = soap_getchar(soap);
+    if (c != '\r' || soap_getchar(soap) != '\n')
+    {
+      soap->error = SOAP_MIME_ERROR;
+      goto post_check_exit;
+    }
+    if (soap_getmimehdr(soap))
+      goto post_check_exit;
   }
-  return p;
-}
-
-/******************************************************************************/
-
-SOAP_FMAC1
-const char*
-SOAP_FMAC2
-soap_unsignedLong2s(struct soap *soap, unsigned long n)
-{
-  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 20), "%lu", n);
-  return soap->tmpbuf;
-}
-
-/******************************************************************************/
-
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_outunsignedLong(struct soap *soap, const char *tag, int id, const unsigned long *p, const char *type, int n)
-{
-  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
-   || soap_string_out(soap, soap_unsignedLong2s(soap, *p), 0))
-    return soap->error;
-  return soap_element_end_out(soap, tag);
-}
-
-/******************************************************************************/
-
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_s2unsignedLong(struct soap *soap, const char *s, unsigned long *p)
-{
-  if (s)
+  return content;
+post_check_exit:
+  if ((soap->mode & SOAP_MIME_POSTCHECK))
   {
-    char *r;
-    if (!*s)
-      return soap->error = SOAP_EMPTY;
-#ifndef WITH_NOIO
-#ifndef WITH_LEAN
-    soap_reset_errno;
-#endif
-#endif
-    *p = soap_strtoul(s, &r, 10);
-    if (s == r || *r
-#ifndef WITH_NOIO
-#ifndef WITH_LEAN
-        || soap_errno == SOAP_ERANGE
-#endif
-#endif
-    )
-      soap->error = SOAP_TYPE;
-#ifdef HAVE_STRTOUL
-    if (*p > 0 && strchr(s, '-'))
-      return soap->error = SOAP_TYPE;
-#endif
+    if (soap->keep_alive == -2) /* special case to keep alive */
+      soap->keep_alive = 0;
+    (void)soap_closesock(soap);
   }
-  return soap->error;
+  return NULL;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEANER
 SOAP_FMAC1
-unsigned long *
+int
 SOAP_FMAC2
-soap_inunsignedLong(struct soap *soap, const char *tag, unsigned long *p, const char *type, int t)
+soap_match_cid(struct soap *soap, const char *s, const char *t)
 {
-  if (soap_element_begin_in(soap, tag, 0, NULL))
-    return NULL;
-#ifndef WITH_LEAN
-  if (*soap->type
-   && soap_match_tag(soap, soap->type, type)
-   && soap_match_tag(soap, soap->type, ":unsignedInt")
-   && soap_match_tag(soap, soap->type, ":unsignedShort")
-   && soap_match_tag(soap, soap->type, ":unsignedByte"))
-  {
-    soap->error = SOAP_TYPE;
-    soap_revert(soap);
-    return NULL;
-  }
-#else
-  (void)type;
-#endif
-  p = (unsigned long*)soap_id_enter(soap, soap->id, p, t, sizeof(unsigned long), NULL, NULL, NULL, NULL);
-  if (!p)
-    return NULL;
-  if (*soap->href != '#')
-  {
-    int err = soap_s2unsignedLong(soap, soap_value(soap), p);
-    if ((soap->body && soap_element_end_in(soap, tag)) || err)
-      return NULL;
-  }
-  else
+  size_t n;
+  if (!s)
+    return 1;
+  if (!strcmp(s, t))
+    return 0;
+  if (!strncmp(s, "cid:", 4))
+    s += 4;
+  n = strlen(t);
+  if (*t == '<')
   {
-    p = (unsigned long*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(unsigned long), 0, NULL, NULL);
-    if (soap->body && soap_element_end_in(soap, tag))
-      return NULL;
+    t++;
+    n -= 2;
   }
-  return p;
+  if (!strncmp(s, t, n) && !s[n])
+    return 0;
+  (void)soap_decode(soap->tmpbuf, sizeof(soap->tmpbuf), s, SOAP_STR_EOS);
+  if (!strncmp(soap->tmpbuf, t, n) && !soap->tmpbuf[n])
+    return 0;
+  return 1;
 }
+#endif
 
 /******************************************************************************/
 
+/* return UUID "<prefix>xxxxxxxx-xxxx-4xxx-yxxx-xxxxxxxxxxxx" in a temporary buffer */
 SOAP_FMAC1
 const char*
 SOAP_FMAC2
-soap_ULONG642s(struct soap *soap, ULONG64 n)
+soap_rand_uuid(struct soap *soap, const char *prefix)
 {
-  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 20), SOAP_ULONG_FORMAT, n);
+  int r1, r2, r3, r4;
+#ifdef WITH_OPENSSL
+  r1 = soap_random;
+  r2 = soap_random;
+#else
+  size_t i;
+  static int k = 0xFACEB00C;
+  int lo = k % 127773;
+  int hi = k / 127773;
+# if defined(HAVE_GETTIMEOFDAY)
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  r1 = 10000000 * tv.tv_sec + tv.tv_usec;
+# elif defined(UNDER_CE)
+  r1 = (int)Random();
+# elif !defined(WITH_LEAN)
+  r1 = (int)time(NULL);
+# else
+  r1 = k;
+# endif
+  k = 16807 * lo - 2836 * hi;
+  if (k <= 0)
+    k += 0x7FFFFFFF;
+  r2 = k;
+  /* k &= 0x8FFFFFFF; */
+  for (i = 0; i < (sizeof(soap->buf) < 16UL ? sizeof(soap->buf) : 16UL); i++)
+    r2 += soap->buf[i];
+#endif
+  r3 = soap_random;
+  r4 = soap_random;
+  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), prefix ? strlen(prefix) + 37 : 37), "%s%8.8x-%4.4hx-4%3.3hx-%4.4hx-%4.4hx%8.8x", prefix ? prefix : SOAP_STR_EOS, r1, (short)(r2 >> 16), (short)(((short)r2 >> 4) & 0x0FFF), (short)(((short)(r3 >> 16) & 0x3FFF) | 0x8000), (short)r3, r4);
   return soap->tmpbuf;
 }
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_outULONG64(struct soap *soap, const char *tag, int id, const ULONG64 *p, const char *type, int n)
+#ifndef WITH_LEANER
+static void
+soap_resolve_attachment(struct soap *soap, struct soap_multipart *content)
 {
-  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
-   || soap_string_out(soap, soap_ULONG642s(soap, *p), 0))
-    return soap->error;
-  return soap_element_end_out(soap, tag);
+  if (content->id)
+  {
+    struct soap_xlist **xp = &soap->xlist;
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Resolving attachment data for id='%s'\n", content->id));
+    while (*xp)
+    {
+      struct soap_xlist *xq = *xp;
+      if (!soap_match_cid(soap, xq->id, content->id))
+      {
+        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Found matching attachment id='%s' for content id='%s'\n", xq->id, content->id));
+        *xp = xq->next;
+        *xq->ptr = (unsigned char*)content->ptr;
+        *xq->size = (int)content->size;
+        *xq->type = (char*)content->type;
+        if (content->options)
+          *xq->options = (char*)content->options;
+        else
+          *xq->options = (char*)content->description;
+        SOAP_FREE(soap, xq);
+      }
+      else
+      {
+        xp = &(*xp)->next;
+      }
+    }
+  }
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEANER
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_s2ULONG64(struct soap *soap, const char *s, ULONG64 *p)
+soap_putmimehdr(struct soap *soap, struct soap_multipart *content)
 {
-  if (s)
-  {
-    char *r;
-    if (!*s)
-      return soap->error = SOAP_EMPTY;
-#ifndef WITH_NOIO
-#ifndef WITH_LEAN
-    soap_reset_errno;
-#endif
-#endif
-    *p = soap_strtoull(s, &r, 10);
-    if (s == r || *r
-#ifndef WITH_NOIO
-#ifndef WITH_LEAN
-        || soap_errno == SOAP_ERANGE
-#endif
-#endif
-      )
-      soap->error = SOAP_TYPE;
-    if (*p > 0 && strchr(s, '-'))
-      return soap->error = SOAP_TYPE;
-  }
-  return soap->error;
+  const char *s;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "MIME attachment type='%s'\n", content->type ? content->type : SOAP_STR_EOS));
+  if (soap_send3(soap, "\r\n--", soap->mime.boundary, "\r\n"))
+    return soap->error;
+  if (content->type && soap_send3(soap, "Content-Type: ", content->type, "\r\n"))
+    return soap->error;
+  s = soap_code_str(mime_codes, content->encoding);
+  if (s && soap_send3(soap, "Content-Transfer-Encoding: ", s, "\r\n"))
+    return soap->error;
+  if (content->id && soap_send3(soap, "Content-ID: ", content->id, "\r\n"))
+    return soap->error;
+  if (content->location && soap_send3(soap, "Content-Location: ", content->location, "\r\n"))
+    return soap->error;
+  if (content->description && soap_send3(soap, "Content-Description: ", content->description, "\r\n"))
+    return soap->error;
+  return soap_send_raw(soap, "\r\n", 2);
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEANER
 SOAP_FMAC1
-ULONG64 *
+int
 SOAP_FMAC2
-soap_inULONG64(struct soap *soap, const char *tag, ULONG64 *p, const char *type, int t)
+soap_putmime(struct soap *soap)
 {
-  if (soap_element_begin_in(soap, tag, 0, NULL))
-    return NULL;
-#ifndef WITH_LEAN
-  if (*soap->type
-   && soap_match_tag(soap, soap->type, type)
-   && soap_match_tag(soap, soap->type, ":positiveInteger")
-   && soap_match_tag(soap, soap->type, ":nonNegativeInteger")
-   && soap_match_tag(soap, soap->type, ":unsignedLong")
-   && soap_match_tag(soap, soap->type, ":unsignedInt")
-   && soap_match_tag(soap, soap->type, ":unsignedShort")
-   && soap_match_tag(soap, soap->type, ":unsignedByte"))
-  {
-    soap->error = SOAP_TYPE;
-    soap_revert(soap);
-    return NULL;
-  }
-#else
-  (void)type;
-#endif
-  p = (ULONG64*)soap_id_enter(soap, soap->id, p, t, sizeof(ULONG64), NULL, NULL, NULL, NULL);
-  if (!p)
-    return NULL;
-  if (*soap->href != '#')
-  {
-    int err = soap_s2ULONG64(soap, soap_value(soap), p);
-    if ((soap->body && soap_element_end_in(soap, tag)) || err)
-      return NULL;
-  }
-  else
+  struct soap_multipart *content;
+  if (!(soap->mode & SOAP_ENC_MIME) || !soap->mime.boundary)
+    return SOAP_OK;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Sending MIME attachments\n"));
+  for (content = soap->mime.first; content; content = content->next)
   {
-    p = (ULONG64*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(ULONG64), 0, NULL, NULL);
-    if (soap->body && soap_element_end_in(soap, tag))
-      return NULL;
+    int err = SOAP_OK;
+    void *handle;
+    if (soap->fmimereadopen && ((handle = soap->fmimereadopen(soap, (void*)content->ptr, content->id, content->type, content->description)) != NULL || soap->error))
+    {
+      size_t size = content->size;
+      if (!handle)
+      {
+        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fmimereadopen failed\n"));
+        if (!soap->error)
+          soap->error = SOAP_MIME_ERROR;
+        return soap->error;
+      }
+      if (soap_putmimehdr(soap, content))
+        return soap->error;
+      if (!size) /* streaming MIME is indicated by size zero content size when streaming MIME callbacks are set */
+      {
+        if ((soap->mode & SOAP_ENC_PLAIN) || (soap->mode & SOAP_IO) == SOAP_IO_CHUNK || (soap->mode & SOAP_IO) == SOAP_IO_STORE)
+        {
+          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Chunked streaming MIME\n"));
+          do
+          {
+            size = soap->fmimeread(soap, handle, soap->tmpbuf, sizeof(soap->tmpbuf));
+            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fmimeread returned %lu bytes\n", (unsigned long)size));
+            err = soap_send_raw(soap, soap->tmpbuf, size);
+          } while (!err && size);
+        }
+        else
+        {
+          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Error: cannot chunk streaming MIME (no HTTP chunking)\n"));
+        }
+      }
+      else
+      {
+        do
+        {
+          size_t bufsize;
+          if (size < sizeof(soap->tmpbuf))
+            bufsize = size;
+          else
+            bufsize = sizeof(soap->tmpbuf);
+          bufsize = soap->fmimeread(soap, handle, soap->tmpbuf, bufsize);
+          if (!bufsize)
+          {
+            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fmimeread failed: insufficient data (%lu bytes remaining from %lu bytes)\n", (unsigned long)size, (unsigned long)content->size));
+            err = SOAP_MIME_ERROR; /* used to be EOF, SOAP_MIME_ERROR is more appropriaate */
+            break;
+          }
+          err = soap_send_raw(soap, soap->tmpbuf, bufsize);
+          size -= bufsize;
+        } while (!err && size);
+      }
+      if (soap->fmimereadclose)
+        soap->fmimereadclose(soap, handle);
+      if (err)
+        return soap->error = err;
+    }
+    else
+    {
+      if (soap_putmimehdr(soap, content)
+       || soap_send_raw(soap, content->ptr, content->size))
+        return soap->error;
+    }
   }
-  return p;
+  return soap_send3(soap, "\r\n--", soap->mime.boundary, "--");
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEANER
 SOAP_FMAC1
-int
+void
 SOAP_FMAC2
-soap_s2char(struct soap *soap, const char *s, char **t, int flag, long minlen, long maxlen, const char *pattern)
+soap_set_dime(struct soap *soap)
 {
-  if (s)
-  {
-    const char *r = soap_string(soap, s, flag, minlen, maxlen, pattern);
-    if (r && (*t = soap_strdup(soap, r)) == NULL)
-      return soap->error = SOAP_EOM;
-  }
-  return soap->error;
+  soap->omode |= SOAP_ENC_DIME;
+  soap->dime.first = NULL;
+  soap->dime.last = NULL;
 }
+#endif
 
 /******************************************************************************/
 
-#ifndef WITH_COMPAT
-#ifdef __cplusplus
+#ifndef WITH_LEANER
 SOAP_FMAC1
-int
+void
 SOAP_FMAC2
-soap_s2stdchar(struct soap *soap, const char *s, std::string *t, int flag, long minlen, long maxlen, const char *pattern)
+soap_set_mime(struct soap *soap, const char *boundary, const char *start)
 {
-  if (s)
-  {
-    const char *r = soap_string(soap, s, flag, minlen, maxlen, pattern);
-    if (r)
-      t->assign(r);
-  }
-  return soap->error;
+  soap->omode |= SOAP_ENC_MIME;
+  soap->mime.first = NULL;
+  soap->mime.last = NULL;
+  soap->mime.boundary = soap_strdup(soap, boundary);
+  soap->mime.start = soap_strdup(soap, start);
 }
 #endif
-#endif
 
 /******************************************************************************/
 
-static const char*
-soap_string(struct soap *soap, const char *s, int flag, long minlen, long maxlen, const char *pattern)
-{
-  if (s)
-  {
-    if (maxlen < 0 && soap->maxlength > 0)
-      maxlen = soap->maxlength;
-    if (minlen > 0 || maxlen >= 0)
-    {
-      size_t l;
-      if ((soap->mode & SOAP_C_UTFSTRING))
-        l = soap_utf8len(s);
-      else
-        l = strlen(s);
-      if ((maxlen >= 0 && l > (size_t)maxlen) || (minlen > 0 && l < (size_t)minlen))
-      {
-        soap->error = SOAP_LENGTH;
-        return NULL;
-      }
-    }
-    if (flag >= 4)
-      s = soap_collapse(soap, (char*)s, flag, 0);
 #ifndef WITH_LEANER
-    if (pattern && soap->fsvalidate)
-    {
-      soap->error = soap->fsvalidate(soap, pattern, s);
-      if (soap->error)
-        return NULL;
-    }
-#else
-    (void)pattern;
-#endif
-  }
-  return s;
+SOAP_FMAC1
+void
+SOAP_FMAC2
+soap_clr_dime(struct soap *soap)
+{
+  soap->omode &= ~SOAP_ENC_DIME;
+  soap->dime.first = NULL;
+  soap->dime.last = NULL;
 }
+#endif
 
 /******************************************************************************/
 
-static char*
-soap_collapse(struct soap *soap, char *s, int flag, int insitu)
+#ifndef WITH_LEANER
+SOAP_FMAC1
+void
+SOAP_FMAC2
+soap_clr_mime(struct soap *soap)
 {
-  /* flag 4=normalizedString (replace), 5=token (collapse) */
-  char *t;
-  size_t n;
-  if (!s)
-    return NULL;
-  if (flag == 4)
-  {
-    for (t = s; *t && (!soap_coblank((soap_wchar)*t) || *t == 32); t++)
-      continue;
-    if (*t)
-    {
-      /* replace white space and control chars by blanks */
-      if (!insitu)
-        s = soap_strdup(soap, s);
-      for (t = s; *t; t++)
-        if (soap_coblank((soap_wchar)*t))
-          *t = ' ';
-    }
-    return s;
-  }
-  /* collapse white space */
-  for (t = s; *t && soap_coblank((soap_wchar)*t); t++)
-    continue;
-  n = strlen(t);
-  if (insitu && s < t)
-    (void)soap_memmove(s, n + 1, t, n + 1);
-  else
-    s = t;
-  if (n > 0)
-  {
-    if (!soap_coblank((soap_wchar)s[n-1]))
-    {
-      for (t = s; (*t && !soap_coblank((soap_wchar)*t)) || (*t == 32 && (!t[1] || !soap_coblank((soap_wchar)t[1]))); t++)
-        continue;
-      if (!*t)
-        return s;
-    }
-    if (!insitu)
-      s = soap_strdup(soap, s);
-    for (t = s; *t; t++)
-    {
-      if (soap_coblank((soap_wchar)*t))
-      {
-        char *r;
-        *t = ' ';
-        for (r = t + 1; *r && soap_coblank((soap_wchar)*r); r++)
-          continue;
-        if (r > t + 1)
-          (void)soap_memmove(t + 1, n - (t-s), r, n - (r-s) + 1);
-      }
-    }
-    t--;
-    if (t >= s && *t == 32)
-      *t = '\0';
-  }
-  return s;
+  soap->omode &= ~SOAP_ENC_MIME;
+  soap->mime.first = NULL;
+  soap->mime.last = NULL;
+  soap->mime.boundary = NULL;
+  soap->mime.start = NULL;
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_s2QName(struct soap *soap, const char *s, char **t, long minlen, long maxlen, const char *pattern)
+#ifndef WITH_LEANER
+static int
+soap_begin_attachments(struct soap *soap)
 {
-  *t = NULL;
-  if (s)
+  if ((soap->mode & SOAP_ENC_MIME) && soap->mime.boundary && soap->mime.start)
   {
-    const char *r = soap_QName(soap, s, minlen, maxlen, pattern);
-    if (r && (*t = soap_strdup(soap, r)) == NULL)
+    const char *s;
+    if (strlen(soap->mime.boundary) + strlen(soap->mime.start) + 140 > sizeof(soap->tmpbuf))
       return soap->error = SOAP_EOM;
+    if ((soap->mode & SOAP_ENC_DIME) && !(soap->mode & SOAP_ENC_MTOM))
+    {
+      s = "application/dime";
+    }
+    else if (soap->version == 2)
+    {
+      if ((soap->mode & SOAP_ENC_MTOM))
+        s = "application/xop+xml; charset=utf-8; type=\"application/soap+xml\"";
+      else
+        s = "application/soap+xml; charset=utf-8";
+    }
+    else if ((soap->mode & SOAP_ENC_MTOM))
+    {
+      s = "application/xop+xml; charset=utf-8; type=\"text/xml\"";
+    }
+    else
+    {
+      s = "text/xml; charset=utf-8";
+    }
+    (SOAP_SNPRINTF_SAFE(soap->tmpbuf, sizeof(soap->tmpbuf)), "--%s\r\nContent-Type: %s\r\nContent-Transfer-Encoding: binary\r\nContent-ID: %s\r\n\r\n", soap->mime.boundary, s, soap->mime.start);
+    if (soap_send(soap, soap->tmpbuf))
+      return soap->error;
   }
-  return soap->error;
+  if ((soap->mode & SOAP_IO_LENGTH))
+    soap->dime.size = (size_t)soap->count; /* DIME in MIME correction, soap->count is small */
+  if (!(soap->mode & SOAP_IO_LENGTH) && (soap->mode & SOAP_ENC_DIME))
+  {
+    if (soap_putdimehdr(soap))
+      return soap->error;
+  }
+  return SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
-#ifndef WITH_COMPAT
-#ifdef __cplusplus
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_s2stdQName(struct soap *soap, const char *s, std::string *t, long minlen, long maxlen, const char *pattern)
+#ifndef WITH_LEANER
+static int
+soap_end_attachments(struct soap *soap)
 {
-  t->clear();
-  if (s)
+  if ((soap->mode & SOAP_IO_LENGTH) && (soap->mode & SOAP_ENC_DIME) && !(soap->mode & SOAP_ENC_MTOM))
   {
-    const char *r = soap_QName(soap, s, minlen, maxlen, pattern);
-    if (r)
-      t->assign(r);
+    if (soap->count > 0xFFFFFFFF)
+      return soap->error = SOAP_DIME_ERROR;
+    soap->dime.size = (size_t)soap->count - soap->dime.size;    /* DIME in MIME correction */
+    (SOAP_SNPRINTF(soap->id, sizeof(soap->id), strlen(soap->dime_id_format) + 20), soap->dime_id_format, 0);
+    soap->dime.id = soap->id;
+    if (soap->local_namespaces && soap->local_namespaces[0].id)
+    {
+      if (soap->local_namespaces[0].out)
+        soap->dime.type = (char*)soap->local_namespaces[0].out;
+      else
+        soap->dime.type = (char*)soap->local_namespaces[0].ns;
+    }
+    soap->dime.options = NULL;
+    soap->dime.flags = SOAP_DIME_MB | SOAP_DIME_ABSURI;
+    if (!soap->dime.first)
+      soap->dime.flags |= SOAP_DIME_ME;
+    soap->count += 12 + ((strlen(soap->dime.id)+3)&(~3)) + (soap->dime.type ? ((strlen(soap->dime.type)+3)&(~3)) : 0);
   }
-  return soap->error;
+  if ((soap->mode & SOAP_ENC_DIME) && !(soap->mode & SOAP_ENC_MTOM))
+    return soap_send_raw(soap, SOAP_STR_PADDING, -(long)soap->dime.size&3);
+  return SOAP_OK;
 }
 #endif
-#endif
 
 /******************************************************************************/
 
-static const char*
-soap_QName(struct soap *soap, const char *s, long minlen, long maxlen, const char *pattern)
+#ifndef WITH_LEANER
+static struct soap_multipart*
+soap_alloc_multipart(struct soap *soap, struct soap_multipart **first, struct soap_multipart **last, const char *ptr, size_t size)
 {
-  if (s)
+  struct soap_multipart *content;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "New DIME/MIME attachment %p (%lu)\n", (void*)ptr, (unsigned long)size));
+  content = (struct soap_multipart*)soap_malloc(soap, sizeof(struct soap_multipart));
+  if (content)
   {
-    char *b;
-    if (maxlen < 0 && soap->maxlength > 0)
-      maxlen = soap->maxlength;
-    if (minlen > 0 || maxlen >= 0)
-    {
-      size_t l;
-      if ((soap->mode & SOAP_C_UTFSTRING))
-        l = soap_utf8len(s);
-      else
-        l = strlen(s);
-      if ((maxlen >= 0 && l > (size_t)maxlen) || (minlen > 0 && l < (size_t)minlen))
-      {
-        soap->error = SOAP_LENGTH;
-        return NULL;
-      }
-    }
-#ifdef WITH_FAST
-    soap->labidx = 0;
-#else
-    if (soap_alloc_block(soap) == NULL)
-      return NULL;
-#endif
-    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Normalized namespace(s) of QNames '%s'", s));
-    /* convert (by prefix normalize prefix) all QNames in s */
-    for (;;)
-    {
-      size_t n;
-      struct soap_nlist *np;
-      const char *p = NULL;
-      short flag = 0;
-      const char *r = NULL;
-      size_t m = 0;
-#ifndef WITH_FAST
-      size_t k = 0;
-#endif
-      /* skip blanks */
-      while (*s && soap_coblank((soap_wchar)*s))
-        s++;
-      if (!*s)
-        break;
-      /* find next QName */
-      n = 1;
-      while (s[n] && !soap_coblank((soap_wchar)s[n]))
-        n++;
-      np = soap->nlist;
-      /* if there is no namespace stack, or prefix is "#" or "xml" then copy string */
-      if (!np || *s == '#' || !strncmp(s, "xml:", 4))
-      {
-        r = s;
-        m = n;
-      }
-      else /* we normalize the QName by replacing its prefix */
-      {
-        const char *q;
-        for (p = s; *p && p < s + n; p++)
-          if (*p == ':')
-            break;
-        if (*p == ':')
-        {
-          size_t k = p - s;
-          while (np && (strncmp(np->id, s, k) || np->id[k]))
-            np = np->next;
-          p++;
-        }
-        else
-        {
-          while (np && *np->id)
-            np = np->next;
-          p = s;
-        }
-        /* replace prefix */
-        if (np)
-        {
-          if (np->index >= 0 && soap->local_namespaces && (q = soap->local_namespaces[np->index].id) != NULL)
-          {
-            size_t k = strlen(q);
-            if (q[k-1] != '_')
-            {
-              r = q;
-              m = k;
-            }
-            else
-            {
-              flag = 1;
-              r = soap->local_namespaces[np->index].ns;
-              m = strlen(r);
-            }
-          }
-          else if (np->ns)
-          {
-            flag = 1;
-            r = np->ns;
-            m = strlen(r);
-          }
-          else
-          {
-            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "\nNamespace prefix of '%s' not defined (index=%d, URI='%s')\n", s, np->index, np->ns ? np->ns : SOAP_STR_EOS));
-            soap->error = SOAP_NAMESPACE;
-            return NULL;
-          }
-        }
-        else if (s[n]) /* no namespace, part of string */
-        {
-          r = s;
-          m = n;
-        }
-        else /* no namespace: assume "" namespace */
-        {
-          flag = 1;
-        }
-      }
-#ifdef WITH_FAST
-      if ((flag && soap_append_lab(soap, "\"", 1))
-       || (m && soap_append_lab(soap, r, m))
-       || (flag && soap_append_lab(soap, "\"", 1))
-       || (p && (soap_append_lab(soap, ":", 1) || soap_append_lab(soap, p, n - (p-s)))))
-         return NULL;
-#else
-      k = 2*flag + m + (p ? n - (p-s) + 1 : 0) + (s[n] != '\0');
-      b = (char*)soap_push_block(soap, NULL, k);
-      if (!b)
-        return NULL;
-      if (flag)
-        *b++ = '"';
-      if (m)
-      {
-        if (soap_memcpy((void*)b, k, (const void*)r, m))
-        {
-          soap->error = SOAP_EOM;
-          return NULL;
-        }
-        b += m;
-      }
-      if (flag)
-        *b++ = '"';
-      if (p)
-      {
-        *b++ = ':';
-        if (soap_memcpy((void*)b, k - m - flag - 1, (const void*)p, n - (p-s)))
-        {
-          soap->error = SOAP_EOM;
-          return NULL;
-        }
-        b += n - (p-s);
-      }
+    content->next = NULL;
+    content->ptr = ptr;
+    content->size = size;
+    content->id = NULL;
+    content->type = NULL;
+    content->options = NULL;
+    content->encoding = SOAP_MIME_NONE;
+    content->location = NULL;
+    content->description = NULL;
+    if (!*first)
+      *first = content;
+    if (*last)
+      (*last)->next = content;
+    *last = content;
+  }
+  return content;
+}
 #endif
-      /* advance to next and add spacing */
-      s += n;
-      while (*s && soap_coblank(*s))
-        s++;
-      if (*s)
-      {
-#ifdef WITH_FAST
-        if (soap_append_lab(soap, " ", 1))
-          return NULL;
-#else
-        *b = ' ';
+
+/******************************************************************************/
+
+#ifndef WITH_LEANER
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_set_dime_attachment(struct soap *soap, const char *ptr, size_t size, const char *type, const char *id, unsigned short optype, const char *option)
+{
+  struct soap_multipart *content = soap_alloc_multipart(soap, &soap->dime.first, &soap->dime.last, ptr, size);
+  if (!content)
+    return SOAP_EOM;
+  content->id = soap_strdup(soap, id);
+  content->type = soap_strdup(soap, type);
+  content->options = soap_dime_option(soap, optype, option);
+  return SOAP_OK;
+}
 #endif
-      }
-    }
-#ifdef WITH_FAST
-    if (soap_append_lab(soap, SOAP_STR_EOS, 1))
-      return NULL;
-    b = soap->labbuf;
-#else
-    b = (char*)soap_push_block(soap, NULL, 1);
-    if (!b)
-      return NULL;
-    *b = '\0';
-    b = (char*)soap_save_block(soap, NULL, NULL, 0);
+
+/******************************************************************************/
+
+#ifndef WITH_LEANER
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_set_mime_attachment(struct soap *soap, const char *ptr, size_t size, enum soap_mime_encoding encoding, const char *type, const char *id, const char *location, const char *description)
+{
+  struct soap_multipart *content = soap_alloc_multipart(soap, &soap->mime.first, &soap->mime.last, ptr, size);
+  if (!content)
+    return SOAP_EOM;
+  content->id = soap_strdup(soap, id);
+  content->type = soap_strdup(soap, type);
+  content->encoding = encoding;
+  content->location = soap_strdup(soap, location);
+  content->description = soap_strdup(soap, description);
+  return SOAP_OK;
+}
 #endif
+
+/******************************************************************************/
+
 #ifndef WITH_LEANER
-    if (pattern && soap->fsvalidate)
+SOAP_FMAC1
+struct soap_multipart*
+SOAP_FMAC2
+soap_next_multipart(struct soap_multipart *content)
+{
+  if (content)
+    return content->next;
+  return NULL;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEANER
+static void
+soap_select_mime_boundary(struct soap *soap)
+{
+  while (!soap->mime.boundary || soap_valid_mime_boundary(soap))
+  {
+    char *s = soap->mime.boundary;
+    size_t n = 0;
+    if (s)
+      n = strlen(s);
+    if (n < 16)
     {
-      soap->error = soap->fsvalidate(soap, pattern, b);
-      if (soap->error)
-        return NULL;
+      n = 64;
+      s = soap->mime.boundary = (char*)soap_malloc(soap, n + 1);
+      if (!s)
+        return;
     }
-#else
-    (void)pattern;
-#endif
-    return b;
+    *s++ = '=';
+    *s++ = '=';
+    n -= 4;
+    while (n)
+    {
+      *s++ = soap_base64o[soap_random & 0x3F];
+      n--;
+    }
+    *s++ = '=';
+    *s++ = '=';
+    *s = '\0';
   }
-  return NULL;
+  if (!soap->mime.start)
+    soap->mime.start = "<SOAP-ENV:Envelope>";
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-const char*
-SOAP_FMAC2
-soap_QName2s(struct soap *soap, const char *s)
+#ifndef WITH_LEANER
+static int
+soap_valid_mime_boundary(struct soap *soap)
 {
-  const char *t = NULL;
-  if (s)
+  struct soap_multipart *content;
+  size_t k;
+  if (soap->fmimeread)
+    return SOAP_OK;
+  k = strlen(soap->mime.boundary);
+  for (content = soap->mime.first; content; content = content->next)
   {
-#ifdef WITH_FAST
-    soap_store_lab(soap, SOAP_STR_EOS, 1);
-    soap->labidx = 0;
-#else
-    char *b = NULL;
-    if (soap_alloc_block(soap) == NULL)
-      return NULL;
-#endif
-    for (;;)
+    if (content->ptr && content->size >= k)
     {
-      size_t n;
-      const char *q = NULL;
-      const char *r = NULL;
-      size_t m = 0;
-#ifndef WITH_FAST
-      size_t k = 0;
-#endif
-      /* skip blanks */
-      while (*s && soap_coblank((soap_wchar)*s))
-        s++;
-      if (!*s)
-      {
-#ifdef WITH_FAST
-        soap->labbuf[soap->labidx > 0 ? soap->labidx - 1 : 0] = '\0';
-#else
-        if (!b)
-          return soap_strdup(soap, SOAP_STR_EOS);
-        --b;
-        *b = '\0';
-#endif
-        break;
-      }
-      /* find next QName */
-      n = 0;
-      while (s[n] && !soap_coblank((soap_wchar)s[n]))
-      {
-        if (s[n] == ':')
-          r = s;
-        n++;
-      }
-      if (*s != '"') /* non-quoted: pass string as is */
-      {
-#ifndef WITH_LEAN
-        if (r && (soap->mode & SOAP_XML_CANONICAL) && !(soap->mode & SOAP_XML_CANONICAL_NA))
-          soap_utilize_ns(soap, s, 1);
-#endif
-        r = s;
-        m = n + 1;
-      }
-      else /* prefix quoted URI-based string */
-      {
-        q = strchr(s + 1, '"');
-        if (q)
-        {
-          struct Namespace *p = soap->local_namespaces;
-          if (p)
-          {
-            for (; p->id; p++)
-            {
-              if (p->ns)
-                if (!soap_tag_cmp(s + 1, p->ns))
-                  break;
-              if (p->in)
-                if (!soap_tag_cmp(s + 1, p->in))
-                  break;
-            }
-          }
-          q++;
-          /* URL is in the namespace table? */
-          if (p && p->id)
-          {
-            r = p->id;
-            m = strlen(r);
-          }
-          else /* not in namespace table: create xmlns binding */
-          {
-            char *x = soap_strdup(soap, s + 1);
-            if (!x)
-              return NULL;
-            x[q - s - 2] = '\0';
-            (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), 27), "xmlns:_%d", soap->idnum++);
-            soap_set_attr(soap, soap->tmpbuf, x, 1);
-            r = soap->tmpbuf + 6;
-            m = strlen(r);
-          }
-        }
-      }
-      /* copy normalized QName into buffer, including the ending blank or NUL */
-#ifdef WITH_FAST
-      if ((m && soap_append_lab(soap, r, m))
-       || (q && soap_append_lab(soap, q, n - (q - s) + 1)))
-        return NULL;
-#else
-      k = m + (q ? n - (q - s) + 1 : 0);
-      b = (char*)soap_push_block(soap, NULL, k);
-      if (!b)
-      {
-        soap->error = SOAP_EOM;
-        return NULL;
-      }
-      if (soap_memcpy((void*)b, k, (const void*)r, m))
-      {
-        soap->error = SOAP_EOM;
-        return NULL;
-      }
-      b += m;
-      if (q)
+      const char *p = (const char*)content->ptr;
+      size_t i;
+      for (i = 0; i < content->size - k; i++, p++)
       {
-        if (soap_memcpy((void*)b, k - m, (const void*)q, n - (q - s) + 1))
-        {
-          soap->error = SOAP_EOM;
-          return NULL;
-        }
-        b += n - (q - s) + 1;
+        if (!strncmp(p, soap->mime.boundary, k))
+          return SOAP_ERR;
       }
+    }
+  }
+  return SOAP_OK;
+}
 #endif
-      /* advance to next */
-      s += n;
-    }
-#ifdef WITH_FAST
-    t = soap_strdup(soap, soap->labbuf);
-    if (!t)
-      soap->error = SOAP_EOM;
-#else
-    t = (char*)soap_save_block(soap, NULL, NULL, 0);
-#endif
+
+/******************************************************************************/
+
+#ifdef WITH_GZIP
+static int
+soap_getgziphdr(struct soap *soap)
+{
+  int i;
+  soap_wchar c = 0, f = 0;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Get gzip header\n"));
+  for (i = 0; i < 9; i++)
+  {
+    c = soap_get1(soap);
+    if (i == 1 && c == 8)
+      soap->z_dict = 0;
+    if (i == 2)
+      f = c;
   }
-  return t;
+  if (f & 0x04) /* FEXTRA */
+  {
+    i = soap_get1(soap);
+    i |= soap_get1(soap) << 8;
+    while (i-- > 0)
+    {
+      if ((int)soap_get1(soap) == EOF)
+        return soap->error = SOAP_ZLIB_ERROR;
+    }
+  }
+  if (f & 0x08) /* skip FNAME */
+  {
+    do
+    {
+      c = soap_get1(soap);
+    } while (c && (int)c != EOF);
+  }
+  if ((int)c != EOF && (f & 0x10)) /* skip FCOMMENT */
+  {
+    do
+    {
+      c = soap_get1(soap);
+    } while (c && (int)c != EOF);
+  }
+  if ((int)c != EOF && (f & 0x02)) /* skip FHCRC (CRC32 is used) */
+  {
+    c = soap_get1(soap);
+    if ((int)c != EOF)
+      c = soap_get1(soap);
+  }
+  if ((int)c == EOF)
+    return soap->error = SOAP_ZLIB_ERROR;
+  return SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_s2wchar(struct soap *soap, const char *s, wchar_t **t, int flag, long minlen, long maxlen, const char *pattern)
+soap_begin_serve(struct soap *soap)
 {
-  if (s)
+#ifdef WITH_FASTCGI
+  if (FCGI_Accept() < 0)
   {
-    const wchar_t *r = soap_wstring(soap, s, flag, minlen, maxlen, pattern);
-    if (r && (*t = soap_wstrdup(soap, r)) == NULL)
-      return soap->error = SOAP_EOM;
+    soap->error = SOAP_EOF;
+    return soap_send_fault(soap);
   }
-  return soap->error;
-}
 #endif
+  soap_begin(soap);
+  if (soap_begin_recv(soap)
+   || soap_envelope_begin_in(soap)
+   || soap_recv_header(soap)
+   || soap_body_begin_in(soap))
+  {
+    if (soap->error < SOAP_STOP)
+    {
+#ifdef WITH_FASTCGI
+      (void)soap_send_fault(soap);
+#else
+      return soap_send_fault(soap);
+#endif
+    }
+    return soap_closesock(soap);
+  }
+  return SOAP_OK;
+}
 
 /******************************************************************************/
 
-#ifndef WITH_COMPAT
-#ifdef __cplusplus
-#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_s2stdwchar(struct soap *soap, const char *s, std::wstring *t, int flag, long minlen, long maxlen, const char *pattern)
+soap_begin_recv(struct soap *soap)
 {
-  if (s)
+  soap_wchar c;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Initializing for input from socket=%d/fd=%d\n", (int)soap->socket, soap->recvfd));
+  soap->error = SOAP_OK;
+#ifndef WITH_LEANER
+  soap->recverror = SOAP_OK;
+#endif
+  soap_free_temp(soap);
+  soap_set_local_namespaces(soap);
+  soap->version = 0;    /* don't assume we're parsing SOAP content by default */
+#ifndef WITH_NOIDREF
+  soap_free_iht(soap);
+#endif
+  if ((soap->imode & SOAP_IO) == SOAP_IO_CHUNK)
   {
-    const wchar_t *r = soap_wstring(soap, s, flag, minlen, maxlen, pattern);
-    if (r)
-      t->assign(r);
+    soap->imode &= ~SOAP_IO;
+    soap->omode = (soap->omode & ~SOAP_IO) | SOAP_IO_CHUNK;
+  }
+  soap->imode &= ~(SOAP_ENC_DIME | SOAP_ENC_MIME | SOAP_ENC_ZLIB);
+  soap->mode = soap->imode;
+  if (!(soap->mode & SOAP_IO_KEEPALIVE))
+    soap->keep_alive = 0;
+  if (!soap->keep_alive)
+    soap->buflen = soap->bufidx = 0;
+  soap->null = 0;
+  soap->position = 0;
+  soap->mustUnderstand = 0;
+  soap->shaky = 0;
+  soap->ahead = 0;
+  soap->peeked = 0;
+  soap->level = 0;
+  soap->part = SOAP_BEGIN_RECV;
+  soap->count = 0;
+  soap->length = 0;
+  soap->cdata = 0;
+  if (!(soap->mode & SOAP_ENC_PLAIN))
+  {
+    *soap->endpoint = '\0';
+    soap->action = NULL;
+    soap->fform = NULL;
+  }
+  soap->header = NULL;
+  soap->fault = NULL;
+  soap->status = 0;
+  soap->body = 1;
+#ifndef WITH_LEANER
+  soap->dom = NULL;
+  soap->dime.count = 0;
+  soap->dime.chunksize = 0;
+  soap->dime.buflen = 0;
+  soap->dime.list = NULL;
+  soap->dime.first = NULL;
+  soap->dime.last = NULL;
+  soap->mime.list = NULL;
+  soap->mime.first = NULL;
+  soap->mime.last = NULL;
+  soap->mime.boundary = NULL;
+  soap->mime.start = NULL;
+#endif
+#ifdef WIN32
+#ifndef UNDER_CE
+#ifndef WITH_FASTCGI
+  if (!soap_valid_socket(soap->socket) && !soap->is && soap->recvfd >= 0) /* Set win32 stdin or soap->recvfd to BINARY, e.g. to support DIME */
+#ifdef __BORLANDC__
+    setmode(soap->recvfd, _O_BINARY);
+#else
+    _setmode(soap->recvfd, _O_BINARY);
+#endif
+#endif
+#endif
+#endif
+#ifdef WITH_ZLIB
+  soap->zlib_in = SOAP_ZLIB_NONE;
+  soap->zlib_out = SOAP_ZLIB_NONE;
+  if (!soap->d_stream)
+  {
+    soap->d_stream = (z_stream*)SOAP_MALLOC(soap, sizeof(z_stream));
+    if (!soap->d_stream)
+      return soap->error = SOAP_EOM;
+    soap->d_stream->zalloc = Z_NULL;
+    soap->d_stream->zfree = Z_NULL;
+    soap->d_stream->opaque = Z_NULL;
+    soap->d_stream->next_in = Z_NULL;
+    soap->d_stream->msg = Z_NULL;
+  }
+  soap->d_stream->avail_in = 0;
+  soap->d_stream->next_out = (Byte*)soap->buf;
+  soap->d_stream->avail_out = sizeof(soap->buf);
+  soap->z_ratio_in = 1.0;
+#endif
+#ifdef WITH_OPENSSL
+  if (soap->ssl)
+    ERR_clear_error();
+#endif
+#ifndef WITH_LEAN
+  soap->start = (ULONG64)time(NULL);
+#endif
+#ifndef WITH_LEANER
+  if (soap->fprepareinitrecv && (soap->error = soap->fprepareinitrecv(soap)) != SOAP_OK)
+    return soap->error;
+#endif
+  c = soap_getchar(soap);
+#ifdef WITH_GZIP
+  if (c == 0x1F)
+  {
+    if (soap_getgziphdr(soap))
+      return soap->error;
+    if (inflateInit2(soap->d_stream, -MAX_WBITS) != Z_OK)
+      return soap->error = SOAP_ZLIB_ERROR;
+    if (soap->z_dict)
+    {
+      if (inflateSetDictionary(soap->d_stream, (const Bytef*)soap->z_dict, soap->z_dict_len) != Z_OK)
+        return soap->error = SOAP_ZLIB_ERROR;
+    }
+    soap->zlib_state = SOAP_ZLIB_INFLATE;
+    soap->mode |= SOAP_ENC_ZLIB;
+    soap->zlib_in = SOAP_ZLIB_GZIP;
+    soap->z_crc = crc32(0L, NULL, 0);
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "gzip initialized\n"));
+    if (!soap->z_buf)
+      soap->z_buf = (char*)SOAP_MALLOC(soap, sizeof(soap->buf));
+    (void)soap_memcpy((void*)soap->z_buf, sizeof(soap->buf), (const void*)soap->ibuf, soap->buflen);
+    /* should not chunk over plain transport, so why bother to check? */
+    /* if ((soap->mode & SOAP_IO) == SOAP_IO_CHUNK) */
+    /*   soap->z_buflen = soap->bufidx; */
+    /* else */
+    soap->d_stream->next_in = (Byte*)(soap->z_buf + soap->bufidx);
+    soap->d_stream->avail_in = (unsigned int)(soap->buflen - soap->bufidx);
+    soap->z_buflen = soap->buflen;
+    soap->buflen = soap->bufidx;
+    c = ' ';
+  }
+#endif
+  while (soap_coblank(c))
+    c = soap_getchar(soap);
+#ifndef WITH_LEANER
+  if (c == '-' && soap_get0(soap) == '-')
+  {
+    soap->mode |= SOAP_ENC_MIME;
+  }
+  else if ((c & 0xFFFC) == (SOAP_DIME_VERSION | SOAP_DIME_MB) && (soap_get0(soap) & 0xFFF0) == 0x20)
+  {
+    soap->mode |= SOAP_ENC_DIME;
+  }
+  else
+#endif
+  {
+    /* skip BOM */
+    if (c == 0xEF && soap_get0(soap) == 0xBB)
+    {
+      soap_get1(soap);
+      c = soap_get1(soap);
+      if (c == 0xBF)
+      {
+        soap->mode &= ~SOAP_ENC_LATIN;
+        c = soap_getchar(soap);
+      }
+      else
+      {
+        c = (0x0F << 12) | (0xBB << 6) | (c & 0x3F); /* UTF-8 */
+      }
+    }
+    else if ((c == 0xFE && soap_get0(soap) == 0xFF)  /* UTF-16 BE */
+          || (c == 0xFF && soap_get0(soap) == 0xFE)) /* UTF-16 LE */
+    {
+      return soap->error = SOAP_UTF_ERROR;
+    }
+    /* skip space */
+    while (soap_coblank(c))
+      c = soap_getchar(soap);
   }
-  return soap->error;
-}
-#endif
-#endif
-#endif
-
-/******************************************************************************/
-
-#ifndef WITH_LEAN
-static const wchar_t*
-soap_wstring(struct soap *soap, const char *s, int flag, long minlen, long maxlen, const char *pattern)
-{
-  if (s)
+  if ((int)c == EOF)
+    return soap->error = SOAP_CHK_EOF;
+  soap_unget(soap, c);
+#ifndef WITH_NOHTTP
+  /* if not XML/MIME/DIME/ZLIB, assume HTTP method or status line */
+  if (((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) && !(soap->mode & (SOAP_ENC_MIME | SOAP_ENC_DIME | SOAP_ENC_ZLIB | SOAP_ENC_PLAIN)))
   {
-    size_t l;
-    soap_wchar c;
-    wchar_t *t;
-    if (maxlen < 0 && soap->maxlength > 0)
-      maxlen = soap->maxlength;
-    soap->labidx = 0;
-    if ((soap->mode & SOAP_ENC_LATIN))
+    soap_mode m = soap->imode;
+    soap->error = soap->fparse(soap);
+    soap->mode = soap->imode; /* if imode is changed, effectuate */
+    soap->imode = m; /* restore imode */
+    if ((soap->mode & SOAP_IO) == SOAP_IO_CHUNK)
     {
-      wchar_t *r;
-      if (soap_append_lab(soap, NULL, sizeof(wchar_t) * (strlen(s) + 1)))
-        return NULL;
-      r = (wchar_t*)(void*)soap->labbuf;
-      while (*s)
-        *r++ = (wchar_t)*s++;
+      soap->chunkbuflen = soap->buflen;
+      soap->buflen = soap->bufidx;
+      soap->chunksize = 0;
     }
-    else
+#ifdef WITH_ZLIB
+    soap->mode &= ~SOAP_ENC_ZLIB;
+    if (soap->zlib_in != SOAP_ZLIB_NONE)
     {
-      /* Convert UTF8 to wchar_t */
-      while (*s)
+#ifdef WITH_GZIP
+      if (soap->zlib_in != SOAP_ZLIB_DEFLATE)
       {
-        c = (unsigned char)*s++;
-        if (c >= 0x80)
-        {
-#ifdef WITH_REPLACE_ILLEGAL_UTF8
-          soap_wchar c1, c2, c3;
-          c1 = (unsigned char)*s;
-          if (c <= 0xC1 || (c1 & 0xC0) != 0x80)
-          {
-            c = SOAP_UNKNOWN_UNICODE_CHAR;
-          }
-          else
-          {
-            ++s;
-            c1 &= 0x3F;
-            if (c < 0xE0)
-            {
-              c = (((c & 0x1F) << 6) | c1);
-            }
-            else
-            {
-              c2 = (unsigned char)*s;
-              if ((c == 0xE0 && c1 < 0x20) || (c2 & 0xC0) != 0x80)
-              {
-                c = SOAP_UNKNOWN_UNICODE_CHAR;
-              }
-              else
-              {
-                ++s;
-                c2 &= 0x3F;
-                if (c < 0xF0)
-                {
-                  c = (((c & 0x0F) << 12) | (c1 << 6) | c2);
-                }
-                else
-                {
-                  c3 = (unsigned char)*s;
-                  if ((c == 0xF0 && c1 < 0x10) || (c == 0xF4 && c1 >= 0x10) || c >= 0xF5 || (c3 & 0xC0) != 0x80)
-                  {
-                    c = SOAP_UNKNOWN_UNICODE_CHAR;
-                  }
-                  else
-                  {
-                    ++s;
-                    c = (((c & 0x07) << 18) | (c1 << 12) | (c2 << 6) | (c3 & 0x3F));
-                  }
-                }
-              }
-            }
-          }
-#else
-          soap_wchar c1, c2, c3, c4;
-          c1 = (unsigned char)*s;
-          if (c1)
-          {
-            s++;
-            c1 &= 0x3F;
-            if (c < 0xE0)
-            {
-              c = (wchar_t)(((soap_wchar)(c & 0x1F) << 6) | c1);
-            }
-            else
-            {
-              c2 = (unsigned char)*s;
-              if (c2)
-              {
-                s++;
-                c2 &= 0x3F;
-                if (c < 0xF0)
-                {
-                  c = (wchar_t)(((soap_wchar)(c & 0x0F) << 12) | (c1 << 6) | c2);
-                }
-                else
-                {
-                  c3 = (unsigned char)*s;
-                  if (c3)
-                  {
-                    s++;
-                    c3 &= 0x3F;
-                    if (c < 0xF8)
-                    {
-                      c = (wchar_t)(((soap_wchar)(c & 0x07) << 18) | (c1 << 12) | (c2 << 6) | c3);
-                    }
-                    else
-                    {
-                      c4 = (unsigned char)*s;
-                      if (c4)
-                      {
-                        s++;
-                        c4 &= 0x3F;
-                        if (c < 0xFC)
-                        {
-                          c = (wchar_t)(((soap_wchar)(c & 0x03) << 24) | (c1 << 18) | (c2 << 12) | (c3 << 6) | c4);
-                        }
-                        else
-                        {
-                          c = (wchar_t)(((soap_wchar)(c & 0x01) << 30) | (c1 << 24) | (c2 << 18) | (c3 << 12) | (c4 << 6) | (unsigned char)(*s & 0x3F));
-                          if (*s)
-                            s++;
-                        }
-                      }
-                    }
-                  }
-                }
-              }
-            }
-          }
-#endif
-        }
-        /* use UTF16 encoding when wchar_t is too small to hold UCS */
-        if (sizeof(wchar_t) < 4 && c > 0xFFFF)
+        c = soap_get1(soap);
+        if (c == (int)EOF)
+          return soap->error = SOAP_EOF;
+        if (c == 0x1F)
         {
-          wchar_t c1, c2;
-          c1 = 0xD800 - (0x10000 >> 10) + (c >> 10);
-          c2 = 0xDC00 + (c & 0x3FF);
-          if (soap_append_lab(soap, (const char*)&c1, sizeof(wchar_t)) || soap_append_lab(soap, (const char*)&c2, sizeof(wchar_t)))
-            return NULL;
+          if (soap_getgziphdr(soap))
+            return soap->error;
+          if (inflateInit2(soap->d_stream, -MAX_WBITS) != Z_OK)
+            return soap->error = SOAP_ZLIB_ERROR;
+          soap->z_crc = crc32(0L, NULL, 0);
+          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "gzip initialized\n"));
         }
-        else if (soap_append_lab(soap, (const char*)&c, sizeof(wchar_t)))
+        else
         {
-          return NULL;
+          soap_revget1(soap);
+          if (inflateInit(soap->d_stream) != Z_OK)
+            return soap->error = SOAP_ZLIB_ERROR;
+          soap->zlib_in = SOAP_ZLIB_DEFLATE;
         }
       }
+      else
+#endif
+      if (inflateInit(soap->d_stream) != Z_OK)
+        return soap->error = SOAP_ZLIB_ERROR;
+      if (soap->z_dict)
+      {
+        if (inflateSetDictionary(soap->d_stream, (const Bytef*)soap->z_dict, soap->z_dict_len) != Z_OK)
+          return soap->error = SOAP_ZLIB_ERROR;
+      }
+      soap->zlib_state = SOAP_ZLIB_INFLATE;
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Inflate initialized\n"));
+      soap->mode |= SOAP_ENC_ZLIB;
+      if (!soap->z_buf)
+        soap->z_buf = (char*)SOAP_MALLOC(soap, sizeof(soap->buf));
+      /* the chunked body that was read extends to chunkbuflen, past the current chunk that ends at buflen */
+      (void)soap_memcpy((void*)soap->z_buf, sizeof(soap->buf), (const void*)soap->ibuf, (soap->mode & SOAP_IO) == SOAP_IO_CHUNK && soap->chunkbuflen > soap->buflen ? soap->chunkbuflen : soap->buflen);
+      soap->d_stream->next_in = (Byte*)(soap->z_buf + soap->bufidx);
+      soap->d_stream->avail_in = (unsigned int)(soap->buflen - soap->bufidx);
+      soap->z_buflen = soap->buflen;
+      soap->buflen = soap->bufidx;
+    }
+#endif
+#ifndef WITH_LEANER
+    if (soap->fpreparerecv && (soap->mode & SOAP_IO) != SOAP_IO_CHUNK && soap->buflen > soap->bufidx)
+    {
+      int r;
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Invoking fpreparerecv\n"));
+      r = soap->fpreparerecv(soap, soap->ibuf + soap->bufidx, soap->buflen - soap->bufidx);
+      if (r)
+        return soap->error = r;
+    }
+#endif
+    if (soap->error && soap->error < SOAP_STOP)
+    {
+      if (soap->status >= 200 && soap->status < 600)
+      {
+        const char *s = soap_http_get_body(soap, NULL);
+        (void)soap_end_recv(soap);
+        if (soap->status >= 300)
+          soap->keep_alive = 0; /* to force close */
+        return soap_set_receiver_error(soap, "HTTP Error", s, soap->status);
+      }
+      return soap->error;
+    }
+    if (!soap->body && soap->status >= 200 && soap->status < 600)
+      return soap->error = soap->status; /* client side received HTTP status code */
+    if (soap->status > SOAP_POST)
+    {
+      soap->fform = NULL;
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Invoking http method handler\n"));
+      switch (soap->status)
+      {
+        case SOAP_GET:
+          if (soap_http_skip_body(soap) || soap_end_recv(soap))
+            return soap->error;
+          soap->error = soap->fget(soap);
+          break;
+        case SOAP_PUT:
+          soap->error = soap->fput(soap);
+          break;
+        case SOAP_PATCH:
+          soap->error = soap->fpatch(soap);
+          break;
+        case SOAP_DEL:
+          if (soap_http_skip_body(soap) || soap_end_recv(soap))
+            return soap->error;
+          soap->error = soap->fdel(soap);
+          break;
+        case SOAP_HEAD:
+          if (soap_http_skip_body(soap) || soap_end_recv(soap))
+            return soap->error;
+          soap->error = soap->fhead(soap);
+          break;
+        case SOAP_OPTIONS:
+          if (soap_http_skip_body(soap) || soap_end_recv(soap))
+            return soap->error;
+          soap->error = soap->fopt(soap);
+          break;
+        default:
+          if (soap_http_skip_body(soap) || soap_end_recv(soap))
+            return soap->error;
+          return 405;
+      }
+      if (soap->error == SOAP_OK)
+        return soap->error = SOAP_STOP; /* prevents further processing and calls soap_closesock() */
+      if (soap->error != SOAP_FORM || !soap->fform) /* continue if handler returned SOAP_FORM */
+        return soap->error;
+      soap->error = SOAP_OK;
     }
-    l = soap->labidx / sizeof(wchar_t);
-    c = L'\0';
-    if (soap_append_lab(soap, (const char*)&c, sizeof(wchar_t)))
-      return NULL;
-    if ((maxlen >= 0 && l > (size_t)maxlen) || (minlen > 0 && l < (size_t)minlen))
-    {
-      soap->error = SOAP_LENGTH;
-      return NULL;
-    }
-    t = (wchar_t*)(void*)soap->labbuf;
-#ifndef WITH_LEAN
-    if (flag >= 4 && t)
-      t = soap_wcollapse(soap, t, flag, 1);
-#endif
-#ifndef WITH_LEANER
-    if (pattern && soap->fwvalidate)
+    if (soap->fform)
     {
-      soap->error = soap->fwvalidate(soap, pattern, t);
-      if (soap->error)
-        return NULL;
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Invoking http post/form handler\n"));
+      soap->error = soap->fform(soap);
+      soap->fform = NULL;
+      if (soap->error == SOAP_OK)
+        return soap->error = SOAP_STOP; /* prevents further processing */
+      if (soap->status != SOAP_POST || soap->error != 404) /* continue with POST if handler returned HTTP not found */
+        return soap->error;
+      soap->error = SOAP_OK;
     }
-#endif
-    return t;
+    if (!soap->body)
+      return soap->error = SOAP_NO_DATA;
   }
-  return NULL;
-}
-#endif
-
-/******************************************************************************/
-
-#ifndef WITH_LEAN
-static wchar_t*
-soap_wcollapse(struct soap *soap, wchar_t *s, int flag, int insitu)
-{
-  /* flag 4=normalizedString (replace), 5=token (collapse) */
-  wchar_t *t;
-  size_t n;
-  if (!s)
-    return NULL;
-  if (flag == 4)
+  else if (soap->fform)
   {
-    for (t = s; *t && (!soap_coblank((soap_wchar)*t) || *t == 32); t++)
-      continue;
-    if (*t)
-    {
-      /* replace blanks and control char by space */
-      if (!insitu)
-        s = soap_wstrdup(soap, s);
-      if (s)
-        for (t = s; *t; t++)
-          if (soap_coblank((soap_wchar)*t))
-            *t = L' ';
-    }
-    return s;
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Invoking http form handler\n"));
+    soap->error = soap->fform(soap);
+    soap->fform = NULL;
+    if (soap->error == SOAP_OK)
+      return soap->error = SOAP_STOP; /* prevents further processing */
+    if (soap->error != 404) /* continue with POST if handler returned HTTP not found */
+      return soap->error;
+    soap->error = SOAP_OK;
   }
-  /* collapse white space */
-  for (t = s; *t && soap_coblank((soap_wchar)*t); t++)
-    continue;
-  n = 0;
-  while (t[n])
-    n++;
-  if (insitu && s < t)
-    (void)soap_memmove(s, n + 1, t, n + 1);
-  else
-    s = t;
-  if (n > 0)
+#endif
+#ifndef WITH_LEANER
+  if ((soap->mode & SOAP_ENC_MIME))
   {
-    if (!soap_coblank((soap_wchar)s[n-1]))
+    do /* skip preamble */
     {
-      for (t = s; (*t && !soap_coblank((soap_wchar)*t)) || (*t == 32 && (!t[1] || !soap_coblank((soap_wchar)t[1]))); t++)
-        continue;
-      if (!*t)
-        return s;
-    }
-    if (!insitu)
-      s = soap_wstrdup(soap, s);
-    if (s)
+      c = soap_getchar(soap);
+      if ((int)c == EOF)
+        return soap->error = SOAP_CHK_EOF;
+    } while (c != '-' || soap_get0(soap) != '-');
+    soap_unget(soap, c);
+    if (soap_getmimehdr(soap))
+      return soap->error;
+    if (soap->mime.start)
     {
-      for (t = s; *t; t++)
+      do
       {
-        if (soap_coblank((soap_wchar)*t))
-        {
-          wchar_t *r;
-          *t = L' ';
-          for (r = t + 1; *r && soap_coblank((soap_wchar)*r); r++)
-            continue;
-          if (r > t + 1)
-            (void)soap_memmove(t + 1, sizeof(wchar_t) * (n - (t-s)), r, sizeof(wchar_t) * (n - (r-s) + 1));
-        }
-      }
-      t--;
-      if (t >= s && *t == 32)
-        *t = L'\0';
+        if (!soap->mime.last->id)
+          break;
+        if (!soap_match_cid(soap, soap->mime.start, soap->mime.last->id))
+          break;
+      } while (soap_recv_mime_attachment(soap, NULL));
     }
+    if (soap_http_header_attribute(soap, soap->mime.first->type, "application/dime"))
+      soap->mode |= SOAP_ENC_DIME;
   }
-  return s;
-}
-#endif
-
-/******************************************************************************/
-
-#ifndef WITH_LEAN
-SOAP_FMAC1
-const char*
-SOAP_FMAC2
-soap_wchar2s(struct soap *soap, const wchar_t *s)
-{
-  soap_wchar c;
-  char *r, *t;
-  const wchar_t *q = s;
-  size_t n = 0;
-  if (!s)
-    return NULL;
-  while ((c = *q++))
-  {
-    if (c > 0 && c < 0x80)
-      n++;
-    else
-#ifdef WITH_REPLACE_ILLEGAL_UTF8
-      n += 4;
-#else
-      n += 6;
-#endif
-  }
-  r = t = (char*)soap_malloc(soap, n + 1);
-  if (r)
+  if ((soap->mode & SOAP_ENC_DIME))
   {
-    /* Convert wchar to UTF8 (chars above U+10FFFF are silently converted, but should not be used) */
-    while ((c = *s++))
+    if (soap_getdimehdr(soap))
+      return soap->error;
+    if ((soap->dime.flags & SOAP_DIME_CF))
     {
-      if (c > 0 && c < 0x80)
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Chunked SOAP in DIME message\n"));
+      soap->dime.chunksize = soap->dime.size;
+      if (soap->buflen - soap->bufidx >= soap->dime.chunksize)
       {
-        *t++ = (char)c;
+        soap->dime.buflen = soap->buflen;
+        soap->buflen = soap->bufidx + soap->dime.chunksize;
       }
       else
       {
-        /* check for UTF16 encoding when wchar_t is too small to hold UCS */
-        if (sizeof(wchar_t) < 4 && (c & 0xFC00) == 0xD800)
-        {
-          soap_wchar d = *s;
-          if ((d & 0xFC00) == 0xDC00)
-          {
-            c = ((c - 0xD800) << 10) + (d - 0xDC00) + 0x10000;
-            s++;
-          }
-#ifdef WITH_REPLACE_ILLEGAL_UTF8
-          else
-          {
-            c = SOAP_UNKNOWN_UNICODE_CHAR; /* Malformed UTF-16 */
-          }
-#endif
-        }
-        if (c < 0x0800)
-        {
-          *t++ = (char)(0xC0 | ((c >> 6) & 0x1F));
-        }
-        else
-        {
-#ifdef WITH_REPLACE_ILLEGAL_UTF8
-          if (!((c >= 0x80 && c <= 0xD7FF) || (c >= 0xE000 && c <= 0xFFFD) || (c >= 0x10000 && c <= 0x10FFFF)))
-            c = SOAP_UNKNOWN_UNICODE_CHAR;
-#endif
-          if (c < 0x010000)
-          {
-            *t++ = (char)(0xE0 | ((c >> 12) & 0x0F));
-          }
-          else
-          {
-            if (c < 0x200000)
-            {
-              *t++ = (char)(0xF0 | ((c >> 18) & 0x07));
-            }
-            else
-            {
-              if (c < 0x04000000)
-              {
-                *t++ = (char)(0xF8 | ((c >> 24) & 0x03));
-              }
-              else
-              {
-                *t++ = (char)(0xFC | ((c >> 30) & 0x01));
-                *t++ = (char)(0x80 | ((c >> 24) & 0x3F));
-              }
-              *t++ = (char)(0x80 | ((c >> 18) & 0x3F));
-            }
-            *t++ = (char)(0x80 | ((c >> 12) & 0x3F));
-          }
-          *t++ = (char)(0x80 | ((c >> 6) & 0x3F));
-        }
-        *t++ = (char)(0x80 | (c & 0x3F));
+        soap->dime.chunksize -= soap->buflen - soap->bufidx;
       }
     }
-    *t = '\0';
+    soap->count = soap->buflen - soap->bufidx;
+    if (soap->recv_maxlength && soap->count > soap->recv_maxlength)
+      return soap->error = SOAP_EOF;
   }
-  return r;
+#endif
+#ifndef WITH_LEAN
+  if ((soap->bxml & SOAP_BXML_IN) && soap_bxml_begin(soap, &soap->bxml_in))
+    return soap->error;
+#endif
+  return SOAP_OK;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_envelope_begin_out(struct soap *soap)
+{
+  if (soap->version == 0)
+    return SOAP_OK;
+  soap->part = SOAP_IN_ENVELOPE;
+  return soap_element_begin_out(soap, "SOAP-ENV:Envelope", 0, NULL);
 }
-#endif
 
 /******************************************************************************/
 
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_outstring(struct soap *soap, const char *tag, int id, char *const*p, const char *type, int n)
+soap_envelope_end_out(struct soap *soap)
 {
-  id = soap_element_id(soap, tag, id, *p, NULL, 0, type, n, NULL);
-  if (id < 0)
+  if (soap->version == 0)
+    return SOAP_OK;
+  if (soap_element_end_out(soap, "SOAP-ENV:Envelope"))
     return soap->error;
-  if (!**p)
-  {
-    if ((soap->mode & SOAP_C_NILSTRING))
-      return soap_element_null(soap, tag, id, type);
-    return soap_element_empty(soap, tag, id, type);
-  }
-  if (soap_element_begin_out(soap, tag, id, type)
-   || soap_string_out(soap, *p, 0)
-   || soap_element_end_out(soap, tag))
+#ifndef WITH_LEAN
+  if (!(soap->bxml & SOAP_BXML_OUT))
+#endif
+  if (soap_send_raw(soap, "\r\n", 2))   /* 2.8: always emit \r\n */
     return soap->error;
+  soap->part = SOAP_END_ENVELOPE;
   return SOAP_OK;
 }
 
 /******************************************************************************/
 
 SOAP_FMAC1
-char **
+int
 SOAP_FMAC2
-soap_instring(struct soap *soap, const char *tag, char **p, const char *type, int t, int flag, long minlen, long maxlen, const char *pattern)
+soap_http_has_body(struct soap *soap)
 {
-  (void)type;
-  if (soap_element_begin_in(soap, tag, 1, NULL))
-  {
-    if (!tag || *tag != '-' || soap->error != SOAP_NO_TAG)
-      return NULL;
-    soap->error = SOAP_OK;
-  }
-  if (!p)
-  {
-    p = (char**)soap_malloc(soap, sizeof(char*));
-    if (!p)
-      return NULL;
-  }
-  if (soap->null)
-  {
-    *p = NULL;
-  }
-  else if (soap->body)
+  return soap->length || (soap->mode & SOAP_ENC_ZLIB) || (soap->mode & SOAP_IO) == SOAP_IO_CHUNK;
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_http_skip_body(struct soap *soap)
+{
+  ULONG64 k = soap->length;
+  /* check HTTP body, return "" if none */
+  if (!k && !(soap->mode & SOAP_ENC_ZLIB) && (soap->mode & SOAP_IO) != SOAP_IO_CHUNK)
+    return SOAP_OK;
+  /* do not consume DIME or MIME attachments, leave this to soap_end_recv */
+  if ((soap->mode & SOAP_ENC_DIME) || (soap->mode & SOAP_ENC_MIME))
+    return SOAP_OK;
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Skipping HTTP body (mode=0x%x)\n", soap->mode));
+  if (k && !(soap->mode & SOAP_ENC_ZLIB))
   {
-    *p = soap_string_in(soap, flag, minlen, maxlen, pattern);
-    if (!*p || !(char*)soap_id_enter(soap, soap->id, *p, t, sizeof(char*), NULL, NULL, NULL, NULL))
-      return NULL;
-    if (!**p && tag && *tag == '-')
+    ULONG64 i;
+    soap->length = 0;
+    for (i = 0; i < k; i++)
     {
-      soap->error = SOAP_NO_TAG;
-      return NULL;
+      soap_wchar c = soap_get1(soap);
+      if ((int)c == EOF)
+        break;
     }
   }
-  else if (tag && *tag == '-')
-  {
-    soap->error = SOAP_NO_TAG;
-    return NULL;
-  }
-  else if (*soap->href != '#')
+  else
   {
-    if (minlen > 0)
+    for (;;)
     {
-      soap->error = SOAP_LENGTH;
-      return NULL;
+      soap_wchar c = soap_get1(soap);
+      if ((int)c == EOF)
+        break;
     }
-    *p = soap_strdup(soap, SOAP_STR_EOS);
-    if (!*p)
-      return NULL;
   }
-  if (*soap->href == '#')
-    p = (char**)soap_id_lookup(soap, soap->href, (void**)p, t, sizeof(char**), 0, NULL);
-  if (soap->body && soap_element_end_in(soap, tag))
-    return NULL;
-  return p;
+  return SOAP_OK;
 }
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
 SOAP_FMAC1
-int
+char *
 SOAP_FMAC2
-soap_outwstring(struct soap *soap, const char *tag, int id, wchar_t *const*p, const char *type, int n)
+soap_http_get_body(struct soap *soap, size_t *len)
 {
-  id = soap_element_id(soap, tag, id, *p, NULL, 0, type, n, NULL);
-  if (id < 0)
-    return soap->error;
-  if (!**p)
+  return soap_http_get_body_prefix(soap, len, NULL);
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+char *
+SOAP_FMAC2
+soap_http_get_form(struct soap *soap)
+{
+  return soap_http_get_body_prefix(soap, NULL, "?");
+}
+
+/******************************************************************************/
+
+SOAP_FMAC1
+char *
+SOAP_FMAC2
+soap_http_get_body_prefix(struct soap *soap, size_t *len, const char *prefix)
+{
+  char *s;
+  ULONG64 k = soap->length;
+  size_t n = 0;
+  if (!prefix)
+    prefix = SOAP_STR_EOS;
+  else
+    n = strlen(prefix);
+  if (len)
+    *len = 0;
+  /* check HTTP body, return "" if none */
+  if (!k && !(soap->mode & SOAP_ENC_PLAIN) && !(soap->mode & SOAP_ENC_ZLIB) && (soap->mode & SOAP_IO) != SOAP_IO_CHUNK)
+    return soap_strdup(soap, prefix);
+  /* do not consume DIME or MIME attachments, leave this to soap_end_recv */
+  if ((soap->mode & SOAP_ENC_DIME) || (soap->mode & SOAP_ENC_MIME))
+    return soap_strdup(soap, prefix);
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Parsing HTTP body, prefixed with '%s' (mode=0x%x)\n", prefix, soap->mode));
+  if (k && !(soap->mode & SOAP_ENC_ZLIB))
   {
-    if ((soap->mode & SOAP_C_NILSTRING))
-      return soap_element_null(soap, tag, id, type);
-    return soap_element_empty(soap, tag, id, type);
+    char *t;
+    size_t j;
+    soap->length = 0;
+    /* http content length != 0 and uncompressed body and body length does not exceed size_t max size */
+    if ((SOAP_MAXALLOCSIZE != 0 && n + k > SOAP_MAXALLOCSIZE) || n + k > (ULONG64)((size_t)-2))
+    {
+      soap->error = SOAP_EOM;
+      return NULL;
+    }
+    j = (size_t)k; /* safe cast: k is in size_t range as guarded above */
+    s = t = (char*)soap_malloc(soap, j + n + 1);
+    if (s)
+    {
+      size_t i = 0;
+      if (n)
+      {
+        (void)soap_memcpy(t, n, prefix, n);
+        t += n;
+      }
+      if (soap->ahead && j > 0)
+      {
+        *t++ = soap->ahead;
+        ++i;
+        soap->ahead = 0;
+      }
+      while (i < j)
+      {
+        size_t m;
+        if (soap->bufidx >= soap->buflen)
+          if (soap_recv(soap))
+            break;
+        if (soap->buflen - soap->bufidx > j - i)
+          m = j - i;
+        else
+          m = soap->buflen - soap->bufidx;
+        (void)soap_memcpy(t, j + n + 1 - i, soap->ibuf + soap->bufidx, m);
+        soap->bufidx += m;
+        t += m;
+        i += m;
+      }
+      *t = '\0';
+      if (len)
+        *len = n + i;
+    }
+    else
+    {
+      soap->error = SOAP_EOM;
+      return NULL;
+    }
   }
-  if (soap_element_begin_out(soap, tag, id, type)
-   || soap_wstring_out(soap, *p, 0)
-   || soap_element_end_out(soap, tag))
-    return soap->error;
-  return SOAP_OK;
+  else
+  {
+    size_t i, l = 0;
+    if (soap_alloc_block(soap) == NULL)
+      return NULL;
+    if (n)
+    {
+      s = (char*)soap_push_block(soap, NULL, n);
+      if (!s)
+        return NULL;
+      (void)soap_memcpy(s, n, prefix, n);
+      l += n;
+    }
+    if (soap->ahead)
+    {
+      s = (char*)soap_push_block(soap, NULL, 1);
+      if (!s)
+        return NULL;
+      *s = soap->ahead;
+      ++l;
+      soap->ahead = 0;
+    }
+    for (;;)
+    {
+      size_t k = SOAP_BLKLEN;
+      s = (char*)soap_push_block(soap, NULL, k);
+      if (!s)
+        return NULL;
+      i = 0;
+      while (i < k)
+      {
+        size_t m;
+        if (soap->bufidx >= soap->buflen)
+          if (soap_recv(soap))
+            goto end;
+        if (soap->buflen - soap->bufidx > k - i)
+          m = k - i;
+        else
+          m = soap->buflen - soap->bufidx;
+        (void)soap_memcpy(s, k - i, soap->ibuf + soap->bufidx, m);
+        soap->bufidx += m;
+        s += m;
+        i += m;
+        if (l + m < l)
+        {
+          soap->error = SOAP_EOM;
+          return NULL;
+        }
+        l += m;
+      }
+    }
+end:
+    *s = '\0';
+    if (len)
+      *len = l;
+    soap_size_block(soap, NULL, i + 1);
+    s = (char*)soap_save_block(soap, NULL, NULL, 0);
+  }
+  return s;
 }
-#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
 SOAP_FMAC1
-wchar_t **
+int
 SOAP_FMAC2
-soap_inwstring(struct soap *soap, const char *tag, wchar_t **p, const char *type, int t, int flag, long minlen, long maxlen, const char *pattern)
+soap_envelope_begin_in(struct soap *soap)
 {
-  (void)type;
-  if (soap_element_begin_in(soap, tag, 1, NULL))
-  {
-    if (!tag || *tag != '-' || soap->error != SOAP_NO_TAG)
-      return NULL;
-    soap->error = SOAP_OK;
-  }
-  if (!p)
-  {
-    p = (wchar_t**)soap_malloc(soap, sizeof(wchar_t*));
-    if (!p)
-      return NULL;
-  }
-  if (soap->null)
-  {
-    *p = NULL;
-  }
-  else if (soap->body)
+  soap->part = SOAP_IN_ENVELOPE;
+  if (soap_element_begin_in(soap, "SOAP-ENV:Envelope", 0, NULL))
   {
-    *p = soap_wstring_in(soap, flag, minlen, maxlen, pattern);
-    if (!*p || !(wchar_t*)soap_id_enter(soap, soap->id, *p, t, sizeof(wchar_t*), NULL, NULL, NULL, NULL))
-      return NULL;
-    if (!**p && tag && *tag == '-')
+    if (soap->error == SOAP_TAG_MISMATCH)
     {
-      soap->error = SOAP_NO_TAG;
-      return NULL;
+      if (!soap_element_begin_in(soap, ":Envelope", 0, NULL))
+        return soap->error = SOAP_VERSIONMISMATCH;
+      if (soap->status == 0
+           || (soap->status >= 200 && soap->status <= 299)
+           || soap->status == 400
+           || soap->status == 500)
+        return soap->error = SOAP_OK; /* allow non-SOAP (REST) XML content to be captured */
+      soap->error = soap->status;
     }
-  }
-  else if (tag && *tag == '-')
-  {
-    soap->error = SOAP_NO_TAG;
-    return NULL;
-  }
-  else if (*soap->href != '#')
-  {
-    if (minlen > 0)
+    else if (soap->status)
     {
-      soap->error = SOAP_LENGTH;
-      return NULL;
+      soap->error = soap->status;
     }
-    *p = soap_wstrdup(soap, L"");
+    return soap->error;
   }
-  if (*soap->href == '#')
-    p = (wchar_t**)soap_id_lookup(soap, soap->href, (void**)p, t, sizeof(wchar_t**), 0, NULL);
-  if (soap->body && soap_element_end_in(soap, tag))
-    return NULL;
-  return p;
+  soap_version(soap);
+  return SOAP_OK;
 }
-#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEAN
-#ifdef UNDER_CE
-/* WinCE mktime (based on the mingw-runtime, public domain) */
-#define __FILETIME_to_ll(f) ((long long)(f).dwHighDateTime << 32 | (long long)(f).dwLowDateTime)
-static time_t
-mktime(struct tm *pt)
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_envelope_end_in(struct soap *soap)
 {
-  SYSTEMTIME s, s1, s2;
-  FILETIME f, f1, f2;
-  long long diff;
-  GetSystemTime(&s1);
-  GetLocalTime(&s2);
-  SystemTimeToFileTime(&s1, &f1);
-  SystemTimeToFileTime(&s2, &f2);
-  diff = (__FILETIME_to_ll(f2) - __FILETIME_to_ll(f1)) / 10000000LL;
-  s.wYear = pt->tm_year + 1900;
-  s.wMonth = pt->tm_mon  + 1;
-  s.wDayOfWeek = pt->tm_wday;
-  s.wDay = pt->tm_mday;
-  s.wHour = pt->tm_hour;
-  s.wMinute = pt->tm_min;
-  s.wSecond = pt->tm_sec;
-  s.wMilliseconds = 0;
-  SystemTimeToFileTime(&s, &f);
-  return (time_t)((__FILETIME_to_ll(f) - 116444736000000000LL) / 10000000LL) - (time_t)diff;
+  if (soap->version == 0)
+    return SOAP_OK;
+  soap->part = SOAP_END_ENVELOPE;
+  return soap_element_end_in(soap, "SOAP-ENV:Envelope");
 }
-#endif
-#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEAN
-#ifdef UNDER_CE
-/* WinCE gmtime_r (based on the mingw-runtime, public domain) */
-#define HAVE_GMTIME_R
-static struct tm*
-gmtime_r(const time_t *t, struct tm *pt)
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_body_begin_out(struct soap *soap)
 {
-  FILETIME f, f1, f2;
-  SYSTEMTIME s, s1 = {0};
-  long long time = (long long)(*t) * 10000000LL + 116444736000000000LL;
-  f.dwHighDateTime = (DWORD)((time >> 32) & 0x00000000FFFFFFFF);
-  f.dwLowDateTime = (DWORD)(time & 0x00000000FFFFFFFF);
-  FileTimeToSystemTime(&f, &s);
-  pt->tm_year = s.wYear - 1900;
-  pt->tm_mon = s.wMonth - 1;
-  pt->tm_wday = s.wDayOfWeek;
-  pt->tm_mday = s.wDay;
-  s1.wYear = s.wYear;
-  s1.wMonth = 1;
-  s1.wDayOfWeek = 1;
-  s1.wDay = 1;
-  SystemTimeToFileTime(&s1, &f1);
-  SystemTimeToFileTime(&s, &f2);
-  pt->tm_yday = (((__FILETIME_to_ll(f2) - __FILETIME_to_ll(f1)) / 10000000LL) / (60 * 60 * 24));
-  pt->tm_hour = s.wHour;
-  pt->tm_min = s.wMinute;
-  pt->tm_sec = s.wSecond;
-  pt->tm_isdst = 0;
-  return pt;
-}
-#endif
+  if (soap->version == 1)
+    soap->encoding = 1;
+#ifndef WITH_LEAN
+  if ((soap->mode & SOAP_SEC_WSUID) && soap_set_attr(soap, "wsu:Id", "Body", 1))
+    return soap->error;
 #endif
+  if (soap->version == 0)
+    return SOAP_OK;
+  soap->part = SOAP_IN_BODY;
+  return soap_element_begin_out(soap, "SOAP-ENV:Body", 0, NULL);
+}
 
 /******************************************************************************/
 
-#ifndef WITH_LEAN
-#ifdef UNDER_CE
-/* WinCE very simple strftime for format "%Y-%m-%dT%H:%M:%SZ", note: %F and %T not supported by MS */
-static size_t
-strftime(char *buf, size_t len, const char *format, const struct tm *pT)
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_body_end_out(struct soap *soap)
 {
-  (void)len; (void)format;
-#ifndef WITH_NOZONE
-  (SOAP_SNPRINTF(buf, len, 20), "%04d-%02d-%02dT%02d:%02d:%02dZ", pT->tm_year + 1900, pT->tm_mon + 1, pT->tm_mday, pT->tm_hour, pT->tm_min, pT->tm_sec);
-#else
-  (SOAP_SNPRINTF(buf, len, 20), "%04d-%02d-%02dT%02d:%02d:%02d", pT->tm_year + 1900, pT->tm_mon + 1, pT->tm_mday, pT->tm_hour, pT->tm_min, pT->tm_sec);
-#endif
-  return len;
+  if (soap->version == 0)
+    return SOAP_OK;
+  if (soap_element_end_out(soap, "SOAP-ENV:Body"))
+    return soap->error;
+  soap->part = SOAP_END_BODY;
+  return SOAP_OK;
 }
-#endif
-#endif
 
 /******************************************************************************/
 
-#if !defined(WITH_LEAN) || defined(WITH_COOKIES)
 SOAP_FMAC1
-time_t
+int
 SOAP_FMAC2
-soap_timegm(struct tm *T)
+soap_body_begin_in(struct soap *soap)
 {
-#if defined(HAVE_TIMEGM)
-  return timegm(T);
-#else
-  time_t t, g, z;
-  struct tm tm;
-#ifndef HAVE_GMTIME_R
-  struct tm *tp;
-#endif
-  t = mktime(T);
-  if (t == (time_t)-1)
-    return (time_t)-1;
-#ifdef HAVE_GMTIME_R
-  if (gmtime_r(&t, &tm) == SOAP_FUNC_R_ERR)
-    return (time_t)-1;
-#else
-  tp = gmtime(&t);
-  if (!tp)
-    return (time_t)-1;
-  tm = *tp;
-#endif
-  tm.tm_isdst = 0;
-  g = mktime(&tm);
-  if (g == (time_t)-1)
-    return (time_t)-1;
-  z = g - t;
-  return t - z;
-#endif
+  if (soap->version == 0)
+    return SOAP_OK;
+  soap->part = SOAP_IN_BODY;
+  if (soap_element_begin_in(soap, "SOAP-ENV:Body", 0, NULL))
+    return soap->error;
+  if (!soap->body)
+    soap->part = SOAP_NO_BODY;
+  return SOAP_OK;
 }
-#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEAN
 SOAP_FMAC1
-const char*
+int
 SOAP_FMAC2
-soap_dateTime2s(struct soap *soap, time_t n)
+soap_body_end_in(struct soap *soap)
 {
-  struct tm T, *pT = &T;
-  size_t l = 0;
-#if defined(HAVE_GMTIME_R) && !defined(WITH_NOZONE)
-  if (gmtime_r(&n, pT) != SOAP_FUNC_R_ERR)
-    l = strftime(soap->tmpbuf, sizeof(soap->tmpbuf), "%Y-%m-%dT%H:%M:%SZ", pT);
-#elif defined(HAVE_GMTIME) && !defined(WITH_NOZONE)
-  pT = gmtime(&n);
-  if (pT)
-    l = strftime(soap->tmpbuf, sizeof(soap->tmpbuf), "%Y-%m-%dT%H:%M:%SZ", pT);
-#elif (defined(HAVE_TM_GMTOFF) || defined(HAVE_STRUCT_TM_TM_GMTOFF) || defined(HAVE_STRUCT_TM___TM_GMTOFF)) && !defined(WITH_NOZONE)
-#if defined(HAVE_LOCALTIME_R)
-  if (localtime_r(&n, pT) != SOAP_FUNC_R_ERR)
-  {
-    l = strftime(soap->tmpbuf, sizeof(soap->tmpbuf), "%Y-%m-%dT%H:%M:%S%z", pT);
-    if (l)
-    {
-      (void)soap_memmove(soap->tmpbuf + 23, sizeof(soap->tmpbuf) - 23, soap->tmpbuf + 22, 3); /* 2000-03-01T02:00:00+0300 */
-      soap->tmpbuf[22] = ':';                                                           /* 2000-03-01T02:00:00+03:00 */
-    }
-  }
-#else
-  pT = localtime(&n);
-  if (pT)
-  {
-    l = strftime(soap->tmpbuf, sizeof(soap->tmpbuf), "%Y-%m-%dT%H:%M:%S%z", pT);
-    if (l)
-    {
-      (void)soap_memmove(soap->tmpbuf + 23, sizeof(soap->tmpbuf) - 23, soap->tmpbuf + 22, 3); /* 2000-03-01T02:00:00+0300 */
-      soap->tmpbuf[22] = ':';                                                           /* 2000-03-01T02:00:00+03:00 */
-    }
-  }
-#endif
-#elif defined(HAVE_GETTIMEOFDAY) && !defined(WITH_NOZONE)
-#if defined(HAVE_LOCALTIME_R)
-  if (localtime_r(&n, pT) != SOAP_FUNC_R_ERR)
-  {
-    struct timeval tv;
-    struct timezone tz;
-    memset((void*)&tz, 0, sizeof(tz));
-    gettimeofday(&tv, &tz);
-    l = strftime(soap->tmpbuf, sizeof(soap->tmpbuf), "%Y-%m-%dT%H:%M:%S", pT);
-    if (l)
-      (SOAP_SNPRINTF(soap->tmpbuf + l, sizeof(soap->tmpbuf) - l, 7), "%+03d:%02d", -tz.tz_minuteswest/60+(pT->tm_isdst!=0), abs(tz.tz_minuteswest)%60);
-  }
-#else
-  pT = localtime(&n);
-  if (pT)
-  {
-    struct timeval tv;
-    struct timezone tz;
-    memset((void*)&tz, 0, sizeof(tz));
-    gettimeofday(&tv, &tz);
-    l = strftime(soap->tmpbuf, sizeof(soap->tmpbuf), "%Y-%m-%dT%H:%M:%S", pT);
-    if (l)
-      (SOAP_SNPRINTF(soap->tmpbuf + l, sizeof(soap->tmpbuf) - l, 7), "%+03d:%02d", -tz.tz_minuteswest/60+(pT->tm_isdst!=0), abs(tz.tz_minuteswest)%60);
-  }
-#endif
-#elif defined(HAVE_FTIME) && !defined(WITH_NOZONE)
-#if defined(HAVE_LOCALTIME_R)
-  if (localtime_r(&n, pT) != SOAP_FUNC_R_ERR)
-  {
-    struct timeb t;
-    memset((void*)&t, 0, sizeof(t));
-#ifdef __BORLANDC__
-    ::ftime(&t);
-#else
-    ftime(&t);
-#endif
-    l = strftime(soap->tmpbuf, sizeof(soap->tmpbuf), "%Y-%m-%dT%H:%M:%S", pT);
-    if (l)
-      (SOAP_SNPRINTF(soap->tmpbuf + l, sizeof(soap->tmpbuf) - l, 7), "%+03d:%02d", -t.timezone/60+(pT->tm_isdst!=0), abs(t.timezone)%60);
-  }
-#else
-  pT = localtime(&n);
-  if (pT)
-  {
-    struct timeb t;
-    memset((void*)&t, 0, sizeof(t));
-#ifdef __BORLANDC__
-    ::ftime(&t);
-#else
-    ftime(&t);
-#endif
-    l = strftime(soap->tmpbuf, sizeof(soap->tmpbuf), "%Y-%m-%dT%H:%M:%S", pT);
-    if (l)
-      (SOAP_SNPRINTF(soap->tmpbuf + l, sizeof(soap->tmpbuf) - l, 7), "%+03d:%02d", -t.timezone/60+(pT->tm_isdst!=0), abs(t.timezone)%60);
-  }
-#endif
-#elif defined(HAVE_LOCALTIME_R)
-  if (localtime_r(&n, pT) != SOAP_FUNC_R_ERR)
-    l = strftime(soap->tmpbuf, sizeof(soap->tmpbuf), "%Y-%m-%dT%H:%M:%S", pT);
-#else
-  pT = localtime(&n);
-  if (pT)
-    l = strftime(soap->tmpbuf, sizeof(soap->tmpbuf), "%Y-%m-%dT%H:%M:%S", pT);
-#endif
-  if (!l)
-    soap_strcpy(soap->tmpbuf, sizeof(soap->tmpbuf), "1969-12-31T23:59:59Z");
-  return soap->tmpbuf;
+  if (soap->version == 0)
+    return SOAP_OK;
+  if (soap->part == SOAP_NO_BODY)
+    return soap->error = SOAP_OK;
+  soap->part = SOAP_END_BODY;
+  return soap_element_end_in(soap, "SOAP-ENV:Body");
 }
-#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_outdateTime(struct soap *soap, const char *tag, int id, const time_t *p, const char *type, int n)
+soap_recv_header(struct soap *soap)
 {
-  if (soap_element_begin_out(soap, tag, soap_embedded_id(soap, id, p, n), type)
-   || soap_string_out(soap, soap_dateTime2s(soap, *p), 0))
-    return soap->error;
-  return soap_element_end_out(soap, tag);
+  if (soap_getheader(soap) && soap->error == SOAP_TAG_MISMATCH)
+    soap->error = SOAP_OK;
+  if (soap->error == SOAP_OK && soap->fheader)
+    soap->error = soap->fheader(soap);
+  return soap->error;
 }
-#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEAN
 SOAP_FMAC1
-int
+void
 SOAP_FMAC2
-soap_s2dateTime(struct soap *soap, const char *s, time_t *p)
+soap_set_endpoint(struct soap *soap, const char *endpoint)
 {
-  *p = 0;
-  if (s)
+  const char *s, *t;
+  size_t i, n;
+  soap->endpoint[0] = '\0';
+  soap->host[0] = '\0';
+  soap->path[0] = '/';
+  soap->path[1] = '\0';
+  soap->port = 80;
+  if (!endpoint || !*endpoint)
+    return;
+#if defined(WITH_OPENSSL) || defined(WITH_GNUTLS) || defined(WITH_WOLFSSL) || defined(WITH_SYSTEMSSL)
+  if (!soap_tag_cmp(endpoint, "https:*"))
+    soap->port = 443;
+#endif
+  soap_strcpy(soap->endpoint, sizeof(soap->endpoint), endpoint);
+  s = strchr(endpoint, ':');
+  if (s && s[1] == '/' && s[2] == '/')
+    s += 3;
+  else
+    s = endpoint;
+#if !defined(WITH_NOHTTP) || !defined(WITH_LEANER)
+  t = strchr(s, '@');
+  if (t && *s != ':' && *s != '@')
   {
-    unsigned long d;
-    struct tm T;
-    char *t;
-    if (!*s)
-      return soap->error = SOAP_EMPTY;
-    memset((void*)&T, 0, sizeof(T));
-    d = soap_strtoul(s, &t, 10);
-    if (*t == '-')
-    {
-      /* YYYY-MM-DD */
-      T.tm_year = (int)d;
-      T.tm_mon = (int)soap_strtoul(t + 1, &t, 10);
-      T.tm_mday = (int)soap_strtoul(t + 1, &t, 10);
-    }
-    else if (!(soap->mode & SOAP_XML_STRICT))
-    {
-      /* YYYYMMDD */
-      T.tm_year = (int)(d / 10000);
-      T.tm_mon = (int)(d / 100 % 100);
-      T.tm_mday = (int)(d % 100);
-    }
-    else
-    {
-      return soap->error = SOAP_TYPE;
-    }
-    if (*t == 'T' || ((*t == 't' || *t == ' ') && !(soap->mode & SOAP_XML_STRICT)))
-    {
-      d = soap_strtoul(t + 1, &t, 10);
-      if (*t == ':')
-      {
-        /* Thh:mm:ss */
-        T.tm_hour = (int)d;
-        T.tm_min = (int)soap_strtoul(t + 1, &t, 10);
-        T.tm_sec = (int)soap_strtoul(t + 1, &t, 10);
-      }
-      else if (!(soap->mode & SOAP_XML_STRICT))
-      {
-        /* Thhmmss */
-        T.tm_hour = (int)(d / 10000);
-        T.tm_min = (int)(d / 100 % 100);
-        T.tm_sec = (int)(d % 100);
-      }
-      else
-      {
-        return soap->error = SOAP_TYPE;
-      }
-    }
-    if (T.tm_year == 1)
-      T.tm_year = 70;
-    else
-      T.tm_year -= 1900;
-    T.tm_mon--;
-    if (*t == '.')
-    {
-      for (t++; *t; t++)
-        if (*t < '0' || *t > '9')
-          break;
-    }
-    if (*t == ' ' && !(soap->mode & SOAP_XML_STRICT))
-      t++;
-    if (*t)
+    size_t l = t - s + 1;
+    char *r = (char*)soap_malloc(soap, l);
+    n = s - endpoint;
+    if (r)
     {
-#ifndef WITH_NOZONE
-      if (*t == '+' || *t == '-')
+      s = soap_decode(r, l, s, ":@");
+      soap->userid = r;
+      soap->passwd = SOAP_STR_EOS;
+      if (*s == ':')
       {
-        int h, m;
-        m = (int)soap_strtol(t, &t, 10);
-        if (*t == ':')
-        {
-          /* +hh:mm */
-          h = m;
-          m = (int)soap_strtol(t + 1, &t, 10);
-          if (h < 0)
-            m = -m;
-        }
-        else if (!(soap->mode & SOAP_XML_STRICT))
-        {
-          /* +hhmm */
-          h = m / 100;
-          m = m % 100;
-        }
-        else
-        {
-          /* +hh */
-          h = m;
-          m = 0;
-        }
-        if (*t)
-          return soap->error = SOAP_TYPE;
-        T.tm_min -= m;
-        T.tm_hour -= h;
-        /* put hour and min in range */
-        T.tm_hour += T.tm_min / 60;
-        T.tm_min %= 60;
-        if (T.tm_min < 0)
-        {
-          T.tm_min += 60;
-          T.tm_hour--;
-        }
-        T.tm_mday += T.tm_hour / 24;
-        T.tm_hour %= 24;
-        if (T.tm_hour < 0)
+        s++;
+        if (*s != '@' && s < t)
         {
-          T.tm_hour += 24;
-          T.tm_mday--;
+          l = t - s + 1;
+          r = r + strlen(r) + 1;
+          s = soap_decode(r, l, s, "@");
+          soap->passwd = r;
         }
-        /* note: day of the month may be out of range, timegm() handles it */
       }
-      else if (*t != 'Z')
+    }
+    s++;
+    soap_strcpy(soap->endpoint + n, sizeof(soap->endpoint) - n, s);
+  }
+#endif
+  n = strlen(s);
+  if (n >= sizeof(soap->host))
+    n = sizeof(soap->host) - 1;
+#ifdef WITH_IPV6
+  if (s[0] == '[')
+  {
+    s++;
+    for (i = 0; i < n; i++)
+    {
+      if (s[i] == ']')
       {
-        return soap->error = SOAP_TYPE;
+        s++;
+        --n;
+        break;
       }
-#endif
-      *p = soap_timegm(&T);
+      soap->host[i] = s[i];
     }
-    else /* no UTC or timezone, so assume we got a localtime */
+  }
+  else
+  {
+    for (i = 0; i < n; i++)
     {
-      T.tm_isdst = -1;
-      *p = mktime(&T);
+      soap->host[i] = s[i];
+      if (s[i] == '/' || s[i] == ':' || s[i] == '?')
+        break;
     }
   }
-  return soap->error;
-}
-#endif
-
-/******************************************************************************/
-
-#ifndef WITH_LEAN
-SOAP_FMAC1
-time_t *
-SOAP_FMAC2
-soap_indateTime(struct soap *soap, const char *tag, time_t *p, const char *type, int t)
-{
-  if (soap_element_begin_in(soap, tag, 0, NULL))
-    return NULL;
-  if (*soap->type
-   && soap_match_tag(soap, soap->type, type)
-   && soap_match_tag(soap, soap->type, ":dateTime"))
+#else
+  for (i = 0; i < n; i++)
   {
-    soap->error = SOAP_TYPE;
-    soap_revert(soap);
-    return NULL;
+    soap->host[i] = s[i];
+    if (s[i] == '/' || s[i] == ':' || s[i] == '?')
+      break;
   }
-  p = (time_t*)soap_id_enter(soap, soap->id, p, t, sizeof(time_t), NULL, NULL, NULL, NULL);
-  if (!p)
-    return NULL;
-  if (*soap->href != '#')
+#endif
+  soap->host[i] = '\0';
+  if (s[i] == ':')
   {
-    int err = soap_s2dateTime(soap, soap_value(soap), p);
-    if ((soap->body && soap_element_end_in(soap, tag)) || err)
-      return NULL;
+    soap->port = (int)soap_strtol(s + i + 1, NULL, 10);
+    for (i++; i < n; i++)
+      if (s[i] == '/')
+        break;
   }
-  else
+  if (i < n && s[i])
+    soap_strcpy(soap->path, sizeof(soap->path), s + i);
+  if (soap->override_host && *soap->override_host)
   {
-    p = (time_t*)soap_id_forward(soap, soap->href, p, 0, t, t, sizeof(time_t), 0, NULL, NULL);
-    if (soap->body && soap_element_end_in(soap, tag))
-      return NULL;
+    soap_strcpy(soap->host, sizeof(soap->host), soap->override_host);
+    if (soap->override_port)
+      soap->port = soap->override_port;
   }
-  return p;
+  if (soap->userid && !soap->authrealm)
+    soap->authrealm = soap->host;
 }
-#endif
 
 /******************************************************************************/
 
+#ifndef WITH_NOHTTP
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_outliteral(struct soap *soap, const char *tag, char *const*p, const char *type)
+soap_GET(struct soap *soap, const char *endpoint, const char *action)
 {
-  if (tag && *tag != '-')
-    if (soap_element_begin_out(soap, tag, 0, type))
-      return soap->error;
-  if (p && *p)
-    if (soap_send(soap, *p)) /* send as-is */
-      return soap->error;
-  if (tag && *tag != '-')
-    return soap_element_end_out(soap, tag);
-  return SOAP_OK;
+  return soap_connect_command(soap, SOAP_GET, endpoint, action);
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_NOHTTP
 SOAP_FMAC1
-char **
+int
 SOAP_FMAC2
-soap_inliteral(struct soap *soap, const char *tag, char **p)
+soap_PUT(struct soap *soap, const char *endpoint, const char *action, const char *type)
 {
-  if (soap_element_begin_in(soap, tag, 1, NULL))
-  {
-    if (soap->error != SOAP_NO_TAG || soap_peek(soap) == SOAP_TT)
-      return NULL;
-    soap->error = SOAP_OK;
-  }
-  if (!p)
-  {
-    p = (char**)soap_malloc(soap, sizeof(char*));
-    if (!p)
-      return NULL;
-  }
-  if (soap->body || (tag && *tag == '-'))
-  {
-    if (tag && *tag != '-')
-      *p = soap_string_in(soap, 0, -1, -1, NULL);
-    else
-      *p = soap_string_in(soap, -1, -1, -1, NULL);
-    if (!*p)
-      return NULL;
-    if (!**p && tag && *tag == '-')
-    {
-      soap->error = SOAP_NO_TAG;
-      return NULL;
-    }
-  }
-  else if (soap->null)
-  {
-    *p = NULL;
-  }
-  else
+  if (!soap->http_content)
+    soap->http_content = type;
+  if ((soap->omode & SOAP_IO) != SOAP_IO_CHUNK)
   {
-    *p = soap_strdup(soap, SOAP_STR_EOS);
+    soap->omode &= ~SOAP_IO;
+    soap->omode |= SOAP_IO_STORE;
   }
-  if (soap->body && soap_element_end_in(soap, tag))
-    return NULL;
-  return p;
+  return soap_connect_command(soap, SOAP_PUT, endpoint, action);
 }
+#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
+#ifndef WITH_NOHTTP
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_outwliteral(struct soap *soap, const char *tag, wchar_t *const*p, const char *type)
+soap_POST(struct soap *soap, const char *endpoint, const char *action, const char *type)
 {
-  if (tag && *tag != '-')
-    if (soap_element_begin_out(soap, tag, 0, type))
-      return soap->error;
-  if (p)
-  {
-    wchar_t c;
-    const wchar_t *s = *p;
-    while ((c = *s++))
-    {
-      if (soap_pututf8(soap, (unsigned long)c)) /* send as-is in UTF8 */
-        return soap->error;
-    }
+  if (!soap->http_content)
+    soap->http_content = type;
+  if ((soap->omode & SOAP_IO) != SOAP_IO_CHUNK)
+  {
+    soap->omode &= ~SOAP_IO;
+    soap->omode |= SOAP_IO_STORE;
   }
-  if (tag && *tag != '-')
-    return soap_element_end_out(soap, tag);
-  return SOAP_OK;
+  return soap_connect_command(soap, SOAP_POST_FILE, endpoint, action);
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
+#ifndef WITH_NOHTTP
 SOAP_FMAC1
-wchar_t **
+int
 SOAP_FMAC2
-soap_inwliteral(struct soap *soap, const char *tag, wchar_t **p)
+soap_PATCH(struct soap *soap, const char *endpoint, const char *action, const char *type)
 {
-  if (soap_element_begin_in(soap, tag, 1, NULL))
-  {
-    if (soap->error != SOAP_NO_TAG || soap_peek(soap) == SOAP_TT)
-      return NULL;
-    soap->error = SOAP_OK;
-  }
-  if (!p)
-  {
-    p = (wchar_t**)soap_malloc(soap, sizeof(wchar_t*));
-    if (!p)
-      return NULL;
-  }
-  if (soap->body)
-  {
-    if (tag && *tag != '-')
-      *p = soap_wstring_in(soap, 0, -1, -1, NULL);
-    else
-      *p = soap_wstring_in(soap, -1, -1, -1, NULL);
-    if (!*p)
-      return NULL;
-    if (!**p && tag && *tag == '-')
-    {
-      soap->error = SOAP_NO_TAG;
-      return NULL;
-    }
-  }
-  else if (tag && *tag == '-')
-  {
-    soap->error = SOAP_NO_TAG;
-    return NULL;
-  }
-  else if (soap->null)
-  {
-    *p = NULL;
-  }
-  else
+  if (!soap->http_content)
+    soap->http_content = type;
+  if ((soap->omode & SOAP_IO) != SOAP_IO_CHUNK)
   {
-    *p = soap_wstrdup(soap, L"");
+    soap->omode &= ~SOAP_IO;
+    soap->omode |= SOAP_IO_STORE;
   }
-  if (soap->body && soap_element_end_in(soap, tag))
-    return NULL;
-  return p;
+  return soap_connect_command(soap, SOAP_PATCH, endpoint, action);
 }
 #endif
 
 /******************************************************************************/
 
+#ifndef WITH_NOHTTP
 SOAP_FMAC1
-const char *
+int
 SOAP_FMAC2
-soap_value(struct soap *soap)
+soap_DELETE(struct soap *soap, const char *endpoint)
 {
-  size_t i;
-  soap_wchar c = 0;
-  char *s = soap->tmpbuf;
-  if (!soap->body)
-    return SOAP_STR_EOS;
-  do
-  {
-    c = soap_get(soap);
-  } while (soap_coblank(c));
-  for (i = 0; i < sizeof(soap->tmpbuf) - 1; i++)
-  {
-    if (c == SOAP_TT || c == SOAP_LT || (int)c == EOF)
-      break;
-    *s++ = (char)c;
-    c = soap_get(soap);
-  }
-  for (s--; i > 0; i--, s--)
-  {
-    if (!soap_coblank((soap_wchar)*s))
-      break;
-  }
-  s[1] = '\0';
-  soap->tmpbuf[sizeof(soap->tmpbuf) - 1] = '\0'; /* appease */
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Element content value='%s'\n", soap->tmpbuf));
-  if (c == SOAP_TT || c == SOAP_LT || (int)c == EOF)
-  {
-    soap_unget(soap, c);
-  }
-  else
-  {
-    soap->error = SOAP_LENGTH;
-    return NULL;
-  }
-#ifdef WITH_DOM
-  if ((soap->mode & SOAP_XML_DOM) && soap->dom)
-  {
-    soap->dom->text = soap_strdup(soap, soap->tmpbuf);
-    if (!soap->dom->text)
-      return NULL;
-  }
-#endif
-  return soap->tmpbuf; /* return non-null pointer */
+  if (soap_connect_command(soap, SOAP_DEL, endpoint, NULL)
+   || soap_recv_empty_response(soap))
+    return soap_closesock(soap);
+  return SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
-#if !defined(WITH_LEANER) || !defined(WITH_NOHTTP)
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_getline(struct soap *soap, char *buf, int len)
+soap_connect(struct soap *soap, const char *endpoint, const char *action)
 {
-  char *s = buf;
-  int i = len;
-  soap_wchar c = 0;
-  for (;;)
-  {
-    while (i > 1)
-    {
-      c = soap_getchar(soap);
-      if (c == '\r' || c == '\n')
-        break;
-      if ((int)c == EOF)
-        return soap->error = SOAP_CHK_EOF;
-      *s++ = (char)c;
-      i--;
-    }
-    *s = '\0';
-    if (c != '\n')
-      c = soap_getchar(soap); /* got \r or something else, now get \n */
-    if (c == '\n')
-    {
-      if (i == len) /* empty line: end of HTTP/MIME header */
-        break;
-      c = soap_get0(soap);
-      if (c != ' ' && c != '\t') /* HTTP line continuation? */
-        break;
-    }
-    else if ((int)c == EOF)
-    {
-      return soap->error = SOAP_CHK_EOF;
-    }
-    else if (i <= 1)
-    {
-      return soap->error = SOAP_HDR;
-    }
-  }
-  return SOAP_OK;
+  return soap_connect_command(soap, SOAP_POST, endpoint, action);
 }
-#endif
 
 /******************************************************************************/
 
-static ULONG64
-soap_count_attachments(struct soap *soap)
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_connect_command(struct soap *soap, int http_command, const char *endpoints, const char *action)
 {
-#ifndef WITH_LEANER
-  struct soap_multipart *content;
-  ULONG64 count = soap->count;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Calculating the message size with attachments, current count=" SOAP_ULONG_FORMAT "\n", count));
-  if ((soap->mode & SOAP_ENC_DIME) && !(soap->mode & SOAP_ENC_MTOM))
-  {
-    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Calculating the size of DIME attachments\n"));
-    for (content = soap->dime.first; content; content = content->next)
-    {
-      count += 12 + ((content->size+3)&(~3));
-      if (content->id)
-        count += ((strlen(content->id)+3)&(~3));
-      if (content->type)
-        count += ((strlen(content->type)+3)&(~3));
-      if (content->options)
-        count += ((((unsigned char)content->options[2] << 8) | ((unsigned char)content->options[3]))+7)&(~3);
-      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Size of DIME attachment content is %lu bytes\n", (unsigned long)content->size));
-    }
-  }
-  if ((soap->mode & SOAP_ENC_MIME) && soap->mime.boundary)
+  if (endpoints)
   {
-    size_t n = strlen(soap->mime.boundary);
-    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Calculating the size of MIME attachments\n"));
-    for (content = soap->mime.first; content; content = content->next)
+    int retry = soap->connect_retry;
+    unsigned int backoff = 1;
+    for (;;)
     {
+      struct timeval tv;
       const char *s;
-      /* count \r\n--boundary\r\n */
-      count += 6 + n;
-      /* count Content-Type: ...\r\n */
-      if (content->type)
-        count += 16 + strlen(content->type);
-      /* count Content-Transfer-Encoding: ...\r\n */
-      s = soap_code_str(mime_codes, content->encoding);
+      s = strchr(endpoints, ' ');
       if (s)
-        count += 29 + strlen(s);
-      /* count Content-ID: ...\r\n */
-      if (content->id)
-        count += 14 + strlen(content->id);
-      /* count Content-Location: ...\r\n */
-      if (content->location)
-        count += 20 + strlen(content->location);
-      /* count Content-Description: ...\r\n */
-      if (content->description)
-        count += 23 + strlen(content->description);
-      /* count \r\n...content */
-      count += 2 + content->size;
-      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Size of MIME attachment content is %lu bytes\n", (unsigned long)content->size));
-    }
-    /* count \r\n--boundary-- */
-    count += 6 + n;
-  }
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "New count=" SOAP_ULONG_FORMAT "\n", count));
-  return count;
-#else
-  return soap->count;
-#endif
+      {
+        size_t l = strlen(endpoints);
+        char *endpoint = NULL;
+        if (SOAP_MAXALLOCSIZE == 0 || l <= SOAP_MAXALLOCSIZE)
+          endpoint = (char*)SOAP_MALLOC(soap, l + 1);
+        if (!endpoint)
+          return soap->error = SOAP_EOM;
+        for (;;)
+        {
+          (void)soap_strncpy(endpoint, l + 1, endpoints, s - endpoints);
+          endpoint[s - endpoints] = '\0';
+          if (soap_try_connect_command(soap, http_command, endpoint, action) != SOAP_TCP_ERROR)
+            break;
+          while (*s == ' ')
+            s++;
+          if (!*s)
+            break;
+          soap->error = SOAP_OK;
+          endpoints = s;
+          s = strchr(endpoints, ' ');
+          if (!s)
+            s = endpoints + strlen(endpoints);
+        }
+        SOAP_FREE(soap, endpoint);
+      }
+      else
+      {
+        soap_try_connect_command(soap, http_command, endpoints, action);
+      }
+      if (soap->error != SOAP_TCP_ERROR || retry <= 0)
+        break;
+      soap->error = SOAP_OK;
+      tv.tv_sec = backoff;
+      tv.tv_usec = 0;
+      select(0, NULL, NULL, NULL, &tv);
+      if (backoff < 32)
+        backoff *= 2;
+      --retry;
+    }
+  }
+  return soap->error;
 }
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
 static int
-soap_putdimefield(struct soap *soap, const char *s, size_t n)
+soap_try_connect_command(struct soap *soap, int http_command, const char *endpoint, const char *action)
 {
-  if (soap_send_raw(soap, s, n))
-    return soap->error;
-  return soap_send_raw(soap, SOAP_STR_PADDING, -(long)n&3);
-}
-#endif
-
-/******************************************************************************/
-
+  char host[sizeof(soap->host)];
+  int port;
+  ULONG64 count;
+  soap->error = SOAP_OK;
+  soap_reset_errno;
+  soap->errnum = 0;
+  (void)soap_memcpy(host, sizeof(host), soap->host, sizeof(soap->host)); /* save previous host name: if != then reconnect */
+  port = soap->port; /* save previous port to compare */
+  soap->status = http_command;
+  soap_set_endpoint(soap, endpoint);
+  soap->action = soap_strdup(soap, action);
 #ifndef WITH_LEANER
-SOAP_FMAC1
-char *
-SOAP_FMAC2
-soap_dime_option(struct soap *soap, unsigned short optype, const char *option)
-{
-  size_t n;
-  char *s = NULL;
-  if (option)
+  if (soap->fconnect)
   {
-    n = strlen(option);
-    s = (char*)soap_malloc(soap, n + 5);
-    if (s)
+    soap->error = soap->fconnect(soap, endpoint, soap->host, soap->port);
+    if (soap->error)
+      return soap->error;
+  }
+  else
+#endif
+  if (soap->fopen && *soap->host)
+  {
+    if (!soap->keep_alive || !soap_valid_socket(soap->socket) || strcmp(soap->host, host) || soap->port != port || !soap->fpoll || soap->fpoll(soap))
     {
-      s[0] = (char)(optype >> 8);
-      s[1] = (char)(optype & 0xFF);
-      s[2] = (char)(n >> 8);
-      s[3] = (char)(n & 0xFF);
-      soap_strcpy(s + 4, n + 1, option);
+      soap->error = SOAP_OK;
+#ifndef WITH_LEAN
+      if (!strncmp(endpoint, "soap.udp:", 9) || !strncmp(endpoint, "udp:", 4))
+      {
+        soap->omode |= SOAP_IO_UDP;
+      }
+      else
+#endif
+      {
+        soap->keep_alive = 0; /* to force close */
+        soap->omode &= ~SOAP_IO_UDP; /* to force close */
+      }
+      (void)soap_closesock(soap);
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Connect/reconnect to '%s' host='%s' path='%s' port=%d\n", endpoint?endpoint:"(null)", soap->host, soap->path, soap->port));
+      if (!soap->keep_alive || !soap_valid_socket(soap->socket))
+      {
+        soap->socket = soap->fopen(soap, endpoint, soap->host, soap->port);
+        if (!soap_valid_socket(soap->socket) || soap->error)
+        {
+          if (soap->error)
+            return soap->error;
+          return soap->error = SOAP_TCP_ERROR;
+        }
+        soap->keep_alive = -((soap->omode & SOAP_IO_KEEPALIVE) != 0);
+      }
     }
   }
-  return s;
-}
+#ifdef WITH_NTLM
+  if (soap_ntlm_handshake(soap, SOAP_GET, endpoint, soap->host, soap->port))
+    return soap->error;
 #endif
-
-/******************************************************************************/
-
-#ifndef WITH_LEANER
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_putdimehdr(struct soap *soap)
-{
-  unsigned char tmp[12];
-  size_t optlen = 0, idlen = 0, typelen = 0;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Put DIME header id='%s'\n", soap->dime.id ? soap->dime.id : SOAP_STR_EOS));
-  if (soap->dime.options)
-    optlen = (((unsigned char)soap->dime.options[2] << 8) | ((unsigned char)soap->dime.options[3])) + 4;
-  if (soap->dime.id)
+  count = soap_count_attachments(soap);
+  if (soap_init_send(soap, 1))
+    return soap->error;
+#ifndef WITH_NOHTTP
+  if (http_command == SOAP_GET || http_command == SOAP_DEL || http_command == SOAP_HEAD || http_command == SOAP_OPTIONS)
   {
-    idlen = strlen(soap->dime.id);
-    if (idlen > 0x0000FFFF)
-      idlen = 0x0000FFFF;
+    soap->mode &= ~(SOAP_IO | SOAP_ENC_ZLIB);
+    soap->mode |= SOAP_IO_BUFFER;
   }
-  if (soap->dime.type)
+  if ((soap->mode & SOAP_IO) != SOAP_IO_STORE && !(soap->mode & SOAP_ENC_PLAIN) && endpoint)
   {
-    typelen = strlen(soap->dime.type);
-    if (typelen > 0x0000FFFF)
-      typelen = 0x0000FFFF;
+    soap_mode k = soap->mode;
+    soap->mode &= ~(SOAP_IO | SOAP_ENC_ZLIB);
+    if ((k & SOAP_IO) != SOAP_IO_FLUSH)
+      soap->mode |= SOAP_IO_BUFFER;
+    soap->error = soap->fpost(soap, endpoint, soap->host, soap->port, soap->path, action, count);
+    if (soap->error)
+      return soap->error;
+    if ((k & SOAP_IO) == SOAP_IO_CHUNK)
+    {
+      if (soap_flush(soap))
+        return soap->error;
+    }
+    soap->mode = k;
   }
-  tmp[0] = SOAP_DIME_VERSION | (soap->dime.flags & 0x7);
-  tmp[1] = soap->dime.flags & 0xF0;
-  tmp[2] = (char)(optlen >> 8);
-  tmp[3] = (char)(optlen & 0xFF);
-  tmp[4] = (char)(idlen >> 8);
-  tmp[5] = (char)(idlen & 0xFF);
-  tmp[6] = (char)(typelen >> 8);
-  tmp[7] = (char)(typelen & 0xFF);
-  tmp[8] = (char)(soap->dime.size >> 24);
-  tmp[9] = (char)((soap->dime.size >> 16) & 0xFF);
-  tmp[10] = (char)((soap->dime.size >> 8) & 0xFF);
-  tmp[11] = (char)(soap->dime.size & 0xFF);
-  if (soap_send_raw(soap, (char*)tmp, 12)
-   || soap_putdimefield(soap, soap->dime.options, optlen)
-   || soap_putdimefield(soap, soap->dime.id, idlen)
-   || soap_putdimefield(soap, soap->dime.type, typelen))
+  if (http_command == SOAP_GET || http_command == SOAP_DEL || http_command == SOAP_HEAD || http_command == SOAP_OPTIONS)
+    return soap_end_send_flush(soap);
+#endif
+#ifndef WITH_LEANER
+  if (soap_begin_attachments(soap))
     return soap->error;
+#endif
   return SOAP_OK;
 }
-#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_putdime(struct soap *soap)
+#ifdef WITH_NTLM
+static int
+soap_ntlm_handshake(struct soap *soap, int command, const char *endpoint, const char *host, int port)
 {
-  struct soap_multipart *content;
-  if (!(soap->mode & SOAP_ENC_DIME))
-    return SOAP_OK;
-  for (content = soap->dime.first; content; content = content->next)
+  /* requires libntlm from http://www.nongnu.org/libntlm/ */
+  const char *userid = (soap->proxy_userid ? soap->proxy_userid : soap->userid);
+  const char *passwd = (soap->proxy_passwd ? soap->proxy_passwd : soap->passwd);
+  struct SOAP_ENV__Header *oldheader;
+  if (soap->ntlm_challenge && userid && passwd && soap->authrealm)
   {
-    void *handle;
-    soap->dime.size = content->size;
-    soap->dime.id = content->id;
-    soap->dime.type = content->type;
-    soap->dime.options = content->options;
-    soap->dime.flags = SOAP_DIME_VERSION | SOAP_DIME_MEDIA;
-    if (soap->fdimereadopen && ((handle = soap->fdimereadopen(soap, (void*)content->ptr, content->id, content->type, content->options)) != NULL || soap->error))
-    {
-      size_t size = content->size;
-      if (!handle)
-      {
-        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fdimereadopen failed\n"));
-        return soap->error;
-      }
-      if (!size && ((soap->mode & SOAP_ENC_PLAIN) || (soap->mode & SOAP_IO) == SOAP_IO_CHUNK || (soap->mode & SOAP_IO) == SOAP_IO_STORE))
-      {
-        size_t chunksize = sizeof(soap->tmpbuf);
-        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Chunked streaming DIME\n"));
-        do
-        {
-          size = soap->fdimeread(soap, handle, soap->tmpbuf, chunksize);
-          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fdimeread returned %lu bytes\n", (unsigned long)size));
-          if (size < chunksize)
-          {
-            soap->dime.flags &= ~SOAP_DIME_CF;
-            if (!content->next)
-              soap->dime.flags |= SOAP_DIME_ME;
-          }
-          else
-          {
-            soap->dime.flags |= SOAP_DIME_CF;
-          }
-          soap->dime.size = size;
-          if (soap_putdimehdr(soap)
-           || soap_putdimefield(soap, soap->tmpbuf, size))
-            break;
-          if (soap->dime.id)
-          {
-            soap->dime.flags &= ~(SOAP_DIME_MB | SOAP_DIME_MEDIA);
-            soap->dime.id = NULL;
-            soap->dime.type = NULL;
-            soap->dime.options = NULL;
-          }
-        } while (size >= chunksize);
-      }
-      else
-      {
-        if (!content->next)
-          soap->dime.flags |= SOAP_DIME_ME;
-        if (soap_putdimehdr(soap))
-          return soap->error;
-        do
-        {
-          size_t bufsize;
-          if (size < sizeof(soap->tmpbuf))
-            bufsize = size;
-          else
-            bufsize = sizeof(soap->tmpbuf);
-          bufsize = soap->fdimeread(soap, handle, soap->tmpbuf, bufsize);
-          if (!bufsize)
-          {
-            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fdimeread failed: insufficient data (%lu bytes remaining from %lu bytes)\n", (unsigned long)size, (unsigned long)content->size));
-            soap->error = SOAP_CHK_EOF;
-            break;
-          }
-          if (soap_send_raw(soap, soap->tmpbuf, bufsize))
-            break;
-          size -= bufsize;
-        } while (size);
-        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fdimereadclose\n"));
-        if (soap_send_raw(soap, SOAP_STR_PADDING, -(long)soap->dime.size&3))
-          return soap->error;
-      }
-      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fdimereadclose\n"));
-      if (soap->fdimereadclose)
-        soap->fdimereadclose(soap, handle);
-    }
-    else
+    tSmbNtlmAuthRequest req;
+    tSmbNtlmAuthResponse res;
+    tSmbNtlmAuthChallenge ch;
+    int keep_alive = soap->keep_alive;
+    ULONG64 length = soap->length;
+    ULONG64 count = soap->count;
+    soap_mode m = soap->mode;
+    soap_mode om = soap->omode;
+    int status = soap->status;
+    char *action = soap->action;
+    short version = soap->version;
+    const char *http_content = soap->http_content;
+    const char *http_extra_header = soap->http_extra_header;
+    const char *bearer = soap->bearer;
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "NTLM '%s'\n", soap->ntlm_challenge));
+    if (!*soap->ntlm_challenge)
     {
-      if (!content->next)
-        soap->dime.flags |= SOAP_DIME_ME;
-      if (soap_putdimehdr(soap)
-       || soap_putdimefield(soap, (char*)content->ptr, content->size))
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "NTLM S->C Type 1: received NTLM authentication challenge from server\n"));
+      /* S -> C   401 Unauthorized
+                  WWW-Authenticate: NTLM
+      */
+      buildSmbNtlmAuthRequest(&req, userid, soap->authrealm);
+      soap->ntlm_challenge = soap_s2base64(soap, (unsigned char*)(void*)&req, NULL, SmbLength(&req));
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "NTLM C->S Type 2: sending NTLM authorization to server\nAuthorization: NTLM %s\n", soap->ntlm_challenge));
+      /* C -> S   GET ...
+                  Authorization: NTLM TlRMTVNTUAABAAAAA7IAAAoACgApAAAACQAJACAAAABMSUdIVENJVFlVUlNBLU1JTk9S
+      */
+      soap->omode = SOAP_IO_BUFFER;
+      if (soap_init_send(soap, 0))
         return soap->error;
+      if (!soap->keep_alive)
+        soap->keep_alive = -1; /* client keep alive */
+      soap->status = command; /* GET or CONNECT for proxy */
+      if (soap->fpost(soap, endpoint, host, port, soap->path, soap->action, 0)
+       || soap_end_send_flush(soap))
+        return soap->error;
+      soap->mode = m;
+      soap->keep_alive = keep_alive;
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "NTLM S->C Type 2: waiting on server NTLM response\n"));
+      oldheader = soap->header;
+      if (soap_begin_recv(soap))
+        if (soap->error == SOAP_EOF)
+          return soap->error;
+      (void)soap_end_recv(soap);
+      soap->header = oldheader;
+      soap->length = length;
+      if (soap->status != 401 && soap->status != 407)
+        return soap->error = SOAP_NTLM_ERROR;
+      soap->error = SOAP_OK;
     }
+    /* S -> C   401 Unauthorized
+                WWW-Authenticate: NTLM TlRMTVNTUAACAAAAAAAAACgAAAABggAAU3J2Tm9uY2UAAAAAAAAAAA==
+    */
+    soap_base642s(soap, soap->ntlm_challenge, (char*)&ch, sizeof(tSmbNtlmAuthChallenge), NULL);
+    buildSmbNtlmAuthResponse(&ch, &res, userid, passwd);
+    soap->ntlm_challenge = soap_s2base64(soap, (unsigned char*)(void*)&res, NULL, SmbLength(&res));
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "NTLM C->S Type 3: sending NTLM authorization to server\nAuthorization: NTLM %s\n", soap->ntlm_challenge));
+    /* C -> S   GET ...
+                Authorization: NTLM TlRMTVNTUAADAAAAGAAYAHIAAAAYABgAigAAABQAFABAAAAADAAMAFQAAAASABIAYAAAAAAAAACiAAAAAYIAAFUAUgBTAEEALQBNAEkATgBPAFIAWgBhAHAAaABvAGQATABJAEcASABUAEMASQBUAFkArYfKbe/jRoW5xDxHeoxC1gBmfWiS5+iX4OAN4xBKG/IFPwfH3agtPEia6YnhsADT
+    */
+    soap->userid = NULL;
+    soap->passwd = NULL;
+    soap->proxy_userid = NULL;
+    soap->proxy_passwd = NULL;
+    soap->keep_alive = keep_alive;
+    soap->length = length;
+    soap->count = count;
+    soap->mode = m;
+    soap->omode = om;
+    soap->status = status;
+    soap->action = action;
+    soap->version = version;
+    soap->http_content = http_content;
+    soap->http_extra_header = http_extra_header;
+    soap->bearer = bearer;
   }
   return SOAP_OK;
 }
@@ -19995,2500 +25109,2870 @@ soap_putdime(struct soap *soap)
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
-static char *
-soap_getdimefield(struct soap *soap, size_t n)
-{
-  char *p = NULL;
-  if (n > 0)
-  {
-    p = (char*)soap_malloc(soap, n + 1 > n ? n + 1 : n);
-    if (p)
-    {
-      char *s = p;
-      size_t i;
-      for (i = n; i > 0; i--)
-      {
-        soap_wchar c = soap_get1(soap);
-        if ((int)c == EOF)
-        {
-          soap->error = SOAP_CHK_EOF;
-          return NULL;
-        }
-        *s++ = (char)c;
-      }
-      if (n + 1 > n)
-        *s = '\0'; /* force NUL terminated */
-      soap->error = soap_move(soap, (size_t)(-(long)n&3));
-      if (soap->error)
-        return NULL;
-    }
-    else
-    {
-      soap->error = SOAP_EOM;
-    }
-  }
-  return p;
-}
-#endif
-
-/******************************************************************************/
-
-#ifndef WITH_LEANER
 SOAP_FMAC1
-int
+char*
 SOAP_FMAC2
-soap_getdimehdr(struct soap *soap)
+soap_s2base64(struct soap *soap, const unsigned char *s, char *t, int n)
 {
-  soap_wchar c;
-  char *s;
   int i;
-  unsigned char tmp[12];
-  size_t optlen, idlen, typelen;
-  if (!(soap->mode & SOAP_ENC_DIME))
-    return soap->error = SOAP_DIME_END;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Get DIME header\n"));
-  s = (char*)tmp;
-  for (i = 12; i > 0; i--)
+  unsigned long m;
+  char *p;
+  if (!t)
+    t = (char*)soap_malloc(soap, (n + 2) / 3 * 4 + 1);
+  if (!t)
+    return NULL;
+  p = t;
+  t[0] = '\0';
+  if (!s)
+    return p;
+  for (; n > 2; n -= 3, s += 3)
   {
-    c = soap_getchar(soap);
-    if ((int)c == EOF)
-      return soap->error = SOAP_CHK_EOF;
-    *s++ = (char)c;
+    m = s[0];
+    m = (m << 8) | s[1];
+    m = (m << 8) | s[2];
+    for (i = 4; i > 0; m >>= 6)
+      t[--i] = soap_base64o[m & 0x3F];
+    t += 4;
   }
-  if ((tmp[0] & 0xF8) != SOAP_DIME_VERSION)
-    return soap->error = SOAP_DIME_MISMATCH;
-  soap->dime.flags = (tmp[0] & 0x7) | (tmp[1] & 0xF0);
-  optlen = (tmp[2] << 8) | tmp[3];
-  idlen = (tmp[4] << 8) | tmp[5];
-  typelen = (tmp[6] << 8) | tmp[7];
-  soap->dime.size = ((size_t)tmp[8] << 24) | ((size_t)tmp[9] << 16) | ((size_t)tmp[10] << 8) | ((size_t)tmp[11]);
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "DIME size=%lu flags=0x%X\n", (unsigned long)soap->dime.size, soap->dime.flags));
-  soap->dime.options = soap_getdimefield(soap, optlen);
-  if (!soap->dime.options && soap->error)
-    return soap->error;
-  soap->dime.id = soap_getdimefield(soap, idlen);
-  if (!soap->dime.id && soap->error)
-    return soap->error;
-  soap->dime.type = soap_getdimefield(soap, typelen);
-  if (!soap->dime.type && soap->error)
-    return soap->error;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "DIME flags=%x id='%s', type='%s', options='%s'\n", soap->dime.flags, soap->dime.id ? soap->dime.id : SOAP_STR_EOS, soap->dime.type ? soap->dime.type : "", soap->dime.options ? soap->dime.options+4 : SOAP_STR_EOS));
-  if ((soap->dime.flags & SOAP_DIME_ME))
-    soap->mode &= ~SOAP_ENC_DIME;
-  return SOAP_OK;
+  t[0] = '\0';
+  if (n > 0) /* 0 < n <= 2 implies that t[0..4] is allocated (base64 scaling formula) */
+  {
+    m = 0;
+    for (i = 0; i < n; i++)
+      m = (m << 8) | *s++;
+    for (; i < 3; i++)
+      m <<= 8;
+    for (i = 4; i > 0; m >>= 6)
+      t[--i] = soap_base64o[m & 0x3F];
+    for (i = 3; i > n; i--)
+      t[i] = '=';
+    t[4] = '\0';
+  }
+  return p;
 }
-#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
 SOAP_FMAC1
-int
+const char*
 SOAP_FMAC2
-soap_getdime(struct soap *soap)
+soap_base642s(struct soap *soap, const char *s, char *t, size_t l, int *n)
 {
-  if (soap->dime.buflen || soap->dime.chunksize)
-  {
-    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Skip remainder of SOAP in DIME (%u bytes or %u bytes in chunk left)\n", (unsigned int)soap->dime.buflen, (unsigned int)soap->dime.chunksize));
-    do
-      if (soap_get1(soap) == (int)EOF)
-        return soap->error = SOAP_CHK_EOF;
-    while (soap->dime.buflen || soap->dime.chunksize);
-    if (soap_move(soap, (size_t)(-(long)soap->dime.size&3)))
-      return soap->error = SOAP_CHK_EOF;
-    if (!(soap->mode & SOAP_ENC_DIME))
-      return SOAP_OK;
-  }
-  else
+  size_t i, j;
+  soap_wchar c;
+  unsigned long m;
+  const char *p;
+  if (n)
+    *n = 0;
+  if (!s || !*s)
   {
-    if (soap_move(soap, (size_t)(((soap->dime.size+3)&(~3)) - soap_tell(soap))))
-      return soap->error = SOAP_CHK_EOF;
+    if (soap->error)
+      return NULL;
+    return SOAP_NON_NULL;
   }
-  for (;;)
+  if (!t)
   {
-    struct soap_multipart *content;
-    if (soap_getdimehdr(soap))
-      break;
-    if (soap->fdimewriteopen && ((soap->dime.ptr = (char*)soap->fdimewriteopen(soap, soap->dime.id, soap->dime.type, soap->dime.options)) != NULL || soap->error))
-    {
-      const char *id, *type, *options;
-      size_t size, n;
-      if (!soap->dime.ptr)
-        return soap->error;
-      id = soap->dime.id;
-      type = soap->dime.type;
-      options = soap->dime.options;
-      for (;;)
-      {
-        size = soap->dime.size;
-        for (;;)
-        {
-          n = soap->buflen - soap->bufidx;
-          if (size < n)
-            n = size;
-          soap->error = soap->fdimewrite(soap, (void*)soap->dime.ptr, soap->buf + soap->bufidx, n);
-          if (soap->error)
-            break;
-          size -= n;
-          if (!size)
-          {
-            soap->bufidx += n;
-            break;
-          }
-          if (soap_recv(soap))
-          {
-            soap->error = SOAP_EOF;
-            goto end;
-          }
-        }
-        if (soap_move(soap, (size_t)(-(long)soap->dime.size&3)))
-        {
-          soap->error = SOAP_EOF;
-          break;
-        }
-        if (!(soap->dime.flags & SOAP_DIME_CF))
-          break;
-        if (soap_getdimehdr(soap))
-          break;
-      }
-end:
-      if (soap->fdimewriteclose)
-        soap->fdimewriteclose(soap, (void*)soap->dime.ptr);
-      soap->dime.size = 0;
-      soap->dime.id = id;
-      soap->dime.type = type;
-      soap->dime.options = options;
-    }
-    else if ((soap->dime.flags & SOAP_DIME_CF))
+    l = (strlen(s) + 3) / 4 * 3 + 1;    /* space for raw binary and \0 */
+    t = (char*)soap_malloc(soap, l);
+  }
+  if (!t)
+    return NULL;
+  p = t;
+  for (i = 0; ; i += 3, l -= 3)
+  {
+    m = 0;
+    j = 0;
+    while (j < 4)
     {
-      const char *id, *type, *options;
-      id = soap->dime.id;
-      type = soap->dime.type;
-      options = soap->dime.options;
-      if (soap_alloc_block(soap) == NULL)
-        return soap->error = SOAP_EOM;
-      for (;;)
+      c = *s++;
+      if (c == '=' || !c)
       {
-        soap_wchar c;
-        size_t i;
-        char *s;
-        if (soap->dime.size > SOAP_MAXDIMESIZE)
+        if (l >= j - 1)
         {
-          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "DIME size=%lu exceeds SOAP_MAXDIMESIZE=%lu\n", (unsigned long)soap->dime.size, (unsigned long)SOAP_MAXDIMESIZE));
-          return soap->error = SOAP_DIME_ERROR;
+          switch (j)
+          {
+            case 2:
+              *t++ = (char)((m >> 4) & 0xFF);
+              i++;
+              l--;
+              break;
+            case 3:
+              *t++ = (char)((m >> 10) & 0xFF);
+              *t++ = (char)((m >> 2) & 0xFF);
+              i += 2;
+              l -= 2;
+          }
         }
-        s = (char*)soap_push_block(soap, NULL, soap->dime.size);
-        if (!s)
-          return soap->error = SOAP_EOM;
-        for (i = soap->dime.size; i > 0; i--)
+        if (n)
+          *n = (int)i;
+        if (l)
+          *t = '\0';
+        return p;
+      }
+      c -= '+';
+      if (c >= 0 && c <= 79)
+      {
+        int b = soap_base64i[c];
+        if (b >= 64)
         {
-          c = soap_get1(soap);
-          if ((int)c == EOF)
-            return soap->error = SOAP_EOF;
-          *s++ = (char)c;
+          soap->error = SOAP_TYPE;
+          return NULL;
         }
-        if (soap_move(soap, (size_t)(-(long)soap->dime.size&3)))
-          return soap->error = SOAP_EOF;
-        if (!(soap->dime.flags & SOAP_DIME_CF))
-          break;
-        if (soap_getdimehdr(soap))
-          return soap->error;
+        m = (m << 6) + b;
+        j++;
+      }
+      else if (!soap_coblank(c + '+'))
+      {
+        soap->error = SOAP_TYPE;
+        return NULL;
       }
-      soap->dime.size = soap->blist->size;
-      if (soap->dime.size + 1 > soap->dime.size)
-        soap->blist->size++; /* allocate one more byte in blist for the terminating '\0' */
-      soap->dime.ptr = (char*)soap_save_block(soap, NULL, NULL, 0);
-      if (!soap->dime.ptr)
-        return soap->error;
-      if (soap->dime.size + 1 > soap->dime.size)
-        soap->dime.ptr[soap->dime.size] = '\0'; /* make 0-terminated, just in case even though this is binary data */
-      soap->dime.id = id;
-      soap->dime.type = type;
-      soap->dime.options = options;
     }
-    else
+    if (l < 3)
     {
-      soap->dime.ptr = soap_getdimefield(soap, soap->dime.size);
+      if (n)
+        *n = (int)i;
+      if (l)
+        *t = '\0';
+      return p;
     }
-    content = soap_alloc_multipart(soap, &soap->dime.first, &soap->dime.last, soap->dime.ptr, soap->dime.size);
-    if (!content)
-      return soap->error = SOAP_EOM;
-    content->id = soap->dime.id;
-    content->type = soap->dime.type;
-    content->options = soap->dime.options;
-    if (soap->error)
-      return soap->error;
-    soap_resolve_attachment(soap, content);
+    *t++ = (char)((m >> 16) & 0xFF);
+    *t++ = (char)((m >> 8) & 0xFF);
+    *t++ = (char)(m & 0xFF);
   }
-  if (soap->error != SOAP_DIME_END)
-    return soap->error;
-  return soap->error = SOAP_OK;
 }
-#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
 SOAP_FMAC1
-int
+char*
 SOAP_FMAC2
-soap_getmimehdr(struct soap *soap)
+soap_s2hex(struct soap *soap, const unsigned char *s, char *t, int n)
 {
-  struct soap_multipart *content;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Get MIME header\n"));
-  do
-  {
-    if (soap_getline(soap, soap->msgbuf, sizeof(soap->msgbuf)))
-      return soap->error;
-  } while (!*soap->msgbuf);
-  if (soap->msgbuf[0] == '-' && soap->msgbuf[1] == '-')
-  {
-    char *s = soap->msgbuf + strlen(soap->msgbuf) - 1;
-    /* remove white space */
-    while (soap_coblank((soap_wchar)*s))
-      s--;
-    s[1] = '\0';
-    if (soap->mime.boundary)
-    {
-      if (strcmp(soap->msgbuf + 2, soap->mime.boundary))
-        return soap->error = SOAP_MIME_ERROR;
-    }
-    else
-    {
-      soap->mime.boundary = soap_strdup(soap, soap->msgbuf + 2);
-      if (!soap->mime.boundary)
-        return soap->error = SOAP_EOM;
-    }
-    if (soap_getline(soap, soap->msgbuf, sizeof(soap->msgbuf)))
-      return soap->error;
-  }
-  if (soap_set_mime_attachment(soap, NULL, 0, SOAP_MIME_NONE, NULL, NULL, NULL, NULL))
-    return soap->error = SOAP_EOM;
-  content = soap->mime.last;
-  for (;;)
+  char *p;
+  if (!t)
+    t = (char*)soap_malloc(soap, 2 * n + 1);
+  if (!t)
+    return NULL;
+  p = t;
+  t[0] = '\0';
+  if (s)
   {
-    char *key = soap->msgbuf;
-    char *val;
-    if (!*key)
-      break;
-    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "MIME header: %s\n", key));
-    val = strchr(soap->msgbuf, ':');
-    if (val)
+    for (; n > 0; n--)
     {
-      *val = '\0';
-      do
-      {
-        val++;
-      } while (*val && *val <= 32);
-      if (!soap_tag_cmp(key, "Content-ID"))
-        content->id = soap_strdup(soap, val);
-      else if (!soap_tag_cmp(key, "Content-Location"))
-        content->location = soap_strdup(soap, val);
-      else if (!content->id && !soap_tag_cmp(key, "Content-Disposition"))
-        content->id = soap_strdup(soap, soap_http_header_attribute(soap, val, "name"));
-      else if (!soap_tag_cmp(key, "Content-Type"))
-        content->type = soap_strdup(soap, val);
-      else if (!soap_tag_cmp(key, "Content-Description"))
-        content->description = soap_strdup(soap, val);
-      else if (!soap_tag_cmp(key, "Content-Transfer-Encoding"))
-        content->encoding = (enum soap_mime_encoding)soap_code_int(mime_codes, val, (LONG64)SOAP_MIME_NONE);
+      int m = *s++;
+      *t++ = (char)((m >> 4) + (m > 159 ? 'a' - 10 : '0'));
+      m &= 0x0F;
+      *t++ = (char)(m + (m > 9 ? 'a' - 10 : '0'));
     }
-    if (soap_getline(soap, key, sizeof(soap->msgbuf)))
-      return soap->error;
   }
-  return SOAP_OK;
+  *t++ = '\0';
+  return p;
 }
-#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
 SOAP_FMAC1
-int
+const char*
 SOAP_FMAC2
-soap_getmime(struct soap *soap)
+soap_hex2s(struct soap *soap, const char *s, char *t, size_t l, int *n)
 {
-  while (soap_recv_mime_attachment(soap, NULL))
-    continue;
-  return soap->error;
+  const char *p;
+  if (n)
+    *n = 0;
+  if (!s || !*s)
+  {
+    if (soap->error)
+      return NULL;
+    return SOAP_NON_NULL;
+  }
+  if (!t)
+  {
+    l = strlen(s) / 2 + 1;      /* make sure enough space for \0 */
+    t = (char*)soap_malloc(soap, l);
+  }
+  if (!t)
+    return NULL;
+  p = t;
+  while (l)
+  {
+    int d1, d2;
+    d1 = *s++;
+    if (!d1)
+      break;
+    d2 = *s++;
+    if (!d2)
+      break;
+    *t++ = (char)(((d1 >= 'A' ? (d1 & 0x7) + 9 : d1 - '0') << 4) + (d2 >= 'A' ? (d2 & 0x7) + 9 : d2 - '0'));
+    l--;
+  }
+  if (n)
+    *n = (int)(t - p);
+  if (l)
+    *t = '\0';
+  return p;
 }
-#endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
-SOAP_FMAC1
-void
-SOAP_FMAC2
-soap_post_check_mime_attachments(struct soap *soap)
+#ifndef WITH_LEAN
+/* appends code point c to the look-aside buffer in UTF-8 */
+static int
+soap_json_append_utf8(struct soap *soap, unsigned long c)
 {
-  soap->imode |= SOAP_MIME_POSTCHECK;
+  char tmp[4];
+  size_t n;
+  if (c < 0x80)
+  {
+    tmp[0] = (char)c;
+    n = 1;
+  }
+  else if (c < 0x800)
+  {
+    tmp[0] = (char)(0xC0 | (c >> 6));
+    tmp[1] = (char)(0x80 | (c & 0x3F));
+    n = 2;
+  }
+  else if (c < 0x10000)
+  {
+    tmp[0] = (char)(0xE0 | (c >> 12));
+    tmp[1] = (char)(0x80 | ((c >> 6) & 0x3F));
+    tmp[2] = (char)(0x80 | (c & 0x3F));
+    n = 3;
+  }
+  else
+  {
+    tmp[0] = (char)(0xF0 | (c >> 18));
+    tmp[1] = (char)(0x80 | ((c >> 12) & 0x3F));
+    tmp[2] = (char)(0x80 | ((c >> 6) & 0x3F));
+    tmp[3] = (char)(0x80 | (c & 0x3F));
+    n = 4;
+  }
+  return soap_append_lab(soap, tmp, n);
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_check_mime_attachments(struct soap *soap)
+#ifndef WITH_LEAN
+/* returns the next non-blank JSON character, sets soap->error at EOF */
+static soap_wchar
+soap_json_skip(struct soap *soap)
 {
-  if ((soap->mode & SOAP_MIME_POSTCHECK))
-    return soap_recv_mime_attachment(soap, NULL) != NULL;
-  return 0;
+  soap_wchar c;
+  do
+    c = soap_getchar(soap);
+  while (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+  if ((int)c == EOF && !soap->error)
+    soap->error = SOAP_EOF;
+  return c;
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
-SOAP_FMAC1
-struct soap_multipart *
-SOAP_FMAC2
-soap_recv_mime_attachment(struct soap *soap, void *handle)
+#ifndef WITH_LEAN
+/* reads a JSON string after its opening quote into the look-aside buffer */
+static int
+soap_json_str(struct soap *soap)
 {
-  soap_wchar c = 0;
-  size_t i, m = 0;
-  char *s, *t = NULL;
-  struct soap_multipart *content;
-  short flag = 0;
-  if (!(soap->mode & SOAP_ENC_MIME))
-    goto post_check_exit;
-  content = soap->mime.last;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Get MIME (%p)\n", (void*)content));
-  if (!content)
-  {
-    if (soap_getmimehdr(soap))
-      goto post_check_exit;
-    content = soap->mime.last;
-  }
-  else if (content != soap->mime.first)
-  {
-    if (soap->fmimewriteopen && ((content->ptr = (char*)soap->fmimewriteopen(soap, (void*)handle, content->id, content->type, content->description, content->encoding)) != NULL || soap->error))
-    {
-      if (!content->ptr)
-        goto post_check_exit;
-    }
-  }
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Parsing MIME content id='%s' type='%s'\n", content->id ? content->id : SOAP_STR_EOS, content->type ? content->type : SOAP_STR_EOS));
-  if (!content->ptr && soap_alloc_block(soap) == NULL)
-  {
-    soap->error = SOAP_EOM;
-    goto post_check_exit;
-  }
+  soap->labidx = 0;
   for (;;)
   {
-    if (content->ptr)
-    {
-      s = soap->tmpbuf;
-    }
-    else
+    char buf[64];
+    size_t n = 0;
+    soap_wchar c = EOF;
+    while (n < sizeof(buf))
     {
-      s = (char*)soap_push_block(soap, NULL, sizeof(soap->tmpbuf));
-      if (!s)
-      {
-        soap->error = SOAP_EOM;
-        goto post_check_exit;
-      }
+      c = soap_getchar(soap);
+      if (c == '"' || c == '\\' || (int)c == EOF)
+        break;
+      buf[n++] = (char)c;
     }
-    for (i = 0; i < sizeof(soap->tmpbuf); i++)
+    if (n && soap_append_lab(soap, buf, n))
+      return soap->error;
+    if (n == sizeof(buf))
+      continue;
+    if (c == '"')
+      return soap_append_lab(soap, "", 1);
+    if ((int)c == EOF)
+      return soap->error = SOAP_EOF;
+    c = soap_getchar(soap);
+    switch (c)
     {
-      if (m > 0)
-      {
-        *s++ = *t++;
-        m--;
-      }
-      else
+      case 'b':
+        c = '\b';
+        break;
+      case 'f':
+        c = '\f';
+        break;
+      case 'n':
+        c = '\n';
+        break;
+      case 'r':
+        c = '\r';
+        break;
+      case 't':
+        c = '\t';
+        break;
+      case 'u':
       {
-        if (!flag)
+        unsigned long u = 0;
+        int i;
+        for (i = 0; i < 4; i++)
         {
           c = soap_getchar(soap);
-          if ((int)c == EOF)
-          {
-            if (content->ptr && soap->fmimewriteclose)
-              soap->fmimewriteclose(soap, (void*)content->ptr);
-            soap->error = SOAP_CHK_EOF;
-            goto post_check_exit;
-          }
+          if (c >= '0' && c <= '9')
+            u = (u << 4) | (c - '0');
+          else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+            u = (u << 4) | ((c | 0x20) - 'a' + 10);
+          else
+            return soap->error = SOAP_SYNTAX_ERROR;
         }
-        if (flag || c == '\r')
+        if (u >= 0xD800 && u < 0xDC00)
         {
-          memset((void*)soap->msgbuf, 0, sizeof(soap->msgbuf));
-          soap_strcpy(soap->msgbuf, sizeof(soap->msgbuf), "\n--");
-          if (soap->mime.boundary)
-          {
-            if (soap_strncat(soap->msgbuf, sizeof(soap->msgbuf), soap->mime.boundary, sizeof(soap->msgbuf) - 4))
-            {
-              soap->error = SOAP_MIME_ERROR;
-              goto post_check_exit;
-            }
-          }
-          t = soap->msgbuf;
-          do
+          unsigned long l = 0;
+          if (soap_getchar(soap) != '\\' || soap_getchar(soap) != 'u')
+            return soap->error = SOAP_SYNTAX_ERROR;
+          for (i = 0; i < 4; i++)
           {
             c = soap_getchar(soap);
-          } while (c == *t++);
-          if ((int)c == EOF)
-          {
-            if (content->ptr && soap->fmimewriteclose)
-              soap->fmimewriteclose(soap, (void*)content->ptr);
-            soap->error = SOAP_CHK_EOF;
-            goto post_check_exit;
+            if (c >= '0' && c <= '9')
+              l = (l << 4) | (c - '0');
+            else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+              l = (l << 4) | ((c | 0x20) - 'a' + 10);
+            else
+              return soap->error = SOAP_SYNTAX_ERROR;
           }
-          if (!*--t)
-            goto end;
-          *t = (char)c;
-          flag = (c == '\r');
-          m = t - soap->msgbuf + 1 - flag;
-          t = soap->msgbuf;
-          c = '\r';
+          if (l < 0xDC00 || l >= 0xE000)
+            return soap->error = SOAP_SYNTAX_ERROR;
+          u = 0x10000 + ((u - 0xD800) << 10) + (l - 0xDC00);
         }
-        *s++ = (char)c;
+        if (soap_json_append_utf8(soap, u))
+          return soap->error;
+        continue;
       }
-    }
-    if (content->ptr && soap->fmimewrite)
-    {
-      soap->error = soap->fmimewrite(soap, (void*)content->ptr, soap->tmpbuf, i);
-      if (soap->error)
+      case '"':
+      case '\\':
+      case '/':
         break;
+      default:
+        return soap->error = SOAP_SYNTAX_ERROR;
     }
+    buf[0] = (char)c;
+    if (soap_append_lab(soap, buf, 1))
+      return soap->error;
   }
-end:
-  if (content->ptr)
-  {
-    if (!soap->error && soap->fmimewrite)
-      soap->error = soap->fmimewrite(soap, (void*)content->ptr, soap->tmpbuf, i);
-    if (soap->fmimewriteclose)
-      soap->fmimewriteclose(soap, (void*)content->ptr);
-    if (soap->error)
-      goto post_check_exit;
-  }
-  else
-  {
-    *s = '\0'; /* make 0-terminated, just in case even though this is binary data */
-    content->size = soap_size_block(soap, NULL, i + 1) - 1; /* last block with '\0' */
-    content->ptr = (char*)soap_save_block(soap, NULL, NULL, 0);
-  }
-  soap_resolve_attachment(soap, content);
-  if (c == '-' && soap_getchar(soap) == '-')
-  {
-    soap->mode &= ~SOAP_ENC_MIME;
-    if ((soap->mode & SOAP_MIME_POSTCHECK))
-    {
-      if (soap_end_recv(soap))
-        goto post_check_exit;
-      if (soap->keep_alive == -2) /* special case to keep alive */
-        soap->keep_alive = 0;
-      (void)soap_closesock(soap);
-    }
-  }
-  else
-  {
-    while (c != '\r' && (int)c != EOF && soap_coblank(c))
-      c = soap_getchar(soap);
-    if (c != '\r' || soap_getchar(soap) != '\n')
-    {
-      soap->error = SOAP_MIME_ERROR;
-      goto post_check_exit;
-    }
-    if (soap_getmimehdr(soap))
-      goto post_check_exit;
-  }
-  return content;
-post_check_exit:
-  if ((soap->mode & SOAP_MIME_POSTCHECK))
-  {
-    if (soap->keep_alive == -2) /* special case to keep alive */
-      soap->keep_alive = 0;
-    (void)soap_closesock(soap);
-  }
-  return NULL;
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_match_cid(struct soap *soap, const char *s, const char *t)
+#ifndef WITH_LEAN
+/* reads a JSON number or literal starting with c into the look-aside buffer */
+static int
+soap_json_token(struct soap *soap, soap_wchar c)
 {
-  size_t n;
-  if (!s)
-    return 1;
-  if (!strcmp(s, t))
-    return 0;
-  if (!strncmp(s, "cid:", 4))
-    s += 4;
-  n = strlen(t);
-  if (*t == '<')
+  soap->labidx = 0;
+  while ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.')
   {
-    t++;
-    n -= 2;
+    char ch = (char)c;
+    if (soap_append_lab(soap, &ch, 1))
+      return soap->error;
+    c = soap_getchar(soap);
   }
-  if (!strncmp(s, t, n) && !s[n])
-    return 0;
-  (void)soap_decode(soap->tmpbuf, sizeof(soap->tmpbuf), s, SOAP_STR_EOS);
-  if (!strncmp(soap->tmpbuf, t, n) && !soap->tmpbuf[n])
-    return 0;
-  return 1;
+  soap_unget(soap, c);
+  if (soap->labidx == 0)
+    return soap->error = SOAP_SYNTAX_ERROR;
+  return soap_append_lab(soap, "", 1);
 }
 #endif
 
-/******************************************************************************/
-
-/* return UUID "<prefix>xxxxxxxx-xxxx-4xxx-yxxx-xxxxxxxxxxxx" in a temporary buffer */
-SOAP_FMAC1
-const char*
-SOAP_FMAC2
-soap_rand_uuid(struct soap *soap, const char *prefix)
-{
-  int r1, r2, r3, r4;
-#ifdef WITH_OPENSSL
-  r1 = soap_random;
-  r2 = soap_random;
-#else
-  size_t i;
-  static int k = 0xFACEB00C;
-  int lo = k % 127773;
-  int hi = k / 127773;
-# if defined(HAVE_GETTIMEOFDAY)
-  struct timeval tv;
-  gettimeofday(&tv, NULL);
-  r1 = 10000000 * tv.tv_sec + tv.tv_usec;
-# elif defined(UNDER_CE)
-  r1 = (int)Random();
-# elif !defined(WITH_LEAN)
-  r1 = (int)time(NULL);
-# else
-  r1 = k;
-# endif
-  k = 16807 * lo - 2836 * hi;
-  if (k <= 0)
-    k += 0x7FFFFFFF;
-  r2 = k;
-  /* k &= 0x8FFFFFFF; */
-  for (i = 0; i < (sizeof(soap->buf) < 16UL ? sizeof(soap->buf) : 16UL); i++)
-    r2 += soap->buf[i];
-#endif
-  r3 = soap_random;
-  r4 = soap_random;
-  (SOAP_SNPRINTF(soap->tmpbuf, sizeof(soap->tmpbuf), prefix ? strlen(prefix) + 37 : 37), "%s%8.8x-%4.4hx-4%3.3hx-%4.4hx-%4.4hx%8.8x", prefix ? prefix : SOAP_STR_EOS, r1, (short)(r2 >> 16), (short)(((short)r2 >> 4) & 0x0FFF), (short)(((short)(r3 >> 16) & 0x3FFF) | 0x8000), (short)r3, r4);
-  return soap->tmpbuf;
-}
-
-/******************************************************************************/
-
-#ifndef WITH_LEANER
-static void
-soap_resolve_attachment(struct soap *soap, struct soap_multipart *content)
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_json_string_out(struct soap *soap, const char *s)
 {
-  if (content->id)
+  const char *t;
+  if (!s)
+    return soap_send_raw(soap, "null", 4);
+  if (soap_send_raw(soap, "\"", 1))
+    return soap->error;
+  for (t = s; *t; t++)
   {
-    struct soap_xlist **xp = &soap->xlist;
-    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Resolving attachment data for id='%s'\n", content->id));
-    while (*xp)
+    unsigned char c = (unsigned char)*t;
+    if (c < 0x20 || c == '"' || c == '\\')
     {
-      struct soap_xlist *xq = *xp;
-      if (!soap_match_cid(soap, xq->id, content->id))
-      {
-        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Found matching attachment id='%s' for content id='%s'\n", xq->id, content->id));
-        *xp = xq->next;
-        *xq->ptr = (unsigned char*)content->ptr;
-        *xq->size = (int)content->size;
-        *xq->type = (char*)content->type;
-        if (content->options)
-          *xq->options = (char*)content->options;
-        else
-          *xq->options = (char*)content->description;
-        SOAP_FREE(soap, xq);
-      }
-      else
+      char tmp[8];
+      if (soap_send_raw(soap, s, t - s))
+        return soap->error;
+      switch (c)
       {
-        xp = &(*xp)->next;
+        case '"':
+        case '\\':
+          tmp[0] = '\\';
+          tmp[1] = (char)c;
+          tmp[2] = '\0';
+          break;
+        case '\n':
+          soap_strcpy(tmp, sizeof(tmp), "\\n");
+          break;
+        case '\r':
+          soap_strcpy(tmp, sizeof(tmp), "\\r");
+          break;
+        case '\t':
+          soap_strcpy(tmp, sizeof(tmp), "\\t");
+          break;
+        default:
+          (SOAP_SNPRINTF(tmp, sizeof(tmp), 6), "\\u%.4x", (unsigned int)c);
       }
+      if (soap_send(soap, tmp))
+        return soap->error;
+      s = t + 1;
     }
   }
+  if (soap_send_raw(soap, s, t - s))
+    return soap->error;
+  return soap_send_raw(soap, "\"", 1);
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
+#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_putmimehdr(struct soap *soap, struct soap_multipart *content)
+soap_json_number_out(struct soap *soap, const char *s)
 {
-  const char *s;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "MIME attachment type='%s'\n", content->type ? content->type : SOAP_STR_EOS));
-  if (soap_send3(soap, "\r\n--", soap->mime.boundary, "\r\n"))
-    return soap->error;
-  if (content->type && soap_send3(soap, "Content-Type: ", content->type, "\r\n"))
-    return soap->error;
-  s = soap_code_str(mime_codes, content->encoding);
-  if (s && soap_send3(soap, "Content-Transfer-Encoding: ", s, "\r\n"))
-    return soap->error;
-  if (content->id && soap_send3(soap, "Content-ID: ", content->id, "\r\n"))
-    return soap->error;
-  if (content->location && soap_send3(soap, "Content-Location: ", content->location, "\r\n"))
+  if (!s || !strcmp(s, "INF") || !strcmp(s, "-INF") || !strcmp(s, "NaN"))
+    return soap_send_raw(soap, "null", 4);
+  return soap_send(soap, s);
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_json_key_out(struct soap *soap, const char *key, int n)
+{
+  if ((n && soap_send_raw(soap, ",", 1))
+   || soap_json_string_out(soap, key))
     return soap->error;
-  if (content->description && soap_send3(soap, "Content-Description: ", content->description, "\r\n"))
+  return soap_send_raw(soap, ":", 1);
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_json_begin_in(struct soap *soap, int c)
+{
+  soap_wchar d = soap_json_skip(soap);
+  if ((int)d == EOF)
     return soap->error;
-  return soap_send_raw(soap, "\r\n", 2);
+  if (d != c)
+    return soap->error = SOAP_TYPE;
+  if (++soap->level > soap->maxlevel)
+    return soap->error = SOAP_LEVEL;
+  return SOAP_OK;
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
+#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_putmime(struct soap *soap)
+soap_json_next_in(struct soap *soap, int c, int *n)
 {
-  struct soap_multipart *content;
-  if (!(soap->mode & SOAP_ENC_MIME) || !soap->mime.boundary)
-    return SOAP_OK;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Sending MIME attachments\n"));
-  for (content = soap->mime.first; content; content = content->next)
+  soap_wchar d = soap_json_skip(soap);
+  if (d == c)
   {
-    int err = SOAP_OK;
-    void *handle;
-    if (soap->fmimereadopen && ((handle = soap->fmimereadopen(soap, (void*)content->ptr, content->id, content->type, content->description)) != NULL || soap->error))
-    {
-      size_t size = content->size;
-      if (!handle)
-      {
-        DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fmimereadopen failed\n"));
-        if (!soap->error)
-          soap->error = SOAP_MIME_ERROR;
-        return soap->error;
-      }
-      if (soap_putmimehdr(soap, content))
-        return soap->error;
-      if (!size) /* streaming MIME is indicated by size zero content size when streaming MIME callbacks are set */
-      {
-        if ((soap->mode & SOAP_ENC_PLAIN) || (soap->mode & SOAP_IO) == SOAP_IO_CHUNK || (soap->mode & SOAP_IO) == SOAP_IO_STORE)
-        {
-          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Chunked streaming MIME\n"));
-          do
-          {
-            size = soap->fmimeread(soap, handle, soap->tmpbuf, sizeof(soap->tmpbuf));
-            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fmimeread returned %lu bytes\n", (unsigned long)size));
-            err = soap_send_raw(soap, soap->tmpbuf, size);
-          } while (!err && size);
-        }
-        else
-        {
-          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Error: cannot chunk streaming MIME (no HTTP chunking)\n"));
-        }
-      }
-      else
-      {
-        do
-        {
-          size_t bufsize;
-          if (size < sizeof(soap->tmpbuf))
-            bufsize = size;
-          else
-            bufsize = sizeof(soap->tmpbuf);
-          bufsize = soap->fmimeread(soap, handle, soap->tmpbuf, bufsize);
-          if (!bufsize)
-          {
-            DBGLOG(TEST, SOAP_MESSAGE(fdebug, "fmimeread failed: insufficient data (%lu bytes remaining from %lu bytes)\n", (unsigned long)size, (unsigned long)content->size));
-            err = SOAP_MIME_ERROR; /* used to be EOF, SOAP_MIME_ERROR is more appropriaate */
-            break;
-          }
-          err = soap_send_raw(soap, soap->tmpbuf, bufsize);
-          size -= bufsize;
-        } while (!err && size);
-      }
-      if (soap->fmimereadclose)
-        soap->fmimereadclose(soap, handle);
-      if (err)
-        return soap->error = err;
-    }
-    else
+    soap->level--;
+    return 0;
+  }
+  if ((int)d == EOF)
+    return 0;
+  if (*n > 0)
+  {
+    if (d != ',')
     {
-      if (soap_putmimehdr(soap, content)
-       || soap_send_raw(soap, content->ptr, content->size))
-        return soap->error;
+      soap->error = SOAP_SYNTAX_ERROR;
+      return 0;
     }
   }
-  return soap_send3(soap, "\r\n--", soap->mime.boundary, "--");
+  else
+  {
+    soap_unget(soap, d);
+  }
+  ++*n;
+  return 1;
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
+#ifndef WITH_LEAN
 SOAP_FMAC1
-void
+const char *
 SOAP_FMAC2
-soap_set_dime(struct soap *soap)
+soap_json_key_in(struct soap *soap)
 {
-  soap->omode |= SOAP_ENC_DIME;
-  soap->dime.first = NULL;
-  soap->dime.last = NULL;
+  if (soap_json_skip(soap) != '"')
+  {
+    if (!soap->error)
+      soap->error = SOAP_SYNTAX_ERROR;
+    return NULL;
+  }
+  if (soap_json_str(soap))
+    return NULL;
+  if (soap_json_skip(soap) != ':')
+  {
+    if (!soap->error)
+      soap->error = SOAP_SYNTAX_ERROR;
+    return NULL;
+  }
+  soap_strcpy(soap->tag, sizeof(soap->tag), soap->labbuf);
+  return soap->tag;
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
+#ifndef WITH_LEAN
 SOAP_FMAC1
-void
+const char *
 SOAP_FMAC2
-soap_set_mime(struct soap *soap, const char *boundary, const char *start)
+soap_json_value_in(struct soap *soap)
 {
-  soap->omode |= SOAP_ENC_MIME;
-  soap->mime.first = NULL;
-  soap->mime.last = NULL;
-  soap->mime.boundary = soap_strdup(soap, boundary);
-  soap->mime.start = soap_strdup(soap, start);
+  soap_wchar c = soap_json_skip(soap);
+  if (c == '"')
+  {
+    if (soap_json_str(soap))
+      return NULL;
+  }
+  else if (c == '{' || c == '[')
+  {
+    soap->error = SOAP_TYPE;
+    return NULL;
+  }
+  else if ((int)c == EOF || soap_json_token(soap, c))
+  {
+    return NULL;
+  }
+  else if (!strcmp(soap->labbuf, "null"))
+  {
+    return NULL;
+  }
+  return soap->labbuf;
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
+#ifndef WITH_LEAN
 SOAP_FMAC1
-void
+int
 SOAP_FMAC2
-soap_clr_dime(struct soap *soap)
+soap_json_null_in(struct soap *soap)
 {
-  soap->omode &= ~SOAP_ENC_DIME;
-  soap->dime.first = NULL;
-  soap->dime.last = NULL;
+  soap_wchar c = soap_json_skip(soap);
+  if (c == 'n')
+  {
+    if (soap_json_token(soap, c))
+      return 0;
+    if (strcmp(soap->labbuf, "null"))
+    {
+      soap->error = SOAP_SYNTAX_ERROR;
+      return 0;
+    }
+    return 1;
+  }
+  if ((int)c != EOF)
+    soap_unget(soap, c);
+  return 0;
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
+#ifndef WITH_LEAN
 SOAP_FMAC1
-void
+int
 SOAP_FMAC2
-soap_clr_mime(struct soap *soap)
+soap_json_ignore_in(struct soap *soap)
 {
-  soap->omode &= ~SOAP_ENC_MIME;
-  soap->mime.first = NULL;
-  soap->mime.last = NULL;
-  soap->mime.boundary = NULL;
-  soap->mime.start = NULL;
+  unsigned int level = 0;
+  soap_wchar c = soap_json_skip(soap);
+  for (;;)
+  {
+    switch (c)
+    {
+      case '"':
+        if (soap_json_str(soap))
+          return soap->error;
+        break;
+      case '{':
+      case '[':
+        if (++level > soap->maxlevel)
+          return soap->error = SOAP_LEVEL;
+        break;
+      case '}':
+      case ']':
+        if (level == 0)
+          return soap->error = SOAP_SYNTAX_ERROR;
+        level--;
+        break;
+      case ',':
+      case ':':
+        if (level == 0)
+          return soap->error = SOAP_SYNTAX_ERROR;
+        break;
+      default:
+        if ((int)c == EOF)
+          return soap->error;
+        if (soap_json_token(soap, c))
+          return soap->error;
+    }
+    if (level == 0)
+      return SOAP_OK;
+    c = soap_json_skip(soap);
+  }
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* sends the CBOR initial byte c followed by the k least significant bytes of n in network byte order */
+static int
+soap_cbor_send_arg(struct soap *soap, int c, ULONG64 n, size_t k)
+{
+  char tmp[9];
+  size_t i;
+  tmp[0] = (char)c;
+  for (i = k; i > 0; i--)
+  {
+    tmp[i] = (char)(n & 0xFF);
+    n >>= 8;
+  }
+  return soap_send_raw(soap, tmp, k + 1);
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
-static int
-soap_begin_attachments(struct soap *soap)
+#ifndef WITH_LEAN
+/* returns the initial byte of the next CBOR data item after skipping its tags and sets *n to the argument of the item, returns EOF and sets soap->error on error */
+static soap_wchar
+soap_cbor_head_in(struct soap *soap, ULONG64 *n)
 {
-  if ((soap->mode & SOAP_ENC_MIME) && soap->mime.boundary && soap->mime.start)
+  for (;;)
   {
-    const char *s;
-    if (strlen(soap->mime.boundary) + strlen(soap->mime.start) + 140 > sizeof(soap->tmpbuf))
-      return soap->error = SOAP_EOM;
-    if ((soap->mode & SOAP_ENC_DIME) && !(soap->mode & SOAP_ENC_MTOM))
-    {
-      s = "application/dime";
-    }
-    else if (soap->version == 2)
+    soap_wchar c = soap_getchar(soap);
+    int k;
+    if ((int)c == EOF)
     {
-      if ((soap->mode & SOAP_ENC_MTOM))
-        s = "application/xop+xml; charset=utf-8; type=\"application/soap+xml\"";
-      else
-        s = "application/soap+xml; charset=utf-8";
+      if (!soap->error)
+        soap->error = SOAP_EOF;
+      return EOF;
     }
-    else if ((soap->mode & SOAP_ENC_MTOM))
+    k = c & 0x1F;
+    *n = k;
+    if (k >= 24 && k <= 27)
     {
-      s = "application/xop+xml; charset=utf-8; type=\"text/xml\"";
+      int i;
+      *n = 0;
+      for (i = 1 << (k - 24); i > 0; i--)
+      {
+        soap_wchar d = soap_getchar(soap);
+        if ((int)d == EOF)
+        {
+          if (!soap->error)
+            soap->error = SOAP_EOF;
+          return EOF;
+        }
+        *n = (*n << 8) | (ULONG64)d;
+      }
     }
-    else
+    else if (k > 27 && (k < 31 || (c >> 5) <= SOAP_CBOR_NINT || (c >> 5) == SOAP_CBOR_TAG))
     {
-      s = "text/xml; charset=utf-8";
+      soap->error = SOAP_SYNTAX_ERROR;
+      return EOF;
     }
-    (SOAP_SNPRINTF_SAFE(soap->tmpbuf, sizeof(soap->tmpbuf)), "--%s\r\nContent-Type: %s\r\nContent-Transfer-Encoding: binary\r\nContent-ID: %s\r\n\r\n", soap->mime.boundary, s, soap->mime.start);
-    if (soap_send(soap, soap->tmpbuf))
-      return soap->error;
-  }
-  if ((soap->mode & SOAP_IO_LENGTH))
-    soap->dime.size = (size_t)soap->count; /* DIME in MIME correction, soap->count is small */
-  if (!(soap->mode & SOAP_IO_LENGTH) && (soap->mode & SOAP_ENC_DIME))
-  {
-    if (soap_putdimehdr(soap))
-      return soap->error;
+    if ((c >> 5) != SOAP_CBOR_TAG)
+      return c;
   }
-  return SOAP_OK;
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
+#ifndef WITH_LEAN
+/* returns the next byte without consuming it, or EOF */
+static soap_wchar
+soap_cbor_peek(struct soap *soap)
+{
+  if (soap->ahead)
+    return soap->ahead;
+  return soap_get0(soap);
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* reads n bytes of a CBOR string directly from the input buffer, appends them to the look-aside buffer when lab is nonzero */
 static int
-soap_end_attachments(struct soap *soap)
+soap_cbor_raw_in(struct soap *soap, ULONG64 n, int lab)
 {
-  if ((soap->mode & SOAP_IO_LENGTH) && (soap->mode & SOAP_ENC_DIME) && !(soap->mode & SOAP_ENC_MTOM))
+  while (n > 0)
   {
-    if (soap->count > 0xFFFFFFFF)
-      return soap->error = SOAP_DIME_ERROR;
-    soap->dime.size = (size_t)soap->count - soap->dime.size;    /* DIME in MIME correction */
-    (SOAP_SNPRINTF(soap->id, sizeof(soap->id), strlen(soap->dime_id_format) + 20), soap->dime_id_format, 0);
-    soap->dime.id = soap->id;
-    if (soap->local_namespaces && soap->local_namespaces[0].id)
+    size_t k;
+    if (soap->bufidx >= soap->buflen && soap_recv(soap))
     {
-      if (soap->local_namespaces[0].out)
-        soap->dime.type = (char*)soap->local_namespaces[0].out;
-      else
-        soap->dime.type = (char*)soap->local_namespaces[0].ns;
+      if (!soap->error)
+        soap->error = SOAP_EOF;
+      return soap->error;
     }
-    soap->dime.options = NULL;
-    soap->dime.flags = SOAP_DIME_MB | SOAP_DIME_ABSURI;
-    if (!soap->dime.first)
-      soap->dime.flags |= SOAP_DIME_ME;
-    soap->count += 12 + ((strlen(soap->dime.id)+3)&(~3)) + (soap->dime.type ? ((strlen(soap->dime.type)+3)&(~3)) : 0);
+    k = soap->buflen - soap->bufidx;
+    if ((ULONG64)k > n)
+      k = (size_t)n;
+    if (lab && soap_append_lab(soap, soap->ibuf + soap->bufidx, k))
+      return soap->error;
+    soap->bufidx += k;
+    n -= k;
   }
-  if ((soap->mode & SOAP_ENC_DIME) && !(soap->mode & SOAP_ENC_MTOM))
-    return soap_send_raw(soap, SOAP_STR_PADDING, -(long)soap->dime.size&3);
   return SOAP_OK;
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
-static struct soap_multipart*
-soap_alloc_multipart(struct soap *soap, struct soap_multipart **first, struct soap_multipart **last, const char *ptr, size_t size)
+#ifndef WITH_LEAN
+/* reads a CBOR byte or text string with initial byte c and argument n into the look-aside buffer, '\0'-terminated, or skips it when lab is zero */
+static int
+soap_cbor_str(struct soap *soap, soap_wchar c, ULONG64 n, int lab)
 {
-  struct soap_multipart *content;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "New DIME/MIME attachment %p (%lu)\n", (void*)ptr, (unsigned long)size));
-  content = (struct soap_multipart*)soap_malloc(soap, sizeof(struct soap_multipart));
-  if (content)
+  soap->labidx = 0;
+  if ((c & 0x1F) == 31)
   {
-    content->next = NULL;
-    content->ptr = ptr;
-    content->size = size;
-    content->id = NULL;
-    content->type = NULL;
-    content->options = NULL;
-    content->encoding = SOAP_MIME_NONE;
-    content->location = NULL;
-    content->description = NULL;
-    if (!*first)
-      *first = content;
-    if (*last)
-      (*last)->next = content;
-    *last = content;
+    for (;;)
+    {
+      soap_wchar d = soap_cbor_head_in(soap, &n);
+      if ((int)d == EOF)
+        return soap->error;
+      if (d == 0xFF)
+        break;
+      if ((d >> 5) != (c >> 5) || (d & 0x1F) == 31)
+        return soap->error = SOAP_SYNTAX_ERROR;
+      if (soap_cbor_raw_in(soap, n, lab))
+        return soap->error;
+    }
   }
-  return content;
+  else if (soap_cbor_raw_in(soap, n, lab))
+  {
+    return soap->error;
+  }
+  if (lab)
+    return soap_append_lab(soap, "", 1);
+  return SOAP_OK;
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
+#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_set_dime_attachment(struct soap *soap, const char *ptr, size_t size, const char *type, const char *id, unsigned short optype, const char *option)
+soap_cbor_head_out(struct soap *soap, int major, ULONG64 n)
 {
-  struct soap_multipart *content = soap_alloc_multipart(soap, &soap->dime.first, &soap->dime.last, ptr, size);
-  if (!content)
-    return SOAP_EOM;
-  content->id = soap_strdup(soap, id);
-  content->type = soap_strdup(soap, type);
-  content->options = soap_dime_option(soap, optype, option);
-  return SOAP_OK;
+  major <<= 5;
+  if (n < 24)
+    return soap_cbor_send_arg(soap, major | (int)n, n, 0);
+  if (n <= 0xFF)
+    return soap_cbor_send_arg(soap, major | 24, n, 1);
+  if (n <= 0xFFFF)
+    return soap_cbor_send_arg(soap, major | 25, n, 2);
+  if (n <= 0xFFFFFFFFUL)
+    return soap_cbor_send_arg(soap, major | 26, n, 4);
+  return soap_cbor_send_arg(soap, major | 27, n, 8);
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
+#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_set_mime_attachment(struct soap *soap, const char *ptr, size_t size, enum soap_mime_encoding encoding, const char *type, const char *id, const char *location, const char *description)
+soap_cbor_begin_out(struct soap *soap, int major)
 {
-  struct soap_multipart *content = soap_alloc_multipart(soap, &soap->mime.first, &soap->mime.last, ptr, size);
-  if (!content)
-    return SOAP_EOM;
-  content->id = soap_strdup(soap, id);
-  content->type = soap_strdup(soap, type);
-  content->encoding = encoding;
-  content->location = soap_strdup(soap, location);
-  content->description = soap_strdup(soap, description);
-  return SOAP_OK;
+  return soap_cbor_send_arg(soap, (major << 5) | 31, 0, 0);
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
+#ifndef WITH_LEAN
 SOAP_FMAC1
-struct soap_multipart*
+int
 SOAP_FMAC2
-soap_next_multipart(struct soap_multipart *content)
+soap_cbor_end_out(struct soap *soap)
 {
-  if (content)
-    return content->next;
-  return NULL;
+  return soap_cbor_send_arg(soap, 0xFF, 0, 0);
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
-static void
-soap_select_mime_boundary(struct soap *soap)
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_cbor_int_out(struct soap *soap, LONG64 n)
 {
-  while (!soap->mime.boundary || soap_valid_mime_boundary(soap))
-  {
-    char *s = soap->mime.boundary;
-    size_t n = 0;
-    if (s)
-      n = strlen(s);
-    if (n < 16)
-    {
-      n = 64;
-      s = soap->mime.boundary = (char*)soap_malloc(soap, n + 1);
-      if (!s)
-        return;
-    }
-    *s++ = '=';
-    *s++ = '=';
-    n -= 4;
-    while (n)
-    {
-      *s++ = soap_base64o[soap_random & 0x3F];
-      n--;
-    }
-    *s++ = '=';
-    *s++ = '=';
-    *s = '\0';
-  }
-  if (!soap->mime.start)
-    soap->mime.start = "<SOAP-ENV:Envelope>";
+  if (n >= 0)
+    return soap_cbor_head_out(soap, SOAP_CBOR_UINT, (ULONG64)n);
+  return soap_cbor_head_out(soap, SOAP_CBOR_NINT, (ULONG64)(-1 - n));
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_LEANER
-static int
-soap_valid_mime_boundary(struct soap *soap)
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_cbor_float_out(struct soap *soap, float f)
 {
-  struct soap_multipart *content;
-  size_t k;
-  if (soap->fmimeread)
-    return SOAP_OK;
-  k = strlen(soap->mime.boundary);
-  for (content = soap->mime.first; content; content = content->next)
-  {
-    if (content->ptr && content->size >= k)
-    {
-      const char *p = (const char*)content->ptr;
-      size_t i;
-      for (i = 0; i < content->size - k; i++, p++)
-      {
-        if (!strncmp(p, soap->mime.boundary, k))
-          return SOAP_ERR;
-      }
-    }
-  }
-  return SOAP_OK;
+  soap_int32 n;
+  (void)soap_memcpy((void*)&n, sizeof(n), (const void*)&f, sizeof(f));
+  return soap_cbor_send_arg(soap, 0xFA, (ULONG64)n & 0xFFFFFFFFUL, 4);
 }
 #endif
 
 /******************************************************************************/
 
-#ifdef WITH_GZIP
-static int
-soap_getgziphdr(struct soap *soap)
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_cbor_double_out(struct soap *soap, double d)
 {
-  int i;
-  soap_wchar c = 0, f = 0;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Get gzip header\n"));
-  for (i = 0; i < 9; i++)
-  {
-    c = soap_get1(soap);
-    if (i == 1 && c == 8)
-      soap->z_dict = 0;
-    if (i == 2)
-      f = c;
-  }
-  if (f & 0x04) /* FEXTRA */
-  {
-    i = soap_get1(soap);
-    i |= soap_get1(soap) << 8;
-    while (i-- > 0)
-    {
-      if ((int)soap_get1(soap) == EOF)
-        return soap->error = SOAP_ZLIB_ERROR;
-    }
-  }
-  if (f & 0x08) /* skip FNAME */
-  {
-    do
-    {
-      c = soap_get1(soap);
-    } while (c && (int)c != EOF);
-  }
-  if ((int)c != EOF && (f & 0x10)) /* skip FCOMMENT */
-  {
-    do
-    {
-      c = soap_get1(soap);
-    } while (c && (int)c != EOF);
-  }
-  if ((int)c != EOF && (f & 0x02)) /* skip FHCRC (CRC32 is used) */
-  {
-    c = soap_get1(soap);
-    if ((int)c != EOF)
-      c = soap_get1(soap);
-  }
-  if ((int)c == EOF)
-    return soap->error = SOAP_ZLIB_ERROR;
-  return SOAP_OK;
+  ULONG64 n;
+  (void)soap_memcpy((void*)&n, sizeof(n), (const void*)&d, sizeof(d));
+  return soap_cbor_send_arg(soap, 0xFB, n, 8);
 }
 #endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_begin_serve(struct soap *soap)
+soap_cbor_bool_out(struct soap *soap, int b)
 {
-#ifdef WITH_FASTCGI
-  if (FCGI_Accept() < 0)
-  {
-    soap->error = SOAP_EOF;
-    return soap_send_fault(soap);
-  }
-#endif
-  soap_begin(soap);
-  if (soap_begin_recv(soap)
-   || soap_envelope_begin_in(soap)
-   || soap_recv_header(soap)
-   || soap_body_begin_in(soap))
-  {
-    if (soap->error < SOAP_STOP)
-    {
-#ifdef WITH_FASTCGI
-      (void)soap_send_fault(soap);
-#else
-      return soap_send_fault(soap);
-#endif
-    }
-    return soap_closesock(soap);
-  }
-  return SOAP_OK;
+  return soap_cbor_send_arg(soap, b ? 0xF5 : 0xF4, 0, 0);
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_begin_recv(struct soap *soap)
+soap_cbor_null_out(struct soap *soap)
 {
-  soap_wchar c;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Initializing for input from socket=%d/fd=%d\n", (int)soap->socket, soap->recvfd));
-  soap->error = SOAP_OK;
-#ifndef WITH_LEANER
-  soap->recverror = SOAP_OK;
-#endif
-  soap_free_temp(soap);
-  soap_set_local_namespaces(soap);
-  soap->version = 0;    /* don't assume we're parsing SOAP content by default */
-#ifndef WITH_NOIDREF
-  soap_free_iht(soap);
-#endif
-  if ((soap->imode & SOAP_IO) == SOAP_IO_CHUNK)
-  {
-    soap->imode &= ~SOAP_IO;
-    soap->omode = (soap->omode & ~SOAP_IO) | SOAP_IO_CHUNK;
-  }
-  soap->imode &= ~(SOAP_ENC_DIME | SOAP_ENC_MIME | SOAP_ENC_ZLIB);
-  soap->mode = soap->imode;
-  if (!(soap->mode & SOAP_IO_KEEPALIVE))
-    soap->keep_alive = 0;
-  if (!soap->keep_alive)
-    soap->buflen = soap->bufidx = 0;
-  soap->null = 0;
-  soap->position = 0;
-  soap->mustUnderstand = 0;
-  soap->shaky = 0;
-  soap->ahead = 0;
-  soap->peeked = 0;
-  soap->level = 0;
-  soap->part = SOAP_BEGIN_RECV;
-  soap->count = 0;
-  soap->length = 0;
-  soap->cdata = 0;
-  if (!(soap->mode & SOAP_ENC_PLAIN))
-  {
-    *soap->endpoint = '\0';
-    soap->action = NULL;
-    soap->fform = NULL;
-  }
-  soap->header = NULL;
-  soap->fault = NULL;
-  soap->status = 0;
-  soap->body = 1;
-#ifndef WITH_LEANER
-  soap->dom = NULL;
-  soap->dime.count = 0;
-  soap->dime.chunksize = 0;
-  soap->dime.buflen = 0;
-  soap->dime.list = NULL;
-  soap->dime.first = NULL;
-  soap->dime.last = NULL;
-  soap->mime.list = NULL;
-  soap->mime.first = NULL;
-  soap->mime.last = NULL;
-  soap->mime.boundary = NULL;
-  soap->mime.start = NULL;
-#endif
-#ifdef WIN32
-#ifndef UNDER_CE
-#ifndef WITH_FASTCGI
-  if (!soap_valid_socket(soap->socket) && !soap->is && soap->recvfd >= 0) /* Set win32 stdin or soap->recvfd to BINARY, e.g. to support DIME */
-#ifdef __BORLANDC__
-    setmode(soap->recvfd, _O_BINARY);
-#else
-    _setmode(soap->recvfd, _O_BINARY);
-#endif
-#endif
-#endif
-#endif
-#ifdef WITH_ZLIB
-  soap->zlib_in = SOAP_ZLIB_NONE;
-  soap->zlib_out = SOAP_ZLIB_NONE;
-  if (!soap->d_stream)
-  {
-    soap->d_stream = (z_stream*)SOAP_MALLOC(soap, sizeof(z_stream));
-    if (!soap->d_stream)
-      return soap->error = SOAP_EOM;
-    soap->d_stream->zalloc = Z_NULL;
-    soap->d_stream->zfree = Z_NULL;
-    soap->d_stream->opaque = Z_NULL;
-    soap->d_stream->next_in = Z_NULL;
-    soap->d_stream->msg = Z_NULL;
-  }
-  soap->d_stream->avail_in = 0;
-  soap->d_stream->next_out = (Byte*)soap->buf;
-  soap->d_stream->avail_out = sizeof(soap->buf);
-  soap->z_ratio_in = 1.0;
-#endif
-#ifdef WITH_OPENSSL
-  if (soap->ssl)
-    ERR_clear_error();
+  return soap_cbor_send_arg(soap, 0xF6, 0, 0);
+}
 #endif
+
+/******************************************************************************/
+
 #ifndef WITH_LEAN
-  soap->start = (ULONG64)time(NULL);
-#endif
-#ifndef WITH_LEANER
-  if (soap->fprepareinitrecv && (soap->error = soap->fprepareinitrecv(soap)) != SOAP_OK)
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_cbor_string_out(struct soap *soap, const char *s)
+{
+  size_t n;
+  if (!s)
+    return soap_cbor_null_out(soap);
+  n = strlen(s);
+  if (soap_cbor_head_out(soap, SOAP_CBOR_TEXT, (ULONG64)n))
     return soap->error;
+  return soap_send_raw(soap, s, n);
+}
 #endif
-  c = soap_getchar(soap);
-#ifdef WITH_GZIP
-  if (c == 0x1F)
-  {
-    if (soap_getgziphdr(soap))
-      return soap->error;
-    if (inflateInit2(soap->d_stream, -MAX_WBITS) != Z_OK)
-      return soap->error = SOAP_ZLIB_ERROR;
-    if (soap->z_dict)
-    {
-      if (inflateSetDictionary(soap->d_stream, (const Bytef*)soap->z_dict, soap->z_dict_len) != Z_OK)
-        return soap->error = SOAP_ZLIB_ERROR;
-    }
-    soap->zlib_state = SOAP_ZLIB_INFLATE;
-    soap->mode |= SOAP_ENC_ZLIB;
-    soap->zlib_in = SOAP_ZLIB_GZIP;
-    soap->z_crc = crc32(0L, NULL, 0);
-    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "gzip initialized\n"));
-    if (!soap->z_buf)
-      soap->z_buf = (char*)SOAP_MALLOC(soap, sizeof(soap->buf));
-    (void)soap_memcpy((void*)soap->z_buf, sizeof(soap->buf), (const void*)soap->buf, sizeof(soap->buf));
-    /* should not chunk over plain transport, so why bother to check? */
-    /* if ((soap->mode & SOAP_IO) == SOAP_IO_CHUNK) */
-    /*   soap->z_buflen = soap->bufidx; */
-    /* else */
-    soap->d_stream->next_in = (Byte*)(soap->z_buf + soap->bufidx);
-    soap->d_stream->avail_in = (unsigned int)(soap->buflen - soap->bufidx);
-    soap->z_buflen = soap->buflen;
-    soap->buflen = soap->bufidx;
-    c = ' ';
-  }
-#endif
-  while (soap_coblank(c))
-    c = soap_getchar(soap);
-#ifndef WITH_LEANER
-  if (c == '-' && soap_get0(soap) == '-')
-  {
-    soap->mode |= SOAP_ENC_MIME;
-  }
-  else if ((c & 0xFFFC) == (SOAP_DIME_VERSION | SOAP_DIME_MB) && (soap_get0(soap) & 0xFFF0) == 0x20)
-  {
-    soap->mode |= SOAP_ENC_DIME;
-  }
-  else
-#endif
-  {
-    /* skip BOM */
-    if (c == 0xEF && soap_get0(soap) == 0xBB)
-    {
-      soap_get1(soap);
-      c = soap_get1(soap);
-      if (c == 0xBF)
-      {
-        soap->mode &= ~SOAP_ENC_LATIN;
-        c = soap_getchar(soap);
-      }
-      else
-      {
-        c = (0x0F << 12) | (0xBB << 6) | (c & 0x3F); /* UTF-8 */
-      }
-    }
-    else if ((c == 0xFE && soap_get0(soap) == 0xFF)  /* UTF-16 BE */
-          || (c == 0xFF && soap_get0(soap) == 0xFE)) /* UTF-16 LE */
-    {
-      return soap->error = SOAP_UTF_ERROR;
-    }
-    /* skip space */
-    while (soap_coblank(c))
-      c = soap_getchar(soap);
-  }
-  if ((int)c == EOF)
-    return soap->error = SOAP_CHK_EOF;
-  soap_unget(soap, c);
-#ifndef WITH_NOHTTP
-  /* if not XML/MIME/DIME/ZLIB, assume HTTP method or status line */
-  if (((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) && !(soap->mode & (SOAP_ENC_MIME | SOAP_ENC_DIME | SOAP_ENC_ZLIB | SOAP_ENC_PLAIN)))
-  {
-    soap_mode m = soap->imode;
-    soap->error = soap->fparse(soap);
-    soap->mode = soap->imode; /* if imode is changed, effectuate */
-    soap->imode = m; /* restore imode */
-    if ((soap->mode & SOAP_IO) == SOAP_IO_CHUNK)
-    {
-      soap->chunkbuflen = soap->buflen;
-      soap->buflen = soap->bufidx;
-      soap->chunksize = 0;
-    }
-#ifdef WITH_ZLIB
-    soap->mode &= ~SOAP_ENC_ZLIB;
-    if (soap->zlib_in != SOAP_ZLIB_NONE)
-    {
-#ifdef WITH_GZIP
-      if (soap->zlib_in != SOAP_ZLIB_DEFLATE)
-      {
-        c = soap_get1(soap);
-        if (c == (int)EOF)
-          return soap->error = SOAP_EOF;
-        if (c == 0x1F)
-        {
-          if (soap_getgziphdr(soap))
-            return soap->error;
-          if (inflateInit2(soap->d_stream, -MAX_WBITS) != Z_OK)
-            return soap->error = SOAP_ZLIB_ERROR;
-          soap->z_crc = crc32(0L, NULL, 0);
-          DBGLOG(TEST, SOAP_MESSAGE(fdebug, "gzip initialized\n"));
-        }
-        else
-        {
-          soap_revget1(soap);
-          if (inflateInit(soap->d_stream) != Z_OK)
-            return soap->error = SOAP_ZLIB_ERROR;
-          soap->zlib_in = SOAP_ZLIB_DEFLATE;
-        }
-      }
-      else
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_cbor_bytes_out(struct soap *soap, const unsigned char *s, int n)
+{
+  if (!s)
+    return soap_cbor_null_out(soap);
+  if (n < 0)
+    n = 0;
+  if (soap_cbor_head_out(soap, SOAP_CBOR_BYTES, (ULONG64)n))
+    return soap->error;
+  return soap_send_raw(soap, (const char*)s, (size_t)n);
+}
 #endif
-      if (inflateInit(soap->d_stream) != Z_OK)
-        return soap->error = SOAP_ZLIB_ERROR;
-      if (soap->z_dict)
-      {
-        if (inflateSetDictionary(soap->d_stream, (const Bytef*)soap->z_dict, soap->z_dict_len) != Z_OK)
-          return soap->error = SOAP_ZLIB_ERROR;
-      }
-      soap->zlib_state = SOAP_ZLIB_INFLATE;
-      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Inflate initialized\n"));
-      soap->mode |= SOAP_ENC_ZLIB;
-      if (!soap->z_buf)
-        soap->z_buf = (char*)SOAP_MALLOC(soap, sizeof(soap->buf));
-      (void)soap_memcpy((void*)soap->z_buf, sizeof(soap->buf), (const void*)soap->buf, sizeof(soap->buf));
-      soap->d_stream->next_in = (Byte*)(soap->z_buf + soap->bufidx);
-      soap->d_stream->avail_in = (unsigned int)(soap->buflen - soap->bufidx);
-      soap->z_buflen = soap->buflen;
-      soap->buflen = soap->bufidx;
-    }
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_cbor_begin_in(struct soap *soap, int major, size_t *n)
+{
+  ULONG64 k;
+  soap_wchar c = soap_cbor_head_in(soap, &k);
+  if ((int)c == EOF)
+    return soap->error;
+  if ((c >> 5) != major)
+    return soap->error = SOAP_TYPE;
+  if ((c & 0x1F) == 31)
+    *n = (size_t)-1;
+  else if (k < (ULONG64)(size_t)-1)
+    *n = (size_t)k;
+  else
+    return soap->error = SOAP_LENGTH;
+  if (++soap->level > soap->maxlevel)
+    return soap->error = SOAP_LEVEL;
+  return SOAP_OK;
+}
 #endif
-#ifndef WITH_LEANER
-    if (soap->fpreparerecv && (soap->mode & SOAP_IO) != SOAP_IO_CHUNK && soap->buflen > soap->bufidx)
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_cbor_next_in(struct soap *soap, size_t *n)
+{
+  if (*n == (size_t)-1)
+  {
+    soap_wchar c = soap_cbor_peek(soap);
+    if ((int)c == EOF)
     {
-      int r;
-      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Invoking fpreparerecv\n"));
-      r = soap->fpreparerecv(soap, soap->buf + soap->bufidx, soap->buflen - soap->bufidx);
-      if (r)
-        return soap->error = r;
+      if (!soap->error)
+        soap->error = SOAP_EOF;
+      return 0;
     }
+    if (c != 0xFF)
+      return 1;
+    (void)soap_getchar(soap);
+  }
+  else if (*n > 0)
+  {
+    --*n;
+    return 1;
+  }
+  soap->level--;
+  return 0;
+}
 #endif
-    if (soap->error && soap->error < SOAP_STOP)
-    {
-      if (soap->status >= 200 && soap->status < 600)
-      {
-        const char *s = soap_http_get_body(soap, NULL);
-        (void)soap_end_recv(soap);
-        if (soap->status >= 300)
-          soap->keep_alive = 0; /* to force close */
-        return soap_set_receiver_error(soap, "HTTP Error", s, soap->status);
-      }
-      return soap->error;
-    }
-    if (!soap->body && soap->status >= 200 && soap->status < 600)
-      return soap->error = soap->status; /* client side received HTTP status code */
-    if (soap->status > SOAP_POST)
-    {
-      soap->fform = NULL;
-      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Invoking http method handler\n"));
-      switch (soap->status)
-      {
-        case SOAP_GET:
-          if (soap_http_skip_body(soap) || soap_end_recv(soap))
-            return soap->error;
-          soap->error = soap->fget(soap);
-          break;
-        case SOAP_PUT:
-          soap->error = soap->fput(soap);
-          break;
-        case SOAP_PATCH:
-          soap->error = soap->fpatch(soap);
-          break;
-        case SOAP_DEL:
-          if (soap_http_skip_body(soap) || soap_end_recv(soap))
-            return soap->error;
-          soap->error = soap->fdel(soap);
-          break;
-        case SOAP_HEAD:
-          if (soap_http_skip_body(soap) || soap_end_recv(soap))
-            return soap->error;
-          soap->error = soap->fhead(soap);
-          break;
-        case SOAP_OPTIONS:
-          if (soap_http_skip_body(soap) || soap_end_recv(soap))
-            return soap->error;
-          soap->error = soap->fopt(soap);
-          break;
-        default:
-          if (soap_http_skip_body(soap) || soap_end_recv(soap))
-            return soap->error;
-          return 405;
-      }
-      if (soap->error == SOAP_OK)
-        return soap->error = SOAP_STOP; /* prevents further processing and calls soap_closesock() */
-      if (soap->error != SOAP_FORM || !soap->fform) /* continue if handler returned SOAP_FORM */
-        return soap->error;
-      soap->error = SOAP_OK;
-    }
-    if (soap->fform)
-    {
-      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Invoking http post/form handler\n"));
-      soap->error = soap->fform(soap);
-      soap->fform = NULL;
-      if (soap->error == SOAP_OK)
-        return soap->error = SOAP_STOP; /* prevents further processing */
-      if (soap->status != SOAP_POST || soap->error != 404) /* continue with POST if handler returned HTTP not found */
-        return soap->error;
-      soap->error = SOAP_OK;
-    }
-    if (!soap->body)
-      return soap->error = SOAP_NO_DATA;
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+const char *
+SOAP_FMAC2
+soap_cbor_key_in(struct soap *soap)
+{
+  ULONG64 n;
+  soap_wchar c = soap_cbor_head_in(soap, &n);
+  if ((int)c == EOF)
+    return NULL;
+  if ((c >> 5) != SOAP_CBOR_TEXT)
+  {
+    soap->error = SOAP_TYPE;
+    return NULL;
   }
-  else if (soap->fform)
+  if (soap_cbor_str(soap, c, n, 1))
+    return NULL;
+  return soap->labbuf;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+const char *
+SOAP_FMAC2
+soap_cbor_string_in(struct soap *soap)
+{
+  ULONG64 n;
+  soap_wchar c = soap_cbor_head_in(soap, &n);
+  if ((int)c == EOF || c == 0xF6 || c == 0xF7)
+    return NULL;
+  if ((c >> 5) != SOAP_CBOR_TEXT)
   {
-    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Invoking http form handler\n"));
-    soap->error = soap->fform(soap);
-    soap->fform = NULL;
-    if (soap->error == SOAP_OK)
-      return soap->error = SOAP_STOP; /* prevents further processing */
-    if (soap->error != 404) /* continue with POST if handler returned HTTP not found */
-      return soap->error;
-    soap->error = SOAP_OK;
+    soap->error = SOAP_TYPE;
+    return NULL;
   }
+  if (soap_cbor_str(soap, c, n, 1))
+    return NULL;
+  return soap->labbuf;
+}
 #endif
-#ifndef WITH_LEANER
-  if ((soap->mode & SOAP_ENC_MIME))
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+const unsigned char *
+SOAP_FMAC2
+soap_cbor_bytes_in(struct soap *soap, int *size)
+{
+  ULONG64 n;
+  soap_wchar c = soap_cbor_head_in(soap, &n);
+  *size = 0;
+  if ((int)c == EOF || c == 0xF6 || c == 0xF7)
+    return NULL;
+  if ((c >> 5) != SOAP_CBOR_BYTES)
   {
-    do /* skip preamble */
-    {
-      c = soap_getchar(soap);
-      if ((int)c == EOF)
-        return soap->error = SOAP_CHK_EOF;
-    } while (c != '-' || soap_get0(soap) != '-');
-    soap_unget(soap, c);
-    if (soap_getmimehdr(soap))
-      return soap->error;
-    if (soap->mime.start)
-    {
-      do
-      {
-        if (!soap->mime.last->id)
-          break;
-        if (!soap_match_cid(soap, soap->mime.start, soap->mime.last->id))
-          break;
-      } while (soap_recv_mime_attachment(soap, NULL));
-    }
-    if (soap_http_header_attribute(soap, soap->mime.first->type, "application/dime"))
-      soap->mode |= SOAP_ENC_DIME;
+    soap->error = SOAP_TYPE;
+    return NULL;
   }
-  if ((soap->mode & SOAP_ENC_DIME))
+  if (soap_cbor_str(soap, c, n, 1))
+    return NULL;
+  if (soap->labidx > 0x7FFFFFFF)
   {
-    if (soap_getdimehdr(soap))
-      return soap->error;
-    if ((soap->dime.flags & SOAP_DIME_CF))
+    soap->error = SOAP_LENGTH;
+    return NULL;
+  }
+  *size = (int)(soap->labidx - 1);
+  return (const unsigned char*)soap->labbuf;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_cbor_int_in(struct soap *soap, LONG64 *p)
+{
+  ULONG64 n;
+  soap_wchar c = soap_cbor_head_in(soap, &n);
+  if ((int)c == EOF)
+    return soap->error;
+  if ((c >> 5) <= SOAP_CBOR_NINT)
+  {
+    if (n >= ((ULONG64)1 << 63))
+      return soap->error = SOAP_TYPE;
+    *p = (c >> 5) == SOAP_CBOR_UINT ? (LONG64)n : -1 - (LONG64)n;
+  }
+  else if (c != 0xF6 && c != 0xF7)
+  {
+    return soap->error = SOAP_TYPE;
+  }
+  return SOAP_OK;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_cbor_uint_in(struct soap *soap, ULONG64 *p)
+{
+  ULONG64 n;
+  soap_wchar c = soap_cbor_head_in(soap, &n);
+  if ((int)c == EOF)
+    return soap->error;
+  if ((c >> 5) == SOAP_CBOR_UINT)
+    *p = n;
+  else if (c != 0xF6 && c != 0xF7)
+    return soap->error = SOAP_TYPE;
+  return SOAP_OK;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+SOAP_FMAC1
+int
+SOAP_FMAC2
+soap_cbor_double_in(struct soap *soap, double *p)
+{
+  ULONG64 n;
+  soap_wchar c = soap_cbor_head_in(soap, &n);
+  if ((int)c == EOF)
+    return soap->error;
+  switch (c)
+  {
+    case 0xF9: /* half precision, widened to single precision */
     {
-      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Chunked SOAP in DIME message\n"));
-      soap->dime.chunksize = soap->dime.size;
-      if (soap->buflen - soap->bufidx >= soap->dime.chunksize)
+      unsigned long m = (unsigned long)(n & 0x3FF), e = (unsigned long)((n >> 10) & 0x1F);
+      n = (n & 0x8000) << 16;
+      if (e == 0x1F)
       {
-        soap->dime.buflen = soap->buflen;
-        soap->buflen = soap->bufidx + soap->dime.chunksize;
+        n |= 0x7F800000 | (m << 13);
       }
-      else
+      else if (e)
       {
-        soap->dime.chunksize -= soap->buflen - soap->bufidx;
+        n |= ((e + 112) << 23) | (m << 13);
+      }
+      else if (m)
+      {
+        e = 113;
+        do
+        {
+          m <<= 1;
+          e--;
+        } while (!(m & 0x400));
+        n |= (e << 23) | ((m & 0x3FF) << 13);
       }
     }
-    soap->count = soap->buflen - soap->bufidx;
-    if (soap->recv_maxlength && soap->count > soap->recv_maxlength)
-      return soap->error = SOAP_EOF;
+    /* fall through */
+    case 0xFA:
+    {
+      soap_int32 i = (soap_int32)n;
+      float f;
+      (void)soap_memcpy((void*)&f, sizeof(f), (const void*)&i, sizeof(i));
+      *p = (double)f;
+      break;
+    }
+    case 0xFB:
+      (void)soap_memcpy((void*)p, sizeof(double), (const void*)&n, sizeof(n));
+      break;
+    case 0xF6:
+    case 0xF7:
+      break;
+    default:
+      if ((c >> 5) == SOAP_CBOR_UINT)
+        *p = (double)n;
+      else if ((c >> 5) == SOAP_CBOR_NINT)
+        *p = -1.0 - (double)n;
+      else
+        return soap->error = SOAP_TYPE;
   }
-#endif
   return SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_envelope_begin_out(struct soap *soap)
+soap_cbor_bool_in(struct soap *soap, int *p)
 {
-  if (soap->version == 0)
-    return SOAP_OK;
-  soap->part = SOAP_IN_ENVELOPE;
-  return soap_element_begin_out(soap, "SOAP-ENV:Envelope", 0, NULL);
+  ULONG64 n;
+  soap_wchar c = soap_cbor_head_in(soap, &n);
+  if ((int)c == EOF)
+    return soap->error;
+  if (c == 0xF4 || c == 0xF5)
+    *p = (c == 0xF5);
+  else if (c != 0xF6 && c != 0xF7)
+    return soap->error = SOAP_TYPE;
+  return SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_envelope_end_out(struct soap *soap)
+soap_cbor_null_in(struct soap *soap)
 {
-  if (soap->version == 0)
-    return SOAP_OK;
-  if (soap_element_end_out(soap, "SOAP-ENV:Envelope")
-   || soap_send_raw(soap, "\r\n", 2))   /* 2.8: always emit \r\n */
-    return soap->error;
-  soap->part = SOAP_END_ENVELOPE;
-  return SOAP_OK;
+  soap_wchar c = soap_cbor_peek(soap);
+  if (c == 0xF6 || c == 0xF7)
+  {
+    (void)soap_getchar(soap);
+    return 1;
+  }
+  return 0;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEAN
 SOAP_FMAC1
 int
 SOAP_FMAC2
-soap_http_has_body(struct soap *soap)
+soap_cbor_ignore_in(struct soap *soap)
 {
-  return soap->length || (soap->mode & SOAP_ENC_ZLIB) || (soap->mode & SOAP_IO) == SOAP_IO_CHUNK;
+  ULONG64 n;
+  soap_wchar c = soap_cbor_head_in(soap, &n);
+  if ((int)c == EOF)
+    return soap->error;
+  switch (c >> 5)
+  {
+    case SOAP_CBOR_BYTES:
+    case SOAP_CBOR_TEXT:
+      return soap_cbor_str(soap, c, n, 0);
+    case SOAP_CBOR_ARRAY:
+    case SOAP_CBOR_MAP:
+      if (++soap->level > soap->maxlevel)
+        return soap->error = SOAP_LEVEL;
+      if ((c & 0x1F) == 31)
+      {
+        for (;;)
+        {
+          soap_wchar d = soap_cbor_peek(soap);
+          if ((int)d == EOF)
+            return soap->error ? soap->error : (soap->error = SOAP_EOF);
+          if (d == 0xFF)
+            break;
+          if (soap_cbor_ignore_in(soap) || ((c >> 5) == SOAP_CBOR_MAP && soap_cbor_ignore_in(soap)))
+            return soap->error;
+        }
+        (void)soap_getchar(soap);
+      }
+      else
+      {
+        for (; n > 0; n--)
+          if (soap_cbor_ignore_in(soap) || ((c >> 5) == SOAP_CBOR_MAP && soap_cbor_ignore_in(soap)))
+            return soap->error;
+      }
+      soap->level--;
+      break;
+    default:
+      if (c == 0xFF)
+        return soap->error = SOAP_SYNTAX_ERROR;
+  }
+  return SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_http_skip_body(struct soap *soap)
+#ifndef WITH_LEAN
+/* returns the binary XML encoder or decoder state *bp, allocated on first use */
+static struct soap_bxml *
+soap_bxml_state(struct soap *soap, struct soap_bxml **bp)
 {
-  ULONG64 k = soap->length;
-  /* check HTTP body, return "" if none */
-  if (!k && !(soap->mode & SOAP_ENC_ZLIB) && (soap->mode & SOAP_IO) != SOAP_IO_CHUNK)
-    return SOAP_OK;
-  /* do not consume DIME or MIME attachments, leave this to soap_end_recv */
-  if ((soap->mode & SOAP_ENC_DIME) || (soap->mode & SOAP_ENC_MIME))
-    return SOAP_OK;
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Skipping HTTP body (mode=0x%x)\n", soap->mode));
-  if (k && !(soap->mode & SOAP_ENC_ZLIB))
+  if (!*bp)
   {
-    ULONG64 i;
-    soap->length = 0;
-    for (i = 0; i < k; i++)
+    *bp = (struct soap_bxml*)SOAP_MALLOC(soap, sizeof(struct soap_bxml));
+    if (!*bp)
     {
-      soap_wchar c = soap_get1(soap);
-      if ((int)c == EOF)
-        break;
+      soap->error = SOAP_EOM;
+      return NULL;
     }
+    memset((void*)*bp, 0, sizeof(struct soap_bxml));
   }
-  else
+  return *bp;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* empties a binary XML string table */
+static void
+soap_bxml_reset(struct soap_bxml_table *tp)
+{
+  tp->len = 0;
+  tp->num = 0;
+  if (tp->hash)
+    memset((void*)tp->hash, 0, SOAP_BXML_HASHLEN * sizeof(size_t));
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* resets the binary XML encoder or decoder state *bp to start a message */
+static int
+soap_bxml_begin(struct soap *soap, struct soap_bxml **bp)
+{
+  struct soap_bxml *p = soap_bxml_state(soap, bp);
+  if (!p)
+    return soap->error;
+  soap_bxml_reset(&p->names);
+  soap_bxml_reset(&p->values);
+  soap_bxml_reset(&p->stack);
+  return SOAP_OK;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* deallocates a binary XML string table */
+static void
+soap_bxml_free_table(struct soap *soap, struct soap_bxml_table *tp)
+{
+  (void)soap;
+  if (tp->buf)
+    SOAP_FREE(soap, tp->buf);
+  if (tp->off)
+    SOAP_FREE(soap, tp->off);
+  if (tp->hash)
+    SOAP_FREE(soap, tp->hash);
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* deallocates the binary XML encoder or decoder state *bp */
+static void
+soap_bxml_free(struct soap *soap, struct soap_bxml **bp)
+{
+  if (*bp)
   {
-    for (;;)
+    soap_bxml_free_table(soap, &(*bp)->names);
+    soap_bxml_free_table(soap, &(*bp)->values);
+    soap_bxml_free_table(soap, &(*bp)->stack);
+    if ((*bp)->buf)
+      SOAP_FREE(soap, (*bp)->buf);
+    SOAP_FREE(soap, *bp);
+    *bp = NULL;
+  }
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* returns the hash table slot of the string s of n bytes */
+static size_t
+soap_bxml_hash(const char *s, size_t n)
+{
+  size_t h = 0;
+  while (n-- > 0)
+    h = (unsigned char)*s++ + (h << 6) + (h << 16) - h;
+  return h & (SOAP_BXML_HASHLEN - 1);
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* appends the string s of n bytes to a binary XML string table, indexed in its hash table when hash is nonzero */
+static int
+soap_bxml_add(struct soap *soap, struct soap_bxml_table *tp, const char *s, size_t n, int hash)
+{
+  if (tp->len + n + 1 > tp->size)
+  {
+    size_t k = tp->size ? tp->size : SOAP_LABLEN;
+    char *buf;
+    while (k < tp->len + n + 1)
     {
-      soap_wchar c = soap_get1(soap);
-      if ((int)c == EOF)
-        break;
+      if (k << 1 < k)
+        return soap->error = SOAP_EOM;
+      k <<= 1;
+    }
+    if (SOAP_MAXALLOCSIZE > 0 && k > SOAP_MAXALLOCSIZE)
+      return soap->error = SOAP_EOM;
+    buf = (char*)SOAP_MALLOC(soap, k);
+    if (!buf)
+      return soap->error = SOAP_EOM;
+    if (tp->buf)
+    {
+      (void)soap_memcpy((void*)buf, k, (const void*)tp->buf, tp->len);
+      SOAP_FREE(soap, tp->buf);
+    }
+    tp->buf = buf;
+    tp->size = k;
+  }
+  if (tp->num >= tp->max)
+  {
+    size_t k = tp->max ? 2 * tp->max : 64;
+    size_t *off = (size_t*)SOAP_MALLOC(soap, k * sizeof(size_t));
+    if (!off)
+      return soap->error = SOAP_EOM;
+    if (tp->off)
+    {
+      (void)soap_memcpy((void*)off, k * sizeof(size_t), (const void*)tp->off, tp->num * sizeof(size_t));
+      SOAP_FREE(soap, tp->off);
+    }
+    tp->off = off;
+    tp->max = k;
+  }
+  if (hash)
+  {
+    size_t h;
+    if (!tp->hash)
+    {
+      tp->hash = (size_t*)SOAP_MALLOC(soap, SOAP_BXML_HASHLEN * sizeof(size_t));
+      if (!tp->hash)
+        return soap->error = SOAP_EOM;
+      memset((void*)tp->hash, 0, SOAP_BXML_HASHLEN * sizeof(size_t));
     }
+    for (h = soap_bxml_hash(s, n); tp->hash[h]; h = (h + 1) & (SOAP_BXML_HASHLEN - 1))
+      continue;
+    tp->hash[h] = tp->num + 1;
+  }
+  (void)soap_memcpy((void*)(tp->buf + tp->len), tp->size - tp->len, (const void*)s, n);
+  tp->buf[tp->len + n] = '\0';
+  tp->off[tp->num++] = tp->len;
+  tp->len += n + 1;
+  return SOAP_OK;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* returns the number + 1 of the string s of n bytes in a hashed binary XML string table, or 0 when not found */
+static size_t
+soap_bxml_find(const struct soap_bxml_table *tp, const char *s, size_t n)
+{
+  size_t h;
+  if (!tp->hash)
+    return 0;
+  for (h = soap_bxml_hash(s, n); tp->hash[h]; h = (h + 1) & (SOAP_BXML_HASHLEN - 1))
+  {
+    const char *t = tp->buf + tp->off[tp->hash[h] - 1];
+    if (!strncmp(t, s, n) && !t[n])
+      return tp->hash[h];
+  }
+  return 0;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* copies binary XML string table tq to tp */
+static int
+soap_bxml_copy_table(struct soap *soap, struct soap_bxml_table *tp, const struct soap_bxml_table *tq)
+{
+  size_t i;
+  for (i = 0; i < tq->num; i++)
+  {
+    const char *s = tq->buf + tq->off[i];
+    if (soap_bxml_add(soap, tp, s, strlen(s), 0))
+      return soap->error;
   }
   return SOAP_OK;
 }
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* copies the binary XML decoder state of soap to copy, to continue reading the message with copy */
+static int
+soap_bxml_copy(struct soap *copy, const struct soap *soap)
+{
+  const struct soap_bxml *bp = soap->bxml_in;
+  if (!bp)
+    return SOAP_OK;
+  if (soap_bxml_begin(copy, &copy->bxml_in)
+   || soap_bxml_copy_table(copy, &copy->bxml_in->names, &bp->names)
+   || soap_bxml_copy_table(copy, &copy->bxml_in->values, &bp->values)
+   || soap_bxml_copy_table(copy, &copy->bxml_in->stack, &bp->stack))
+    return copy->error;
+  return SOAP_OK;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* returns the scratch buffer of binary XML state bp enlarged to hold at least n bytes, or NULL */
+static char *
+soap_bxml_buf(struct soap *soap, struct soap_bxml *bp, size_t n)
+{
+  if (n > bp->size || !bp->buf)
+  {
+    size_t k = bp->size ? bp->size : SOAP_LABLEN;
+    while (k < n)
+    {
+      if (k << 1 < k)
+      {
+        soap->error = SOAP_EOM;
+        return NULL;
+      }
+      k <<= 1;
+    }
+    if (SOAP_MAXALLOCSIZE > 0 && k > SOAP_MAXALLOCSIZE)
+    {
+      soap->error = SOAP_EOM;
+      return NULL;
+    }
+    if (bp->buf)
+      SOAP_FREE(soap, bp->buf);
+    bp->size = 0;
+    bp->buf = (char*)SOAP_MALLOC(soap, k);
+    if (!bp->buf)
+    {
+      soap->error = SOAP_EOM;
+      return NULL;
+    }
+    bp->size = k;
+  }
+  return bp->buf;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* stores the UTF-8 encoding of char c at t, returns its length */
+static size_t
+soap_bxml_utf8(char *t, unsigned long c)
+{
+  size_t i, n;
+  if (c < 0x80)
+  {
+    *t = (char)c;
+    return 1;
+  }
+  n = c < 0x0800 ? 2 : c < 0x010000 ? 3 : c < 0x200000 ? 4 : c < 0x04000000 ? 5 : 6;
+  for (i = n - 1; i > 0; i--)
+  {
+    t[i] = (char)(0x80 | (c & 0x3F));
+    c >>= 6;
+  }
+  t[0] = (char)(((0xFF00 >> n) & 0xFF) | c);
+  return n;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* decodes the UTF-8 char at *s and advances *s */
+static unsigned long
+soap_bxml_getutf8(const char **s)
+{
+  const unsigned char *r = (const unsigned char*)*s;
+  unsigned long c = *r++;
+  if (c >= 0xC0)
+  {
+    int n = c >= 0xFC ? 5 : c >= 0xF8 ? 4 : c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : 1;
+    c &= 0x3F >> n;
+    while (n-- > 0 && (*r & 0xC0) == 0x80)
+      c = (c << 6) | (*r++ & 0x3F);
+  }
+  *s = (const char*)r;
+  return c;
+}
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-char *
-SOAP_FMAC2
-soap_http_get_body(struct soap *soap, size_t *len)
+#ifndef WITH_LEAN
+/* converts UTF-8 string s in place to 8-bit chars, chars above U+00FF are truncated like the XML parser does */
+static void
+soap_bxml_latin(char *s)
 {
-  return soap_http_get_body_prefix(soap, len, NULL);
+  const char *r = s;
+  while (*r)
+    *s++ = (char)(soap_bxml_getutf8(&r) & 0xFF);
+  *s = '\0';
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-char *
-SOAP_FMAC2
-soap_http_get_form(struct soap *soap)
+#ifndef WITH_LEAN
+/* sends binary XML token c */
+static int
+soap_bxml_put(struct soap *soap, int c)
 {
-  return soap_http_get_body_prefix(soap, NULL, "?");
+  char t = (char)c;
+  return soap_send_raw(soap, &t, 1);
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-char *
-SOAP_FMAC2
-soap_http_get_body_prefix(struct soap *soap, size_t *len, const char *prefix)
+#ifndef WITH_LEAN
+/* sends binary XML token c, unless zero, followed by n as a varint of 7 bits per byte, least significant first */
+static int
+soap_bxml_put_num(struct soap *soap, int c, ULONG64 n)
 {
-  char *s;
-  ULONG64 k = soap->length;
-  size_t n = 0;
-  if (!prefix)
-    prefix = SOAP_STR_EOS;
-  else
-    n = strlen(prefix);
-  if (len)
-    *len = 0;
-  /* check HTTP body, return "" if none */
-  if (!k && !(soap->mode & SOAP_ENC_PLAIN) && !(soap->mode & SOAP_ENC_ZLIB) && (soap->mode & SOAP_IO) != SOAP_IO_CHUNK)
-    return soap_strdup(soap, prefix);
-  /* do not consume DIME or MIME attachments, leave this to soap_end_recv */
-  if ((soap->mode & SOAP_ENC_DIME) || (soap->mode & SOAP_ENC_MIME))
-    return soap_strdup(soap, prefix);
-  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Parsing HTTP body, prefixed with '%s' (mode=0x%x)\n", prefix, soap->mode));
-  if (k && !(soap->mode & SOAP_ENC_ZLIB))
-  {
-    char *t;
-    size_t j;
-    soap->length = 0;
-    /* http content length != 0 and uncompressed body and body length does not exceed size_t max size */
-    if ((SOAP_MAXALLOCSIZE != 0 && n + k > SOAP_MAXALLOCSIZE) || n + k > (ULONG64)((size_t)-2))
-    {
-      soap->error = SOAP_EOM;
-      return NULL;
-    }
-    j = (size_t)k; /* safe cast: k is in size_t range as guarded above */
-    s = t = (char*)soap_malloc(soap, j + n + 1);
-    if (s)
-    {
-      size_t i = 0;
-      if (n)
-      {
-        (void)soap_memcpy(t, n, prefix, n);
-        t += n;
-      }
-      if (soap->ahead && j > 0)
-      {
-        *t++ = soap->ahead;
-        ++i;
-        soap->ahead = 0;
-      }
-      while (i < j)
-      {
-        size_t m;
-        if (soap->bufidx >= soap->buflen)
-          if (soap_recv(soap))
-            break;
-        if (soap->buflen - soap->bufidx > j - i)
-          m = j - i;
-        else
-          m = soap->buflen - soap->bufidx;
-        (void)soap_memcpy(t, j + n + 1 - i, soap->buf + soap->bufidx, m);
-        soap->bufidx += m;
-        t += m;
-        i += m;
-      }
-      *t = '\0';
-      if (len)
-        *len = n + i;
-    }
-    else
-    {
-      soap->error = SOAP_EOM;
-      return NULL;
-    }
-  }
-  else
+  char tmp[11];
+  size_t i = 0;
+  if (c)
+    tmp[i++] = (char)c;
+  while (n >= 0x80)
   {
-    size_t i, l = 0;
-    if (soap_alloc_block(soap) == NULL)
-      return NULL;
-    if (n)
-    {
-      s = (char*)soap_push_block(soap, NULL, n);
-      if (!s)
-        return NULL;
-      (void)soap_memcpy(s, n, prefix, n);
-      l += n;
-    }
-    if (soap->ahead)
-    {
-      s = (char*)soap_push_block(soap, NULL, 1);
-      if (!s)
-        return NULL;
-      *s = soap->ahead;
-      ++l;
-      soap->ahead = 0;
-    }
-    for (;;)
-    {
-      size_t k = SOAP_BLKLEN;
-      s = (char*)soap_push_block(soap, NULL, k);
-      if (!s)
-        return NULL;
-      i = 0;
-      while (i < k)
-      {
-        size_t m;
-        if (soap->bufidx >= soap->buflen)
-          if (soap_recv(soap))
-            goto end;
-        if (soap->buflen - soap->bufidx > k - i)
-          m = k - i;
-        else
-          m = soap->buflen - soap->bufidx;
-        (void)soap_memcpy(s, k - i, soap->buf + soap->bufidx, m);
-        soap->bufidx += m;
-        s += m;
-        i += m;
-        if (l + m < l)
-        {
-          soap->error = SOAP_EOM;
-          return NULL;
-        }
-        l += m;
-      }
-    }
-end:
-    *s = '\0';
-    if (len)
-      *len = l;
-    soap_size_block(soap, NULL, i + 1);
-    s = (char*)soap_save_block(soap, NULL, NULL, 0);
+    tmp[i++] = (char)(0x80 | (n & 0x7F));
+    n >>= 7;
   }
-  return s;
+  tmp[i++] = (char)n;
+  return soap_send_raw(soap, tmp, i);
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_envelope_begin_in(struct soap *soap)
+#ifndef WITH_LEAN
+/* sends binary XML token c followed by the name s of n bytes as a number in the name table or as a new name */
+static int
+soap_bxml_name_out(struct soap *soap, int c, const char *s, size_t n)
 {
-  soap->part = SOAP_IN_ENVELOPE;
-  if (soap_element_begin_in(soap, "SOAP-ENV:Envelope", 0, NULL))
-  {
-    if (soap->error == SOAP_TAG_MISMATCH)
-    {
-      if (!soap_element_begin_in(soap, ":Envelope", 0, NULL))
-        return soap->error = SOAP_VERSIONMISMATCH;
-      if (soap->status == 0
-           || (soap->status >= 200 && soap->status <= 299)
-           || soap->status == 400
-           || soap->status == 500)
-        return soap->error = SOAP_OK; /* allow non-SOAP (REST) XML content to be captured */
-      soap->error = soap->status;
-    }
-    else if (soap->status)
-    {
-      soap->error = soap->status;
-    }
+  struct soap_bxml *bp = soap_bxml_state(soap, &soap->bxml_out);
+  size_t k;
+  if (!bp)
     return soap->error;
-  }
-  soap_version(soap);
-  return SOAP_OK;
+  k = soap_bxml_find(&bp->names, s, n);
+  if (k)
+    return soap_bxml_put_num(soap, c, k);
+  if (bp->names.num < SOAP_BXML_MAXNUM && soap_bxml_add(soap, &bp->names, s, n, 1))
+    return soap->error;
+  if (soap_bxml_put_num(soap, c, 0)
+   || soap_bxml_put_num(soap, 0, n))
+    return soap->error;
+  return soap_send_raw(soap, s, n);
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_envelope_end_in(struct soap *soap)
+#ifndef WITH_LEAN
+/* sends binary XML token c, unless zero, followed by the UTF-8 value s of n bytes as a number in the value table or as a new value */
+static int
+soap_bxml_value_out(struct soap *soap, int c, const char *s, size_t n)
 {
-  if (soap->version == 0)
-    return SOAP_OK;
-  soap->part = SOAP_END_ENVELOPE;
-  return soap_element_end_in(soap, "SOAP-ENV:Envelope");
+  struct soap_bxml *bp = soap_bxml_state(soap, &soap->bxml_out);
+  if (!bp)
+    return soap->error;
+  if (n <= SOAP_BXML_MAXLEN)
+  {
+    size_t k = soap_bxml_find(&bp->values, s, n);
+    if (k)
+      return soap_bxml_put_num(soap, c, k);
+    if (bp->values.num < SOAP_BXML_MAXNUM && soap_bxml_add(soap, &bp->values, s, n, 1))
+      return soap->error;
+  }
+  if (soap_bxml_put_num(soap, c, 0)
+   || soap_bxml_put_num(soap, 0, n))
+    return soap->error;
+  return soap_send_raw(soap, s, n);
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_body_begin_out(struct soap *soap)
-{
-  if (soap->version == 1)
-    soap->encoding = 1;
 #ifndef WITH_LEAN
-  if ((soap->mode & SOAP_SEC_WSUID) && soap_set_attr(soap, "wsu:Id", "Body", 1))
-    return soap->error;
+/* converts string s to UTF-8 like soap_string_out() does with flag, returns s or the UTF-8 string in the scratch buffer and sets *n to its length */
+static const char *
+soap_bxml_utf8_out(struct soap *soap, const char *s, int flag, size_t *n)
+{
+  struct soap_bxml *bp;
+  const char *r;
+  char *t;
+  for (r = s; *r; r++)
+    if ((*r & 0x80))
+      break;
+  *n = r - s;
+  if (!*r)
+    return s;
+  *n += strlen(r);
+#if !defined(WITH_LEANER) && defined(HAVE_MBTOWC)
+  if (!(soap->mode & SOAP_C_MBSTRING))
 #endif
-  if (soap->version == 0)
-    return SOAP_OK;
-  soap->part = SOAP_IN_BODY;
-  return soap_element_begin_out(soap, "SOAP-ENV:Body", 0, NULL);
+  {
+#ifndef WITH_NOSTRINGTOUTF8
+    if (flag == 2 || (soap->mode & SOAP_C_UTFSTRING))
+#endif
+      return s;
+  }
+  bp = soap_bxml_state(soap, &soap->bxml_out);
+  if (!bp || !soap_bxml_buf(soap, bp, 6 * *n))
+    return NULL;
+  t = bp->buf;
+  while (*s)
+  {
+    unsigned long c = (unsigned char)*s++;
+#if !defined(WITH_LEANER) && defined(HAVE_MBTOWC)
+    if ((soap->mode & SOAP_C_MBSTRING))
+    {
+      wchar_t wc;
+      int m = mbtowc(&wc, s - 1, MB_CUR_MAX);
+      if (m > 0)
+      {
+        c = (unsigned long)wc;
+        s += m - 1;
+      }
+    }
+#endif
+    t += soap_bxml_utf8(t, c);
+  }
+  *n = t - bp->buf;
+  return bp->buf;
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_body_end_out(struct soap *soap)
+#ifndef WITH_LEAN
+/* sends string s as a binary XML text value, converted to UTF-8 like soap_string_out() does with flag */
+static int
+soap_bxml_string_out(struct soap *soap, const char *s, int flag)
 {
-  if (soap->version == 0)
+  size_t n;
+  if (!*s)
     return SOAP_OK;
-  if (soap_element_end_out(soap, "SOAP-ENV:Body"))
+  s = soap_bxml_utf8_out(soap, s, flag, &n);
+  if (!s)
     return soap->error;
-  soap->part = SOAP_END_BODY;
-  return SOAP_OK;
+  return soap_bxml_value_out(soap, SOAP_BXML_TEXT, s, n);
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_body_begin_in(struct soap *soap)
+#ifndef WITH_LEAN
+/* sends a binary XML attribute */
+static int
+soap_bxml_attribute_out(struct soap *soap, const char *name, const char *value, int flag)
 {
-  if (soap->version == 0)
-    return SOAP_OK;
-  soap->part = SOAP_IN_BODY;
-  if (soap_element_begin_in(soap, "SOAP-ENV:Body", 0, NULL))
+  size_t n;
+  if (soap_bxml_name_out(soap, SOAP_BXML_ATT, name, strlen(name)))
     return soap->error;
-  if (!soap->body)
-    soap->part = SOAP_NO_BODY;
-  return SOAP_OK;
+  value = soap_bxml_utf8_out(soap, value, flag, &n);
+  if (!value)
+    return soap->error;
+  return soap_bxml_value_out(soap, 0, value, n);
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_body_end_in(struct soap *soap)
+#ifndef WITH_LEAN
+/* sends binary XML token c, SOAP_BXML_BASE64 or SOAP_BXML_HEX, followed by n bytes of s */
+static int
+soap_bxml_bytes_out(struct soap *soap, int c, const unsigned char *s, int n)
 {
-  if (soap->version == 0)
+  if (!s || n <= 0)
     return SOAP_OK;
-  if (soap->part == SOAP_NO_BODY)
-    return soap->error = SOAP_OK;
-  soap->part = SOAP_END_BODY;
-  return soap_element_end_in(soap, "SOAP-ENV:Body");
+  if (soap_bxml_put_num(soap, c, (ULONG64)n))
+    return soap->error;
+  return soap_send_raw(soap, (const char*)s, (size_t)n);
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_recv_header(struct soap *soap)
+#ifndef WITH_LEAN
+/* sends n bytes of XML text s with its entities decoded as a binary XML value preceded by token c, unless zero, text that is all white space is not sent when c is nonzero */
+static int
+soap_bxml_xml_text_out(struct soap *soap, int c, const char *s, size_t n)
 {
-  if (soap_getheader(soap) && soap->error == SOAP_TAG_MISMATCH)
-    soap->error = SOAP_OK;
-  if (soap->error == SOAP_OK && soap->fheader)
-    soap->error = soap->fheader(soap);
-  return soap->error;
+  static const char *const ents[] = { "lt;", "gt;", "amp;", "quot;", "apos;" };
+  struct soap_bxml *bp;
+  const char *e = s + n;
+  char *t;
+  if (c)
+  {
+    const char *r;
+    for (r = s; r < e && soap_coblank((soap_wchar)*r); r++)
+      continue;
+    if (r == e)
+      return SOAP_OK;
+  }
+  bp = soap_bxml_state(soap, &soap->bxml_out);
+  if (!bp || !soap_bxml_buf(soap, bp, n + 1))
+    return soap->error;
+  t = bp->buf;
+  while (s < e)
+  {
+    if (*s == '&')
+    {
+      const char *r = s + 1;
+      if (r < e && *r == '#')
+      {
+        unsigned long k = 0;
+        int base = 10;
+        if (r + 1 < e && r[1] == 'x')
+        {
+          base = 16;
+          r++;
+        }
+        for (r++; r < e && *r != ';'; r++)
+        {
+          int d = *r | 0x20;
+          if (*r >= '0' && *r <= '9')
+            d = *r - '0';
+          else if (base == 16 && d >= 'a' && d <= 'f')
+            d -= 'a' - 10;
+          else
+            break;
+          if (k > 0x7FFFFFF)
+            break;
+          k = base * k + d;
+        }
+        if (r < e && *r == ';' && k)
+        {
+          t += soap_bxml_utf8(t, k);
+          s = r + 1;
+          continue;
+        }
+      }
+      else
+      {
+        size_t i;
+        for (i = 0; i < sizeof(ents) / sizeof(*ents); i++)
+        {
+          size_t l = strlen(ents[i]);
+          if ((size_t)(e - r) >= l && !strncmp(r, ents[i], l))
+            break;
+        }
+        if (i < sizeof(ents) / sizeof(*ents))
+        {
+          *t++ = "<>&\"'"[i];
+          s = r + strlen(ents[i]);
+          continue;
+        }
+      }
+    }
+    *t++ = *s++;
+  }
+  return soap_bxml_value_out(soap, c, bp->buf, t - bp->buf);
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-void
-SOAP_FMAC2
-soap_set_endpoint(struct soap *soap, const char *endpoint)
+#ifndef WITH_LEAN
+/* sends XML text s, such as literal XML and the XML of a DOM, as binary XML tokens, white space between tags is not sent */
+static int
+soap_bxml_xml_out(struct soap *soap, const char *s)
 {
-  const char *s, *t;
-  size_t i, n;
-  soap->endpoint[0] = '\0';
-  soap->host[0] = '\0';
-  soap->path[0] = '/';
-  soap->path[1] = '\0';
-  soap->port = 80;
-  if (!endpoint || !*endpoint)
-    return;
-#if defined(WITH_OPENSSL) || defined(WITH_GNUTLS) || defined(WITH_WOLFSSL) || defined(WITH_SYSTEMSSL)
-  if (!soap_tag_cmp(endpoint, "https:*"))
-    soap->port = 443;
-#endif
-  soap_strcpy(soap->endpoint, sizeof(soap->endpoint), endpoint);
-  s = strchr(endpoint, ':');
-  if (s && s[1] == '/' && s[2] == '/')
-    s += 3;
-  else
-    s = endpoint;
-#if !defined(WITH_NOHTTP) || !defined(WITH_LEANER)
-  t = strchr(s, '@');
-  if (t && *s != ':' && *s != '@')
+  const char *t;
+  if (!s)
+    return SOAP_OK;
+  while (*s)
   {
-    size_t l = t - s + 1;
-    char *r = (char*)soap_malloc(soap, l);
-    n = s - endpoint;
-    if (r)
+    if (*s != '<')
     {
-      s = soap_decode(r, l, s, ":@");
-      soap->userid = r;
-      soap->passwd = SOAP_STR_EOS;
-      if (*s == ':')
+      for (t = s; *t && *t != '<'; t++)
+        continue;
+      if (soap_bxml_xml_text_out(soap, SOAP_BXML_TEXT, s, t - s))
+        return soap->error;
+      s = t;
+    }
+    else if (s[1] == '/')
+    {
+      t = strchr(s, '>');
+      if (!t)
+        return soap->error = SOAP_SYNTAX_ERROR;
+      if (soap_bxml_put(soap, SOAP_BXML_END))
+        return soap->error;
+      s = t + 1;
+    }
+    else if (!strncmp(s, "<![CDATA[", 9))
+    {
+      s += 9;
+      t = strstr(s, "]]>");
+      if (!t)
+        return soap->error = SOAP_SYNTAX_ERROR;
+      if (t > s && soap_bxml_value_out(soap, SOAP_BXML_TEXT, s, t - s))
+        return soap->error;
+      s = t + 3;
+    }
+    else if (s[1] == '!' || s[1] == '?')
+    {
+      if (!strncmp(s, "<!--", 4))
+        t = strstr(s + 4, "-->");
+      else if (s[1] == '?')
+        t = strstr(s + 2, "?>");
+      else
+        t = strchr(s, '>');
+      if (!t)
+        return soap->error = SOAP_SYNTAX_ERROR;
+      t += *t == '>' ? 1 : *t == '?' ? 2 : 3;
+      if (soap_bxml_put_num(soap, SOAP_BXML_MARKUP, (ULONG64)(t - s))
+       || soap_send_raw(soap, s, t - s))
+        return soap->error;
+      s = t;
+    }
+    else
+    {
+      for (t = ++s; *t && *t != '>' && *t != '/' && !soap_coblank((soap_wchar)*t); t++)
+        continue;
+      if (t == s || soap_bxml_name_out(soap, SOAP_BXML_ELT, s, t - s))
+        return soap->error ? soap->error : (soap->error = SOAP_SYNTAX_ERROR);
+      for (;;)
       {
-        s++;
-        if (*s != '@' && s < t)
+        const char *v;
+        while (*t && soap_coblank((soap_wchar)*t))
+          t++;
+        if (*t == '>')
         {
-          l = t - s + 1;
-          r = r + strlen(r) + 1;
-          s = soap_decode(r, l, s, "@");
-          soap->passwd = r;
+          if (soap_bxml_put(soap, SOAP_BXML_GT))
+            return soap->error;
+          s = t + 1;
+          break;
+        }
+        if (*t == '/' && t[1] == '>')
+        {
+          if (soap_bxml_put(soap, SOAP_BXML_EMPTY))
+            return soap->error;
+          s = t + 2;
+          break;
+        }
+        for (s = t; *t && *t != '=' && *t != '>' && *t != '/' && !soap_coblank((soap_wchar)*t); t++)
+          continue;
+        if (t == s || soap_bxml_name_out(soap, SOAP_BXML_ATT, s, t - s))
+          return soap->error ? soap->error : (soap->error = SOAP_SYNTAX_ERROR);
+        while (*t && soap_coblank((soap_wchar)*t))
+          t++;
+        if (*t != '=')
+        {
+          if (soap_bxml_value_out(soap, 0, SOAP_STR_EOS, 0))
+            return soap->error;
+          continue;
         }
+        do
+        {
+          t++;
+        } while (*t && soap_coblank((soap_wchar)*t));
+        if (*t != '"' && *t != '\'')
+          return soap->error = SOAP_SYNTAX_ERROR;
+        v = t + 1;
+        t = strchr(v, *t);
+        if (!t)
+          return soap->error = SOAP_SYNTAX_ERROR;
+        if (soap_bxml_xml_text_out(soap, 0, v, t - v))
+          return soap->error;
+        t++;
       }
     }
-    s++;
-    soap_strcpy(soap->endpoint + n, sizeof(soap->endpoint) - n, s);
   }
+  return SOAP_OK;
+}
 #endif
-  n = strlen(s);
-  if (n >= sizeof(soap->host))
-    n = sizeof(soap->host) - 1;
-#ifdef WITH_IPV6
-  if (s[0] == '[')
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* reads a binary XML varint into *n */
+static int
+soap_bxml_get_num(struct soap *soap, ULONG64 *n)
+{
+  int k;
+  *n = 0;
+  for (k = 0; k < 64; k += 7)
   {
-    s++;
-    for (i = 0; i < n; i++)
+    soap_wchar c = soap_getchar(soap);
+    if ((int)c == EOF)
     {
-      if (s[i] == ']')
-      {
-        s++;
-        --n;
-        break;
-      }
-      soap->host[i] = s[i];
+      if (!soap->error)
+        soap->error = SOAP_EOF;
+      return soap->error;
     }
+    *n |= (ULONG64)(c & 0x7F) << k;
+    if (!(c & 0x80))
+      return SOAP_OK;
   }
-  else
+  return soap->error = SOAP_SYNTAX_ERROR;
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* returns the integer of zigzag varint n */
+static LONG64
+soap_bxml_int(ULONG64 n)
+{
+  if ((n & 1))
+    return -(LONG64)(n >> 1) - 1;
+  return (LONG64)(n >> 1);
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* reads the operand of binary XML token c, SOAP_BXML_FLOAT or SOAP_BXML_DOUBLE, into *d */
+static int
+soap_bxml_real_in(struct soap *soap, soap_wchar c, double *d)
+{
+  ULONG64 n = 0;
+  int k = c == SOAP_BXML_FLOAT ? 4 : 8;
+  while (k-- > 0)
   {
-    for (i = 0; i < n; i++)
+    soap_wchar b = soap_getchar(soap);
+    if ((int)b == EOF)
     {
-      soap->host[i] = s[i];
-      if (s[i] == '/' || s[i] == ':' || s[i] == '?')
-        break;
+      if (!soap->error)
+        soap->error = SOAP_EOF;
+      return soap->error;
     }
+    n = (n << 8) | (ULONG64)b;
   }
-#else
-  for (i = 0; i < n; i++)
+  if (c == SOAP_BXML_FLOAT)
   {
-    soap->host[i] = s[i];
-    if (s[i] == '/' || s[i] == ':' || s[i] == '?')
-      break;
+    soap_int32 i = (soap_int32)n;
+    float f;
+    (void)soap_memcpy((void*)&f, sizeof(f), (const void*)&i, sizeof(i));
+    *d = (double)f;
+  }
+  else
+  {
+    (void)soap_memcpy((void*)d, sizeof(double), (const void*)&n, sizeof(n));
   }
+  return SOAP_OK;
+}
 #endif
-  soap->host[i] = '\0';
-  if (s[i] == ':')
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* reads the operand of binary XML number token c and returns it as text in soap::tmpbuf, or NULL on error */
+static const char *
+soap_bxml_number(struct soap *soap, soap_wchar c)
+{
+  ULONG64 n;
+  double d;
+  if (c == SOAP_BXML_FLOAT || c == SOAP_BXML_DOUBLE)
   {
-    soap->port = (int)soap_strtol(s + i + 1, NULL, 10);
-    for (i++; i < n; i++)
-      if (s[i] == '/')
-        break;
+    if (soap_bxml_real_in(soap, c, &d))
+      return NULL;
+    if (c == SOAP_BXML_FLOAT)
+      return soap_float2s(soap, (float)d);
+    return soap_double2s(soap, d);
   }
-  if (i < n && s[i])
-    soap_strcpy(soap->path, sizeof(soap->path), s + i);
-  if (soap->override_host && *soap->override_host)
+  if (soap_bxml_get_num(soap, &n))
+    return NULL;
+  if (c == SOAP_BXML_INT)
+    return soap_LONG642s(soap, soap_bxml_int(n));
+  return soap_ULONG642s(soap, n);
+}
+#endif
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* reads a binary XML name into buf[len] */
+static int
+soap_bxml_name_in(struct soap *soap, char *buf, size_t len)
+{
+  struct soap_bxml *bp = soap_bxml_state(soap, &soap->bxml_in);
+  ULONG64 n;
+  size_t i;
+  if (!bp || soap_bxml_get_num(soap, &n))
+    return soap->error;
+  if (n > 0)
   {
-    soap_strcpy(soap->host, sizeof(soap->host), soap->override_host);
-    if (soap->override_port)
-      soap->port = soap->override_port;
+    if (n > bp->names.num)
+      return soap->error = SOAP_SYNTAX_ERROR;
+    soap_strcpy(buf, len, bp->names.buf + bp->names.off[n - 1]);
+    return SOAP_OK;
   }
-  if (soap->userid && !soap->authrealm)
-    soap->authrealm = soap->host;
+  if (soap_bxml_get_num(soap, &n))
+    return soap->error;
+  if (n == 0 || n >= len)
+    return soap->error = SOAP_SYNTAX_ERROR;
+  i = soap->labidx;
+  if (soap_cbor_raw_in(soap, n, 1))
+    return soap->error;
+  (void)soap_memcpy((void*)buf, len, (const void*)(soap->labbuf + i), (size_t)n);
+  buf[n] = '\0';
+  soap->labidx = i;
+  if (bp->names.num < SOAP_BXML_MAXNUM && soap_bxml_add(soap, &bp->names, buf, (size_t)n, 0))
+    return soap->error;
+  return SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
-#ifndef WITH_NOHTTP
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_GET(struct soap *soap, const char *endpoint, const char *action)
+#ifndef WITH_LEAN
+/* reads a binary XML value and appends it to the look-aside buffer, or skips it when skip is nonzero */
+static int
+soap_bxml_value_in(struct soap *soap, int skip)
 {
-  return soap_connect_command(soap, SOAP_GET, endpoint, action);
+  struct soap_bxml *bp = soap_bxml_state(soap, &soap->bxml_in);
+  ULONG64 n;
+  size_t i = soap->labidx;
+  if (!bp || soap_bxml_get_num(soap, &n))
+    return soap->error;
+  if (n > 0)
+  {
+    const char *s;
+    if (n > bp->values.num)
+      return soap->error = SOAP_SYNTAX_ERROR;
+    if (skip)
+      return SOAP_OK;
+    s = bp->values.buf + bp->values.off[n - 1];
+    return soap_append_lab(soap, s, strlen(s));
+  }
+  if (soap_bxml_get_num(soap, &n))
+    return soap->error;
+  if (soap->maxlength > 0 && n > (ULONG64)soap->maxlength)
+    return soap->error = SOAP_LENGTH;
+  if (n > SOAP_BXML_MAXLEN)
+    return soap_cbor_raw_in(soap, n, !skip);
+  if (soap_cbor_raw_in(soap, n, 1))
+    return soap->error;
+  if (bp->values.num < SOAP_BXML_MAXNUM && soap_bxml_add(soap, &bp->values, soap->labbuf + i, (size_t)n, 0))
+    return soap->error;
+  if (skip)
+    soap->labidx = i;
+  return SOAP_OK;
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_NOHTTP
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_PUT(struct soap *soap, const char *endpoint, const char *action, const char *type)
+#ifndef WITH_LEAN
+/* appends n bytes of s to the look-aside buffer, with &, <, > and " escaped when esc is nonzero */
+static int
+soap_bxml_append(struct soap *soap, const char *s, size_t n, int esc)
 {
-  if (!soap->http_content)
-    soap->http_content = type;
-  if ((soap->omode & SOAP_IO) != SOAP_IO_CHUNK)
+  const char *t, *e = s + n;
+  if (!esc)
+    return soap_append_lab(soap, s, n);
+  for (t = s; t < e; t++)
   {
-    soap->omode &= ~SOAP_IO;
-    soap->omode |= SOAP_IO_STORE;
+    const char *r;
+    switch (*t)
+    {
+      case '&':
+        r = "&amp;";
+        break;
+      case '<':
+        r = "&lt;";
+        break;
+      case '>':
+        r = "&gt;";
+        break;
+      case '"':
+        r = "&quot;";
+        break;
+      default:
+        continue;
+    }
+    if (soap_append_lab(soap, s, t - s)
+     || soap_append_lab(soap, r, strlen(r)))
+      return soap->error;
+    s = t + 1;
   }
-  return soap_connect_command(soap, SOAP_PUT, endpoint, action);
+  return soap_append_lab(soap, s, e - s);
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_NOHTTP
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_POST(struct soap *soap, const char *endpoint, const char *action, const char *type)
+#ifndef WITH_LEAN
+/* reads a binary XML value and appends it to the look-aside buffer, with &, <, > and " escaped when esc is nonzero */
+static int
+soap_bxml_text_in(struct soap *soap, int esc)
 {
-  if (!soap->http_content)
-    soap->http_content = type;
-  if ((soap->omode & SOAP_IO) != SOAP_IO_CHUNK)
+  size_t i = soap->labidx, n, k;
+  char *s;
+  if (soap_bxml_value_in(soap, 0))
+    return soap->error;
+  if (!esc)
+    return SOAP_OK;
+  n = soap->labidx - i;
+  for (k = i; k < soap->labidx; k++)
   {
-    soap->omode &= ~SOAP_IO;
-    soap->omode |= SOAP_IO_STORE;
+    char c = soap->labbuf[k];
+    if (c == '&' || c == '<' || c == '>' || c == '"')
+      break;
   }
-  return soap_connect_command(soap, SOAP_POST_FILE, endpoint, action);
+  if (k == soap->labidx)
+    return SOAP_OK;
+  s = soap_bxml_buf(soap, soap->bxml_in, n);
+  if (!s)
+    return soap->error;
+  (void)soap_memcpy((void*)s, n, (const void*)(soap->labbuf + i), n);
+  soap->labidx = i;
+  return soap_bxml_append(soap, s, n, 1);
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_NOHTTP
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_PATCH(struct soap *soap, const char *endpoint, const char *action, const char *type)
+#ifndef WITH_LEAN
+/* pushes the name of an element with content on the stack of open elements */
+static int
+soap_bxml_push(struct soap *soap, const char *s)
 {
-  if (!soap->http_content)
-    soap->http_content = type;
-  if ((soap->omode & SOAP_IO) != SOAP_IO_CHUNK)
-  {
-    soap->omode &= ~SOAP_IO;
-    soap->omode |= SOAP_IO_STORE;
-  }
-  return soap_connect_command(soap, SOAP_PATCH, endpoint, action);
+  struct soap_bxml *bp = soap_bxml_state(soap, &soap->bxml_in);
+  if (!bp)
+    return soap->error;
+  if (bp->stack.num >= soap->maxlevel)
+    return soap->error = SOAP_LEVEL;
+  return soap_bxml_add(soap, &bp->stack, s, strlen(s), 0);
 }
 #endif
 
 /******************************************************************************/
 
-#ifndef WITH_NOHTTP
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_DELETE(struct soap *soap, const char *endpoint)
+#ifndef WITH_LEAN
+/* pops the name of the innermost open element, returns the name or NULL on error */
+static const char *
+soap_bxml_pop(struct soap *soap)
 {
-  if (soap_connect_command(soap, SOAP_DEL, endpoint, NULL)
-   || soap_recv_empty_response(soap))
-    return soap_closesock(soap);
-  return SOAP_OK;
+  struct soap_bxml *bp = soap_bxml_state(soap, &soap->bxml_in);
+  if (!bp)
+    return NULL;
+  if (!bp->stack.num)
+  {
+    soap->error = SOAP_SYNTAX_ERROR;
+    return NULL;
+  }
+  bp->stack.len = bp->stack.off[--bp->stack.num];
+  return bp->stack.buf + bp->stack.len;
 }
 #endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_connect(struct soap *soap, const char *endpoint, const char *action)
+#ifndef WITH_LEAN
+/* returns the next binary XML token without consuming it, or EOF */
+static soap_wchar
+soap_bxml_peek(struct soap *soap)
 {
-  return soap_connect_command(soap, SOAP_POST, endpoint, action);
+  soap_wchar c = soap_getchar(soap);
+  soap_unget(soap, c);
+  return c;
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-int
-SOAP_FMAC2
-soap_connect_command(struct soap *soap, int http_command, const char *endpoints, const char *action)
+#ifndef WITH_LEAN
+/* reads a binary XML start tag into soap::tag and soap::attributes and pushes its namespace bindings, returns SOAP_NO_TAG when the next token is not a start tag */
+static int
+soap_bxml_element_in(struct soap *soap)
 {
-  if (endpoints)
+  struct soap_attribute *tp, *tq;
+  soap_wchar c;
+  for (;;)
   {
-    int retry = soap->connect_retry;
-    unsigned int backoff = 1;
-    for (;;)
+    ULONG64 n;
+    c = soap_getchar(soap);
+    if (c != SOAP_BXML_MARKUP)
+      break;
+    if (soap_bxml_get_num(soap, &n) || soap_cbor_raw_in(soap, n, 0))
+      return soap->error;
+  }
+  if (c != SOAP_BXML_ELT)
+  {
+    *soap->tag = '\0';
+    if ((int)c == EOF)
+      return soap->error = SOAP_CHK_EOF;
+    soap_unget(soap, c);
+    return soap->error = SOAP_NO_TAG;
+  }
+  if (soap_bxml_name_in(soap, soap->tag, sizeof(soap->tag)))
+    return soap->error;
+  soap_pop_namespace(soap);
+  for (tp = soap->attributes; tp; tp = tp->next)
+    tp->visible = 0;
+  for (;;)
+  {
+    size_t k;
+    c = soap_getchar(soap);
+    if (c != SOAP_BXML_ATT)
+      break;
+    if (soap_bxml_name_in(soap, soap->tmpbuf, sizeof(soap->tmpbuf)))
+      return soap->error;
+    tq = NULL;
+    for (tp = soap->attributes; tp; tq = tp, tp = tp->next)
     {
-      struct timeval tv;
-      const char *s;
-      s = strchr(endpoints, ' ');
-      if (s)
+      if (!SOAP_STRCMP(tp->name, soap->tmpbuf))
+        break;
+    }
+    if (!tp)
+    {
+      size_t l = strlen(soap->tmpbuf);
+      tp = (struct soap_attribute*)SOAP_MALLOC(soap, sizeof(struct soap_attribute) + l);
+      if (!tp)
+        return soap->error = SOAP_EOM;
+      (void)soap_memcpy((char*)tp->name, l + 1, soap->tmpbuf, l + 1);
+      tp->value = NULL;
+      tp->size = 0;
+      tp->ns = NULL;
+      tp->visible = 0;
+      /* append attribute to the end of the list */
+      if (tq)
       {
-        size_t l = strlen(endpoints);
-        char *endpoint = NULL;
-        if (SOAP_MAXALLOCSIZE == 0 || l <= SOAP_MAXALLOCSIZE)
-          endpoint = (char*)SOAP_MALLOC(soap, l + 1);
-        if (!endpoint)
-          return soap->error = SOAP_EOM;
-        for (;;)
-        {
-          (void)soap_strncpy(endpoint, l + 1, endpoints, s - endpoints);
-          endpoint[s - endpoints] = '\0';
-          if (soap_try_connect_command(soap, http_command, endpoint, action) != SOAP_TCP_ERROR)
-            break;
-          while (*s == ' ')
-            s++;
-          if (!*s)
-            break;
-          soap->error = SOAP_OK;
-          endpoints = s;
-          s = strchr(endpoints, ' ');
-          if (!s)
-            s = endpoints + strlen(endpoints);
-        }
-        SOAP_FREE(soap, endpoint);
+        tq->next = tp;
+        tp->next = NULL;
       }
       else
       {
-        soap_try_connect_command(soap, http_command, endpoints, action);
+        tp->next = soap->attributes;
+        soap->attributes = tp;
       }
-      if (soap->error != SOAP_TCP_ERROR || retry <= 0)
-        break;
-      soap->error = SOAP_OK;
-      tv.tv_sec = backoff;
-      tv.tv_usec = 0;
-      select(0, NULL, NULL, NULL, &tv);
-      if (backoff < 32)
-        backoff *= 2;
-      --retry;
+    }
+    else if (tp->visible)
+    {
+      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Duplicate attribute in %s\n", soap->tag));
+      return soap->error = SOAP_SYNTAX_ERROR; /* redefined (duplicate) attribute */
+    }
+    soap->labidx = 0;
+    if (soap_bxml_value_in(soap, 0) || soap_append_lab(soap, SOAP_STR_EOS, 1))
+      return soap->error;
+    if (!(soap->mode & SOAP_C_UTFSTRING))
+      soap_bxml_latin(soap->labbuf);
+    k = strlen(soap->labbuf) + 1;
+    if (tp->size < k)
+    {
+      if (tp->value)
+        SOAP_FREE(soap, tp->value);
+      tp->size = 0;
+      tp->value = (char*)SOAP_MALLOC(soap, k);
+      if (!tp->value)
+        return soap->error = SOAP_EOM;
+      tp->size = k;
+    }
+    (void)soap_memcpy((void*)tp->value, tp->size, (const void*)soap->labbuf, k);
+    tp->visible = 2; /* seen this attribute w/ value */
+    if (!strncmp(tp->name, "xmlns", 5) && (tp->name[5] == ':' || !tp->name[5]))
+    {
+      if (soap_push_namespace(soap, tp->name + 5 + (tp->name[5] == ':'), tp->value) == NULL)
+        return soap->error;
     }
   }
-  return soap->error;
+  if (c == SOAP_BXML_GT)
+  {
+    soap->body = 1;
+    return soap_bxml_push(soap, soap->tag);
+  }
+  if (c == SOAP_BXML_EMPTY)
+  {
+    soap->body = 0;
+    return SOAP_OK;
+  }
+  if ((int)c == EOF)
+    return soap->error = SOAP_CHK_EOF;
+  return soap->error = SOAP_SYNTAX_ERROR;
 }
+#endif
 
 /******************************************************************************/
 
+#ifndef WITH_LEAN
+/* reads the name and attributes of a binary XML start tag after its token and appends the tag as XML to the look-aside buffer when xml is nonzero, sets *body and pushes the name when the element has content */
 static int
-soap_try_connect_command(struct soap *soap, int http_command, const char *endpoint, const char *action)
+soap_bxml_tag_in(struct soap *soap, int xml, int *body)
 {
-  char host[sizeof(soap->host)];
-  int port;
-  ULONG64 count;
-  soap->error = SOAP_OK;
-  soap_reset_errno;
-  soap->errnum = 0;
-  (void)soap_memcpy(host, sizeof(host), soap->host, sizeof(soap->host)); /* save previous host name: if != then reconnect */
-  port = soap->port; /* save previous port to compare */
-  soap->status = http_command;
-  soap_set_endpoint(soap, endpoint);
-  soap->action = soap_strdup(soap, action);
-#ifndef WITH_LEANER
-  if (soap->fconnect)
+  soap_wchar c;
+  if (soap_bxml_name_in(soap, soap->tmpbuf, sizeof(soap->tmpbuf))
+   || soap_bxml_push(soap, soap->tmpbuf))
+    return soap->error;
+  if (xml && (soap_append_lab(soap, "<", 1) || soap_append_lab(soap, soap->tmpbuf, strlen(soap->tmpbuf))))
+    return soap->error;
+  for (;;)
+  {
+    c = soap_getchar(soap);
+    if (c != SOAP_BXML_ATT)
+      break;
+    if (soap_bxml_name_in(soap, soap->tmpbuf, sizeof(soap->tmpbuf)))
+      return soap->error;
+    if (xml)
+    {
+      if (soap_append_lab(soap, " ", 1)
+       || soap_append_lab(soap, soap->tmpbuf, strlen(soap->tmpbuf))
+       || soap_append_lab(soap, "=\"", 2)
+       || soap_bxml_text_in(soap, 1)
+       || soap_append_lab(soap, "\"", 1))
+        return soap->error;
+    }
+    else if (soap_bxml_value_in(soap, 1))
+    {
+      return soap->error;
+    }
+  }
+  if (c == SOAP_BXML_GT)
+  {
+    *body = 1;
+    return xml ? soap_append_lab(soap, ">", 1) : SOAP_OK;
+  }
+  if (c == SOAP_BXML_EMPTY)
   {
-    soap->error = soap->fconnect(soap, endpoint, soap->host, soap->port);
-    if (soap->error)
+    *body = 0;
+    if (!soap_bxml_pop(soap))
       return soap->error;
+    return xml ? soap_append_lab(soap, "/>", 2) : SOAP_OK;
   }
-  else
+  if ((int)c == EOF)
+    return soap->error = SOAP_CHK_EOF;
+  return soap->error = SOAP_SYNTAX_ERROR;
+}
 #endif
-  if (soap->fopen && *soap->host)
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* skips binary XML content up to and including the end tag of the element at depth n of the content, then sets soap::tag to the name of the element that ended at depth 0 */
+static int
+soap_bxml_end_in(struct soap *soap, int n)
+{
+  for (;;)
   {
-    if (!soap->keep_alive || !soap_valid_socket(soap->socket) || strcmp(soap->host, host) || soap->port != port || !soap->fpoll || soap->fpoll(soap))
+    soap_wchar c = soap_getchar(soap);
+    ULONG64 k;
+    double d;
+    int body;
+    if (c != SOAP_BXML_END && c != SOAP_BXML_TEXT && c != SOAP_BXML_MARKUP && (int)c != EOF && (soap->mode & SOAP_XML_STRICT))
+      return soap->error = SOAP_END_TAG; /* reject mixed content before ending tag */
+    switch (c)
     {
-      soap->error = SOAP_OK;
-#ifndef WITH_LEAN
-      if (!strncmp(endpoint, "soap.udp:", 9) || !strncmp(endpoint, "udp:", 4))
-      {
-        soap->omode |= SOAP_IO_UDP;
-      }
-      else
-#endif
+      case SOAP_BXML_END:
       {
-        soap->keep_alive = 0; /* to force close */
-        soap->omode &= ~SOAP_IO_UDP; /* to force close */
+        const char *s = soap_bxml_pop(soap);
+        if (!s)
+          return soap->error;
+        if (n-- == 0)
+        {
+          soap_strcpy(soap->tag, sizeof(soap->tag), s);
+          return SOAP_OK;
+        }
+        break;
       }
-      (void)soap_closesock(soap);
-      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Connect/reconnect to '%s' host='%s' path='%s' port=%d\n", endpoint?endpoint:"(null)", soap->host, soap->path, soap->port));
-      if (!soap->keep_alive || !soap_valid_socket(soap->socket))
-      {
-        soap->socket = soap->fopen(soap, endpoint, soap->host, soap->port);
-        if (!soap_valid_socket(soap->socket) || soap->error)
+      case SOAP_BXML_ELT:
+        if (soap_bxml_tag_in(soap, 0, &body))
+          return soap->error;
+        n += body;
+        break;
+      case SOAP_BXML_TEXT:
+        if ((soap->mode & SOAP_XML_STRICT))
         {
-          if (soap->error)
+          size_t i;
+          soap->labidx = 0;
+          if (soap_bxml_value_in(soap, 0))
             return soap->error;
-          return soap->error = SOAP_TCP_ERROR;
+          for (i = 0; i < soap->labidx; i++)
+            if (!soap_coblank((soap_wchar)soap->labbuf[i]))
+              return soap->error = SOAP_END_TAG; /* reject mixed content before ending tag */
         }
-        soap->keep_alive = -((soap->omode & SOAP_IO_KEEPALIVE) != 0);
-      }
+        else if (soap_bxml_value_in(soap, 1))
+        {
+          return soap->error;
+        }
+        break;
+      case SOAP_BXML_INT:
+      case SOAP_BXML_UINT:
+        if (soap_bxml_get_num(soap, &k))
+          return soap->error;
+        break;
+      case SOAP_BXML_FLOAT:
+      case SOAP_BXML_DOUBLE:
+        if (soap_bxml_real_in(soap, c, &d))
+          return soap->error;
+        break;
+      case SOAP_BXML_BASE64:
+      case SOAP_BXML_HEX:
+      case SOAP_BXML_MARKUP:
+        if (soap_bxml_get_num(soap, &k) || soap_cbor_raw_in(soap, k, 0))
+          return soap->error;
+        break;
+      default:
+        if ((int)c == EOF)
+          return soap->error = SOAP_CHK_EOF;
+        return soap->error = SOAP_SYNTAX_ERROR;
     }
   }
-#ifdef WITH_NTLM
-  if (soap_ntlm_handshake(soap, SOAP_GET, endpoint, soap->host, soap->port))
-    return soap->error;
+}
 #endif
-  count = soap_count_attachments(soap);
-  if (soap_init_send(soap))
-    return soap->error;
-#ifndef WITH_NOHTTP
-  if (http_command == SOAP_GET || http_command == SOAP_DEL || http_command == SOAP_HEAD || http_command == SOAP_OPTIONS)
-  {
-    soap->mode &= ~(SOAP_IO | SOAP_ENC_ZLIB);
-    soap->mode |= SOAP_IO_BUFFER;
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* returns binary XML element content as a string like soap_value() does, with a number converted to text */
+static const char *
+soap_bxml_value(struct soap *soap)
+{
+  soap_wchar c = soap_getchar(soap);
+  const char *s;
+  size_t i, n;
+  switch (c)
+  {
+    case SOAP_BXML_INT:
+    case SOAP_BXML_UINT:
+    case SOAP_BXML_FLOAT:
+    case SOAP_BXML_DOUBLE:
+      return soap_bxml_number(soap, c);
+    case SOAP_BXML_TEXT:
+      soap->labidx = 0;
+      if (soap_bxml_value_in(soap, 0))
+        return NULL;
+      break;
+    default:
+      if ((int)c == EOF)
+      {
+        soap->error = SOAP_CHK_EOF;
+        return NULL;
+      }
+      soap_unget(soap, c);
+      *soap->tmpbuf = '\0';
+      return soap->tmpbuf;
   }
-  if ((soap->mode & SOAP_IO) != SOAP_IO_STORE && !(soap->mode & SOAP_ENC_PLAIN) && endpoint)
+  s = soap->labbuf;
+  n = soap->labidx;
+  for (i = 0; i < n && soap_coblank((soap_wchar)s[i]); i++)
+    continue;
+  while (n > i && soap_coblank((soap_wchar)s[n - 1]))
+    n--;
+  if (n - i >= sizeof(soap->tmpbuf))
   {
-    soap_mode k = soap->mode;
-    soap->mode &= ~(SOAP_IO | SOAP_ENC_ZLIB);
-    if ((k & SOAP_IO) != SOAP_IO_FLUSH)
-      soap->mode |= SOAP_IO_BUFFER;
-    soap->error = soap->fpost(soap, endpoint, soap->host, soap->port, soap->path, action, count);
-    if (soap->error)
-      return soap->error;
-    if ((k & SOAP_IO) == SOAP_IO_CHUNK)
-    {
-      if (soap_flush(soap))
-        return soap->error;
-    }
-    soap->mode = k;
+    soap->error = SOAP_LENGTH;
+    return NULL;
   }
-  if (http_command == SOAP_GET || http_command == SOAP_DEL || http_command == SOAP_HEAD || http_command == SOAP_OPTIONS)
-    return soap_end_send_flush(soap);
+  (void)soap_memcpy((void*)soap->tmpbuf, sizeof(soap->tmpbuf), (const void*)(s + i), n - i);
+  soap->tmpbuf[n - i] = '\0';
+  DBGLOG(TEST, SOAP_MESSAGE(fdebug, "Element content value='%s'\n", soap->tmpbuf));
+  return soap->tmpbuf;
+}
 #endif
-#ifndef WITH_LEANER
-  if (soap_begin_attachments(soap))
+
+/******************************************************************************/
+
+#ifndef WITH_LEAN
+/* reads the operand of binary XML token c, SOAP_BXML_BASE64 or SOAP_BXML_HEX, and appends it as base64 or hex text to the look-aside buffer */
+static int
+soap_bxml_bytes_text(struct soap *soap, soap_wchar c)
+{
+  size_t i = soap->labidx, n, k;
+  ULONG64 m;
+  char *s;
+  if (soap_bxml_get_num(soap, &m))
     return soap->error;
-#endif
+  if (m > 0x7FFFFFFF)
+    return soap->error = SOAP_LENGTH;
+  if (soap_cbor_raw_in(soap, m, 1))
+    return soap->error;
+  n = (size_t)m;
+  s = soap_bxml_buf(soap, soap->bxml_in, n + 1);
+  if (!s)
+    return soap->error;
+  (void)soap_memcpy((void*)s, n + 1, (const void*)(soap->labbuf + i), n);
+  soap->labidx = i;
+  k = c == SOAP_BXML_BASE64 ? (n + 2) / 3 * 4 : 2 * n;
+  if (soap_append_lab(soap, NULL, k + 1))
+    return soap->error;
+  if (c == SOAP_BXML_BASE64)
+    (void)soap_s2base64(soap, (const unsigned char*)s, soap->labbuf + i, (int)n);
+  else
+    (void)soap_s2hex(soap, (const unsigned char*)s, soap->labbuf + i, (int)n);
+  soap->labidx = i + k;
   return SOAP_OK;
 }
+#endif
 
 /******************************************************************************/
 
-#ifdef WITH_NTLM
-static int
-soap_ntlm_handshake(struct soap *soap, int command, const char *endpoint, const char *host, int port)
+#ifndef WITH_LEAN
+/* reads binary XML content as a string like soap_string_in() does with flag, sets *l to the number of chars */
+static char *
+soap_bxml_string_in(struct soap *soap, int flag, long maxlen, ULONG64 *l)
 {
-  /* requires libntlm from http://www.nongnu.org/libntlm/ */
-  const char *userid = (soap->proxy_userid ? soap->proxy_userid : soap->userid);
-  const char *passwd = (soap->proxy_passwd ? soap->proxy_passwd : soap->passwd);
-  struct SOAP_ENV__Header *oldheader;
-  if (soap->ntlm_challenge && userid && passwd && soap->authrealm)
+  int n = 0, f = 0, body;
+  const char *s;
+  soap->labidx = 0;
+  if (flag <= 0 && soap->peeked && *soap->tag)
   {
-    tSmbNtlmAuthRequest req;
-    tSmbNtlmAuthResponse res;
-    tSmbNtlmAuthChallenge ch;
-    int keep_alive = soap->keep_alive;
-    ULONG64 length = soap->length;
-    ULONG64 count = soap->count;
-    soap_mode m = soap->mode;
-    soap_mode om = soap->omode;
-    int status = soap->status;
-    char *action = soap->action;
-    short version = soap->version;
-    const char *http_content = soap->http_content;
-    const char *http_extra_header = soap->http_extra_header;
-    const char *bearer = soap->bearer;
-    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "NTLM '%s'\n", soap->ntlm_challenge));
-    if (!*soap->ntlm_challenge)
+    struct soap_attribute *tp;
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String content includes tag '%s' and attributes\n", soap->tag));
+    if (soap_append_lab(soap, "<", 1)
+     || soap_append_lab(soap, soap->tag, strlen(soap->tag)))
+      return NULL;
+    for (tp = soap->attributes; tp; tp = tp->next)
     {
-      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "NTLM S->C Type 1: received NTLM authentication challenge from server\n"));
-      /* S -> C   401 Unauthorized
-                  WWW-Authenticate: NTLM
-      */
-      buildSmbNtlmAuthRequest(&req, userid, soap->authrealm);
-      soap->ntlm_challenge = soap_s2base64(soap, (unsigned char*)(void*)&req, NULL, SmbLength(&req));
-      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "NTLM C->S Type 2: sending NTLM authorization to server\nAuthorization: NTLM %s\n", soap->ntlm_challenge));
-      /* C -> S   GET ...
-                  Authorization: NTLM TlRMTVNTUAABAAAAA7IAAAoACgApAAAACQAJACAAAABMSUdIVENJVFlVUlNBLU1JTk9S
-      */
-      soap->omode = SOAP_IO_BUFFER;
-      if (soap_init_send(soap))
-        return soap->error;
-      if (!soap->keep_alive)
-        soap->keep_alive = -1; /* client keep alive */
-      soap->status = command; /* GET or CONNECT for proxy */
-      if (soap->fpost(soap, endpoint, host, port, soap->path, soap->action, 0)
-       || soap_end_send_flush(soap))
-        return soap->error;
-      soap->mode = m;
-      soap->keep_alive = keep_alive;
-      DBGLOG(TEST, SOAP_MESSAGE(fdebug, "NTLM S->C Type 2: waiting on server NTLM response\n"));
-      oldheader = soap->header;
-      if (soap_begin_recv(soap))
-        if (soap->error == SOAP_EOF)
-          return soap->error;
-      (void)soap_end_recv(soap);
-      soap->header = oldheader;
-      soap->length = length;
-      if (soap->status != 401 && soap->status != 407)
-        return soap->error = SOAP_NTLM_ERROR;
-      soap->error = SOAP_OK;
+      if (tp->visible)
+      {
+        if (soap_append_lab(soap, " ", 1)
+         || soap_append_lab(soap, tp->name, strlen(tp->name)))
+          return NULL;
+        if (tp->value
+         && (soap_append_lab(soap, "=\"", 2)
+          || soap_bxml_append(soap, tp->value, strlen(tp->value), 1)
+          || soap_append_lab(soap, "\"", 1)))
+          return NULL;
+      }
+    }
+    if (soap_append_lab(soap, soap->body ? ">" : "/>", soap->body ? 1 : 2))
+      return NULL;
+    if (soap->body)
+      n = 1;
+    f = 1;
+    soap->peeked = 0;
+  }
+  for (;;)
+  {
+    soap_wchar c = soap_getchar(soap);
+    ULONG64 k;
+    switch (c)
+    {
+      case SOAP_BXML_TEXT:
+        if (soap_bxml_text_in(soap, flag <= 0))
+          return NULL;
+        break;
+      case SOAP_BXML_INT:
+      case SOAP_BXML_UINT:
+      case SOAP_BXML_FLOAT:
+      case SOAP_BXML_DOUBLE:
+        s = soap_bxml_number(soap, c);
+        if (!s || soap_append_lab(soap, s, strlen(s)))
+          return NULL;
+        break;
+      case SOAP_BXML_BASE64:
+      case SOAP_BXML_HEX:
+        if (soap_bxml_bytes_text(soap, c))
+          return NULL;
+        break;
+      case SOAP_BXML_MARKUP:
+        if (soap_bxml_get_num(soap, &k) || soap_cbor_raw_in(soap, k, flag <= 0))
+          return NULL;
+        break;
+      case SOAP_BXML_ELT:
+        if (flag == 3 || (f && n == 0))
+        {
+          soap_unget(soap, c);
+          goto end;
+        }
+        if (soap_bxml_tag_in(soap, 1, &body))
+          return NULL;
+        n += body;
+        break;
+      case SOAP_BXML_END:
+        if (n == 0)
+        {
+          soap_unget(soap, c);
+          goto end;
+        }
+        n--;
+        s = soap_bxml_pop(soap);
+        if (!s
+         || soap_append_lab(soap, "</", 2)
+         || soap_append_lab(soap, s, strlen(s))
+         || soap_append_lab(soap, ">", 1))
+          return NULL;
+        break;
+      default:
+        if ((int)c == EOF)
+        {
+          soap_unget(soap, c);
+          goto end;
+        }
+        soap->error = SOAP_SYNTAX_ERROR;
+        return NULL;
+    }
+  }
+end:
+  if (soap_append_lab(soap, SOAP_STR_EOS, 1))
+    return NULL;
+  *l = 0;
+  for (s = soap->labbuf; *s; s++)
+    if ((*s & 0xC0) != 0x80)
+      (*l)++;
+  if (maxlen >= 0 && *l > (ULONG64)maxlen)
+  {
+    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "String too long: maxlen=%ld\n", maxlen));
+    soap->error = SOAP_LENGTH;
+    return NULL;
+  }
+  if (flag > 0 && !(soap->mode & SOAP_C_UTFSTRING))
+  {
+#if !defined(WITH_LEANER) && defined(HAVE_WCTOMB)
+    if ((soap->mode & SOAP_C_MBSTRING))
+    {
+      char *r, *t;
+      t = (char*)soap_malloc(soap, MB_CUR_MAX * (soap->labidx - 1) + 1);
+      if (!t)
+        return NULL;
+      for (r = t, s = soap->labbuf; *s; )
+      {
+        unsigned long c = soap_bxml_getutf8(&s);
+        int m;
+        if (c < 0x80)
+        {
+          *r++ = (char)c;
+          continue;
+        }
+#if defined(WIN32) && !defined(CYGWIN) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(__BORLANDC__)
+        m = 0;
+        wctomb_s(&m, r, MB_CUR_MAX, (wchar_t)c);
+#else
+        m = wctomb(r, (wchar_t)c);
+#endif
+        if (m >= 1 && m <= (int)MB_CUR_MAX)
+          r += m;
+        else
+          *r++ = SOAP_UNKNOWN_CHAR;
+      }
+      *r = '\0';
+      return t;
     }
-    /* S -> C   401 Unauthorized
-                WWW-Authenticate: NTLM TlRMTVNTUAACAAAAAAAAACgAAAABggAAU3J2Tm9uY2UAAAAAAAAAAA==
-    */
-    soap_base642s(soap, soap->ntlm_challenge, (char*)&ch, sizeof(tSmbNtlmAuthChallenge), NULL);
-    buildSmbNtlmAuthResponse(&ch, &res, userid, passwd);
-    soap->ntlm_challenge = soap_s2base64(soap, (unsigned char*)(void*)&res, NULL, SmbLength(&res));
-    DBGLOG(TEST, SOAP_MESSAGE(fdebug, "NTLM C->S Type 3: sending NTLM authorization to server\nAuthorization: NTLM %s\n", soap->ntlm_challenge));
-    /* C -> S   GET ...
-                Authorization: NTLM TlRMTVNTUAADAAAAGAAYAHIAAAAYABgAigAAABQAFABAAAAADAAMAFQAAAASABIAYAAAAAAAAACiAAAAAYIAAFUAUgBTAEEALQBNAEkATgBPAFIAWgBhAHAAaABvAGQATABJAEcASABUAEMASQBUAFkArYfKbe/jRoW5xDxHeoxC1gBmfWiS5+iX4OAN4xBKG/IFPwfH3agtPEia6YnhsADT
-    */
-    soap->userid = NULL;
-    soap->passwd = NULL;
-    soap->proxy_userid = NULL;
-    soap->proxy_passwd = NULL;
-    soap->keep_alive = keep_alive;
-    soap->length = length;
-    soap->count = count;
-    soap->mode = m;
-    soap->omode = om;
-    soap->status = status;
-    soap->action = action;
-    soap->version = version;
-    soap->http_content = http_content;
-    soap->http_extra_header = http_extra_header;
-    soap->bearer = bearer;
+#endif
+    soap_bxml_latin(soap->labbuf);
   }
-  return SOAP_OK;
+  return soap_strdup(soap, soap->labbuf);
 }
 #endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-char*
-SOAP_FMAC2
-soap_s2base64(struct soap *soap, const unsigned char *s, char *t, int n)
+#ifndef WITH_LEAN
+/* reads binary XML xsd:base64Binary or xsd:hexBinary content, text content is decoded as hex when hex is nonzero or as base64 */
+static unsigned char *
+soap_bxml_bytes_in(struct soap *soap, int *n, int hex)
 {
-  int i;
-  unsigned long m;
-  char *p;
-  if (!t)
-    t = (char*)soap_malloc(soap, (n + 2) / 3 * 4 + 1);
-  if (!t)
-    return NULL;
-  p = t;
-  t[0] = '\0';
-  if (!s)
-    return p;
-  for (; n > 2; n -= 3, s += 3)
+  unsigned char *p;
+  soap_wchar c = soap_bxml_peek(soap);
+  if (c != SOAP_BXML_BASE64 && c != SOAP_BXML_HEX)
   {
-    m = s[0];
-    m = (m << 8) | s[1];
-    m = (m << 8) | s[2];
-    for (i = 4; i > 0; m >>= 6)
-      t[--i] = soap_base64o[m & 0x3F];
-    t += 4;
+    const char *s = soap_string_in(soap, 1, -1, -1, NULL);
+    if (!s)
+      return NULL;
+    if (hex)
+      return (unsigned char*)soap_hex2s(soap, s, NULL, 0, n);
+    return (unsigned char*)soap_base642s(soap, s, NULL, 0, n);
   }
-  t[0] = '\0';
-  if (n > 0) /* 0 < n <= 2 implies that t[0..4] is allocated (base64 scaling formula) */
+  soap->labidx = 0;
+  while (c == SOAP_BXML_BASE64 || c == SOAP_BXML_HEX)
   {
-    m = 0;
-    for (i = 0; i < n; i++)
-      m = (m << 8) | *s++;
-    for (; i < 3; i++)
-      m <<= 8;
-    for (i = 4; i > 0; m >>= 6)
-      t[--i] = soap_base64o[m & 0x3F];
-    for (i = 3; i > n; i--)
-      t[i] = '=';
-    t[4] = '\0';
+    ULONG64 k;
+    (void)soap_getchar(soap);
+    if (soap_bxml_get_num(soap, &k))
+      return NULL;
+    if (k > 0x7FFFFFFF - (ULONG64)soap->labidx || (soap->maxlength > 0 && soap->labidx + k > (ULONG64)soap->maxlength))
+    {
+      soap->error = SOAP_LENGTH;
+      return NULL;
+    }
+    if (soap_cbor_raw_in(soap, k, 1))
+      return NULL;
+    c = soap_bxml_peek(soap);
   }
+  if (n)
+    *n = (int)soap->labidx;
+  p = (unsigned char*)soap_malloc(soap, soap->labidx);
+  if (p)
+    (void)soap_memcpy((void*)p, soap->labidx, (const void*)soap->labbuf, soap->labidx);
   return p;
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-const char*
-SOAP_FMAC2
-soap_base642s(struct soap *soap, const char *s, char *t, size_t l, int *n)
+#ifndef WITH_LEAN
+/* reads a binary XML number token as an integer in [min, max] and returns nonzero, or returns zero when the element content is not a number token */
+static int
+soap_bxml_integer_in(struct soap *soap, LONG64 *p, LONG64 min, LONG64 max)
 {
-  size_t i, j;
+  ULONG64 n;
   soap_wchar c;
-  unsigned long m;
-  const char *p;
-  if (n)
-    *n = 0;
-  if (!s || !*s)
-  {
-    if (soap->error)
-      return NULL;
-    return SOAP_NON_NULL;
-  }
-  if (!t)
+  if (!(soap->bxml & SOAP_BXML_IN) || !soap->body)
+    return 0;
+  c = soap_getchar(soap);
+  if (c != SOAP_BXML_INT && c != SOAP_BXML_UINT)
   {
-    l = (strlen(s) + 3) / 4 * 3 + 1;    /* space for raw binary and \0 */
-    t = (char*)soap_malloc(soap, l);
+    soap_unget(soap, c);
+    return 0;
   }
-  if (!t)
-    return NULL;
-  p = t;
-  for (i = 0; ; i += 3, l -= 3)
+  if (soap_bxml_get_num(soap, &n))
+    return 1;
+  if (c == SOAP_BXML_UINT && n > (ULONG64)max)
   {
-    m = 0;
-    j = 0;
-    while (j < 4)
-    {
-      c = *s++;
-      if (c == '=' || !c)
-      {
-        if (l >= j - 1)
-        {
-          switch (j)
-          {
-            case 2:
-              *t++ = (char)((m >> 4) & 0xFF);
-              i++;
-              l--;
-              break;
-            case 3:
-              *t++ = (char)((m >> 10) & 0xFF);
-              *t++ = (char)((m >> 2) & 0xFF);
-              i += 2;
-              l -= 2;
-          }
-        }
-        if (n)
-          *n = (int)i;
-        if (l)
-          *t = '\0';
-        return p;
-      }
-      c -= '+';
-      if (c >= 0 && c <= 79)
-      {
-        int b = soap_base64i[c];
-        if (b >= 64)
-        {
-          soap->error = SOAP_TYPE;
-          return NULL;
-        }
-        m = (m << 6) + b;
-        j++;
-      }
-      else if (!soap_coblank(c + '+'))
-      {
-        soap->error = SOAP_TYPE;
-        return NULL;
-      }
-    }
-    if (l < 3)
-    {
-      if (n)
-        *n = (int)i;
-      if (l)
-        *t = '\0';
-      return p;
-    }
-    *t++ = (char)((m >> 16) & 0xFF);
-    *t++ = (char)((m >> 8) & 0xFF);
-    *t++ = (char)(m & 0xFF);
+    soap->error = SOAP_TYPE;
+    return 1;
   }
+  *p = c == SOAP_BXML_INT ? soap_bxml_int(n) : (LONG64)n;
+  if (*p < min || *p > max)
+    soap->error = SOAP_TYPE;
+  return 1;
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-char*
-SOAP_FMAC2
-soap_s2hex(struct soap *soap, const unsigned char *s, char *t, int n)
+#ifndef WITH_LEAN
+/* reads a binary XML number token as an unsigned integer not greater than max and returns nonzero, or returns zero when the element content is not a number token */
+static int
+soap_bxml_unsigned_in(struct soap *soap, ULONG64 *p, ULONG64 max)
 {
-  char *p;
-  if (!t)
-    t = (char*)soap_malloc(soap, 2 * n + 1);
-  if (!t)
-    return NULL;
-  p = t;
-  t[0] = '\0';
-  if (s)
+  ULONG64 n;
+  soap_wchar c;
+  if (!(soap->bxml & SOAP_BXML_IN) || !soap->body)
+    return 0;
+  c = soap_getchar(soap);
+  if (c != SOAP_BXML_INT && c != SOAP_BXML_UINT)
   {
-    for (; n > 0; n--)
+    soap_unget(soap, c);
+    return 0;
+  }
+  if (soap_bxml_get_num(soap, &n))
+    return 1;
+  if (c == SOAP_BXML_INT)
+  {
+    if ((n & 1))
     {
-      int m = *s++;
-      *t++ = (char)((m >> 4) + (m > 159 ? 'a' - 10 : '0'));
-      m &= 0x0F;
-      *t++ = (char)(m + (m > 9 ? 'a' - 10 : '0'));
+      soap->error = SOAP_TYPE;
+      return 1;
     }
+    n >>= 1;
   }
-  *t++ = '\0';
-  return p;
+  *p = n;
+  if (n > max)
+    soap->error = SOAP_TYPE;
+  return 1;
 }
+#endif
 
 /******************************************************************************/
 
-SOAP_FMAC1
-const char*
-SOAP_FMAC2
-soap_hex2s(struct soap *soap, const char *s, char *t, size_t l, int *n)
+#ifndef WITH_LEAN
+/* reads a binary XML number token as a floating point value and returns nonzero, or returns zero when the element content is not a number token */
+static int
+soap_bxml_double_in(struct soap *soap, double *p)
 {
-  const char *p;
-  if (n)
-    *n = 0;
-  if (!s || !*s)
-  {
-    if (soap->error)
-      return NULL;
-    return SOAP_NON_NULL;
-  }
-  if (!t)
-  {
-    l = strlen(s) / 2 + 1;      /* make sure enough space for \0 */
-    t = (char*)soap_malloc(soap, l);
-  }
-  if (!t)
-    return NULL;
-  p = t;
-  while (l)
+  ULONG64 n;
+  soap_wchar c;
+  if (!(soap->bxml & SOAP_BXML_IN) || !soap->body)
+    return 0;
+  c = soap_getchar(soap);
+  switch (c)
   {
-    int d1, d2;
-    d1 = *s++;
-    if (!d1)
-      break;
-    d2 = *s++;
-    if (!d2)
-      break;
-    *t++ = (char)(((d1 >= 'A' ? (d1 & 0x7) + 9 : d1 - '0') << 4) + (d2 >= 'A' ? (d2 & 0x7) + 9 : d2 - '0'));
-    l--;
+    case SOAP_BXML_FLOAT:
+    case SOAP_BXML_DOUBLE:
+      (void)soap_bxml_real_in(soap, c, p);
+      return 1;
+    case SOAP_BXML_INT:
+      if (!soap_bxml_get_num(soap, &n))
+        *p = (double)soap_bxml_int(n);
+      return 1;
+    case SOAP_BXML_UINT:
+      if (!soap_bxml_get_num(soap, &n))
+        *p = (double)n;
+      return 1;
   }
-  if (n)
-    *n = (int)(t - p);
-  if (l)
-    *t = '\0';
-  return p;
+  soap_unget(soap, c);
+  return 0;
 }
+#endif
 
 /******************************************************************************/
 
@@ -23491,25 +28975,23 @@ SOAP_FMAC2
 soap_print_fault_location(struct soap *soap, FILE *fd)
 {
 #ifndef WITH_LEAN
-  int i, j, c1, c2;
-  if (soap_check_state(soap) == SOAP_OK && soap->error && soap->error != SOAP_STOP && soap->bufidx <= soap->buflen && soap->buflen > 0 && soap->buflen <= sizeof(soap->buf))
-  {
-    i = (int)soap->bufidx - 1;
-    if (i <= 0)
-      i = 0;
-    c1 = soap->buf[i];
-    soap->buf[i] = '\0';
-    if ((int)soap->buflen >= i + 1024)
-      j = i + 1023;
-    else
-      j = (int)soap->buflen - 1;
-    c2 = soap->buf[j];
-    soap->buf[j] = '\0';
-    fprintf(fd, "%s%c\n<!-- ** HERE ** -->\n", soap->buf, c1);
+  size_t i, j, n = sizeof(soap->tmpbuf) / 2;
+  if (soap_check_state(soap) == SOAP_OK && soap->error && soap->error != SOAP_STOP && soap->ibuf && soap->bufidx <= soap->buflen && soap->buflen > 0)
+  {
+    /* copy the window around bufidx from ibuf, which may point into isbuf[] or a read-only mapping */
+    i = soap->bufidx > n ? soap->bufidx - n : 0;
+    (void)soap_memcpy((void*)soap->tmpbuf, sizeof(soap->tmpbuf), (const void*)(soap->ibuf + i), soap->bufidx - i);
+    soap->tmpbuf[soap->bufidx - i] = '\0';
+    fprintf(fd, "%s\n<!-- ** HERE ** -->\n", soap->tmpbuf);
     if (soap->bufidx < soap->buflen)
-      fprintf(fd, "%s\n", soap->buf + soap->bufidx);
-    soap->buf[i] = (char)c1;
-    soap->buf[j] = (char)c2;
+    {
+      j = soap->buflen - soap->bufidx;
+      if (j >= sizeof(soap->tmpbuf))
+        j = sizeof(soap->tmpbuf) - 1;
+      (void)soap_memcpy((void*)soap->tmpbuf, sizeof(soap->tmpbuf), (const void*)(soap->ibuf + soap->bufidx), j);
+      soap->tmpbuf[j] = '\0';
+      fprintf(fd, "%s\n", soap->tmpbuf);
+    }
   }
 #else
   (void)soap;
@@ -23529,25 +29011,23 @@ void
 SOAP_FMAC2
 soap_stream_fault_location(struct soap *soap, std::ostream& os)
 {
-  int i, j, c1, c2;
-  if (soap_check_state(soap) == SOAP_OK && soap->error && soap->error != SOAP_STOP && soap->bufidx <= soap->buflen && soap->buflen > 0 && soap->buflen <= sizeof(soap->buf))
+  size_t i, j, n = sizeof(soap->tmpbuf) / 2;
+  if (soap_check_state(soap) == SOAP_OK && soap->error && soap->error != SOAP_STOP && soap->ibuf && soap->bufidx <= soap->buflen && soap->buflen > 0)
   {
-    i = (int)soap->bufidx - 1;
-    if (i <= 0)
-      i = 0;
-    c1 = soap->buf[i];
-    soap->buf[i] = '\0';
-    if ((int)soap->buflen >= i + 1024)
-      j = i + 1023;
-    else
-      j = (int)soap->buflen - 1;
-    c2 = soap->buf[j];
-    soap->buf[j] = '\0';
-    os << soap->buf << (char)c1 << std::endl << "<!-- ** HERE ** -->" << std::endl;
+    /* copy the window around bufidx from ibuf, which may point into isbuf[] or a read-only mapping */
+    i = soap->bufidx > n ? soap->bufidx - n : 0;
+    (void)soap_memcpy((void*)soap->tmpbuf, sizeof(soap->tmpbuf), (const void*)(soap->ibuf + i), soap->bufidx - i);
+    soap->tmpbuf[soap->bufidx - i] = '\0';
+    os << soap->tmpbuf << std::endl << "<!-- ** HERE ** -->" << std::endl;
     if (soap->bufidx < soap->buflen)
-      os << soap->buf + soap->bufidx << std::endl;
-    soap->buf[i] = (char)c1;
-    soap->buf[j] = (char)c2;
+    {
+      j = soap->buflen - soap->bufidx;
+      if (j >= sizeof(soap->tmpbuf))
+        j = sizeof(soap->tmpbuf) - 1;
+      (void)soap_memcpy((void*)soap->tmpbuf, sizeof(soap->tmpbuf), (const void*)(soap->ibuf + soap->bufidx), j);
+      soap->tmpbuf[j] = '\0';
+      os << soap->tmpbuf << std::endl;
+    }
   }
 }
 #endif
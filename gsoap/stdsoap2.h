@@ -302,6 +302,7 @@ A commercial use license is available from Genivia, Inc., contact@genivia.com
 #  endif
 # elif defined(__APPLE__)
 #  define HAVE_POLL
+#  define HAVE_MMAP
 #  define HAVE_SNPRINTF
 #  define HAVE_STRLCPY
 #  define HAVE_STRRCHR
@@ -376,6 +377,7 @@ extern intmax_t __strtoull(const char*, char**, int);
 #  define HAVE_LOCALE_H
 # elif defined(FREEBSD) || defined(__FreeBSD__) || defined(OPENBSD)
 #  define HAVE_POLL
+#  define HAVE_MMAP
 #  define HAVE_SNPRINTF
 #  define HAVE_STRLCPY
 #  define HAVE_STRRCHR
@@ -530,6 +532,7 @@ extern intmax_t __strtoull(const char*, char**, int);
 #  define HAVE_LOCALTIME_R
 # elif defined(__GLIBC__) || defined(__GNU__) || defined(__GNUC__)
 #  define HAVE_POLL
+#  define HAVE_MMAP
 #  define HAVE_SNPRINTF
 #  define HAVE_STRRCHR
 #  define HAVE_STRTOD
@@ -747,6 +750,11 @@ extern intmax_t __strtoull(const char*, char**, int);
 # include <poll.h>
 #endif
 
+#if defined(HAVE_MMAP) && !defined(WITH_LEAN) && !defined(WITH_NOIO)
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+
 #ifdef __cplusplus
 # include <new>
 # include <iterator>
@@ -1188,18 +1196,25 @@ extern "C" {
 #endif
 #ifndef SOAP_PTRHASH
 # ifndef WITH_LEAN
-#  define SOAP_PTRHASH (4096) /* size of pointer analysis hash table (must be power of 2) */
+#  define SOAP_PTRHASH (4096) /* initial size of pointer analysis hash table (must be power of 2), doubles when half full */
 # else
 #  define SOAP_PTRHASH   (32)
 # endif
 #endif
 #ifndef SOAP_IDHASH
 # ifndef WITH_LEAN
-#  define SOAP_IDHASH  (1999) /* 1999, 8191: prime size of hash table for parsed id/ref */
+#  define SOAP_IDHASH  (1999) /* 1999, 8191: prime initial size of hash table for parsed id/ref, grows to 2n+1 entries when half full */
 # else
 #  define SOAP_IDHASH    (19) /* 19, 199: small prime */
 # endif
 #endif
+#ifndef SOAP_NSHASH
+# ifndef WITH_LEAN
+#  define SOAP_NSHASH    (61) /* prime size of hash table for namespace URIs of the namespace mapping table */
+# else
+#  define SOAP_NSHASH    (13)
+# endif
+#endif
 #ifndef SOAP_BLKLEN
 # ifndef WITH_LEAN
 #  define SOAP_BLKLEN   (256) /* to collect long strings and XML attributes */
@@ -1247,6 +1262,14 @@ extern "C" {
 # define SOAP_MAXALLOCSIZE (0) /* max size that malloc() can handle, zero for no limit */
 #endif
 
+#ifndef SOAP_ARENALEN
+# define SOAP_ARENALEN (0) /* initial size of arena chunks allocated by soap_malloc(), zero to disable arena allocation */
+#endif
+
+#ifndef SOAP_ARENAKEEP
+# define SOAP_ARENAKEEP (0) /* max total size of arena chunks kept by soap_end() for reuse, zero to free all chunks */
+#endif
+
 #ifndef SOAP_MAXLOGS
 # define SOAP_MAXLOGS     (3) /* max number of debug logs per struct soap environment */
 # define SOAP_INDEX_RECV  (0)
@@ -1336,6 +1359,26 @@ extern "C" {
 # define SOAP_MAXOCCURS (100000)
 #endif
 
+/* maximum number of slices of an array that are (de)serialized in parallel by the soap::fparallel job runner */
+#ifndef SOAP_MAXSLICES
+# define SOAP_MAXSLICES (64)
+#endif
+
+/* minimum length in bytes of a slice of an array that is deserialized in parallel, shorter arrays are deserialized sequentially */
+#ifndef SOAP_SLICELEN
+# define SOAP_SLICELEN (65536)
+#endif
+
+/* lazy members are indexed on the 2^SOAP_LAZYSHIFT byte granule of their address, so that the members in a block moved by soap_update_pointers() are found by granule */
+#ifndef SOAP_LAZYSHIFT
+# define SOAP_LAZYSHIFT (8)
+#endif
+
+/* minimum number of items of a slice of an array that is serialized in parallel, shorter arrays are serialized sequentially */
+#ifndef SOAP_SLICENUM
+# define SOAP_SLICENUM (1024)
+#endif
+
 #ifdef VXWORKS
 # ifdef WMW_RPM_IO
 #  include "httpLib.h"
@@ -2043,12 +2086,92 @@ struct soap_blist
   struct soap_bhead *head;
   size_t size;
   size_t item;
+  char *ptr;    /* soap_malloc() array of the items pushed with soap_push_block_max(), handed over by soap_save_block(), or NULL */
+  size_t room;  /* unused capacity of ptr */
+  size_t unit;  /* size of the items in ptr */
+};
+
+/* arena chunk of soap_malloc() data, the data flows into the allocated region below this struct */
+struct soap_arena
+{
+  struct soap_arena *next;
+  size_t size; /* size of the data region */
+  size_t used; /* number of bytes allocated from the data region */
+};
+
+/* entry of an allocation list index, maps the address of managed data to its alist link or clist node */
+struct soap_lent
+{
+  const void *ptr;
+  void *link;
+};
+
+/* open addressing hash table index of an allocation list, built on demand to unlink and delete data in O(1) */
+struct soap_lht
+{
+  struct soap_lent *table;
+  size_t size;
+  size_t num;
+  void *head; /* list head when the index was last updated, the list entries before it are not indexed yet */
+};
+
+/* mark of the managed memory before an item of a repetition is deserialized or produced, soap_end_item() and soap_next_item() release the data of the item allocated after the mark */
+struct soap_imark
+{
+  void *alist;
+  struct soap_clist *clist;
+  struct soap_arena *arena;
+  size_t used;
+  struct soap_lazy *lazy;
+};
+
+/* slices of the items of a repetition in the in-situ input buffer, computed by soap_begin_slices() and deserialized in parallel by soap_in_slices() */
+struct soap_slices
+{
+  size_t num;                           /* number of items */
+  size_t size;                          /* size of an item */
+  int len;                              /* number of slices */
+  size_t idx[SOAP_MAXSLICES + 1];       /* index of the first item of each slice, idx[len] = num */
+  size_t off[SOAP_MAXSLICES + 1];       /* offset in isbuf[] of the first item of each slice, off[len] is the end of the last item */
+};
+
+/* XML element of a lazy member retained by soap_lazy_in(), which is deserialized on first access by the soapcpp2-generated soap_lazy_X() accessor or sent verbatim by soap_lazy_out() */
+struct soap_lazy
+{
+  struct soap_lazy *next;
+  struct soap_lazy *move; /* temporary list of the members moved by soap_update_pointers() */
+  const void *ptr;      /* address of the lazy member, NULL when deserialized */
+  char *xml;            /* the element with the namespace bindings in scope, NUL-terminated */
+  size_t len;           /* length of xml[] */
+};
+
+#ifndef WITH_LEAN
+/* string table of the binary XML codec, strings are numbered in the order of their first occurrence in a message */
+struct soap_bxml_table
+{
+  char *buf;            /* the strings, NUL-terminated */
+  size_t len;           /* length of buf[] used */
+  size_t size;          /* allocated size of buf[] */
+  size_t *off;          /* offsets of the strings in buf[] */
+  size_t num;           /* number of strings */
+  size_t max;           /* allocated size of off[] */
+  size_t *hash;         /* open addressing hash table of string numbers + 1, to find strings when encoding, or NULL */
+};
+
+/* state of the binary XML encoder or decoder of a message */
+struct soap_bxml
+{
+  struct soap_bxml_table names;  /* qualified element and attribute names */
+  struct soap_bxml_table values; /* short attribute values and text */
+  struct soap_bxml_table stack;  /* names of the elements open when decoding */
+  char *buf;            /* scratch buffer to convert strings */
+  size_t size;          /* allocated size of buf[] */
 };
+#endif
 
 /* pointer serialization management */
 struct soap_plist
 {
-  struct soap_plist *next;
   const void *ptr;
   void *dup;
   const void *array; /* array pointer */
@@ -2082,6 +2205,7 @@ struct soap_mlist
 struct soap_clist
 {
   struct soap_clist *next;
+  struct soap_clist **prev; /* points to the next field of the previous node or to soap::clist */
   void *ptr;
   int type;
   int size; /* array size */
@@ -2734,14 +2858,28 @@ struct SOAP_CMAC soap
   const char *lang;             /* user-definable xml:lang attribute value of SOAP-ENV:Text */
   const struct Namespace *namespaces;   /* Pointer to global namespace mapping table */
   struct Namespace *local_namespaces;   /* Local namespace mapping table */
+  short nsshared;               /* local_namespaces points to a shared read-only table, which is copied before it is changed */
+  short nsht[SOAP_NSHASH];      /* namespace URI hash table of local_namespaces index + 1 */
   struct soap_nlist *nlist;     /* namespace stack */
+  struct soap_nlist *nmatch;    /* last namespace binding found on the namespace stack by soap_match_namespace */
   struct soap_blist *blist;     /* block allocation stack */
   struct soap_clist *clist;     /* class instance allocation list */
   void *alist;                  /* memory allocation (malloc) list */
+  struct soap_lht aht;          /* index of alist on the data address, used by soap_dealloc() and soap_unlink() */
+  struct soap_lht cht;          /* index of clist on the instance address, used by soap_delete() and soap_unlink() */
+  struct soap_arena *arena;     /* arena chunks of soap_malloc() data */
+  struct soap_arena *arenafree; /* empty arena chunks kept by soap_end() for reuse */
+  size_t arenakeep;             /* user-definable max total size of arena chunks kept by soap_end() for reuse (SOAP_ARENAKEEP), chunks exceeding this high-water mark are freed */
+  size_t arenalen;              /* user-definable initial arena chunk size (SOAP_ARENALEN), soap_malloc() and soap_push_block() allocate data up to this size from arena chunks that are freed all at once by soap_end(), arena data cannot be soap_unlink()-ed */
 #if !defined(WITH_LEANER) || !defined(WITH_NOIDREF)
-  struct soap_ilist *iht[SOAP_IDHASH];
-#endif
-  struct soap_plist *pht[SOAP_PTRHASH];
+  struct soap_ilist **iht;      /* open addressing hash table of parsed id/ref, SOAP_IDHASH initial size */
+  struct soap_ilist *ilist;     /* list of the id/ref entries in iht */
+  size_t ihtsize;
+  size_t ihtnum;
+#endif
+  struct soap_plist **pht;      /* open addressing hash table of pointer analysis, SOAP_PTRHASH initial size */
+  size_t phtsize;
+  size_t phtnum;
   struct soap_pblk *pblk;       /* plist block allocation */
   short pidx;                   /* plist block allocation */
   short shaky;                  /* objects in reallocatable containers are on shaky grounds */
@@ -2786,6 +2924,9 @@ struct SOAP_CMAC soap
   void (*fseterror)(struct soap*, const char **c, const char **s);
   int (*fencoding)(struct soap*, const char*);
   int (*fignore)(struct soap*, const char*);
+  int (*fitemin)(struct soap*, const char*, int, void*); /* streaming deserialization hook, consumes an item of a repetition deserialized by soapcpp2 -F generated code */
+  int (*fitemout)(struct soap*, const char*, int, const void*, void*); /* streaming serialization hook, produces the next item of a repetition serialized by soapcpp2 -F generated code, returns SOAP_EOF when done */
+  int (*fparallel)(struct soap*, int (*)(void*), void**, int); /* parallel job runner, runs the n jobs with the job function and returns when all jobs are done, used to (de)serialize large arrays in parallel by soapcpp2 -F generated code */
   int (*fserveloop)(struct soap*);
   void *(*fplugin)(struct soap*, const char*);
 #ifndef WITH_LEANER
@@ -2828,6 +2969,20 @@ struct SOAP_CMAC soap
   const char **os;      /* C only: pointer to a const char*, will be set to point to the string output */
   const char *is;       /* C only: a const char* to read from (soap->is will advance) */
 #endif
+#ifndef WITH_LEAN
+  char *isbuf;          /* in-situ input buffer to read from (soap->isidx will advance), string content is NUL-terminated in place and returned as pointers into isbuf, which should not be deallocated while the deserialized data is used */
+  size_t islen;         /* length of the in-situ input buffer isbuf[] */
+  size_t isidx;         /* index in isbuf[] of the next input to read */
+  char *insitu;         /* points to the location in isbuf[] of the current ibuf[] content, or NULL when the content of ibuf[] was not read verbatim from isbuf[] */
+  short isconst;        /* isbuf[] is read-only, such as the soap_mmap() mapping, string content is copied instead of NUL-terminated in place */
+  void *mmapbuf;        /* file mapped with soap_mmap() to read from in-situ, unmapped with soap_munmap() or soap_done() */
+  size_t mmaplen;       /* length of the file mapping mmapbuf */
+  struct soap_lazy *lazy; /* elements of lazy members retained by soap_lazy_in() until soap_end(), newest first */
+  struct soap_lht lzht; /* index of the lazy members on the 2^SOAP_LAZYSHIFT byte granule of their address, kept up to date by soap_update_pointers() */
+  short bxml;           /* SOAP_BXML_IN and SOAP_BXML_OUT: the message received and the message sent are binary XML, set by the bxml plugin after content negotiation */
+  struct soap_bxml *bxml_in;  /* binary XML decoder state */
+  struct soap_bxml *bxml_out; /* binary XML encoder state */
+#endif
 #ifndef UNDER_CE
   int sendfd;           /* int file descriptor for sending */
   int recvfd;           /* int file descriptor for receiving */
@@ -2898,12 +3053,18 @@ struct SOAP_CMAC soap
   unsigned int level;   /* XML nesting level */
 #ifndef WITH_LEAN
   ULONG64 start;        /* start time of send/recv (value cast to time_t) */
+  time_t dt_time;       /* last time_t value converted by soap_dateTime2s() */
+  char dt_buf[32];      /* cached xsd:dateTime "YYYY-MM-DDThh:mm:ss" UTC string of dt_time, empty if none */
+  LONG64 tz_hour;       /* last local hour (since the epoch) converted to UTC by soap_s2dateTime() */
+  long tz_offset;       /* cached UTC offset in seconds of local hour tz_hour */
+  short store;          /* soap_begin_count() selected to store the message once to determine its length, instead of counting it in a separate pass */
 #endif
   ULONG64 count;        /* message length counter */
   ULONG64 length;       /* message length as was set by HTTP header received */
   char *labbuf;         /* look-aside buffer */
   size_t lablen;        /* look-aside buffer allocated length */
   size_t labidx;        /* look-aside buffer index to available part */
+  const char *ibuf;     /* receive buffer with buflen bytes, points to buf[] or into isbuf[] when reading in-situ */
   char buf[SOAP_BUFLEN];/* send and receive buffer */
   char msgbuf[SOAP_TMPLEN]; /* in/out buffer for HTTP/MIME headers and short messages, must be >=1024 bytes */
   char tmpbuf[SOAP_TMPLEN]; /* in/out buffer for HTTP/MIME headers, simpleType values, element and attribute tag names, and DIME must be >=1024 bytes */
@@ -3078,8 +3239,8 @@ struct soap_plugin
 extern SOAP_NMAC struct Namespace namespaces[];
 
 #ifndef WITH_LEAN
-# define soap_get0(soap) (((soap)->bufidx>=(soap)->buflen && soap_recv((soap))) ? EOF : (unsigned char)(soap)->buf[(soap)->bufidx])
-# define soap_get1(soap) (((soap)->bufidx>=(soap)->buflen && soap_recv((soap))) ? EOF : (unsigned char)(soap)->buf[(soap)->bufidx++])
+# define soap_get0(soap) (((soap)->bufidx>=(soap)->buflen && soap_recv((soap))) ? EOF : (unsigned char)(soap)->ibuf[(soap)->bufidx])
+# define soap_get1(soap) (((soap)->bufidx>=(soap)->buflen && soap_recv((soap))) ? EOF : (unsigned char)(soap)->ibuf[(soap)->bufidx++])
 # define soap_getchar(soap) ((soap)->ahead ? soap_getahead((soap)) : soap_get1((soap)))
 SOAP_FMAC1 soap_wchar SOAP_FMAC2 soap_getahead(struct soap*);
 #else
@@ -3240,7 +3401,12 @@ SOAP_FMAC1 int SOAP_FMAC2 soap_set_receiver_error(struct soap*, const char*, con
 SOAP_FMAC1 int SOAP_FMAC2 soap_send_raw(struct soap*, const char*, size_t);
 SOAP_FMAC1 int SOAP_FMAC2 soap_recv_raw(struct soap*);
 SOAP_FMAC1 int SOAP_FMAC2 soap_recv(struct soap*);
+#ifndef WITH_LEAN
+SOAP_FMAC1 int SOAP_FMAC2 soap_mmap(struct soap*, int);
+SOAP_FMAC1 void SOAP_FMAC2 soap_munmap(struct soap*);
+#endif
 SOAP_FMAC1 int SOAP_FMAC2 soap_send(struct soap*, const char*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_send_xml(struct soap*, const char*);
 
 #ifndef WITH_LEANER
 SOAP_FMAC1 int SOAP_FMAC2 soap_send2(struct soap*, const char*, const char*);
@@ -3313,6 +3479,16 @@ SOAP_FMAC1 int SOAP_FMAC2 soap_end_recv(struct soap*);
 SOAP_FMAC1 void* SOAP_FMAC2 soap_malloc(struct soap*, size_t);
 SOAP_FMAC1 void SOAP_FMAC2 soap_dealloc(struct soap*, void*);
 SOAP_FMAC1 struct soap_clist * SOAP_FMAC2 soap_link(struct soap*, int, int, int (*fdelete)(struct soap*, struct soap_clist*));
+SOAP_FMAC1 void SOAP_FMAC2 soap_begin_item(struct soap*, struct soap_imark*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_end_item(struct soap*, const char *tag, int t, void *p, const struct soap_imark*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_next_item(struct soap*, const char *tag, int t, const void *a, void *p, const struct soap_imark*);
+SOAP_FMAC1 size_t SOAP_FMAC2 soap_begin_slices(struct soap*, struct soap_slices*, size_t size);
+SOAP_FMAC1 int SOAP_FMAC2 soap_in_slices(struct soap*, const char *tag, const struct soap_slices*, void *p, void *(*fin)(struct soap*, const char*, void*, const char*), const char *type);
+SOAP_FMAC1 size_t SOAP_FMAC2 soap_out_slices(struct soap*, const char *tag, const void *p, size_t num, size_t size, int (*fout)(struct soap*, const char*, const void*, const char*), const char *type);
+SOAP_FMAC1 int SOAP_FMAC2 soap_lazy_in(struct soap*, const char *tag, const void *p);
+SOAP_FMAC1 int SOAP_FMAC2 soap_lazy_out(struct soap*, const void *p);
+SOAP_FMAC1 struct soap * SOAP_FMAC2 soap_lazy_begin(struct soap*, const void *p);
+SOAP_FMAC1 void SOAP_FMAC2 soap_lazy_end(struct soap*, struct soap *copy, const void *p);
 SOAP_FMAC1 int SOAP_FMAC2 soap_unlink(struct soap*, const void*);
 SOAP_FMAC1 void SOAP_FMAC2 soap_free_temp(struct soap*);
 SOAP_FMAC1 void SOAP_FMAC2 soap_del(struct soap*);
@@ -3513,6 +3689,8 @@ SOAP_FMAC1 int SOAP_FMAC2 soap_s2stdwchar(struct soap*, const char*, std::wstrin
 #ifndef WITH_LEAN
 SOAP_FMAC1 int SOAP_FMAC2 soap_s2wchar(struct soap*, const char*, wchar_t**, int, long minlen, long maxlen, const char *pattern);
 SOAP_FMAC1 int SOAP_FMAC2 soap_s2dateTime(struct soap*, const char*, time_t*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_s2dateTime_frac(struct soap*, const char*, time_t*, unsigned long *frac, int digits);
+SOAP_FMAC1 int SOAP_FMAC2 soap_s2tm(struct soap*, const char*, struct tm*, unsigned long *frac, int digits);
 #endif
 
 SOAP_FMAC1 char* SOAP_FMAC2 soap_s2base64(struct soap*, const unsigned char*, char*, int);
@@ -3535,11 +3713,62 @@ SOAP_FMAC1 const char* SOAP_FMAC2 soap_QName2s(struct soap*, const char*);
 #ifndef WITH_LEAN
 SOAP_FMAC1 const char* SOAP_FMAC2 soap_wchar2s(struct soap*, const wchar_t*);
 SOAP_FMAC1 const char* SOAP_FMAC2 soap_dateTime2s(struct soap*, time_t);
+SOAP_FMAC1 const char* SOAP_FMAC2 soap_dateTime2s_frac(struct soap*, time_t, unsigned long frac, int digits);
 #endif
 
 SOAP_FMAC1 const char* SOAP_FMAC2 soap_base642s(struct soap*, const char*, char*, size_t, int*);
 SOAP_FMAC1 const char* SOAP_FMAC2 soap_hex2s(struct soap*, const char*, char*, size_t, int*);
 
+#ifndef WITH_LEAN
+SOAP_FMAC1 int SOAP_FMAC2 soap_json_string_out(struct soap*, const char*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_json_number_out(struct soap*, const char*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_json_key_out(struct soap*, const char*, int);
+SOAP_FMAC1 int SOAP_FMAC2 soap_json_begin_in(struct soap*, int);
+SOAP_FMAC1 int SOAP_FMAC2 soap_json_next_in(struct soap*, int, int*);
+SOAP_FMAC1 const char* SOAP_FMAC2 soap_json_key_in(struct soap*);
+SOAP_FMAC1 const char* SOAP_FMAC2 soap_json_value_in(struct soap*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_json_null_in(struct soap*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_json_ignore_in(struct soap*);
+#endif
+
+#ifndef WITH_LEAN
+#define SOAP_CBOR_UINT   (0)     /* CBOR major types */
+#define SOAP_CBOR_NINT   (1)
+#define SOAP_CBOR_BYTES  (2)
+#define SOAP_CBOR_TEXT   (3)
+#define SOAP_CBOR_ARRAY  (4)
+#define SOAP_CBOR_MAP    (5)
+#define SOAP_CBOR_TAG    (6)
+#define SOAP_CBOR_SELF   (55799) /* self-described CBOR tag that starts a CBOR message */
+#define SOAP_CBOR_CONTENT_TYPE "application/cbor"
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_head_out(struct soap*, int, ULONG64);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_begin_out(struct soap*, int);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_end_out(struct soap*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_int_out(struct soap*, LONG64);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_float_out(struct soap*, float);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_double_out(struct soap*, double);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_bool_out(struct soap*, int);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_null_out(struct soap*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_string_out(struct soap*, const char*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_bytes_out(struct soap*, const unsigned char*, int);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_begin_in(struct soap*, int, size_t*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_next_in(struct soap*, size_t*);
+SOAP_FMAC1 const char* SOAP_FMAC2 soap_cbor_key_in(struct soap*);
+SOAP_FMAC1 const char* SOAP_FMAC2 soap_cbor_string_in(struct soap*);
+SOAP_FMAC1 const unsigned char* SOAP_FMAC2 soap_cbor_bytes_in(struct soap*, int*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_int_in(struct soap*, LONG64*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_uint_in(struct soap*, ULONG64*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_double_in(struct soap*, double*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_bool_in(struct soap*, int*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_null_in(struct soap*);
+SOAP_FMAC1 int SOAP_FMAC2 soap_cbor_ignore_in(struct soap*);
+#endif
+
+#ifndef WITH_LEAN
+#define SOAP_BXML_IN     (0x1)   /* soap::bxml flags */
+#define SOAP_BXML_OUT    (0x2)
+#endif
+
 SOAP_FMAC1 int* SOAP_FMAC2 soap_inint(struct soap*, const char *tag, int *p, const char *, int);
 SOAP_FMAC1 char* SOAP_FMAC2 soap_inbyte(struct soap*, const char *tag, char *p, const char *, int);
 SOAP_FMAC1 long* SOAP_FMAC2 soap_inlong(struct soap*, const char *tag, long *p, const char *, int);
@@ -3686,7 +3915,12 @@ struct soap_block
       b = soap->blist;
     if (!b)
       return NULL;
-    T *p = (T*)soap_push_block_max(soap, b, sizeof(T));
+    if (b->item >= soap->maxoccurs) /* restrict block array length */
+    {
+      soap->error = SOAP_OCCURS;
+      return NULL;
+    }
+    T *p = (T*)soap_push_block(soap, b, sizeof(T)); /* one block per instance, instances cannot be moved in memory */
     if (p)
       SOAP_PLACEMENT_NEW(soap, p, T);
     return p;